@@ -0,0 +1,181 @@
+#include "../src/common.h"
+#include "../src/platform.h"
+#include "../src/texture.h"
+#include "../src/asset_pack.h"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../src/third_party/stb/stb_image.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+	usage: asset-baker [--format bc1|rgba8] output.vxpack input.png...
+
+	decodes every input, generates its mip chain and compresses it, then writes them all into one asset pack.
+	textures with any transparent pixel are kept as rgba8, since bc1 can't store alpha.
+	each texture is named after its file, without the directory and extension.
+*/
+
+static void copyTextureName(const char* filepath, char* name) {
+	const char* begin = filepath;
+	for (const char* c = filepath; *c != 0; c++) {
+		if (*c == '/' || *c == '\\') {
+			begin = c + 1;
+		}
+	}
+	const char* end = strrchr(begin, '.');
+	if (end == nil) {
+		end = begin + strlen(begin);
+	}
+	u64 length = MIN((u64)(end - begin), (u64)ASSET_PACK_NAME_LENGTH - 1);
+	memset(name, 0, ASSET_PACK_NAME_LENGTH);
+	memcpy(name, begin, length);
+}
+
+static bool32 isOpaque(u8* pixels, u32 width, u32 height) {
+	for (u64 i = 0; i < (u64)width * height; i++) {
+		if (pixels[4 * i + 3] != 255) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+//peak signal to noise ratio of the color channels, in decibels
+static f64 calculatePSNR(u8* expected, u8* actual, u32 width, u32 height) {
+	f64 squaredErrorSum = 0.0;
+	for (u64 i = 0; i < (u64)width * height; i++) {
+		for (u32 c = 0; c < 3; c++) {
+			f64 difference = (f64)expected[4 * i + c] - (f64)actual[4 * i + c];
+			squaredErrorSum += difference * difference;
+		}
+	}
+	if (squaredErrorSum == 0.0) {
+		return INFINITY;
+	}
+	f64 meanSquaredError = squaredErrorSum / (3.0 * width * height);
+	return 10.0 * log10(255.0 * 255.0 / meanSquaredError);
+}
+
+int main(int argc, char** argv) {
+	TextureFormat requestedFormat = TEXTURE_FORMAT_BC1_SRGB;
+	i32 argumentIndex = 1;
+	if (argumentIndex + 1 < argc && strcmp(argv[argumentIndex], "--format") == 0) {
+		if (strcmp(argv[argumentIndex + 1], "bc1") == 0) {
+			requestedFormat = TEXTURE_FORMAT_BC1_SRGB;
+		} else if (strcmp(argv[argumentIndex + 1], "rgba8") == 0) {
+			requestedFormat = TEXTURE_FORMAT_RGBA8_SRGB;
+		} else {
+			printf("unknown format %s\n", argv[argumentIndex + 1]);
+			return 1;
+		}
+		argumentIndex += 2;
+	}
+	if (argumentIndex + 1 >= argc) {
+		printf("usage: asset-baker [--format bc1|rgba8] output.vxpack input.png...\n");
+		return 1;
+	}
+	const char* outputFilepath = argv[argumentIndex];
+	u32 texturesCount = (u32)(argc - argumentIndex - 1);
+	const char** inputFilepaths = (const char**)&argv[argumentIndex + 1];
+
+	AssetPackTexture* textures = (AssetPackTexture*) calloc(texturesCount, sizeof(AssetPackTexture));
+	u8** texturesData = (u8**) calloc(texturesCount, sizeof(u8*));
+	u64 sourceBytes = 0;
+	u64 bakedBytes = 0;
+	for (u32 i = 0; i < texturesCount; i++) {
+		int width, height, channels;
+		stbi_uc* basePixels = stbi_load(inputFilepaths[i], &width, &height, &channels, STBI_rgb_alpha);
+		if (!basePixels) {
+			printf("failed to load %s: %s\n", inputFilepaths[i], stbi_failure_reason());
+			return 1;
+		}
+		AssetPackTexture* texture = &textures[i];
+		copyTextureName(inputFilepaths[i], texture->name);
+		//the game decodes the pngs instead of using the pack once they differ from these
+		if (!getFileInfo(inputFilepaths[i], &texture->sourceSize, &texture->sourceModificationTime)) {
+			printf("failed to read the size and modification time of %s\n", inputFilepaths[i]);
+			return 1;
+		}
+		for (u32 j = 0; j < i; j++) {
+			if (strcmp(textures[j].name, texture->name) == 0) {
+				printf("%s and %s would both be named %s\n", inputFilepaths[j], inputFilepaths[i], texture->name);
+				return 1;
+			}
+		}
+		texture->width = width;
+		texture->height = height;
+		texture->mipLevelsCount = MIN(calculateMipLevelsCount(width, height), ASSET_PACK_MAX_MIP_LEVELS);
+		u8* chain = (u8*) malloc(calculateMipChainSize(width, height, texture->mipLevelsCount));
+		memcpy(chain, basePixels, 4ull * width * height);
+		stbi_image_free(basePixels);
+		generateMipChain(chain, width, height, texture->mipLevelsCount);
+
+		texture->format = requestedFormat;
+		if (requestedFormat == TEXTURE_FORMAT_BC1_SRGB && !isOpaque(chain, width, height)) {
+			printf("%s has transparent pixels, keeping it as rgba8\n", inputFilepaths[i]);
+			texture->format = TEXTURE_FORMAT_RGBA8_SRGB;
+		}
+		texture->dataSize = calculateTextureChainSize(texture->format, width, height, texture->mipLevelsCount);
+
+		f64 psnr = INFINITY;
+		if (texture->format == TEXTURE_FORMAT_BC1_SRGB) {
+			u8* blocks = (u8*) malloc(texture->dataSize);
+			u8* source = chain;
+			u8* destination = blocks;
+			for (u32 level = 0; level < texture->mipLevelsCount; level++) {
+				u32 levelWidth = calculateMipLevelDimension(width, level);
+				u32 levelHeight = calculateMipLevelDimension(height, level);
+				compressBC1(source, levelWidth, levelHeight, destination);
+				source += calculateTextureLevelSize(TEXTURE_FORMAT_RGBA8_SRGB, levelWidth, levelHeight);
+				destination += calculateTextureLevelSize(TEXTURE_FORMAT_BC1_SRGB, levelWidth, levelHeight);
+			}
+			u8* decompressed = (u8*) malloc(4ull * width * height);
+			decompressBC1(blocks, width, height, decompressed);
+			psnr = calculatePSNR(chain, decompressed, width, height);
+			free(decompressed);
+			free(chain);
+			texturesData[i] = blocks;
+		} else {
+			texturesData[i] = chain;
+		}
+		sourceBytes += calculateMipChainSize(width, height, texture->mipLevelsCount);
+		bakedBytes += texture->dataSize;
+		printf(
+			"%-24s %4dx%-4d %2u mips %-5s %8.1f KB  psnr %.1f dB\n",
+			texture->name, width, height, texture->mipLevelsCount, texture->format == TEXTURE_FORMAT_BC1_SRGB ? "bc1" : "rgba8",
+			(f64)texture->dataSize / 1024.0, psnr
+		);
+	}
+
+	if (!writeAssetPack(outputFilepath, textures, texturesData, texturesCount)) {
+		return 1;
+	}
+	AssetPack pack;
+	if (!openAssetPack(outputFilepath, &pack)) {
+		printf("failed to read back %s\n", outputFilepath);
+		return 1;
+	}
+	for (u32 i = 0; i < texturesCount; i++) {
+		AssetPackTexture* texture = findAssetPackTexture(&pack, textures[i].name);
+		if (texture == nil || memcmp(getAssetPackTextureData(&pack, texture), texturesData[i], texture->dataSize) != 0) {
+			printf("texture %s of %s doesn't match what was written\n", textures[i].name, outputFilepath);
+			return 1;
+		}
+	}
+	printf(
+		"wrote %u textures to %s. %.1f KB, %.1f KB as rgba8 with mips\n",
+		texturesCount, outputFilepath, (f64)bakedBytes / 1024.0, (f64)sourceBytes / 1024.0
+	);
+	closeAssetPack(&pack);
+
+	for (u32 i = 0; i < texturesCount; i++) {
+		free(texturesData[i]);
+	}
+	free(texturesData);
+	free(textures);
+	return 0;
+}
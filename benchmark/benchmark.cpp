@@ -0,0 +1,1331 @@
+#include "../src/common.h"
+#include "../src/math.h"
+#include "../src/collision.h"
+#include "../src/memory.h"
+#include "../src/voxel.h"
+#include "../src/platform.h"
+#include "../src/texture.h"
+#include "../src/world_file.h"
+#include "../src/vox.h"
+#include "../src/edit_journal.h"
+#include "../src/voxel_region.h"
+#include "../src/voxel_selection.h"
+#include "../src/voxel_translucency.h"
+#include "../src/radix_sort.h"
+#include "../src/voxel_occlusion.h"
+#include "../src/voxel_light.h"
+#include "../src/voxel_shadow.h"
+#include "../src/voxel_tracer.h"
+#include "../src/jobs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+
+/*
+	usage: benchmark [--filter substring] [--repetitions n] [--warmup n] [--json path]
+
+	every benchmark runs its warmup repetitions first, then the measured repetitions.
+	one repetition processes itemsCount items, so the per item time is comparable across sizes.
+*/
+
+typedef void (*BenchmarkFunction)(void* context);
+
+struct BenchmarkResult {
+	const char* name;
+	u64 itemsCount;
+	u32 repetitions;
+	f64 minNanoseconds;
+	f64 medianNanoseconds;
+	f64 p99Nanoseconds;
+	f64 meanNanoseconds;
+	//codecs report their throughput over the uncompressed bytes, and how much smaller the encoded bytes are
+	u64 rawBytesCount;
+	u64 encodedBytesCount;
+};
+
+struct BenchmarkConfig {
+	const char* filter;
+	const char* jsonFilepath;
+	u32 warmupRepetitions;
+	u32 repetitions;
+};
+
+const u32 MAX_BENCHMARK_RESULTS = 64;
+
+static BenchmarkResult benchmarkResults[MAX_BENCHMARK_RESULTS];
+static u32 benchmarkResultsCount = 0;
+
+//results are written here so the optimizer can't remove the work being measured
+static volatile f32 benchmarkSink;
+
+static int compareF64(const void* a, const void* b) {
+	f64 x = *(const f64*)a;
+	f64 y = *(const f64*)b;
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static void runCodecBenchmark(
+	BenchmarkConfig* config, const char* name, u64 itemsCount, u64 rawBytesCount, u64 encodedBytesCount, BenchmarkFunction function, void* context
+) {
+	if (config->filter != nil && strstr(name, config->filter) == nil) {
+		return;
+	}
+	_assert(benchmarkResultsCount < MAX_BENCHMARK_RESULTS);
+
+	for (u32 i = 0; i < config->warmupRepetitions; i++) {
+		function(context);
+	}
+
+	f64* samples = (f64*) malloc(config->repetitions * sizeof(f64));
+	_assert(samples != nil);
+	f64 totalNanoseconds = 0.0;
+	for (u32 i = 0; i < config->repetitions; i++) {
+		f64 begin = getWallClockSeconds();
+		function(context);
+		f64 end = getWallClockSeconds();
+		samples[i] = (end - begin) * 1.0e9;
+		totalNanoseconds += samples[i];
+	}
+	qsort(samples, config->repetitions, sizeof(f64), compareF64);
+
+	BenchmarkResult* result = &benchmarkResults[benchmarkResultsCount];
+	benchmarkResultsCount += 1;
+	result->name = name;
+	result->itemsCount = itemsCount;
+	result->repetitions = config->repetitions;
+	result->minNanoseconds = samples[0];
+	result->medianNanoseconds = samples[config->repetitions / 2];
+	result->p99Nanoseconds = samples[MIN((config->repetitions * 99) / 100, config->repetitions - 1)];
+	result->meanNanoseconds = totalNanoseconds / (f64)config->repetitions;
+	result->rawBytesCount = rawBytesCount;
+	result->encodedBytesCount = encodedBytesCount;
+	free(samples);
+
+	printf("%-40s %10llu %14.1f %14.1f %14.1f %12.2f",
+		name,
+		(unsigned long long)itemsCount,
+		result->medianNanoseconds / 1000.0,
+		result->p99Nanoseconds / 1000.0,
+		result->minNanoseconds / 1000.0,
+		result->medianNanoseconds / (f64)itemsCount
+	);
+	if (rawBytesCount > 0) {
+		//bytes per nanosecond are gigabytes per second
+		printf("   %.2f GB/s, ratio %.2f", (f64)rawBytesCount / result->medianNanoseconds, (f64)rawBytesCount / (f64)encodedBytesCount);
+	}
+	printf("\n");
+}
+
+static void runBenchmark(BenchmarkConfig* config, const char* name, u64 itemsCount, BenchmarkFunction function, void* context) {
+	runCodecBenchmark(config, name, itemsCount, 0, 0, function, context);
+}
+
+static bool32 writeBenchmarkResultsJSON(const char* filepath) {
+	FILE* file = fopen(filepath, "wb");
+	if (file == nil) {
+		printf("unable to open %s for writing the benchmark results\n", filepath);
+		return 0;
+	}
+	fprintf(file, "{\"benchmarks\":[\n");
+	for (u32 i = 0; i < benchmarkResultsCount; i++) {
+		BenchmarkResult* r = &benchmarkResults[i];
+		fprintf(file, "\t{\"name\":\"%s\",\"items\":%llu,\"repetitions\":%u,\"min_ns\":%.1f,\"median_ns\":%.1f,\"p99_ns\":%.1f,\"mean_ns\":%.1f,\"median_ns_per_item\":%.3f",
+			r->name,
+			(unsigned long long)r->itemsCount,
+			r->repetitions,
+			r->minNanoseconds,
+			r->medianNanoseconds,
+			r->p99Nanoseconds,
+			r->meanNanoseconds,
+			r->medianNanoseconds / (f64)r->itemsCount
+		);
+		if (r->rawBytesCount > 0) {
+			fprintf(file, ",\"raw_bytes\":%llu,\"encoded_bytes\":%llu,\"gb_per_second\":%.3f,\"compression_ratio\":%.3f",
+				(unsigned long long)r->rawBytesCount,
+				(unsigned long long)r->encodedBytesCount,
+				(f64)r->rawBytesCount / r->medianNanoseconds,
+				(f64)r->rawBytesCount / (f64)r->encodedBytesCount
+			);
+		}
+		fprintf(file, "}%s\n", i + 1 < benchmarkResultsCount ? "," : "");
+	}
+	fprintf(file, "]}\n");
+	bool32 success = ferror(file) == 0;
+	fclose(file);
+	return success;
+}
+
+//xorshift, so every run benchmarks the same data
+static u32 randomState = 0x9E3779B9u;
+
+static u32 randomU32() {
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return randomState;
+}
+
+static f32 randomF32(f32 min, f32 max) {
+	return min + (max - min) * (f32)(randomU32() & 0xFFFFFF) / (f32)0xFFFFFF;
+}
+
+static math::Vector3 randomUnitVector() {
+	math::Vector3 v = { randomF32(-1.0f, 1.0f), randomF32(-1.0f, 1.0f), randomF32(-1.0f, 1.0f) };
+	if (v.dot(v) < 0.0001f) {
+		v = math::Vector3{ 0.0f, 0.0f, -1.0f };
+	}
+	return v.normalize();
+}
+
+struct MathContext {
+	u32 count;
+	math::Matrix4* matrices;
+	math::Quaternion* quaternions;
+	math::Vector3* vectors;
+};
+
+static void benchmarkMatrixMultiply(void* context) {
+	MathContext* c = (MathContext*)context;
+	f32 sum = 0.0f;
+	for (u32 i = 0; i + 1 < c->count; i++) {
+		math::Matrix4 m = c->matrices[i].multiply(c->matrices[i + 1]);
+		sum += m.a.m[0];
+	}
+	benchmarkSink = sum;
+}
+
+static void benchmarkMatrixInverse(void* context) {
+	MathContext* c = (MathContext*)context;
+	f32 sum = 0.0f;
+	for (u32 i = 0; i < c->count; i++) {
+		math::Matrix4 m = math::inverseMatrix(c->matrices[i]);
+		sum += m.a.m[5];
+	}
+	benchmarkSink = sum;
+}
+
+static void benchmarkRotateVector(void* context) {
+	MathContext* c = (MathContext*)context;
+	f32 sum = 0.0f;
+	for (u32 i = 0; i < c->count; i++) {
+		math::Vector3 v = math::rotateVector(c->vectors[i], c->quaternions[i]);
+		sum += v.x;
+	}
+	benchmarkSink = sum;
+}
+
+static void benchmarkMultiplyQuaternions(void* context) {
+	MathContext* c = (MathContext*)context;
+	f32 sum = 0.0f;
+	for (u32 i = 0; i + 1 < c->count; i++) {
+		math::Quaternion q = math::multiplyQuaternions(c->quaternions[i], c->quaternions[i + 1]);
+		sum += q.real;
+	}
+	benchmarkSink = sum;
+}
+
+static void benchmarkCreateRotationMatrix(void* context) {
+	MathContext* c = (MathContext*)context;
+	f32 sum = 0.0f;
+	for (u32 i = 0; i < c->count; i++) {
+		math::Matrix4 m = math::createRotationMatrix(c->quaternions[i]);
+		sum += m.a.m[0];
+	}
+	benchmarkSink = sum;
+}
+
+struct RayContext {
+	u32 count;
+	Ray* rays;
+	AABB* aabbs;
+	OBB* obbs;
+};
+
+static void benchmarkRayAABB(void* context) {
+	RayContext* c = (RayContext*)context;
+	u32 hits = 0;
+	for (u32 i = 0; i < c->count; i++) {
+		f32 t;
+		math::Vector3 q;
+		hits += isRayIntersectingAABB(c->rays[i].origin, c->rays[i].direction, c->aabbs[i], 100.0f, &t, &q);
+	}
+	benchmarkSink = (f32)hits;
+}
+
+static void benchmarkRayOBB(void* context) {
+	RayContext* c = (RayContext*)context;
+	u32 hits = 0;
+	for (u32 i = 0; i < c->count; i++) {
+		f32 t;
+		math::Vector3 q;
+		hits += isRayIntersectingOBB(c->rays[i].origin, c->rays[i].direction, c->obbs[i], 100.0f, &t, &q);
+	}
+	benchmarkSink = (f32)hits;
+}
+
+struct VoxelContext {
+	VoxelArray* voxelArray;
+	u32 raysCount;
+	Ray* rays;
+	math::Matrix4* models;
+	i32 dirtyGroupsCount;
+	i32 spansCapacity;
+	VoxelSpan* spans;
+};
+
+static void benchmarkPicking(void* context) {
+	VoxelContext* c = (VoxelContext*)context;
+	i32 sum = 0;
+	for (u32 i = 0; i < c->raysCount; i++) {
+		f32 hitDistance;
+		math::Vector3 hitPoint;
+		sum += pickVoxel(c->voxelArray, c->rays[i].origin, c->rays[i].direction, 100.0f, &hitDistance, &hitPoint);
+	}
+	benchmarkSink = (f32)sum;
+}
+
+static void benchmarkInstanceTransformBuild(void* context) {
+	VoxelContext* c = (VoxelContext*)context;
+	for (i32 i = 0; i < c->voxelArray->voxelsCount; i++) {
+		c->models[i] = calculateVoxelModelMatrix(c->voxelArray, i);
+	}
+	benchmarkSink = c->models[c->voxelArray->voxelsCount - 1].a.m[12];
+}
+
+//the per frame cost when a few groups move: collecting the dirty spans and rebuilding only their instances
+static void benchmarkDirtyInstanceBuild(void* context) {
+	VoxelContext* c = (VoxelContext*)context;
+	i32 groupsStep = c->voxelArray->groupsCount / c->dirtyGroupsCount;
+	for (i32 i = 0; i < c->dirtyGroupsCount; i++) {
+		markVoxelGroupDirty(c->voxelArray, i * groupsStep);
+	}
+	i32 spansCount = collectDirtyVoxelSpans(c->voxelArray, c->spans, c->spansCapacity);
+	for (i32 s = 0; s < spansCount; s++) {
+		for (i32 i = c->spans[s].begin; i < c->spans[s].end; i++) {
+			c->models[i] = calculateVoxelModelMatrix(c->voxelArray, i);
+		}
+	}
+	benchmarkSink = (f32)spansCount;
+}
+
+struct AllocationContext {
+	MemoryAllocator* allocator;
+	u32 count;
+	u32* sizes;
+};
+
+static void benchmarkArenaAllocation(void* context) {
+	AllocationContext* c = (AllocationContext*)context;
+	c->allocator->byteOffset = 0;
+	u8* last = nil;
+	for (u32 i = 0; i < c->count; i++) {
+		last = (u8*) allocateMemory(c->allocator, c->sizes[i]);
+	}
+	benchmarkSink = (f32)(last - c->allocator->memory);
+}
+
+struct InsertionContext {
+	MemoryAllocator* allocator;
+	i32 voxelsCount;
+	i32 voxelsPerGroup;
+};
+
+static void benchmarkVoxelInsertion(void* context) {
+	InsertionContext* c = (InsertionContext*)context;
+	c->allocator->byteOffset = 0;
+	VoxelArray voxelArray = {};
+	initVoxelArray(&voxelArray, c->allocator, c->voxelsCount, c->voxelsCount / c->voxelsPerGroup + 1);
+	RGBAColorF32 color = { 1.0f, 1.0f, 1.0f, 1.0f };
+	i32 groupIndex = -1;
+	for (i32 i = 0; i < c->voxelsCount; i++) {
+		if (i % c->voxelsPerGroup == 0) {
+			groupIndex = addEmptyVoxelGroup(&voxelArray, math::Vector3{ (f32)i, 0.0f, 0.0f });
+		}
+		addVoxelToGroup(&voxelArray, color, Vector3i{ i % 64, (i / 64) % 64, i / 4096 }, Vector3ui{ 1, 1, 1 }, groupIndex);
+	}
+	benchmarkSink = (f32)voxelArray.voxelsCount;
+}
+
+struct MipChainContext {
+	u8* pixels;
+	u32 width;
+	u32 height;
+	u32 mipLevelsCount;
+};
+
+static void benchmarkMipChainGeneration(void* context) {
+	MipChainContext* c = (MipChainContext*)context;
+	generateMipChain(c->pixels, c->width, c->height, c->mipLevelsCount);
+	benchmarkSink = (f32)c->pixels[calculateMipChainSize(c->width, c->height, c->mipLevelsCount) - 1];
+}
+
+static void benchmarkBC1Compression(void* context) {
+	MipChainContext* c = (MipChainContext*)context;
+	u8* blocks = c->pixels + calculateMipChainSize(c->width, c->height, c->mipLevelsCount);
+	compressBC1(c->pixels, c->width, c->height, blocks);
+	benchmarkSink = (f32)blocks[0];
+}
+
+struct WorldContext {
+	VoxelArray* voxelArray;
+	World* world;
+	VoxelArray* openedVoxelArray;
+	World* openedWorld;
+	u8* chunkData;
+	u64 chunkSize;
+	i32 editedVoxelIndex;
+};
+
+static void benchmarkWorldChunkEncode(void* context) {
+	WorldContext* c = (WorldContext*)context;
+	c->chunkSize = encodeWorldChunk(c->voxelArray, VoxelSpan{ 0, VOXELS_PER_CHUNK }, c->chunkData);
+	benchmarkSink = (f32)c->chunkSize;
+}
+
+static void benchmarkWorldChunkDecode(void* context) {
+	WorldContext* c = (WorldContext*)context;
+	benchmarkSink = (f32)decodeWorldChunk(c->chunkData, c->chunkSize, c->openedVoxelArray, VoxelSpan{ 0, VOXELS_PER_CHUNK });
+}
+
+static void benchmarkWorldOpen(void* context) {
+	WorldContext* c = (WorldContext*)context;
+	c->openedVoxelArray->voxelsCount = 0;
+	c->openedVoxelArray->groupsCount = 0;
+	benchmarkSink = (f32)openWorld(c->openedWorld);
+	closeWorld(c->openedWorld);
+}
+
+static void benchmarkWorldSaveSmallEdit(void* context) {
+	WorldContext* c = (WorldContext*)context;
+	c->editedVoxelIndex = (c->editedVoxelIndex + 7919) % c->voxelArray->voxelsCount;
+	c->voxelArray->colors[c->editedVoxelIndex].r = randomF32(0.0f, 1.0f);
+	markVoxelDirty(c->voxelArray, c->editedVoxelIndex);
+	benchmarkSink = (f32)saveWorld(c->world);
+}
+
+struct CodecContext {
+	VoxelArray* voxelArray;
+	VoxelArray* decodedVoxelArray;
+	i32 chunksCount;
+	u8* data;
+	//where each chunk's payload starts in data. the last entry is the end of the last payload
+	u64* offsets;
+};
+
+static VoxelSpan getBenchmarkChunkSpan(VoxelArray* voxelArray, i32 chunkIndex) {
+	return VoxelSpan{ chunkIndex * VOXELS_PER_CHUNK, MIN((chunkIndex + 1) * VOXELS_PER_CHUNK, voxelArray->voxelsCount) };
+}
+
+static void benchmarkCodecEncode(void* context) {
+	CodecContext* c = (CodecContext*)context;
+	c->offsets[0] = 0;
+	for (i32 i = 0; i < c->chunksCount; i++) {
+		c->offsets[i + 1] = c->offsets[i] + encodeWorldChunk(c->voxelArray, getBenchmarkChunkSpan(c->voxelArray, i), c->data + c->offsets[i]);
+	}
+	benchmarkSink = (f32)c->offsets[c->chunksCount];
+}
+
+static void benchmarkCodecDecode(void* context) {
+	CodecContext* c = (CodecContext*)context;
+	bool32 isDecoded = 1;
+	for (i32 i = 0; i < c->chunksCount; i++) {
+		isDecoded &= decodeWorldChunk(c->data + c->offsets[i], c->offsets[i + 1] - c->offsets[i], c->decodedVoxelArray, getBenchmarkChunkSpan(c->voxelArray, i));
+	}
+	benchmarkSink = (f32)isDecoded;
+}
+
+//encodes once so the encoded size is known before the codec is measured
+static void runCodecBenchmarks(BenchmarkConfig* config, MemoryAllocator* memoryAllocator, VoxelArray* voxelArray, const char* encodeName, const char* decodeName) {
+	u64 byteOffset = memoryAllocator->byteOffset;
+	CodecContext c = {};
+	c.voxelArray = voxelArray;
+	c.chunksCount = (voxelArray->voxelsCount + VOXELS_PER_CHUNK - 1) / VOXELS_PER_CHUNK;
+	c.decodedVoxelArray = (VoxelArray*) allocateMemory(memoryAllocator, sizeof(VoxelArray));
+	initVoxelArray(c.decodedVoxelArray, memoryAllocator, voxelArray->voxelsCount, voxelArray->groupsCount);
+	c.decodedVoxelArray->groupsCount = voxelArray->groupsCount;
+	c.data = (u8*) allocateMemory(memoryAllocator, calculateWorldChunkMaxEncodedSize(VOXELS_PER_CHUNK) * c.chunksCount);
+	c.offsets = (u64*) allocateMemory(memoryAllocator, (c.chunksCount + 1) * sizeof(u64));
+	benchmarkCodecEncode(&c);
+	//the size of the voxels' attributes in the voxel array
+	u64 rawBytesCount = (u64)voxelArray->voxelsCount * (sizeof(RGBAColorF32) + sizeof(Vector3i) + sizeof(Vector3ui) + sizeof(i32));
+	u64 encodedBytesCount = c.offsets[c.chunksCount];
+	runCodecBenchmark(config, encodeName, voxelArray->voxelsCount, rawBytesCount, encodedBytesCount, benchmarkCodecEncode, &c);
+	runCodecBenchmark(config, decodeName, voxelArray->voxelsCount, rawBytesCount, encodedBytesCount, benchmarkCodecDecode, &c);
+	memoryAllocator->byteOffset = byteOffset;
+}
+
+struct VoxContext {
+	const char* filepath;
+	VoxelArray* voxelArray;
+	VoxelArray* importedVoxelArray;
+};
+
+static void benchmarkVoxExport(void* context) {
+	VoxContext* c = (VoxContext*)context;
+	benchmarkSink = (f32)exportVoxFile(c->filepath, c->voxelArray, VOX_DEFAULT_VOXEL_SIZE);
+}
+
+static void benchmarkVoxImport(void* context) {
+	VoxContext* c = (VoxContext*)context;
+	c->importedVoxelArray->voxelsCount = 0;
+	c->importedVoxelArray->groupsCount = 0;
+	c->importedVoxelArray->dirtySpansCount = 0;
+	benchmarkSink = (f32)importVoxFile(c->filepath, c->importedVoxelArray, VOX_DEFAULT_VOXEL_SIZE);
+}
+
+struct JournalContext {
+	EditJournal* journal;
+	VoxelArray* voxelArray;
+};
+
+//undoes the last edit and redoes it, so every repetition starts from the same state
+static void benchmarkJournalUndoRedo(void* context) {
+	JournalContext* c = (JournalContext*)context;
+	bool32 isApplied = undoEdit(c->journal, c->voxelArray, nil);
+	isApplied &= redoEdit(c->journal, c->voxelArray, nil);
+	c->voxelArray->dirtyGroupsCount = 0;
+	c->voxelArray->dirtySpansCount = 0;
+	benchmarkSink = (f32)isApplied;
+}
+
+struct RegionContext {
+	VoxelArray* voxelArray;
+	JobQueue* jobQueue;
+	VoxelRegion region;
+	i32 cellSize;
+	i32 hollowThickness;
+	i32 groupIndex;
+	i32 voxelsCount;
+	VoxelClipboard* clipboard;
+	u32 repetition;
+};
+
+//every repetition fills the same group again
+static void benchmarkRegionFill(void* context) {
+	RegionContext* c = (RegionContext*)context;
+	c->voxelArray->voxelsCount = c->voxelsCount;
+	VoxelGroup* group = &c->voxelArray->groups[c->groupIndex];
+	group->voxelsCount = 0;
+	group->voxelsBegin = 0;
+	group->voxelsEnd = 0;
+	c->voxelArray->dirtySpansCount = 0;
+	benchmarkSink = (f32)fillVoxelRegion(c->voxelArray, c->jobQueue, nil, c->region, c->cellSize, c->hollowThickness, RGBAColorF32{ 0.3f, 0.1f, 0.7f, 1.0f }, c->groupIndex);
+}
+
+//swaps two colors back and forth, so every repetition recolors the same voxels
+static void benchmarkRegionReplaceColor(void* context) {
+	RegionContext* c = (RegionContext*)context;
+	RGBAColorF32 colors[2] = { { 0.3f, 0.1f, 0.7f, 1.0f }, { 0.5f, 0.5f, 0.5f, 1.0f } };
+	c->repetition += 1;
+	c->voxelArray->dirtySpansCount = 0;
+	benchmarkSink = (f32)replaceVoxelRegionColor(c->voxelArray, c->jobQueue, nil, c->region, c->groupIndex, colors[c->repetition % 2], colors[(c->repetition + 1) % 2]);
+}
+
+static void benchmarkRegionCopy(void* context) {
+	RegionContext* c = (RegionContext*)context;
+	benchmarkSink = (f32)copyVoxelRegion(c->voxelArray, c->jobQueue, c->region, c->groupIndex, c->clipboard);
+}
+
+struct SelectionContext {
+	VoxelArray* voxelArray;
+	JobQueue* jobQueue;
+	VoxelSpatialIndex* index;
+	VoxelSelection* selection;
+	AABB box;
+	math::Matrix4 viewProjection;
+	math::Vector2 lasso[8];
+	u32 repetition;
+};
+
+static void benchmarkSpatialIndexRefresh(void* context) {
+	SelectionContext* c = (SelectionContext*)context;
+	memset(c->index->isChunkStale, 1, c->index->chunksCapacity);
+	refreshVoxelSpatialIndex(c->index, c->voxelArray, c->jobQueue);
+	benchmarkSink = c->index->chunkBounds[0].min.x;
+}
+
+static void benchmarkSelectBox(void* context) {
+	SelectionContext* c = (SelectionContext*)context;
+	benchmarkSink = (f32)selectVoxelsInBox(c->selection, c->index, c->voxelArray, c->jobQueue, c->box, VOXEL_SELECTION_REPLACE);
+}
+
+static void benchmarkSelectLasso(void* context) {
+	SelectionContext* c = (SelectionContext*)context;
+	benchmarkSink = (f32)selectVoxelsInLasso(c->selection, c->index, c->voxelArray, c->jobQueue, c->viewProjection, c->lasso, 8, VOXEL_SELECTION_REPLACE);
+}
+
+//alternates two colors, so every repetition writes the selected voxels
+static void benchmarkRecolorSelection(void* context) {
+	SelectionContext* c = (SelectionContext*)context;
+	RGBAColorF32 colors[2] = { { 0.3f, 0.1f, 0.7f, 1.0f }, { 0.5f, 0.5f, 0.5f, 1.0f } };
+	c->repetition += 1;
+	c->voxelArray->dirtySpansCount = 0;
+	recolorVoxelSelection(c->selection, c->voxelArray, c->jobQueue, nil, colors[c->repetition % 2]);
+	benchmarkSink = c->voxelArray->colors[0].r;
+}
+
+struct TranslucencyContext {
+	TranslucentVoxels* translucentVoxels;
+	math::Matrix4* models;
+	RGBAColorF32* colors;
+	u32 repetition;
+};
+
+//the camera circles the voxels by about as much as it turns in a frame, so every repetition sorts them in a slightly different order
+static void benchmarkSortTranslucentVoxels(void* context) {
+	TranslucencyContext* c = (TranslucencyContext*)context;
+	c->repetition += 1;
+	f32 angle = 0.01f * (f32)c->repetition;
+	math::Vector3 eye = { 150.0f * cosf(angle), 40.0f, 150.0f * sinf(angle) };
+	math::Matrix4 view = math::lookAt(eye, math::Vector3{}, math::Vector3{ 0.0f, 1.0f, 0.0f });
+	i32 count = sortTranslucentVoxels(c->translucentVoxels, view, c->models, c->colors);
+	benchmarkSink = c->models[count - 1].e.m03;
+}
+
+struct OcclusionContext {
+	VoxelArray* voxelArray;
+	JobQueue* jobQueue;
+	MemoryAllocator* memoryAllocator;
+	VoxelOcclusion* occlusion;
+	u32 repetition;
+};
+
+//hashes every voxel and computes all of their occlusion, like the first frame after a world is loaded
+static void benchmarkBakeVoxelOcclusion(void* context) {
+	OcclusionContext* c = (OcclusionContext*)context;
+	u64 byteOffset = c->memoryAllocator->byteOffset;
+	VoxelOcclusion occlusion = {};
+	initVoxelOcclusion(&occlusion, c->memoryAllocator, c->voxelArray);
+	updateVoxelOcclusion(&occlusion, c->voxelArray, c->jobQueue, nil, 0);
+	benchmarkSink = (f32)occlusion.occlusions[c->voxelArray->voxelsCount / 2];
+	c->memoryAllocator->byteOffset = byteOffset;
+}
+
+//moves a voxel in the middle of the box up and back, which recomputes the chunks of the voxels around it
+static void benchmarkUpdateVoxelOcclusion(void* context) {
+	OcclusionContext* c = (OcclusionContext*)context;
+	c->repetition += 1;
+	i32 voxelIndex = c->voxelArray->voxelsCount / 2;
+	c->voxelArray->voxelsPosition[voxelIndex].y += c->repetition % 2 ? 4 : -4;
+	VoxelSpan span = { voxelIndex, voxelIndex + 1 };
+	updateVoxelOcclusion(c->occlusion, c->voxelArray, c->jobQueue, &span, 1);
+	collectVoxelOcclusionChanges(c->occlusion, &span);
+	benchmarkSink = (f32)span.end;
+}
+
+struct LightContext {
+	VoxelArray* voxelArray;
+	JobQueue* jobQueue;
+	VoxelLight* light;
+	VoxelShadow* shadow;
+	VoxelTracer* tracer;
+	VoxelTracerConfig* tracerConfig;
+	math::Matrix4 tracerView;
+	math::Matrix4 tracerProjection;
+	u8* pixels;
+	i32 roofVoxelIndex;
+	u32 repetition;
+};
+
+//fills every cell from the sky and the sources again, like the first frame after a world is loaded
+static void benchmarkRelightVoxelLight(void* context) {
+	LightContext* c = (LightContext*)context;
+	c->light->isRelightNeeded = 1;
+	updateVoxelLight(c->light, c->voxelArray, c->jobQueue, nil, 0, 0);
+	benchmarkSink = (f32)c->light->voxelLevels[c->voxelArray->voxelsCount / 2];
+}
+
+//places a source under the roof, and takes it out again the next time
+static void benchmarkToggleVoxelLightSource(void* context) {
+	LightContext* c = (LightContext*)context;
+	c->repetition += 1;
+	setVoxelLightSource(c->light, Vector3i{ 514, 42, 514 }, c->repetition % 2 ? 15 : 0);
+	updateVoxelLight(c->light, c->voxelArray, c->jobQueue, nil, 0, 0);
+	VoxelSpan span;
+	collectVoxelLightChanges(c->light, &span);
+	benchmarkSink = (f32)span.end;
+}
+
+//opens a hole in the roof and closes it again the next time, which lets a column of sky light in and takes it out
+static void benchmarkToggleVoxelLightRoof(void* context) {
+	LightContext* c = (LightContext*)context;
+	c->repetition += 1;
+	i32 voxelIndex = c->roofVoxelIndex;
+	c->voxelArray->voxelsScale[voxelIndex] = c->repetition % 2 ? Vector3ui{ 0, 0, 0 } : Vector3ui{ 4, 4, 4 };
+	VoxelSpan span = { voxelIndex, voxelIndex + 1 };
+	updateVoxelLight(c->light, c->voxelArray, c->jobQueue, &span, 1, 0);
+	collectVoxelLightChanges(c->light, &span);
+	benchmarkSink = (f32)span.end;
+}
+
+//rebuilds the shadow's occupancy of every chunk, like after a relight
+static void benchmarkRebuildVoxelShadow(void* context) {
+	LightContext* c = (LightContext*)context;
+	memset(c->light->isChunkBlockingChanged, 1, c->light->chunksCount);
+	updateVoxelShadow(c->shadow, c->light, c->jobQueue);
+	i32 chunksBegin;
+	i32 chunksEnd;
+	collectVoxelShadowChanges(c->shadow, &chunksBegin, &chunksEnd);
+	benchmarkSink = (f32)c->shadow->occupancy[chunksEnd * VOXEL_SHADOW_CHUNK_WORDS / 2];
+}
+
+//marches a ray from the top of every floor voxel toward a low sun, most of which go under the roof until they leave the volume
+static void benchmarkMarchVoxelShadowRays(void* context) {
+	LightContext* c = (LightContext*)context;
+	math::Vector3 up = { 0.0f, 1.0f, 0.0f };
+	math::Vector3 sun = math::Vector3{ 0.6f, 0.3f, 0.4f }.normalize();
+	i32 shadowedCount = 0;
+	for (i32 z = 0; z < 256; z++) {
+		for (i32 x = 0; x < 256; x++) {
+			shadowedCount += isVoxelShadowed(c->shadow, math::Vector3{ 4.0f * x + 2.0f, 4.0f, 4.0f * z + 2.0f }, up, sun);
+		}
+	}
+	benchmarkSink = (f32)shadowedCount;
+}
+
+//path traces the floor under the roof from a corner of the volume, with the tracer's leaves rebuilt first like for every image
+static void benchmarkTraceVoxelImage(void* context) {
+	LightContext* c = (LightContext*)context;
+	VoxelTracerStats stats;
+	traceVoxelImage(c->tracer, c->jobQueue, c->tracerView, c->tracerProjection, c->tracerConfig, c->pixels, &stats);
+	benchmarkSink = (f32)c->pixels[4 * c->tracerConfig->width * c->tracerConfig->height / 2];
+}
+
+struct SortKeyValue32 {
+	u32 key;
+	u32 value;
+};
+
+struct SortKeyValue64 {
+	u64 key;
+	u32 value;
+};
+
+//every repetition copies the same random keys in, and sorts them with their indices as values
+struct SortContext {
+	JobQueue* jobQueue;
+	MemoryAllocator* scratch;
+	i32 count;
+	const u64* sourceKeys;
+	u64* keys;
+	u32* values;
+	void* pairs;
+};
+
+static void loadSortKeys32(SortContext* c) {
+	u32* keys = (u32*)c->keys;
+	for (i32 i = 0; i < c->count; i++) {
+		keys[i] = (u32)c->sourceKeys[i];
+		c->values[i] = i;
+	}
+}
+
+static void loadSortKeys64(SortContext* c) {
+	memcpy(c->keys, c->sourceKeys, c->count * sizeof(u64));
+	for (i32 i = 0; i < c->count; i++) {
+		c->values[i] = i;
+	}
+}
+
+static void benchmarkRadixSort32(void* context) {
+	SortContext* c = (SortContext*)context;
+	loadSortKeys32(c);
+	radixSort((u32*)c->keys, c->values, c->count, c->scratch);
+	benchmarkSink = (f32)c->values[c->count / 2];
+}
+
+static void benchmarkParallelRadixSort32(void* context) {
+	SortContext* c = (SortContext*)context;
+	loadSortKeys32(c);
+	parallelRadixSort(c->jobQueue, (u32*)c->keys, c->values, c->count, c->scratch);
+	benchmarkSink = (f32)c->values[c->count / 2];
+}
+
+static void benchmarkStdSort32(void* context) {
+	SortContext* c = (SortContext*)context;
+	SortKeyValue32* pairs = (SortKeyValue32*)c->pairs;
+	for (i32 i = 0; i < c->count; i++) {
+		pairs[i].key = (u32)c->sourceKeys[i];
+		pairs[i].value = i;
+	}
+	std::sort(pairs, pairs + c->count, [](const SortKeyValue32& a, const SortKeyValue32& b) { return a.key < b.key; });
+	benchmarkSink = (f32)pairs[c->count / 2].value;
+}
+
+static void benchmarkRadixSort64(void* context) {
+	SortContext* c = (SortContext*)context;
+	loadSortKeys64(c);
+	radixSort(c->keys, c->values, c->count, c->scratch);
+	benchmarkSink = (f32)c->values[c->count / 2];
+}
+
+static void benchmarkParallelRadixSort64(void* context) {
+	SortContext* c = (SortContext*)context;
+	loadSortKeys64(c);
+	parallelRadixSort(c->jobQueue, c->keys, c->values, c->count, c->scratch);
+	benchmarkSink = (f32)c->values[c->count / 2];
+}
+
+static void benchmarkStdSort64(void* context) {
+	SortContext* c = (SortContext*)context;
+	SortKeyValue64* pairs = (SortKeyValue64*)c->pairs;
+	for (i32 i = 0; i < c->count; i++) {
+		pairs[i].key = c->sourceKeys[i];
+		pairs[i].value = i;
+	}
+	std::sort(pairs, pairs + c->count, [](const SortKeyValue64& a, const SortKeyValue64& b) { return a.key < b.key; });
+	benchmarkSink = (f32)pairs[c->count / 2].value;
+}
+
+//a scene similar to the editor's: groups of voxels spread in front of a camera at the origin, some of them rotated
+static void fillBenchmarkVoxelArray(VoxelArray* voxelArray, i32 voxelsCount) {
+	const i32 voxelsPerGroup = 64;
+	RGBAColorF32 color = { 1.0f, 1.0f, 1.0f, 1.0f };
+	i32 groupIndex = -1;
+	for (i32 i = 0; i < voxelsCount; i++) {
+		if (i % voxelsPerGroup == 0) {
+			math::Vector3 position = { randomF32(-400.0f, 400.0f), randomF32(-400.0f, 400.0f), randomF32(-800.0f, -40.0f) };
+			groupIndex = addEmptyVoxelGroup(voxelArray, position);
+			if (groupIndex % 2 == 1) {
+				voxelArray->groups[groupIndex].rotation = math::createQuaternionRotation(randomF32(0.0f, TAU32), randomUnitVector());
+			}
+		}
+		Vector3i position = { (i32)(randomU32() % 32) - 16, (i32)(randomU32() % 32) - 16, (i32)(randomU32() % 32) - 16 };
+		addVoxelToGroup(voxelArray, color, position, Vector3ui{ 2, 2, 2 }, groupIndex);
+	}
+}
+
+int main(int argc, char** argv) {
+	BenchmarkConfig config = {};
+	config.warmupRepetitions = 3;
+	config.repetitions = 31;
+
+	for (int i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+			config.filter = argv[++i];
+		} else if (strcmp(argv[i], "--repetitions") == 0 && i + 1 < argc) {
+			config.repetitions = (u32)atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+			config.warmupRepetitions = (u32)atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+			config.jsonFilepath = argv[++i];
+		} else {
+			printf("usage: %s [--filter substring] [--repetitions n] [--warmup n] [--json path]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (config.repetitions == 0) {
+		printf("repetitions must be at least 1\n");
+		return 1;
+	}
+
+	MemoryAllocator memoryAllocator = {};
+	initMemoryAllocator(&memoryAllocator, gigabyte(1));
+
+	printf("%-40s %10s %14s %14s %14s %12s\n", "benchmark", "items", "median us", "p99 us", "min us", "ns/item");
+
+	{
+		MathContext c = {};
+		c.count = 4096;
+		c.matrices = (math::Matrix4*) allocateMemory(&memoryAllocator, c.count * sizeof(math::Matrix4));
+		c.quaternions = (math::Quaternion*) allocateMemory(&memoryAllocator, c.count * sizeof(math::Quaternion));
+		c.vectors = (math::Vector3*) allocateMemory(&memoryAllocator, c.count * sizeof(math::Vector3));
+		for (u32 i = 0; i < c.count; i++) {
+			c.quaternions[i] = math::createQuaternionRotation(randomF32(0.0f, TAU32), randomUnitVector());
+			c.vectors[i] = math::Vector3{ randomF32(-10.0f, 10.0f), randomF32(-10.0f, 10.0f), randomF32(-10.0f, 10.0f) };
+			c.matrices[i] = math::translateMatrix(math::initIdentityMatrix(), c.vectors[i]).multiply(math::createRotationMatrix(c.quaternions[i]));
+		}
+
+		runBenchmark(&config, "math/matrix_multiply", c.count - 1, benchmarkMatrixMultiply, &c);
+		runBenchmark(&config, "math/matrix_inverse", c.count, benchmarkMatrixInverse, &c);
+		runBenchmark(&config, "math/rotate_vector", c.count, benchmarkRotateVector, &c);
+		runBenchmark(&config, "math/multiply_quaternions", c.count - 1, benchmarkMultiplyQuaternions, &c);
+		runBenchmark(&config, "math/create_rotation_matrix", c.count, benchmarkCreateRotationMatrix, &c);
+	}
+
+	{
+		RayContext c = {};
+		c.count = 4096;
+		c.rays = (Ray*) allocateMemory(&memoryAllocator, c.count * sizeof(Ray));
+		c.aabbs = (AABB*) allocateMemory(&memoryAllocator, c.count * sizeof(AABB));
+		c.obbs = (OBB*) allocateMemory(&memoryAllocator, c.count * sizeof(OBB));
+		for (u32 i = 0; i < c.count; i++) {
+			c.rays[i].origin = math::Vector3{};
+			c.rays[i].direction = randomUnitVector();
+			math::Vector3 center = { randomF32(-20.0f, 20.0f), randomF32(-20.0f, 20.0f), randomF32(-20.0f, 20.0f) };
+			math::Vector3 halfExtents = { randomF32(0.5f, 4.0f), randomF32(0.5f, 4.0f), randomF32(0.5f, 4.0f) };
+			c.aabbs[i].min = center.sub(halfExtents);
+			c.aabbs[i].max = center.add(halfExtents);
+			c.obbs[i].center = center;
+			c.obbs[i].halfExtents = halfExtents;
+			c.obbs[i].orientation = math::createQuaternionRotation(randomF32(0.0f, TAU32), randomUnitVector());
+		}
+
+		runBenchmark(&config, "collision/ray_aabb", c.count, benchmarkRayAABB, &c);
+		runBenchmark(&config, "collision/ray_obb", c.count, benchmarkRayOBB, &c);
+	}
+
+	{
+		const i32 voxelCounts[] = { 1024, 65536 };
+		const char* pickingNames[] = { "voxel/picking_1k", "voxel/picking_64k" };
+		const char* transformNames[] = { "voxel/instance_transform_build_1k", "voxel/instance_transform_build_64k" };
+		const char* dirtyNames[] = { "voxel/dirty_instance_build_1k_4_groups", "voxel/dirty_instance_build_64k_4_groups" };
+		for (u32 n = 0; n < sizeof(voxelCounts) / sizeof(voxelCounts[0]); n++) {
+			u64 byteOffset = memoryAllocator.byteOffset;
+
+			VoxelArray voxelArray = {};
+			initVoxelArray(&voxelArray, &memoryAllocator, voxelCounts[n], voxelCounts[n] / 64 + 1);
+			fillBenchmarkVoxelArray(&voxelArray, voxelCounts[n]);
+
+			VoxelContext c = {};
+			c.voxelArray = &voxelArray;
+			c.raysCount = 16;
+			c.rays = (Ray*) allocateMemory(&memoryAllocator, c.raysCount * sizeof(Ray));
+			c.models = (math::Matrix4*) allocateMemory(&memoryAllocator, voxelCounts[n] * sizeof(math::Matrix4));
+			c.dirtyGroupsCount = 4;
+			c.spansCapacity = voxelArray.groupsCapacity + MAX_DIRTY_VOXEL_SPANS;
+			c.spans = (VoxelSpan*) allocateMemory(&memoryAllocator, c.spansCapacity * sizeof(VoxelSpan));
+			collectDirtyVoxelSpans(&voxelArray, c.spans, c.spansCapacity);
+			for (u32 i = 0; i < c.raysCount; i++) {
+				c.rays[i].origin = math::Vector3{};
+				c.rays[i].direction = math::Vector3{ randomF32(-0.5f, 0.5f), randomF32(-0.5f, 0.5f), -1.0f }.normalize();
+			}
+
+			//picking is measured per voxel tested, so both sizes report the cost of one ray-obb test inside the loop
+			runBenchmark(&config, pickingNames[n], (u64)c.raysCount * voxelCounts[n], benchmarkPicking, &c);
+			runBenchmark(&config, transformNames[n], voxelCounts[n], benchmarkInstanceTransformBuild, &c);
+			//reported per voxel in the world, so it can be compared against the full rebuild
+			runBenchmark(&config, dirtyNames[n], voxelCounts[n], benchmarkDirtyInstanceBuild, &c);
+
+			memoryAllocator.byteOffset = byteOffset;
+		}
+	}
+
+	{
+		MemoryAllocator arena = {};
+		initMemoryAllocator(&arena, 64 * 1024 * 1024);
+		AllocationContext c = {};
+		c.allocator = &arena;
+		c.count = 65536;
+		c.sizes = (u32*) allocateMemory(&memoryAllocator, c.count * sizeof(u32));
+		for (u32 i = 0; i < c.count; i++) {
+			c.sizes[i] = 1 + randomU32() % 512;
+		}
+		runBenchmark(&config, "memory/arena_allocation", c.count, benchmarkArenaAllocation, &c);
+
+		InsertionContext insertion = {};
+		insertion.allocator = &arena;
+		insertion.voxelsCount = 262144;
+		insertion.voxelsPerGroup = 64;
+		runBenchmark(&config, "voxel/insertion_256k", insertion.voxelsCount, benchmarkVoxelInsertion, &insertion);
+		free(arena.memory);
+	}
+
+	{
+		u64 byteOffset = memoryAllocator.byteOffset;
+		MipChainContext c = {};
+		c.width = 256;
+		c.height = 256;
+		c.mipLevelsCount = calculateMipLevelsCount(c.width, c.height);
+		//the bc1 blocks of the base level go right after the chain
+		u64 chainSize = calculateMipChainSize(c.width, c.height, c.mipLevelsCount);
+		c.pixels = (u8*) allocateMemory(&memoryAllocator, chainSize + calculateTextureLevelSize(TEXTURE_FORMAT_BC1_SRGB, c.width, c.height));
+		for (u32 i = 0; i < c.width * c.height * 4; i++) {
+			c.pixels[i] = (u8)randomU32();
+		}
+		//reported per base level pixel
+		runBenchmark(&config, "texture/mip_chain_256x256_srgb", c.width * c.height, benchmarkMipChainGeneration, &c);
+		runBenchmark(&config, "texture/bc1_compression_256x256", c.width * c.height, benchmarkBC1Compression, &c);
+		memoryAllocator.byteOffset = byteOffset;
+	}
+
+	{
+		u64 byteOffset = memoryAllocator.byteOffset;
+		const char* worldPath = "benchmark.vxworld";
+		const i32 voxelsCount = 1024 * 1024;
+		WorldContext c = {};
+		c.voxelArray = (VoxelArray*) allocateMemory(&memoryAllocator, sizeof(VoxelArray));
+		c.openedVoxelArray = (VoxelArray*) allocateMemory(&memoryAllocator, sizeof(VoxelArray));
+		initVoxelArray(c.voxelArray, &memoryAllocator, voxelsCount, voxelsCount / 64 + 1);
+		initVoxelArray(c.openedVoxelArray, &memoryAllocator, voxelsCount, voxelsCount / 64 + 1);
+		fillBenchmarkVoxelArray(c.voxelArray, voxelsCount);
+		c.chunkData = (u8*) allocateMemory(&memoryAllocator, calculateWorldChunkMaxEncodedSize(VOXELS_PER_CHUNK));
+		c.openedVoxelArray->groupsCount = c.voxelArray->groupsCount;
+		runBenchmark(&config, "world/chunk_encode", VOXELS_PER_CHUNK, benchmarkWorldChunkEncode, &c);
+		runBenchmark(&config, "world/chunk_decode", VOXELS_PER_CHUNK, benchmarkWorldChunkDecode, &c);
+
+		remove(worldPath);
+		c.world = (World*) allocateMemory(&memoryAllocator, sizeof(World));
+		c.openedWorld = (World*) allocateMemory(&memoryAllocator, sizeof(World));
+		initWorld(c.world, &memoryAllocator, c.voxelArray, worldPath);
+		initWorld(c.openedWorld, &memoryAllocator, c.openedVoxelArray, worldPath);
+		if (saveWorld(c.world)) {
+			//opening reads the tables and decodes only the last chunk, so it's reported per voxel of the world
+			runBenchmark(&config, "world/open_1m", voxelsCount, benchmarkWorldOpen, &c);
+			runBenchmark(&config, "world/save_small_edit_1m", 1, benchmarkWorldSaveSmallEdit, &c);
+		}
+		closeWorld(c.world);
+		remove(worldPath);
+		memoryAllocator.byteOffset = byteOffset;
+	}
+
+	{
+		u64 byteOffset = memoryAllocator.byteOffset;
+		//64 solid models of 64 x 16 x 64 voxels, in a few colors
+		const i32 groupsCount = 64;
+		const i32 voxelsCount = groupsCount * 64 * 16 * 64;
+		VoxContext c = {};
+		c.filepath = "benchmark.vox";
+		c.voxelArray = (VoxelArray*) allocateMemory(&memoryAllocator, sizeof(VoxelArray));
+		c.importedVoxelArray = (VoxelArray*) allocateMemory(&memoryAllocator, sizeof(VoxelArray));
+		initVoxelArray(c.voxelArray, &memoryAllocator, voxelsCount, groupsCount);
+		initVoxelArray(c.importedVoxelArray, &memoryAllocator, voxelsCount, groupsCount);
+		RGBAColorF32 colors[4] = { { 1.0f, 1.0f, 1.0f, 1.0f }, { 0.5f, 0.25f, 0.0f, 1.0f }, { 0.0f, 1.0f, 1.0f, 0.2f }, { 0.1f, 0.9f, 0.1f, 1.0f } };
+		for (i32 g = 0; g < groupsCount; g++) {
+			i32 groupIndex = addEmptyVoxelGroup(c.voxelArray, math::Vector3{ (f32)(g % 8) * 160.0f, 0.0f, -(f32)(g / 8) * 160.0f });
+			for (i32 i = 0; i < 64 * 16 * 64; i++) {
+				Vector3i position = { (i % 64) * 2, (i / 4096) * 2, ((i / 64) % 64) * 2 };
+				addVoxelToGroup(c.voxelArray, colors[(i / 1000) % 4], position, Vector3ui{ 2, 2, 2 }, groupIndex);
+			}
+		}
+		//reported per voxel
+		runBenchmark(&config, "vox/export_4m", voxelsCount, benchmarkVoxExport, &c);
+		runBenchmark(&config, "vox/import_4m", voxelsCount, benchmarkVoxImport, &c);
+		remove(c.filepath);
+		memoryAllocator.byteOffset = byteOffset;
+	}
+
+	{
+		u64 byteOffset = memoryAllocator.byteOffset;
+		//rolling terrain of 256 x 256 columns, 8 voxels deep, in 16 groups of 64 x 64 columns. grass on top, then dirt and stone
+		const i32 groupsCount = 16;
+		const i32 depth = 8;
+		const i32 voxelsCount = 256 * 256 * depth;
+		VoxelArray* voxelArray = (VoxelArray*) allocateMemory(&memoryAllocator, sizeof(VoxelArray));
+		initVoxelArray(voxelArray, &memoryAllocator, voxelsCount, groupsCount);
+		//colors are r, b, g, a
+		RGBAColorF32 grass = { 0.3f, 0.1f, 0.7f, 1.0f };
+		RGBAColorF32 dirt = { 0.45f, 0.15f, 0.3f, 1.0f };
+		RGBAColorF32 stone = { 0.5f, 0.5f, 0.5f, 1.0f };
+		for (i32 g = 0; g < groupsCount; g++) {
+			i32 groupIndex = addEmptyVoxelGroup(voxelArray, math::Vector3{ (f32)(g % 4) * 128.0f, 0.0f, (f32)(g / 4) * 128.0f });
+			i32 voxelsBegin = voxelArray->voxelsCount;
+			for (i32 z = 0; z < 64; z++) {
+				for (i32 x = 0; x < 64; x++) {
+					i32 worldX = (g % 4) * 64 + x;
+					i32 worldZ = (g / 4) * 64 + z;
+					i32 height = (i32)(6.0f * sinf((f32)worldX * 0.05f) + 6.0f * cosf((f32)worldZ * 0.07f));
+					for (i32 y = 0; y < depth; y++) {
+						RGBAColorF32 color = y == 0 ? grass : (y < 3 ? dirt : stone);
+						addVoxelToGroup(voxelArray, color, Vector3i{ x * 2 - 63, (height - y) * 2, z * 2 - 63 }, Vector3ui{ 2, 2, 2 }, groupIndex);
+					}
+				}
+			}
+			sortVoxelsInMortonOrder(voxelArray, VoxelSpan{ voxelsBegin, voxelArray->voxelsCount });
+		}
+		//reported per voxel
+		runCodecBenchmarks(&config, &memoryAllocator, voxelArray, "world/codec_encode_terrain_512k", "world/codec_decode_terrain_512k");
+
+		//a hollow sphere with colored bands, exported and imported back like a model made in another editor
+		const char* voxPath = "benchmark_codec.vox";
+		const i32 radius = 48;
+		VoxelArray* modelVoxelArray = (VoxelArray*) allocateMemory(&memoryAllocator, sizeof(VoxelArray));
+		initVoxelArray(modelVoxelArray, &memoryAllocator, voxelsCount, groupsCount);
+		i32 groupIndex = addEmptyVoxelGroup(modelVoxelArray, math::Vector3{});
+		RGBAColorF32 bands[4] = { grass, dirt, stone, { 0.9f, 0.9f, 0.9f, 1.0f } };
+		for (i32 z = -radius; z < radius; z++) {
+			for (i32 y = -radius; y < radius; y++) {
+				for (i32 x = -radius; x < radius; x++) {
+					i32 distanceSquared = x * x + y * y + z * z;
+					if (distanceSquared < (radius - 3) * (radius - 3) || distanceSquared >= radius * radius) {
+						continue;
+					}
+					addVoxelToGroup(modelVoxelArray, bands[((y + radius) / 12) % 4], Vector3i{ x * 2 + 1, y * 2 + 1, z * 2 + 1 }, Vector3ui{ 2, 2, 2 }, groupIndex);
+				}
+			}
+		}
+		if (exportVoxFile(voxPath, modelVoxelArray, VOX_DEFAULT_VOXEL_SIZE)) {
+			modelVoxelArray->voxelsCount = 0;
+			modelVoxelArray->groupsCount = 0;
+			if (importVoxFile(voxPath, modelVoxelArray, VOX_DEFAULT_VOXEL_SIZE)) {
+				runCodecBenchmarks(&config, &memoryAllocator, modelVoxelArray, "world/codec_encode_vox_sphere", "world/codec_decode_vox_sphere");
+			}
+		}
+		remove(voxPath);
+		memoryAllocator.byteOffset = byteOffset;
+	}
+
+	{
+		u64 byteOffset = memoryAllocator.byteOffset;
+		//a fill of a million voxels next to a world of a million, then a recolor of the whole world.
+		//the raw bytes are what a copy of the voxels would take, and the encoded bytes are the edit in the journal
+		const i32 voxelsCount = 1024 * 1024;
+		const i32 fillCount = 1024 * 1024;
+		JournalContext c = {};
+		c.voxelArray = (VoxelArray*) allocateMemory(&memoryAllocator, sizeof(VoxelArray));
+		initVoxelArray(c.voxelArray, &memoryAllocator, voxelsCount + fillCount, voxelsCount / 64 + 2);
+		fillBenchmarkVoxelArray(c.voxelArray, voxelsCount);
+		c.journal = (EditJournal*) allocateMemory(&memoryAllocator, sizeof(EditJournal));
+		initEditJournal(c.journal, &memoryAllocator, 64ull * 1024 * 1024, "benchmark.vxjournal");
+		u64 voxelSize = sizeof(RGBAColorF32) + sizeof(Vector3i) + sizeof(Vector3ui) + sizeof(i32);
+
+		beginEdit(c.journal, c.voxelArray, 0);
+		i32 groupIndex = addEmptyVoxelGroup(c.voxelArray, math::Vector3{ 0.0f, -200.0f, 0.0f });
+		for (i32 i = 0; i < fillCount; i++) {
+			addVoxelToGroup(c.voxelArray, RGBAColorF32{ 0.3f, 0.1f, 0.7f, 1.0f }, Vector3i{ (i % 128) * 2, (i / 16384) * 2, ((i / 128) % 128) * 2 }, Vector3ui{ 2, 2, 2 }, groupIndex);
+		}
+		endEdit(c.journal, c.voxelArray);
+		//reported per filled voxel
+		runCodecBenchmark(&config, "journal/undo_redo_fill_1m", fillCount, (u64)fillCount * voxelSize, c.journal->entries[0].size, benchmarkJournalUndoRedo, &c);
+
+		beginEdit(c.journal, c.voxelArray, 0);
+		VoxelSpan span = { 0, voxelsCount };
+		recordVoxelSpanEdit(c.journal, c.voxelArray, span);
+		for (i32 i = span.begin; i < span.end; i++) {
+			c.voxelArray->colors[i] = RGBAColorF32{ 0.5f, 0.5f, (f32)(i / 4096 % 2), 1.0f };
+		}
+		markVoxelSpanDirty(c.voxelArray, span);
+		endEdit(c.journal, c.voxelArray);
+		//reported per recolored voxel
+		runCodecBenchmark(&config, "journal/undo_redo_recolor_1m", voxelsCount, (u64)voxelsCount * voxelSize, c.journal->entries[1].size, benchmarkJournalUndoRedo, &c);
+		destroyEditJournal(c.journal);
+		memoryAllocator.byteOffset = byteOffset;
+	}
+
+	{
+		u64 byteOffset = memoryAllocator.byteOffset;
+		//regions of 512 voxel units on a side, filled with voxels of 4, which is 2m voxels for the box
+		const i32 voxelsCapacity = 128 * 128 * 128;
+		JobQueue* jobQueue = (JobQueue*) malloc(sizeof(JobQueue));
+		initJobQueue(jobQueue, MAX(1u, getLogicalProcessorCount() - 1));
+		RegionContext c = {};
+		c.voxelArray = (VoxelArray*) allocateMemory(&memoryAllocator, sizeof(VoxelArray));
+		initVoxelArray(c.voxelArray, &memoryAllocator, voxelsCapacity, 1);
+		c.jobQueue = jobQueue;
+		c.cellSize = 4;
+		c.groupIndex = addEmptyVoxelGroup(c.voxelArray, math::Vector3{});
+		c.region = VoxelRegion{ VOXEL_REGION_BOX, { -256, -256, -256 }, { 256, 256, 256 } };
+		//reported per cell of the region
+		runBenchmark(&config, "region/fill_box_512", voxelsCapacity, benchmarkRegionFill, &c);
+		c.region.shape = VOXEL_REGION_CYLINDER;
+		runBenchmark(&config, "region/fill_cylinder_512", voxelsCapacity, benchmarkRegionFill, &c);
+		c.region.shape = VOXEL_REGION_SPHERE;
+		c.hollowThickness = 2;
+		runBenchmark(&config, "region/fill_hollow_sphere_512", voxelsCapacity, benchmarkRegionFill, &c);
+		c.hollowThickness = 0;
+		runBenchmark(&config, "region/fill_sphere_512", voxelsCapacity, benchmarkRegionFill, &c);
+
+		//the sphere's voxels in the upper half of the region
+		c.region.min.y = 0;
+		c.clipboard = (VoxelClipboard*) allocateMemory(&memoryAllocator, sizeof(VoxelClipboard));
+		initVoxelClipboard(c.clipboard, &memoryAllocator, c.voxelArray->voxelsCount);
+		//reported per voxel of the group
+		runBenchmark(&config, "region/replace_color_sphere_1m", c.voxelArray->voxelsCount, benchmarkRegionReplaceColor, &c);
+		runBenchmark(&config, "region/copy_sphere_1m", c.voxelArray->voxelsCount, benchmarkRegionCopy, &c);
+		memoryAllocator.byteOffset = byteOffset;
+	}
+
+	{
+		u64 byteOffset = memoryAllocator.byteOffset;
+		//a box of 100 voxels on a side, 1m in all, with selections of a tenth of it
+		const i32 voxelsCapacity = 100 * 100 * 100;
+		JobQueue* jobQueue = (JobQueue*) malloc(sizeof(JobQueue));
+		initJobQueue(jobQueue, MAX(1u, getLogicalProcessorCount() - 1));
+		SelectionContext c = {};
+		c.voxelArray = (VoxelArray*) allocateMemory(&memoryAllocator, sizeof(VoxelArray));
+		initVoxelArray(c.voxelArray, &memoryAllocator, voxelsCapacity, 1);
+		c.jobQueue = jobQueue;
+		i32 groupIndex = addEmptyVoxelGroup(c.voxelArray, math::Vector3{});
+		fillVoxelRegion(c.voxelArray, jobQueue, nil, VoxelRegion{ VOXEL_REGION_BOX, { 0, 0, 0 }, { 400, 400, 400 } }, 4, 0, RGBAColorF32{ 1.0f, 1.0f, 1.0f, 1.0f }, groupIndex);
+		c.voxelArray->dirtySpansCount = 0;
+		c.index = (VoxelSpatialIndex*) allocateMemory(&memoryAllocator, sizeof(VoxelSpatialIndex));
+		initVoxelSpatialIndex(c.index, &memoryAllocator, c.voxelArray);
+		c.selection = (VoxelSelection*) allocateMemory(&memoryAllocator, sizeof(VoxelSelection));
+		initVoxelSelection(c.selection, &memoryAllocator, c.voxelArray);
+		//reported per voxel of the array
+		runBenchmark(&config, "selection/index_refresh_1m", voxelsCapacity, benchmarkSpatialIndexRefresh, &c);
+		//voxels are filled along x, then y, then z, so a slab along z covers whole chunks and one along x cuts through every chunk.
+		//reported per selected voxel
+		c.box = AABB{ { 0.0f, 0.0f, 0.0f }, { 100.0f, 100.0f, 10.0f } };
+		runBenchmark(&config, "selection/box_select_100k_whole_chunks", voxelsCapacity / 10, benchmarkSelectBox, &c);
+		c.box = AABB{ { 0.0f, 0.0f, 0.0f }, { 10.0f, 100.0f, 100.0f } };
+		runBenchmark(&config, "selection/box_select_100k_every_chunk", voxelsCapacity / 10, benchmarkSelectBox, &c);
+		runBenchmark(&config, "selection/recolor_100k", voxelsCapacity / 10, benchmarkRecolorSelection, &c);
+
+		//an octagon around the middle of the view of the box from a corner
+		math::Matrix4 view = math::lookAt(math::Vector3{ 150.0f, 120.0f, 150.0f }, math::Vector3{ 50.0f, 50.0f, 50.0f }, math::Vector3{ 0.0f, 1.0f, 0.0f });
+		c.viewProjection = math::createPerspective(math::radians(70.0f), 16.0f / 9.0f, 0.1f, 400.0f).multiply(view);
+		for (i32 i = 0; i < 8; i++) {
+			f32 angle = TAU32 * (f32)i / 8.0f;
+			c.lasso[i] = math::Vector2{ 0.3f * cosf(angle), 0.3f * sinf(angle) };
+		}
+		//reported per voxel of the array
+		runBenchmark(&config, "selection/lasso_1m", voxelsCapacity, benchmarkSelectLasso, &c);
+		memoryAllocator.byteOffset = byteOffset;
+	}
+
+	{
+		u64 byteOffset = memoryAllocator.byteOffset;
+		//translucent voxels scattered through a box of 200 world units on a side
+		const i32 translucentCapacity = 256 * 1024;
+		TranslucencyContext c = {};
+		c.translucentVoxels = (TranslucentVoxels*) allocateMemory(&memoryAllocator, sizeof(TranslucentVoxels));
+		initTranslucentVoxels(c.translucentVoxels, &memoryAllocator, translucentCapacity, translucentCapacity);
+		c.models = (math::Matrix4*) allocateMemory(&memoryAllocator, translucentCapacity * sizeof(math::Matrix4));
+		c.colors = (RGBAColorF32*) allocateMemory(&memoryAllocator, translucentCapacity * sizeof(RGBAColorF32));
+		u32 random = 1;
+		for (i32 i = 0; i < translucentCapacity; i++) {
+			math::Vector3 position = {};
+			for (i32 a = 0; a < 3; a++) {
+				random = random * 1664525u + 1013904223u;
+				position.v[a] = (f32)(random >> 8) / (f32)(1 << 24) * 200.0f - 100.0f;
+			}
+			math::Matrix4 model = math::translateMatrix(math::initIdentityMatrix(), position);
+			updateTranslucentVoxel(c.translucentVoxels, i, model, RGBAColorF32{ 0.0f, 1.0f, 1.0f, 0.2f });
+			if (i + 1 == 100000) {
+				//reported per translucent voxel
+				runBenchmark(&config, "translucency/sort_100k", c.translucentVoxels->count, benchmarkSortTranslucentVoxels, &c);
+			}
+		}
+		runBenchmark(&config, "translucency/sort_256k", c.translucentVoxels->count, benchmarkSortTranslucentVoxels, &c);
+		memoryAllocator.byteOffset = byteOffset;
+	}
+
+	{
+		u64 byteOffset = memoryAllocator.byteOffset;
+		//a solid box of 100 voxels on a side, so nearly every corner is next to other voxels
+		const i32 voxelsCapacity = 100 * 100 * 100;
+		JobQueue* jobQueue = (JobQueue*) malloc(sizeof(JobQueue));
+		initJobQueue(jobQueue, MAX(1u, getLogicalProcessorCount() - 1));
+		OcclusionContext c = {};
+		c.voxelArray = (VoxelArray*) allocateMemory(&memoryAllocator, sizeof(VoxelArray));
+		initVoxelArray(c.voxelArray, &memoryAllocator, voxelsCapacity, 1);
+		c.jobQueue = jobQueue;
+		c.memoryAllocator = &memoryAllocator;
+		i32 groupIndex = addEmptyVoxelGroup(c.voxelArray, math::Vector3{});
+		fillVoxelRegion(c.voxelArray, jobQueue, nil, VoxelRegion{ VOXEL_REGION_BOX, { 0, 0, 0 }, { 400, 400, 400 } }, 4, 0, RGBAColorF32{ 1.0f, 1.0f, 1.0f, 1.0f }, groupIndex);
+		c.voxelArray->dirtySpansCount = 0;
+		//reported per voxel
+		runBenchmark(&config, "occlusion/bake_1m", c.voxelArray->voxelsCount, benchmarkBakeVoxelOcclusion, &c);
+		c.occlusion = (VoxelOcclusion*) allocateMemory(&memoryAllocator, sizeof(VoxelOcclusion));
+		initVoxelOcclusion(c.occlusion, &memoryAllocator, c.voxelArray);
+		updateVoxelOcclusion(c.occlusion, c.voxelArray, jobQueue, nil, 0);
+		//reported per update
+		runBenchmark(&config, "occlusion/update_one_voxel_1m", 1, benchmarkUpdateVoxelOcclusion, &c);
+		memoryAllocator.byteOffset = byteOffset;
+	}
+
+	{
+		u64 byteOffset = memoryAllocator.byteOffset;
+		//a volume of 256x64x256 cells of 4 voxel units, with a floor and a roof of a voxel per cell, and a source in every 16th cell
+		//between them
+		JobQueue* jobQueue = (JobQueue*) malloc(sizeof(JobQueue));
+		initJobQueue(jobQueue, MAX(1u, getLogicalProcessorCount() - 1));
+		LightContext c = {};
+		c.voxelArray = (VoxelArray*) allocateMemory(&memoryAllocator, sizeof(VoxelArray));
+		initVoxelArray(c.voxelArray, &memoryAllocator, 2 * 256 * 256, 1);
+		c.jobQueue = jobQueue;
+		i32 groupIndex = addEmptyVoxelGroup(c.voxelArray, math::Vector3{});
+		for (i32 layer = 0; layer < 2; layer++) {
+			for (i32 z = 0; z < 256; z++) {
+				for (i32 x = 0; x < 256; x++) {
+					Vector3i p = { 4 * x + 2, layer == 0 ? 2 : 4 * 20 + 2, 4 * z + 2 };
+					addVoxelToGroup(c.voxelArray, RGBAColorF32{ 1.0f, 1.0f, 1.0f, 1.0f }, p, Vector3ui{ 4, 4, 4 }, groupIndex);
+				}
+			}
+		}
+		c.voxelArray->dirtySpansCount = 0;
+		c.roofVoxelIndex = 256 * 256 + 128 * 256 + 128;
+		c.light = (VoxelLight*) allocateMemory(&memoryAllocator, sizeof(VoxelLight));
+		initVoxelLight(c.light, &memoryAllocator, c.voxelArray, Vector3i{ 0, 0, 0 }, 4, Vector3i{ 16, 4, 16 }, 4 * 1024 * 1024);
+		for (i32 z = 8; z < 256; z += 16) {
+			for (i32 x = 8; x < 256; x += 16) {
+				setVoxelLightSource(c.light, Vector3i{ 4 * x + 2, 4 * 10 + 2, 4 * z + 2 }, 15);
+			}
+		}
+		//reported per update
+		runBenchmark(&config, "light/relight_4m_cells", 1, benchmarkRelightVoxelLight, &c);
+		runBenchmark(&config, "light/toggle_source", 1, benchmarkToggleVoxelLightSource, &c);
+		runBenchmark(&config, "light/toggle_roof_voxel", 1, benchmarkToggleVoxelLightRoof, &c);
+		c.shadow = (VoxelShadow*) allocateMemory(&memoryAllocator, sizeof(VoxelShadow));
+		initVoxelShadow(c.shadow, &memoryAllocator, c.light);
+		runBenchmark(&config, "shadow/rebuild_4m_cells", 1, benchmarkRebuildVoxelShadow, &c);
+		runBenchmark(&config, "shadow/march_64k_rays", 256 * 256, benchmarkMarchVoxelShadowRays, &c);
+		VoxelSpatialIndex* index = (VoxelSpatialIndex*) allocateMemory(&memoryAllocator, sizeof(VoxelSpatialIndex));
+		initVoxelSpatialIndex(index, &memoryAllocator, c.voxelArray);
+		c.tracer = (VoxelTracer*) allocateMemory(&memoryAllocator, sizeof(VoxelTracer));
+		initVoxelTracer(c.tracer, &memoryAllocator, c.voxelArray, index);
+		VoxelTracerConfig tracerConfig = {};
+		tracerConfig.width = 64;
+		tracerConfig.height = 36;
+		tracerConfig.samplesPerPixel = 1;
+		tracerConfig.maxBounces = 1;
+		tracerConfig.seed = 1;
+		tracerConfig.sunDirection = math::Vector3{ 0.6f, 0.3f, 0.4f }.normalize();
+		tracerConfig.sunColor = math::Vector3{ 1.0f, 1.0f, 1.0f };
+		tracerConfig.skyColor = math::Vector3{ 0.5f, 0.6f, 0.8f };
+		c.tracerConfig = &tracerConfig;
+		c.tracerView = math::lookAt(math::Vector3{ 8.0f, 10.0f, 8.0f }, math::Vector3{ 128.0f, 1.0f, 128.0f }, math::Vector3{ 0.0f, 1.0f, 0.0f });
+		c.tracerProjection = math::createPerspective(math::radians(70.0f), (f32)tracerConfig.width / (f32)tracerConfig.height, 0.1f, 100.0f);
+		c.pixels = (u8*) allocateMemory(&memoryAllocator, 4 * tracerConfig.width * tracerConfig.height);
+		//reported per ray. the image's rays are the same every time, so they're counted once up front
+		for (i32 i = 0; i < 2; i++) {
+			tracerConfig.shadow = i == 0 ? nil : c.shadow;
+			VoxelTracerStats stats;
+			traceVoxelImage(c.tracer, jobQueue, c.tracerView, c.tracerProjection, &tracerConfig, c.pixels, &stats);
+			runBenchmark(&config, i == 0 ? "trace/image_64x36" : "trace/image_64x36_shadow_volume", stats.raysCount, benchmarkTraceVoxelImage, &c);
+		}
+		memoryAllocator.byteOffset = byteOffset;
+	}
+
+	{
+		u64 byteOffset = memoryAllocator.byteOffset;
+		const i32 maxCount = 10 * 1000 * 1000;
+		JobQueue* jobQueue = (JobQueue*) malloc(sizeof(JobQueue));
+		initJobQueue(jobQueue, MAX(1u, getLogicalProcessorCount() - 1));
+		SortContext c = {};
+		c.jobQueue = jobQueue;
+		u64* sourceKeys = (u64*) allocateMemory(&memoryAllocator, maxCount * sizeof(u64));
+		u64 random = 88172645463325252ull;
+		for (i32 i = 0; i < maxCount; i++) {
+			random ^= random << 13;
+			random ^= random >> 7;
+			random ^= random << 17;
+			sourceKeys[i] = random;
+		}
+		c.sourceKeys = sourceKeys;
+		c.keys = (u64*) allocateMemory(&memoryAllocator, maxCount * sizeof(u64));
+		c.values = (u32*) allocateMemory(&memoryAllocator, maxCount * sizeof(u32));
+		c.pairs = allocateMemory(&memoryAllocator, maxCount * sizeof(SortKeyValue64));
+		MemoryAllocator scratch = {};
+		scratch.byteCapacity = calculateRadixSortScratchSize(maxCount, sizeof(u64), 1);
+		scratch.memory = (u8*) allocateMemory(&memoryAllocator, scratch.byteCapacity);
+		c.scratch = &scratch;
+		//random keys use every digit, so no pass is skipped. reported per key
+		c.count = maxCount / 10;
+		runBenchmark(&config, "sort/radix_u32_1m", c.count, benchmarkRadixSort32, &c);
+		runBenchmark(&config, "sort/parallel_radix_u32_1m", c.count, benchmarkParallelRadixSort32, &c);
+		runBenchmark(&config, "sort/std_sort_u32_1m", c.count, benchmarkStdSort32, &c);
+		c.count = maxCount;
+		runBenchmark(&config, "sort/radix_u32_10m", c.count, benchmarkRadixSort32, &c);
+		runBenchmark(&config, "sort/parallel_radix_u32_10m", c.count, benchmarkParallelRadixSort32, &c);
+		runBenchmark(&config, "sort/std_sort_u32_10m", c.count, benchmarkStdSort32, &c);
+		runBenchmark(&config, "sort/radix_u64_10m", c.count, benchmarkRadixSort64, &c);
+		runBenchmark(&config, "sort/parallel_radix_u64_10m", c.count, benchmarkParallelRadixSort64, &c);
+		runBenchmark(&config, "sort/std_sort_u64_10m", c.count, benchmarkStdSort64, &c);
+		memoryAllocator.byteOffset = byteOffset;
+	}
+
+	if (config.jsonFilepath != nil) {
+		if (!writeBenchmarkResultsJSON(config.jsonFilepath)) {
+			return 1;
+		}
+		printf("wrote benchmark results to %s\n", config.jsonFilepath);
+	}
+
+	free(memoryAllocator.memory);
+	return 0;
+}
@@ -0,0 +1,232 @@
+#include "../src/gpu_allocator.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+
+//stands in for vulkan. tracks which blocks are alive and can be told to run out of memory
+struct MockMemory {
+	bool32 isBlockAlive[GPU_ALLOCATOR_MAX_MEMORY_TYPES][GPU_ALLOCATOR_MAX_BLOCKS];
+	u64 blockSizes[GPU_ALLOCATOR_MAX_MEMORY_TYPES][GPU_ALLOCATOR_MAX_BLOCKS];
+	u32 aliveBlocksCount;
+	u32 allocateCallsCount;
+	//blocks past this many fail to allocate
+	u32 blocksLimit;
+};
+
+static bool32 allocateMockBlock(void* context, u32 memoryTypeIndex, u32 blockIndex, u64 size) {
+	MockMemory* memory = (MockMemory*)context;
+	memory->allocateCallsCount += 1;
+	if (memory->isBlockAlive[memoryTypeIndex][blockIndex] || memory->aliveBlocksCount >= memory->blocksLimit) {
+		return 0;
+	}
+	memory->isBlockAlive[memoryTypeIndex][blockIndex] = 1;
+	memory->blockSizes[memoryTypeIndex][blockIndex] = size;
+	memory->aliveBlocksCount += 1;
+	return 1;
+}
+
+static void freeMockBlock(void* context, u32 memoryTypeIndex, u32 blockIndex) {
+	MockMemory* memory = (MockMemory*)context;
+	memory->isBlockAlive[memoryTypeIndex][blockIndex] = 0;
+	memory->aliveBlocksCount -= 1;
+}
+
+static GPUMemoryInterface initMockMemory(MockMemory* memory, u32 blocksLimit) {
+	memset(memory, 0, sizeof(MockMemory));
+	memory->blocksLimit = blocksLimit;
+	GPUMemoryInterface memoryInterface = {};
+	memoryInterface.context = memory;
+	memoryInterface.allocateBlock = allocateMockBlock;
+	memoryInterface.freeBlock = freeMockBlock;
+	return memoryInterface;
+}
+
+static u32 randomState = 12345;
+static u32 nextRandom() {
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return randomState;
+}
+
+static bool32 areOverlapping(GPUAllocation* a, GPUAllocation* b) {
+	if (a->memoryTypeIndex != b->memoryTypeIndex || a->blockIndex != b->blockIndex) {
+		return 0;
+	}
+	u64 aEnd = a->offset + (GPU_ALLOCATOR_MIN_ALLOCATION_SIZE << a->order);
+	u64 bEnd = b->offset + (GPU_ALLOCATOR_MIN_ALLOCATION_SIZE << b->order);
+	return a->offset < bEnd && b->offset < aEnd;
+}
+
+int main() {
+	const u64 blockSize = 1024 * 1024;
+	GPUAllocator* allocator = (GPUAllocator*) malloc(sizeof(GPUAllocator));
+	MockMemory* memory = (MockMemory*) malloc(sizeof(MockMemory));
+
+	{
+		initGPUAllocator(allocator, initMockMemory(memory, 100), 2, blockSize, 1);
+		GPUAllocation a, b, c;
+		if (!allocateGPUMemory(allocator, 1, 1000, 16, GPU_RESOURCE_LINEAR, &a) || !allocateGPUMemory(allocator, 1, 100, 16, GPU_RESOURCE_LINEAR, &b)) {
+			printf("small allocations failed\n");
+			return 1;
+		}
+		if (a.order != 2 || b.order != 0 || memory->aliveBlocksCount != 1 || !memory->isBlockAlive[1][0] || memory->blockSizes[1][0] != blockSize) {
+			printf("small allocations want orders 2 and 0 in one block of type 1. got orders %u and %u in %u blocks\n", a.order, b.order, memory->aliveBlocksCount);
+			return 1;
+		}
+		if (areOverlapping(&a, &b)) {
+			printf("allocations at %llu and %llu overlap\n", (unsigned long long)a.offset, (unsigned long long)b.offset);
+			return 1;
+		}
+		//alignment larger than the size
+		if (!allocateGPUMemory(allocator, 1, 300, 64 * 1024, GPU_RESOURCE_LINEAR, &c) || c.offset % (64 * 1024) != 0) {
+			printf("an allocation aligned to 64k landed at %llu\n", (unsigned long long)c.offset);
+			return 1;
+		}
+		GPUMemoryTypeStatistics statistics = allocator->statistics[1];
+		if (statistics.allocationsCount != 3 || statistics.allocatedBytes != 1400 || statistics.usedBytes != 1024 + 256 + 64 * 1024 || statistics.blockBytes != blockSize) {
+			printf("statistics are wrong after 3 allocations: %u allocations, %llu allocated, %llu used\n", statistics.allocationsCount, (unsigned long long)statistics.allocatedBytes, (unsigned long long)statistics.usedBytes);
+			return 1;
+		}
+		freeGPUMemory(allocator, &a);
+		freeGPUMemory(allocator, &b);
+		freeGPUMemory(allocator, &c);
+		statistics = allocator->statistics[1];
+		if (statistics.allocationsCount != 0 || statistics.allocatedBytes != 0 || statistics.usedBytes != 0) {
+			printf("statistics aren't empty after freeing everything\n");
+			return 1;
+		}
+		//with everything merged back, the whole block fits in one allocation again
+		GPUAllocation whole;
+		if (!allocateGPUMemory(allocator, 1, blockSize, 1, GPU_RESOURCE_LINEAR, &whole) || whole.offset != 0 || memory->aliveBlocksCount != 1) {
+			printf("freed buddies weren't merged back into the whole block\n");
+			return 1;
+		}
+		freeGPUMemory(allocator, &whole);
+		destroyGPUAllocator(allocator);
+		if (memory->aliveBlocksCount != 0) {
+			printf("destroying the allocator left %u blocks alive\n", memory->aliveBlocksCount);
+			return 1;
+		}
+	}
+
+	{
+		//allocations larger than a block get a dedicated one of exactly their size, which is given back once freed
+		initGPUAllocator(allocator, initMockMemory(memory, 100), 1, blockSize, 1);
+		GPUAllocation small, large;
+		allocateGPUMemory(allocator, 0, 256, 1, GPU_RESOURCE_LINEAR, &small);
+		if (!allocateGPUMemory(allocator, 0, 3 * blockSize, 1, GPU_RESOURCE_LINEAR, &large) || large.blockIndex == small.blockIndex) {
+			printf("an allocation larger than the block size didn't get its own block\n");
+			return 1;
+		}
+		if (memory->blockSizes[0][large.blockIndex] != 3 * blockSize || large.offset != 0) {
+			printf("a 3MB allocation wants a 3MB block. got %llu\n", (unsigned long long)memory->blockSizes[0][large.blockIndex]);
+			return 1;
+		}
+		freeGPUMemory(allocator, &large);
+		if (memory->aliveBlocksCount != 1) {
+			printf("the dedicated block wasn't given back\n");
+			return 1;
+		}
+		//the last block of a memory type stays, even when empty
+		freeGPUMemory(allocator, &small);
+		if (memory->aliveBlocksCount != 1) {
+			printf("the last block of the memory type was given back\n");
+			return 1;
+		}
+		destroyGPUAllocator(allocator);
+	}
+
+	{
+		//a coarse granularity keeps linear and optimal resources apart. a fine one lets them share blocks
+		u64 granularities[] = { 64 * 1024, 128 };
+		u32 wantedBlocks[] = { 2, 1 };
+		for (u32 i = 0; i < 2; i++) {
+			initGPUAllocator(allocator, initMockMemory(memory, 100), 1, blockSize, granularities[i]);
+			GPUAllocation buffer, image;
+			allocateGPUMemory(allocator, 0, 512, 1, GPU_RESOURCE_LINEAR, &buffer);
+			allocateGPUMemory(allocator, 0, 512, 1, GPU_RESOURCE_OPTIMAL, &image);
+			if (memory->aliveBlocksCount != wantedBlocks[i]) {
+				printf("with a granularity of %llu, a buffer and an image want %u blocks. got %u\n", (unsigned long long)granularities[i], wantedBlocks[i], memory->aliveBlocksCount);
+				return 1;
+			}
+			destroyGPUAllocator(allocator);
+		}
+	}
+
+	{
+		//running out of device memory fails the allocation without changing anything
+		initGPUAllocator(allocator, initMockMemory(memory, 1), 1, blockSize, 1);
+		GPUAllocation first, second;
+		allocateGPUMemory(allocator, 0, blockSize, 1, GPU_RESOURCE_LINEAR, &first);
+		if (allocateGPUMemory(allocator, 0, 256, 1, GPU_RESOURCE_LINEAR, &second)) {
+			printf("an allocation succeeded with the device out of memory\n");
+			return 1;
+		}
+		if (allocator->statistics[0].allocationsCount != 1 || allocator->statistics[0].blocksCount != 1) {
+			printf("a failed allocation changed the statistics\n");
+			return 1;
+		}
+		destroyGPUAllocator(allocator);
+	}
+
+	{
+		//random allocations and frees never overlap, and every allocation honors its alignment
+		initGPUAllocator(allocator, initMockMemory(memory, 100), 3, blockSize, 1);
+		const u32 slotsCount = 512;
+		GPUAllocation* allocations = (GPUAllocation*) calloc(slotsCount, sizeof(GPUAllocation));
+		bool32* isAllocated = (bool32*) calloc(slotsCount, sizeof(bool32));
+		for (u32 step = 0; step < 20000; step++) {
+			u32 slot = nextRandom() % slotsCount;
+			if (isAllocated[slot]) {
+				freeGPUMemory(allocator, &allocations[slot]);
+				isAllocated[slot] = 0;
+				continue;
+			}
+			u64 size = 1 + nextRandom() % (nextRandom() % 4 == 0 ? 200000 : 4000);
+			u64 alignment = 1ull << (nextRandom() % 13);
+			u32 memoryTypeIndex = nextRandom() % 3;
+			if (!allocateGPUMemory(allocator, memoryTypeIndex, size, alignment, GPU_RESOURCE_LINEAR, &allocations[slot])) {
+				printf("allocation %u of %llu bytes failed\n", step, (unsigned long long)size);
+				return 1;
+			}
+			isAllocated[slot] = 1;
+			GPUAllocation* allocation = &allocations[slot];
+			if (allocation->offset % alignment != 0 || (GPU_ALLOCATOR_MIN_ALLOCATION_SIZE << allocation->order) < size) {
+				printf("allocation %u of %llu bytes aligned to %llu got %llu bytes at %llu\n", step, (unsigned long long)size, (unsigned long long)alignment, (unsigned long long)(GPU_ALLOCATOR_MIN_ALLOCATION_SIZE << allocation->order), (unsigned long long)allocation->offset);
+				return 1;
+			}
+			if (allocation->offset + size > memory->blockSizes[memoryTypeIndex][allocation->blockIndex]) {
+				printf("allocation %u ends past its block\n", step);
+				return 1;
+			}
+			for (u32 other = 0; other < slotsCount; other++) {
+				if (other != slot && isAllocated[other] && areOverlapping(allocation, &allocations[other])) {
+					printf("allocation %u overlaps another one\n", step);
+					return 1;
+				}
+			}
+		}
+		u32 liveCount = 0;
+		for (u32 i = 0; i < slotsCount; i++) {
+			if (isAllocated[i]) {
+				liveCount += 1;
+				freeGPUMemory(allocator, &allocations[i]);
+			}
+		}
+		for (u32 type = 0; type < 3; type++) {
+			if (allocator->statistics[type].allocationsCount != 0 || allocator->statistics[type].usedBytes != 0 || allocator->statistics[type].blocksCount > 1) {
+				printf("memory type %u still has %u allocations in %u blocks after freeing all %u\n", type, allocator->statistics[type].allocationsCount, allocator->statistics[type].blocksCount, liveCount);
+				return 1;
+			}
+		}
+		destroyGPUAllocator(allocator);
+		free(allocations);
+		free(isAllocated);
+	}
+
+	free(memory);
+	free(allocator);
+	printf("Successfully completed the tests!!!\n");
+	return 0;
+}
@@ -206,6 +206,28 @@ int main() {
 		}
 	}
 
+	{
+		//rotations around each axis, half turns included, survive a round trip through a matrix
+		math::Quaternion testCases[] = {
+			math::Quaternion{1.0f, {0.0f, 0.0f, 0.0f}},
+			math::createQuaternionRotation(PI32 / 2.0f, math::Vector3{1.0f, 0.0f, 0.0f}),
+			math::createQuaternionRotation(PI32, math::Vector3{0.0f, 1.0f, 0.0f}),
+			math::createQuaternionRotation(PI32, math::Vector3{0.0f, 0.0f, 1.0f}),
+			math::createQuaternionRotation(PI32, math::Vector3{1.0f, 0.0f, 0.0f}),
+			math::createQuaternionRotation(2.5f, math::Vector3{1.0f, 2.0f, -3.0f}.normalize()),
+		};
+		for (int i = 0; i < sizeof(testCases) / sizeof(testCases[0]); i++) {
+			math::Matrix4 want = math::createRotationMatrix(testCases[i]);
+			math::Matrix4 got = math::createRotationMatrix(math::createQuaternionFromRotationMatrix(want));
+			for (int j = 0; j < 16; j++) {
+				if (!math::isWithinTolerance(got.a.m[j], want.a.m[j], 1.0f / 1024.0f)) {
+					printf("quaternion from rotation matrix failed at test case %d. element %d. want %f, got %f\n", i, j, want.a.m[j], got.a.m[j]);
+					return 1;
+				}
+			}
+		}
+	}
+
 	printf("Successfully completed the tests!!!\n");
 
 	return 0;
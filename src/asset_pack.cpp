@@ -0,0 +1,120 @@
+#include "asset_pack.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static bool32 isAssetPackTextureValid(AssetPack* pack, AssetPackTexture* texture) {
+	if (memchr(texture->name, 0, ASSET_PACK_NAME_LENGTH) == nil) {
+		return 0;
+	}
+	if (texture->format != TEXTURE_FORMAT_RGBA8_SRGB && texture->format != TEXTURE_FORMAT_BC1_SRGB) {
+		return 0;
+	}
+	if (texture->width == 0 || texture->height == 0 || texture->mipLevelsCount == 0 || texture->mipLevelsCount > ASSET_PACK_MAX_MIP_LEVELS) {
+		return 0;
+	}
+	if (texture->mipLevelsCount > calculateMipLevelsCount(texture->width, texture->height)) {
+		return 0;
+	}
+	if (texture->dataSize != calculateTextureChainSize(texture->format, texture->width, texture->height, texture->mipLevelsCount)) {
+		return 0;
+	}
+	return texture->dataOffset <= pack->file.size && texture->dataSize <= pack->file.size - texture->dataOffset;
+}
+
+bool32 openAssetPack(const char* filepath, AssetPack* pack) {
+	*pack = {};
+	if (!mapFile(filepath, &pack->file)) {
+		return 0;
+	}
+	AssetPackHeader* header = (AssetPackHeader*)pack->file.data;
+	if (pack->file.size < sizeof(AssetPackHeader) || header->magic != ASSET_PACK_MAGIC || header->version != ASSET_PACK_VERSION) {
+		printf("%s is not a version %u asset pack\n", filepath, ASSET_PACK_VERSION);
+		closeAssetPack(pack);
+		return 0;
+	}
+	u64 tableSize = (u64)header->texturesCount * sizeof(AssetPackTexture);
+	if (header->fileSize != pack->file.size || header->texturesOffset > pack->file.size || tableSize > pack->file.size - header->texturesOffset) {
+		printf("asset pack %s is truncated\n", filepath);
+		closeAssetPack(pack);
+		return 0;
+	}
+	pack->header = header;
+	pack->textures = (AssetPackTexture*)(pack->file.data + header->texturesOffset);
+	for (u32 i = 0; i < header->texturesCount; i++) {
+		if (!isAssetPackTextureValid(pack, &pack->textures[i])) {
+			printf("texture %u of asset pack %s is invalid\n", i, filepath);
+			closeAssetPack(pack);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+void closeAssetPack(AssetPack* pack) {
+	unmapFile(&pack->file);
+	*pack = {};
+}
+
+AssetPackTexture* findAssetPackTexture(AssetPack* pack, const char* name) {
+	for (u32 i = 0; i < pack->header->texturesCount; i++) {
+		if (strcmp(pack->textures[i].name, name) == 0) {
+			return &pack->textures[i];
+		}
+	}
+	return nil;
+}
+
+u8* getAssetPackTextureData(AssetPack* pack, AssetPackTexture* texture) {
+	return pack->file.data + texture->dataOffset;
+}
+
+bool32 isAssetPackTextureStale(AssetPackTexture* texture, const char* sourceFilepath) {
+	u64 size;
+	u64 modificationTime;
+	if (!getFileInfo(sourceFilepath, &size, &modificationTime)) {
+		return 0;
+	}
+	return size != texture->sourceSize || modificationTime != texture->sourceModificationTime;
+}
+
+static u64 alignAssetPackOffset(u64 offset) {
+	return (offset + ASSET_PACK_DATA_ALIGNMENT - 1) / ASSET_PACK_DATA_ALIGNMENT * ASSET_PACK_DATA_ALIGNMENT;
+}
+
+bool32 writeAssetPack(const char* filepath, AssetPackTexture* textures, u8** texturesData, u32 texturesCount) {
+	AssetPackHeader header = {};
+	header.magic = ASSET_PACK_MAGIC;
+	header.version = ASSET_PACK_VERSION;
+	header.texturesCount = texturesCount;
+	header.texturesOffset = sizeof(AssetPackHeader);
+	u64 offset = header.texturesOffset + (u64)texturesCount * sizeof(AssetPackTexture);
+	for (u32 i = 0; i < texturesCount; i++) {
+		offset = alignAssetPackOffset(offset);
+		textures[i].dataOffset = offset;
+		offset += textures[i].dataSize;
+	}
+	header.fileSize = offset;
+
+	FILE* file = fopen(filepath, "wb");
+	if (file == nil) {
+		printf("failed to open %s for writing\n", filepath);
+		return 0;
+	}
+	bool32 isWritten = fwrite(&header, sizeof(header), 1, file) == 1;
+	isWritten = isWritten && (texturesCount == 0 || fwrite(textures, sizeof(AssetPackTexture), texturesCount, file) == texturesCount);
+	u64 writtenOffset = header.texturesOffset + (u64)texturesCount * sizeof(AssetPackTexture);
+	const u8 padding[ASSET_PACK_DATA_ALIGNMENT] = {};
+	for (u32 i = 0; i < texturesCount && isWritten; i++) {
+		u64 paddingSize = textures[i].dataOffset - writtenOffset;
+		isWritten = paddingSize == 0 || fwrite(padding, 1, paddingSize, file) == paddingSize;
+		isWritten = isWritten && fwrite(texturesData[i], 1, textures[i].dataSize, file) == textures[i].dataSize;
+		writtenOffset = textures[i].dataOffset + textures[i].dataSize;
+	}
+	isWritten = fclose(file) == 0 && isWritten;
+	if (!isWritten) {
+		printf("failed to write asset pack %s\n", filepath);
+		remove(filepath);
+	}
+	return isWritten;
+}
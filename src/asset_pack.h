@@ -0,0 +1,63 @@
+#pragma once
+#ifndef VOXELS_GAME_ASSET_PACK_H
+#define VOXELS_GAME_ASSET_PACK_H
+
+#include "common.h"
+#include "platform.h"
+#include "texture.h"
+
+/*
+	asset packs are baked by asset-baker and mapped read only by the game.
+	layout: AssetPackHeader, then the table of contents, then every texture's mip chain, base level first.
+	all offsets are from the start of the file, and every texture's data starts on ASSET_PACK_DATA_ALIGNMENT
+*/
+
+const u32 ASSET_PACK_MAGIC = 'V' | ('X' << 8) | ('A' << 16) | ('P' << 24);
+//2 added the sources' sizes and modification times
+const u32 ASSET_PACK_VERSION = 2;
+const u32 ASSET_PACK_NAME_LENGTH = 56;
+const u32 ASSET_PACK_DATA_ALIGNMENT = 256;
+const u32 ASSET_PACK_MAX_MIP_LEVELS = 16;
+
+struct AssetPackHeader {
+	u32 magic;
+	u32 version;
+	u32 texturesCount;
+	u32 reserved;
+	u64 texturesOffset;
+	u64 fileSize;
+};
+
+struct AssetPackTexture {
+	//the source file's name without its directory and extension, null terminated
+	char name[ASSET_PACK_NAME_LENGTH];
+	TextureFormat format;
+	u32 width;
+	u32 height;
+	u32 mipLevelsCount;
+	u64 dataOffset;
+	u64 dataSize;
+	//of the file the texture was baked from, to tell when the pack is out of date
+	u64 sourceSize;
+	u64 sourceModificationTime;
+};
+
+struct AssetPack {
+	MappedFile file;
+	AssetPackHeader* header;
+	AssetPackTexture* textures;
+};
+
+//maps the pack and checks its table of contents against the file. returns 0 if it's missing or invalid
+bool32 openAssetPack(const char* filepath, AssetPack* pack);
+void closeAssetPack(AssetPack* pack);
+//returns nil if the pack has no texture with that name
+AssetPackTexture* findAssetPackTexture(AssetPack* pack, const char* name);
+u8* getAssetPackTextureData(AssetPack* pack, AssetPackTexture* texture);
+//whether the file the texture was baked from has changed since. a source that doesn't exist anymore leaves the pack as the only copy,
+//so it isn't stale
+bool32 isAssetPackTextureStale(AssetPackTexture* texture, const char* sourceFilepath);
+//writes the header, the table of contents and the data of every texture. fills in each texture's dataOffset. returns 0 on failure
+bool32 writeAssetPack(const char* filepath, AssetPackTexture* textures, u8** texturesData, u32 texturesCount);
+
+#endif
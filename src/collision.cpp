@@ -45,3 +45,81 @@ bool32 isRayIntersectingOBB(math::Vector3 rayOrigin, math::Vector3 rayDirection,
 	return 0;
 }
 
+Frustum extractFrustum(math::Matrix4 viewProjection) {
+	math::Matrix4 m = viewProjection;
+	math::Vector4 row0 = { m.e.m00, m.e.m01, m.e.m02, m.e.m03 };
+	math::Vector4 row1 = { m.e.m10, m.e.m11, m.e.m12, m.e.m13 };
+	math::Vector4 row2 = { m.e.m20, m.e.m21, m.e.m22, m.e.m23 };
+	math::Vector4 row3 = { m.e.m30, m.e.m31, m.e.m32, m.e.m33 };
+
+	//the near plane uses the -w <= z clip range, which is also conservative for a 0 to w depth range
+	Frustum f = {};
+	f.planes[0] = math::Vector4{ row3.x + row0.x, row3.y + row0.y, row3.z + row0.z, row3.w + row0.w };
+	f.planes[1] = math::Vector4{ row3.x - row0.x, row3.y - row0.y, row3.z - row0.z, row3.w - row0.w };
+	f.planes[2] = math::Vector4{ row3.x + row1.x, row3.y + row1.y, row3.z + row1.z, row3.w + row1.w };
+	f.planes[3] = math::Vector4{ row3.x - row1.x, row3.y - row1.y, row3.z - row1.z, row3.w - row1.w };
+	f.planes[4] = math::Vector4{ row3.x + row2.x, row3.y + row2.y, row3.z + row2.z, row3.w + row2.w };
+	f.planes[5] = math::Vector4{ row3.x - row2.x, row3.y - row2.y, row3.z - row2.z, row3.w - row2.w };
+	return f;
+}
+
+Frustum extractScreenRectFrustum(math::Matrix4 viewProjection, f32 minX, f32 minY, f32 maxX, f32 maxY) {
+	math::Matrix4 m = viewProjection;
+	math::Vector4 row0 = { m.e.m00, m.e.m01, m.e.m02, m.e.m03 };
+	math::Vector4 row1 = { m.e.m10, m.e.m11, m.e.m12, m.e.m13 };
+	math::Vector4 row3 = { m.e.m30, m.e.m31, m.e.m32, m.e.m33 };
+
+	//x >= minX * w, x <= maxX * w, and the same for y. near and far are the full frustum's
+	Frustum f = extractFrustum(viewProjection);
+	f.planes[0] = math::Vector4{ row0.x - minX * row3.x, row0.y - minX * row3.y, row0.z - minX * row3.z, row0.w - minX * row3.w };
+	f.planes[1] = math::Vector4{ maxX * row3.x - row0.x, maxX * row3.y - row0.y, maxX * row3.z - row0.z, maxX * row3.w - row0.w };
+	f.planes[2] = math::Vector4{ row1.x - minY * row3.x, row1.y - minY * row3.y, row1.z - minY * row3.z, row1.w - minY * row3.w };
+	f.planes[3] = math::Vector4{ maxY * row3.x - row1.x, maxY * row3.y - row1.y, maxY * row3.z - row1.z, maxY * row3.w - row1.w };
+	return f;
+}
+
+bool32 isAABBIntersectingFrustum(Frustum* frustum, AABB a) {
+	for (i32 i = 0; i < 6; i++) {
+		math::Vector4 plane = frustum->planes[i];
+		//the corner furthest along the plane's normal. if even that one is behind the plane, the whole box is
+		math::Vector3 positiveCorner = {
+			plane.x >= 0.0f ? a.max.x : a.min.x,
+			plane.y >= 0.0f ? a.max.y : a.min.y,
+			plane.z >= 0.0f ? a.max.z : a.min.z,
+		};
+		if (plane.x * positiveCorner.x + plane.y * positiveCorner.y + plane.z * positiveCorner.z + plane.w < 0.0f) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+bool32 isAABBInsideFrustum(Frustum* frustum, AABB a) {
+	for (i32 i = 0; i < 6; i++) {
+		math::Vector4 plane = frustum->planes[i];
+		//the corner furthest against the plane's normal. if even that one is in front of the plane, the whole box is
+		math::Vector3 negativeCorner = {
+			plane.x >= 0.0f ? a.min.x : a.max.x,
+			plane.y >= 0.0f ? a.min.y : a.max.y,
+			plane.z >= 0.0f ? a.min.z : a.max.z,
+		};
+		if (plane.x * negativeCorner.x + plane.y * negativeCorner.y + plane.z * negativeCorner.z + plane.w < 0.0f) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+AABB calculateTransformedUnitCubeBounds(math::Matrix4 model) {
+	math::Matrix4 m = model;
+	math::Vector3 center = { m.e.m03, m.e.m13, m.e.m23 };
+	math::Vector3 halfExtents = {
+		0.5f * (fabsf(m.e.m00) + fabsf(m.e.m01) + fabsf(m.e.m02)),
+		0.5f * (fabsf(m.e.m10) + fabsf(m.e.m11) + fabsf(m.e.m12)),
+		0.5f * (fabsf(m.e.m20) + fabsf(m.e.m21) + fabsf(m.e.m22)),
+	};
+	AABB a = {};
+	a.min = center.sub(halfExtents);
+	a.max = center.add(halfExtents);
+	return a;
+}
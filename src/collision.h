@@ -23,7 +23,21 @@ struct Ray {
 	math::Vector3 origin;
 };
 
+//planes are (normal, distance) with normals pointing into the frustum. a point p is inside a plane when dot(normal, p) + distance >= 0
+struct Frustum {
+	math::Vector4 planes[6];
+};
+
 bool32 isRayIntersectingAABB(math::Vector3 rayOrigin, math::Vector3 rayDirection, AABB a, f32 tmax, f32* tmin, math::Vector3 *q);
 bool32 isRayIntersectingOBB(math::Vector3 rayOrigin, math::Vector3 rayDirection, OBB o, f32 tmax, f32* tmin, math::Vector3 *q);
 
+Frustum extractFrustum(math::Matrix4 viewProjection);
+//the part of the frustum that projects into the rectangle [minX, maxX] x [minY, maxY] of normalized device coordinates
+Frustum extractScreenRectFrustum(math::Matrix4 viewProjection, f32 minX, f32 minY, f32 maxX, f32 maxY);
+//conservative. may report an aabb near a corner of the frustum as intersecting when it isn't
+bool32 isAABBIntersectingFrustum(Frustum* frustum, AABB a);
+bool32 isAABBInsideFrustum(Frustum* frustum, AABB a);
+//bounds of the unit cube centered at the origin after being transformed by the model matrix
+AABB calculateTransformedUnitCubeBounds(math::Matrix4 model);
+
 #endif
@@ -0,0 +1,523 @@
+#include "edit_journal.h"
+#include "platform.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*
+	an edit's record: EditRecordHeader, the recorded spans, the group changes, the groups it added as they were at its end,
+	then the old values of the spans, their new values and the added voxels. values are encoded in pieces of at most a chunk,
+	each one its u32 size followed by its payload
+*/
+struct EditRecordHeader {
+	u32 coalesceKey;
+	u32 spansCount;
+	u32 groupChangesCount;
+	i32 voxelsCountBefore;
+	i32 voxelsCountAfter;
+	i32 groupsCountBefore;
+	i32 groupsCountAfter;
+	u32 padding;
+	u64 oldValuesSize;
+	u64 newValuesSize;
+	u64 addedVoxelsSize;
+};
+
+//records are kept 8 byte aligned in the log
+const u64 EDIT_RECORD_ALIGNMENT = 8;
+
+static void reserveJournalBytes(u8** data, u64* capacity, u64 size) {
+	if (size <= *capacity) {
+		return;
+	}
+	*capacity = MAX(size, 2 * *capacity);
+	*data = (u8*) realloc(*data, *capacity);
+	_assert(*data != nil);
+}
+
+static void encodeVoxelPieces(EditJournal* journal, VoxelArray* voxelArray, VoxelSpan span, u8** data, u64* size, u64* capacity) {
+	for (i32 begin = span.begin; begin < span.end; begin += VOXELS_PER_CHUNK) {
+		VoxelSpan piece = { begin, MIN(begin + VOXELS_PER_CHUNK, span.end) };
+		u32 pieceSize = (u32)encodeWorldChunk(voxelArray, piece, journal->chunkBuffer);
+		reserveJournalBytes(data, capacity, *size + sizeof(u32) + pieceSize);
+		memcpy(*data + *size, &pieceSize, sizeof(u32));
+		memcpy(*data + *size + sizeof(u32), journal->chunkBuffer, pieceSize);
+		*size += sizeof(u32) + pieceSize;
+	}
+}
+
+//returns the size of the span's pieces, or 0 if they are corrupt
+static u64 decodeVoxelPieces(const u8* data, u64 size, VoxelArray* voxelArray, VoxelSpan span) {
+	u64 offset = 0;
+	for (i32 begin = span.begin; begin < span.end; begin += VOXELS_PER_CHUNK) {
+		VoxelSpan piece = { begin, MIN(begin + VOXELS_PER_CHUNK, span.end) };
+		u32 pieceSize;
+		if (size - offset < sizeof(u32)) {
+			return 0;
+		}
+		memcpy(&pieceSize, data + offset, sizeof(u32));
+		offset += sizeof(u32);
+		if (pieceSize > size - offset || !decodeWorldChunk(data + offset, pieceSize, voxelArray, piece)) {
+			return 0;
+		}
+		offset += pieceSize;
+	}
+	return offset;
+}
+
+void initEditJournal(EditJournal* journal, MemoryAllocator* memoryAllocator, u64 memoryBudget, const char* spillFilepath) {
+	*journal = {};
+	_assert(strlen(spillFilepath) < WORLD_FILE_PATH_LENGTH);
+	strcpy(journal->spillFilepath, spillFilepath);
+	journal->memoryBudget = memoryBudget;
+	journal->memory = (u8*) allocateMemory(memoryAllocator, memoryBudget);
+	journal->chunkBuffer = (u8*) allocateMemory(memoryAllocator, calculateWorldChunkMaxEncodedSize(VOXELS_PER_CHUNK));
+}
+
+void destroyEditJournal(EditJournal* journal) {
+	if (journal->spillFile != nil) {
+		fclose(journal->spillFile);
+		remove(journal->spillFilepath);
+		journal->spillFile = nil;
+	}
+	free(journal->spans);
+	free(journal->groupChanges);
+	free(journal->oldValues);
+	journal->spans = nil;
+	journal->groupChanges = nil;
+	journal->oldValues = nil;
+	journal->spansCapacity = 0;
+	journal->groupChangesCapacity = 0;
+	journal->oldValuesCapacity = 0;
+}
+
+void beginEdit(EditJournal* journal, VoxelArray* voxelArray, u32 coalesceKey) {
+	_assert(!journal->isEditing);
+	journal->isEditing = 1;
+	journal->coalesceKey = coalesceKey;
+	journal->voxelsCountBefore = voxelArray->voxelsCount;
+	journal->groupsCountBefore = voxelArray->groupsCount;
+	journal->spansCount = 0;
+	journal->groupChangesCount = 0;
+	journal->oldValuesSize = 0;
+}
+
+void recordVoxelSpanEdit(EditJournal* journal, VoxelArray* voxelArray, VoxelSpan span) {
+	_assert(journal->isEditing);
+	span.end = MIN(span.end, journal->voxelsCountBefore);
+	if (span.begin >= span.end) {
+		return;
+	}
+	if (journal->spansCount == journal->spansCapacity) {
+		journal->spansCapacity = MAX(16u, 2 * journal->spansCapacity);
+		journal->spans = (VoxelSpan*) realloc(journal->spans, journal->spansCapacity * sizeof(VoxelSpan));
+		_assert(journal->spans != nil);
+	}
+	journal->spans[journal->spansCount] = span;
+	journal->spansCount += 1;
+	encodeVoxelPieces(journal, voxelArray, span, &journal->oldValues, &journal->oldValuesSize, &journal->oldValuesCapacity);
+}
+
+void recordVoxelGroupEdit(EditJournal* journal, VoxelArray* voxelArray, i32 groupIndex) {
+	_assert(journal->isEditing);
+	if (groupIndex < 0 || groupIndex >= journal->groupsCountBefore) {
+		return;
+	}
+	for (u32 i = 0; i < journal->groupChangesCount; i++) {
+		if (journal->groupChanges[i].groupIndex == groupIndex) {
+			return;
+		}
+	}
+	if (journal->groupChangesCount == journal->groupChangesCapacity) {
+		journal->groupChangesCapacity = MAX(16u, 2 * journal->groupChangesCapacity);
+		journal->groupChanges = (EditJournalGroupChange*) realloc(journal->groupChanges, journal->groupChangesCapacity * sizeof(EditJournalGroupChange));
+		_assert(journal->groupChanges != nil);
+	}
+	EditJournalGroupChange* change = &journal->groupChanges[journal->groupChangesCount];
+	change->groupIndex = groupIndex;
+	change->before = voxelArray->groups[groupIndex];
+	journal->groupChangesCount += 1;
+}
+
+static bool32 isVoxelGroupUnchanged(VoxelGroup a, VoxelGroup b) {
+	return
+		a.position.x == b.position.x && a.position.y == b.position.y && a.position.z == b.position.z &&
+		a.rotation.real == b.rotation.real && a.rotation.vector.x == b.rotation.vector.x && a.rotation.vector.y == b.rotation.vector.y &&
+		a.rotation.vector.z == b.rotation.vector.z &&
+		a.voxelsCount == b.voxelsCount && a.voxelsBegin == b.voxelsBegin && a.voxelsEnd == b.voxelsEnd;
+}
+
+static bool32 openEditJournalSpillFile(EditJournal* journal) {
+	if (journal->spillFile == nil) {
+		journal->spillFile = fopen(journal->spillFilepath, "w+b");
+		if (journal->spillFile == nil) {
+			printf("unable to open %s for spilling undo history\n", journal->spillFilepath);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+//drops the oldest edits. an edit that's undone can't be redone without the ones before it, so dropping one drops every edit
+static void dropOldestEdits(EditJournal* journal, u32 count) {
+	if (count > journal->appliedEditsCount) {
+		count = journal->editsCount;
+	}
+	u64 droppedMemory = 0;
+	for (u32 i = 0; i < count; i++) {
+		if (!journal->entries[i].isSpilled) {
+			droppedMemory += journal->entries[i].size;
+		}
+	}
+	memmove(journal->memory, journal->memory + droppedMemory, journal->memoryUsed - droppedMemory);
+	journal->memoryUsed -= droppedMemory;
+	memmove(journal->entries, journal->entries + count, (journal->editsCount - count) * sizeof(EditJournalEntry));
+	journal->editsCount -= count;
+	journal->appliedEditsCount -= MIN(count, journal->appliedEditsCount);
+	bool32 hasSpilledEdits = 0;
+	for (u32 i = 0; i < journal->editsCount; i++) {
+		if (journal->entries[i].isSpilled) {
+			hasSpilledEdits = 1;
+		} else {
+			journal->entries[i].offset -= droppedMemory;
+		}
+	}
+	//the file is written from its start again once nothing in it is needed
+	if (!hasSpilledEdits) {
+		journal->spilledBytes = 0;
+	}
+}
+
+//moves the oldest edits that are in memory to the spill file until at most keptBytes of the log are used
+static void spillOldestEdits(EditJournal* journal, u64 keptBytes) {
+	u32 first = 0;
+	while (first < journal->editsCount && journal->entries[first].isSpilled) {
+		first += 1;
+	}
+	u32 end = first;
+	u64 spilledMemory = 0;
+	while (end < journal->editsCount && journal->memoryUsed - spilledMemory > keptBytes) {
+		spilledMemory += journal->entries[end].size;
+		end += 1;
+	}
+	if (end == first) {
+		return;
+	}
+	bool32 isWritten = openEditJournalSpillFile(journal) && seekFile(journal->spillFile, journal->spilledBytes);
+	isWritten = isWritten && fwrite(journal->memory, 1, spilledMemory, journal->spillFile) == spilledMemory;
+	if (!isWritten) {
+		printf("unable to spill undo history to %s. the oldest edits are dropped instead\n", journal->spillFilepath);
+		dropOldestEdits(journal, end);
+		return;
+	}
+	for (u32 i = first; i < end; i++) {
+		journal->entries[i].offset += journal->spilledBytes;
+		journal->entries[i].isSpilled = 1;
+	}
+	journal->spilledBytes += spilledMemory;
+	memmove(journal->memory, journal->memory + spilledMemory, journal->memoryUsed - spilledMemory);
+	journal->memoryUsed -= spilledMemory;
+	for (u32 i = end; i < journal->editsCount; i++) {
+		journal->entries[i].offset -= spilledMemory;
+	}
+}
+
+static void storeEditRecord(EditJournal* journal, const u8* record, u64 size) {
+	if (journal->editsCount == MAX_JOURNAL_EDITS) {
+		dropOldestEdits(journal, 1);
+	}
+	u64 alignedSize = (size + EDIT_RECORD_ALIGNMENT - 1) & ~(EDIT_RECORD_ALIGNMENT - 1);
+	if (alignedSize > journal->memoryBudget) {
+		//too big for the log, so it goes straight to the file, after every edit that's older
+		spillOldestEdits(journal, 0);
+		const u8 padding[EDIT_RECORD_ALIGNMENT] = {};
+		bool32 isWritten = openEditJournalSpillFile(journal) && seekFile(journal->spillFile, journal->spilledBytes);
+		isWritten = isWritten && fwrite(record, 1, size, journal->spillFile) == size;
+		isWritten = isWritten && fwrite(padding, 1, alignedSize - size, journal->spillFile) == alignedSize - size;
+		if (!isWritten) {
+			printf("unable to spill an edit to %s. it can't be undone\n", journal->spillFilepath);
+			return;
+		}
+		EditJournalEntry* entry = &journal->entries[journal->editsCount];
+		entry->offset = journal->spilledBytes;
+		entry->size = alignedSize;
+		entry->isSpilled = 1;
+		journal->spilledBytes += alignedSize;
+	} else {
+		//spills down to half the log, so a run of edits doesn't spill on every one of them
+		if (journal->memoryUsed + alignedSize > journal->memoryBudget) {
+			spillOldestEdits(journal, MIN(journal->memoryBudget / 2, journal->memoryBudget - alignedSize));
+		}
+		EditJournalEntry* entry = &journal->entries[journal->editsCount];
+		entry->offset = journal->memoryUsed;
+		entry->size = alignedSize;
+		entry->isSpilled = 0;
+		memcpy(journal->memory + journal->memoryUsed, record, size);
+		memset(journal->memory + journal->memoryUsed + size, 0, alignedSize - size);
+		journal->memoryUsed += alignedSize;
+	}
+	journal->editsCount += 1;
+	journal->appliedEditsCount = journal->editsCount;
+}
+
+//the last edit absorbs this one if both only moved the same groups
+static bool32 coalesceEdit(EditJournal* journal, VoxelArray* voxelArray) {
+	if (
+		journal->coalesceKey == 0 || journal->editsCount == 0 || journal->appliedEditsCount != journal->editsCount ||
+		journal->entries[journal->editsCount - 1].isSpilled || journal->spansCount > 0 ||
+		voxelArray->voxelsCount != journal->voxelsCountBefore || voxelArray->groupsCount != journal->groupsCountBefore
+	) {
+		return 0;
+	}
+	u8* record = journal->memory + journal->entries[journal->editsCount - 1].offset;
+	EditRecordHeader* header = (EditRecordHeader*)record;
+	if (
+		header->coalesceKey != journal->coalesceKey || header->spansCount > 0 || header->groupChangesCount != journal->groupChangesCount ||
+		header->voxelsCountBefore != header->voxelsCountAfter || header->groupsCountBefore != header->groupsCountAfter
+	) {
+		return 0;
+	}
+	EditJournalGroupChange* changes = (EditJournalGroupChange*)(record + sizeof(EditRecordHeader));
+	for (u32 i = 0; i < journal->groupChangesCount; i++) {
+		if (changes[i].groupIndex != journal->groupChanges[i].groupIndex) {
+			return 0;
+		}
+	}
+	for (u32 i = 0; i < journal->groupChangesCount; i++) {
+		changes[i].after = journal->groupChanges[i].after;
+	}
+	return 1;
+}
+
+//discards the edits that were undone, since they can't be redone after a new edit
+static void discardUndoneEdits(EditJournal* journal) {
+	for (u32 i = journal->appliedEditsCount; i < journal->editsCount; i++) {
+		if (journal->entries[i].isSpilled) {
+			journal->spilledBytes = MIN(journal->spilledBytes, journal->entries[i].offset);
+		} else {
+			journal->memoryUsed = MIN(journal->memoryUsed, journal->entries[i].offset);
+		}
+	}
+	journal->editsCount = journal->appliedEditsCount;
+}
+
+void endEdit(EditJournal* journal, VoxelArray* voxelArray) {
+	_assert(journal->isEditing);
+	journal->isEditing = 0;
+	u32 changesCount = 0;
+	for (u32 i = 0; i < journal->groupChangesCount; i++) {
+		EditJournalGroupChange change = journal->groupChanges[i];
+		change.after = voxelArray->groups[change.groupIndex];
+		if (!isVoxelGroupUnchanged(change.before, change.after)) {
+			journal->groupChanges[changesCount] = change;
+			changesCount += 1;
+		}
+	}
+	journal->groupChangesCount = changesCount;
+	//voxels and groups can only be added during an edit
+	_assert(voxelArray->voxelsCount >= journal->voxelsCountBefore && voxelArray->groupsCount >= journal->groupsCountBefore);
+	if (
+		journal->spansCount == 0 && journal->groupChangesCount == 0 &&
+		voxelArray->voxelsCount == journal->voxelsCountBefore && voxelArray->groupsCount == journal->groupsCountBefore
+	) {
+		return;
+	}
+	if (coalesceEdit(journal, voxelArray)) {
+		return;
+	}
+	discardUndoneEdits(journal);
+
+	EditRecordHeader header = {};
+	header.coalesceKey = journal->coalesceKey;
+	header.spansCount = journal->spansCount;
+	header.groupChangesCount = journal->groupChangesCount;
+	header.voxelsCountBefore = journal->voxelsCountBefore;
+	header.voxelsCountAfter = voxelArray->voxelsCount;
+	header.groupsCountBefore = journal->groupsCountBefore;
+	header.groupsCountAfter = voxelArray->groupsCount;
+	header.oldValuesSize = journal->oldValuesSize;
+	u64 addedGroupsSize = (u64)(header.groupsCountAfter - header.groupsCountBefore) * sizeof(VoxelGroup);
+	u64 tablesSize = sizeof(EditRecordHeader) + header.spansCount * sizeof(VoxelSpan) + header.groupChangesCount * sizeof(EditJournalGroupChange) + addedGroupsSize;
+
+	//the record is built after the tables, once the size of the values is known
+	u8* record = nil;
+	u64 capacity = 0;
+	u64 size = tablesSize;
+	reserveJournalBytes(&record, &capacity, size + journal->oldValuesSize);
+	if (journal->oldValuesSize > 0) {
+		memcpy(record + size, journal->oldValues, journal->oldValuesSize);
+		size += journal->oldValuesSize;
+	}
+	for (u32 i = 0; i < journal->spansCount; i++) {
+		encodeVoxelPieces(journal, voxelArray, journal->spans[i], &record, &size, &capacity);
+	}
+	header.newValuesSize = size - tablesSize - header.oldValuesSize;
+	encodeVoxelPieces(journal, voxelArray, VoxelSpan{ header.voxelsCountBefore, header.voxelsCountAfter }, &record, &size, &capacity);
+	header.addedVoxelsSize = size - tablesSize - header.oldValuesSize - header.newValuesSize;
+
+	u8* at = record;
+	memcpy(at, &header, sizeof(EditRecordHeader));
+	at += sizeof(EditRecordHeader);
+	if (header.spansCount > 0) {
+		memcpy(at, journal->spans, header.spansCount * sizeof(VoxelSpan));
+		at += header.spansCount * sizeof(VoxelSpan);
+	}
+	if (header.groupChangesCount > 0) {
+		memcpy(at, journal->groupChanges, header.groupChangesCount * sizeof(EditJournalGroupChange));
+		at += header.groupChangesCount * sizeof(EditJournalGroupChange);
+	}
+	memcpy(at, &voxelArray->groups[header.groupsCountBefore], addedGroupsSize);
+
+	storeEditRecord(journal, record, size);
+	free(record);
+}
+
+//returns the record, either in the log or read back into memory that the caller frees
+static u8* readEditRecord(EditJournal* journal, u32 editIndex, bool32* isAllocated) {
+	EditJournalEntry* entry = &journal->entries[editIndex];
+	*isAllocated = entry->isSpilled;
+	if (!entry->isSpilled) {
+		return journal->memory + entry->offset;
+	}
+	u8* record = (u8*) malloc(entry->size);
+	_assert(record != nil);
+	if (!seekFile(journal->spillFile, entry->offset) || fread(record, 1, entry->size, journal->spillFile) != entry->size) {
+		printf("unable to read an edit back from %s\n", journal->spillFilepath);
+		free(record);
+		return nil;
+	}
+	return record;
+}
+
+static void loadEditedWorldChunks(World* world, VoxelArray* voxelArray, VoxelSpan span) {
+	span.end = MIN(span.end, voxelArray->voxelsCount);
+	if (world == nil || span.begin >= span.end) {
+		return;
+	}
+	for (i32 c = span.begin / VOXELS_PER_CHUNK; c <= (span.end - 1) / VOXELS_PER_CHUNK; c++) {
+		if ((u32)c < world->header.chunksCount) {
+			loadWorldChunk(world, c);
+		}
+	}
+}
+
+static void setVoxelGroup(VoxelArray* voxelArray, i32 groupIndex, VoxelGroup value) {
+	VoxelGroup* group = &voxelArray->groups[groupIndex];
+	bool32 isDirty = group->isDirty;
+	*group = value;
+	group->isDirty = isDirty;
+	markVoxelGroupDirty(voxelArray, groupIndex);
+}
+
+static bool32 applyEditRecord(u8* record, VoxelArray* voxelArray, World* world, bool32 isUndoing) {
+	EditRecordHeader* header = (EditRecordHeader*)record;
+	u8* at = record + sizeof(EditRecordHeader);
+	VoxelSpan* spans = (VoxelSpan*)at;
+	at += header->spansCount * sizeof(VoxelSpan);
+	EditJournalGroupChange* changes = (EditJournalGroupChange*)at;
+	at += header->groupChangesCount * sizeof(EditJournalGroupChange);
+	VoxelGroup* addedGroups = (VoxelGroup*)at;
+	at += (u64)(header->groupsCountAfter - header->groupsCountBefore) * sizeof(VoxelGroup);
+	u8* oldValues = at;
+	u8* newValues = oldValues + header->oldValuesSize;
+	u8* addedVoxels = newValues + header->newValuesSize;
+	VoxelSpan addedSpan = { header->voxelsCountBefore, header->voxelsCountAfter };
+
+	for (u32 i = 0; i < header->spansCount; i++) {
+		loadEditedWorldChunks(world, voxelArray, spans[i]);
+	}
+	loadEditedWorldChunks(world, voxelArray, addedSpan);
+
+	bool32 isApplied = 1;
+	if (isUndoing) {
+		//spans are restored last to first, so a voxel recorded twice ends up with its oldest value
+		u64* offsets = (u64*) malloc((header->spansCount + 1) * sizeof(u64));
+		offsets[0] = 0;
+		//the sizes of the pieces give where every span's values start
+		for (u32 i = 0; i < header->spansCount; i++) {
+			u64 size = 0;
+			u64 offset = offsets[i];
+			for (i32 begin = spans[i].begin; begin < spans[i].end; begin += VOXELS_PER_CHUNK) {
+				u32 pieceSize;
+				memcpy(&pieceSize, oldValues + offset + size, sizeof(u32));
+				size += sizeof(u32) + pieceSize;
+			}
+			offsets[i + 1] = offset + size;
+		}
+		for (u32 i = header->spansCount; i > 0 && isApplied; i--) {
+			prepareVoxelSpanWrite(voxelArray, spans[i - 1]);
+			isApplied = decodeVoxelPieces(oldValues + offsets[i - 1], offsets[i] - offsets[i - 1], voxelArray, spans[i - 1]) > 0;
+			markVoxelSpanDirty(voxelArray, spans[i - 1]);
+		}
+		free(offsets);
+		for (u32 i = 0; i < header->groupChangesCount; i++) {
+			setVoxelGroup(voxelArray, changes[i].groupIndex, changes[i].before);
+		}
+		//added voxels are dropped. their chunks are written again by the next save, and a snapshot that shares them keeps its copy
+		prepareVoxelSpanWrite(voxelArray, addedSpan);
+		markVoxelSpanDirty(voxelArray, addedSpan);
+		voxelArray->voxelsCount = header->voxelsCountBefore;
+		voxelArray->groupsCount = header->groupsCountBefore;
+	} else {
+		voxelArray->groupsCount = header->groupsCountAfter;
+		for (i32 i = header->groupsCountBefore; i < header->groupsCountAfter; i++) {
+			voxelArray->groups[i] = addedGroups[i - header->groupsCountBefore];
+			voxelArray->groups[i].isDirty = 0;
+		}
+		voxelArray->voxelsCount = header->voxelsCountAfter;
+		prepareVoxelSpanWrite(voxelArray, addedSpan);
+		isApplied = addedSpan.begin == addedSpan.end || decodeVoxelPieces(addedVoxels, header->addedVoxelsSize, voxelArray, addedSpan) > 0;
+		markVoxelSpanDirty(voxelArray, addedSpan);
+		u64 offset = 0;
+		for (u32 i = 0; i < header->spansCount && isApplied; i++) {
+			prepareVoxelSpanWrite(voxelArray, spans[i]);
+			u64 size = decodeVoxelPieces(newValues + offset, header->newValuesSize - offset, voxelArray, spans[i]);
+			isApplied = size > 0;
+			offset += size;
+			markVoxelSpanDirty(voxelArray, spans[i]);
+		}
+		for (u32 i = 0; i < header->groupChangesCount; i++) {
+			setVoxelGroup(voxelArray, changes[i].groupIndex, changes[i].after);
+		}
+	}
+	if (!isApplied) {
+		printf("an edit in the undo history is corrupt\n");
+	}
+	return isApplied;
+}
+
+bool32 undoEdit(EditJournal* journal, VoxelArray* voxelArray, World* world) {
+	_assert(!journal->isEditing);
+	if (journal->appliedEditsCount == 0) {
+		return 0;
+	}
+	bool32 isAllocated;
+	u8* record = readEditRecord(journal, journal->appliedEditsCount - 1, &isAllocated);
+	if (record == nil) {
+		return 0;
+	}
+	bool32 isApplied = applyEditRecord(record, voxelArray, world, 1);
+	if (isAllocated) {
+		free(record);
+	}
+	journal->appliedEditsCount -= 1;
+	return isApplied;
+}
+
+bool32 redoEdit(EditJournal* journal, VoxelArray* voxelArray, World* world) {
+	_assert(!journal->isEditing);
+	if (journal->appliedEditsCount == journal->editsCount) {
+		return 0;
+	}
+	bool32 isAllocated;
+	u8* record = readEditRecord(journal, journal->appliedEditsCount, &isAllocated);
+	if (record == nil) {
+		return 0;
+	}
+	bool32 isApplied = applyEditRecord(record, voxelArray, world, 0);
+	if (isAllocated) {
+		free(record);
+	}
+	journal->appliedEditsCount += 1;
+	return isApplied;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#ifndef VOXELS_GAME_EDIT_JOURNAL_H
+#define VOXELS_GAME_EDIT_JOURNAL_H
+
+#include "common.h"
+#include "memory.h"
+#include "voxel.h"
+#include "world_file.h"
+
+#include <stdio.h>
+
+/*
+	undo and redo history of the editor. an edit records what it's about to change between beginEdit and endEdit:
+	spans of existing voxels and groups are recorded before they are written, and voxels and groups added after the
+	last existing ones are picked up by endEdit. voxel values are stored as runs with the chunk codec of the world file,
+	and added voxels and groups are undone by dropping them, so undoing a big fill doesn't copy the world.
+	edits are kept in a log of at most memoryBudget bytes. the oldest ones spill to a file once it's full
+*/
+
+const u32 MAX_JOURNAL_EDITS = 1024;
+const char* const EDIT_JOURNAL_SPILL_PATH = "./edits.vxjournal";
+
+struct EditJournalEntry {
+	u64 offset;
+	u64 size;
+	//spilled edits are read back from the file. they are always the oldest ones
+	bool32 isSpilled;
+};
+
+struct EditJournalGroupChange {
+	i32 groupIndex;
+	VoxelGroup before;
+	VoxelGroup after;
+};
+
+struct EditJournal {
+	char spillFilepath[WORLD_FILE_PATH_LENGTH];
+	FILE* spillFile;
+	u64 spilledBytes;
+
+	u8* memory;
+	u64 memoryBudget;
+	u64 memoryUsed;
+
+	//edits [0, appliedEditsCount) are done, and the ones after it are undone and can be redone until the next edit
+	EditJournalEntry entries[MAX_JOURNAL_EDITS];
+	u32 editsCount;
+	u32 appliedEditsCount;
+
+	//the edit being recorded
+	bool32 isEditing;
+	u32 coalesceKey;
+	i32 voxelsCountBefore;
+	i32 groupsCountBefore;
+	VoxelSpan* spans;
+	u32 spansCount;
+	u32 spansCapacity;
+	EditJournalGroupChange* groupChanges;
+	u32 groupChangesCount;
+	u32 groupChangesCapacity;
+	//the encoded values of the recorded spans from before the edit
+	u8* oldValues;
+	u64 oldValuesSize;
+	u64 oldValuesCapacity;
+	u8* chunkBuffer;
+};
+
+void initEditJournal(EditJournal* journal, MemoryAllocator* memoryAllocator, u64 memoryBudget, const char* spillFilepath);
+//closes and deletes the spill file, and frees what the edit being recorded allocated
+void destroyEditJournal(EditJournal* journal);
+
+//edits that end with the same nonzero coalesceKey as the last one, and only change the same groups, are merged into it.
+//the editor gives every drag its own key, so a drag is undone in one step
+void beginEdit(EditJournal* journal, VoxelArray* voxelArray, u32 coalesceKey);
+//call before writing to voxels that existed when the edit began
+void recordVoxelSpanEdit(EditJournal* journal, VoxelArray* voxelArray, VoxelSpan span);
+//call before changing a group that existed when the edit began, including adding voxels to it
+void recordVoxelGroupEdit(EditJournal* journal, VoxelArray* voxelArray, i32 groupIndex);
+//edits that didn't change anything aren't kept. redoable edits are dropped by any edit that is kept
+void endEdit(EditJournal* journal, VoxelArray* voxelArray);
+
+//the world may be nil. its chunks that the edit touches are loaded first. returns 0 if there was nothing to undo or redo,
+//or if a spilled edit couldn't be read back
+bool32 undoEdit(EditJournal* journal, VoxelArray* voxelArray, World* world);
+bool32 redoEdit(EditJournal* journal, VoxelArray* voxelArray, World* world);
+
+#endif
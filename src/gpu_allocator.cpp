@@ -0,0 +1,211 @@
+#include "gpu_allocator.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static u32 calculateOrder(u64 size) {
+	u32 order = 0;
+	while ((GPU_ALLOCATOR_MIN_ALLOCATION_SIZE << order) < size) {
+		order += 1;
+	}
+	return order;
+}
+
+static u64 roundBlockSize(u64 size) {
+	u64 rounded = GPU_ALLOCATOR_MIN_ALLOCATION_SIZE;
+	while (rounded * 2 <= size) {
+		rounded *= 2;
+	}
+	return rounded;
+}
+
+void initGPUAllocator(GPUAllocator* allocator, GPUMemoryInterface memoryInterface, u32 memoryTypesCount, u64 blockSize, u64 bufferImageGranularity) {
+	_assert(memoryTypesCount <= GPU_ALLOCATOR_MAX_MEMORY_TYPES);
+	memset(allocator, 0, sizeof(GPUAllocator));
+	allocator->memoryInterface = memoryInterface;
+	allocator->memoryTypesCount = memoryTypesCount;
+	for (u32 i = 0; i < memoryTypesCount; i++) {
+		allocator->blockSizes[i] = roundBlockSize(blockSize);
+	}
+	allocator->bufferImageGranularity = bufferImageGranularity;
+	allocator->isSeparatingResourceKinds = bufferImageGranularity > GPU_ALLOCATOR_MIN_ALLOCATION_SIZE;
+}
+
+void setGPUMemoryTypeBlockSize(GPUAllocator* allocator, u32 memoryTypeIndex, u64 blockSize) {
+	_assert(memoryTypeIndex < allocator->memoryTypesCount);
+	allocator->blockSizes[memoryTypeIndex] = roundBlockSize(blockSize);
+}
+
+static bool32 createBlock(GPUAllocator* allocator, u32 memoryTypeIndex, u32 blockIndex, u64 size, GPUResourceKind kind, bool32 isDedicated) {
+	if (!allocator->memoryInterface.allocateBlock(allocator->memoryInterface.context, memoryTypeIndex, blockIndex, size)) {
+		return 0;
+	}
+	GPUMemoryBlock* block = &allocator->blocks[memoryTypeIndex][blockIndex];
+	block->isInUse = 1;
+	block->isDedicated = isDedicated;
+	block->kind = kind;
+	block->size = size;
+	block->maxOrder = calculateOrder(size);
+	block->allocationsCount = 0;
+	allocator->statistics[memoryTypeIndex].blocksCount += 1;
+	allocator->statistics[memoryTypeIndex].blockBytes += size;
+	allocator->blocksCount += 1;
+	if (isDedicated) {
+		block->largestFreeOrders = nil;
+		return 1;
+	}
+
+	u64 nodesCount = 2ull << block->maxOrder;
+	block->largestFreeOrders = (u8*) malloc(nodesCount);
+	//every node starts out free. node n sits at depth floor(log2(n)), so its order is maxOrder minus that
+	u32 order = block->maxOrder;
+	for (u64 levelBegin = 1; levelBegin < nodesCount; levelBegin *= 2) {
+		memset(&block->largestFreeOrders[levelBegin], order + 1, levelBegin);
+		order -= 1;
+	}
+	block->largestFreeOrders[0] = 0;
+	return 1;
+}
+
+static void destroyBlock(GPUAllocator* allocator, u32 memoryTypeIndex, u32 blockIndex) {
+	GPUMemoryBlock* block = &allocator->blocks[memoryTypeIndex][blockIndex];
+	allocator->memoryInterface.freeBlock(allocator->memoryInterface.context, memoryTypeIndex, blockIndex);
+	allocator->statistics[memoryTypeIndex].blocksCount -= 1;
+	allocator->statistics[memoryTypeIndex].blockBytes -= block->size;
+	allocator->blocksCount -= 1;
+	free(block->largestFreeOrders);
+	*block = {};
+}
+
+//returns the node, or 0 if the block has no free run of that order
+static u32 allocateFromBlock(GPUMemoryBlock* block, u32 order) {
+	u8* largest = block->largestFreeOrders;
+	if (order > block->maxOrder || largest[1] < order + 1) {
+		return 0;
+	}
+	u32 node = 1;
+	for (u32 nodeOrder = block->maxOrder; nodeOrder > order; nodeOrder--) {
+		u32 left = 2 * node;
+		u32 right = left + 1;
+		//the child with the smaller run that still fits is picked, which leaves the larger runs for larger allocations
+		if (largest[left] >= order + 1 && (largest[right] < order + 1 || largest[left] <= largest[right])) {
+			node = left;
+		} else {
+			node = right;
+		}
+	}
+	largest[node] = 0;
+	for (u32 parent = node / 2; parent >= 1; parent /= 2) {
+		largest[parent] = MAX(largest[2 * parent], largest[2 * parent + 1]);
+	}
+	return node;
+}
+
+static void freeFromBlock(GPUMemoryBlock* block, u32 node, u32 order) {
+	u8* largest = block->largestFreeOrders;
+	largest[node] = (u8)(order + 1);
+	u32 childOrder = order;
+	for (u32 parent = node / 2; parent >= 1; parent /= 2) {
+		u8 left = largest[2 * parent];
+		u8 right = largest[2 * parent + 1];
+		//two whole free buddies merge back into their parent
+		if (left == childOrder + 1 && right == childOrder + 1) {
+			largest[parent] = (u8)(childOrder + 2);
+		} else {
+			largest[parent] = MAX(left, right);
+		}
+		childOrder += 1;
+	}
+}
+
+bool32 allocateGPUMemory(GPUAllocator* allocator, u32 memoryTypeIndex, u64 size, u64 alignment, GPUResourceKind kind, GPUAllocation* allocation) {
+	_assert(memoryTypeIndex < allocator->memoryTypesCount);
+	_assert(size > 0);
+	//buddies are aligned to their own size, so an alignment larger than the size only needs a larger buddy
+	u32 order = calculateOrder(MAX(size, alignment));
+	if (!allocator->isSeparatingResourceKinds) {
+		kind = GPU_RESOURCE_LINEAR;
+	}
+	GPUMemoryBlock* blocks = allocator->blocks[memoryTypeIndex];
+	bool32 isDedicated = (GPU_ALLOCATOR_MIN_ALLOCATION_SIZE << order) > allocator->blockSizes[memoryTypeIndex];
+
+	u32 blockIndex = GPU_ALLOCATOR_MAX_BLOCKS;
+	u32 node = 0;
+	for (u32 i = 0; i < GPU_ALLOCATOR_MAX_BLOCKS && node == 0 && !isDedicated; i++) {
+		if (blocks[i].isInUse && !blocks[i].isDedicated && blocks[i].kind == kind) {
+			node = allocateFromBlock(&blocks[i], order);
+			blockIndex = i;
+		}
+	}
+	if (node == 0) {
+		blockIndex = GPU_ALLOCATOR_MAX_BLOCKS;
+		for (u32 i = 0; i < GPU_ALLOCATOR_MAX_BLOCKS; i++) {
+			if (!blocks[i].isInUse) {
+				blockIndex = i;
+				break;
+			}
+		}
+		if (blockIndex == GPU_ALLOCATOR_MAX_BLOCKS) {
+			return 0;
+		}
+		//dedicated blocks start at offset 0, which meets any alignment
+		u64 blockSize = isDedicated ? (size + GPU_ALLOCATOR_MIN_ALLOCATION_SIZE - 1) / GPU_ALLOCATOR_MIN_ALLOCATION_SIZE * GPU_ALLOCATOR_MIN_ALLOCATION_SIZE : allocator->blockSizes[memoryTypeIndex];
+		if (!createBlock(allocator, memoryTypeIndex, blockIndex, blockSize, kind, isDedicated)) {
+			return 0;
+		}
+		if (!isDedicated) {
+			node = allocateFromBlock(&blocks[blockIndex], order);
+			_assert(node != 0);
+		}
+	}
+
+	GPUMemoryBlock* block = &blocks[blockIndex];
+	block->allocationsCount += 1;
+	allocation->memoryTypeIndex = memoryTypeIndex;
+	allocation->blockIndex = blockIndex;
+	allocation->size = size;
+	allocation->order = order;
+	allocation->node = node;
+	if (isDedicated) {
+		allocation->offset = 0;
+	} else {
+		u32 depth = block->maxOrder - order;
+		allocation->offset = (u64)(node - (1u << depth)) * (GPU_ALLOCATOR_MIN_ALLOCATION_SIZE << order);
+	}
+
+	GPUMemoryTypeStatistics* statistics = &allocator->statistics[memoryTypeIndex];
+	statistics->allocationsCount += 1;
+	statistics->allocatedBytes += size;
+	statistics->usedBytes += isDedicated ? block->size : GPU_ALLOCATOR_MIN_ALLOCATION_SIZE << order;
+	return 1;
+}
+
+void freeGPUMemory(GPUAllocator* allocator, GPUAllocation* allocation) {
+	GPUMemoryBlock* block = &allocator->blocks[allocation->memoryTypeIndex][allocation->blockIndex];
+	_assert(block->isInUse && block->allocationsCount > 0);
+	if (!block->isDedicated) {
+		freeFromBlock(block, allocation->node, allocation->order);
+	}
+	block->allocationsCount -= 1;
+
+	GPUMemoryTypeStatistics* statistics = &allocator->statistics[allocation->memoryTypeIndex];
+	statistics->allocationsCount -= 1;
+	statistics->allocatedBytes -= allocation->size;
+	statistics->usedBytes -= block->isDedicated ? block->size : GPU_ALLOCATOR_MIN_ALLOCATION_SIZE << allocation->order;
+
+	//one empty shared block is kept around so a resource that is recreated, like the depth image on resize, doesn't allocate a new block every time
+	if (block->allocationsCount == 0 && (block->isDedicated || statistics->blocksCount > 1)) {
+		destroyBlock(allocator, allocation->memoryTypeIndex, allocation->blockIndex);
+	}
+	*allocation = {};
+}
+
+void destroyGPUAllocator(GPUAllocator* allocator) {
+	for (u32 type = 0; type < allocator->memoryTypesCount; type++) {
+		for (u32 i = 0; i < GPU_ALLOCATOR_MAX_BLOCKS; i++) {
+			if (allocator->blocks[type][i].isInUse) {
+				destroyBlock(allocator, type, i);
+			}
+		}
+	}
+}
@@ -0,0 +1,88 @@
+#pragma once
+#ifndef VOXELS_GAME_GPU_ALLOCATOR_H
+#define VOXELS_GAME_GPU_ALLOCATOR_H
+
+#include "common.h"
+
+/*
+	sub-allocates gpu memory out of large blocks, one set of blocks per memory type.
+	each block is a buddy allocator: every allocation is a power of two times GPU_ALLOCATOR_MIN_ALLOCATION_SIZE, aligned to its own size.
+	the allocator never touches the memory itself, it only asks GPUMemoryInterface for blocks and hands out offsets into them,
+	so it runs the same against vulkan and against the mock in gpu-allocator-test.
+*/
+
+const u32 GPU_ALLOCATOR_MAX_MEMORY_TYPES = 32;
+const u32 GPU_ALLOCATOR_MAX_BLOCKS = 64;
+const u64 GPU_ALLOCATOR_MIN_ALLOCATION_SIZE = 256;
+const u64 GPU_ALLOCATOR_DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+
+//buffers and linearly tiled images are linear resources, optimally tiled images are not.
+//bufferImageGranularity only applies between neighboring linear and optimal resources
+typedef u32 GPUResourceKind;
+const GPUResourceKind GPU_RESOURCE_LINEAR = 0;
+const GPUResourceKind GPU_RESOURCE_OPTIMAL = 1;
+
+struct GPUMemoryInterface {
+	void* context;
+	//returns 0 if the memory type's heap is out of memory
+	bool32 (*allocateBlock)(void* context, u32 memoryTypeIndex, u32 blockIndex, u64 size);
+	void (*freeBlock)(void* context, u32 memoryTypeIndex, u32 blockIndex);
+};
+
+struct GPUMemoryBlock {
+	bool32 isInUse;
+	//holds one allocation larger than the block size, sized to fit it exactly instead of to a power of two
+	bool32 isDedicated;
+	GPUResourceKind kind;
+	u64 size;
+	//the whole block is one allocation of this order
+	u32 maxOrder;
+	u32 allocationsCount;
+	//buddy tree in heap order, node 1 being the whole block. each node holds 1 + the largest free order in its subtree, or 0 if nothing in it is free.
+	//nil for dedicated blocks
+	u8* largestFreeOrders;
+};
+
+struct GPUAllocation {
+	u32 memoryTypeIndex;
+	u32 blockIndex;
+	u64 offset;
+	//the size that was asked for. the allocation takes GPU_ALLOCATOR_MIN_ALLOCATION_SIZE << order bytes, or its whole block if that's dedicated
+	u64 size;
+	u32 order;
+	u32 node;
+};
+
+struct GPUMemoryTypeStatistics {
+	u32 blocksCount;
+	u32 allocationsCount;
+	u64 blockBytes;
+	//bytes asked for, and bytes taken once rounded up to a power of two
+	u64 allocatedBytes;
+	u64 usedBytes;
+};
+
+struct GPUAllocator {
+	GPUMemoryInterface memoryInterface;
+	u32 memoryTypesCount;
+	u64 blockSizes[GPU_ALLOCATOR_MAX_MEMORY_TYPES];
+	//linear and optimal resources only get separate blocks when the granularity is coarser than the smallest allocation
+	u64 bufferImageGranularity;
+	bool32 isSeparatingResourceKinds;
+	GPUMemoryBlock blocks[GPU_ALLOCATOR_MAX_MEMORY_TYPES][GPU_ALLOCATOR_MAX_BLOCKS];
+	GPUMemoryTypeStatistics statistics[GPU_ALLOCATOR_MAX_MEMORY_TYPES];
+	u32 blocksCount;
+};
+
+//block sizes are rounded down to a power of two times GPU_ALLOCATOR_MIN_ALLOCATION_SIZE
+void initGPUAllocator(GPUAllocator* allocator, GPUMemoryInterface memoryInterface, u32 memoryTypesCount, u64 blockSize, u64 bufferImageGranularity);
+//only affects blocks allocated afterwards
+void setGPUMemoryTypeBlockSize(GPUAllocator* allocator, u32 memoryTypeIndex, u64 blockSize);
+//allocations larger than the memory type's block size get a dedicated block. returns 0 if no block has room and a new one can't be allocated
+bool32 allocateGPUMemory(GPUAllocator* allocator, u32 memoryTypeIndex, u64 size, u64 alignment, GPUResourceKind kind, GPUAllocation* allocation);
+//blocks left empty are given back, except the last shared block of each memory type
+void freeGPUMemory(GPUAllocator* allocator, GPUAllocation* allocation);
+//frees every block, whether or not its allocations were freed
+void destroyGPUAllocator(GPUAllocator* allocator);
+
+#endif
@@ -0,0 +1,64 @@
+#include "jobs.h"
+
+#include <stdio.h>
+
+static void runJobWorker(void* data) {
+	JobQueue* queue = (JobQueue*)data;
+	for (;;) {
+		if (!runNextJob(queue)) {
+			waitForSemaphore(queue->semaphore);
+		}
+	}
+}
+
+void initJobQueue(JobQueue* queue, u32 threadsCount) {
+	queue->addedJobsCount = 0;
+	queue->takenJobsCount = 0;
+	queue->completedJobsCount = 0;
+	queue->semaphore = createSemaphore(0);
+	queue->threadsCount = 0;
+	for (u32 i = 0; i < threadsCount; i++) {
+		if (!createThread(runJobWorker, queue)) {
+			printf("unable to create job worker thread %u\n", i);
+			break;
+		}
+		queue->threadsCount += 1;
+	}
+}
+
+void addJob(JobQueue* queue, JobFunction function, void* data) {
+	u32 added = queue->addedJobsCount;
+	//a slot is free again once the job stored in it was taken, since taking a job copies it out first
+	while (added - atomicLoadU32(&queue->takenJobsCount) >= MAX_QUEUED_JOBS) {
+		runNextJob(queue);
+	}
+	Job* job = &queue->jobs[added % MAX_QUEUED_JOBS];
+	job->function = function;
+	job->data = data;
+	atomicStoreU32(&queue->addedJobsCount, added + 1);
+	signalSemaphore(queue->semaphore, 1);
+}
+
+bool32 runNextJob(JobQueue* queue) {
+	for (;;) {
+		u32 taken = atomicLoadU32(&queue->takenJobsCount);
+		if (taken == atomicLoadU32(&queue->addedJobsCount)) {
+			return 0;
+		}
+		//the producer doesn't overwrite a slot until its job was taken, so this copy is valid if the exchange below succeeds
+		Job job = queue->jobs[taken % MAX_QUEUED_JOBS];
+		if (atomicCompareExchangeU32(&queue->takenJobsCount, taken, taken + 1) == taken) {
+			job.function(job.data);
+			atomicIncrementU32(&queue->completedJobsCount);
+			return 1;
+		}
+	}
+}
+
+void waitForAllJobs(JobQueue* queue) {
+	while (atomicLoadU32(&queue->completedJobsCount) != queue->addedJobsCount) {
+		if (!runNextJob(queue)) {
+			sleepMilliseconds(0);
+		}
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+#ifndef VOXELS_GAME_JOBS_H
+#define VOXELS_GAME_JOBS_H
+
+#include "common.h"
+#include "platform.h"
+
+//must be a power of two
+const u32 MAX_QUEUED_JOBS = 4096;
+
+typedef void (*JobFunction)(void* data);
+
+struct Job {
+	JobFunction function;
+	void* data;
+};
+
+//single producer, multiple consumer queue of jobs run by a fixed pool of worker threads
+struct JobQueue {
+	//totals ever added, taken by a thread and finished. job n is stored in jobs[n % MAX_QUEUED_JOBS]
+	volatile u32 addedJobsCount;
+	volatile u32 takenJobsCount;
+	volatile u32 completedJobsCount;
+	PlatformSemaphore semaphore;
+	u32 threadsCount;
+	Job jobs[MAX_QUEUED_JOBS];
+};
+
+//starts threadsCount worker threads. 0 runs every job on the thread that waits for them
+void initJobQueue(JobQueue* queue, u32 threadsCount);
+//only the thread that created the queue may add jobs. blocks, running queued jobs itself, while the queue is full
+void addJob(JobQueue* queue, JobFunction function, void* data);
+//runs one queued job on the calling thread. returns 0 if there was none
+bool32 runNextJob(JobQueue* queue);
+//runs queued jobs on the calling thread until every added job has finished
+void waitForAllJobs(JobQueue* queue);
+
+#endif
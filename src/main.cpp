@@ -19,6 +19,18 @@
 #include "voxel.h"
 #include "memory.h"
 #include "collision.h"
+#include "profiler.h"
+#include "jobs.h"
+#include "world_file.h"
+#include "world_streaming.h"
+#include "vox.h"
+#include "edit_journal.h"
+#include "voxel_region.h"
+#include "voxel_selection.h"
+#include "voxel_translucency.h"
+#include "voxel_occlusion.h"
+#include "voxel_light.h"
+#include "voxel_shadow.h"
 
 #define IMGUI_DISABLE_OBSOLETE_FUNCTIONS
 #include <imgui/imgui.h>
@@ -54,6 +66,25 @@ struct WorldEditorConfig {
 	i32 voxelGridWidth;
 	i32 voxelGridHeight;
 	i32 voxelGridUnitSize;
+	bool isAutosaveEnabled;
+	f32 autosaveIntervalSeconds;
+	//region edits, in voxel units of the group they edit
+	i32 regionShape;
+	i32 regionMin[3];
+	i32 regionMax[3];
+	i32 regionCellSize;
+	i32 regionHollowThickness;
+	f32 regionColor[4];
+	//how a lasso combines with the selection. a VoxelSelectionMode
+	i32 selectionMode;
+	i32 selectionOffset[3];
+	//the block light of the sources placed from the lighting header, and how many cells the light spreads through a frame
+	i32 lightSourceLevel;
+	i32 lightNodesBudget;
+	//the sun's angles in degrees, and how dark its shadows are
+	f32 sunYaw;
+	f32 sunPitch;
+	f32 shadowStrength;
 };
 
 f64 scrollWheelOffset;
@@ -62,8 +93,38 @@ void scrollCallback(GLFWwindow *window, double xoffset, double yoffset) {
 	scrollWheelOffset = yoffset;
 }
 
+//the last .vox file dropped on the window. it's imported by the main loop
+char droppedVoxFilepath[WORLD_FILE_PATH_LENGTH];
+
+void dropCallback(GLFWwindow* window, int pathsCount, const char** paths) {
+	for (int i = 0; i < pathsCount; i++) {
+		size_t length = strlen(paths[i]);
+		if (length >= 4 && length < WORLD_FILE_PATH_LENGTH && _stricmp(paths[i] + length - 4, ".vox") == 0) {
+			strcpy(droppedVoxFilepath, paths[i]);
+		}
+	}
+}
+
+//adds a span of voxels whose instances are redrawn without being dirty. returns the new spans count
+static i32 appendRedrawnVoxelSpan(VoxelSpan* spans, i32 spansCount, i32 spansCapacity, VoxelSpan span, i32 voxelsCount) {
+	span.end = MIN(span.end, voxelsCount);
+	if (spansCount < spansCapacity) {
+		spans[spansCount] = span;
+		return spansCount + 1;
+	}
+	//out of spans. one span covering all of them redraws more than needed, but never misses a voxel
+	for (i32 i = 0; i < spansCount; i++) {
+		span.begin = MIN(span.begin, spans[i].begin);
+		span.end = MAX(span.end, spans[i].end);
+	}
+	spans[0] = span;
+	return 1;
+}
+
 int main(void) {
 	f64 loadStartTime = glfwGetTime();
+	initProfiler();
+	setProfilerThreadName("main");
 #ifndef NDEBUG
 	printf("IN DEBUG MODE\n");
 #endif
@@ -84,57 +145,108 @@ int main(void) {
 		return 1;
 	}
 
-	//TODO: might have to memory allocate the memory allocator
-	MemoryAllocator* memoryAllocator;
-	{
-		MemoryAllocator tmp;
-		initMemoryAllocator(&tmp, gigabyte(1));
-		memoryAllocator = &tmp;
-	}
+	MemoryAllocator mainMemoryAllocator = {};
+	initMemoryAllocator(&mainMemoryAllocator, gigabyte(2));
+	MemoryAllocator* memoryAllocator = &mainMemoryAllocator;
 
-	Renderer* renderer = (Renderer*) allocateMemory(memoryAllocator, sizeof(renderer));
-	initRenderer(renderer, window, memoryAllocator);
+	//the main thread runs jobs too while it waits for them, so one core is left for it
+	JobQueue* jobQueue = (JobQueue*) allocateMemory(memoryAllocator, sizeof(JobQueue));
+	initJobQueue(jobQueue, MAX(getLogicalProcessorCount(), 2) - 1);
+
+	Renderer* renderer = (Renderer*) allocateMemory(memoryAllocator, sizeof(Renderer));
+	memset(renderer, 0, sizeof(Renderer));
+	initRenderer(renderer, window, memoryAllocator, jobQueue);
 
 	const u32 maxVoxels = 2048 * 2048;
 	VoxelArray voxelArray = {};
 	initVoxelArray(&voxelArray, memoryAllocator, maxVoxels, maxVoxels/16);
 
+	TranslucentVoxels* translucentVoxels = (TranslucentVoxels*) allocateMemory(memoryAllocator, sizeof(TranslucentVoxels));
+	initTranslucentVoxels(translucentVoxels, memoryAllocator, voxelArray.voxelsCapacity, 256 * 1024);
+
+	VoxelOcclusion* voxelOcclusion = (VoxelOcclusion*) allocateMemory(memoryAllocator, sizeof(VoxelOcclusion));
+	initVoxelOcclusion(voxelOcclusion, memoryAllocator, &voxelArray);
+
+	//256 x 64 x 256 world units around the origin, in cells of a world unit
+	VoxelLight* voxelLight = (VoxelLight*) allocateMemory(memoryAllocator, sizeof(VoxelLight));
+	initVoxelLight(voxelLight, memoryAllocator, &voxelArray, Vector3i{ -512, -64, -512 }, 4, Vector3i{ 16, 4, 16 }, 2 * 1024 * 1024);
+
+	//the sun's shadows are marched through the cells the light is blocked in
+	VoxelShadow* voxelShadow = (VoxelShadow*) allocateMemory(memoryAllocator, sizeof(VoxelShadow));
+	initVoxelShadow(voxelShadow, memoryAllocator, voxelLight);
+	_assert((u64)voxelShadow->chunksCount * VOXEL_SHADOW_CHUNK_WORDS * sizeof(u32) <= MAX_VOXEL_SHADOW_OCCUPANCY_SIZE);
+	//the chunks of the occupancy waiting to be uploaded. [begin, end)
+	i32 shadowUploadChunksBegin = voxelShadow->chunksCount;
+	i32 shadowUploadChunksEnd = 0;
+	bool32 isShadowUploaded = 0;
+
+	//the voxels' instances
 	GPUObjectData gpuObjectData = {};
 	gpuObjectData.models = (math::Matrix4*) allocateMemory(memoryAllocator, voxelArray.voxelsCapacity * sizeof(math::Matrix4));
 	gpuObjectData.rgbaColors = (RGBAColorF32*) allocateMemory(memoryAllocator, voxelArray.voxelsCapacity * sizeof(RGBAColorF32));
+	gpuObjectData.occlusions = (u64*) allocateMemory(memoryAllocator, voxelArray.voxelsCapacity * sizeof(u64));
 	gpuObjectData.count = 0;
 
-	RGBAColorF32 colorWhite = { 1.0f, 1.0f, 1.0f, 1.0f };
-
-	i32 mainVoxelGroup = addEmptyVoxelGroup(&voxelArray, math::Vector3{});
+	//the cursor and camera markers, the translucent voxels sorted back to front and the selected voxel. they go to their own region of the object buffers
+	GPUObjectData overlayObjectData = {};
+	i32 overlayObjectsCapacity = 2 + translucentVoxels->capacity + 1;
+	_assert((u32)overlayObjectsCapacity <= MAX_OVERLAY_OBJECTS);
+	overlayObjectData.models = (math::Matrix4*) allocateMemory(memoryAllocator, overlayObjectsCapacity * sizeof(math::Matrix4));
+	overlayObjectData.rgbaColors = (RGBAColorF32*) allocateMemory(memoryAllocator, overlayObjectsCapacity * sizeof(RGBAColorF32));
+	overlayObjectData.occlusions = (u64*) allocateMemory(memoryAllocator, overlayObjectsCapacity * sizeof(u64));
+	overlayObjectData.count = 0;
+
+	i32 dirtyVoxelSpansCapacity = voxelArray.groupsCapacity + MAX_DIRTY_VOXEL_SPANS;
+	VoxelSpan* dirtyVoxelSpans = (VoxelSpan*) allocateMemory(memoryAllocator, dirtyVoxelSpansCapacity * sizeof(VoxelSpan));
+	//spans whose upload didn't fit in the ring. they are redrawn on the next frame without being marked dirty again
+	VoxelSpan* pendingRedrawSpans = (VoxelSpan*) allocateMemory(memoryAllocator, dirtyVoxelSpansCapacity * sizeof(VoxelSpan));
+	i32 pendingRedrawSpansCount = 0;
+
+	//the saved world is opened without decoding its voxels. they are streamed in around the camera
+	World* world = (World*) allocateMemory(memoryAllocator, sizeof(World));
+	initWorld(world, memoryAllocator, &voxelArray, WORLD_FILE_PATH);
+	WorldStreamer* worldStreamer = (WorldStreamer*) allocateMemory(memoryAllocator, sizeof(WorldStreamer));
+	initWorldStreamer(worldStreamer, memoryAllocator, world, jobQueue, 128ull * 1024 * 1024, 100.0f);
+	EditJournal* editJournal = (EditJournal*) allocateMemory(memoryAllocator, sizeof(EditJournal));
+	initEditJournal(editJournal, memoryAllocator, 64ull * 1024 * 1024, EDIT_JOURNAL_SPILL_PATH);
+	//only the built in scene's groups 1 to 3 spin. a saved or imported world's groups are left where they are
+	bool32 isDemoScene = 0;
+	if (openWorld(world)) {
+		printf("opened world %s with %d voxels in %u chunks\n", WORLD_FILE_PATH, voxelArray.voxelsCount, world->header.chunksCount);
+	} else {
+		isDemoScene = 1;
+		RGBAColorF32 colorWhite = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+		i32 mainVoxelGroup = addEmptyVoxelGroup(&voxelArray, math::Vector3{});
+
+		addStandaloneVoxel(&voxelArray, colorWhite, Vector3i{ 12, 0, -30 }, Vector3ui{ 8, 8, 8 });
+		addStandaloneVoxel(&voxelArray, colorWhite, Vector3i{ -12, 0, -30 }, Vector3ui{ 8, 8, 8 });
+
+		addVoxelToGroup(&voxelArray, {0.0f, 1.0f, 1.0f, 0.2f}, Vector3i{0, 12, -40}, Vector3ui{8, 8, 8}, mainVoxelGroup);
+		addVoxelToGroup(&voxelArray, colorWhite, Vector3i{24, 12, -30}, Vector3ui{ 8, 8, 2 }, mainVoxelGroup);
+		addVoxelToGroup(&voxelArray, colorWhite, Vector3i{36, 12, -30}, Vector3ui{ 8, 8, 1 }, mainVoxelGroup);
+		addVoxelToGroup(&voxelArray, colorWhite, Vector3i{-10, 12, -30}, Vector3ui{ 8, 8, 8 }, mainVoxelGroup);
+		addVoxelToGroup(&voxelArray, colorWhite, Vector3i{10, 12, -30}, Vector3ui{ 8, 8, 8 }, mainVoxelGroup);
+		addVoxelToGroup(&voxelArray, colorWhite, Vector3i{-24, 12, -30}, Vector3ui{ 1, 1, 1 }, mainVoxelGroup);
 
-	addStandaloneVoxel(&voxelArray, colorWhite, Vector3i{ 12, 0, -30 }, Vector3ui{ 8, 8, 8 });
-	addStandaloneVoxel(&voxelArray, colorWhite, Vector3i{ -12, 0, -30 }, Vector3ui{ 8, 8, 8 });
-
-	addVoxelToGroup(&voxelArray, {0.0f, 1.0f, 1.0f, 0.2f}, Vector3i{0, 12, -40}, Vector3ui{8, 8, 8}, mainVoxelGroup);
-	addVoxelToGroup(&voxelArray, colorWhite, Vector3i{24, 12, -30}, Vector3ui{ 8, 8, 2 }, mainVoxelGroup);
-	addVoxelToGroup(&voxelArray, colorWhite, Vector3i{36, 12, -30}, Vector3ui{ 8, 8, 1 }, mainVoxelGroup);
-	addVoxelToGroup(&voxelArray, colorWhite, Vector3i{-10, 12, -30}, Vector3ui{ 8, 8, 8 }, mainVoxelGroup);
-	addVoxelToGroup(&voxelArray, colorWhite, Vector3i{10, 12, -30}, Vector3ui{ 8, 8, 8 }, mainVoxelGroup);
-	addVoxelToGroup(&voxelArray, colorWhite, Vector3i{-24, 12, -30}, Vector3ui{ 1, 1, 1 }, mainVoxelGroup);
-
-	{
-		i32 g1 = addEmptyVoxelGroup(&voxelArray, math::Vector3{0, 0, -30.0f});
-		addVoxelToGroup(&voxelArray, colorWhite, Vector3i{ 0, 0, 0 }, Vector3ui{ 2, 2, 2 }, g1);
-		addVoxelToGroup(&voxelArray, colorWhite, Vector3i{ 0, 2, 0 }, Vector3ui{ 2, 2, 2 }, g1);
-		addVoxelToGroup(&voxelArray, colorWhite, Vector3i{ 0, 4, 0 }, Vector3ui{ 2, 2, 2 }, g1);
-		addVoxelToGroup(&voxelArray, colorWhite, Vector3i{ 0, 6, 0 }, Vector3ui{ 2, 2, 2 }, g1);
-		addVoxelToGroup(&voxelArray, colorWhite, Vector3i{ 0, 8, 0 }, Vector3ui{ 2, 2, 2 }, g1);
-	}
-	{
+		{
+			i32 g1 = addEmptyVoxelGroup(&voxelArray, math::Vector3{0, 0, -30.0f});
+			addVoxelToGroup(&voxelArray, colorWhite, Vector3i{ 0, 0, 0 }, Vector3ui{ 2, 2, 2 }, g1);
+			addVoxelToGroup(&voxelArray, colorWhite, Vector3i{ 0, 2, 0 }, Vector3ui{ 2, 2, 2 }, g1);
+			addVoxelToGroup(&voxelArray, colorWhite, Vector3i{ 0, 4, 0 }, Vector3ui{ 2, 2, 2 }, g1);
+			addVoxelToGroup(&voxelArray, colorWhite, Vector3i{ 0, 6, 0 }, Vector3ui{ 2, 2, 2 }, g1);
+			addVoxelToGroup(&voxelArray, colorWhite, Vector3i{ 0, 8, 0 }, Vector3ui{ 2, 2, 2 }, g1);
+		}
+		{
 
-		i32 g1 = addEmptyVoxelGroup(&voxelArray, math::Vector3{ 0, 0, -50 });
-		i32 g2 = addEmptyVoxelGroup(&voxelArray, math::Vector3{ 0, 0, -60 });
-		addVoxelToGroup(&voxelArray, { 0.8f, 1.0f, 0.0f, 1.0f }, Vector3i{ 0, 0, 0 }, Vector3ui{2, 2, 4}, g1);
-		addVoxelToGroup(&voxelArray, { 0.5f, 0.0f, 1.0f, 1.0f }, Vector3i{ 0, 0, 0 }, Vector3ui{2, 2, 4}, g2);
-		voxelArray.groups[g1].rotation = math::createQuaternionRotation(1.604749, { 0.067773, 0.995257, -0.069782 });
+			i32 g1 = addEmptyVoxelGroup(&voxelArray, math::Vector3{ 0, 0, -50 });
+			i32 g2 = addEmptyVoxelGroup(&voxelArray, math::Vector3{ 0, 0, -60 });
+			addVoxelToGroup(&voxelArray, { 0.8f, 1.0f, 0.0f, 1.0f }, Vector3i{ 0, 0, 0 }, Vector3ui{2, 2, 4}, g1);
+			addVoxelToGroup(&voxelArray, { 0.5f, 0.0f, 1.0f, 1.0f }, Vector3i{ 0, 0, 0 }, Vector3ui{2, 2, 4}, g2);
+			voxelArray.groups[g1].rotation = math::createQuaternionRotation(1.604749, { 0.067773, 0.995257, -0.069782 });
 
-		voxelArray.groups[g2].rotation = math::createQuaternionRotation(PI32 / 4.0f, { 0.0f, 1.0f, 0.0f });
+			voxelArray.groups[g2].rotation = math::createQuaternionRotation(PI32 / 4.0f, { 0.0f, 1.0f, 0.0f });
+		}
 	}
 
 	/* Make the window's context current */
@@ -153,6 +265,7 @@ int main(void) {
 	lastCursorY = cursorY;
 
 	bool showImGuiDemoWindow = false;
+	bool showProfilerWindow = false;
 	bool wasCameraToggleKeyPressed = false;
 
 	bool32 isMovingCamera = 0;
@@ -163,16 +276,37 @@ int main(void) {
 		}
 	}
 	glfwSetScrollCallback(window, scrollCallback);
+	glfwSetDropCallback(window, dropCallback);
 
 	WorldEditorConfig worldEditorConfig;
 	worldEditorConfig = {};
 	worldEditorConfig.voxelGridWidth = 64;
 	worldEditorConfig.voxelGridHeight = 32;
 	worldEditorConfig.voxelGridUnitSize = 8;
+	worldEditorConfig.isAutosaveEnabled = true;
+	worldEditorConfig.autosaveIntervalSeconds = 5.0f;
+	worldEditorConfig.regionShape = VOXEL_REGION_BOX;
+	worldEditorConfig.regionMin[0] = -32;
+	worldEditorConfig.regionMin[1] = 0;
+	worldEditorConfig.regionMin[2] = -96;
+	worldEditorConfig.regionMax[0] = 32;
+	worldEditorConfig.regionMax[1] = 64;
+	worldEditorConfig.regionMax[2] = -32;
+	worldEditorConfig.regionCellSize = 4;
+	worldEditorConfig.regionColor[0] = 0.3f;
+	worldEditorConfig.regionColor[1] = 0.7f;
+	worldEditorConfig.regionColor[2] = 0.1f;
+	worldEditorConfig.regionColor[3] = 1.0f;
+	worldEditorConfig.lightSourceLevel = 15;
+	worldEditorConfig.lightNodesBudget = 256 * 1024;
+	worldEditorConfig.sunYaw = 30.0f;
+	worldEditorConfig.sunPitch = 55.0f;
+	worldEditorConfig.shadowStrength = 0.35f;
 
 	i32 maxVoxelGridUnitSize = 16;
 
 	i32 selectedVoxelIndex = -1;
+	i32 lastSelectedVoxelIndex = -1;
 	RGBAColorF32 selectedVoxelColorBlend = { 1.0f, 1.0f, 0.0f, 0.1f };
 
 	f32 cameraPitch = 0.0f;
@@ -193,6 +327,27 @@ int main(void) {
 	UniformBufferData ub = {};
 
 	bool32 isLeftCursorPressed = false;
+	//every drag is one edit. its frames are coalesced by this key
+	u32 dragEditKey = 0;
+	bool32 isUndoRequested = 0;
+	bool32 isRedoRequested = 0;
+	bool32 wasUndoKeyPressed = 0;
+	//the group of the last voxel that was picked, which region edits other than fills work on
+	i32 regionGroupIndex = -1;
+	RGBAColorF32 regionPickedColor = {};
+	VoxelClipboard* voxelClipboard = (VoxelClipboard*) allocateMemory(memoryAllocator, sizeof(VoxelClipboard));
+	initVoxelClipboard(voxelClipboard, memoryAllocator, voxelArray.voxelsCapacity / 4);
+	//shift + drag selects the voxels in a rectangle, and alt + drag the voxels in a freehand lasso
+	VoxelSpatialIndex* voxelSpatialIndex = (VoxelSpatialIndex*) allocateMemory(memoryAllocator, sizeof(VoxelSpatialIndex));
+	initVoxelSpatialIndex(voxelSpatialIndex, memoryAllocator, &voxelArray);
+	VoxelSelection* voxelSelection = (VoxelSelection*) allocateMemory(memoryAllocator, sizeof(VoxelSelection));
+	initVoxelSelection(voxelSelection, memoryAllocator, &voxelArray);
+	RGBAColorF32 selectionColorBlend = { 0.0f, 0.6f, 1.0f, 1.0f };
+	bool32 isLassoing = 0;
+	bool32 isLassoRectangle = 0;
+	//in pixels, with y going up like the cursor
+	math::Vector2* lassoPoints = (math::Vector2*) allocateMemory(memoryAllocator, MAX_LASSO_POINTS * sizeof(math::Vector2));
+	i32 lassoPointsCount = 0;
 
 	bool32 wasCursorRayCasted = false;
 	math::Quaternion cursorRayOrientation = math::Quaternion{};
@@ -214,6 +369,9 @@ int main(void) {
 	
 	/* Loop until the user closes the window */
 	while (!glfwWindowShouldClose(window)) {
+		beginProfilerFrame();
+		PROFILE_ZONE("frame");
+		PROFILE_ZONE_BEGIN(inputZone, "input");
 		frameCounter = (frameCounter + 1) % MAX_FRAMES_IN_FLIGHT;
 		scrollWheelOffset = 0.0f;
 		/* Poll for and process events */
@@ -225,6 +383,47 @@ int main(void) {
 			continue;
 		}
 
+		if (droppedVoxFilepath[0] != 0) {
+			f64 importStartTime = glfwGetTime();
+			i32 importedVoxelsBegin = voxelArray.voxelsCount;
+			beginEdit(editJournal, &voxelArray, 0);
+			if (importVoxFile(droppedVoxFilepath, &voxelArray, VOX_DEFAULT_VOXEL_SIZE)) {
+				printf("imported %d voxels from %s in %f seconds\n", voxelArray.voxelsCount - importedVoxelsBegin, droppedVoxFilepath, glfwGetTime() - importStartTime);
+			}
+			endEdit(editJournal, &voxelArray);
+			droppedVoxFilepath[0] = 0;
+		}
+
+		bool32 isControlPressed = glfwGetKey(window, GLFW_KEY_LEFT_CONTROL) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_RIGHT_CONTROL) == GLFW_PRESS;
+		bool32 isUndoKeyPressed = isControlPressed && (glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_Y) == GLFW_PRESS);
+		if (isUndoKeyPressed && !wasUndoKeyPressed) {
+			if (glfwGetKey(window, GLFW_KEY_Y) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS) {
+				isRedoRequested = 1;
+			} else {
+				isUndoRequested = 1;
+			}
+		}
+		wasUndoKeyPressed = isUndoKeyPressed;
+		if (isUndoRequested || isRedoRequested) {
+			PROFILE_ZONE("undo");
+			//the selection may not exist anymore, so it's dropped, along with the drag
+			if (lastSelectedVoxelIndex >= 0) {
+				markVoxelDirty(&voxelArray, lastSelectedVoxelIndex);
+			}
+			selectedVoxelIndex = -1;
+			lastSelectedVoxelIndex = -1;
+			isCursorRayHit = 0;
+			regionGroupIndex = -1;
+			clearVoxelSelection(voxelSelection);
+			f64 undoStartTime = glfwGetTime();
+			bool32 isApplied = isUndoRequested ? undoEdit(editJournal, &voxelArray, world) : redoEdit(editJournal, &voxelArray, world);
+			if (isApplied) {
+				printf("%s an edit in %f seconds\n", isUndoRequested ? "undid" : "redid", glfwGetTime() - undoStartTime);
+			}
+			isUndoRequested = 0;
+			isRedoRequested = 0;
+		}
+
 		lastCursorX = cursorX;
 		lastCursorY = cursorY;
 		glfwGetCursorPos(window, &cursorX, &cursorY);
@@ -270,7 +469,33 @@ int main(void) {
 			wasCameraToggleKeyPressed = false;
 		}
 		if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS) {
-			if (!isLeftCursorPressed) {
+			bool32 isShiftPressed = glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_RIGHT_SHIFT) == GLFW_PRESS;
+			bool32 isAltPressed = glfwGetKey(window, GLFW_KEY_LEFT_ALT) == GLFW_PRESS || glfwGetKey(window, GLFW_KEY_RIGHT_ALT) == GLFW_PRESS;
+			math::Vector2 cursor = { (f32)cursorX, (f32)cursorY };
+			if (!isLeftCursorPressed && (isShiftPressed || isAltPressed)) {
+				//a lasso doesn't pick, so it never drags a group
+				isLassoing = 1;
+				isLassoRectangle = isShiftPressed;
+				lassoPoints[0] = cursor;
+				lassoPoints[1] = cursor;
+				lassoPointsCount = isLassoRectangle ? 2 : 1;
+				selectedVoxelIndex = -1;
+				isCursorRayHit = 0;
+			}
+			else if (isLassoing) {
+				math::Vector2 last = lassoPoints[lassoPointsCount - 1];
+				f32 dx = cursor.x - last.x;
+				f32 dy = cursor.y - last.y;
+				if (isLassoRectangle) {
+					lassoPoints[1] = cursor;
+				} else if (lassoPointsCount < MAX_LASSO_POINTS && dx * dx + dy * dy >= 16.0f) {
+					lassoPoints[lassoPointsCount] = cursor;
+					lassoPointsCount += 1;
+				}
+			}
+			else if (!isLeftCursorPressed) {
+				PROFILE_ZONE("picking");
+				dragEditKey += 1;
 				cursorRay = calculateRayFromScreenToWorld(cursorX, cursorY, windowWidth, windowHeight, ub, cameraPosition);
 
 				cursorRayOrientation = math::convertEulerAnglesToQuaternionRotation(math::Vector3{ cameraPitch, -cameraYaw, 0.0f });
@@ -283,29 +508,12 @@ int main(void) {
 
 				wasCursorRayCasted = 1;
 
-				selectedVoxelIndex = -1;
 				const f32 tmax = 100.0f;
-				isCursorRayHit = 0;
-				cursorRayHitDist = tmax;
-				for (i32 i = 0; i < voxelArray.voxelsCount; i++) {
-					OBB o = {};
-					o.center = convertVoxelUnitsToWorldUnits(voxelArray.voxelsPosition[i]);
-					o.halfExtents = convertVoxelUnitsToWorldUnits(voxelArray.voxelsScale[i]).scale(0.5f);
-					o.orientation = math::createQuaternionRotation( 0.0f, {1.0f, 0.0f, 0.0f} );
-
-					i32 voxelGroupIndex = voxelArray.voxelsGroupIndex[i];
-					if (voxelGroupIndex >= 0) {
-						o.center = math::rotateVector(o.center, voxelArray.groups[voxelGroupIndex].rotation).add(voxelArray.groups[voxelGroupIndex].position.scale(voxelUnitsToWorldUnits));
-						o.orientation = voxelArray.groups[voxelGroupIndex].rotation;
-					}
-					f32 t;
-					math::Vector3 q;
-					if (isRayIntersectingOBB(cursorRay.origin, cursorRay.direction, o, tmax, &t, &q) && t < cursorRayHitDist) {
-						cursorRayHitDist = t;
-						cursorRayHitPoint = q;
-						selectedVoxelIndex = i;
-						isCursorRayHit = 1;
-					}
+				selectedVoxelIndex = pickVoxelInIndex(voxelSpatialIndex, &voxelArray, jobQueue, cursorRay.origin, cursorRay.direction, tmax, &cursorRayHitDist, &cursorRayHitPoint);
+				isCursorRayHit = selectedVoxelIndex >= 0;
+				if (isCursorRayHit) {
+					regionGroupIndex = voxelArray.voxelsGroupIndex[selectedVoxelIndex];
+					regionPickedColor = voxelArray.colors[selectedVoxelIndex];
 				}
 			}
 			else if (isCursorRayHit) {
@@ -318,6 +526,29 @@ int main(void) {
 			isLeftCursorPressed = 1;
 		}
 		else if (glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_RELEASE) {
+			if (isLassoing) {
+				PROFILE_ZONE("lasso selection");
+				math::Vector2 points[MAX_LASSO_POINTS];
+				i32 pointsCount = lassoPointsCount;
+				for (i32 i = 0; i < lassoPointsCount; i++) {
+					points[i] = math::Vector2{ 2.0f * lassoPoints[i].x / (f32)windowWidth - 1.0f, 2.0f * lassoPoints[i].y / (f32)windowHeight - 1.0f };
+				}
+				if (isLassoRectangle) {
+					math::Vector2 a = points[0];
+					math::Vector2 b = points[1];
+					points[1] = math::Vector2{ b.x, a.y };
+					points[2] = b;
+					points[3] = math::Vector2{ a.x, b.y };
+					pointsCount = 4;
+				}
+				f64 selectStartTime = glfwGetTime();
+				i32 selectedCount = selectVoxelsInLasso(
+					voxelSelection, voxelSpatialIndex, &voxelArray, jobQueue, ub.projection.multiply(ub.view), points, pointsCount,
+					(VoxelSelectionMode)worldEditorConfig.selectionMode
+				);
+				printf("%d voxels selected in %f seconds\n", selectedCount, glfwGetTime() - selectStartTime);
+				isLassoing = 0;
+			}
 			isLeftCursorPressed = 0;
 		}
 
@@ -354,9 +585,13 @@ int main(void) {
 			}
 		}
 
+		PROFILE_ZONE_END(inputZone);
+
+		PROFILE_ZONE_BEGIN(acquireZone, "wait and acquire");
 		vkWaitForFences(renderer->device, 1, &renderer->inFlightFences[frameCounter], VK_TRUE, UINT64_MAX);
 		u32 imageIndex;
 		VkResult result = vkAcquireNextImageKHR(renderer->device, renderer->swapchain->handle, UINT64_MAX, renderer->imageAvailableSemaphores[frameCounter], VK_NULL_HANDLE, &imageIndex);
+		PROFILE_ZONE_END(acquireZone);
 		if (result == VK_ERROR_OUT_OF_DATE_KHR) {
 			result = handleRenderResizing(renderer);
 			if (result != VK_SUCCESS) {
@@ -370,6 +605,7 @@ int main(void) {
 		}
 		vkResetFences(renderer->device, 1, &renderer->inFlightFences[frameCounter]);
 
+		PROFILE_ZONE_BEGIN(commandRecordingZone, "command recording");
 		vkResetCommandBuffer(renderer->commandBuffers[frameCounter], 0);
 
 		VkCommandBufferBeginInfo commandBufferBeginInfo = {};
@@ -381,6 +617,225 @@ int main(void) {
 			printf("unable to begin the command buffer!\n");
 			return 1;
 		}
+		beginGPUProfilerFrame(renderer, frameCounter, getProfilerFrameNumber());
+
+		if (isDemoScene && voxelArray.groupsCount > 3) {
+			voxelArray.groups[1].rotation = math::createQuaternionRotation(fmodf((float)glfwGetTime(), TAU32), math::Vector3{ 1.0f, 0.0f, 0.0f });
+
+			voxelArray.groups[2].rotation = math::createQuaternionRotation(fmodf((float)glfwGetTime(), TAU32), math::Vector3{ 0.0f, 1.0f, 0.0f });
+
+			voxelArray.groups[3].rotation = math::createQuaternionRotation(fmodf((float) glfwGetTime(), TAU32), math::Vector3{ 1.0f, 0.0f, 1.0f }.normalize());
+			markVoxelGroupDirty(&voxelArray, 1);
+			markVoxelGroupDirty(&voxelArray, 2);
+			markVoxelGroupDirty(&voxelArray, 3);
+		}
+
+		{
+			//the frustum is last frame's. a frame late doesn't matter for ordering the loads
+			PROFILE_ZONE("world streaming");
+			updateWorldStreaming(worldStreamer, cameraPosition, ub.projection.multiply(ub.view));
+		}
+
+		{
+			//saves are written on the world's save thread. finishing one only maps the file again
+			PROFILE_ZONE("world save");
+			if (isWorldSaveWritten(world)) {
+				//chunk loads read from the mapping that's replaced
+				finishWorldStreaming(worldStreamer);
+				if (!finishWorldSave(world)) {
+					printf("unable to save the world to %s\n", WORLD_FILE_PATH);
+				}
+			}
+			//an unchanged world would only append another copy of its group table
+			if (
+				worldEditorConfig.isAutosaveEnabled && !world->isSaving &&
+				getWallClockSeconds() - world->saveStartSeconds >= (f64)worldEditorConfig.autosaveIntervalSeconds && isWorldModified(world)
+			) {
+				beginWorldSave(world);
+			}
+		}
+
+		PROFILE_ZONE_BEGIN(transformBuildZone, "transform build");
+		if (selectedVoxelIndex >= 0) {
+			math::Vector3 cursorRayPoint = cursorRay.origin.add(cursorRay.direction.scale(cursorRayHitDist));
+			i32 groupIndex = voxelArray.voxelsGroupIndex[selectedVoxelIndex];
+			math::Vector3 dragDelta = cursorRayPoint.sub(cursorRayHitPoint);
+			if (groupIndex >= 0 && dragDelta.dot(dragDelta) > 0.0f) {
+				beginEdit(editJournal, &voxelArray, dragEditKey);
+				recordVoxelGroupEdit(editJournal, &voxelArray, groupIndex);
+				VoxelGroup* g = &voxelArray.groups[groupIndex];
+				g->position = g->position.add(dragDelta.scale(1.0f / voxelUnitsToWorldUnits));
+				markVoxelGroupDirty(&voxelArray, groupIndex);
+				endEdit(editJournal, &voxelArray);
+			}
+			cursorRayHitPoint = cursorRayPoint;
+		}
+		//the selected voxel is drawn after everything else for transparency, so its own instance is collapsed to nothing, like the translucent voxels'
+		if (selectedVoxelIndex != lastSelectedVoxelIndex) {
+			if (lastSelectedVoxelIndex >= 0) {
+				markVoxelDirty(&voxelArray, lastSelectedVoxelIndex);
+			}
+			if (selectedVoxelIndex >= 0) {
+				markVoxelDirty(&voxelArray, selectedVoxelIndex);
+			}
+			lastSelectedVoxelIndex = selectedVoxelIndex;
+		}
+
+		//a voxel's instance index is its voxel index, so only the instances of changed voxels are rebuilt
+		i32 dirtyVoxelSpansCount = collectDirtyVoxelSpans(&voxelArray, dirtyVoxelSpans, dirtyVoxelSpansCapacity);
+		markVoxelSpatialIndexStale(voxelSpatialIndex, dirtyVoxelSpans, dirtyVoxelSpansCount);
+		{
+			PROFILE_ZONE("occlusion");
+			updateVoxelOcclusion(voxelOcclusion, &voxelArray, jobQueue, dirtyVoxelSpans, dirtyVoxelSpansCount);
+		}
+		{
+			PROFILE_ZONE("light");
+			updateVoxelLight(voxelLight, &voxelArray, jobQueue, dirtyVoxelSpans, dirtyVoxelSpansCount, worldEditorConfig.lightNodesBudget);
+		}
+		{
+			PROFILE_ZONE("shadow");
+			updateVoxelShadow(voxelShadow, voxelLight, jobQueue);
+			i32 chunksBegin;
+			i32 chunksEnd;
+			if (collectVoxelShadowChanges(voxelShadow, &chunksBegin, &chunksEnd)) {
+				shadowUploadChunksBegin = MIN(shadowUploadChunksBegin, chunksBegin);
+				shadowUploadChunksEnd = MAX(shadowUploadChunksEnd, chunksEnd);
+			}
+		}
+		//voxels whose selection, occlusion or light changed only need their instances redrawn. they aren't marked dirty, which would have them saved again
+		VoxelSpan redrawSpan;
+		if (collectVoxelSelectionChanges(voxelSelection, &redrawSpan)) {
+			dirtyVoxelSpansCount = appendRedrawnVoxelSpan(dirtyVoxelSpans, dirtyVoxelSpansCount, dirtyVoxelSpansCapacity, redrawSpan, voxelArray.voxelsCount);
+		}
+		if (collectVoxelOcclusionChanges(voxelOcclusion, &redrawSpan)) {
+			dirtyVoxelSpansCount = appendRedrawnVoxelSpan(dirtyVoxelSpans, dirtyVoxelSpansCount, dirtyVoxelSpansCapacity, redrawSpan, voxelArray.voxelsCount);
+		}
+		if (collectVoxelLightChanges(voxelLight, &redrawSpan)) {
+			dirtyVoxelSpansCount = appendRedrawnVoxelSpan(dirtyVoxelSpans, dirtyVoxelSpansCount, dirtyVoxelSpansCapacity, redrawSpan, voxelArray.voxelsCount);
+		}
+		for (i32 s = 0; s < pendingRedrawSpansCount; s++) {
+			dirtyVoxelSpansCount = appendRedrawnVoxelSpan(
+				dirtyVoxelSpans, dirtyVoxelSpansCount, dirtyVoxelSpansCapacity, pendingRedrawSpans[s], voxelArray.voxelsCount
+			);
+		}
+		pendingRedrawSpansCount = 0;
+		for (i32 s = 0; s < dirtyVoxelSpansCount; s++) {
+			for (i32 i = dirtyVoxelSpans[s].begin; i < dirtyVoxelSpans[s].end; i++) {
+				RGBAColorF32 color = voxelArray.colors[i];
+				if (isVoxelSelected(voxelSelection, i)) {
+					color.r = 0.5f * (color.r + selectionColorBlend.r);
+					color.g = 0.5f * (color.g + selectionColorBlend.g);
+					color.b = 0.5f * (color.b + selectionColorBlend.b);
+				}
+				gpuObjectData.rgbaColors[i] = color;
+				gpuObjectData.occlusions[i] = voxelOcclusion->occlusions[i] | ((u64)voxelLight->voxelLevels[i] << VOXEL_LIGHT_OCCLUSION_SHIFT);
+				//voxels of unloaded chunks keep their slots with a zero scale, and are drawn as nothing
+				if (i == selectedVoxelIndex || voxelArray.voxelsScale[i].x == 0) {
+					removeTranslucentVoxel(translucentVoxels, i);
+					gpuObjectData.models[i] = {};
+					continue;
+				}
+				//translucent voxels are drawn after the opaque ones from their own sorted instances
+				math::Matrix4 model = calculateVoxelModelMatrix(&voxelArray, i);
+				gpuObjectData.models[i] = updateTranslucentVoxel(translucentVoxels, i, model, color) ? math::Matrix4{} : model;
+			}
+		}
+
+
+		PROFILE_ZONE_END(transformBuildZone);
+
+		ub = {};
+		ub.view = math::lookAt(cameraPosition, cameraPosition.add(cameraDirection), math::Vector3{0.0f, 1.0f, 0.0f});
+		ub.projection = math::createPerspective(math::radians(70.0f), (f32)renderer->swapchain->extent.width/(f32)renderer->swapchain->extent.height, 0.1f, 100.0f);
+
+		gpuObjectData.count = voxelArray.voxelsCount;
+		//the overlay instances change every frame, so they are always rebuilt and uploaded
+		overlayObjectData.count = 0;
+		if (isCursorRayHit) {
+			math::Matrix4 model = math::translateMatrix(math::initIdentityMatrix(), cursorRayHitPoint);
+			model = model.multiply(math::createRotationMatrix(cursorRayOrientation));
+			model = math::scaleMatrix(model, math::Vector3{0.125f, 0.125f, 0.125f});
+			overlayObjectData.models[overlayObjectData.count] = model;
+			overlayObjectData.rgbaColors[overlayObjectData.count] = RGBAColorF32{0.7f, 1.0f, 0.0f, 1.0f};
+			overlayObjectData.count += 1;
+		}
+
+		math::Quaternion cameraOrientation = math::convertEulerAnglesToQuaternionRotation(math::Vector3{ cameraPitch, -cameraYaw, 0.0f });
+		math::Matrix4 model = math::initIdentityMatrix();
+		model = model.multiply(math::createRotationMatrix(cameraOrientation));
+		model = math::scaleMatrix(model, math::Vector3{0.5f, 0.5f, 2.0f});
+		overlayObjectData.models[overlayObjectData.count] = model;
+		overlayObjectData.rgbaColors[overlayObjectData.count] = RGBAColorF32{1.0f, 0.5f, 0.0f, 1.0f};
+		overlayObjectData.count += 1;
+
+		//the markers are opaque, and drawn with the voxels
+		u32 opaqueInstancesCount = overlayObjectData.count;
+		{
+			PROFILE_ZONE("translucent sort");
+			//voxels removed by an undo or an unload leave the set here
+			trimTranslucentVoxels(translucentVoxels, voxelArray.voxelsCount);
+			overlayObjectData.count += sortTranslucentVoxels(
+				translucentVoxels, ub.view, &overlayObjectData.models[overlayObjectData.count], &overlayObjectData.rgbaColors[overlayObjectData.count]
+			);
+		}
+
+		if (selectedVoxelIndex >= 0) {
+			RGBAColorF32 color = voxelArray.colors[selectedVoxelIndex];
+			color.r = 0.5f * (color.r + selectedVoxelColorBlend.r);
+			color.g = 0.5f * (color.g + selectedVoxelColorBlend.g);
+			color.b = 0.5f * (color.b + selectedVoxelColorBlend.b);
+			color.a = 0.5f * (color.a + selectedVoxelColorBlend.a);
+			overlayObjectData.models[overlayObjectData.count] = calculateVoxelModelMatrix(&voxelArray, selectedVoxelIndex);
+			overlayObjectData.rgbaColors[overlayObjectData.count] = color;
+			overlayObjectData.count += 1;
+		}
+		for (u32 i = 0; i < overlayObjectData.count; i++) {
+			overlayObjectData.occlusions[i] = VOXEL_UNOCCLUDED | ((u64)VOXEL_LIGHT_OPEN_SKY << VOXEL_LIGHT_OCCLUSION_SHIFT);
+		}
+
+		{
+			PROFILE_ZONE("upload");
+			u32 uploadGPUZone = beginGPUZone(renderer, frameCounter, "upload");
+			beginFrameUploads(renderer, frameCounter);
+			for (i32 s = 0; s < dirtyVoxelSpansCount; s++) {
+				if (
+					!uploadGPUObjectData(renderer, frameCounter, &gpuObjectData, dirtyVoxelSpans[s].begin, dirtyVoxelSpans[s].end) ||
+					!updateCullingBatches(renderer, frameCounter, &gpuObjectData, dirtyVoxelSpans[s].begin, dirtyVoxelSpans[s].end, voxelArray.voxelsCount)
+				) {
+					//the ring is full. the span is uploaded on a later frame. its edits, if it had any, already marked its chunks modified
+					pendingRedrawSpansCount = appendRedrawnVoxelSpan(
+						pendingRedrawSpans, pendingRedrawSpansCount, dirtyVoxelSpansCapacity, dirtyVoxelSpans[s], voxelArray.voxelsCount
+					);
+				}
+			}
+			//the ring is full when it fails, and the chunks are uploaded on a later frame
+			if (
+				shadowUploadChunksBegin < shadowUploadChunksEnd &&
+				uploadVoxelShadowOccupancy(
+					renderer, frameCounter, voxelShadow->occupancy, shadowUploadChunksBegin * VOXEL_SHADOW_CHUNK_WORDS, shadowUploadChunksEnd * VOXEL_SHADOW_CHUNK_WORDS
+				)
+			) {
+				shadowUploadChunksBegin = voxelShadow->chunksCount;
+				shadowUploadChunksEnd = 0;
+				isShadowUploaded = 1;
+			}
+			if (!uploadGPUOverlayObjectData(renderer, frameCounter, &overlayObjectData)) {
+				overlayObjectData.count = 0;
+				opaqueInstancesCount = 0;
+			}
+			endFrameUploads(renderer, frameCounter);
+			endGPUZone(renderer, frameCounter, uploadGPUZone);
+		}
+
+		{
+			//only the voxels are culled. the instances after them are few and change every frame
+			PROFILE_ZONE("culling");
+			u32 cullingGPUZone = beginGPUZone(renderer, frameCounter, "culling");
+			recordInstanceCulling(renderer, frameCounter, ub.projection.multiply(ub.view), voxelArray.voxelsCount);
+			endGPUZone(renderer, frameCounter, cullingGPUZone);
+		}
+
+		u32 renderPassGPUZone = beginGPUZone(renderer, frameCounter, "render pass");
 
 		VkRenderPassBeginInfo renderPassBeginInfo = {};
 		renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
@@ -413,10 +868,6 @@ int main(void) {
 
 		f32 scale = 2.0f;
 
-		ub = {};
-		ub.view = math::lookAt(cameraPosition, cameraPosition.add(cameraDirection), math::Vector3{0.0f, 1.0f, 0.0f});
-		ub.projection = math::createPerspective(math::radians(70.0f), (f32)renderer->swapchain->extent.width/(f32)renderer->swapchain->extent.height, 0.1f, 100.0f);
-
 		{
 			VkDeviceSize offsets[] = { 0 };
 			vkCmdBindVertexBuffers(renderer->commandBuffers[frameCounter], 0, 1, &renderer->texturedCubeVertexBuffer.buffer, offsets);
@@ -424,115 +875,72 @@ int main(void) {
 
 		memcpy(renderer->uniformBuffers[frameCounter].mappedData, &ub, sizeof(ub));
 
-		voxelArray.groups[1].rotation = math::createQuaternionRotation(fmodf((float)glfwGetTime(), TAU32), math::Vector3{ 1.0f, 0.0f, 0.0f });
-
-		voxelArray.groups[2].rotation = math::createQuaternionRotation(fmodf((float)glfwGetTime(), TAU32), math::Vector3{ 0.0f, 1.0f, 0.0f });
-
-		voxelArray.groups[3].rotation = math::createQuaternionRotation(fmodf((float) glfwGetTime(), TAU32), math::Vector3{ 1.0f, 0.0f, 1.0f }.normalize());
-
-		gpuObjectData.count = 0;
-
-		for (i32 i = 0; i < voxelArray.voxelsCount; i++) {
-			math::Vector3 worldPosition = math::Vector3{ (f32)voxelArray.voxelsPosition[i].x, (f32)voxelArray.voxelsPosition[i].y, (f32)voxelArray.voxelsPosition[i].z }.scale(voxelUnitsToWorldUnits);
-
-			math::Matrix4 rotationMatrix = math::initIdentityMatrix();
-			RGBAColorF32 color = voxelArray.colors[i];
-			if (selectedVoxelIndex == i) {
-				math::Vector3 cursorRayPoint = cursorRay.origin.add(cursorRay.direction.scale(cursorRayHitDist));
-				if (voxelArray.voxelsGroupIndex[i] >= 0) {
-					VoxelGroup* g = &voxelArray.groups[voxelArray.voxelsGroupIndex[i]];
-					g->position = g->position.add(cursorRayPoint.sub(cursorRayHitPoint).scale(1.0f / voxelUnitsToWorldUnits));
-
-				}
-				cursorRayHitPoint = cursorRayPoint;
-				color.r = 0.5f * (color.r + selectedVoxelColorBlend.r);
-				color.g = 0.5f * (color.g + selectedVoxelColorBlend.g);
-				color.b = 0.5f * (color.b + selectedVoxelColorBlend.b);
-				color.a = 0.5f * (color.a + selectedVoxelColorBlend.a);
-			}
-
-			if (voxelArray.voxelsGroupIndex[i] >= 0) {
-				//if part of a group, the voxel's world position is now relative to the group's world position.
-				VoxelGroup* group = &voxelArray.groups[voxelArray.voxelsGroupIndex[i]];
-				worldPosition = math::rotateVector(worldPosition, group->rotation);
-				worldPosition = worldPosition.add(group->position.scale(voxelUnitsToWorldUnits));
-				rotationMatrix = math::createRotationMatrix(group->rotation);
-			}
-			math::Matrix4 model = math::translateMatrix(math::initIdentityMatrix(), worldPosition);
-			model = model.multiply(rotationMatrix);
-
-			model = math::scaleMatrix(model, math::Vector3{ (f32)voxelArray.voxelsScale[i].x, (f32)voxelArray.voxelsScale[i].y, (f32)voxelArray.voxelsScale[i].z }.scale(voxelUnitsToWorldUnits));
-			gpuObjectData.models[gpuObjectData.count] = model;
-			gpuObjectData.rgbaColors[gpuObjectData.count] = color;
-			gpuObjectData.count += 1;
-		}
-
-
-		if (selectedVoxelIndex >= 0){ //handle transparent objects
-			math::Matrix4 otherModel = gpuObjectData.models[gpuObjectData.count - 1];
-			RGBAColorF32 otherColor = gpuObjectData.rgbaColors[gpuObjectData.count - 1];
-			gpuObjectData.models[gpuObjectData.count - 1] = gpuObjectData.models[selectedVoxelIndex];
-			gpuObjectData.rgbaColors[gpuObjectData.count - 1] = gpuObjectData.rgbaColors[selectedVoxelIndex];
-			gpuObjectData.models[selectedVoxelIndex] = otherModel;
-			gpuObjectData.rgbaColors[selectedVoxelIndex] = otherColor;
-		}
-
-		if (worldEditorConfig.isGridVisible) {
-			f32 lineThickness = 0.015625;
-			RGBAColorF32 gridColor = {1.0f, 0.0f, 0.0f, 0.1f};
-			for (i32 i = 0; i < worldEditorConfig.voxelGridWidth + 1; i++) {
-				f32 zLength = -(f32)(worldEditorConfig.voxelGridHeight * worldEditorConfig.voxelGridUnitSize) * voxelUnitsToWorldUnits;
-				math::Matrix4 model = math::translateMatrix(math::initIdentityMatrix(), math::Vector3{ (f32)(worldEditorConfig.voxelGridUnitSize * i) * voxelUnitsToWorldUnits , 0.0f, 0.5f * zLength });
-				model = math::scaleMatrix(model, math::Vector3{ lineThickness, lineThickness, (f32)zLength });
-				gpuObjectData.models[gpuObjectData.count] = model;
-				gpuObjectData.rgbaColors[gpuObjectData.count] = gridColor;
-				gpuObjectData.count += 1;
-			}
-
-			for (i32 i = 0; i < worldEditorConfig.voxelGridHeight + 1; i++) {
-				f32 columnLength = (f32)(worldEditorConfig.voxelGridWidth * worldEditorConfig.voxelGridUnitSize) * voxelUnitsToWorldUnits;
-				math::Matrix4 model = math::translateMatrix(math::initIdentityMatrix(), math::Vector3{ 0.5f * columnLength, 0.0f, -(f32)(worldEditorConfig.voxelGridUnitSize * i) * voxelUnitsToWorldUnits});
-				model = math::scaleMatrix(model, math::Vector3{columnLength, lineThickness, lineThickness });
-				gpuObjectData.models[gpuObjectData.count] = model;
-				gpuObjectData.rgbaColors[gpuObjectData.count] = gridColor;
-				gpuObjectData.count += 1;
-			}
-		}
-
-		if (isCursorRayHit) {
-			math::Matrix4 model = math::translateMatrix(math::initIdentityMatrix(), cursorRayHitPoint);
-			model = model.multiply(math::createRotationMatrix(cursorRayOrientation));
-			model = math::scaleMatrix(model, math::Vector3{0.125f, 0.125f, 0.125f});
-			gpuObjectData.models[gpuObjectData.count] = model;
-			gpuObjectData.rgbaColors[gpuObjectData.count] = RGBAColorF32{0.7f, 1.0f, 0.0f, 1.0f};
-			gpuObjectData.count += 1;
+		//the shadows stay off until the whole occupancy made it to the gpu once
+		VoxelShadowPushConstants shadowPushConstants = {};
+		{
+			f32 yaw = math::radians(worldEditorConfig.sunYaw);
+			f32 pitch = math::radians(worldEditorConfig.sunPitch);
+			shadowPushConstants.sunDirection[0] = cosf(pitch) * cosf(yaw);
+			shadowPushConstants.sunDirection[1] = sinf(pitch);
+			shadowPushConstants.sunDirection[2] = cosf(pitch) * sinf(yaw);
+			shadowPushConstants.strength = isShadowUploaded ? worldEditorConfig.shadowStrength : 0.0f;
+			shadowPushConstants.origin[0] = (f32)voxelShadow->origin.x * voxelUnitsToWorldUnits;
+			shadowPushConstants.origin[1] = (f32)voxelShadow->origin.y * voxelUnitsToWorldUnits;
+			shadowPushConstants.origin[2] = (f32)voxelShadow->origin.z * voxelUnitsToWorldUnits;
+			shadowPushConstants.cellSize = (f32)voxelShadow->cellSize * voxelUnitsToWorldUnits;
+			shadowPushConstants.cellsDims[0] = voxelShadow->chunksDims.x * VOXEL_LIGHT_CHUNK_SIZE;
+			shadowPushConstants.cellsDims[1] = voxelShadow->chunksDims.y * VOXEL_LIGHT_CHUNK_SIZE;
+			shadowPushConstants.cellsDims[2] = voxelShadow->chunksDims.z * VOXEL_LIGHT_CHUNK_SIZE;
+			shadowPushConstants.maxSteps = MAX_VOXEL_SHADOW_STEPS;
 		}
 
-
-		math::Quaternion cameraOrientation = math::convertEulerAnglesToQuaternionRotation(math::Vector3{ cameraPitch, -cameraYaw, 0.0f });
-		math::Matrix4 model = math::initIdentityMatrix();
-		model = model.multiply(math::createRotationMatrix(cameraOrientation));
-		model = math::scaleMatrix(model, math::Vector3{0.5f, 0.5f, 2.0f});
-		gpuObjectData.models[gpuObjectData.count] = model;
-		gpuObjectData.rgbaColors[gpuObjectData.count] = RGBAColorF32{1.0f, 0.5f, 0.0f, 1.0f};
-		gpuObjectData.count += 1;
-
-		memcpy(renderer->objectTransformBuffers[frameCounter].mappedData, gpuObjectData.models, sizeof(math::Matrix4)*gpuObjectData.count);
-		memcpy(renderer->objectColorBuffers[frameCounter].mappedData, gpuObjectData.rgbaColors, sizeof(RGBAColorF32)*gpuObjectData.count);
-
+		u32 voxelPassGPUZone = beginGPUZone(renderer, frameCounter, "voxel pass");
 		vkCmdBindPipeline(renderer->commandBuffers[frameCounter], VK_PIPELINE_BIND_POINT_GRAPHICS, renderer->voxelPipeline);
 
 		vkCmdBindDescriptorSets(renderer->commandBuffers[frameCounter], VK_PIPELINE_BIND_POINT_GRAPHICS, renderer->voxelPipelineLayout, 0, 1, &renderer->uniformBufferDescriptorSets[frameCounter], 0, nil);
 		vkCmdBindDescriptorSets(renderer->commandBuffers[frameCounter], VK_PIPELINE_BIND_POINT_GRAPHICS, renderer->voxelPipelineLayout, 1, 1, &renderer->objectDataDescriptorSets[frameCounter], 0, nil);
+		vkCmdPushConstants(renderer->commandBuffers[frameCounter], renderer->voxelPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(shadowPushConstants), &shadowPushConstants);
 
 		{
 			VkDeviceSize offsets[] = { 0 };
 			vkCmdBindVertexBuffers(renderer->commandBuffers[frameCounter], 0, 1, &renderer->cubeVertexBuffer.buffer, offsets);
 		}
 
-		vkCmdDraw(renderer->commandBuffers[frameCounter], 36, gpuObjectData.count, 0, 0);
+		drawCulledInstances(renderer, frameCounter, voxelArray.voxelsCount, voxelArray.voxelsCount);
+		drawOverlayInstances(renderer, frameCounter, 0, opaqueInstancesCount);
+		endGPUZone(renderer, frameCounter, voxelPassGPUZone);
+
+		//blended over the voxels, so it's drawn after them
+		if (worldEditorConfig.isGridVisible) {
+			u32 gridPassGPUZone = beginGPUZone(renderer, frameCounter, "grid pass");
+			GridPushConstants grid = {};
+			grid.color[0] = 1.0f;
+			grid.color[1] = 0.0f;
+			grid.color[2] = 0.0f;
+			grid.color[3] = 0.1f;
+			grid.cellsCount[0] = (f32)worldEditorConfig.voxelGridWidth;
+			grid.cellsCount[1] = (f32)worldEditorConfig.voxelGridHeight;
+			grid.cellSize = (f32)worldEditorConfig.voxelGridUnitSize * voxelUnitsToWorldUnits;
+			grid.lineWidth = 1.5f;
+			//centered under the camera, and snapped to whole cells so the lines stay on the same world positions as it moves
+			grid.origin[0] = (floorf(cameraPosition.x / grid.cellSize) - floorf(0.5f * grid.cellsCount[0])) * grid.cellSize;
+			grid.origin[1] = (floorf(-cameraPosition.z / grid.cellSize) - floorf(0.5f * grid.cellsCount[1])) * grid.cellSize;
+			drawGrid(renderer, frameCounter, &grid);
+			endGPUZone(renderer, frameCounter, gridPassGPUZone);
+		}
+
+		//the sorted translucent voxels and the selected voxel, blended over everything drawn so far.
+		//the grid pipeline's layout differs, so the descriptor sets and push constants are bound again
+		u32 translucentPassGPUZone = beginGPUZone(renderer, frameCounter, "translucent pass");
+		vkCmdBindPipeline(renderer->commandBuffers[frameCounter], VK_PIPELINE_BIND_POINT_GRAPHICS, renderer->translucentVoxelPipeline);
+		vkCmdBindDescriptorSets(renderer->commandBuffers[frameCounter], VK_PIPELINE_BIND_POINT_GRAPHICS, renderer->voxelPipelineLayout, 0, 1, &renderer->uniformBufferDescriptorSets[frameCounter], 0, nil);
+		vkCmdBindDescriptorSets(renderer->commandBuffers[frameCounter], VK_PIPELINE_BIND_POINT_GRAPHICS, renderer->voxelPipelineLayout, 1, 1, &renderer->objectDataDescriptorSets[frameCounter], 0, nil);
+		vkCmdPushConstants(renderer->commandBuffers[frameCounter], renderer->voxelPipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(shadowPushConstants), &shadowPushConstants);
+		drawOverlayInstances(renderer, frameCounter, opaqueInstancesCount, overlayObjectData.count);
+		endGPUZone(renderer, frameCounter, translucentPassGPUZone);
 
         // Start the Dear ImGui frame
+		PROFILE_ZONE_BEGIN(imguiZone, "imgui");
         ImGui_ImplVulkan_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
@@ -540,6 +948,9 @@ int main(void) {
 		if (showImGuiDemoWindow) {
 			ImGui::ShowDemoWindow(&showImGuiDemoWindow);
 		}
+		if (showProfilerWindow) {
+			drawProfilerWindow(&showProfilerWindow);
+		}
         {
             static float f = 0.0f;
             static int counter = 0;
@@ -548,6 +959,30 @@ int main(void) {
 
             ImGui::Text("This is some useful text.");               // Display some text (you can use a format strings too)
             ImGui::Checkbox("Demo Window", &showImGuiDemoWindow);      // Edit bools storing our window open/close state
+			ImGui::Checkbox("Profiler", &showProfilerWindow);
+			ImGui::Text("instance upload: %.1f KB", (f64)renderer->uploadRing.bytesUploadedThisFrame / 1024.0);
+			ImGui::Text("pipeline creation: %.2f ms (%s cache)", renderer->pipelineCreationMilliseconds, renderer->isPipelineCacheWarm ? "warm" : "cold");
+			if (renderer->gpuCulling.isSupported) {
+				GPUCulling* culling = &renderer->gpuCulling;
+				bool isCullingEnabled = culling->isEnabled;
+				ImGui::Checkbox("GPU Culling", &isCullingEnabled);
+				culling->isEnabled = isCullingEnabled;
+				ImGui::Text("culled draws: %u gpu, %u cpu", culling->lastCounters.drawCount, culling->lastExpectedCounters.drawCount);
+				ImGui::Text("visible voxels: %u gpu, %u cpu", culling->lastCounters.visibleInstancesCount, culling->lastExpectedCounters.visibleInstancesCount);
+				ImGui::Text("mismatched frames: %u", culling->mismatchedFramesCount);
+			}
+			GPUAllocator* gpuAllocator = &renderer->deviceMemory->allocator;
+			ImGui::Text("device memory blocks: %u", gpuAllocator->blocksCount);
+			for (u32 i = 0; i < gpuAllocator->memoryTypesCount; i++) {
+				GPUMemoryTypeStatistics* statistics = &gpuAllocator->statistics[i];
+				if (statistics->blocksCount > 0) {
+					ImGui::Text(
+						"  type %u: %u allocations, %.2f MB used of %.2f MB in %u blocks (%.2f MB asked for)", i, statistics->allocationsCount,
+						(f64)statistics->usedBytes / (1024.0 * 1024.0), (f64)statistics->blockBytes / (1024.0 * 1024.0), statistics->blocksCount,
+						(f64)statistics->allocatedBytes / (1024.0 * 1024.0)
+					);
+				}
+			}
 
             ImGui::SliderFloat("float", &f, 0.0f, 1.0f);            // Edit 1 float using a slider from 0.0f to 1.0f
             ImGui::ColorEdit3("clear color", (float*)&clearColor); // Edit 3 floats representing a color
@@ -560,10 +995,189 @@ int main(void) {
 				ImGui::InputInt("Voxel Grid Cell Size", &worldEditorConfig.voxelGridUnitSize);
 			}
 
-			worldEditorConfig.voxelGridWidth = MIN(MAX(1, worldEditorConfig.voxelGridWidth), 1024);
-			worldEditorConfig.voxelGridHeight = MIN(MAX(1, worldEditorConfig.voxelGridHeight), 1024);
+			//the grid costs the same at any size, so the limit only keeps its coordinates precise
+			worldEditorConfig.voxelGridWidth = MIN(MAX(1, worldEditorConfig.voxelGridWidth), 65536);
+			worldEditorConfig.voxelGridHeight = MIN(MAX(1, worldEditorConfig.voxelGridHeight), 65536);
 			worldEditorConfig.voxelGridUnitSize = MIN(MAX(1, worldEditorConfig.voxelGridUnitSize), maxVoxelGridUnitSize);
 
+			ImGui::Text(
+				"world: %d of %u chunks loaded, %.1f MB resident and %.1f MB pinned, %u waiting for memory, %llu loads, %llu unloads", world->loadedChunksCount,
+				world->header.chunksCount, (f64)getWorldResidentBytes(worldStreamer) / (1024.0 * 1024.0), (f64)getWorldPinnedBytes(worldStreamer) / (1024.0 * 1024.0),
+				worldStreamer->blockedChunksCount, (unsigned long long)worldStreamer->loadedChunksCount, (unsigned long long)worldStreamer->unloadedChunksCount
+			);
+			i32 residentMegabytesBudget = (i32)(worldStreamer->residentBytesBudget / (1024 * 1024));
+			if (ImGui::SliderInt("World Memory Budget (MB)", &residentMegabytesBudget, 16, 4096)) {
+				worldStreamer->residentBytesBudget = (u64)residentMegabytesBudget * 1024 * 1024;
+			}
+			ImGui::SliderFloat("World Load Radius", &worldStreamer->loadRadius, 10.0f, 1000.0f);
+			if (ImGui::Button("Save World")) {
+				beginWorldSave(world);
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Export .vox")) {
+				exportVoxFile("./export.vox", &voxelArray, VOX_DEFAULT_VOXEL_SIZE);
+			}
+			if (world->lastSaveSeconds > 0.0) {
+				ImGui::SameLine();
+				ImGui::Text(
+					"last save: %.2f ms, %.3f ms on the main thread, %.2f MB file%s", 1000.0 * world->lastSaveSeconds, 1000.0 * world->lastSaveBlockingSeconds,
+					(f64)world->lastSaveBytes / (1024.0 * 1024.0), world->wasLastSaveCompacted ? ", compacted" : ""
+				);
+			}
+			ImGui::Checkbox("Autosave", &worldEditorConfig.isAutosaveEnabled);
+			if (worldEditorConfig.isAutosaveEnabled) {
+				ImGui::SameLine();
+				ImGui::SliderFloat("Autosave Interval (s)", &worldEditorConfig.autosaveIntervalSeconds, 1.0f, 60.0f);
+			}
+			if (ImGui::CollapsingHeader("Region Edits")) {
+				ImGui::Combo("Shape", &worldEditorConfig.regionShape, "Box\0Sphere\0Cylinder\0");
+				ImGui::InputInt3("Region Min", worldEditorConfig.regionMin);
+				ImGui::InputInt3("Region Max", worldEditorConfig.regionMax);
+				ImGui::InputInt("Region Cell Size", &worldEditorConfig.regionCellSize);
+				ImGui::InputInt("Hollow Thickness", &worldEditorConfig.regionHollowThickness);
+				ImGui::ColorEdit4("Region Color", worldEditorConfig.regionColor);
+				worldEditorConfig.regionCellSize = MIN(MAX(1, worldEditorConfig.regionCellSize), 64);
+				worldEditorConfig.regionHollowThickness = MAX(0, worldEditorConfig.regionHollowThickness);
+				VoxelRegion region = {};
+				region.shape = (VoxelRegionShape)worldEditorConfig.regionShape;
+				region.min = Vector3i{ worldEditorConfig.regionMin[0], worldEditorConfig.regionMin[1], worldEditorConfig.regionMin[2] };
+				region.max = Vector3i{ worldEditorConfig.regionMax[0], worldEditorConfig.regionMax[1], worldEditorConfig.regionMax[2] };
+				f32* c = worldEditorConfig.regionColor;
+				RGBAColorF32 regionColor = { c[0], c[2], c[1], c[3] };
+				//fills go into a group of their own, the other edits into the group of the last voxel picked
+				bool32 hasRegionGroup = regionGroupIndex >= 0 && regionGroupIndex < voxelArray.groupsCount;
+				if (ImGui::Button("Fill") && voxelArray.groupsCount < voxelArray.groupsCapacity) {
+					f64 editStartTime = glfwGetTime();
+					beginEdit(editJournal, &voxelArray, 0);
+					i32 groupIndex = addEmptyVoxelGroup(&voxelArray, math::Vector3{});
+					i32 begin = fillVoxelRegion(
+						&voxelArray, jobQueue, editJournal, region, worldEditorConfig.regionCellSize, worldEditorConfig.regionHollowThickness, regionColor, groupIndex
+					);
+					if (begin < 0) {
+						voxelArray.groupsCount -= 1;
+						printf("the region has no cells, or they don't fit in the voxel array\n");
+					} else {
+						printf("filled %d voxels in %f seconds\n", voxelArray.voxelsCount - begin, glfwGetTime() - editStartTime);
+					}
+					endEdit(editJournal, &voxelArray);
+				}
+				if (hasRegionGroup) {
+					ImGui::SameLine();
+					if (ImGui::Button("Replace Picked Color")) {
+						beginEdit(editJournal, &voxelArray, 0);
+						i32 count = replaceVoxelRegionColor(&voxelArray, jobQueue, editJournal, region, regionGroupIndex, regionPickedColor, regionColor);
+						endEdit(editJournal, &voxelArray);
+						printf("recolored %d voxels\n", count);
+					}
+					ImGui::SameLine();
+					if (ImGui::Button("Copy") && !copyVoxelRegion(&voxelArray, jobQueue, region, regionGroupIndex, voxelClipboard)) {
+						printf("the region has more voxels than the clipboard can hold\n");
+					}
+					if (voxelClipboard->voxelsCount > 0) {
+						ImGui::SameLine();
+						//pastes with the copied region's min at the region's min
+						if (ImGui::Button("Paste")) {
+							beginEdit(editJournal, &voxelArray, 0);
+							if (pasteVoxelClipboard(&voxelArray, editJournal, voxelClipboard, region.min, regionGroupIndex) < 0) {
+								printf("the clipboard's voxels don't fit in the voxel array\n");
+							}
+							endEdit(editJournal, &voxelArray);
+						}
+					}
+					ImGui::Text("editing group %d, clipboard: %d voxels", regionGroupIndex, voxelClipboard->voxelsCount);
+				}
+			}
+			if (ImGui::CollapsingHeader("Lighting")) {
+				ImGui::SliderInt("Source Level", &worldEditorConfig.lightSourceLevel, 1, (i32)MAX_VOXEL_LIGHT_LEVEL);
+				ImGui::InputInt("Cells Spread per Frame", &worldEditorConfig.lightNodesBudget);
+				worldEditorConfig.lightNodesBudget = MAX(1024, worldEditorConfig.lightNodesBudget);
+				//the source goes in the cell in front of the surface that was clicked
+				if (isCursorRayHit) {
+					math::Vector3 p = cursorRayHitPoint.add(cursorRay.direction.scale(-0.5f)).scale(1.0f / voxelUnitsToWorldUnits);
+					Vector3i position = { (i32)floorf(p.x), (i32)floorf(p.y), (i32)floorf(p.z) };
+					if (ImGui::Button("Place Source at Cursor") && !setVoxelLightSource(voxelLight, position, worldEditorConfig.lightSourceLevel)) {
+						printf("the cursor is outside of the lit volume\n");
+					}
+					ImGui::SameLine();
+					if (ImGui::Button("Remove Source at Cursor")) {
+						setVoxelLightSource(voxelLight, position, 0);
+					}
+				}
+				ImGui::Text(
+					"queued: %llu removals, %llu fills", (unsigned long long)voxelLight->removalNodesCount, (unsigned long long)voxelLight->fillNodesCount
+				);
+				ImGui::SliderFloat("Sun Yaw", &worldEditorConfig.sunYaw, 0.0f, 360.0f);
+				ImGui::SliderFloat("Sun Pitch", &worldEditorConfig.sunPitch, 5.0f, 90.0f);
+				ImGui::SliderFloat("Shadow Strength", &worldEditorConfig.shadowStrength, 0.0f, 1.0f);
+			}
+			if (ImGui::CollapsingHeader("Selection")) {
+				ImGui::Text("shift + drag selects a rectangle, alt + drag a lasso. %d voxels selected", voxelSelection->selectedCount);
+				ImGui::RadioButton("Replace", &worldEditorConfig.selectionMode, (i32)VOXEL_SELECTION_REPLACE);
+				ImGui::SameLine();
+				ImGui::RadioButton("Add", &worldEditorConfig.selectionMode, (i32)VOXEL_SELECTION_ADD);
+				ImGui::SameLine();
+				ImGui::RadioButton("Remove", &worldEditorConfig.selectionMode, (i32)VOXEL_SELECTION_REMOVE);
+				if (voxelSelection->selectedCount > 0) {
+					if (ImGui::Button("Select Groups")) {
+						selectVoxelGroupsOfSelection(voxelSelection, &voxelArray, jobQueue);
+					}
+					ImGui::SameLine();
+					if (ImGui::Button("Clear Selection")) {
+						clearVoxelSelection(voxelSelection);
+					}
+					ImGui::InputInt3("Offset", worldEditorConfig.selectionOffset);
+					i32* o = worldEditorConfig.selectionOffset;
+					//recolors with the region color
+					if (ImGui::Button("Recolor")) {
+						f32* c = worldEditorConfig.regionColor;
+						beginEdit(editJournal, &voxelArray, 0);
+						recolorVoxelSelection(voxelSelection, &voxelArray, jobQueue, editJournal, RGBAColorF32{ c[0], c[2], c[1], c[3] });
+						endEdit(editJournal, &voxelArray);
+					}
+					ImGui::SameLine();
+					if (ImGui::Button("Translate Voxels")) {
+						beginEdit(editJournal, &voxelArray, 0);
+						translateVoxelSelection(voxelSelection, &voxelArray, jobQueue, editJournal, Vector3i{ o[0], o[1], o[2] });
+						endEdit(editJournal, &voxelArray);
+					}
+					ImGui::SameLine();
+					if (ImGui::Button("Move Groups")) {
+						beginEdit(editJournal, &voxelArray, 0);
+						moveVoxelSelectionGroups(voxelSelection, &voxelArray, editJournal, math::Vector3{ (f32)o[0], (f32)o[1], (f32)o[2] });
+						endEdit(editJournal, &voxelArray);
+					}
+				}
+			}
+			if (isLassoing) {
+				//imgui's y goes down
+				ImVec2 points[MAX_LASSO_POINTS + 1];
+				i32 pointsCount = lassoPointsCount;
+				for (i32 i = 0; i < lassoPointsCount; i++) {
+					points[i] = ImVec2(lassoPoints[i].x, (f32)windowHeight - lassoPoints[i].y);
+				}
+				if (isLassoRectangle) {
+					ImVec2 a = points[0];
+					ImVec2 b = points[1];
+					points[1] = ImVec2(b.x, a.y);
+					points[2] = b;
+					points[3] = ImVec2(a.x, b.y);
+					pointsCount = 4;
+				}
+				ImGui::GetForegroundDrawList()->AddPolyline(points, pointsCount, IM_COL32(0, 160, 255, 255), ImDrawFlags_Closed, 1.5f);
+			}
+			if (ImGui::Button("Undo")) {
+				isUndoRequested = 1;
+			}
+			ImGui::SameLine();
+			if (ImGui::Button("Redo")) {
+				isRedoRequested = 1;
+			}
+			ImGui::SameLine();
+			ImGui::Text(
+				"edits: %u of %u, %.2f MB in memory, %.2f MB spilled", editJournal->appliedEditsCount, editJournal->editsCount,
+				(f64)editJournal->memoryUsed / (1024.0 * 1024.0), (f64)editJournal->spilledBytes / (1024.0 * 1024.0)
+			);
+
             if (ImGui::Button("Button"))                            // Buttons return true when clicked (most widgets return true when edited/activated)
                 counter++;
             ImGui::SameLine();
@@ -576,14 +1190,21 @@ int main(void) {
         // Rendering
         ImGui::Render();
         ImDrawData* drawData = ImGui::GetDrawData();
+		u32 imguiGPUZone = beginGPUZone(renderer, frameCounter, "imgui");
 		ImGui_ImplVulkan_RenderDrawData(drawData, renderer->commandBuffers[frameCounter]);
+		endGPUZone(renderer, frameCounter, imguiGPUZone);
+		PROFILE_ZONE_END(imguiZone);
 
 		vkCmdEndRenderPass(renderer->commandBuffers[frameCounter]);
+		endGPUZone(renderer, frameCounter, renderPassGPUZone);
 
 		if (vkEndCommandBuffer(renderer->commandBuffers[frameCounter]) != VK_SUCCESS) {
 			printf("unable to record command buffer!\n");
 			return 1;
 		}
+		PROFILE_ZONE_END(commandRecordingZone);
+
+		PROFILE_ZONE_BEGIN(submitZone, "submit");
 
 		VkSubmitInfo submitInfo = {};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -601,6 +1222,9 @@ int main(void) {
 			printf("unable to submit to queue!\n");
 			return 1;
 		}
+		PROFILE_ZONE_END(submitZone);
+
+		PROFILE_ZONE_BEGIN(presentZone, "present");
 
 		VkPresentInfoKHR presentInfo = {};
 		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -612,6 +1236,7 @@ int main(void) {
 		presentInfo.pResults = nil;
 
 		result = vkQueuePresentKHR(renderer->presentQueue, &presentInfo);
+		PROFILE_ZONE_END(presentZone);
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR) {
 			result = handleRenderResizing(renderer);
 			if (result != VK_SUCCESS) {
@@ -624,6 +1249,17 @@ int main(void) {
 
 	vkDeviceWaitIdle(renderer->device);
 
+	finishWorldStreaming(worldStreamer);
+	if (!saveWorld(world)) {
+		printf("unable to save the world to %s\n", WORLD_FILE_PATH);
+	}
+	closeWorld(world);
+	destroyEditJournal(editJournal);
+
+	if (!savePipelineCache(renderer)) {
+		printf("unable to save the pipeline cache. the next launch will compile every pipeline again\n");
+	}
+
 	glfwTerminate();
 	return 0;
 }
@@ -384,6 +384,30 @@ namespace math {
 		return m;
 	}
 
+	Quaternion createQuaternionFromRotationMatrix(Matrix4 m) {
+		Quaternion q;
+		f32 trace = m.e.m00 + m.e.m11 + m.e.m22;
+		//divides by the largest of the four components to keep precision
+		if (trace > 0.0f) {
+			f32 s = 2.0f * sqrtf(trace + 1.0f);
+			q.real = 0.25f * s;
+			q.vector = Vector3{ (m.e.m21 - m.e.m12) / s, (m.e.m02 - m.e.m20) / s, (m.e.m10 - m.e.m01) / s };
+		} else if (m.e.m00 > m.e.m11 && m.e.m00 > m.e.m22) {
+			f32 s = 2.0f * sqrtf(1.0f + m.e.m00 - m.e.m11 - m.e.m22);
+			q.real = (m.e.m21 - m.e.m12) / s;
+			q.vector = Vector3{ 0.25f * s, (m.e.m01 + m.e.m10) / s, (m.e.m02 + m.e.m20) / s };
+		} else if (m.e.m11 > m.e.m22) {
+			f32 s = 2.0f * sqrtf(1.0f + m.e.m11 - m.e.m00 - m.e.m22);
+			q.real = (m.e.m02 - m.e.m20) / s;
+			q.vector = Vector3{ (m.e.m01 + m.e.m10) / s, 0.25f * s, (m.e.m12 + m.e.m21) / s };
+		} else {
+			f32 s = 2.0f * sqrtf(1.0f + m.e.m22 - m.e.m00 - m.e.m11);
+			q.real = (m.e.m10 - m.e.m01) / s;
+			q.vector = Vector3{ (m.e.m02 + m.e.m20) / s, (m.e.m12 + m.e.m21) / s, 0.25f * s };
+		}
+		return normalizeQuaternion(q);
+	}
+
 	bool32 isWithinTolerance(f32 got, f32 want, f32 tolerance) {
 		return got - tolerance <= want && got + tolerance >= want;
 	}
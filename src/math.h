@@ -27,6 +27,10 @@ namespace math {
 		Vector3 project(Vector3 onto);
 	};
 
+	struct Vector2 {
+		f32 x, y;
+	};
+
 	struct Vector4 {
 		f32 x, y, z, w;
 	};
@@ -81,6 +85,8 @@ namespace math {
 	Quaternion normalizeQuaternion(Quaternion q);
 	Vector3 rotateVector(Vector3 a, Quaternion q);
 	Matrix4 createRotationMatrix(Quaternion q);
+	//the inverse of createRotationMatrix. only the upper 3x3 is read, and it must be a rotation
+	Quaternion createQuaternionFromRotationMatrix(Matrix4 m);
 	Quaternion createQuaternionRotation(f32 angle, math::Vector3 axis);
 	Quaternion multiplyQuaternions(Quaternion a, Quaternion b);
 	Quaternion convertEulerAnglesToQuaternionRotation(math::Vector3 euler);
@@ -1,7 +1,6 @@
 #include "memory.h"
 
 void initMemoryAllocator(MemoryAllocator *allocator, u64 capacity) {
-	(u8*) malloc(capacity);
 	allocator->memory = (u8*) malloc(capacity);
 	allocator->byteOffset = 0;
 	allocator->byteCapacity = capacity;
@@ -9,8 +8,10 @@ void initMemoryAllocator(MemoryAllocator *allocator, u64 capacity) {
 }
 
 void* allocateMemory(MemoryAllocator *allocator, u64 byteAllocation) {
-	_assert(allocator->byteOffset + byteAllocation <= allocator->byteCapacity);
-	void* ptr = (void*)(allocator->memory + allocator->byteOffset + byteAllocation);
-	allocator->byteOffset += byteAllocation;
+	//keep every allocation aligned for simd loads of vectors and matrices
+	u64 alignedOffset = (allocator->byteOffset + 15) & ~15ull;
+	_assert(alignedOffset + byteAllocation <= allocator->byteCapacity);
+	void* ptr = (void*)(allocator->memory + alignedOffset);
+	allocator->byteOffset = alignedOffset + byteAllocation;
 	return ptr;
 }
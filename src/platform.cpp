@@ -0,0 +1,329 @@
+#include "platform.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <intrin.h>
+#include <io.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <stdlib.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#endif
+
+u64 readCPUTimestamp() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (u64)t.tv_sec * 1000000000ull + (u64)t.tv_nsec;
+#endif
+}
+
+f64 getWallClockSeconds() {
+#ifdef _WIN32
+	static f64 secondsPerCount = 0.0;
+	if (secondsPerCount == 0.0) {
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		secondsPerCount = 1.0 / (f64)frequency.QuadPart;
+	}
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+	return (f64)counter.QuadPart * secondsPerCount;
+#else
+	timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (f64)t.tv_sec + (f64)t.tv_nsec * 1e-9;
+#endif
+}
+
+u32 getCurrentThreadId() {
+#ifdef _WIN32
+	return (u32)GetCurrentThreadId();
+#else
+	return (u32)syscall(SYS_gettid);
+#endif
+}
+
+u32 atomicIncrementU32(volatile u32* value) {
+#ifdef _MSC_VER
+	return (u32)_InterlockedIncrement((volatile long*)value);
+#else
+	return __atomic_add_fetch(value, 1, __ATOMIC_SEQ_CST);
+#endif
+}
+
+u64 atomicAddU64(volatile u64* value, u64 addend) {
+#ifdef _MSC_VER
+	return (u64)_InterlockedExchangeAdd64((volatile long long*)value, (long long)addend) + addend;
+#else
+	return __atomic_add_fetch(value, addend, __ATOMIC_SEQ_CST);
+#endif
+}
+
+u32 atomicLoadU32(volatile u32* value) {
+#ifdef _MSC_VER
+	u32 result = *value;
+	_ReadWriteBarrier();
+	return result;
+#else
+	return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#endif
+}
+
+void atomicStoreU32(volatile u32* value, u32 newValue) {
+#ifdef _MSC_VER
+	_InterlockedExchange((volatile long*)value, (long)newValue);
+#else
+	__atomic_store_n(value, newValue, __ATOMIC_RELEASE);
+#endif
+}
+
+u32 atomicCompareExchangeU32(volatile u32* value, u32 expected, u32 desired) {
+#ifdef _MSC_VER
+	return (u32)_InterlockedCompareExchange((volatile long*)value, (long)desired, (long)expected);
+#else
+	__atomic_compare_exchange_n(value, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	return expected;
+#endif
+}
+
+u32 getLogicalProcessorCount() {
+#ifdef _WIN32
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	return (u32)systemInfo.dwNumberOfProcessors;
+#else
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? (u32)count : 1;
+#endif
+}
+
+struct ThreadStartInfo {
+	ThreadFunction function;
+	void* data;
+};
+
+#ifdef _WIN32
+static DWORD WINAPI runThread(LPVOID parameter) {
+#else
+static void* runThread(void* parameter) {
+#endif
+	ThreadStartInfo info = *(ThreadStartInfo*)parameter;
+	free(parameter);
+	info.function(info.data);
+	return 0;
+}
+
+bool32 createThread(ThreadFunction function, void* data) {
+	ThreadStartInfo* info = (ThreadStartInfo*)malloc(sizeof(ThreadStartInfo));
+	info->function = function;
+	info->data = data;
+#ifdef _WIN32
+	HANDLE thread = CreateThread(nil, 0, runThread, info, 0, nil);
+	if (thread == nil) {
+		free(info);
+		return 0;
+	}
+	CloseHandle(thread);
+#else
+	pthread_t thread;
+	if (pthread_create(&thread, nil, runThread, info) != 0) {
+		free(info);
+		return 0;
+	}
+	pthread_detach(thread);
+#endif
+	return 1;
+}
+
+void sleepMilliseconds(u32 milliseconds) {
+#ifdef _WIN32
+	Sleep(milliseconds);
+#else
+	usleep(milliseconds * 1000);
+#endif
+}
+
+PlatformSemaphore createSemaphore(u32 initialCount) {
+	PlatformSemaphore semaphore = {};
+#ifdef _WIN32
+	semaphore.handle = CreateSemaphoreEx(nil, initialCount, LONG_MAX, nil, 0, SEMAPHORE_ALL_ACCESS);
+#else
+	sem_t* s = (sem_t*)malloc(sizeof(sem_t));
+	sem_init(s, 0, initialCount);
+	semaphore.handle = s;
+#endif
+	return semaphore;
+}
+
+void signalSemaphore(PlatformSemaphore semaphore, u32 count) {
+#ifdef _WIN32
+	ReleaseSemaphore((HANDLE)semaphore.handle, count, nil);
+#else
+	for (u32 i = 0; i < count; i++) {
+		sem_post((sem_t*)semaphore.handle);
+	}
+#endif
+}
+
+void waitForSemaphore(PlatformSemaphore semaphore) {
+#ifdef _WIN32
+	WaitForSingleObjectEx((HANDLE)semaphore.handle, INFINITE, FALSE);
+#else
+	while (sem_wait((sem_t*)semaphore.handle) != 0) {
+	}
+#endif
+}
+
+void destroySemaphore(PlatformSemaphore semaphore) {
+#ifdef _WIN32
+	CloseHandle((HANDLE)semaphore.handle);
+#else
+	sem_destroy((sem_t*)semaphore.handle);
+	free(semaphore.handle);
+#endif
+}
+
+bool32 mapFile(const char* filepath, MappedFile* file) {
+	*file = {};
+#ifdef _WIN32
+	//writes are shared so that the file can be appended to while it's mapped
+	HANDLE fileHandle = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nil, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nil);
+	if (fileHandle == INVALID_HANDLE_VALUE) {
+		return 0;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(fileHandle, &size) || size.QuadPart == 0) {
+		CloseHandle(fileHandle);
+		return 0;
+	}
+	HANDLE mappingHandle = CreateFileMappingA(fileHandle, nil, PAGE_READONLY, 0, 0, nil);
+	if (mappingHandle == nil) {
+		CloseHandle(fileHandle);
+		return 0;
+	}
+	void* data = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (data == nil) {
+		CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+		return 0;
+	}
+	file->data = (u8*)data;
+	file->size = (u64)size.QuadPart;
+	file->fileHandle = fileHandle;
+	file->mappingHandle = mappingHandle;
+#else
+	int descriptor = open(filepath, O_RDONLY);
+	if (descriptor < 0) {
+		return 0;
+	}
+	struct stat status;
+	if (fstat(descriptor, &status) != 0 || status.st_size == 0) {
+		close(descriptor);
+		return 0;
+	}
+	void* data = mmap(nil, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	//the mapping keeps the file alive on its own
+	close(descriptor);
+	if (data == MAP_FAILED) {
+		return 0;
+	}
+	file->data = (u8*)data;
+	file->size = (u64)status.st_size;
+#endif
+	return 1;
+}
+
+void unmapFile(MappedFile* file) {
+	if (file->data == nil) {
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(file->data);
+	CloseHandle((HANDLE)file->mappingHandle);
+	CloseHandle((HANDLE)file->fileHandle);
+#else
+	munmap(file->data, file->size);
+#endif
+	*file = {};
+}
+
+void discardMemoryPages(void* memory, u64 size) {
+	static u64 pageSize = 0;
+	if (pageSize == 0) {
+#ifdef _WIN32
+		SYSTEM_INFO systemInfo;
+		GetSystemInfo(&systemInfo);
+		pageSize = systemInfo.dwPageSize;
+#else
+		pageSize = (u64)sysconf(_SC_PAGESIZE);
+#endif
+	}
+	u64 begin = ((u64)memory + pageSize - 1) / pageSize * pageSize;
+	u64 end = ((u64)memory + size) / pageSize * pageSize;
+	if (begin >= end) {
+		return;
+	}
+#ifdef _WIN32
+	VirtualAlloc((void*)begin, end - begin, MEM_RESET, PAGE_READWRITE);
+#else
+	madvise((void*)begin, end - begin, MADV_DONTNEED);
+#endif
+}
+
+bool32 getFileInfo(const char* filepath, u64* size, u64* modificationTime) {
+#ifdef _WIN32
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(filepath, GetFileExInfoStandard, &attributes)) {
+		return 0;
+	}
+	*size = ((u64)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+	*modificationTime = ((u64)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+#else
+	struct stat status;
+	if (stat(filepath, &status) != 0) {
+		return 0;
+	}
+	*size = (u64)status.st_size;
+	*modificationTime = (u64)status.st_mtime;
+#endif
+	return 1;
+}
+
+bool32 seekFile(FILE* file, u64 offset) {
+#ifdef _WIN32
+	return _fseeki64(file, (__int64)offset, SEEK_SET) == 0;
+#else
+	return fseeko(file, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+bool32 flushFileToDisk(FILE* file) {
+	if (fflush(file) != 0) {
+		return 0;
+	}
+#ifdef _WIN32
+	return _commit(_fileno(file)) == 0;
+#else
+	return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool32 replaceFile(const char* sourcePath, const char* destinationPath) {
+#ifdef _WIN32
+	return MoveFileExA(sourcePath, destinationPath, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+	return rename(sourcePath, destinationPath) == 0;
+#endif
+}
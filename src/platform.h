@@ -0,0 +1,60 @@
+#pragma once
+#ifndef VOXELS_GAME_PLATFORM_H
+#define VOXELS_GAME_PLATFORM_H
+
+#include "common.h"
+#include <stdio.h>
+
+//raw cpu timestamp counter. falls back to a nanosecond clock when rdtsc is not available
+u64 readCPUTimestamp();
+f64 getWallClockSeconds();
+u32 getCurrentThreadId();
+
+u32 atomicIncrementU32(volatile u32* value);
+u64 atomicAddU64(volatile u64* value, u64 addend);
+u32 atomicLoadU32(volatile u32* value);
+void atomicStoreU32(volatile u32* value, u32 newValue);
+//returns the value that was stored before the exchange
+u32 atomicCompareExchangeU32(volatile u32* value, u32 expected, u32 desired);
+
+u32 getLogicalProcessorCount();
+
+typedef void (*ThreadFunction)(void* data);
+//the thread runs detached until the process exits. returns 0 if it couldn't be created
+bool32 createThread(ThreadFunction function, void* data);
+void sleepMilliseconds(u32 milliseconds);
+
+//counting semaphore. the handle is owned by the platform layer
+struct PlatformSemaphore {
+	void* handle;
+};
+PlatformSemaphore createSemaphore(u32 initialCount);
+void signalSemaphore(PlatformSemaphore semaphore, u32 count);
+void waitForSemaphore(PlatformSemaphore semaphore);
+//no thread may be waiting on it anymore
+void destroySemaphore(PlatformSemaphore semaphore);
+
+//a whole file mapped read only into the address space. the handles are owned by the platform layer
+struct MappedFile {
+	u8* data;
+	u64 size;
+	void* fileHandle;
+	void* mappingHandle;
+};
+//returns 0 if the file doesn't exist, is empty or couldn't be mapped
+bool32 mapFile(const char* filepath, MappedFile* file);
+void unmapFile(MappedFile* file);
+
+//lets the os take back the physical pages that lie entirely inside the range. their contents are undefined until they are written again
+void discardMemoryPages(void* memory, u64 size);
+
+//returns 0 if the file doesn't exist. the modification time is only good for comparing against another one from the same machine
+bool32 getFileInfo(const char* filepath, u64* size, u64* modificationTime);
+//64 bit offsets, unlike fseek on windows
+bool32 seekFile(FILE* file, u64 offset);
+//flushes the stdio buffer and waits until the os has written the file to the disk
+bool32 flushFileToDisk(FILE* file);
+//renames the file over destinationPath, replacing it if it exists
+bool32 replaceFile(const char* sourcePath, const char* destinationPath);
+
+#endif
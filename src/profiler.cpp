@@ -0,0 +1,210 @@
+#include "profiler.h"
+#include "platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+Profiler globalProfiler;
+
+static thread_local ProfilerThreadBuffer* threadProfilerBuffer = nil;
+
+void initProfiler() {
+	memset(&globalProfiler, 0, sizeof(globalProfiler));
+	globalProfiler.calibrationTimestamp = readCPUTimestamp();
+	globalProfiler.calibrationSeconds = getWallClockSeconds();
+	globalProfiler.isRecording = 1;
+}
+
+static ProfilerThreadBuffer* getProfilerThreadBuffer() {
+	if (threadProfilerBuffer == nil) {
+		u32 index = atomicIncrementU32(&globalProfiler.threadBuffersCount) - 1;
+		if (index >= PROFILER_MAX_THREADS) {
+			return nil;
+		}
+		ProfilerThreadBuffer* buffer = &globalProfiler.threadBuffers[index];
+		buffer->threadId = getCurrentThreadId();
+		buffer->depth = 0;
+		buffer->events = (ProfilerEvent*) malloc(PROFILER_EVENTS_PER_THREAD * sizeof(ProfilerEvent));
+		_assert(buffer->events != nil);
+		threadProfilerBuffer = buffer;
+	}
+	return threadProfilerBuffer;
+}
+
+void setProfilerThreadName(const char* name) {
+	ProfilerThreadBuffer* buffer = getProfilerThreadBuffer();
+	if (buffer != nil) {
+		buffer->threadName = name;
+	}
+}
+
+void beginProfilerFrame() {
+	if (!globalProfiler.isRecording) {
+		return;
+	}
+	globalProfiler.frameBeginTimestamps[globalProfiler.framesCount % PROFILER_FRAME_HISTORY] = readCPUTimestamp();
+	globalProfiler.framesCount += 1;
+}
+
+u64 getProfilerFrameNumber() {
+	return globalProfiler.framesCount > 0 ? globalProfiler.framesCount - 1 : 0;
+}
+
+u64 beginProfilerZone() {
+	ProfilerThreadBuffer* buffer = getProfilerThreadBuffer();
+	if (buffer != nil) {
+		buffer->depth += 1;
+	}
+	return readCPUTimestamp();
+}
+
+void endProfilerZone(const char* name, u64 beginTimestamp) {
+	u64 endTimestamp = readCPUTimestamp();
+	ProfilerThreadBuffer* buffer = threadProfilerBuffer;
+	if (buffer == nil) {
+		return;
+	}
+	buffer->depth -= 1;
+	if (!globalProfiler.isRecording) {
+		return;
+	}
+
+	u32 writeIndex = buffer->writeIndex;
+	ProfilerEvent* e = &buffer->events[writeIndex % PROFILER_EVENTS_PER_THREAD];
+	e->name = name;
+	e->beginTimestamp = beginTimestamp;
+	e->endTimestamp = endTimestamp;
+	e->depth = buffer->depth;
+	//publish after the event is written so that readers on other threads never see a half written event
+	atomicStoreU32(&buffer->writeIndex, writeIndex + 1);
+}
+
+void submitProfilerGPUZones(u64 frameNumber, ProfilerGPUZone* zones, u32 zonesCount) {
+	if (!globalProfiler.isRecording) {
+		return;
+	}
+	ProfilerGPUFrame* gpuFrame = &globalProfiler.gpuFrames[frameNumber % PROFILER_FRAME_HISTORY];
+	gpuFrame->frameNumber = frameNumber;
+	gpuFrame->zonesCount = MIN(zonesCount, PROFILER_MAX_GPU_ZONES);
+	memcpy(gpuFrame->zones, zones, gpuFrame->zonesCount * sizeof(ProfilerGPUZone));
+}
+
+f64 getProfilerTicksPerSecond() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+	//the tsc frequency is measured against the wall clock over the whole lifetime of the profiler, so it gets more precise over time without a calibration stall at startup
+	f64 elapsedSeconds = getWallClockSeconds() - globalProfiler.calibrationSeconds;
+	u64 elapsedTicks = readCPUTimestamp() - globalProfiler.calibrationTimestamp;
+	if (elapsedSeconds < 0.001 || elapsedTicks == 0) {
+		return 1.0e9;
+	}
+	return (f64)elapsedTicks / elapsedSeconds;
+#else
+	return 1.0e9;
+#endif
+}
+
+static void writeJSONString(FILE* file, const char* s) {
+	fputc('"', file);
+	for (const char* c = s; *c; c++) {
+		if (*c == '"' || *c == '\\') {
+			fputc('\\', file);
+		}
+		fputc(*c, file);
+	}
+	fputc('"', file);
+}
+
+//writes every zone still held in the ring buffers in the chrome trace_event format. open it in chrome://tracing or ui.perfetto.dev
+bool32 writeProfilerChromeTrace(const char* filepath) {
+	FILE* file = fopen(filepath, "wb");
+	if (file == nil) {
+		printf("unable to open %s for writing the profiler trace\n", filepath);
+		return 0;
+	}
+
+	f64 microsecondsPerTick = 1.0e6 / getProfilerTicksPerSecond();
+	u64 baseTimestamp = globalProfiler.calibrationTimestamp;
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool32 isFirstEvent = 1;
+
+	u32 threadBuffersCount = MIN(atomicLoadU32(&globalProfiler.threadBuffersCount), PROFILER_MAX_THREADS);
+	for (u32 i = 0; i < threadBuffersCount; i++) {
+		ProfilerThreadBuffer* buffer = &globalProfiler.threadBuffers[i];
+		if (buffer->events == nil) {
+			continue;
+		}
+
+		if (buffer->threadName != nil) {
+			fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":", isFirstEvent ? "" : ",\n", buffer->threadId);
+			writeJSONString(file, buffer->threadName);
+			fprintf(file, "}}");
+			isFirstEvent = 0;
+		}
+
+		u32 writeIndex = atomicLoadU32(&buffer->writeIndex);
+		u32 firstIndex = writeIndex > PROFILER_EVENTS_PER_THREAD ? writeIndex - PROFILER_EVENTS_PER_THREAD : 0;
+		for (u32 j = firstIndex; j < writeIndex; j++) {
+			ProfilerEvent e = buffer->events[j % PROFILER_EVENTS_PER_THREAD];
+			if (e.beginTimestamp < baseTimestamp) {
+				continue;
+			}
+			fprintf(file, "%s{\"name\":", isFirstEvent ? "" : ",\n");
+			writeJSONString(file, e.name);
+			fprintf(file, ",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+				buffer->threadId,
+				(f64)(e.beginTimestamp - baseTimestamp) * microsecondsPerTick,
+				(f64)(e.endTimestamp - e.beginTimestamp) * microsecondsPerTick
+			);
+			isFirstEvent = 0;
+		}
+	}
+
+	//gpu zones are placed at the start of the cpu frame that recorded them, since the two clocks are not calibrated against each other
+	u64 historyCount = MIN(globalProfiler.framesCount, (u64)PROFILER_FRAME_HISTORY);
+	for (u64 f = globalProfiler.framesCount - historyCount; f < globalProfiler.framesCount; f++) {
+		ProfilerGPUFrame* gpuFrame = &globalProfiler.gpuFrames[f % PROFILER_FRAME_HISTORY];
+		u64 frameBeginTimestamp = globalProfiler.frameBeginTimestamps[f % PROFILER_FRAME_HISTORY];
+		if (gpuFrame->frameNumber != f || gpuFrame->zonesCount == 0 || frameBeginTimestamp < baseTimestamp) {
+			continue;
+		}
+		f64 frameBeginMicroseconds = (f64)(frameBeginTimestamp - baseTimestamp) * microsecondsPerTick;
+		for (u32 i = 0; i < gpuFrame->zonesCount; i++) {
+			ProfilerGPUZone* zone = &gpuFrame->zones[i];
+			fprintf(file, "%s{\"name\":", isFirstEvent ? "" : ",\n");
+			writeJSONString(file, zone->name);
+			fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":%.3f,\"dur\":%.3f}",
+				frameBeginMicroseconds + zone->beginMilliseconds * 1000.0,
+				(zone->endMilliseconds - zone->beginMilliseconds) * 1000.0
+			);
+			isFirstEvent = 0;
+		}
+	}
+	fprintf(file, "%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"GPU\"}}", isFirstEvent ? "" : ",\n");
+
+	fprintf(file, "\n]}\n");
+	bool32 success = ferror(file) == 0;
+	fclose(file);
+	if (success) {
+		printf("wrote profiler trace to %s\n", filepath);
+	}
+	return success;
+}
+
+ProfileZone::ProfileZone(const char* zoneName) {
+	name = zoneName;
+	isEnded = 0;
+	beginTimestamp = beginProfilerZone();
+}
+
+ProfileZone::~ProfileZone() {
+	end();
+}
+
+void ProfileZone::end() {
+	if (!isEnded) {
+		endProfilerZone(name, beginTimestamp);
+		isEnded = 1;
+	}
+}
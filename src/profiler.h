@@ -0,0 +1,106 @@
+#pragma once
+#ifndef VOXELS_GAME_PROFILER_H
+#define VOXELS_GAME_PROFILER_H
+
+#include "common.h"
+
+const u32 PROFILER_MAX_THREADS = 32;
+//per thread ring buffer of completed zones. older zones are overwritten
+const u32 PROFILER_EVENTS_PER_THREAD = 1 << 16;
+const u32 PROFILER_FRAME_HISTORY = 256;
+const u32 PROFILER_MAX_GPU_ZONES = 16;
+
+struct ProfilerEvent {
+	const char* name;
+	u64 beginTimestamp;
+	u64 endTimestamp;
+	u32 depth;
+};
+
+struct ProfilerThreadBuffer {
+	const char* threadName;
+	u32 threadId;
+	u32 depth;
+	//total amount of events ever written. the ring index is writeIndex % PROFILER_EVENTS_PER_THREAD
+	volatile u32 writeIndex;
+	ProfilerEvent* events;
+};
+
+//gpu timestamps are in their own clock domain, so gpu zones are stored relative to the first timestamp of their frame
+struct ProfilerGPUZone {
+	const char* name;
+	f64 beginMilliseconds;
+	f64 endMilliseconds;
+	u32 depth;
+};
+
+struct ProfilerGPUFrame {
+	//the cpu frame that recorded the gpu work
+	u64 frameNumber;
+	u32 zonesCount;
+	ProfilerGPUZone zones[PROFILER_MAX_GPU_ZONES];
+};
+
+struct Profiler {
+	bool32 isRecording;
+
+	u64 calibrationTimestamp;
+	f64 calibrationSeconds;
+
+	volatile u32 threadBuffersCount;
+	ProfilerThreadBuffer threadBuffers[PROFILER_MAX_THREADS];
+
+	//total amount of frames ever started. frame n started at frameBeginTimestamps[n % PROFILER_FRAME_HISTORY]
+	u64 framesCount;
+	u64 frameBeginTimestamps[PROFILER_FRAME_HISTORY];
+
+	//gpu results arrive a few frames late. the gpu zones of frame n are stored in gpuFrames[n % PROFILER_FRAME_HISTORY]
+	ProfilerGPUFrame gpuFrames[PROFILER_FRAME_HISTORY];
+};
+
+extern Profiler globalProfiler;
+
+void initProfiler();
+//names the calling thread in the flame graph and chrome traces. the string must outlive the profiler
+void setProfilerThreadName(const char* name);
+//marks the start of a new frame. zones are grouped into frames for the flame graph
+void beginProfilerFrame();
+//the number of the frame currently being recorded
+u64 getProfilerFrameNumber();
+u64 beginProfilerZone();
+void endProfilerZone(const char* name, u64 beginTimestamp);
+void submitProfilerGPUZones(u64 frameNumber, ProfilerGPUZone* zones, u32 zonesCount);
+f64 getProfilerTicksPerSecond();
+bool32 writeProfilerChromeTrace(const char* filepath);
+
+//implemented in profiler_ui.cpp since it depends on imgui
+void drawProfilerWindow(bool* isOpen);
+
+struct ProfileZone {
+	const char* name;
+	u64 beginTimestamp;
+	bool32 isEnded;
+
+	ProfileZone(const char* zoneName);
+	~ProfileZone();
+	//ends the zone before the end of its scope
+	void end();
+};
+
+#define PROFILER_CONCAT_INTERNAL(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INTERNAL(a, b)
+
+#ifndef VOXELS_DISABLE_PROFILER
+#define PROFILE_ZONE(name) ProfileZone PROFILER_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_ZONE(__FUNCTION__)
+//for stages that declare variables used after the stage, so they can't be wrapped in their own scope
+#define PROFILE_ZONE_BEGIN(zone, name) ProfileZone zone(name)
+#define PROFILE_ZONE_END(zone) zone.end()
+#else
+#define PROFILE_ZONE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_ZONE_BEGIN(zone, name)
+#define PROFILE_ZONE_END(zone)
+#endif
+
+#endif
@@ -0,0 +1,204 @@
+#include "profiler.h"
+#include "platform.h"
+
+#define IMGUI_DISABLE_OBSOLETE_FUNCTIONS
+#include <imgui/imgui.h>
+
+static ImU32 getProfilerZoneColor(const char* name) {
+	u32 hash = 2166136261u;
+	for (const char* c = name; *c; c++) {
+		hash = (hash ^ (u8)*c) * 16777619u;
+	}
+	f32 hue = (f32)(hash % 360) / 360.0f;
+	return ImColor::HSV(hue, 0.55f, 0.8f);
+}
+
+//fractions are relative to the start and end of the frame
+static void drawProfilerZoneRect(ImDrawList* drawList, ImVec2 origin, f32 width, f32 rowHeight, f64 beginFraction, f64 endFraction, f64 milliseconds, const char* name, u32 depth) {
+	beginFraction = MAX(beginFraction, 0.0);
+	endFraction = MIN(endFraction, 1.0);
+	f32 x0 = origin.x + width * (f32)beginFraction;
+	f32 x1 = origin.x + width * (f32)endFraction;
+	if (x1 - x0 < 1.0f) {
+		x1 = x0 + 1.0f;
+	}
+	f32 y0 = origin.y + rowHeight * depth;
+	f32 y1 = y0 + rowHeight - 1.0f;
+
+	drawList->AddRectFilled(ImVec2(x0, y0), ImVec2(x1, y1), getProfilerZoneColor(name));
+
+	ImVec2 textSize = ImGui::CalcTextSize(name);
+	if (textSize.x + 4.0f < x1 - x0) {
+		drawList->PushClipRect(ImVec2(x0, y0), ImVec2(x1, y1), true);
+		drawList->AddText(ImVec2(x0 + 2.0f, y0 + 1.0f), IM_COL32(0, 0, 0, 255), name);
+		drawList->PopClipRect();
+	}
+
+	if (ImGui::IsMouseHoveringRect(ImVec2(x0, y0), ImVec2(x1, y1))) {
+		ImGui::SetTooltip("%s\n%.3f ms", name, milliseconds);
+	}
+}
+
+void drawProfilerWindow(bool* isOpen) {
+	static u64 selectedFrame = 0;
+	static bool isFollowingLatestFrame = true;
+
+	if (!ImGui::Begin("Profiler", isOpen)) {
+		ImGui::End();
+		return;
+	}
+
+	bool isRecording = globalProfiler.isRecording != 0;
+	if (ImGui::Checkbox("Record", &isRecording)) {
+		globalProfiler.isRecording = isRecording;
+	}
+	ImGui::SameLine();
+	ImGui::Checkbox("Follow Latest Frame", &isFollowingLatestFrame);
+	ImGui::SameLine();
+	if (ImGui::Button("Export Chrome Trace")) {
+		writeProfilerChromeTrace("profile_trace.json");
+	}
+
+	f64 millisecondsPerTick = 1000.0 / getProfilerTicksPerSecond();
+
+	//the newest frame is still in progress, so only the ones before it can be shown
+	u64 completeFramesCount = globalProfiler.framesCount > 0 ? globalProfiler.framesCount - 1 : 0;
+	u64 historyCount = MIN(completeFramesCount, (u64)PROFILER_FRAME_HISTORY - 1);
+	if (historyCount == 0) {
+		ImGui::Text("waiting for frames...");
+		ImGui::End();
+		return;
+	}
+	u64 firstHistoryFrame = completeFramesCount - historyCount;
+
+	if (isFollowingLatestFrame || selectedFrame < firstHistoryFrame || selectedFrame >= completeFramesCount) {
+		selectedFrame = completeFramesCount - 1;
+	}
+
+	u64 worstFrame = firstHistoryFrame;
+	f64 worstFrameMilliseconds = 0.0;
+	for (u64 f = firstHistoryFrame; f < completeFramesCount; f++) {
+		u64 begin = globalProfiler.frameBeginTimestamps[f % PROFILER_FRAME_HISTORY];
+		u64 end = globalProfiler.frameBeginTimestamps[(f + 1) % PROFILER_FRAME_HISTORY];
+		f64 milliseconds = (f64)(end - begin) * millisecondsPerTick;
+		if (milliseconds > worstFrameMilliseconds) {
+			worstFrameMilliseconds = milliseconds;
+			worstFrame = f;
+		}
+	}
+
+	u64 selectedFrameBegin = globalProfiler.frameBeginTimestamps[selectedFrame % PROFILER_FRAME_HISTORY];
+	u64 selectedFrameEnd = globalProfiler.frameBeginTimestamps[(selectedFrame + 1) % PROFILER_FRAME_HISTORY];
+	ImGui::Text("frame %llu: %.3f ms. worst of the last %llu frames: %.3f ms", (unsigned long long)selectedFrame, (f64)(selectedFrameEnd - selectedFrameBegin) * millisecondsPerTick, (unsigned long long)historyCount, worstFrameMilliseconds);
+	ImGui::SameLine();
+	if (ImGui::SmallButton("Select Worst")) {
+		selectedFrame = worstFrame;
+		isFollowingLatestFrame = false;
+	}
+
+	//frame time history. clicking a bar selects that frame
+	{
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		ImVec2 origin = ImGui::GetCursorScreenPos();
+		f32 width = ImGui::GetContentRegionAvail().x;
+		f32 height = 60.0f;
+		ImGui::InvisibleButton("frame history", ImVec2(width, height));
+		bool isClicked = ImGui::IsItemClicked();
+
+		f32 barWidth = width / (f32)historyCount;
+		f64 scaleMilliseconds = MAX(worstFrameMilliseconds, 1000.0 / 60.0);
+		for (u64 f = firstHistoryFrame; f < completeFramesCount; f++) {
+			u64 begin = globalProfiler.frameBeginTimestamps[f % PROFILER_FRAME_HISTORY];
+			u64 end = globalProfiler.frameBeginTimestamps[(f + 1) % PROFILER_FRAME_HISTORY];
+			f64 milliseconds = (f64)(end - begin) * millisecondsPerTick;
+			f32 x0 = origin.x + barWidth * (f32)(f - firstHistoryFrame);
+			f32 barHeight = height * (f32)(milliseconds / scaleMilliseconds);
+			ImU32 color = f == selectedFrame ? IM_COL32(255, 200, 0, 255) : (milliseconds > 1000.0 / 60.0 ? IM_COL32(220, 80, 60, 255) : IM_COL32(90, 170, 90, 255));
+			drawList->AddRectFilled(ImVec2(x0, origin.y + height - barHeight), ImVec2(x0 + MAX(barWidth - 1.0f, 1.0f), origin.y + height), color);
+		}
+
+		if (isClicked) {
+			u64 clickedOffset = (u64)((ImGui::GetIO().MousePos.x - origin.x) / barWidth);
+			selectedFrame = firstHistoryFrame + MIN(clickedOffset, historyCount - 1);
+			isFollowingLatestFrame = false;
+		}
+	}
+
+	const f32 rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+	u32 threadBuffersCount = MIN(atomicLoadU32(&globalProfiler.threadBuffersCount), PROFILER_MAX_THREADS);
+	for (u32 i = 0; i < threadBuffersCount; i++) {
+		ProfilerThreadBuffer* buffer = &globalProfiler.threadBuffers[i];
+		if (buffer->events == nil) {
+			continue;
+		}
+
+		u32 writeIndex = atomicLoadU32(&buffer->writeIndex);
+		u32 firstIndex = writeIndex > PROFILER_EVENTS_PER_THREAD ? writeIndex - PROFILER_EVENTS_PER_THREAD : 0;
+
+		//events are written when they end, so walking backwards from the newest event can stop at the first one that ended before the frame
+		u32 maxDepth = 0;
+		u32 firstFrameEventIndex = writeIndex;
+		for (u32 j = writeIndex; j > firstIndex; j--) {
+			ProfilerEvent* e = &buffer->events[(j - 1) % PROFILER_EVENTS_PER_THREAD];
+			if (e->endTimestamp <= selectedFrameBegin) {
+				break;
+			}
+			firstFrameEventIndex = j - 1;
+			if (e->beginTimestamp < selectedFrameEnd) {
+				maxDepth = MAX(maxDepth, e->depth);
+			}
+		}
+		if (firstFrameEventIndex == writeIndex) {
+			continue;
+		}
+
+		if (buffer->threadName != nil) {
+			ImGui::Text("%s (thread %u)", buffer->threadName, buffer->threadId);
+		} else {
+			ImGui::Text("thread %u", buffer->threadId);
+		}
+
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		ImVec2 origin = ImGui::GetCursorScreenPos();
+		f32 width = ImGui::GetContentRegionAvail().x;
+		ImGui::Dummy(ImVec2(width, rowHeight * (maxDepth + 1)));
+
+		for (u32 j = firstFrameEventIndex; j < writeIndex; j++) {
+			ProfilerEvent e = buffer->events[j % PROFILER_EVENTS_PER_THREAD];
+			if (e.beginTimestamp >= selectedFrameEnd || e.endTimestamp <= selectedFrameBegin) {
+				continue;
+			}
+			f64 frameTicks = (f64)(selectedFrameEnd - selectedFrameBegin);
+			f64 beginFraction = ((f64)e.beginTimestamp - (f64)selectedFrameBegin) / frameTicks;
+			f64 endFraction = ((f64)e.endTimestamp - (f64)selectedFrameBegin) / frameTicks;
+			drawProfilerZoneRect(drawList, origin, width, rowHeight, beginFraction, endFraction, (f64)(e.endTimestamp - e.beginTimestamp) * millisecondsPerTick, e.name, e.depth);
+		}
+	}
+
+	//gpu zones are drawn on the same time scale as the cpu frame, starting at the first gpu timestamp of the frame
+	ProfilerGPUFrame* gpuFrame = &globalProfiler.gpuFrames[selectedFrame % PROFILER_FRAME_HISTORY];
+	if (gpuFrame->frameNumber == selectedFrame && gpuFrame->zonesCount > 0) {
+		u32 maxDepth = 0;
+		for (u32 i = 0; i < gpuFrame->zonesCount; i++) {
+			maxDepth = MAX(maxDepth, gpuFrame->zones[i].depth);
+		}
+
+		ImGui::Text("GPU");
+		ImDrawList* drawList = ImGui::GetWindowDrawList();
+		ImVec2 origin = ImGui::GetCursorScreenPos();
+		f32 width = ImGui::GetContentRegionAvail().x;
+		ImGui::Dummy(ImVec2(width, rowHeight * (maxDepth + 1)));
+
+		f64 frameMilliseconds = (f64)(selectedFrameEnd - selectedFrameBegin) * millisecondsPerTick;
+		for (u32 i = 0; i < gpuFrame->zonesCount; i++) {
+			ProfilerGPUZone* zone = &gpuFrame->zones[i];
+			drawProfilerZoneRect(drawList, origin, width, rowHeight, zone->beginMilliseconds / frameMilliseconds, zone->endMilliseconds / frameMilliseconds, zone->endMilliseconds - zone->beginMilliseconds, zone->name, zone->depth);
+		}
+		for (u32 i = 0; i < gpuFrame->zonesCount; i++) {
+			ProfilerGPUZone* zone = &gpuFrame->zones[i];
+			ImGui::Text("%*s%s: %.3f ms", zone->depth * 2, "", zone->name, zone->endMilliseconds - zone->beginMilliseconds);
+		}
+	}
+
+	ImGui::End();
+}
@@ -0,0 +1,273 @@
+#include "radix_sort.h"
+
+#include <string.h>
+
+const u32 RADIX_SORT_DIGIT_MASK = RADIX_SORT_DIGITS_COUNT - 1;
+
+//counts every digit of the keys [begin, end) in one read. counts has a row per byte of the keys
+static void countRadixDigits(const void* keys, u32 keyBytes, i32 begin, i32 end, u32 (*counts)[RADIX_SORT_DIGITS_COUNT]) {
+	if (keyBytes == 4) {
+		const u32* k = (const u32*)keys;
+		for (i32 i = begin; i < end; i++) {
+			u32 key = k[i];
+			counts[0][key & RADIX_SORT_DIGIT_MASK] += 1;
+			counts[1][(key >> 8) & RADIX_SORT_DIGIT_MASK] += 1;
+			counts[2][(key >> 16) & RADIX_SORT_DIGIT_MASK] += 1;
+			counts[3][key >> 24] += 1;
+		}
+	} else {
+		const u64* k = (const u64*)keys;
+		for (i32 i = begin; i < end; i++) {
+			u64 key = k[i];
+			for (u32 d = 0; d < 8; d++) {
+				counts[d][(key >> (8 * d)) & RADIX_SORT_DIGIT_MASK] += 1;
+			}
+		}
+	}
+}
+
+static void countRadixDigit(const void* keys, u32 keyBytes, i32 begin, i32 end, u32 shift, u32* counts) {
+	if (keyBytes == 4) {
+		const u32* k = (const u32*)keys;
+		for (i32 i = begin; i < end; i++) {
+			counts[(k[i] >> shift) & RADIX_SORT_DIGIT_MASK] += 1;
+		}
+	} else {
+		const u64* k = (const u64*)keys;
+		for (i32 i = begin; i < end; i++) {
+			counts[(k[i] >> shift) & RADIX_SORT_DIGIT_MASK] += 1;
+		}
+	}
+}
+
+//moves the keys [begin, end) and their values to the offsets of their digits, advancing them
+static void scatterRadixDigit(
+	const void* keys, const u32* values, void* sortedKeys, u32* sortedValues, u32 keyBytes, i32 begin, i32 end, u32 shift, u32* offsets
+) {
+	if (keyBytes == 4) {
+		const u32* k = (const u32*)keys;
+		u32* sorted = (u32*)sortedKeys;
+		if (values != nil) {
+			for (i32 i = begin; i < end; i++) {
+				u32 offset = offsets[(k[i] >> shift) & RADIX_SORT_DIGIT_MASK]++;
+				sorted[offset] = k[i];
+				sortedValues[offset] = values[i];
+			}
+		} else {
+			for (i32 i = begin; i < end; i++) {
+				sorted[offsets[(k[i] >> shift) & RADIX_SORT_DIGIT_MASK]++] = k[i];
+			}
+		}
+	} else {
+		const u64* k = (const u64*)keys;
+		u64* sorted = (u64*)sortedKeys;
+		if (values != nil) {
+			for (i32 i = begin; i < end; i++) {
+				u32 offset = offsets[(k[i] >> shift) & RADIX_SORT_DIGIT_MASK]++;
+				sorted[offset] = k[i];
+				sortedValues[offset] = values[i];
+			}
+		} else {
+			for (i32 i = begin; i < end; i++) {
+				sorted[offsets[(k[i] >> shift) & RADIX_SORT_DIGIT_MASK]++] = k[i];
+			}
+		}
+	}
+}
+
+static u32 getRadixDigit(const void* keys, u32 keyBytes, i32 index, u32 shift) {
+	u64 key = keyBytes == 4 ? ((const u32*)keys)[index] : ((const u64*)keys)[index];
+	return (u32)(key >> shift) & RADIX_SORT_DIGIT_MASK;
+}
+
+//the sorted keys and values end up in whichever array the last pass wrote to, so they are copied back if that's the scratch one
+static void finishRadixSort(void* keys, u32* values, void* sortedKeys, u32* sortedValues, i32 count, u32 keyBytes) {
+	if (sortedKeys != keys) {
+		memcpy(keys, sortedKeys, (u64)count * keyBytes);
+		if (values != nil) {
+			memcpy(values, sortedValues, (u64)count * sizeof(u32));
+		}
+	}
+}
+
+static void sortRadix(void* keys, u32* values, i32 count, u32 keyBytes, MemoryAllocator* scratch) {
+	if (count < 2) {
+		return;
+	}
+	u64 byteOffset = scratch->byteOffset;
+	void* from = keys;
+	u32* fromValues = values;
+	void* to = allocateMemory(scratch, (u64)count * keyBytes);
+	u32* toValues = values != nil ? (u32*) allocateMemory(scratch, (u64)count * sizeof(u32)) : nil;
+
+	u32 counts[8][RADIX_SORT_DIGITS_COUNT] = {};
+	countRadixDigits(keys, keyBytes, 0, count, counts);
+	for (u32 d = 0; d < keyBytes; d++) {
+		u32 shift = RADIX_SORT_DIGIT_BITS * d;
+		if (counts[d][getRadixDigit(keys, keyBytes, 0, shift)] == (u32)count) {
+			continue;
+		}
+		u32 offset = 0;
+		for (u32 v = 0; v < RADIX_SORT_DIGITS_COUNT; v++) {
+			u32 digitCount = counts[d][v];
+			counts[d][v] = offset;
+			offset += digitCount;
+		}
+		scatterRadixDigit(from, fromValues, to, toValues, keyBytes, 0, count, shift, counts[d]);
+		void* swap = from;
+		from = to;
+		to = swap;
+		u32* swapValues = fromValues;
+		fromValues = toValues;
+		toValues = swapValues;
+	}
+	finishRadixSort(keys, values, from, fromValues, count, keyBytes);
+	scratch->byteOffset = byteOffset;
+}
+
+void radixSort(u32* keys, u32* values, i32 count, MemoryAllocator* scratch) {
+	sortRadix(keys, values, count, 4, scratch);
+}
+
+void radixSort(u64* keys, u32* values, i32 count, MemoryAllocator* scratch) {
+	sortRadix(keys, values, count, 8, scratch);
+}
+
+struct RadixSortJob {
+	const void* keys;
+	const u32* values;
+	void* sortedKeys;
+	u32* sortedValues;
+	u32 keyBytes;
+	i32 begin;
+	i32 end;
+	u32 shift;
+	//a row per byte of the keys, counted from the keys before the first pass
+	u32 (*digitsCounts)[RADIX_SORT_DIGITS_COUNT];
+	//the counts of the pass' digit in the block, and then where the block's keys of each digit go
+	u32 offsets[RADIX_SORT_DIGITS_COUNT];
+};
+
+static void countRadixSortJobDigits(void* data) {
+	RadixSortJob* job = (RadixSortJob*)data;
+	countRadixDigits(job->keys, job->keyBytes, job->begin, job->end, job->digitsCounts);
+}
+
+static void countRadixSortJobDigit(void* data) {
+	RadixSortJob* job = (RadixSortJob*)data;
+	memset(job->offsets, 0, sizeof(job->offsets));
+	countRadixDigit(job->keys, job->keyBytes, job->begin, job->end, job->shift, job->offsets);
+}
+
+static void scatterRadixSortJob(void* data) {
+	RadixSortJob* job = (RadixSortJob*)data;
+	scatterRadixDigit(job->keys, job->values, job->sortedKeys, job->sortedValues, job->keyBytes, job->begin, job->end, job->shift, job->offsets);
+}
+
+static void sortRadixOnJobs(JobQueue* jobQueue, void* keys, u32* values, i32 count, u32 keyBytes, MemoryAllocator* scratch) {
+	i32 jobsCount = MIN(MAX_RADIX_SORT_JOBS, MIN((i32)jobQueue->threadsCount + 1, count / MIN_RADIX_SORT_JOB_KEYS));
+	if (jobsCount < 2) {
+		sortRadix(keys, values, count, keyBytes, scratch);
+		return;
+	}
+	u64 byteOffset = scratch->byteOffset;
+	void* from = keys;
+	u32* fromValues = values;
+	void* to = allocateMemory(scratch, (u64)count * keyBytes);
+	u32* toValues = values != nil ? (u32*) allocateMemory(scratch, (u64)count * sizeof(u32)) : nil;
+	RadixSortJob* jobs = (RadixSortJob*) allocateMemory(scratch, jobsCount * sizeof(RadixSortJob));
+	u32 (*digitsCounts)[RADIX_SORT_DIGITS_COUNT] = (u32 (*)[RADIX_SORT_DIGITS_COUNT]) allocateMemory(scratch, (u64)jobsCount * keyBytes * RADIX_SORT_DIGITS_COUNT * sizeof(u32));
+	memset(digitsCounts, 0, (u64)jobsCount * keyBytes * RADIX_SORT_DIGITS_COUNT * sizeof(u32));
+
+	i32 keysPerJob = (count + jobsCount - 1) / jobsCount;
+	for (i32 j = 0; j < jobsCount; j++) {
+		RadixSortJob* job = &jobs[j];
+		job->keyBytes = keyBytes;
+		job->begin = MIN(j * keysPerJob, count);
+		job->end = MIN(job->begin + keysPerJob, count);
+		job->keys = keys;
+		job->digitsCounts = &digitsCounts[j * keyBytes];
+		addJob(jobQueue, countRadixSortJobDigits, job);
+	}
+	waitForAllJobs(jobQueue);
+
+	//the counts of the whole array tell which digits are the same for every key. the first pass that runs can use the blocks' counts
+	//as they are, since the keys haven't moved yet
+	bool32 hasMoved = 0;
+	for (u32 d = 0; d < keyBytes; d++) {
+		u32 shift = RADIX_SORT_DIGIT_BITS * d;
+		u32 firstDigit = getRadixDigit(keys, keyBytes, 0, shift);
+		u32 firstDigitCount = 0;
+		for (i32 j = 0; j < jobsCount; j++) {
+			firstDigitCount += jobs[j].digitsCounts[d][firstDigit];
+		}
+		if (firstDigitCount == (u32)count) {
+			continue;
+		}
+
+		for (i32 j = 0; j < jobsCount; j++) {
+			RadixSortJob* job = &jobs[j];
+			job->keys = from;
+			job->values = fromValues;
+			job->sortedKeys = to;
+			job->sortedValues = toValues;
+			job->shift = shift;
+			if (!hasMoved) {
+				memcpy(job->offsets, job->digitsCounts[d], sizeof(job->offsets));
+			} else {
+				addJob(jobQueue, countRadixSortJobDigit, job);
+			}
+		}
+		waitForAllJobs(jobQueue);
+
+		//each digit's range holds the keys of the first block, then the second's, and so on
+		u32 offset = 0;
+		for (u32 v = 0; v < RADIX_SORT_DIGITS_COUNT; v++) {
+			for (i32 j = 0; j < jobsCount; j++) {
+				u32 digitCount = jobs[j].offsets[v];
+				jobs[j].offsets[v] = offset;
+				offset += digitCount;
+			}
+		}
+		for (i32 j = 0; j < jobsCount; j++) {
+			addJob(jobQueue, scatterRadixSortJob, &jobs[j]);
+		}
+		waitForAllJobs(jobQueue);
+		hasMoved = 1;
+
+		void* swap = from;
+		from = to;
+		to = swap;
+		u32* swapValues = fromValues;
+		fromValues = toValues;
+		toValues = swapValues;
+	}
+	finishRadixSort(keys, values, from, fromValues, count, keyBytes);
+	scratch->byteOffset = byteOffset;
+}
+
+void parallelRadixSort(JobQueue* jobQueue, u32* keys, u32* values, i32 count, MemoryAllocator* scratch) {
+	sortRadixOnJobs(jobQueue, keys, values, count, 4, scratch);
+}
+
+void parallelRadixSort(JobQueue* jobQueue, u64* keys, u32* values, i32 count, MemoryAllocator* scratch) {
+	sortRadixOnJobs(jobQueue, keys, values, count, 8, scratch);
+}
+
+u64 calculateRadixSortScratchSize(i32 count, u32 keyBytes, bool32 hasValues) {
+	//every allocation may be moved up to 15 bytes for its alignment
+	u64 size = (u64)count * keyBytes + 16;
+	if (hasValues) {
+		size += (u64)count * sizeof(u32) + 16;
+	}
+	size += MAX_RADIX_SORT_JOBS * sizeof(RadixSortJob) + 16;
+	size += (u64)MAX_RADIX_SORT_JOBS * keyBytes * RADIX_SORT_DIGITS_COUNT * sizeof(u32) + 16;
+	return size;
+}
+
+//flips the sign bit of positive floats and every bit of negative ones
+u32 calculateRadixSortKey(f32 value) {
+	u32 bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits ^ ((u32)((i32)bits >> 31) | 0x80000000u);
+}
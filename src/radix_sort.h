@@ -0,0 +1,36 @@
+#pragma once
+#ifndef VOXELS_GAME_RADIX_SORT_H
+#define VOXELS_GAME_RADIX_SORT_H
+
+#include "common.h"
+#include "memory.h"
+#include "jobs.h"
+
+/*
+	least significant digit first radix sorts of 32 and 64 bit keys, each with a 32 bit value moved along with it, like the index of
+	whatever the key was made from. keys and values are separate arrays, and both end up sorted in place.
+	the sorts are stable, and skip the digits that are the same for every key, so keys that only use their low bits sort in fewer passes.
+	the arrays they sort back and forth through are allocated from the scratch allocator, which is given back its space before they return.
+	the parallel sorts split the keys into one block per job. each pass, every job counts the digits of its block, and then scatters its
+	block to where the blocks before it leave off in each digit's range, which keeps them stable
+*/
+
+const u32 RADIX_SORT_DIGIT_BITS = 8;
+const u32 RADIX_SORT_DIGITS_COUNT = 1 << RADIX_SORT_DIGIT_BITS;
+const i32 MAX_RADIX_SORT_JOBS = 64;
+//fewer keys than this per job aren't worth splitting
+const i32 MIN_RADIX_SORT_JOB_KEYS = 64 * 1024;
+
+//values may be nil to sort only the keys
+void radixSort(u32* keys, u32* values, i32 count, MemoryAllocator* scratch);
+void radixSort(u64* keys, u32* values, i32 count, MemoryAllocator* scratch);
+//only the thread that created the job queue may call these
+void parallelRadixSort(JobQueue* jobQueue, u32* keys, u32* values, i32 count, MemoryAllocator* scratch);
+void parallelRadixSort(JobQueue* jobQueue, u64* keys, u32* values, i32 count, MemoryAllocator* scratch);
+//the bytes the sorts need from the scratch allocator, for sizing it
+u64 calculateRadixSortScratchSize(i32 count, u32 keyBytes, bool32 hasValues);
+
+//keys in the same order as the floats. negative zero sorts right before zero
+u32 calculateRadixSortKey(f32 value);
+
+#endif
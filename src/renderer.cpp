@@ -1,6 +1,11 @@
 #include "renderer.h"
 #include "common.h"
 #include "math.h"
+#include "collision.h"
+#include "platform.h"
+#include "jobs.h"
+#include "texture.h"
+#include "asset_pack.h"
 
 #define VK_USE_PLATFORM_WIN32_KHR
 #include <vulkan/vulkan.h>
@@ -20,6 +25,8 @@
 
 
 #include <stdio.h>
+#include <math.h>
+#include <stdlib.h>
 
 #include <malloc.h>
 
@@ -36,18 +43,77 @@ inline void vkCheck(VkResult result) {
 	_assert(result == VK_SUCCESS);
 }
 
-u32 findMemoryType(VkPhysicalDeviceMemoryProperties memoryProperties, u32 memoryTypeBits, VkMemoryPropertyFlags desiredMemoryPropertyFlags) {
-	u32 memoryTypeIndex = 0;
-	for (u32 i = 0; i < memoryProperties.memoryTypeCount; i++) {
-		if ((memoryTypeBits & (1 << i)) && (memoryProperties.memoryTypes[i].propertyFlags & desiredMemoryPropertyFlags) == desiredMemoryPropertyFlags) {
-			memoryTypeIndex = i;
-			return memoryTypeIndex;
+static bool32 allocateDeviceMemoryBlock(void* context, u32 memoryTypeIndex, u32 blockIndex, u64 size) {
+	DeviceMemory* deviceMemory = (DeviceMemory*)context;
+	VkMemoryAllocateInfo allocateInfo = {};
+	allocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocateInfo.allocationSize = size;
+	allocateInfo.memoryTypeIndex = memoryTypeIndex;
+	VkDeviceMemory* block = &deviceMemory->blocks[memoryTypeIndex][blockIndex];
+	if (vkAllocateMemory(deviceMemory->device, &allocateInfo, nil, block) != VK_SUCCESS) {
+		return 0;
+	}
+	deviceMemory->mappedBlocks[memoryTypeIndex][blockIndex] = nil;
+	if (deviceMemory->properties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+		if (vkMapMemory(deviceMemory->device, *block, 0, VK_WHOLE_SIZE, 0, (void**)&deviceMemory->mappedBlocks[memoryTypeIndex][blockIndex]) != VK_SUCCESS) {
+			vkFreeMemory(deviceMemory->device, *block, nil);
+			*block = VK_NULL_HANDLE;
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static void freeDeviceMemoryBlock(void* context, u32 memoryTypeIndex, u32 blockIndex) {
+	DeviceMemory* deviceMemory = (DeviceMemory*)context;
+	//freeing the memory unmaps it as well
+	vkFreeMemory(deviceMemory->device, deviceMemory->blocks[memoryTypeIndex][blockIndex], nil);
+	deviceMemory->blocks[memoryTypeIndex][blockIndex] = VK_NULL_HANDLE;
+	deviceMemory->mappedBlocks[memoryTypeIndex][blockIndex] = nil;
+}
+
+static void initDeviceMemory(DeviceMemory* deviceMemory, VkPhysicalDevice physicalDevice, VkDevice device) {
+	deviceMemory->device = device;
+	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &deviceMemory->properties);
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+	GPUMemoryInterface memoryInterface = {};
+	memoryInterface.context = deviceMemory;
+	memoryInterface.allocateBlock = allocateDeviceMemoryBlock;
+	memoryInterface.freeBlock = freeDeviceMemoryBlock;
+	initGPUAllocator(&deviceMemory->allocator, memoryInterface, deviceMemory->properties.memoryTypeCount, GPU_ALLOCATOR_DEFAULT_BLOCK_SIZE, properties.limits.bufferImageGranularity);
+	//small heaps, like the host visible window into vram some devices have, would be used up by a couple of default sized blocks
+	for (u32 i = 0; i < deviceMemory->properties.memoryTypeCount; i++) {
+		VkDeviceSize heapSize = deviceMemory->properties.memoryHeaps[deviceMemory->properties.memoryTypes[i].heapIndex].size;
+		if (heapSize / 8 < GPU_ALLOCATOR_DEFAULT_BLOCK_SIZE) {
+			setGPUMemoryTypeBlockSize(&deviceMemory->allocator, i, heapSize / 8);
+		}
+	}
+}
+
+//tries every memory type with the flags, in order, so a full heap falls through to the next type that fits. returns 0 if none can hold it
+static bool32 allocateDeviceMemory(DeviceMemory* deviceMemory, VkMemoryRequirements requirements, VkMemoryPropertyFlags memoryPropertyFlags, GPUResourceKind kind, GPUAllocation* allocation) {
+	for (u32 i = 0; i < deviceMemory->properties.memoryTypeCount; i++) {
+		if ((requirements.memoryTypeBits & (1 << i)) && (deviceMemory->properties.memoryTypes[i].propertyFlags & memoryPropertyFlags) == memoryPropertyFlags) {
+			if (allocateGPUMemory(&deviceMemory->allocator, i, requirements.size, requirements.alignment, kind, allocation)) {
+				return 1;
+			}
 		}
 	}
-	panic();
 	return 0;
 }
 
+static VkDeviceMemory getAllocationMemory(DeviceMemory* deviceMemory, GPUAllocation* allocation) {
+	return deviceMemory->blocks[allocation->memoryTypeIndex][allocation->blockIndex];
+}
+
+//nil if the allocation isn't host visible
+static void* getAllocationMappedData(DeviceMemory* deviceMemory, GPUAllocation* allocation) {
+	u8* block = deviceMemory->mappedBlocks[allocation->memoryTypeIndex][allocation->blockIndex];
+	return block != nil ? block + allocation->offset : nil;
+}
+
 VkResult createShaderFromFile(VkDevice device , const char * shaderFilePath, VkShaderModule * shaderModule) {
 	FILE * shaderFile;
 	//TODO: fopen_s won't work with gcc
@@ -78,8 +144,8 @@ VkResult createShaderFromFile(VkDevice device , const char * shaderFilePath, VkS
 	return vkCreateShaderModule(device, &shaderModuleCreateInfo, nil, shaderModule);
 }
 
-Buffer createBuffer(VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties, VkDevice device, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryPropertyFlags) {
-	Buffer buffer;
+Buffer createBuffer(DeviceMemory* deviceMemory, VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryPropertyFlags) {
+	Buffer buffer = {};
 	buffer.size = size;
 	VkBufferCreateInfo bufferInfo = {};
 	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -87,36 +153,23 @@ Buffer createBuffer(VkPhysicalDeviceMemoryProperties physicalDeviceMemoryPropert
 	bufferInfo.usage = usage;
 	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-	buffer.createResult = vkCreateBuffer(device, &bufferInfo, nil, &buffer.buffer);
+	buffer.createResult = vkCreateBuffer(deviceMemory->device, &bufferInfo, nil, &buffer.buffer);
 	if (buffer.createResult != VK_SUCCESS) {
 		printf("unable to create the buffer!\n");
 		return buffer;
 	}
 
 	VkMemoryRequirements memoryRequirements;
-	vkGetBufferMemoryRequirements(device, buffer.buffer, &memoryRequirements);
-
-	VkMemoryPropertyFlags desiredMemoryPropertyFlags = memoryPropertyFlags;
-	u32 memoryTypeIndex = 0;
-	for (u32 i = 0; i < physicalDeviceMemoryProperties.memoryTypeCount; i++) {
-		if ((memoryRequirements.memoryTypeBits & (1 << i)) && (physicalDeviceMemoryProperties.memoryTypes[i].propertyFlags & desiredMemoryPropertyFlags) == desiredMemoryPropertyFlags) {
-			memoryTypeIndex = i;
-			break;
-		}
-	}
+	vkGetBufferMemoryRequirements(deviceMemory->device, buffer.buffer, &memoryRequirements);
 
-	VkMemoryAllocateInfo memoryAllocInfo = {};
-	memoryAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	memoryAllocInfo.allocationSize = memoryRequirements.size;
-	memoryAllocInfo.memoryTypeIndex = memoryTypeIndex;
-
-	buffer.createResult = vkAllocateMemory(device, &memoryAllocInfo, nil, &buffer.memory);
-	if (buffer.createResult != VK_SUCCESS) {
+	if (!allocateDeviceMemory(deviceMemory, memoryRequirements, memoryPropertyFlags, GPU_RESOURCE_LINEAR, &buffer.allocation)) {
 		printf("unable to allocate any memory!\n");
+		buffer.createResult = VK_ERROR_OUT_OF_DEVICE_MEMORY;
 		return buffer;
 	}
 
-	vkBindBufferMemory(device, buffer.buffer, buffer.memory, 0);
+	vkBindBufferMemory(deviceMemory->device, buffer.buffer, getAllocationMemory(deviceMemory, &buffer.allocation), buffer.allocation.offset);
+	buffer.mappedData = getAllocationMappedData(deviceMemory, &buffer.allocation);
 	return buffer;
 }
 
@@ -196,100 +249,807 @@ void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayo
 		endSingleTimeCommands(device, commandBuffer, commandPool, queue);
 }
 
-void loadTextureImage(const char *filepath, Renderer* renderer, Image *textureImage) {
-	int texWidth, texHeight, texChannels;
-	stbi_uc* pixels = stbi_load(filepath, &texWidth, &texHeight, &texChannels, STBI_rgb_alpha);
-	VkDeviceSize imageSize =  texWidth * texHeight * 4;
-	if (!pixels) {
-		printf("failed to load texture image!\n");
-		panic();
+struct TextureDecodeJob {
+	const char* filepath;
+	//the rgba8 base level followed by the rest of its mip chain
+	u8* pixels;
+	i32 width;
+	i32 height;
+	u32 mipLevelsCount;
+};
+
+static void decodeTexture(void* data) {
+	TextureDecodeJob* job = (TextureDecodeJob*)data;
+	int channels;
+	stbi_uc* basePixels = stbi_load(job->filepath, &job->width, &job->height, &channels, STBI_rgb_alpha);
+	if (!basePixels) {
+		return;
 	}
+	job->mipLevelsCount = calculateMipLevelsCount(job->width, job->height);
+	job->pixels = (u8*) malloc(calculateMipChainSize(job->width, job->height, job->mipLevelsCount));
+	memcpy(job->pixels, basePixels, 4ull * job->width * job->height);
+	stbi_image_free(basePixels);
+	generateMipChain(job->pixels, job->width, job->height, job->mipLevelsCount);
+}
 
-	{
-		void *data;
-		vkMapMemory(renderer->device, renderer->stagingBuffer.memory, 0, imageSize, 0, &data);
-		memcpy(data, pixels, imageSize);
-		vkUnmapMemory(renderer->device, renderer->stagingBuffer.memory);
-		stbi_image_free(pixels);
+static TextureDecodeJob* decodeTextures(const char** filepaths, u32 texturesCount, JobQueue* jobQueue) {
+	TextureDecodeJob* decodeJobs = (TextureDecodeJob*) malloc(texturesCount * sizeof(TextureDecodeJob));
+	for (u32 i = 0; i < texturesCount; i++) {
+		decodeJobs[i] = {};
+		decodeJobs[i].filepath = filepaths[i];
+		if (jobQueue != nil) {
+			addJob(jobQueue, decodeTexture, &decodeJobs[i]);
+		} else {
+			decodeTexture(&decodeJobs[i]);
+		}
+	}
+	if (jobQueue != nil) {
+		waitForAllJobs(jobQueue);
 	}
+	for (u32 i = 0; i < texturesCount; i++) {
+		if (!decodeJobs[i].pixels) {
+			printf("failed to load texture image %s!\n", filepaths[i]);
+			panic();
+		}
+	}
+	return decodeJobs;
+}
+
+static VkFormat getTextureVkFormat(TextureFormat format) {
+	return format == TEXTURE_FORMAT_BC1_SRGB ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_R8G8B8A8_SRGB;
+}
+
+static void createTextureImage(Renderer* renderer, TextureFormat format, u32 width, u32 height, u32 mipLevelsCount, u32 arrayLayersCount, Image* textureImage) {
+	//images used by both the transfer and the graphics queue are shared, instead of having their ownership transferred
+	u32 sharedQueueFamilyIndices[2] = { renderer->queueFamilyIndices[0], renderer->transferQueueFamilyIndex };
 
 	VkImageCreateInfo imageInfo = {};
 	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 	imageInfo.imageType = VK_IMAGE_TYPE_2D;
-	imageInfo.extent.width = texWidth;
-	imageInfo.extent.height = texHeight;
+	imageInfo.extent.width = width;
+	imageInfo.extent.height = height;
 	imageInfo.extent.depth = 1;
-	imageInfo.mipLevels = 1;
-	imageInfo.arrayLayers = 1;
-	imageInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
+	imageInfo.mipLevels = mipLevelsCount;
+	imageInfo.arrayLayers = arrayLayersCount;
+	imageInfo.format = getTextureVkFormat(format);
 	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
 	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 	imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
-	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	if (sharedQueueFamilyIndices[0] != sharedQueueFamilyIndices[1]) {
+		imageInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		imageInfo.queueFamilyIndexCount = 2;
+		imageInfo.pQueueFamilyIndices = sharedQueueFamilyIndices;
+	} else {
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	}
 	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 	imageInfo.flags = 0;
 
 	vkCheck(vkCreateImage(renderer->device, &imageInfo, nil, &textureImage->image));
 
 	textureImage->extent = imageInfo.extent;
+	textureImage->mipLevelsCount = mipLevelsCount;
+	textureImage->arrayLayersCount = arrayLayersCount;
 
 	VkMemoryRequirements textureImageMemoryRequirements = {};
 	vkGetImageMemoryRequirements(renderer->device, textureImage->image, &textureImageMemoryRequirements);
-	VkMemoryAllocateInfo textureImageMemoryAllocateInfo = {};
-	textureImageMemoryAllocateInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	textureImageMemoryAllocateInfo.allocationSize = textureImageMemoryRequirements.size;
-	textureImageMemoryAllocateInfo.memoryTypeIndex = findMemoryType(renderer->physicalDeviceMemoryProperties, textureImageMemoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	vkCheck(vkAllocateMemory(renderer->device, &textureImageMemoryAllocateInfo, nil, &textureImage->memory));
-
-	vkBindImageMemory(renderer->device, textureImage->image, textureImage->memory, 0);
-
-	//TODO: run copy command buffer, and transition layouts asynchronously
-
-	transitionImageLayout(textureImage->image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, renderer->device, renderer->commandPool, renderer->graphicsQueue);
-	VkCommandBuffer copyCommand = beginSingleTimeCommands(renderer->device, renderer->commandPool);
-
-	VkBufferImageCopy region = {};
-	region.bufferOffset = 0;
-	region.bufferRowLength = 0;
-	region.bufferImageHeight = 0;
-	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	region.imageSubresource.mipLevel = 0;
-	region.imageSubresource.baseArrayLayer = 0;
-	region.imageSubresource.layerCount = 1;
-	region.imageOffset = { 0, 0, 0, };
-	region.imageExtent = {
-		textureImage->extent.width, textureImage->extent.height,
-		1
-	};
-
-	vkCmdCopyBufferToImage(
-		copyCommand,
-		renderer->stagingBuffer.buffer,
-		textureImage->image,
-		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-		1,
-		&region
-	);
-
-	endSingleTimeCommands(renderer->device, copyCommand, renderer->commandPool, renderer->graphicsQueue);
-
-	transitionImageLayout(textureImage->image, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, renderer->device, renderer->commandPool, renderer->graphicsQueue);
+	if (!allocateDeviceMemory(renderer->deviceMemory, textureImageMemoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GPU_RESOURCE_OPTIMAL, &textureImage->allocation)) {
+		printf("unable to allocate memory for a %ux%u texture!\n", width, height);
+		panic();
+	}
+	vkBindImageMemory(renderer->device, textureImage->image, getAllocationMemory(renderer->deviceMemory, &textureImage->allocation), textureImage->allocation.offset);
 
 	VkImageViewCreateInfo viewInfo = {};
 	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 	viewInfo.image = textureImage->image;
-	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
-	viewInfo.format = VK_FORMAT_R8G8B8A8_SRGB;
+	viewInfo.viewType = arrayLayersCount > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = imageInfo.format;
 	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
 	viewInfo.subresourceRange.baseMipLevel = 0;
-	viewInfo.subresourceRange.levelCount = 1;
+	viewInfo.subresourceRange.levelCount = mipLevelsCount;
 	viewInfo.subresourceRange.baseArrayLayer = 0;
-	viewInfo.subresourceRange.layerCount = 1;
+	viewInfo.subresourceRange.layerCount = arrayLayersCount;
 	vkCheck(vkCreateImageView(renderer->device, &viewInfo, nil, &textureImage->imageView));
 }
 
+//one array layer of an image, with its whole mip chain
+struct TextureLayerUpload {
+	Image* image;
+	u32 arrayLayer;
+	TextureFormat format;
+	u8* pixels;
+	//pixels that point into a mapped asset pack aren't freed once they are staged
+	bool32 isPixelsOwned;
+	VkDeviceSize size;
+	VkDeviceSize stagingOffset;
+};
+
+//records the layout transitions and copies of the layers [begin, end), whose pixels are already in the staging buffer, and waits for them on the transfer queue
+static void submitTextureUploads(Renderer* renderer, VkFence fence, TextureLayerUpload* uploads, VkImageMemoryBarrier* barriers, u32 begin, u32 end) {
+	if (begin >= end) {
+		return;
+	}
+	bool32 isUsingDedicatedTransferQueue = renderer->transferQueueFamilyIndex != renderer->queueFamilyIndices[0];
+	VkCommandBuffer commandBuffer = beginSingleTimeCommands(renderer->device, renderer->transferCommandPool);
+
+	for (u32 i = begin; i < end; i++) {
+		VkImageMemoryBarrier* barrier = &barriers[i - begin];
+		*barrier = {};
+		barrier->sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier->oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier->newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier->srcAccessMask = 0;
+		barrier->dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier->srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier->dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier->image = uploads[i].image->image;
+		barrier->subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier->subresourceRange.baseMipLevel = 0;
+		barrier->subresourceRange.levelCount = uploads[i].image->mipLevelsCount;
+		barrier->subresourceRange.baseArrayLayer = uploads[i].arrayLayer;
+		barrier->subresourceRange.layerCount = 1;
+	}
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nil, 0, nil, end - begin, barriers);
+
+	VkBufferImageCopy regions[16] = {};
+	for (u32 i = begin; i < end; i++) {
+		Image* image = uploads[i].image;
+		_assert(image->mipLevelsCount <= sizeof(regions) / sizeof(regions[0]));
+		VkDeviceSize levelOffset = uploads[i].stagingOffset;
+		for (u32 level = 0; level < image->mipLevelsCount; level++) {
+			VkBufferImageCopy* region = &regions[level];
+			region->bufferOffset = levelOffset;
+			region->bufferRowLength = 0;
+			region->bufferImageHeight = 0;
+			region->imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+			region->imageSubresource.mipLevel = level;
+			region->imageSubresource.baseArrayLayer = uploads[i].arrayLayer;
+			region->imageSubresource.layerCount = 1;
+			region->imageOffset = { 0, 0, 0, };
+			region->imageExtent = {
+				calculateMipLevelDimension(image->extent.width, level),
+				calculateMipLevelDimension(image->extent.height, level),
+				1
+			};
+			levelOffset += calculateTextureLevelSize(uploads[i].format, region->imageExtent.width, region->imageExtent.height);
+		}
+		vkCmdCopyBufferToImage(commandBuffer, renderer->stagingBuffer.buffer, image->image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, image->mipLevelsCount, regions);
+	}
+
+	//a transfer only queue can't name the fragment shader stage. the fence wait below orders the copies before any later graphics submission
+	for (u32 i = begin; i < end; i++) {
+		VkImageMemoryBarrier* barrier = &barriers[i - begin];
+		barrier->oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier->newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier->srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier->dstAccessMask = isUsingDedicatedTransferQueue ? 0 : VK_ACCESS_SHADER_READ_BIT;
+	}
+	VkPipelineStageFlags destinationStage = isUsingDedicatedTransferQueue ? VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT : VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, destinationStage, 0, 0, nil, 0, nil, end - begin, barriers);
+
+	vkCheck(vkEndCommandBuffer(commandBuffer));
+	VkSubmitInfo submitInfo = {};
+	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+	submitInfo.commandBufferCount = 1;
+	submitInfo.pCommandBuffers = &commandBuffer;
+	vkCheck(vkResetFences(renderer->device, 1, &fence));
+	vkCheck(vkQueueSubmit(renderer->transferQueue, 1, &submitInfo, fence));
+	vkCheck(vkWaitForFences(renderer->device, 1, &fence, VK_TRUE, UINT64_MAX));
+	vkFreeCommandBuffers(renderer->device, renderer->transferCommandPool, 1, &commandBuffer);
+}
+
+//packs the layers into the staging buffer. whenever it fills up, the packed layers are uploaded in one submission. frees the pixels of every layer that owns them
+static void uploadTextureLayers(Renderer* renderer, TextureLayerUpload* uploads, u32 uploadsCount, const char* description, f64 startSeconds, JobQueue* jobQueue) {
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(renderer->physicalDevice, &properties);
+	VkDeviceSize offsetAlignment = MAX(16, properties.limits.optimalBufferCopyOffsetAlignment);
+
+	VkImageMemoryBarrier* barriers = (VkImageMemoryBarrier*) malloc(uploadsCount * sizeof(VkImageMemoryBarrier));
+	VkFenceCreateInfo fenceInfo = {};
+	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+	VkFence fence;
+	vkCheck(vkCreateFence(renderer->device, &fenceInfo, nil, &fence));
+
+	u8* stagingData = (u8*)renderer->stagingBuffer.mappedData;
+
+	u32 batchBegin = 0;
+	VkDeviceSize stagingOffset = 0;
+	VkDeviceSize uploadedBytes = 0;
+	VkDeviceSize baseLevelBytes = 0;
+	u32 submissionsCount = 0;
+	for (u32 i = 0; i < uploadsCount; i++) {
+		TextureLayerUpload* upload = &uploads[i];
+		if (upload->size > renderer->stagingBuffer.size) {
+			printf("a %ux%u texture doesn't fit in the staging buffer!\n", upload->image->extent.width, upload->image->extent.height);
+			panic();
+		}
+		VkDeviceSize offset = (stagingOffset + offsetAlignment - 1) / offsetAlignment * offsetAlignment;
+		if (offset + upload->size > renderer->stagingBuffer.size) {
+			submitTextureUploads(renderer, fence, uploads, barriers, batchBegin, i);
+			submissionsCount += 1;
+			batchBegin = i;
+			offset = 0;
+		}
+		memcpy(stagingData + offset, upload->pixels, upload->size);
+		if (upload->isPixelsOwned) {
+			free(upload->pixels);
+		}
+		upload->pixels = nil;
+		upload->stagingOffset = offset;
+		stagingOffset = offset + upload->size;
+		uploadedBytes += upload->size;
+		baseLevelBytes += 4ull * upload->image->extent.width * upload->image->extent.height;
+	}
+	submitTextureUploads(renderer, fence, uploads, barriers, batchBegin, uploadsCount);
+	submissionsCount += 1;
+
+	vkDestroyFence(renderer->device, fence, nil);
+	free(barriers);
+
+	bool32 isUsingDedicatedTransferQueue = renderer->transferQueueFamilyIndex != renderer->queueFamilyIndices[0];
+	printf(
+		"loaded %s in %.2f ms with %u decode threads and %u submissions to the %s queue. %.1f KB uploaded, %.1f KB as rgba8 without mips\n",
+		description, 1000.0 * (getWallClockSeconds() - startSeconds), jobQueue != nil ? jobQueue->threadsCount + 1 : 1, submissionsCount,
+		isUsingDedicatedTransferQueue ? "transfer" : "graphics", (f64)uploadedBytes / 1024.0, (f64)baseLevelBytes / 1024.0
+	);
+}
+
+void loadTextureImages(const char** filepaths, u32 texturesCount, Renderer* renderer, Image* textureImages, JobQueue* jobQueue) {
+	if (texturesCount == 0) {
+		return;
+	}
+	f64 startSeconds = getWallClockSeconds();
+	TextureDecodeJob* decodeJobs = decodeTextures(filepaths, texturesCount, jobQueue);
+
+	TextureLayerUpload* uploads = (TextureLayerUpload*) malloc(texturesCount * sizeof(TextureLayerUpload));
+	for (u32 i = 0; i < texturesCount; i++) {
+		TextureDecodeJob* job = &decodeJobs[i];
+		createTextureImage(renderer, TEXTURE_FORMAT_RGBA8_SRGB, job->width, job->height, job->mipLevelsCount, 1, &textureImages[i]);
+		uploads[i] = {};
+		uploads[i].image = &textureImages[i];
+		uploads[i].arrayLayer = 0;
+		uploads[i].format = TEXTURE_FORMAT_RGBA8_SRGB;
+		uploads[i].pixels = job->pixels;
+		uploads[i].isPixelsOwned = 1;
+		uploads[i].size = calculateMipChainSize(job->width, job->height, job->mipLevelsCount);
+	}
+
+	char description[64];
+	snprintf(description, sizeof(description), "%u textures", texturesCount);
+	uploadTextureLayers(renderer, uploads, texturesCount, description, startSeconds, jobQueue);
+	free(uploads);
+	free(decodeJobs);
+}
+
+void loadTextureArray(const char** filepaths, u32 texturesCount, Renderer* renderer, Image* textureArray, JobQueue* jobQueue) {
+	_assert(texturesCount > 0);
+	f64 startSeconds = getWallClockSeconds();
+	TextureDecodeJob* decodeJobs = decodeTextures(filepaths, texturesCount, jobQueue);
+
+	i32 width = decodeJobs[0].width;
+	i32 height = decodeJobs[0].height;
+	for (u32 i = 1; i < texturesCount; i++) {
+		if (decodeJobs[i].width != width || decodeJobs[i].height != height) {
+			printf("texture %s is %dx%d, but the other textures of its array are %dx%d!\n", filepaths[i], decodeJobs[i].width, decodeJobs[i].height, width, height);
+			panic();
+		}
+	}
+	u32 mipLevelsCount = decodeJobs[0].mipLevelsCount;
+	createTextureImage(renderer, TEXTURE_FORMAT_RGBA8_SRGB, width, height, mipLevelsCount, texturesCount, textureArray);
+
+	TextureLayerUpload* uploads = (TextureLayerUpload*) malloc(texturesCount * sizeof(TextureLayerUpload));
+	for (u32 i = 0; i < texturesCount; i++) {
+		uploads[i] = {};
+		uploads[i].image = textureArray;
+		uploads[i].arrayLayer = i;
+		uploads[i].format = TEXTURE_FORMAT_RGBA8_SRGB;
+		uploads[i].pixels = decodeJobs[i].pixels;
+		uploads[i].isPixelsOwned = 1;
+		uploads[i].size = calculateMipChainSize(width, height, mipLevelsCount);
+	}
+
+	char description[64];
+	snprintf(description, sizeof(description), "a %u layer %dx%d texture array", texturesCount, width, height);
+	uploadTextureLayers(renderer, uploads, texturesCount, description, startSeconds, jobQueue);
+	free(uploads);
+	free(decodeJobs);
+}
+
+bool32 loadTextureArrayFromPack(AssetPack* pack, const char** names, u32 texturesCount, Renderer* renderer, Image* textureArray) {
+	_assert(texturesCount > 0);
+	f64 startSeconds = getWallClockSeconds();
+	AssetPackTexture** textures = (AssetPackTexture**) malloc(texturesCount * sizeof(AssetPackTexture*));
+	for (u32 i = 0; i < texturesCount; i++) {
+		textures[i] = findAssetPackTexture(pack, names[i]);
+		if (textures[i] == nil) {
+			printf("the asset pack has no texture named %s\n", names[i]);
+			free(textures);
+			return 0;
+		}
+		AssetPackTexture* first = textures[0];
+		if (textures[i]->width != first->width || textures[i]->height != first->height || textures[i]->mipLevelsCount != first->mipLevelsCount || textures[i]->format != first->format) {
+			printf("texture %s of the asset pack doesn't match the size and format of the other textures of its array\n", names[i]);
+			free(textures);
+			return 0;
+		}
+	}
+	AssetPackTexture* first = textures[0];
+	//devices without bc support get the blocks decompressed here, which is still cheaper than decoding the pngs
+	bool32 isDecompressing = first->format == TEXTURE_FORMAT_BC1_SRGB && !renderer->isTextureCompressionBCSupported;
+	TextureFormat format = isDecompressing ? TEXTURE_FORMAT_RGBA8_SRGB : first->format;
+	createTextureImage(renderer, format, first->width, first->height, first->mipLevelsCount, texturesCount, textureArray);
+
+	TextureLayerUpload* uploads = (TextureLayerUpload*) malloc(texturesCount * sizeof(TextureLayerUpload));
+	for (u32 i = 0; i < texturesCount; i++) {
+		uploads[i] = {};
+		uploads[i].image = textureArray;
+		uploads[i].arrayLayer = i;
+		uploads[i].format = format;
+		uploads[i].size = calculateTextureChainSize(format, first->width, first->height, first->mipLevelsCount);
+		u8* data = getAssetPackTextureData(pack, textures[i]);
+		if (isDecompressing) {
+			uploads[i].pixels = (u8*) malloc(uploads[i].size);
+			uploads[i].isPixelsOwned = 1;
+			u8* source = data;
+			u8* destination = uploads[i].pixels;
+			for (u32 level = 0; level < first->mipLevelsCount; level++) {
+				u32 levelWidth = calculateMipLevelDimension(first->width, level);
+				u32 levelHeight = calculateMipLevelDimension(first->height, level);
+				decompressBC1(source, levelWidth, levelHeight, destination);
+				source += calculateTextureLevelSize(TEXTURE_FORMAT_BC1_SRGB, levelWidth, levelHeight);
+				destination += calculateTextureLevelSize(TEXTURE_FORMAT_RGBA8_SRGB, levelWidth, levelHeight);
+			}
+		} else {
+			uploads[i].pixels = data;
+			uploads[i].isPixelsOwned = 0;
+		}
+	}
+
+	char description[96];
+	snprintf(
+		description, sizeof(description), "a %u layer %ux%u %s texture array from the asset pack",
+		texturesCount, first->width, first->height, format == TEXTURE_FORMAT_BC1_SRGB ? "bc1" : "rgba8"
+	);
+	uploadTextureLayers(renderer, uploads, texturesCount, description, startSeconds, nil);
+	free(uploads);
+	free(textures);
+	return 1;
+}
+
+void loadTextureImage(const char *filepath, Renderer* renderer, Image *textureImage) {
+	loadTextureImages(&filepath, 1, renderer, textureImage, nil);
+}
+
+void beginFrameUploads(Renderer* renderer, u32 frameIndex) {
+	UploadRing* ring = &renderer->uploadRing;
+	//frames finish in order, so every allocation made up to the end of this frame's last use is free again
+	ring->tail = MAX(ring->tail, ring->frameEnds[frameIndex]);
+	ring->bytesUploadedThisFrame = 0;
+
+	//the previous frame may still be reading the buffers that are about to be overwritten: the object data in the vertex shader and the shadow
+	//occupancy in the fragment shader. a write after read hazard only needs an execution dependency
+	vkCmdPipelineBarrier(
+		renderer->commandBuffers[frameIndex], VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0, 0, nil, 0, nil, 0, nil
+	);
+}
+
+bool32 uploadToBuffer(Renderer* renderer, u32 frameIndex, VkBuffer destination, VkDeviceSize destinationOffset, void* data, VkDeviceSize size) {
+	UploadRing* ring = &renderer->uploadRing;
+	u64 ringSize = ring->buffer.size;
+	u64 head = (ring->head + 15) & ~15ull;
+	u64 offset = head % ringSize;
+	//allocations never wrap around the end of the buffer, so they skip to the start
+	if (offset + size > ringSize) {
+		head += ringSize - offset;
+		offset = 0;
+	}
+	if (head + size - ring->tail > ringSize) {
+		return 0;
+	}
+	ring->head = head + size;
+	ring->bytesUploadedThisFrame += size;
+
+	memcpy((u8*)ring->buffer.mappedData + offset, data, size);
+
+	VkBufferCopy region = {};
+	region.srcOffset = offset;
+	region.dstOffset = destinationOffset;
+	region.size = size;
+	vkCmdCopyBuffer(renderer->commandBuffers[frameIndex], ring->buffer.buffer, destination, 1, &region);
+	return 1;
+}
+
+bool32 uploadGPUObjectData(Renderer* renderer, u32 frameIndex, GPUObjectData* objectData, u32 begin, u32 end) {
+	end = MIN(end, MAX_OBJECTS_PER_DRAW);
+	if (begin >= end) {
+		return 1;
+	}
+	u32 count = end - begin;
+	return
+		uploadToBuffer(renderer, frameIndex, renderer->objectTransformBuffer.buffer, begin * sizeof(math::Matrix4), &objectData->models[begin], count * sizeof(math::Matrix4)) &&
+		uploadToBuffer(renderer, frameIndex, renderer->objectColorBuffer.buffer, begin * sizeof(RGBAColorF32), &objectData->rgbaColors[begin], count * sizeof(RGBAColorF32)) &&
+		uploadToBuffer(renderer, frameIndex, renderer->objectOcclusionBuffer.buffer, begin * sizeof(u64), &objectData->occlusions[begin], count * sizeof(u64));
+}
+
+bool32 uploadGPUOverlayObjectData(Renderer* renderer, u32 frameIndex, GPUObjectData* overlayData) {
+	u32 count = MIN(overlayData->count, MAX_OVERLAY_OBJECTS);
+	if (count == 0) {
+		return 1;
+	}
+	return
+		uploadToBuffer(renderer, frameIndex, renderer->objectTransformBuffer.buffer, OVERLAY_OBJECTS_BASE * sizeof(math::Matrix4), overlayData->models, count * sizeof(math::Matrix4)) &&
+		uploadToBuffer(renderer, frameIndex, renderer->objectColorBuffer.buffer, OVERLAY_OBJECTS_BASE * sizeof(RGBAColorF32), overlayData->rgbaColors, count * sizeof(RGBAColorF32)) &&
+		uploadToBuffer(renderer, frameIndex, renderer->objectOcclusionBuffer.buffer, OVERLAY_OBJECTS_BASE * sizeof(u64), overlayData->occlusions, count * sizeof(u64));
+}
+
+bool32 uploadVoxelShadowOccupancy(Renderer* renderer, u32 frameIndex, u32* occupancy, u32 begin, u32 end) {
+	end = MIN(end, (u32)(MAX_VOXEL_SHADOW_OCCUPANCY_SIZE / sizeof(u32)));
+	if (begin >= end) {
+		return 1;
+	}
+	return uploadToBuffer(renderer, frameIndex, renderer->voxelShadowBuffer.buffer, begin * sizeof(u32), &occupancy[begin], (end - begin) * sizeof(u32));
+}
+
+void endFrameUploads(Renderer* renderer, u32 frameIndex) {
+	UploadRing* ring = &renderer->uploadRing;
+	ring->frameEnds[frameIndex] = ring->head;
+
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(renderer->commandBuffers[frameIndex], VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nil, 0, nil);
+}
+
+static GPUCullingBatch calculateCullingBatch(GPUObjectData* objectData, u32 begin, u32 end) {
+	GPUCullingBatch batch = {};
+	batch.firstInstance = begin;
+	bool32 hasBounds = 0;
+	AABB bounds = {};
+	for (u32 i = begin; i < end; i++) {
+		math::Matrix4 model = objectData->models[i];
+		//a zeroed model collapses the instance to nothing, so it can't make the batch visible
+		if (model.e.m33 == 0.0f) {
+			continue;
+		}
+		AABB a = calculateTransformedUnitCubeBounds(model);
+		if (!hasBounds) {
+			bounds = a;
+			hasBounds = 1;
+		} else {
+			bounds.min = math::Vector3{ fminf(bounds.min.x, a.min.x), fminf(bounds.min.y, a.min.y), fminf(bounds.min.z, a.min.z) };
+			bounds.max = math::Vector3{ fmaxf(bounds.max.x, a.max.x), fmaxf(bounds.max.y, a.max.y), fmaxf(bounds.max.z, a.max.z) };
+		}
+	}
+	if (!hasBounds) {
+		return batch;
+	}
+	batch.boundsMin[0] = bounds.min.x;
+	batch.boundsMin[1] = bounds.min.y;
+	batch.boundsMin[2] = bounds.min.z;
+	batch.boundsMax[0] = bounds.max.x;
+	batch.boundsMax[1] = bounds.max.y;
+	batch.boundsMax[2] = bounds.max.z;
+	batch.instancesCount = end - begin;
+	return batch;
+}
+
+bool32 updateCullingBatches(Renderer* renderer, u32 frameIndex, GPUObjectData* objectData, u32 begin, u32 end, u32 culledInstancesCount) {
+	GPUCulling* culling = &renderer->gpuCulling;
+	culledInstancesCount = MIN(culledInstancesCount, MAX_OBJECTS_PER_DRAW);
+	end = MIN(end, culledInstancesCount);
+	if (!culling->isSupported || begin >= end) {
+		return 1;
+	}
+	u32 firstBatch = begin / CULLING_BATCH_SIZE;
+	u32 lastBatch = (end - 1) / CULLING_BATCH_SIZE;
+	for (u32 b = firstBatch; b <= lastBatch; b++) {
+		u32 batchBegin = b * CULLING_BATCH_SIZE;
+		u32 batchEnd = MIN(batchBegin + CULLING_BATCH_SIZE, culledInstancesCount);
+		culling->batches[b] = calculateCullingBatch(objectData, batchBegin, batchEnd);
+	}
+	u32 batchesCount = lastBatch - firstBatch + 1;
+	return uploadToBuffer(renderer, frameIndex, culling->batchBuffer.buffer, firstBatch * sizeof(GPUCullingBatch), &culling->batches[firstBatch], batchesCount * sizeof(GPUCullingBatch));
+}
+
+void recordInstanceCulling(Renderer* renderer, u32 frameIndex, math::Matrix4 viewProjection, u32 culledInstancesCount) {
+	GPUCulling* culling = &renderer->gpuCulling;
+	if (!culling->isSupported) {
+		return;
+	}
+	VkCommandBuffer commandBuffer = renderer->commandBuffers[frameIndex];
+
+	//the in flight fence of this frame was already waited on, so the counters copied by its last use are available
+	if (culling->hasPendingReadback[frameIndex]) {
+		culling->hasPendingReadback[frameIndex] = 0;
+		GPUCullingCounters counters = *(GPUCullingCounters*)culling->readbackBuffers[frameIndex].mappedData;
+		GPUCullingCounters expected = culling->expectedCounters[frameIndex];
+		culling->lastCounters = counters;
+		culling->lastExpectedCounters = expected;
+		if (counters.drawCount != expected.drawCount || counters.visibleInstancesCount != expected.visibleInstancesCount) {
+			culling->mismatchedFramesCount += 1;
+			printf("gpu culling wrote %u draws with %u instances, expected %u draws with %u instances\n", counters.drawCount, counters.visibleInstancesCount, expected.drawCount, expected.visibleInstancesCount);
+		}
+	}
+
+	culledInstancesCount = MIN(culledInstancesCount, MAX_OBJECTS_PER_DRAW);
+	culling->batchesCount = (culledInstancesCount + CULLING_BATCH_SIZE - 1) / CULLING_BATCH_SIZE;
+	if (!culling->isEnabled || culling->batchesCount == 0) {
+		return;
+	}
+
+	Frustum frustum = extractFrustum(viewProjection);
+	GPUCullingCounters expected = {};
+	for (u32 b = 0; b < culling->batchesCount; b++) {
+		GPUCullingBatch* batch = &culling->batches[b];
+		AABB bounds = {};
+		bounds.min = math::Vector3{ batch->boundsMin[0], batch->boundsMin[1], batch->boundsMin[2] };
+		bounds.max = math::Vector3{ batch->boundsMax[0], batch->boundsMax[1], batch->boundsMax[2] };
+		if (batch->instancesCount > 0 && isAABBIntersectingFrustum(&frustum, bounds)) {
+			expected.drawCount += 1;
+			expected.visibleInstancesCount += batch->instancesCount;
+		}
+	}
+	culling->expectedCounters[frameIndex] = expected;
+
+	//the previous frame may still be drawing from the buffers the compute pass is about to overwrite
+	VkMemoryBarrier barrier = {};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nil, 0, nil);
+
+	vkCmdFillBuffer(commandBuffer, culling->countersBuffer.buffer, 0, sizeof(GPUCullingCounters), 0);
+	if (!culling->isDrawIndirectCountSupported) {
+		//without a gpu written draw count every batch gets a draw, so the draws the compute pass doesn't write must draw nothing
+		vkCmdFillBuffer(commandBuffer, culling->drawCommandBuffer.buffer, 0, culling->batchesCount * sizeof(VkDrawIndirectCommand), 0);
+	}
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &barrier, 0, nil, 0, nil);
+
+	CullingPushConstants pushConstants = {};
+	for (i32 i = 0; i < 6; i++) {
+		pushConstants.frustumPlanes[i] = frustum.planes[i];
+	}
+	pushConstants.batchesCount = culling->batchesCount;
+
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, culling->pipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, culling->pipelineLayout, 0, 1, &culling->descriptorSet, 0, nil);
+	vkCmdPushConstants(commandBuffer, culling->pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(CullingPushConstants), &pushConstants);
+	vkCmdDispatch(commandBuffer, (culling->batchesCount + 63) / 64, 1, 1);
+
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_TRANSFER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nil, 0, nil);
+
+	VkBufferCopy region = {};
+	region.size = sizeof(GPUCullingCounters);
+	vkCmdCopyBuffer(commandBuffer, culling->countersBuffer.buffer, culling->readbackBuffers[frameIndex].buffer, 1, &region);
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &barrier, 0, nil, 0, nil);
+	culling->hasPendingReadback[frameIndex] = 1;
+}
+
+void drawCulledInstances(Renderer* renderer, u32 frameIndex, u32 culledInstancesCount, u32 instancesCount) {
+	GPUCulling* culling = &renderer->gpuCulling;
+	VkCommandBuffer commandBuffer = renderer->commandBuffers[frameIndex];
+	instancesCount = MIN(instancesCount, MAX_OBJECTS_PER_DRAW);
+	culledInstancesCount = MIN(culledInstancesCount, instancesCount);
+
+	u32 unculledBegin = 0;
+	if (culling->isSupported && culling->isEnabled && culling->batchesCount > 0) {
+		if (culling->isDrawIndirectCountSupported) {
+			vkCmdDrawIndirectCount(commandBuffer, culling->drawCommandBuffer.buffer, 0, culling->countersBuffer.buffer, offsetof(GPUCullingCounters, drawCount), culling->batchesCount, sizeof(VkDrawIndirectCommand));
+		} else {
+			vkCmdDrawIndirect(commandBuffer, culling->drawCommandBuffer.buffer, 0, culling->batchesCount, sizeof(VkDrawIndirectCommand));
+		}
+		unculledBegin = culledInstancesCount;
+	}
+	if (unculledBegin < instancesCount) {
+		vkCmdDraw(commandBuffer, 36, instancesCount - unculledBegin, 0, UNCULLED_INSTANCES_BASE + unculledBegin);
+	}
+}
+
+void drawOverlayInstances(Renderer* renderer, u32 frameIndex, u32 begin, u32 end) {
+	end = MIN(end, MAX_OVERLAY_OBJECTS);
+	if (begin < end) {
+		vkCmdDraw(renderer->commandBuffers[frameIndex], 36, end - begin, 0, UNCULLED_INSTANCES_BASE + OVERLAY_OBJECTS_BASE + begin);
+	}
+}
+
+void drawGrid(Renderer* renderer, u32 frameIndex, GridPushConstants* grid) {
+	VkCommandBuffer commandBuffer = renderer->commandBuffers[frameIndex];
+	vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderer->gridPipeline);
+	vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderer->gridPipelineLayout, 0, 1, &renderer->uniformBufferDescriptorSets[frameIndex], 0, nil);
+	vkCmdPushConstants(commandBuffer, renderer->gridPipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(GridPushConstants), grid);
+	vkCmdDraw(commandBuffer, 6, 1, 0, 0);
+}
+
+void beginGPUProfilerFrame(Renderer* renderer, u32 frameIndex, u64 frameNumber) {
+	GPUProfiler* profiler = &renderer->gpuProfiler;
+	if (!profiler->isSupported) {
+		return;
+	}
+	GPUProfilerFrame* frame = &profiler->frames[frameIndex];
+	VkCommandBuffer commandBuffer = renderer->commandBuffers[frameIndex];
+
+	//the in flight fence of this frame was already waited on, so the last results written to this pool are available and reading them doesn't stall
+	if (frame->hasPendingResults && frame->zonesCount > 0) {
+		u64 timestamps[2 * PROFILER_MAX_GPU_ZONES] = {};
+		VkResult result = vkGetQueryPoolResults(renderer->device, frame->queryPool, 0, 2 * frame->zonesCount, sizeof(timestamps), timestamps, sizeof(u64), VK_QUERY_RESULT_64_BIT);
+		if (result == VK_SUCCESS) {
+			ProfilerGPUZone zones[PROFILER_MAX_GPU_ZONES] = {};
+			u64 baseTimestamp = timestamps[0] & profiler->timestampMask;
+			for (u32 i = 0; i < frame->zonesCount; i++) {
+				u64 begin = ((timestamps[2 * i] & profiler->timestampMask) - baseTimestamp) & profiler->timestampMask;
+				u64 end = ((timestamps[2 * i + 1] & profiler->timestampMask) - baseTimestamp) & profiler->timestampMask;
+				zones[i].name = frame->zoneNames[i];
+				zones[i].depth = frame->zoneDepths[i];
+				zones[i].beginMilliseconds = (f64)begin * profiler->nanosecondsPerTick / 1.0e6;
+				zones[i].endMilliseconds = (f64)end * profiler->nanosecondsPerTick / 1.0e6;
+			}
+			submitProfilerGPUZones(frame->frameNumber, zones, frame->zonesCount);
+		}
+	}
+
+	vkCmdResetQueryPool(commandBuffer, frame->queryPool, 0, 2 * PROFILER_MAX_GPU_ZONES);
+	frame->frameNumber = frameNumber;
+	frame->zonesCount = 0;
+	frame->hasPendingResults = 1;
+	profiler->depth = 0;
+}
+
+u32 beginGPUZone(Renderer* renderer, u32 frameIndex, const char* name) {
+	GPUProfiler* profiler = &renderer->gpuProfiler;
+	GPUProfilerFrame* frame = &profiler->frames[frameIndex];
+	if (!profiler->isSupported || frame->zonesCount >= PROFILER_MAX_GPU_ZONES) {
+		return UINT32_MAX;
+	}
+	u32 zoneIndex = frame->zonesCount;
+	frame->zonesCount += 1;
+	frame->zoneNames[zoneIndex] = name;
+	frame->zoneDepths[zoneIndex] = profiler->depth;
+	profiler->depth += 1;
+	vkCmdWriteTimestamp(renderer->commandBuffers[frameIndex], VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame->queryPool, 2 * zoneIndex);
+	return zoneIndex;
+}
+
+void endGPUZone(Renderer* renderer, u32 frameIndex, u32 zoneIndex) {
+	GPUProfiler* profiler = &renderer->gpuProfiler;
+	if (!profiler->isSupported || zoneIndex == UINT32_MAX) {
+		return;
+	}
+	profiler->depth -= 1;
+	vkCmdWriteTimestamp(renderer->commandBuffers[frameIndex], VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, profiler->frames[frameIndex].queryPool, 2 * zoneIndex + 1);
+}
+
+//written in front of the driver's cache data. the driver's own header has no driver version, and a cache from another driver version is useless
+struct PipelineCacheFileHeader {
+	u32 magic;
+	u32 vendorID;
+	u32 deviceID;
+	u32 driverVersion;
+	u8 pipelineCacheUUID[VK_UUID_SIZE];
+	u64 dataSize;
+};
+const u32 PIPELINE_CACHE_FILE_MAGIC = 0x43505856; //"VXPC"
+
+static bool32 isPipelineCacheFileHeaderValid(PipelineCacheFileHeader* header, VkPhysicalDeviceProperties* properties) {
+	return
+		header->magic == PIPELINE_CACHE_FILE_MAGIC &&
+		header->vendorID == properties->vendorID &&
+		header->deviceID == properties->deviceID &&
+		header->driverVersion == properties->driverVersion &&
+		memcmp(header->pipelineCacheUUID, properties->pipelineCacheUUID, VK_UUID_SIZE) == 0;
+}
+
+//loads the pipeline cache saved by a previous launch. a missing, stale or corrupt file gives an empty cache
+static VkResult createPipelineCache(Renderer* renderer, VkPhysicalDeviceProperties* properties, const char* filePath, bool32* isWarm) {
+	*isWarm = 0;
+	void* initialData = nil;
+	u64 initialDataSize = 0;
+
+	FILE* file = nil;
+	if (fopen_s(&file, filePath, "rb") == 0 && file != nil) {
+		PipelineCacheFileHeader header = {};
+		if (fread(&header, sizeof(header), 1, file) == 1 && isPipelineCacheFileHeaderValid(&header, properties)) {
+			initialData = malloc(header.dataSize);
+			if (initialData != nil && fread(initialData, 1, header.dataSize, file) == header.dataSize) {
+				initialDataSize = header.dataSize;
+			}
+		} else {
+			printf("pipeline cache %s was made by another device or driver. starting with an empty cache\n", filePath);
+		}
+		fclose(file);
+	}
+
+	//the driver checks its own header too, but a cache it rejects fails creation on some drivers instead of being ignored
+	if (initialDataSize >= sizeof(VkPipelineCacheHeaderVersionOne)) {
+		VkPipelineCacheHeaderVersionOne* driverHeader = (VkPipelineCacheHeaderVersionOne*)initialData;
+		if (
+			driverHeader->headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+			driverHeader->vendorID != properties->vendorID ||
+			driverHeader->deviceID != properties->deviceID ||
+			memcmp(driverHeader->pipelineCacheUUID, properties->pipelineCacheUUID, VK_UUID_SIZE) != 0
+		) {
+			initialDataSize = 0;
+		}
+	} else {
+		initialDataSize = 0;
+	}
+
+	VkPipelineCacheCreateInfo pipelineCacheInfo = {};
+	pipelineCacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	pipelineCacheInfo.initialDataSize = initialDataSize;
+	pipelineCacheInfo.pInitialData = initialDataSize > 0 ? initialData : nil;
+	VkResult result = vkCreatePipelineCache(renderer->device, &pipelineCacheInfo, nil, &renderer->pipelineCache);
+	if (result != VK_SUCCESS && initialDataSize > 0) {
+		pipelineCacheInfo.initialDataSize = 0;
+		pipelineCacheInfo.pInitialData = nil;
+		result = vkCreatePipelineCache(renderer->device, &pipelineCacheInfo, nil, &renderer->pipelineCache);
+		initialDataSize = 0;
+	}
+	free(initialData);
+	*isWarm = result == VK_SUCCESS && initialDataSize > 0;
+	return result;
+}
+
+bool32 savePipelineCache(Renderer* renderer) {
+	if (renderer->pipelineCache == VK_NULL_HANDLE) {
+		return 0;
+	}
+	size_t dataSize = 0;
+	if (vkGetPipelineCacheData(renderer->device, renderer->pipelineCache, &dataSize, nil) != VK_SUCCESS || dataSize == 0) {
+		return 0;
+	}
+	void* data = malloc(dataSize);
+	if (vkGetPipelineCacheData(renderer->device, renderer->pipelineCache, &dataSize, data) != VK_SUCCESS) {
+		free(data);
+		return 0;
+	}
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(renderer->physicalDevice, &properties);
+	PipelineCacheFileHeader header = {};
+	header.magic = PIPELINE_CACHE_FILE_MAGIC;
+	header.vendorID = properties.vendorID;
+	header.deviceID = properties.deviceID;
+	header.driverVersion = properties.driverVersion;
+	memcpy(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE);
+	header.dataSize = dataSize;
+
+	//written to a temporary file first, so a crash while saving never leaves a truncated cache behind
+	char temporaryFilePath[256];
+	snprintf(temporaryFilePath, sizeof(temporaryFilePath), "%s.tmp", PIPELINE_CACHE_FILE_PATH);
+	FILE* file = nil;
+	if (fopen_s(&file, temporaryFilePath, "wb") != 0 || file == nil) {
+		printf("unable to open %s for writing\n", temporaryFilePath);
+		free(data);
+		return 0;
+	}
+	bool32 isWritten = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(data, 1, dataSize, file) == dataSize;
+	isWritten = fclose(file) == 0 && isWritten;
+	free(data);
+	if (!isWritten) {
+		printf("unable to write the pipeline cache to %s\n", temporaryFilePath);
+		remove(temporaryFilePath);
+		return 0;
+	}
+	remove(PIPELINE_CACHE_FILE_PATH);
+	if (rename(temporaryFilePath, PIPELINE_CACHE_FILE_PATH) != 0) {
+		printf("unable to move %s to %s\n", temporaryFilePath, PIPELINE_CACHE_FILE_PATH);
+		return 0;
+	}
+	return 1;
+}
+
 VkResult handleRenderResizing(Renderer* renderer) {
-	return createSwapchainAndRenderPass(renderer->window, renderer->physicalDevice, renderer->device, renderer->surface, renderer->queueFamilyIndices, renderer->queueFamilyIndicesCount, renderer->isUsingSameQueueForGraphicsAndPresent, &renderer->renderPass, renderer->swapchain, &renderer->depthImage);
+	return createSwapchainAndRenderPass(renderer->window, renderer->physicalDevice, renderer->device, renderer->surface, renderer->queueFamilyIndices, renderer->queueFamilyIndicesCount, renderer->isUsingSameQueueForGraphicsAndPresent, &renderer->renderPass, renderer->swapchain, &renderer->depthImage, renderer->deviceMemory);
 }
 
 VkResult createSwapchainAndRenderPass(
@@ -302,7 +1062,8 @@ VkResult createSwapchainAndRenderPass(
 	bool32 isUsingSameQueueForGraphicsAndPresent,
 	VkRenderPass *renderPass,
 	Swapchain *swapchain,
-	Image *depthImage
+	Image *depthImage,
+	DeviceMemory *deviceMemory
 ) {
 	vkDeviceWaitIdle(device);
 	VkResult result;
@@ -391,7 +1152,7 @@ VkResult createSwapchainAndRenderPass(
 	if (depthImage->image != VK_NULL_HANDLE) {
 		vkDestroyImageView(device, depthImage->imageView, nil);
 		vkDestroyImage(device, depthImage->image, nil);
-		vkFreeMemory(device, depthImage->memory, nil);
+		freeGPUMemory(&deviceMemory->allocator, &depthImage->allocation);
 	}
 
 	VkFormat depthFormat = VK_FORMAT_D32_SFLOAT;
@@ -421,21 +1182,12 @@ VkResult createSwapchainAndRenderPass(
 	vkGetImageMemoryRequirements(device, depthImage->image, &depthImageMemoryRequirements);
 
 
-	VkPhysicalDeviceMemoryProperties memoryProperties;
-	vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
-
-	VkMemoryAllocateInfo depthImageMemoryAllocInfo = {};
-	depthImageMemoryAllocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-	depthImageMemoryAllocInfo.allocationSize = depthImageMemoryRequirements.size;
-	depthImageMemoryAllocInfo.memoryTypeIndex = findMemoryType(memoryProperties, depthImageMemoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-	result = vkAllocateMemory(device, &depthImageMemoryAllocInfo, nil, &depthImage->memory);
-	if (result != VK_SUCCESS) {
+	if (!allocateDeviceMemory(deviceMemory, depthImageMemoryRequirements, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, GPU_RESOURCE_OPTIMAL, &depthImage->allocation)) {
 		printf("unable to alloate memory for depth image!\n");
-		return result;
+		return VK_ERROR_OUT_OF_DEVICE_MEMORY;
 	}
 
-	vkBindImageMemory(device, depthImage->image, depthImage->memory, 0);
+	vkBindImageMemory(device, depthImage->image, getAllocationMemory(deviceMemory, &depthImage->allocation), depthImage->allocation.offset);
 
 	VkImageViewCreateInfo depthImageViewInfo = {};
 	depthImageViewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -596,7 +1348,7 @@ VkResult createSwapchainAndRenderPass(
 	return VK_SUCCESS;
 }
 
-int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memoryAllocator) {
+int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memoryAllocator, JobQueue* jobQueue) {
 	VkApplicationInfo appInfo = {};
 	appInfo.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
 	appInfo.pApplicationName = "Hello Triangle";
@@ -756,10 +1508,32 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 	vkGetPhysicalDeviceProperties(renderer->physicalDevice, &physicalDeviceProperties);
 	printf("Using GPU Device: %s\n", physicalDeviceProperties.deviceName);
 
+	VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+	vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
 	VkPhysicalDeviceFeatures2 deviceFeatures = {};
 	deviceFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	bool32 isVulkan12Supported = physicalDeviceProperties.apiVersion >= VK_API_VERSION_1_2;
+	if (isVulkan12Supported) {
+		deviceFeatures.pNext = &vulkan12Features;
+	}
 	vkGetPhysicalDeviceFeatures2(renderer->physicalDevice, &deviceFeatures);
 
+	//gpu culling writes one indirect draw per visible batch, each starting at its own offset into the visible instance list
+	renderer->gpuCulling = {};
+	renderer->gpuCulling.isSupported =
+		deviceFeatures.features.multiDrawIndirect &&
+		deviceFeatures.features.drawIndirectFirstInstance &&
+		physicalDeviceProperties.limits.maxDrawIndirectCount >= MAX_CULLING_BATCHES;
+	renderer->gpuCulling.isEnabled = renderer->gpuCulling.isSupported;
+	renderer->gpuCulling.isDrawIndirectCountSupported = renderer->gpuCulling.isSupported && isVulkan12Supported && vulkan12Features.drawIndirectCount;
+	if (!renderer->gpuCulling.isSupported) {
+		printf("the device doesn't support multi draw indirect. gpu culling is disabled\n");
+	} else if (!renderer->gpuCulling.isDrawIndirectCountSupported) {
+		printf("the device doesn't support draw indirect count. culled batches are drawn with empty indirect draws\n");
+	}
+	renderer->isTextureCompressionBCSupported = deviceFeatures.features.textureCompressionBC;
+
 	u32	queueFamilyCount = 0;
 
 	bool foundGraphicsQueueFamily = false;
@@ -802,7 +1576,19 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 
 	renderer->isUsingSameQueueForGraphicsAndPresent = graphicsQueueFamilyIndex == presentQueueFamilyIndex;
 
+	//a transfer only family is usually backed by a dma engine that copies while the graphics queue keeps rendering
+	u32 transferQueueFamilyIndex = graphicsQueueFamilyIndex;
+	for (u32 i = 0; i < queueFamilyCount; i++) {
+		VkQueueFlags flags = queueFamilyProperties[i].queueFlags;
+		if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+			transferQueueFamilyIndex = i;
+			printf("queue family %d is a dedicated transfer queue\n", i);
+			break;
+		}
+	}
+
 	VkDeviceQueueCreateInfo queueCreateInfos[3] = {};
+	f32 queuePriority = 1.0f;
 
 	u32 queueCreateInfoCount = 1;
 	{
@@ -810,7 +1596,6 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 		queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
 		queueCreateInfo.queueFamilyIndex = graphicsQueueFamilyIndex;
 		queueCreateInfo.queueCount = 1;
-		f32 queuePriority = 1.0f;
 		queueCreateInfo.pQueuePriorities = &queuePriority;
 
 		queueCreateInfos[0] = queueCreateInfo;
@@ -823,14 +1608,22 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 		queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
 		queueCreateInfo.queueFamilyIndex = presentQueueFamilyIndex;
 		queueCreateInfo.queueCount = 1;
-		f32 queuePriority = 1.0f;
 		queueCreateInfo.pQueuePriorities = &queuePriority;
 
-		queueCreateInfos[1] = queueCreateInfo;
+		queueCreateInfos[queueCreateInfoCount] = queueCreateInfo;
 		queueCreateInfoCount += 1;
 	}
 
-	//TODO: support separate transfer queues
+	if (transferQueueFamilyIndex != graphicsQueueFamilyIndex && transferQueueFamilyIndex != presentQueueFamilyIndex) {
+		VkDeviceQueueCreateInfo queueCreateInfo = {};
+		queueCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO;
+		queueCreateInfo.queueFamilyIndex = transferQueueFamilyIndex;
+		queueCreateInfo.queueCount = 1;
+		queueCreateInfo.pQueuePriorities = &queuePriority;
+
+		queueCreateInfos[queueCreateInfoCount] = queueCreateInfo;
+		queueCreateInfoCount += 1;
+	}
 
 	u32 requiredDeviceExtensionsCount = 1;
 	const char* requiredDeviceExtensions[1] = {
@@ -883,6 +1676,9 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 	desiredDeviceFeatures.features.shaderStorageBufferArrayDynamicIndexing = 1;
 	desiredDeviceFeatures.features.shaderStorageImageArrayDynamicIndexing = 1;
 	desiredDeviceFeatures.features.inheritedQueries = 1;
+	desiredDeviceFeatures.features.multiDrawIndirect = renderer->gpuCulling.isSupported;
+	desiredDeviceFeatures.features.drawIndirectFirstInstance = renderer->gpuCulling.isSupported;
+	desiredDeviceFeatures.features.textureCompressionBC = renderer->isTextureCompressionBCSupported;
 
 	VkPhysicalDeviceShaderDrawParametersFeatures shaderDrawParametersFeatures = {};
 	shaderDrawParametersFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SHADER_DRAW_PARAMETERS_FEATURES;
@@ -890,6 +1686,13 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 	shaderDrawParametersFeatures.shaderDrawParameters = VK_TRUE;
 	desiredDeviceFeatures.pNext = &shaderDrawParametersFeatures;
 
+	VkPhysicalDeviceVulkan12Features desiredVulkan12Features = {};
+	desiredVulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	desiredVulkan12Features.drawIndirectCount = renderer->gpuCulling.isDrawIndirectCountSupported;
+	if (isVulkan12Supported) {
+		shaderDrawParametersFeatures.pNext = &desiredVulkan12Features;
+	}
+
 	VkDeviceCreateInfo deviceCreateInfo = {};
 	deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
 	deviceCreateInfo.pQueueCreateInfos = queueCreateInfos;
@@ -914,6 +1717,9 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 		vkGetDeviceQueue(renderer->device, presentQueueFamilyIndex, 0, &renderer->presentQueue);
 	}
 
+	renderer->transferQueueFamilyIndex = transferQueueFamilyIndex;
+	vkGetDeviceQueue(renderer->device, transferQueueFamilyIndex, 0, &renderer->transferQueue);
+
 	renderer->queueFamilyIndicesCount = 2;
 	renderer->queueFamilyIndices = (u32*) allocateMemory(memoryAllocator, renderer->queueFamilyIndicesCount * sizeof(u32)); 
 	renderer->queueFamilyIndices[0] = graphicsQueueFamilyIndex;
@@ -922,6 +1728,10 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 	renderer->swapchain = (Swapchain*) allocateMemory(memoryAllocator, sizeof(Swapchain));
 	renderer->swapchain->handle = VK_NULL_HANDLE;
 
+	renderer->deviceMemory = (DeviceMemory*) allocateMemory(memoryAllocator, sizeof(DeviceMemory));
+	memset(renderer->deviceMemory, 0, sizeof(DeviceMemory));
+	initDeviceMemory(renderer->deviceMemory, renderer->physicalDevice, renderer->device);
+
 	renderer->depthImage = {};
 
 	if (createSwapchainAndRenderPass(
@@ -934,7 +1744,8 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 		renderer->isUsingSameQueueForGraphicsAndPresent,
 		&renderer->renderPass,
 		renderer->swapchain,
-		&renderer->depthImage) != VK_SUCCESS
+		&renderer->depthImage,
+		renderer->deviceMemory) != VK_SUCCESS
 		)
 	{
 		printf("unable to create swapchain!\n");
@@ -942,8 +1753,6 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 	}
 
 
-	const u32 texturesArrayCapacity = 4096;
-
 	VkDescriptorSetLayoutBinding uniformBufferLayoutBinding = {};
 	uniformBufferLayoutBinding.binding = 0;
 	uniformBufferLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
@@ -974,7 +1783,28 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 	objectColorDataBinding.pImmutableSamplers = nil;
 	objectColorDataBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
 
-	VkDescriptorSetLayoutBinding objectDataBindings[] = {objectTransformDataBinding, objectColorDataBinding};
+	VkDescriptorSetLayoutBinding objectInstanceIndexBinding = {};
+	objectInstanceIndexBinding.binding = 2;
+	objectInstanceIndexBinding.descriptorCount = 1;
+	objectInstanceIndexBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	objectInstanceIndexBinding.pImmutableSamplers = nil;
+	objectInstanceIndexBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+	VkDescriptorSetLayoutBinding objectOcclusionDataBinding = {};
+	objectOcclusionDataBinding.binding = 3;
+	objectOcclusionDataBinding.descriptorCount = 1;
+	objectOcclusionDataBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	objectOcclusionDataBinding.pImmutableSamplers = nil;
+	objectOcclusionDataBinding.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+	VkDescriptorSetLayoutBinding voxelShadowDataBinding = {};
+	voxelShadowDataBinding.binding = 4;
+	voxelShadowDataBinding.descriptorCount = 1;
+	voxelShadowDataBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	voxelShadowDataBinding.pImmutableSamplers = nil;
+	voxelShadowDataBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	VkDescriptorSetLayoutBinding objectDataBindings[] = {objectTransformDataBinding, objectColorDataBinding, objectInstanceIndexBinding, objectOcclusionDataBinding, voxelShadowDataBinding};
 
 	VkDescriptorSetLayoutCreateInfo objectDataLayoutInfo = {};
 	objectDataLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
@@ -994,7 +1824,7 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 
 	VkDescriptorSetLayoutBinding texturesLayoutBinding = {};
 	texturesLayoutBinding.binding = 1;
-	texturesLayoutBinding.descriptorCount = texturesArrayCapacity;
+	texturesLayoutBinding.descriptorCount = 1;
 	texturesLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
 	texturesLayoutBinding.pImmutableSamplers = nil;
 	texturesLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
@@ -1009,6 +1839,12 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 
 	vkCheck(vkCreateDescriptorSetLayout(renderer->device, &texturesLayoutInfo, nil, &renderer->texturesSetLayout));
 
+	f64 pipelineCreationStartSeconds = getWallClockSeconds();
+	if (createPipelineCache(renderer, &physicalDeviceProperties, PIPELINE_CACHE_FILE_PATH, &renderer->isPipelineCacheWarm) != VK_SUCCESS) {
+		printf("unable to create pipeline cache!\n");
+		return 1;
+	}
+
 	/* Texture Graphics Pipeline */
 	{
 		const char* vertexShaderFilePath = "./spir-v/textured_shader.vert.spv";
@@ -1189,7 +2025,7 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 		pipelineCreateInfo.basePipelineIndex = -1;
 		pipelineCreateInfo.pDepthStencilState = &pipelineDepthStencilInfo;
 
-		if (vkCreateGraphicsPipelines(renderer->device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nil, &renderer->texturePipeline) != VK_SUCCESS) {
+		if (vkCreateGraphicsPipelines(renderer->device, renderer->pipelineCache, 1, &pipelineCreateInfo, nil, &renderer->texturePipeline) != VK_SUCCESS) {
 			printf("unable to create graphics pipeline!\n");
 			return 1;
 		}
@@ -1318,7 +2154,7 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 
 		VkPushConstantRange pushConstant = {};
 		pushConstant.offset = 0;
-		pushConstant.size = sizeof(TexturePushConstants);
+		pushConstant.size = sizeof(VoxelShadowPushConstants);
 		pushConstant.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
 		VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
@@ -1366,12 +2202,235 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 		pipelineCreateInfo.basePipelineIndex = -1;
 		pipelineCreateInfo.pDepthStencilState = &pipelineDepthStencilInfo;
 
-		if (vkCreateGraphicsPipelines(renderer->device, VK_NULL_HANDLE, 1, &pipelineCreateInfo, nil, &renderer->voxelPipeline) != VK_SUCCESS) {
+		if (vkCreateGraphicsPipelines(renderer->device, renderer->pipelineCache, 1, &pipelineCreateInfo, nil, &renderer->voxelPipeline) != VK_SUCCESS) {
+			printf("unable to create graphics pipeline!\n");
+			return 1;
+		}
+
+		//translucent voxels are blended over what's behind them, so they can't hide the ones drawn after them
+		pipelineDepthStencilInfo.depthWriteEnable = VK_FALSE;
+		if (vkCreateGraphicsPipelines(renderer->device, renderer->pipelineCache, 1, &pipelineCreateInfo, nil, &renderer->translucentVoxelPipeline) != VK_SUCCESS) {
 			printf("unable to create graphics pipeline!\n");
 			return 1;
 		}
 	}
 
+	/* Grid Pipeline */
+	{
+		const char* vertexShaderFilePath = "./spir-v/grid_shader.vert.spv";
+		VkShaderModule vertexShaderModule;
+		if (createShaderFromFile(renderer->device, vertexShaderFilePath, &vertexShaderModule) != VK_SUCCESS) {
+			printf("unable to create vertex shader module!\n");
+			return 1;
+		}
+
+		const char* fragmentShaderFilePath = "./spir-v/grid_shader.frag.spv";
+		VkShaderModule fragmentShaderModule;
+		if (createShaderFromFile(renderer->device, fragmentShaderFilePath, &fragmentShaderModule) != VK_SUCCESS) {
+			printf("unable to create fragment shader module!\n");
+			return 1;
+		}
+
+		VkPipelineShaderStageCreateInfo vertexShaderStageCreateInfo = {};
+		vertexShaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		vertexShaderStageCreateInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
+		vertexShaderStageCreateInfo.module = vertexShaderModule;
+		vertexShaderStageCreateInfo.pName = "main";
+
+		VkPipelineShaderStageCreateInfo fragmentShaderStageCreateInfo = {};
+		fragmentShaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		fragmentShaderStageCreateInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		fragmentShaderStageCreateInfo.module = fragmentShaderModule;
+		fragmentShaderStageCreateInfo.pName = "main";
+
+		VkPipelineShaderStageCreateInfo pipelineShaderStageCreateInfos[] = {
+			vertexShaderStageCreateInfo,
+			fragmentShaderStageCreateInfo
+		};
+
+		const u32 numDynamicStates = 2;
+		VkDynamicState dynamicStates[numDynamicStates] = {
+			VK_DYNAMIC_STATE_VIEWPORT,
+			VK_DYNAMIC_STATE_SCISSOR
+		};
+
+		VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo = {};
+		dynamicStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamicStateCreateInfo.dynamicStateCount = 2;
+		dynamicStateCreateInfo.pDynamicStates = dynamicStates;
+
+		//the quad's corners come from the vertex index
+		VkPipelineVertexInputStateCreateInfo vertexInputStateCreateInfo = {};
+		vertexInputStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+		vertexInputStateCreateInfo.vertexBindingDescriptionCount = 0;
+		vertexInputStateCreateInfo.vertexAttributeDescriptionCount = 0;
+
+		VkPipelineInputAssemblyStateCreateInfo inputAssemblyStateCreateInfo = {};
+		inputAssemblyStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		inputAssemblyStateCreateInfo.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+		inputAssemblyStateCreateInfo.primitiveRestartEnable = VK_FALSE;
+
+		VkPipelineViewportStateCreateInfo viewportStateCreateInfo = {};
+		viewportStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		viewportStateCreateInfo.viewportCount = 1;
+		viewportStateCreateInfo.scissorCount = 1;
+
+		//the grid is seen from above and below
+		VkPipelineRasterizationStateCreateInfo rasterizationStateCreateInfo = {};
+		rasterizationStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		rasterizationStateCreateInfo.depthClampEnable = VK_FALSE;
+		rasterizationStateCreateInfo.rasterizerDiscardEnable = VK_FALSE;
+		rasterizationStateCreateInfo.polygonMode = VK_POLYGON_MODE_FILL;
+		rasterizationStateCreateInfo.lineWidth = 1.0f;
+		rasterizationStateCreateInfo.cullMode = VK_CULL_MODE_NONE;
+		rasterizationStateCreateInfo.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+		rasterizationStateCreateInfo.depthBiasEnable = false;
+		rasterizationStateCreateInfo.depthBiasConstantFactor = 0.0f;
+		rasterizationStateCreateInfo.depthBiasClamp = 0.0f;
+		rasterizationStateCreateInfo.depthBiasSlopeFactor = 0.0f;
+
+		VkPipelineMultisampleStateCreateInfo multisamplingStateCreateInfo = {};
+		multisamplingStateCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		multisamplingStateCreateInfo.sampleShadingEnable = VK_FALSE;
+		multisamplingStateCreateInfo.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+		multisamplingStateCreateInfo.minSampleShading = 1.0f;
+		multisamplingStateCreateInfo.pSampleMask = nil;
+		multisamplingStateCreateInfo.alphaToCoverageEnable = VK_FALSE;
+		multisamplingStateCreateInfo.alphaToOneEnable = VK_FALSE;
+
+		VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+		colorBlendAttachment.blendEnable = VK_TRUE;
+		colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+		colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+		colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+		colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+		VkPipelineColorBlendStateCreateInfo colorBlendingState = {};
+		colorBlendingState.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		colorBlendingState.logicOpEnable = VK_FALSE;
+		colorBlendingState.logicOp = VK_LOGIC_OP_COPY;
+		colorBlendingState.attachmentCount = 1;
+		colorBlendingState.pAttachments = &colorBlendAttachment;
+
+		VkPushConstantRange pushConstant = {};
+		pushConstant.offset = 0;
+		pushConstant.size = sizeof(GridPushConstants);
+		pushConstant.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+		VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+		pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutCreateInfo.setLayoutCount = 1;
+		pipelineLayoutCreateInfo.pSetLayouts = &renderer->uniformBufferDescriptorSetLayout;
+		pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+		pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstant;
+
+		if (vkCreatePipelineLayout(renderer->device, &pipelineLayoutCreateInfo, nil, &renderer->gridPipelineLayout) != VK_SUCCESS) {
+			printf("unable to create pipeline layout!\n");
+			return 1;
+		}
+
+		//tested against the voxels, but doesn't write depth, so voxels drawn after it aren't hidden by its empty pixels
+		VkPipelineDepthStencilStateCreateInfo pipelineDepthStencilInfo = {};
+		pipelineDepthStencilInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		pipelineDepthStencilInfo.depthTestEnable = VK_TRUE;
+		pipelineDepthStencilInfo.depthWriteEnable = VK_FALSE;
+		pipelineDepthStencilInfo.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+		pipelineDepthStencilInfo.depthBoundsTestEnable = VK_FALSE;
+		pipelineDepthStencilInfo.minDepthBounds = 0.0f;
+		pipelineDepthStencilInfo.maxDepthBounds = 1.0f;
+		pipelineDepthStencilInfo.stencilTestEnable = VK_FALSE;
+		pipelineDepthStencilInfo.front = {};
+		pipelineDepthStencilInfo.back = {};
+
+		VkGraphicsPipelineCreateInfo pipelineCreateInfo = {};
+
+		pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineCreateInfo.stageCount = 2;
+		pipelineCreateInfo.pStages = pipelineShaderStageCreateInfos;
+		pipelineCreateInfo.pVertexInputState = &vertexInputStateCreateInfo;
+		pipelineCreateInfo.pInputAssemblyState = &inputAssemblyStateCreateInfo;
+		pipelineCreateInfo.pViewportState = &viewportStateCreateInfo;
+		pipelineCreateInfo.pRasterizationState = &rasterizationStateCreateInfo;
+		pipelineCreateInfo.pMultisampleState = &multisamplingStateCreateInfo;
+		pipelineCreateInfo.pColorBlendState = &colorBlendingState;
+		pipelineCreateInfo.pDynamicState = &dynamicStateCreateInfo;
+		pipelineCreateInfo.layout = renderer->gridPipelineLayout;
+		pipelineCreateInfo.renderPass = renderer->renderPass;
+		pipelineCreateInfo.subpass = 0;
+		pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+		pipelineCreateInfo.basePipelineIndex = -1;
+		pipelineCreateInfo.pDepthStencilState = &pipelineDepthStencilInfo;
+
+		if (vkCreateGraphicsPipelines(renderer->device, renderer->pipelineCache, 1, &pipelineCreateInfo, nil, &renderer->gridPipeline) != VK_SUCCESS) {
+			printf("unable to create graphics pipeline!\n");
+			return 1;
+		}
+	}
+
+	/* Instance Culling Pipeline */
+	if (renderer->gpuCulling.isSupported) {
+		//batches, visible instance indices, indirect draws, counters
+		VkDescriptorSetLayoutBinding cullingBindings[4] = {};
+		for (u32 i = 0; i < sizeof(cullingBindings) / sizeof(cullingBindings[0]); i++) {
+			cullingBindings[i].binding = i;
+			cullingBindings[i].descriptorCount = 1;
+			cullingBindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			cullingBindings[i].pImmutableSamplers = nil;
+			cullingBindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+		}
+
+		VkDescriptorSetLayoutCreateInfo cullingLayoutInfo = {};
+		cullingLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		cullingLayoutInfo.bindingCount = sizeof(cullingBindings) / sizeof(cullingBindings[0]);
+		cullingLayoutInfo.pBindings = cullingBindings;
+		vkCheck(vkCreateDescriptorSetLayout(renderer->device, &cullingLayoutInfo, nil, &renderer->gpuCulling.descriptorSetLayout));
+
+		const char* computeShaderFilePath = "./spir-v/cull_instances.comp.spv";
+		VkShaderModule computeShaderModule;
+		if (createShaderFromFile(renderer->device, computeShaderFilePath, &computeShaderModule) != VK_SUCCESS) {
+			printf("unable to create compute shader module!\n");
+			return 1;
+		}
+
+		VkPushConstantRange pushConstant = {};
+		pushConstant.offset = 0;
+		pushConstant.size = sizeof(CullingPushConstants);
+		pushConstant.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+		VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = {};
+		pipelineLayoutCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutCreateInfo.setLayoutCount = 1;
+		pipelineLayoutCreateInfo.pSetLayouts = &renderer->gpuCulling.descriptorSetLayout;
+		pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+		pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstant;
+
+		if (vkCreatePipelineLayout(renderer->device, &pipelineLayoutCreateInfo, nil, &renderer->gpuCulling.pipelineLayout) != VK_SUCCESS) {
+			printf("unable to create pipeline layout!\n");
+			return 1;
+		}
+
+		VkComputePipelineCreateInfo pipelineCreateInfo = {};
+		pipelineCreateInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineCreateInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipelineCreateInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipelineCreateInfo.stage.module = computeShaderModule;
+		pipelineCreateInfo.stage.pName = "main";
+		pipelineCreateInfo.layout = renderer->gpuCulling.pipelineLayout;
+		pipelineCreateInfo.basePipelineHandle = VK_NULL_HANDLE;
+		pipelineCreateInfo.basePipelineIndex = -1;
+
+		if (vkCreateComputePipelines(renderer->device, renderer->pipelineCache, 1, &pipelineCreateInfo, nil, &renderer->gpuCulling.pipeline) != VK_SUCCESS) {
+			printf("unable to create compute pipeline!\n");
+			return 1;
+		}
+	}
+
+	//imgui's pipeline is created later, and added to this
+	renderer->pipelineCreationMilliseconds = 1000.0 * (getWallClockSeconds() - pipelineCreationStartSeconds);
+
 	VkCommandPoolCreateInfo commandPoolInfo = {};
 	commandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 	commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
@@ -1381,6 +2440,19 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 		return 1;
 	}
 
+	if (transferQueueFamilyIndex != graphicsQueueFamilyIndex) {
+		VkCommandPoolCreateInfo transferCommandPoolInfo = {};
+		transferCommandPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		transferCommandPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		transferCommandPoolInfo.queueFamilyIndex = transferQueueFamilyIndex;
+		if (vkCreateCommandPool(renderer->device, &transferCommandPoolInfo, nil, &renderer->transferCommandPool) != VK_SUCCESS) {
+			printf("unable to create transfer command pool!\n");
+			return 1;
+		}
+	} else {
+		renderer->transferCommandPool = renderer->commandPool;
+	}
+
 	const u32 cubeFrontFaceOffset = 0;
 	const u32 cubeBackFaceOffset = 6;
 	const u32 cubeLeftSideFaceOffset = 12;
@@ -1487,22 +2559,20 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 		{ { -0.5f,  0.5f, -0.5f, }, },
 	};
 
-	vkGetPhysicalDeviceMemoryProperties(renderer->physicalDevice, &renderer->physicalDeviceMemoryProperties);
-
-	renderer->stagingBuffer = createBuffer(renderer->physicalDeviceMemoryProperties, renderer->device, 100*1000*1000, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	renderer->stagingBuffer = createBuffer(renderer->deviceMemory, 100*1000*1000, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 	if (renderer->stagingBuffer.createResult != VK_SUCCESS) {
 		printf("failed to create staging buffer!!!\n");
 		return 1;
 	}
 
-	renderer->texturedCubeVertexBuffer = createBuffer(renderer->physicalDeviceMemoryProperties, renderer->device, sizeof(positionColorTextureCubeVertices), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	renderer->texturedCubeVertexBuffer = createBuffer(renderer->deviceMemory, sizeof(positionColorTextureCubeVertices), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 	if (renderer->texturedCubeVertexBuffer.createResult != VK_SUCCESS) {
 		printf("failed to create textured cube vertex buffer!!!\n");
 		return 1;
 	}
 
 
-	renderer->cubeVertexBuffer = createBuffer(renderer->physicalDeviceMemoryProperties, renderer->device, sizeof(positionCubeVertices), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	renderer->cubeVertexBuffer = createBuffer(renderer->deviceMemory, sizeof(positionCubeVertices), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 	if (renderer->cubeVertexBuffer.createResult != VK_SUCCESS) {
 		printf("failed to create cube vertex buffer!!!\n");
 		return 1;
@@ -1522,10 +2592,7 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 	{
 		vkResetCommandBuffer(copyDataCmdBuffer, 0);
 
-		void *data;
-		vkMapMemory(renderer->device, renderer->stagingBuffer.memory, 0, renderer->stagingBuffer.size, 0, &data);
-		memcpy(data, positionColorTextureCubeVertices, sizeof(positionColorTextureCubeVertices));
-		vkUnmapMemory(renderer->device, renderer->stagingBuffer.memory);
+		memcpy(renderer->stagingBuffer.mappedData, positionColorTextureCubeVertices, sizeof(positionColorTextureCubeVertices));
 
 		VkCommandBufferBeginInfo beginInfo = {};
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -1551,10 +2618,7 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 	{
 		vkResetCommandBuffer(copyDataCmdBuffer, 0);
 
-		void *data;
-		vkMapMemory(renderer->device, renderer->stagingBuffer.memory, 0, renderer->stagingBuffer.size, 0, &data);
-		memcpy(data, positionCubeVertices, sizeof(positionCubeVertices));
-		vkUnmapMemory(renderer->device, renderer->stagingBuffer.memory);
+		memcpy(renderer->stagingBuffer.mappedData, positionCubeVertices, sizeof(positionCubeVertices));
 
 		VkCommandBufferBeginInfo beginInfo = {};
 		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -1577,20 +2641,51 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 		vkQueueWaitIdle(renderer->graphicsQueue);
 	}
 
-	const u32 maxObjectsPerDraw = 100000;
-
 	for (u32 i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
-		renderer->uniformBuffers[i] = createBuffer(renderer->physicalDeviceMemoryProperties, renderer->device, sizeof(UniformBufferData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		renderer->uniformBuffers[i] = createBuffer(renderer->deviceMemory, sizeof(UniformBufferData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 		vkCheck(renderer->uniformBuffers[i].createResult);
-		vkMapMemory(renderer->device, renderer->uniformBuffers[i].memory, 0, sizeof(UniformBufferData), 0, &renderer->uniformBuffers[i].mappedData);
+	}
 
-		renderer->objectTransformBuffers[i] = createBuffer(renderer->physicalDeviceMemoryProperties, renderer->device, maxObjectsPerDraw*sizeof(math::Matrix4), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-		vkCheck(renderer->objectTransformBuffers[i].createResult);
-		vkMapMemory(renderer->device, renderer->objectTransformBuffers[i].memory, 0, maxObjectsPerDraw*sizeof(math::Matrix4), 0, &renderer->objectTransformBuffers[i].mappedData);
+	renderer->objectTransformBuffer = createBuffer(renderer->deviceMemory, MAX_GPU_OBJECTS*sizeof(math::Matrix4), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	vkCheck(renderer->objectTransformBuffer.createResult);
 
-		renderer->objectColorBuffers[i] = createBuffer(renderer->physicalDeviceMemoryProperties, renderer->device, maxObjectsPerDraw*sizeof(RGBAColorF32), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-		vkCheck(renderer->objectColorBuffers[i].createResult);
-		vkMapMemory(renderer->device, renderer->objectColorBuffers[i].memory, 0, maxObjectsPerDraw*sizeof(RGBAColorF32), 0, &renderer->objectColorBuffers[i].mappedData);
+	renderer->objectColorBuffer = createBuffer(renderer->deviceMemory, MAX_GPU_OBJECTS*sizeof(RGBAColorF32), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	vkCheck(renderer->objectColorBuffer.createResult);
+
+	renderer->objectOcclusionBuffer = createBuffer(renderer->deviceMemory, MAX_GPU_OBJECTS*sizeof(u64), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	vkCheck(renderer->objectOcclusionBuffer.createResult);
+
+	renderer->voxelShadowBuffer = createBuffer(renderer->deviceMemory, MAX_VOXEL_SHADOW_OCCUPANCY_SIZE, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	vkCheck(renderer->voxelShadowBuffer.createResult);
+
+	renderer->uploadRing = {};
+	renderer->uploadRing.buffer = createBuffer(renderer->deviceMemory, UPLOAD_RING_SIZE, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	vkCheck(renderer->uploadRing.buffer.createResult);
+
+	//the instance index list is bound to the voxel pipeline even when culling isn't supported
+	renderer->gpuCulling.instanceIndexBuffer = createBuffer(renderer->deviceMemory, MAX_OBJECTS_PER_DRAW*sizeof(u32), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	vkCheck(renderer->gpuCulling.instanceIndexBuffer.createResult);
+
+	if (renderer->gpuCulling.isSupported) {
+		GPUCulling* culling = &renderer->gpuCulling;
+		culling->batches = (GPUCullingBatch*) allocateMemory(memoryAllocator, MAX_CULLING_BATCHES * sizeof(GPUCullingBatch));
+		memset(culling->batches, 0, MAX_CULLING_BATCHES * sizeof(GPUCullingBatch));
+
+		culling->batchBuffer = createBuffer(renderer->deviceMemory, MAX_CULLING_BATCHES*sizeof(GPUCullingBatch), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		vkCheck(culling->batchBuffer.createResult);
+		culling->drawCommandBuffer = createBuffer(renderer->deviceMemory, MAX_CULLING_BATCHES*sizeof(VkDrawIndirectCommand), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		vkCheck(culling->drawCommandBuffer.createResult);
+		culling->countersBuffer = createBuffer(renderer->deviceMemory, sizeof(GPUCullingCounters), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		vkCheck(culling->countersBuffer.createResult);
+		for (u32 i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+			culling->readbackBuffers[i] = createBuffer(renderer->deviceMemory, sizeof(GPUCullingCounters), VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+			vkCheck(culling->readbackBuffers[i].createResult);
+		}
+
+		//batches that were never uploaded must read as empty, since they are culled before their first upload when the ring is full
+		VkCommandBuffer commandBuffer = beginSingleTimeCommands(renderer->device, renderer->commandPool);
+		vkCmdFillBuffer(commandBuffer, culling->batchBuffer.buffer, 0, VK_WHOLE_SIZE, 0);
+		endSingleTimeCommands(renderer->device, commandBuffer, renderer->commandPool, renderer->graphicsQueue);
 	}
 
 	VkSamplerCreateInfo nearestFilterSamplerInfo = {};
@@ -1606,10 +2701,11 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 	nearestFilterSamplerInfo.unnormalizedCoordinates = VK_FALSE;
 	nearestFilterSamplerInfo.compareEnable = VK_FALSE;
 	nearestFilterSamplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
-	nearestFilterSamplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	//texels stay sharp up close, while distant surfaces blend between mip levels instead of shimmering
+	nearestFilterSamplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
 	nearestFilterSamplerInfo.mipLodBias = 0.0f;
 	nearestFilterSamplerInfo.minLod = 0.0f;
-	nearestFilterSamplerInfo.maxLod = 0.0f;
+	nearestFilterSamplerInfo.maxLod = VK_LOD_CLAMP_NONE;
 
 	VkSampler nearestFilterSampler = {};
 	vkCheck(vkCreateSampler(renderer->device, &nearestFilterSamplerInfo, nil, &nearestFilterSampler));
@@ -1627,23 +2723,55 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 	descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
 	descriptorPoolInfo.poolSizeCount = sizeof(poolSizes)/sizeof(poolSizes[0]);
 	descriptorPoolInfo.pPoolSizes = poolSizes;
-	descriptorPoolInfo.maxSets = 7;//2 for view projection data (uniform buffer), 2 for object data (storage buffer), 2 for textures, 1 for imgui
+	descriptorPoolInfo.maxSets = 8;//2 for view projection data (uniform buffer), 2 for object data (storage buffer), 2 for textures, 1 for imgui, 1 for instance culling
 
 	VkDescriptorPool descriptorPool;
 	vkCheck(vkCreateDescriptorPool(renderer->device, &descriptorPoolInfo, nil, &descriptorPool));
 
-	Image textureImages[5] = {};
+	//the block textures are all the same size, so they are layers of one array. TexturePushConstants::imageIndex picks the layer
 	const i32 sideGrassImageIndex = 0;
 	const i32 dirtImageIndex = 1;
 	const i32 topGrassImageIndex = 2;
 	const i32 stoneImageIndex = 3;
 	const i32 sandImageIndex = 4;
 
-	loadTextureImage("./assets/textures/grass_side.png", renderer, &textureImages[sideGrassImageIndex]);
-	loadTextureImage("./assets/textures/dirt.png", renderer, &textureImages[dirtImageIndex]);
-	loadTextureImage("./assets/textures/grass_top.png", renderer, &textureImages[topGrassImageIndex]);
-	loadTextureImage("./assets/textures/stone.png", renderer, &textureImages[stoneImageIndex]);
-	loadTextureImage("./assets/textures/sand.png", renderer, &textureImages[sandImageIndex]);
+	const char* blockTextureNames[5] = {};
+	blockTextureNames[sideGrassImageIndex] = "grass_side";
+	blockTextureNames[dirtImageIndex] = "dirt";
+	blockTextureNames[topGrassImageIndex] = "grass_top";
+	blockTextureNames[stoneImageIndex] = "stone";
+	blockTextureNames[sandImageIndex] = "sand";
+	const u32 blockTexturesCount = sizeof(blockTextureNames) / sizeof(blockTextureNames[0]);
+
+	const char* blockTextureFilepaths[blockTexturesCount] = {};
+	char blockTextureFilepathsStorage[blockTexturesCount][64];
+	for (u32 i = 0; i < blockTexturesCount; i++) {
+		snprintf(blockTextureFilepathsStorage[i], sizeof(blockTextureFilepathsStorage[i]), "./assets/textures/%s.png", blockTextureNames[i]);
+		blockTextureFilepaths[i] = blockTextureFilepathsStorage[i];
+	}
+
+	//the baked pack skips decoding and mip generation entirely. the pngs are only decoded if it's missing, or if a png's size or
+	//modification time differs from the one it was baked from
+	AssetPack blockTexturePack;
+	bool32 isBlockTextureArrayLoaded = 0;
+	if (openAssetPack(BLOCK_TEXTURE_PACK_FILE_PATH, &blockTexturePack)) {
+		bool32 isPackStale = 0;
+		for (u32 i = 0; i < blockTexturesCount && !isPackStale; i++) {
+			AssetPackTexture* texture = findAssetPackTexture(&blockTexturePack, blockTextureNames[i]);
+			if (texture != nil && isAssetPackTextureStale(texture, blockTextureFilepaths[i])) {
+				printf("%s changed since %s was baked\n", blockTextureFilepaths[i], BLOCK_TEXTURE_PACK_FILE_PATH);
+				isPackStale = 1;
+			}
+		}
+		if (!isPackStale) {
+			isBlockTextureArrayLoaded = loadTextureArrayFromPack(&blockTexturePack, blockTextureNames, blockTexturesCount, renderer, &renderer->blockTextureArray);
+		}
+		closeAssetPack(&blockTexturePack);
+	}
+	if (!isBlockTextureArrayLoaded) {
+		printf("no usable asset pack at %s, decoding the block textures instead\n", BLOCK_TEXTURE_PACK_FILE_PATH);
+		loadTextureArray(blockTextureFilepaths, blockTexturesCount, renderer, &renderer->blockTextureArray, jobQueue);
+	}
 
 
 	for (u32 i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
@@ -1677,7 +2805,7 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 		bufferInfo.offset = 0;
 		bufferInfo.range = sizeof(UniformBufferData);
 
-		VkWriteDescriptorSet descriptorWrites[5] = {};
+		VkWriteDescriptorSet descriptorWrites[8] = {};
 
 		descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		descriptorWrites[0].dstSet = renderer->uniformBufferDescriptorSets[i];
@@ -1690,9 +2818,9 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 		descriptorWrites[0].pTexelBufferView = nil;
 
 		VkDescriptorBufferInfo objectTransformBufferInfo = {};
-		objectTransformBufferInfo.buffer = renderer->objectTransformBuffers[i].buffer;
+		objectTransformBufferInfo.buffer = renderer->objectTransformBuffer.buffer;
 		objectTransformBufferInfo.offset = 0;
-		objectTransformBufferInfo.range = (sizeof(math::Matrix4)) * maxObjectsPerDraw;
+		objectTransformBufferInfo.range = (sizeof(math::Matrix4)) * MAX_GPU_OBJECTS;
 		
 		descriptorWrites[1].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		descriptorWrites[1].dstSet = renderer->objectDataDescriptorSets[i];
@@ -1703,9 +2831,9 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 		descriptorWrites[1].pBufferInfo = &objectTransformBufferInfo;
 
 		VkDescriptorBufferInfo objectColorBufferInfo = {};
-		objectColorBufferInfo.buffer = renderer->objectColorBuffers[i].buffer;
+		objectColorBufferInfo.buffer = renderer->objectColorBuffer.buffer;
 		objectColorBufferInfo.offset = 0;
-		objectColorBufferInfo.range = (sizeof(RGBAColorF32)) * maxObjectsPerDraw;
+		objectColorBufferInfo.range = (sizeof(RGBAColorF32)) * MAX_GPU_OBJECTS;
 
 		descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		descriptorWrites[2].dstSet = renderer->objectDataDescriptorSets[i];
@@ -1728,30 +2856,89 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 		descriptorWrites[3].descriptorCount = 1;
 		descriptorWrites[3].pImageInfo = &samplerInfo;
 
-		VkDescriptorImageInfo texturesInfo [texturesArrayCapacity] = {};
-		for (u32 i = 0; i < texturesArrayCapacity; i++) {
-			texturesInfo[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			texturesInfo[i].imageView = textureImages[0].imageView;
-			texturesInfo[i].sampler = nil;
-		}
-		for (u32 i = 0; i < sizeof(textureImages)/sizeof(textureImages[0]); i++) {
-			texturesInfo[i].imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-			texturesInfo[i].imageView = textureImages[i].imageView;
-			texturesInfo[i].sampler = nil;
-		}
+		VkDescriptorImageInfo texturesInfo = {};
+		texturesInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		texturesInfo.imageView = renderer->blockTextureArray.imageView;
+		texturesInfo.sampler = nil;
 
 		descriptorWrites[4].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
 		descriptorWrites[4].dstSet = renderer->textureDescriptorSets[i];
 		descriptorWrites[4].dstBinding = 1;
 		descriptorWrites[4].dstArrayElement = 0;
 		descriptorWrites[4].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
-		descriptorWrites[4].descriptorCount = texturesArrayCapacity;
-		descriptorWrites[4].pImageInfo = texturesInfo;
-
+		descriptorWrites[4].descriptorCount = 1;
+		descriptorWrites[4].pImageInfo = &texturesInfo;
+
+		VkDescriptorBufferInfo instanceIndexBufferInfo = {};
+		instanceIndexBufferInfo.buffer = renderer->gpuCulling.instanceIndexBuffer.buffer;
+		instanceIndexBufferInfo.offset = 0;
+		instanceIndexBufferInfo.range = sizeof(u32) * MAX_OBJECTS_PER_DRAW;
+
+		descriptorWrites[5].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[5].dstSet = renderer->objectDataDescriptorSets[i];
+		descriptorWrites[5].dstBinding = 2;
+		descriptorWrites[5].dstArrayElement = 0;
+		descriptorWrites[5].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		descriptorWrites[5].descriptorCount = 1;
+		descriptorWrites[5].pBufferInfo = &instanceIndexBufferInfo;
+
+		VkDescriptorBufferInfo objectOcclusionBufferInfo = {};
+		objectOcclusionBufferInfo.buffer = renderer->objectOcclusionBuffer.buffer;
+		objectOcclusionBufferInfo.offset = 0;
+		objectOcclusionBufferInfo.range = sizeof(u64) * MAX_GPU_OBJECTS;
+
+		descriptorWrites[6].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[6].dstSet = renderer->objectDataDescriptorSets[i];
+		descriptorWrites[6].dstBinding = 3;
+		descriptorWrites[6].dstArrayElement = 0;
+		descriptorWrites[6].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		descriptorWrites[6].descriptorCount = 1;
+		descriptorWrites[6].pBufferInfo = &objectOcclusionBufferInfo;
+
+		VkDescriptorBufferInfo voxelShadowBufferInfo = {};
+		voxelShadowBufferInfo.buffer = renderer->voxelShadowBuffer.buffer;
+		voxelShadowBufferInfo.offset = 0;
+		voxelShadowBufferInfo.range = MAX_VOXEL_SHADOW_OCCUPANCY_SIZE;
+
+		descriptorWrites[7].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrites[7].dstSet = renderer->objectDataDescriptorSets[i];
+		descriptorWrites[7].dstBinding = 4;
+		descriptorWrites[7].dstArrayElement = 0;
+		descriptorWrites[7].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		descriptorWrites[7].descriptorCount = 1;
+		descriptorWrites[7].pBufferInfo = &voxelShadowBufferInfo;
 
 		vkUpdateDescriptorSets(renderer->device, sizeof(descriptorWrites)/sizeof(descriptorWrites[0]), descriptorWrites, 0, nil);
 	}
 
+	if (renderer->gpuCulling.isSupported) {
+		GPUCulling* culling = &renderer->gpuCulling;
+		VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
+		descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		descriptorSetAllocateInfo.descriptorPool = descriptorPool;
+		descriptorSetAllocateInfo.descriptorSetCount = 1;
+		descriptorSetAllocateInfo.pSetLayouts = &culling->descriptorSetLayout;
+		vkCheck(vkAllocateDescriptorSets(renderer->device, &descriptorSetAllocateInfo, &culling->descriptorSet));
+
+		Buffer* cullingBuffers[] = { &culling->batchBuffer, &culling->instanceIndexBuffer, &culling->drawCommandBuffer, &culling->countersBuffer };
+		VkDescriptorBufferInfo cullingBufferInfos[4] = {};
+		VkWriteDescriptorSet cullingDescriptorWrites[4] = {};
+		for (u32 i = 0; i < 4; i++) {
+			cullingBufferInfos[i].buffer = cullingBuffers[i]->buffer;
+			cullingBufferInfos[i].offset = 0;
+			cullingBufferInfos[i].range = VK_WHOLE_SIZE;
+
+			cullingDescriptorWrites[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			cullingDescriptorWrites[i].dstSet = culling->descriptorSet;
+			cullingDescriptorWrites[i].dstBinding = i;
+			cullingDescriptorWrites[i].dstArrayElement = 0;
+			cullingDescriptorWrites[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			cullingDescriptorWrites[i].descriptorCount = 1;
+			cullingDescriptorWrites[i].pBufferInfo = &cullingBufferInfos[i];
+		}
+		vkUpdateDescriptorSets(renderer->device, 4, cullingDescriptorWrites, 0, nil);
+	}
+
 	VkCommandBufferAllocateInfo commandBufferAllocInfo = {};
 	commandBufferAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 	commandBufferAllocInfo.commandPool = renderer->commandPool;
@@ -1780,6 +2967,24 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 		}
 	}
 
+	renderer->gpuProfiler = {};
+	u32 timestampValidBits = queueFamilyProperties[graphicsQueueFamilyIndex].timestampValidBits;
+	if (timestampValidBits > 0 && physicalDeviceProperties.limits.timestampPeriod > 0.0f) {
+		renderer->gpuProfiler.isSupported = 1;
+		renderer->gpuProfiler.nanosecondsPerTick = physicalDeviceProperties.limits.timestampPeriod;
+		renderer->gpuProfiler.timestampMask = timestampValidBits >= 64 ? UINT64_MAX : (1ull << timestampValidBits) - 1;
+
+		VkQueryPoolCreateInfo queryPoolInfo = {};
+		queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = 2 * PROFILER_MAX_GPU_ZONES;
+		for (u32 i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+			vkCheck(vkCreateQueryPool(renderer->device, &queryPoolInfo, nil, &renderer->gpuProfiler.frames[i].queryPool));
+		}
+	} else {
+		printf("the graphics queue doesn't support timestamps. gpu profiler zones are disabled\n");
+	}
+
 	//setup Dear ImGui
 	IMGUI_CHECKVERSION();
 	ImGui::CreateContext();
@@ -1792,7 +2997,7 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 	initInfo.Device = renderer->device;
 	initInfo.QueueFamily = graphicsQueueFamilyIndex;
 	initInfo.Queue = renderer->graphicsQueue;
-	initInfo.PipelineCache = VK_NULL_HANDLE;
+	initInfo.PipelineCache = renderer->pipelineCache;
 	initInfo.DescriptorPool = descriptorPool;
 	initInfo.Subpass = 0;
 	initInfo.MinImageCount = renderer->swapchain->minImageCount;
@@ -1800,7 +3005,11 @@ int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memory
 	initInfo.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
 	initInfo.Allocator = nil;
 	initInfo.CheckVkResultFn = vkCheck;
+	//imgui builds its pipeline from the cache too, so it's timed with the others
+	f64 imguiInitStartSeconds = getWallClockSeconds();
 	ImGui_ImplVulkan_Init(&initInfo, renderer->renderPass);
+	renderer->pipelineCreationMilliseconds += 1000.0 * (getWallClockSeconds() - imguiInitStartSeconds);
+	printf("created pipelines in %.2f ms (%s pipeline cache)\n", renderer->pipelineCreationMilliseconds, renderer->isPipelineCacheWarm ? "warm" : "cold");
 
 	{
 		VkCommandBuffer commandBuffer = beginSingleTimeCommands(renderer->device, renderer->commandPool);
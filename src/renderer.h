@@ -14,6 +14,10 @@
 #include "math.h"
 
 #include "memory.h"
+#include "profiler.h"
+#include "jobs.h"
+#include "asset_pack.h"
+#include "gpu_allocator.h"
 
 struct PositionColorTextureVertex {
 	f32 position[3];
@@ -24,6 +28,23 @@ struct PositionVertex {
 	f32 position[3];
 };
 const u32 MAX_FRAMES_IN_FLIGHT = 2;
+const u32 MAX_OBJECTS_PER_DRAW = 100000;
+const u64 UPLOAD_RING_SIZE = 32 * 1024 * 1024;
+const char* const PIPELINE_CACHE_FILE_PATH = "./pipeline_cache.bin";
+//written by asset-baker, see the assets target of the Makefile
+const char* const BLOCK_TEXTURE_PACK_FILE_PATH = "./assets/textures.vxpack";
+//instances are culled in fixed runs of consecutive instance indices. each visible batch becomes one indirect draw
+const u32 CULLING_BATCH_SIZE = 64;
+const u32 MAX_CULLING_BATCHES = (MAX_OBJECTS_PER_DRAW + CULLING_BATCH_SIZE - 1) / CULLING_BATCH_SIZE;
+//instances drawn with a first instance at or past this skip the culled index list. must match UNCULLED_INSTANCES_BASE in voxel_shader.vert
+const u32 UNCULLED_INSTANCES_BASE = MAX_OBJECTS_PER_DRAW;
+//the instances drawn over the voxels (markers, sorted translucent voxels, the selected voxel) have their own region of the object buffers
+//after the voxels' MAX_OBJECTS_PER_DRAW, so a full voxel region can't cut them off
+const u32 MAX_OVERLAY_OBJECTS = 256 * 1024 + 3;
+const u32 OVERLAY_OBJECTS_BASE = MAX_OBJECTS_PER_DRAW;
+const u32 MAX_GPU_OBJECTS = OVERLAY_OBJECTS_BASE + MAX_OVERLAY_OBJECTS;
+//the most bytes of shadow occupancy the voxel shader marches through. see voxel_shadow.h
+const u64 MAX_VOXEL_SHADOW_OCCUPANCY_SIZE = 2 * 1024 * 1024;
 
 struct Swapchain {
 	VkSwapchainKHR handle;
@@ -37,9 +58,10 @@ struct Swapchain {
 
 struct Buffer {
 	VkBuffer buffer;
-	VkDeviceMemory memory;
+	GPUAllocation allocation;
 	VkResult createResult;
 	VkDeviceSize size;
+	//host visible buffers stay mapped for as long as they live
 	void * mappedData;
 };
 
@@ -51,6 +73,8 @@ struct UniformBufferData {
 struct GPUObjectData {
 	math::Matrix4* models;
 	RGBAColorF32* rgbaColors;
+	//packed like VoxelOcclusion's. instances that aren't voxels are VOXEL_UNOCCLUDED
+	u64* occlusions;
 	u32 count;
 };
 
@@ -58,12 +82,121 @@ struct TexturePushConstants {
 	i32 imageIndex;
 };
 
+//must match the push constants of grid_shader
+struct GridPushConstants {
+	f32 color[4];
+	//in world units, on the xz plane. the grid runs along x and -z from it
+	f32 origin[2];
+	f32 cellsCount[2];
+	f32 cellSize;
+	//in pixels
+	f32 lineWidth;
+};
+
+//must match the push constants of voxel_shader.frag. the shadow volume's min corner and cell size are in world units
+struct VoxelShadowPushConstants {
+	//toward the sun
+	f32 sunDirection[3];
+	//how much darker a fragment in shadow is, 0 turns the shadows off
+	f32 strength;
+	f32 origin[3];
+	f32 cellSize;
+	i32 cellsDims[3];
+	i32 maxSteps;
+};
 
 struct Image {
 	VkImage image;
 	VkImageView imageView;
-	VkDeviceMemory memory;
+	GPUAllocation allocation;
 	VkExtent3D extent;
+	u32 mipLevelsCount;
+	u32 arrayLayersCount;
+};
+
+//the vulkan side of the gpu allocator. every buffer and image is placed in one of these blocks
+struct DeviceMemory {
+	GPUAllocator allocator;
+	VkDevice device;
+	VkPhysicalDeviceMemoryProperties properties;
+	VkDeviceMemory blocks[GPU_ALLOCATOR_MAX_MEMORY_TYPES][GPU_ALLOCATOR_MAX_BLOCKS];
+	//host visible blocks are mapped once, when they are allocated
+	u8* mappedBlocks[GPU_ALLOCATOR_MAX_MEMORY_TYPES][GPU_ALLOCATOR_MAX_BLOCKS];
+};
+
+//host visible staging memory for per frame uploads. space used by a frame is reclaimed once that frame's in flight fence is signaled
+struct UploadRing {
+	Buffer buffer;
+	//total bytes ever allocated and total bytes the gpu is done with. the offset into the buffer is the value modulo the buffer size
+	u64 head;
+	u64 tail;
+	u64 frameEnds[MAX_FRAMES_IN_FLIGHT];
+	u64 bytesUploadedThisFrame;
+};
+
+//matches the std430 layout of CullingBatch in cull_instances.comp
+struct GPUCullingBatch {
+	f32 boundsMin[3];
+	u32 firstInstance;
+	f32 boundsMax[3];
+	u32 instancesCount;
+};
+
+struct GPUCullingCounters {
+	u32 drawCount;
+	u32 visibleInstancesCount;
+};
+
+struct CullingPushConstants {
+	math::Vector4 frustumPlanes[6];
+	u32 batchesCount;
+};
+
+struct GPUCulling {
+	bool32 isSupported;
+	bool32 isEnabled;
+	bool32 isDrawIndirectCountSupported;
+
+	VkDescriptorSetLayout descriptorSetLayout;
+	VkDescriptorSet descriptorSet;
+	VkPipelineLayout pipelineLayout;
+	VkPipeline pipeline;
+
+	//device local. the batches are updated through the upload ring, the rest is written by the compute pass every frame
+	Buffer batchBuffer;
+	Buffer instanceIndexBuffer;
+	Buffer drawCommandBuffer;
+	Buffer countersBuffer;
+	//host visible copies of the counters, read back once the frame's in flight fence is signaled
+	Buffer readbackBuffers[MAX_FRAMES_IN_FLIGHT];
+
+	//cpu copy of the batches, used to recompute a batch's bounds and to check the gpu's results
+	GPUCullingBatch* batches;
+	u32 batchesCount;
+
+	GPUCullingCounters expectedCounters[MAX_FRAMES_IN_FLIGHT];
+	bool32 hasPendingReadback[MAX_FRAMES_IN_FLIGHT];
+	GPUCullingCounters lastCounters;
+	GPUCullingCounters lastExpectedCounters;
+	u32 mismatchedFramesCount;
+};
+
+struct GPUProfilerFrame {
+	//two timestamps per zone. zone i begins at query 2*i and ends at query 2*i + 1
+	VkQueryPool queryPool;
+	u64 frameNumber;
+	u32 zonesCount;
+	bool32 hasPendingResults;
+	const char* zoneNames[PROFILER_MAX_GPU_ZONES];
+	u32 zoneDepths[PROFILER_MAX_GPU_ZONES];
+};
+
+struct GPUProfiler {
+	bool32 isSupported;
+	f64 nanosecondsPerTick;
+	u64 timestampMask;
+	u32 depth;
+	GPUProfilerFrame frames[MAX_FRAMES_IN_FLIGHT];
 };
 
 struct Renderer {
@@ -73,7 +206,7 @@ struct Renderer {
 	VkSurfaceKHR surface;
 
 	VkPhysicalDevice physicalDevice;
-	VkPhysicalDeviceMemoryProperties physicalDeviceMemoryProperties;
+	DeviceMemory* deviceMemory;
 
 	VkDevice device;
 
@@ -84,6 +217,9 @@ struct Renderer {
 
 	VkQueue graphicsQueue;
 	VkQueue presentQueue;
+	//a dedicated transfer queue if the device has one, otherwise the graphics queue
+	VkQueue transferQueue;
+	u32 transferQueueFamilyIndex;
 
 	Swapchain* swapchain;
 	VkRenderPass renderPass;
@@ -98,13 +234,28 @@ struct Renderer {
 
 	VkPipeline voxelPipeline;
 	VkPipelineLayout voxelPipelineLayout;
+	//the voxel pipeline without depth writes, for instances that are sorted back to front
+	VkPipeline translucentVoxelPipeline;
+
+	VkPipeline gridPipeline;
+	VkPipelineLayout gridPipelineLayout;
+
+	VkPipelineCache pipelineCache;
+	//time spent creating every pipeline during initRenderer, imgui's included, and whether a valid cache was loaded from disk for it
+	f64 pipelineCreationMilliseconds;
+	bool32 isPipelineCacheWarm;
+
+	bool32 isTextureCompressionBCSupported;
 
 	VkCommandPool commandPool;
+	VkCommandPool transferCommandPool;
 
 	Buffer stagingBuffer;
 	Buffer texturedCubeVertexBuffer;
 	Buffer cubeVertexBuffer;
 
+	Image blockTextureArray;
+
 	VkCommandBuffer commandBuffers[MAX_FRAMES_IN_FLIGHT];
 
 	VkSemaphore imageAvailableSemaphores[MAX_FRAMES_IN_FLIGHT];
@@ -112,12 +263,19 @@ struct Renderer {
 	VkFence inFlightFences[MAX_FRAMES_IN_FLIGHT];
 
 	Buffer uniformBuffers[MAX_FRAMES_IN_FLIGHT];
-	Buffer objectTransformBuffers[MAX_FRAMES_IN_FLIGHT];
-	Buffer objectColorBuffers[MAX_FRAMES_IN_FLIGHT];
+	//device local and shared by all frames in flight. only changed ranges are copied in through the upload ring
+	Buffer objectTransformBuffer;
+	Buffer objectColorBuffer;
+	Buffer objectOcclusionBuffer;
+	Buffer voxelShadowBuffer;
+	UploadRing uploadRing;
 
 	VkDescriptorSet uniformBufferDescriptorSets[MAX_FRAMES_IN_FLIGHT];
 	VkDescriptorSet objectDataDescriptorSets[MAX_FRAMES_IN_FLIGHT];
 	VkDescriptorSet textureDescriptorSets[MAX_FRAMES_IN_FLIGHT];
+
+	GPUProfiler gpuProfiler;
+	GPUCulling gpuCulling;
 };
 
 
@@ -131,12 +289,53 @@ VkResult createSwapchainAndRenderPass(
 	bool32 isUsingSameQueueForGraphicsAndPresent,
 	VkRenderPass* renderPass,
 	Swapchain* swapchain,
-	Image* depthImage
+	Image* depthImage,
+	DeviceMemory* deviceMemory
 );
 
 
 VkResult handleRenderResizing(Renderer* renderer);
 void loadTextureImage(const char* filepath, Renderer* renderer, Image* textureImage);
-int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memoryAllocator);
+//decodes the textures and generates their mip chains on the job queue's threads, or on the calling thread if it is nil, then uploads them through the staging buffer in as few submissions as fit
+void loadTextureImages(const char** filepaths, u32 texturesCount, Renderer* renderer, Image* textureImages, JobQueue* jobQueue);
+//same as loadTextureImages, but every texture becomes a layer of one 2d array image. the textures must all be the same size
+void loadTextureArray(const char** filepaths, u32 texturesCount, Renderer* renderer, Image* textureArray, JobQueue* jobQueue);
+//uploads the named textures of a mapped asset pack as the layers of one 2d array image, copying their baked mip chains straight into the staging buffer.
+//returns 0 if a texture is missing or doesn't match the others, in which case nothing is created
+bool32 loadTextureArrayFromPack(AssetPack* pack, const char** names, u32 texturesCount, Renderer* renderer, Image* textureArray);
+int initRenderer(Renderer* renderer, GLFWwindow* window, MemoryAllocator* memoryAllocator, JobQueue* jobQueue);
+//writes the pipeline cache to disk so the next launch can skip compiling the pipelines. returns 0 on failure
+bool32 savePipelineCache(Renderer* renderer);
+
+//must be called after the frame's in flight fence was waited on, and before the render pass begins
+void beginFrameUploads(Renderer* renderer, u32 frameIndex);
+//stages the data in the upload ring and records a copy into the destination. returns 0 if the ring is full, in which case nothing is recorded
+bool32 uploadToBuffer(Renderer* renderer, u32 frameIndex, VkBuffer destination, VkDeviceSize destinationOffset, void* data, VkDeviceSize size);
+//uploads the transforms and colors of the instances [begin, end). returns 0 if the ring is full
+bool32 uploadGPUObjectData(Renderer* renderer, u32 frameIndex, GPUObjectData* objectData, u32 begin, u32 end);
+//uploads all of the overlay instances to their region of the object buffers. returns 0 if the ring is full
+bool32 uploadGPUOverlayObjectData(Renderer* renderer, u32 frameIndex, GPUObjectData* overlayData);
+//uploads the words [begin, end) of the shadow occupancy. returns 0 if the ring is full
+bool32 uploadVoxelShadowOccupancy(Renderer* renderer, u32 frameIndex, u32* occupancy, u32 begin, u32 end);
+//makes the copies visible to the vertex, fragment and compute shaders. must be called before the render pass and the culling pass begin
+void endFrameUploads(Renderer* renderer, u32 frameIndex);
+
+//recomputes the bounds of the batches overlapping the instances [begin, end) and uploads them. only instances below culledInstancesCount are culled. returns 0 if the ring is full
+bool32 updateCullingBatches(Renderer* renderer, u32 frameIndex, GPUObjectData* objectData, u32 begin, u32 end, u32 culledInstancesCount);
+//records the compute pass that culls the batches against the view frustum and writes the indirect draws. must be called after endFrameUploads and before the render pass begins
+void recordInstanceCulling(Renderer* renderer, u32 frameIndex, math::Matrix4 viewProjection, u32 culledInstancesCount);
+//draws the visible batches of the instances [0, culledInstancesCount), then the instances [culledInstancesCount, instancesCount) without culling. the voxel pipeline and its descriptor sets must be bound
+void drawCulledInstances(Renderer* renderer, u32 frameIndex, u32 culledInstancesCount, u32 instancesCount);
+//draws the overlay instances [begin, end) in order, without culling. the voxel pipeline or the translucent one, and their descriptor sets must be bound
+void drawOverlayInstances(Renderer* renderer, u32 frameIndex, u32 begin, u32 end);
+//draws the grid as one quad whose lines are worked out per pixel, so it costs the same for any amount of cells. binds its own pipeline,
+//so it goes after the opaque draws it's blended over
+void drawGrid(Renderer* renderer, u32 frameIndex, GridPushConstants* grid);
+
+//must be called after the frame's in flight fence was waited on, and before the render pass begins
+void beginGPUProfilerFrame(Renderer* renderer, u32 frameIndex, u64 frameNumber);
+//returns the zone index to pass to endGPUZone
+u32 beginGPUZone(Renderer* renderer, u32 frameIndex, const char* name);
+void endGPUZone(Renderer* renderer, u32 frameIndex, u32 zoneIndex);
 
 #endif
@@ -0,0 +1,34 @@
+#version 460
+
+//must match GridPushConstants in renderer.h
+layout (push_constant) uniform GridPushConstants {
+	vec4 color;
+	vec2 origin;
+	vec2 cellsCount;
+	float cellSize;
+	float lineWidth;
+} pc;
+
+layout(location = 0) in vec2 gridCoordinates;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+	//cells per pixel along each axis, so lines keep the same width in pixels at any distance
+	vec2 derivative = max(fwidth(gridCoordinates), vec2(1e-6));
+	//the margin past the last lines only holds their outer halves
+	vec2 outside = max(-gridCoordinates, gridCoordinates - pc.cellsCount) / derivative;
+	if (max(outside.x, outside.y) > 0.5 * pc.lineWidth + 1.0) {
+		discard;
+	}
+	//distance in pixels to the nearest line along each axis, covered with a one pixel falloff
+	vec2 distance = abs(fract(gridCoordinates + 0.5) - 0.5) / derivative;
+	vec2 coverage = clamp(0.5 * pc.lineWidth + 0.5 - distance, 0.0, 1.0);
+	//cells narrower than a few pixels would alias into noise, so they fade out instead
+	coverage *= clamp(0.25 / derivative - 0.5, 0.0, 1.0);
+	float alpha = max(coverage.x, coverage.y);
+	if (alpha <= 0.0) {
+		discard;
+	}
+	outColor = vec4(pc.color.rgb, pc.color.a * alpha);
+}
@@ -0,0 +1,31 @@
+#version 460
+
+layout (set=0, binding = 0) uniform UniformBuffer {
+	mat4 view;
+	mat4 projection;
+} ub;
+
+//must match GridPushConstants in renderer.h
+layout (push_constant) uniform GridPushConstants {
+	vec4 color;
+	vec2 origin;
+	vec2 cellsCount;
+	float cellSize;
+	float lineWidth;
+} pc;
+
+//in cells from the grid's origin, along x and -z
+layout(location = 0) out vec2 gridCoordinates;
+
+//two triangles covering the grid's plane, with half a cell of margin so the border lines aren't cut in half
+const vec2 corners[6] = vec2[](
+	vec2(0.0, 0.0), vec2(1.0, 0.0), vec2(1.0, 1.0),
+	vec2(0.0, 0.0), vec2(1.0, 1.0), vec2(0.0, 1.0)
+);
+
+void main() {
+	vec2 corner = corners[gl_VertexIndex];
+	gridCoordinates = mix(vec2(-0.5), pc.cellsCount + vec2(0.5), corner);
+	vec2 position = pc.origin + gridCoordinates * pc.cellSize;
+	gl_Position = ub.projection * ub.view * vec4(position.x, 0.0, -position.y, 1.0);
+}
@@ -2,7 +2,8 @@
 
 
 layout(set = 2, binding = 0) uniform sampler samp;
-layout(set = 2, binding = 1) uniform texture2D textures[4096];
+//the block textures, one per layer, each with its full mip chain
+layout(set = 2, binding = 1) uniform texture2DArray blockTextures;
 
 layout(location = 0) in vec4 fragColor;
 layout(location = 1) in vec2 fragTexCoord;
@@ -14,5 +15,5 @@ layout(push_constant) uniform object {
 } pc;
 
 void main() {
-	outColor = fragColor * texture(sampler2D(textures[pc.imageIndex], samp), fragTexCoord);
+	outColor = fragColor * texture(sampler2DArray(blockTextures, samp), vec3(fragTexCoord, pc.imageIndex));
 }
\ No newline at end of file
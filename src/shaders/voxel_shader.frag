@@ -1,11 +1,118 @@
-
 #version 460
 
 
 layout(location = 0) in vec4 fragColor;
+layout(location = 1) in vec3 fragPosition;
+layout(location = 2) flat in vec3 fragNormal;
+
+//a bit per cell of the light volume, set when the cell is blocked. laid out like the cells, see voxel_shadow.h
+layout (std430,set = 1, binding = 4) readonly buffer ShadowBuffer{
+	uint occupancy[];
+} shadowBuffer;
+
+//must match VoxelShadowPushConstants in renderer.h
+layout(push_constant) uniform ShadowPushConstants {
+	vec3 sunDirection;
+	float strength;
+	vec3 origin;
+	float cellSize;
+	ivec3 cellsDims;
+	int maxSteps;
+} shadow;
 
 layout(location = 0) out vec4 outColor;
 
+const int CHUNK_SIZE = 16;
+const float SURFACE_OFFSET = 0.05;
+//past any distance a ray goes through the volume. dividing by zero isn't defined in glsl
+const float INFINITY = 1e30;
+
+bool isCellBlocked(ivec3 cell) {
+	if (any(lessThan(cell, ivec3(0))) || any(greaterThanEqual(cell, shadow.cellsDims))) {
+		return false;
+	}
+	ivec3 chunksDims = shadow.cellsDims / CHUNK_SIZE;
+	ivec3 chunk = cell / CHUNK_SIZE;
+	ivec3 local = cell % CHUNK_SIZE;
+	uint index = uint((chunk.z * chunksDims.y + chunk.y) * chunksDims.x + chunk.x) * uint(CHUNK_SIZE * CHUNK_SIZE * CHUNK_SIZE) +
+		uint((local.z * CHUNK_SIZE + local.y) * CHUNK_SIZE + local.x);
+	return ((shadowBuffer.occupancy[index >> 5] >> (index & 31u)) & 1u) != 0u;
+}
+
+//the same march as traceVoxelShadowRay in voxel_shadow.cpp, so the cpu's result can be compared against it
+bool traceShadowRay(vec3 start, vec3 direction, vec3 normal) {
+	vec3 dims = vec3(shadow.cellsDims);
+	float tEnter = 0.0;
+	float tExit = INFINITY;
+	for (int k = 0; k < 3; k++) {
+		if (direction[k] == 0.0) {
+			if (start[k] < 0.0 || start[k] >= dims[k]) {
+				return false;
+			}
+			continue;
+		}
+		float t0 = -start[k] / direction[k];
+		float t1 = (dims[k] - start[k]) / direction[k];
+		tEnter = max(tEnter, min(t0, t1));
+		tExit = min(tExit, max(t0, t1));
+	}
+	if (tEnter >= tExit) {
+		return false;
+	}
+	vec3 axisNormal = abs(normal);
+	int layerAxis = axisNormal.x >= axisNormal.y ? (axisNormal.x >= axisNormal.z ? 0 : 2) : (axisNormal.y >= axisNormal.z ? 1 : 2);
+
+	ivec3 cell;
+	ivec3 stepDirection;
+	vec3 tMax;
+	vec3 tDelta;
+	for (int k = 0; k < 3; k++) {
+		float p = start[k] + direction[k] * tEnter;
+		cell[k] = clamp(int(floor(p)), 0, shadow.cellsDims[k] - 1);
+		if (direction[k] > 0.0) {
+			stepDirection[k] = 1;
+			tMax[k] = tEnter + (float(cell[k] + 1) - p) / direction[k];
+			tDelta[k] = 1.0 / direction[k];
+		} else if (direction[k] < 0.0) {
+			stepDirection[k] = -1;
+			tMax[k] = tEnter + (float(cell[k]) - p) / direction[k];
+			tDelta[k] = -1.0 / direction[k];
+		} else {
+			stepDirection[k] = 0;
+			tMax[k] = INFINITY;
+			tDelta[k] = INFINITY;
+		}
+	}
+	//the fragment's cell and the ones next to it in its layer are blocked by its voxel and its neighbours, even when they're smaller
+	//than a cell. the rest of the layer is tested, so short walls along it still cast shadows
+	bool isStartSkipped = tEnter <= 0.0;
+	ivec3 startCell = cell;
+	for (int i = 0; i < shadow.maxSteps; i++) {
+		bool isSkipped = isStartSkipped && cell[layerAxis] == startCell[layerAxis] && all(lessThanEqual(abs(cell - startCell), ivec3(1)));
+		if (!isSkipped && isCellBlocked(cell)) {
+			return true;
+		}
+		int k = tMax.x < tMax.y ? (tMax.x < tMax.z ? 0 : 2) : (tMax.y < tMax.z ? 1 : 2);
+		cell[k] += stepDirection[k];
+		tMax[k] += tDelta[k];
+		if (cell[k] < 0 || cell[k] >= shadow.cellsDims[k]) {
+			return false;
+		}
+	}
+	return false;
+}
+
 void main() {
 	outColor = fragColor;
-}
\ No newline at end of file
+	if (shadow.strength <= 0.0) {
+		return;
+	}
+	bool isShadowed = dot(fragNormal, shadow.sunDirection) <= 0.0;
+	if (!isShadowed) {
+		vec3 start = (fragPosition - shadow.origin) / shadow.cellSize - fragNormal * SURFACE_OFFSET;
+		isShadowed = traceShadowRay(start, shadow.sunDirection, fragNormal);
+	}
+	if (isShadowed) {
+		outColor.rgb *= 1.0 - shadow.strength;
+	}
+}
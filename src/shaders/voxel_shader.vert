@@ -22,9 +22,67 @@ layout (std140,set = 1, binding = 1) readonly buffer ColorBuffer{
 	RGBAColor colors[];
 } colorBuffer;
 
+//written by cull_instances.comp. the visible instances of the culled draws, packed together
+layout (std430,set = 1, binding = 2) readonly buffer InstanceIndexBuffer{
+	uint indices[];
+} instanceIndexBuffer;
+
+//2 bits for each corner of each face, then a bit per face that flips its quad. see voxel_occlusion.h.
+//the top byte is the voxel's block light, with its sky light above it. see voxel_light.h
+layout (std430,set = 1, binding = 3) readonly buffer OcclusionBuffer{
+	uvec2 occlusions[];
+} occlusionBuffer;
+
+//instances drawn from here on aren't culled and index the object buffer directly. must match UNCULLED_INSTANCES_BASE in renderer.h
+const uint UNCULLED_INSTANCES_BASE = 100000;
+
 layout(location = 0) out vec4 fragColor;
+//in world units, for voxel_shader.frag's shadow march
+layout(location = 1) out vec3 fragPosition;
+layout(location = 2) flat out vec3 fragNormal;
+
+//the corners of each face, in the order positionCubeVertices goes around them. a face's two triangles are corners 0 1 2 and 2 3 0
+const vec3 FACE_CORNERS[24] = vec3[](
+	vec3(-0.5, -0.5,  0.5), vec3( 0.5, -0.5,  0.5), vec3( 0.5,  0.5,  0.5), vec3(-0.5,  0.5,  0.5),
+	vec3(-0.5, -0.5, -0.5), vec3(-0.5,  0.5, -0.5), vec3( 0.5,  0.5, -0.5), vec3( 0.5, -0.5, -0.5),
+	vec3(-0.5,  0.5,  0.5), vec3(-0.5,  0.5, -0.5), vec3(-0.5, -0.5, -0.5), vec3(-0.5, -0.5,  0.5),
+	vec3( 0.5,  0.5,  0.5), vec3( 0.5, -0.5,  0.5), vec3( 0.5, -0.5, -0.5), vec3( 0.5,  0.5, -0.5),
+	vec3(-0.5, -0.5, -0.5), vec3( 0.5, -0.5, -0.5), vec3( 0.5, -0.5,  0.5), vec3(-0.5, -0.5,  0.5),
+	vec3(-0.5,  0.5, -0.5), vec3(-0.5,  0.5,  0.5), vec3( 0.5,  0.5,  0.5), vec3( 0.5,  0.5, -0.5)
+);
+const uint QUAD_CORNERS[6] = uint[](0, 1, 2, 2, 3, 0);
+const vec3 FACE_NORMALS[6] = vec3[](
+	vec3(0.0, 0.0, 1.0), vec3(0.0, 0.0, -1.0), vec3(-1.0, 0.0, 0.0), vec3(1.0, 0.0, 0.0), vec3(0.0, -1.0, 0.0), vec3(0.0, 1.0, 0.0)
+);
+//how bright a corner is for each of its 4 occlusion values, from fully occluded to open
+const float OCCLUSION_BRIGHTNESS[4] = float[](0.45, 0.65, 0.82, 1.0);
+//unlit voxels are still this bright, so they don't turn black
+const float AMBIENT_LIGHT = 0.15;
 
 void main() {
-	gl_Position = ub.projection * ub.view * objectBuffer.objects[gl_InstanceIndex].model * vec4(inPosition, 1.0);
-	fragColor = colorBuffer.colors[gl_InstanceIndex].color;
+	uint instanceIndex = gl_InstanceIndex;
+	uint objectIndex = instanceIndex >= UNCULLED_INSTANCES_BASE ? instanceIndex - UNCULLED_INSTANCES_BASE : instanceIndexBuffer.indices[instanceIndex];
+	uvec2 occlusion = occlusionBuffer.occlusions[objectIndex];
+	uint face = gl_VertexIndex / 6;
+	uint corner = QUAD_CORNERS[gl_VertexIndex % 6];
+	//turning every corner one step around the face splits the quad along its other diagonal, and keeps the triangles' winding
+	bool isFlipped = (occlusion.y & (1u << (16 + face))) != 0;
+	if (isFlipped) {
+		corner = (corner + 1) & 3;
+	}
+	uint bit = 2 * (4 * face + corner);
+	uint cornerOcclusion = ((bit < 32 ? occlusion.x : occlusion.y) >> (bit & 31)) & 3;
+
+	//the vertex buffer only has the unflipped corners
+	vec3 position = isFlipped ? FACE_CORNERS[4 * face + corner] : inPosition;
+	mat4 model = objectBuffer.objects[objectIndex].model;
+	vec4 worldPosition = model * vec4(position, 1.0);
+	gl_Position = ub.projection * ub.view * worldPosition;
+	fragPosition = worldPosition.xyz;
+	//the model only rotates and scales along the cube's axes, so the face's normal stays perpendicular to it
+	fragNormal = normalize(mat3(model) * FACE_NORMALS[face]);
+	fragColor = colorBuffer.colors[objectIndex].color;
+	uint light = occlusion.y >> 24;
+	float lightLevel = float(max(light & 15u, light >> 4)) / 15.0;
+	fragColor.rgb *= OCCLUSION_BRIGHTNESS[cornerOcclusion] * mix(AMBIENT_LIGHT, 1.0, lightLevel);
 }
\ No newline at end of file
@@ -0,0 +1,358 @@
+#include "texture.h"
+
+#include <math.h>
+
+u32 calculateMipLevelsCount(u32 width, u32 height) {
+	u32 largest = MAX(width, height);
+	u32 levelsCount = 1;
+	while (largest > 1) {
+		largest >>= 1;
+		levelsCount += 1;
+	}
+	return levelsCount;
+}
+
+u32 calculateMipLevelDimension(u32 baseDimension, u32 mipLevel) {
+	return MAX(1u, baseDimension >> mipLevel);
+}
+
+u64 calculateMipChainSize(u32 width, u32 height, u32 mipLevelsCount) {
+	u64 size = 0;
+	for (u32 level = 0; level < mipLevelsCount; level++) {
+		size += 4ull * calculateMipLevelDimension(width, level) * calculateMipLevelDimension(height, level);
+	}
+	return size;
+}
+
+//srgb to linear for each 8 bit value. precomputed so the decode jobs that build mip chains only ever read it
+static const f32 srgbToLinearTable[256] = {
+	0.0f, 0.000303526991f, 0.000607053982f, 0.000910580973f, 0.00121410796f, 0.00151763496f, 0.00182116195f, 0.00212468882f,
+	0.00242821593f, 0.0027317428f, 0.00303526991f, 0.00334653584f, 0.00367650739f, 0.00402471703f, 0.00439144205f, 0.00477695325f,
+	0.00518151652f, 0.00560539169f, 0.00604883302f, 0.00651209056f, 0.00699541019f, 0.00749903219f, 0.00802319311f, 0.00856812578f,
+	0.00913405884f, 0.00972121768f, 0.010329823f, 0.0109600937f, 0.0116122449f, 0.012286488f, 0.0129830325f, 0.0137020834f,
+	0.0144438436f, 0.0152085144f, 0.0159962941f, 0.0168073755f, 0.0176419541f, 0.01850022f, 0.0193823613f, 0.0202885624f,
+	0.0212190095f, 0.0221738853f, 0.0231533665f, 0.0241576321f, 0.0251868591f, 0.0262412224f, 0.0273208916f, 0.02842604f,
+	0.0295568351f, 0.0307134446f, 0.0318960324f, 0.0331047662f, 0.0343398079f, 0.0356013142f, 0.0368894488f, 0.0382043719f,
+	0.0395462364f, 0.0409151986f, 0.0423114114f, 0.043735031f, 0.045186203f, 0.0466650873f, 0.0481718257f, 0.0497065671f,
+	0.0512694567f, 0.0528606474f, 0.054480277f, 0.0561284907f, 0.0578054301f, 0.0595112368f, 0.0612460524f, 0.0630100146f,
+	0.064803265f, 0.0666259378f, 0.0684781671f, 0.0703600943f, 0.0722718537f, 0.0742135718f, 0.0761853829f, 0.078187421f,
+	0.0802198201f, 0.0822827071f, 0.0843762085f, 0.0865004584f, 0.0886555836f, 0.0908417106f, 0.0930589661f, 0.0953074694f,
+	0.097587347f, 0.0998987257f, 0.102241732f, 0.104616486f, 0.107023105f, 0.10946171f, 0.111932427f, 0.114435375f,
+	0.116970666f, 0.119538426f, 0.122138776f, 0.124771819f, 0.127437681f, 0.130136475f, 0.13286832f, 0.135633335f,
+	0.138431609f, 0.141263291f, 0.144128472f, 0.147027269f, 0.149959788f, 0.152926147f, 0.155926466f, 0.158960834f,
+	0.162029371f, 0.165132195f, 0.168269396f, 0.171441108f, 0.174647406f, 0.177888423f, 0.18116425f, 0.18447499f,
+	0.187820777f, 0.191201687f, 0.194617838f, 0.198069319f, 0.20155625f, 0.205078736f, 0.208636865f, 0.212230757f,
+	0.215860501f, 0.219526201f, 0.223227963f, 0.226965874f, 0.230740055f, 0.23455058f, 0.238397568f, 0.242281124f,
+	0.246201321f, 0.25015828f, 0.254152089f, 0.258182853f, 0.262250662f, 0.266355604f, 0.270497799f, 0.274677306f,
+	0.278894275f, 0.283148736f, 0.287440836f, 0.291770637f, 0.296138257f, 0.300543785f, 0.304987311f, 0.309468925f,
+	0.313988715f, 0.318546772f, 0.323143214f, 0.327778101f, 0.332451522f, 0.337163627f, 0.341914415f, 0.346704066f,
+	0.351532608f, 0.356400132f, 0.361306787f, 0.366252601f, 0.371237695f, 0.376262128f, 0.38132602f, 0.386429429f,
+	0.391572475f, 0.396755219f, 0.401977777f, 0.407240212f, 0.412542611f, 0.417885065f, 0.423267663f, 0.428690493f,
+	0.434153646f, 0.439657182f, 0.445201188f, 0.450785786f, 0.456411034f, 0.462076992f, 0.467783809f, 0.473531485f,
+	0.479320168f, 0.48514995f, 0.491020858f, 0.496932983f, 0.502886474f, 0.50888133f, 0.514917672f, 0.520995557f,
+	0.527115107f, 0.533276379f, 0.539479494f, 0.545724452f, 0.55201143f, 0.558340371f, 0.564711511f, 0.571124852f,
+	0.577580452f, 0.584078431f, 0.590618849f, 0.597201765f, 0.603827357f, 0.610495567f, 0.617206573f, 0.623960376f,
+	0.630757153f, 0.637596846f, 0.644479692f, 0.651405632f, 0.658374846f, 0.665387273f, 0.672443151f, 0.679542482f,
+	0.686685324f, 0.693871737f, 0.701101899f, 0.708375752f, 0.715693474f, 0.723055124f, 0.730460763f, 0.73791039f,
+	0.745404184f, 0.752942204f, 0.760524511f, 0.768151164f, 0.775822222f, 0.783537805f, 0.791297913f, 0.799102724f,
+	0.806952238f, 0.814846575f, 0.822785735f, 0.830769897f, 0.838799f, 0.846873224f, 0.854992628f, 0.863157213f,
+	0.871367097f, 0.8796224f, 0.887923121f, 0.896269381f, 0.904661179f, 0.913098633f, 0.921581864f, 0.930110872f,
+	0.938685715f, 0.947306514f, 0.955973327f, 0.964686275f, 0.973445296f, 0.982250571f, 0.991102099f, 1.0f,
+};
+
+static u8 linearToSRGB(f32 c) {
+	c = c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+	i32 value = (i32)(c * 255.0f + 0.5f);
+	if (value < 0) {
+		return 0;
+	}
+	return value > 255 ? 255 : (u8)value;
+}
+
+void generateMipChain(u8* pixels, u32 width, u32 height, u32 mipLevelsCount) {
+	u8* source = pixels;
+	u32 sourceWidth = width;
+	u32 sourceHeight = height;
+	for (u32 level = 1; level < mipLevelsCount; level++) {
+		u8* destination = source + 4ull * sourceWidth * sourceHeight;
+		u32 destinationWidth = calculateMipLevelDimension(width, level);
+		u32 destinationHeight = calculateMipLevelDimension(height, level);
+		for (u32 y = 0; y < destinationHeight; y++) {
+			//odd dimensions clamp the last row and column instead of reading past the edge
+			u32 y0 = MIN(2 * y, sourceHeight - 1);
+			u32 y1 = MIN(2 * y + 1, sourceHeight - 1);
+			for (u32 x = 0; x < destinationWidth; x++) {
+				u32 x0 = MIN(2 * x, sourceWidth - 1);
+				u32 x1 = MIN(2 * x + 1, sourceWidth - 1);
+				u8* samples[4] = {
+					&source[4 * (y0 * sourceWidth + x0)],
+					&source[4 * (y0 * sourceWidth + x1)],
+					&source[4 * (y1 * sourceWidth + x0)],
+					&source[4 * (y1 * sourceWidth + x1)],
+				};
+				u8* out = &destination[4 * (y * destinationWidth + x)];
+				for (u32 c = 0; c < 3; c++) {
+					f32 sum = 0.0f;
+					for (u32 s = 0; s < 4; s++) {
+						sum += srgbToLinearTable[samples[s][c]];
+					}
+					out[c] = linearToSRGB(0.25f * sum);
+				}
+				u32 alphaSum = samples[0][3] + samples[1][3] + samples[2][3] + samples[3][3];
+				out[3] = (u8)((alphaSum + 2) / 4);
+			}
+		}
+		source = destination;
+		sourceWidth = destinationWidth;
+		sourceHeight = destinationHeight;
+	}
+}
+
+u64 calculateTextureLevelSize(TextureFormat format, u32 width, u32 height) {
+	if (format == TEXTURE_FORMAT_BC1_SRGB) {
+		return 8ull * ((width + 3) / 4) * ((height + 3) / 4);
+	}
+	return 4ull * width * height;
+}
+
+u64 calculateTextureChainSize(TextureFormat format, u32 width, u32 height, u32 mipLevelsCount) {
+	u64 size = 0;
+	for (u32 level = 0; level < mipLevelsCount; level++) {
+		size += calculateTextureLevelSize(format, calculateMipLevelDimension(width, level), calculateMipLevelDimension(height, level));
+	}
+	return size;
+}
+
+static u16 packRGB565(f32 r, f32 g, f32 b) {
+	u32 r5 = (u32)(r * 31.0f / 255.0f + 0.5f);
+	u32 g6 = (u32)(g * 63.0f / 255.0f + 0.5f);
+	u32 b5 = (u32)(b * 31.0f / 255.0f + 0.5f);
+	return (u16)((r5 << 11) | (g6 << 5) | b5);
+}
+
+static void unpackRGB565(u16 color, i32* rgb) {
+	i32 r = (color >> 11) & 31;
+	i32 g = (color >> 5) & 63;
+	i32 b = color & 31;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+//the four colors of a block with color0 > color1. the other ordering means three colors and transparent black, which opaque blocks never use
+static void calculateBC1Palette(u16 color0, u16 color1, i32 palette[4][3]) {
+	unpackRGB565(color0, palette[0]);
+	unpackRGB565(color1, palette[1]);
+	for (u32 c = 0; c < 3; c++) {
+		if (color0 > color1) {
+			palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+			palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+		} else {
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+}
+
+//picks the closest palette color for every texel. returns the summed squared error
+static i32 chooseBC1Indices(u8 texels[16][4], u16 color0, u16 color1, u32* indices) {
+	*indices = 0;
+	i32 palette[4][3];
+	calculateBC1Palette(color0, color1, palette);
+	//equal endpoints mean the three color mode, where index 3 is transparent black
+	u32 paletteCount = color0 > color1 ? 4 : 3;
+	i32 error = 0;
+	for (u32 i = 0; i < 16; i++) {
+		u32 bestIndex = 0;
+		i32 bestDistance = INT32_MAX;
+		for (u32 p = 0; p < paletteCount; p++) {
+			i32 r = texels[i][0] - palette[p][0];
+			i32 g = texels[i][1] - palette[p][1];
+			i32 b = texels[i][2] - palette[p][2];
+			i32 distance = r * r + g * g + b * b;
+			if (distance < bestDistance) {
+				bestDistance = distance;
+				bestIndex = p;
+			}
+		}
+		*indices |= bestIndex << (2 * i);
+		error += bestDistance;
+	}
+	return error;
+}
+
+static u16 packClampedRGB565(f32* color) {
+	f32 clamped[3];
+	for (u32 c = 0; c < 3; c++) {
+		clamped[c] = color[c] < 0.0f ? 0.0f : (color[c] > 255.0f ? 255.0f : color[c]);
+	}
+	return packRGB565(clamped[0], clamped[1], clamped[2]);
+}
+
+static void compressBC1Block(u8 texels[16][4], u8* block) {
+	f32 mean[3] = {};
+	for (u32 i = 0; i < 16; i++) {
+		for (u32 c = 0; c < 3; c++) {
+			mean[c] += texels[i][c] / 16.0f;
+		}
+	}
+	f32 covariance[6] = {};
+	for (u32 i = 0; i < 16; i++) {
+		f32 r = texels[i][0] - mean[0];
+		f32 g = texels[i][1] - mean[1];
+		f32 b = texels[i][2] - mean[2];
+		covariance[0] += r * r;
+		covariance[1] += r * g;
+		covariance[2] += r * b;
+		covariance[3] += g * g;
+		covariance[4] += g * b;
+		covariance[5] += b * b;
+	}
+	//the endpoints start at the extremes of the block's colors along their principal axis, found with a few rounds of power iteration
+	f32 axis[3] = { 1.0f, 1.0f, 1.0f };
+	for (u32 iteration = 0; iteration < 4; iteration++) {
+		f32 r = axis[0] * covariance[0] + axis[1] * covariance[1] + axis[2] * covariance[2];
+		f32 g = axis[0] * covariance[1] + axis[1] * covariance[3] + axis[2] * covariance[4];
+		f32 b = axis[0] * covariance[2] + axis[1] * covariance[4] + axis[2] * covariance[5];
+		f32 largest = fabsf(r);
+		if (fabsf(g) > largest) {
+			largest = fabsf(g);
+		}
+		if (fabsf(b) > largest) {
+			largest = fabsf(b);
+		}
+		if (largest == 0.0f) {
+			break;
+		}
+		axis[0] = r / largest;
+		axis[1] = g / largest;
+		axis[2] = b / largest;
+	}
+	f32 minProjection = 1e30f;
+	f32 maxProjection = -1e30f;
+	for (u32 i = 0; i < 16; i++) {
+		f32 projection = (texels[i][0] - mean[0]) * axis[0] + (texels[i][1] - mean[1]) * axis[1] + (texels[i][2] - mean[2]) * axis[2];
+		if (projection < minProjection) {
+			minProjection = projection;
+		}
+		if (projection > maxProjection) {
+			maxProjection = projection;
+		}
+	}
+	f32 axisLengthSquared = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+	f32 endpoint0[3];
+	f32 endpoint1[3];
+	for (u32 c = 0; c < 3; c++) {
+		endpoint0[c] = mean[c] + axis[c] * maxProjection / axisLengthSquared;
+		endpoint1[c] = mean[c] + axis[c] * minProjection / axisLengthSquared;
+	}
+	u16 color0 = packClampedRGB565(endpoint0);
+	u16 color1 = packClampedRGB565(endpoint1);
+	if (color0 < color1) {
+		u16 swapped = color0;
+		color0 = color1;
+		color1 = swapped;
+	}
+	u32 indices;
+	i32 error = chooseBC1Indices(texels, color0, color1, &indices);
+
+	//once the indices are known, the endpoints that fit them best are a 2x2 least squares solve. kept only if it lowers the error
+	if (color0 > color1) {
+		const f32 weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+		f32 aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		f32 ax[3] = {};
+		f32 bx[3] = {};
+		for (u32 i = 0; i < 16; i++) {
+			f32 a = weights[(indices >> (2 * i)) & 3];
+			f32 b = 1.0f - a;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (u32 c = 0; c < 3; c++) {
+				ax[c] += a * texels[i][c];
+				bx[c] += b * texels[i][c];
+			}
+		}
+		f32 determinant = aa * bb - ab * ab;
+		if (fabsf(determinant) > 1e-6f) {
+			for (u32 c = 0; c < 3; c++) {
+				endpoint0[c] = (bb * ax[c] - ab * bx[c]) / determinant;
+				endpoint1[c] = (aa * bx[c] - ab * ax[c]) / determinant;
+			}
+			u16 refinedColor0 = packClampedRGB565(endpoint0);
+			u16 refinedColor1 = packClampedRGB565(endpoint1);
+			if (refinedColor0 < refinedColor1) {
+				u16 swapped = refinedColor0;
+				refinedColor0 = refinedColor1;
+				refinedColor1 = swapped;
+			}
+			u32 refinedIndices;
+			i32 refinedError = chooseBC1Indices(texels, refinedColor0, refinedColor1, &refinedIndices);
+			if (refinedError < error) {
+				color0 = refinedColor0;
+				color1 = refinedColor1;
+				indices = refinedIndices;
+			}
+		}
+	}
+
+	block[0] = (u8)(color0 & 0xff);
+	block[1] = (u8)(color0 >> 8);
+	block[2] = (u8)(color1 & 0xff);
+	block[3] = (u8)(color1 >> 8);
+	block[4] = (u8)(indices & 0xff);
+	block[5] = (u8)((indices >> 8) & 0xff);
+	block[6] = (u8)((indices >> 16) & 0xff);
+	block[7] = (u8)(indices >> 24);
+}
+
+void compressBC1(u8* pixels, u32 width, u32 height, u8* blocks) {
+	u32 blocksWide = (width + 3) / 4;
+	u32 blocksHigh = (height + 3) / 4;
+	for (u32 blockY = 0; blockY < blocksHigh; blockY++) {
+		for (u32 blockX = 0; blockX < blocksWide; blockX++) {
+			u8 texels[16][4];
+			for (u32 y = 0; y < 4; y++) {
+				u32 sourceY = MIN(4 * blockY + y, height - 1);
+				for (u32 x = 0; x < 4; x++) {
+					u32 sourceX = MIN(4 * blockX + x, width - 1);
+					u8* source = &pixels[4 * (sourceY * width + sourceX)];
+					for (u32 c = 0; c < 4; c++) {
+						texels[4 * y + x][c] = source[c];
+					}
+				}
+			}
+			compressBC1Block(texels, &blocks[8 * (blockY * blocksWide + blockX)]);
+		}
+	}
+}
+
+void decompressBC1(u8* blocks, u32 width, u32 height, u8* pixels) {
+	u32 blocksWide = (width + 3) / 4;
+	u32 blocksHigh = (height + 3) / 4;
+	for (u32 blockY = 0; blockY < blocksHigh; blockY++) {
+		for (u32 blockX = 0; blockX < blocksWide; blockX++) {
+			u8* block = &blocks[8 * (blockY * blocksWide + blockX)];
+			u16 color0 = (u16)(block[0] | (block[1] << 8));
+			u16 color1 = (u16)(block[2] | (block[3] << 8));
+			u32 indices = (u32)block[4] | ((u32)block[5] << 8) | ((u32)block[6] << 16) | ((u32)block[7] << 24);
+			i32 palette[4][3];
+			calculateBC1Palette(color0, color1, palette);
+			for (u32 y = 0; y < 4; y++) {
+				u32 destinationY = 4 * blockY + y;
+				for (u32 x = 0; x < 4; x++) {
+					u32 destinationX = 4 * blockX + x;
+					if (destinationX >= width || destinationY >= height) {
+						continue;
+					}
+					u32 index = (indices >> (2 * (4 * y + x))) & 3;
+					u8* destination = &pixels[4 * (destinationY * width + destinationX)];
+					destination[0] = (u8)palette[index][0];
+					destination[1] = (u8)palette[index][1];
+					destination[2] = (u8)palette[index][2];
+					destination[3] = (color0 <= color1 && index == 3) ? 0 : 255;
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,29 @@
+#pragma once
+#ifndef VOXELS_GAME_TEXTURE_H
+#define VOXELS_GAME_TEXTURE_H
+
+#include "common.h"
+
+//how a texture's pixels are stored, in memory and in asset packs
+typedef u32 TextureFormat;
+const TextureFormat TEXTURE_FORMAT_RGBA8_SRGB = 0;
+//4x4 blocks of 8 bytes with two 565 endpoints and 2 bit indices. opaque only
+const TextureFormat TEXTURE_FORMAT_BC1_SRGB = 1;
+
+//levels down to 1x1, including the base level
+u32 calculateMipLevelsCount(u32 width, u32 height);
+u32 calculateMipLevelDimension(u32 baseDimension, u32 mipLevel);
+//bytes taken by the first mipLevelsCount levels of an rgba8 image, stored one after the other starting with the base level
+u64 calculateMipChainSize(u32 width, u32 height, u32 mipLevelsCount);
+//pixels holds the rgba8 base level followed by room for the rest of the chain.
+//each level is a 2x2 box filter of the one above it. color is averaged in linear space since the textures are srgb, alpha as is
+void generateMipChain(u8* pixels, u32 width, u32 height, u32 mipLevelsCount);
+
+u64 calculateTextureLevelSize(TextureFormat format, u32 width, u32 height);
+//same layout as calculateMipChainSize, for any format
+u64 calculateTextureChainSize(TextureFormat format, u32 width, u32 height, u32 mipLevelsCount);
+//compresses one rgba8 level into bc1 blocks. partial blocks at the edges repeat the last row and column. alpha is ignored
+void compressBC1(u8* pixels, u32 width, u32 height, u8* blocks);
+void decompressBC1(u8* blocks, u32 width, u32 height, u8* pixels);
+
+#endif
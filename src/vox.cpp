@@ -0,0 +1,947 @@
+#include "vox.h"
+#include "platform.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+const u32 VOX_MAGIC = 'V' | ('O' << 8) | ('X' << 16) | (' ' << 24);
+const i32 VOX_FILE_VERSION = 150;
+const u32 VOX_CHUNK_MAIN = 'M' | ('A' << 8) | ('I' << 16) | ('N' << 24);
+const u32 VOX_CHUNK_SIZE = 'S' | ('I' << 8) | ('Z' << 16) | ('E' << 24);
+const u32 VOX_CHUNK_XYZI = 'X' | ('Y' << 8) | ('Z' << 16) | ('I' << 24);
+const u32 VOX_CHUNK_RGBA = 'R' | ('G' << 8) | ('B' << 16) | ('A' << 24);
+const u32 VOX_CHUNK_TRANSFORM = 'n' | ('T' << 8) | ('R' << 16) | ('N' << 24);
+const u32 VOX_CHUNK_GROUP = 'n' | ('G' << 8) | ('R' << 16) | ('P' << 24);
+const u32 VOX_CHUNK_SHAPE = 'n' | ('S' << 8) | ('H' << 16) | ('P' << 24);
+const u32 VOX_CHUNK_LAYER = 'L' | ('A' << 8) | ('Y' << 16) | ('R' << 24);
+
+//voxels are converted on the stack and handed to the voxel array this many at a time
+const i32 VOX_IMPORT_BATCH_SIZE = 1024;
+//deeper scene graphs are cut off
+const i32 VOX_MAX_SCENE_DEPTH = 64;
+//nodes shared by several parents are visited once per path to them, so a small file can describe an exponential amount of
+//instances. importing fails past either limit
+const i32 VOX_MAX_INSTANCES = 1024 * 1024;
+const i32 VOX_MAX_NODE_VISITS = 16 * 1024 * 1024;
+const u32 VOX_WRITE_BUFFER_SIZE = 64 * 1024;
+//open addressing table from colors to palette indices. twice the palette size keeps it at most half full
+const u32 VOX_PALETTE_TABLE_SIZE = 512;
+
+typedef u32 VoxNodeType;
+const VoxNodeType VOX_NODE_NONE = 0;
+const VoxNodeType VOX_NODE_TRANSFORM = 1;
+const VoxNodeType VOX_NODE_GROUP = 2;
+const VoxNodeType VOX_NODE_SHAPE = 3;
+
+//.vox rotations are always multiples of 90 degrees, so transforms are kept in integers
+struct VoxTransform {
+	i32 rotation[3][3];
+	i32 translation[3];
+};
+
+struct VoxNode {
+	VoxNodeType type;
+	bool32 isHidden;
+	//transform nodes
+	VoxTransform transform;
+	i32 childNodeId;
+	//group nodes. the child ids are read in place from the file
+	i32 childrenCount;
+	const u8* childNodeIds;
+	//shape nodes. only the first model of a shape is used, the others are animation frames
+	i32 modelId;
+	//while its children are collected. a node that is its own ancestor is a cycle
+	bool32 isOnPath;
+};
+
+struct VoxModel {
+	i32 size[3];
+	i32 voxelsCount;
+	//x, y, z and a palette index per voxel
+	const u8* voxels;
+};
+
+//a model placed in the scene by a shape node
+struct VoxInstance {
+	i32 modelId;
+	VoxTransform transform;
+};
+
+struct VoxScene {
+	i32 modelsCount;
+	VoxModel* models;
+	i32 nodesCount;
+	VoxNode* nodes;
+	i32 instancesCount;
+	i32 instancesCapacity;
+	VoxInstance* instances;
+	i32 nodeVisitsCount;
+	//abgr, like in the file. index 0 is never used by a voxel
+	u32 palette[256];
+};
+
+struct VoxReader {
+	const u8* at;
+	const u8* end;
+	bool32 isValid;
+};
+
+struct VoxString {
+	const char* data;
+	i32 length;
+};
+
+struct VoxChunk {
+	u32 id;
+	VoxReader content;
+};
+
+static i32 readVoxI32(VoxReader* reader) {
+	if (reader->end - reader->at < 4) {
+		reader->isValid = 0;
+		return 0;
+	}
+	i32 value;
+	memcpy(&value, reader->at, sizeof(value));
+	reader->at += 4;
+	return value;
+}
+
+static VoxString readVoxString(VoxReader* reader) {
+	VoxString string = {};
+	i32 length = readVoxI32(reader);
+	if (!reader->isValid || length < 0 || length > reader->end - reader->at) {
+		reader->isValid = 0;
+		return string;
+	}
+	string.data = (const char*)reader->at;
+	string.length = length;
+	reader->at += length;
+	return string;
+}
+
+static bool32 isVoxString(VoxString string, const char* text) {
+	return string.length == (i32)strlen(text) && memcmp(string.data, text, string.length) == 0;
+}
+
+//the strings in the file aren't null terminated
+static void copyVoxString(VoxString string, char* text, u32 textCapacity) {
+	u32 length = MIN((u32)string.length, textCapacity - 1);
+	memcpy(text, string.data, length);
+	text[length] = 0;
+}
+
+static bool32 readVoxChunk(VoxReader* reader, VoxChunk* chunk) {
+	chunk->id = (u32)readVoxI32(reader);
+	i32 contentSize = readVoxI32(reader);
+	i32 childrenSize = readVoxI32(reader);
+	if (!reader->isValid || contentSize < 0 || childrenSize < 0 || (i64)contentSize + childrenSize > reader->end - reader->at) {
+		reader->isValid = 0;
+		return 0;
+	}
+	chunk->content = VoxReader{ reader->at, reader->at + contentSize, 1 };
+	//the chunks this reads have no children, and the children of other chunks are skipped with them
+	reader->at += contentSize + childrenSize;
+	return 1;
+}
+
+static void setVoxTransformIdentity(VoxTransform* transform) {
+	*transform = {};
+	for (i32 i = 0; i < 3; i++) {
+		transform->rotation[i][i] = 1;
+	}
+}
+
+//bits 0-1 and 2-3 are the columns of the 1 in the first and second row, the third row takes the column left over.
+//bits 4, 5 and 6 make the 1 of each row negative
+static void decodeVoxRotation(u32 bits, i32 rotation[3][3]) {
+	i32 column0 = bits & 3;
+	i32 column1 = (bits >> 2) & 3;
+	memset(rotation, 0, 9 * sizeof(i32));
+	if (column0 == 3 || column1 == 3 || column0 == column1) {
+		for (i32 i = 0; i < 3; i++) {
+			rotation[i][i] = 1;
+		}
+		return;
+	}
+	rotation[0][column0] = (bits & 16) ? -1 : 1;
+	rotation[1][column1] = (bits & 32) ? -1 : 1;
+	rotation[2][3 - column0 - column1] = (bits & 64) ? -1 : 1;
+}
+
+static u32 encodeVoxRotation(i32 rotation[3][3]) {
+	u32 bits = 0;
+	for (i32 row = 0; row < 3; row++) {
+		for (i32 column = 0; column < 3; column++) {
+			if (rotation[row][column] == 0) {
+				continue;
+			}
+			if (row < 2) {
+				bits |= column << (row * 2);
+			}
+			if (rotation[row][column] < 0) {
+				bits |= 16 << row;
+			}
+		}
+	}
+	return bits;
+}
+
+static void rotateVoxVector(i32 rotation[3][3], const i32 v[3], i32 result[3]) {
+	for (i32 i = 0; i < 3; i++) {
+		result[i] = rotation[i][0] * v[0] + rotation[i][1] * v[1] + rotation[i][2] * v[2];
+	}
+}
+
+//parent applied after child
+static VoxTransform combineVoxTransforms(VoxTransform* parent, VoxTransform* child) {
+	VoxTransform result;
+	for (i32 row = 0; row < 3; row++) {
+		for (i32 column = 0; column < 3; column++) {
+			result.rotation[row][column] = 0;
+			for (i32 k = 0; k < 3; k++) {
+				result.rotation[row][column] += parent->rotation[row][k] * child->rotation[k][column];
+			}
+		}
+	}
+	rotateVoxVector(parent->rotation, child->translation, result.translation);
+	for (i32 i = 0; i < 3; i++) {
+		result.translation[i] += parent->translation[i];
+	}
+	return result;
+}
+
+static i32 calculateVoxDeterminant(i32 m[3][3]) {
+	return
+		m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+		m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+		m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+}
+
+//.vox is z up. the game is y up
+static void convertVoxToGame(const i32 v[3], i32 result[3]) {
+	result[0] = v[0];
+	result[1] = v[2];
+	result[2] = -v[1];
+}
+
+static void convertGameToVox(const i32 v[3], i32 result[3]) {
+	result[0] = v[0];
+	result[1] = -v[2];
+	result[2] = v[1];
+}
+
+//only the node attributes and the first frame of a transform are used
+static void readVoxDictionary(VoxReader* reader, VoxNode* node) {
+	i32 count = readVoxI32(reader);
+	if (count < 0) {
+		reader->isValid = 0;
+	}
+	for (i32 i = 0; i < count && reader->isValid; i++) {
+		VoxString key = readVoxString(reader);
+		VoxString value = readVoxString(reader);
+		if (node == nil || !reader->isValid) {
+			continue;
+		}
+		char text[64];
+		copyVoxString(value, text, sizeof(text));
+		if (isVoxString(key, "_hidden")) {
+			node->isHidden = text[0] == '1';
+		} else if (isVoxString(key, "_t")) {
+			i32* t = node->transform.translation;
+			if (sscanf(text, "%d %d %d", &t[0], &t[1], &t[2]) != 3) {
+				t[0] = t[1] = t[2] = 0;
+			}
+		} else if (isVoxString(key, "_r")) {
+			decodeVoxRotation((u32)atoi(text), node->transform.rotation);
+		}
+	}
+}
+
+static void readVoxNode(VoxChunk* chunk, VoxScene* scene) {
+	VoxReader* reader = &chunk->content;
+	i32 nodeId = readVoxI32(reader);
+	if (!reader->isValid || nodeId < 0 || nodeId >= scene->nodesCount) {
+		return;
+	}
+	VoxNode* node = &scene->nodes[nodeId];
+	*node = {};
+	setVoxTransformIdentity(&node->transform);
+	readVoxDictionary(reader, node);
+	if (chunk->id == VOX_CHUNK_TRANSFORM) {
+		node->childNodeId = readVoxI32(reader);
+		//reserved id and layer id
+		readVoxI32(reader);
+		readVoxI32(reader);
+		i32 framesCount = readVoxI32(reader);
+		if (framesCount > 0) {
+			readVoxDictionary(reader, node);
+		}
+		node->type = VOX_NODE_TRANSFORM;
+	} else if (chunk->id == VOX_CHUNK_GROUP) {
+		node->childrenCount = readVoxI32(reader);
+		node->childNodeIds = reader->at;
+		if (node->childrenCount < 0 || (i64)node->childrenCount * 4 > reader->end - reader->at) {
+			reader->isValid = 0;
+		}
+		node->type = VOX_NODE_GROUP;
+	} else {
+		i32 modelsCount = readVoxI32(reader);
+		node->modelId = modelsCount > 0 ? readVoxI32(reader) : -1;
+		node->type = VOX_NODE_SHAPE;
+	}
+	if (!reader->isValid) {
+		node->type = VOX_NODE_NONE;
+	}
+}
+
+static bool32 isVoxNodeChunk(u32 id) {
+	return id == VOX_CHUNK_TRANSFORM || id == VOX_CHUNK_GROUP || id == VOX_CHUNK_SHAPE;
+}
+
+static void fillDefaultVoxPalette(u32* palette) {
+	//the palette magicavoxel uses when a file has none: a 6x6x6 color cube without black, then ramps of red, green, blue and gray
+	const u32 cubeLevels[6] = { 0xff, 0xcc, 0x99, 0x66, 0x33, 0x00 };
+	const u32 rampLevels[10] = { 0xee, 0xdd, 0xbb, 0xaa, 0x88, 0x77, 0x55, 0x44, 0x22, 0x11 };
+	u32 i = 0;
+	palette[i++] = 0;
+	for (u32 r = 0; r < 6; r++) {
+		for (u32 g = 0; g < 6; g++) {
+			for (u32 b = 0; b < 6; b++) {
+				if (r == 5 && g == 5 && b == 5) {
+					continue;
+				}
+				palette[i++] = 0xff000000 | (cubeLevels[b] << 16) | (cubeLevels[g] << 8) | cubeLevels[r];
+			}
+		}
+	}
+	for (u32 shift = 0; shift < 24; shift += 8) {
+		for (u32 l = 0; l < 10; l++) {
+			palette[i++] = 0xff000000 | (rampLevels[l] << shift);
+		}
+	}
+	for (u32 l = 0; l < 10; l++) {
+		palette[i++] = 0xff000000 | (rampLevels[l] * 0x010101);
+	}
+	_assert(i == 256);
+}
+
+static bool32 readVoxScene(const u8* data, u64 size, VoxScene* scene) {
+	VoxReader reader = { data, data + size, 1 };
+	if (readVoxI32(&reader) != (i32)VOX_MAGIC) {
+		return 0;
+	}
+	//any version is read. the chunks haven't changed in ways that matter here
+	readVoxI32(&reader);
+	VoxChunk main;
+	if (!readVoxChunk(&reader, &main) || main.id != VOX_CHUNK_MAIN) {
+		return 0;
+	}
+	//the children of the main chunk
+	VoxReader chunksBegin = { main.content.end, reader.at, 1 };
+	fillDefaultVoxPalette(scene->palette);
+
+	//counts the models and nodes first, so they can be allocated once
+	i32 maxNodeId = -1;
+	VoxReader chunks = chunksBegin;
+	VoxChunk chunk;
+	while (chunks.at < chunks.end && readVoxChunk(&chunks, &chunk)) {
+		if (chunk.id == VOX_CHUNK_SIZE) {
+			scene->modelsCount += 1;
+		} else if (isVoxNodeChunk(chunk.id)) {
+			i32 nodeId = readVoxI32(&chunk.content);
+			maxNodeId = MAX(maxNodeId, nodeId);
+		}
+	}
+	//every node takes more than 12 bytes, so larger ids can only come from a broken file
+	if (!chunks.isValid || maxNodeId > (i64)(size / 12)) {
+		return 0;
+	}
+	scene->models = (VoxModel*) calloc(MAX(scene->modelsCount, 1), sizeof(VoxModel));
+	scene->nodesCount = maxNodeId + 1;
+	scene->nodes = (VoxNode*) calloc(MAX(scene->nodesCount, 1), sizeof(VoxNode));
+
+	i32 modelsCount = 0;
+	chunks = chunksBegin;
+	while (chunks.at < chunks.end && readVoxChunk(&chunks, &chunk)) {
+		if (chunk.id == VOX_CHUNK_SIZE) {
+			VoxModel* model = &scene->models[modelsCount];
+			for (i32 i = 0; i < 3; i++) {
+				model->size[i] = readVoxI32(&chunk.content);
+			}
+			if (!chunk.content.isValid || model->size[0] <= 0 || model->size[1] <= 0 || model->size[2] <= 0) {
+				return 0;
+			}
+		} else if (chunk.id == VOX_CHUNK_XYZI) {
+			//voxels belong to the size chunk right before them
+			if (modelsCount >= scene->modelsCount || scene->models[modelsCount].size[0] == 0) {
+				return 0;
+			}
+			VoxModel* model = &scene->models[modelsCount];
+			model->voxelsCount = readVoxI32(&chunk.content);
+			model->voxels = chunk.content.at;
+			if (model->voxelsCount < 0 || (i64)model->voxelsCount * 4 > chunk.content.end - chunk.content.at) {
+				return 0;
+			}
+			modelsCount += 1;
+		} else if (chunk.id == VOX_CHUNK_RGBA) {
+			if (chunk.content.end - chunk.content.at < 256 * 4) {
+				return 0;
+			}
+			//the last entry of the chunk is never used
+			memcpy(&scene->palette[1], chunk.content.at, 255 * 4);
+		} else if (isVoxNodeChunk(chunk.id)) {
+			readVoxNode(&chunk, scene);
+		}
+	}
+	scene->modelsCount = modelsCount;
+	return chunks.isValid;
+}
+
+//returns 0 if the scene has more than VOX_MAX_INSTANCES instances or takes more than VOX_MAX_NODE_VISITS visits
+static bool32 collectVoxInstances(VoxScene* scene, i32 nodeId, VoxTransform* transform, i32 depth) {
+	if (nodeId < 0 || nodeId >= scene->nodesCount || depth > VOX_MAX_SCENE_DEPTH || scene->nodes[nodeId].isOnPath) {
+		return 1;
+	}
+	if (scene->nodeVisitsCount == VOX_MAX_NODE_VISITS) {
+		return 0;
+	}
+	scene->nodeVisitsCount += 1;
+	VoxNode* node = &scene->nodes[nodeId];
+	bool32 isCollected = 1;
+	node->isOnPath = 1;
+	if (node->type == VOX_NODE_TRANSFORM) {
+		if (!node->isHidden) {
+			VoxTransform childTransform = combineVoxTransforms(transform, &node->transform);
+			isCollected = collectVoxInstances(scene, node->childNodeId, &childTransform, depth + 1);
+		}
+	} else if (node->type == VOX_NODE_GROUP) {
+		for (i32 i = 0; i < node->childrenCount && isCollected; i++) {
+			i32 childNodeId;
+			memcpy(&childNodeId, node->childNodeIds + i * 4, sizeof(childNodeId));
+			isCollected = collectVoxInstances(scene, childNodeId, transform, depth + 1);
+		}
+	} else if (node->type == VOX_NODE_SHAPE && node->modelId >= 0 && node->modelId < scene->modelsCount) {
+		if (scene->instancesCount == VOX_MAX_INSTANCES) {
+			isCollected = 0;
+		} else {
+			if (scene->instancesCount == scene->instancesCapacity) {
+				scene->instancesCapacity = MAX(16, scene->instancesCapacity * 2);
+				scene->instances = (VoxInstance*) realloc(scene->instances, scene->instancesCapacity * sizeof(VoxInstance));
+			}
+			scene->instances[scene->instancesCount] = VoxInstance{ node->modelId, *transform };
+			scene->instancesCount += 1;
+		}
+	}
+	node->isOnPath = 0;
+	return isCollected;
+}
+
+static RGBAColorF32 unpackVoxColor(u32 color) {
+	RGBAColorF32 result;
+	result.r = (f32)(color & 0xff) / 255.0f;
+	result.g = (f32)((color >> 8) & 0xff) / 255.0f;
+	result.b = (f32)((color >> 16) & 0xff) / 255.0f;
+	result.a = (f32)(color >> 24) / 255.0f;
+	return result;
+}
+
+static void addVoxInstance(VoxelArray* voxelArray, VoxModel* model, VoxTransform* transform, RGBAColorF32* palette, i32 voxelSize) {
+	//a quaternion can't mirror, so a mirroring rotation is split into a rotation and a mirror along the model's x axis,
+	//and the mirror is applied to the voxels
+	i32 mirror = calculateVoxDeterminant(transform->rotation) < 0 ? -1 : 1;
+	i32 rotation[3][3];
+	memcpy(rotation, transform->rotation, sizeof(rotation));
+	for (i32 i = 0; i < 3; i++) {
+		rotation[i][0] *= mirror;
+	}
+
+	//the same rotation in game space: C * rotation * C^T, where C converts .vox to game coordinates
+	math::Matrix4 rotationMatrix = math::initIdentityMatrix();
+	for (i32 column = 0; column < 3; column++) {
+		i32 axis[3] = {};
+		axis[column] = 1;
+		i32 voxAxis[3], rotatedAxis[3], gameAxis[3];
+		convertGameToVox(axis, voxAxis);
+		rotateVoxVector(rotation, voxAxis, rotatedAxis);
+		convertVoxToGame(rotatedAxis, gameAxis);
+		for (i32 row = 0; row < 3; row++) {
+			rotationMatrix.a.m[row + column * 4] = (f32)gameAxis[row];
+		}
+	}
+	i32 position[3];
+	convertVoxToGame(transform->translation, position);
+	i32 groupIndex = addEmptyVoxelGroup(voxelArray, math::Vector3{ (f32)position[0], (f32)position[1], (f32)position[2] }.scale((f32)voxelSize));
+	voxelArray->groups[groupIndex].rotation = math::createQuaternionFromRotationMatrix(rotationMatrix);
+
+	//a voxel's position in its group is origin + x * axes[0] + y * axes[1] + z * axes[2]
+	Vector3i axes[3];
+	for (i32 a = 0; a < 3; a++) {
+		i32 axis[3] = {};
+		axis[a] = a == 0 ? mirror : 1;
+		i32 gameAxis[3];
+		convertVoxToGame(axis, gameAxis);
+		axes[a] = Vector3i{ gameAxis[0] * voxelSize, gameAxis[1] * voxelSize, gameAxis[2] * voxelSize };
+	}
+	i32 center[3] = { mirror * (model->size[0] / 2), model->size[1] / 2, model->size[2] / 2 };
+	i32 gameCenter[3];
+	convertVoxToGame(center, gameCenter);
+	Vector3i origin = { -gameCenter[0] * voxelSize, -gameCenter[1] * voxelSize, -gameCenter[2] * voxelSize };
+
+	Vector3ui scale = { (u32)voxelSize, (u32)voxelSize, (u32)voxelSize };
+	i32 voxelsBegin = voxelArray->voxelsCount;
+	RGBAColorF32 colors[VOX_IMPORT_BATCH_SIZE];
+	Vector3i positions[VOX_IMPORT_BATCH_SIZE];
+	i32 batchCount = 0;
+	const u8* voxel = model->voxels;
+	for (i32 i = 0; i < model->voxelsCount; i++, voxel += 4) {
+		i32 x = voxel[0];
+		i32 y = voxel[1];
+		i32 z = voxel[2];
+		positions[batchCount] = Vector3i{
+			origin.x + x * axes[0].x + y * axes[1].x + z * axes[2].x,
+			origin.y + x * axes[0].y + y * axes[1].y + z * axes[2].y,
+			origin.z + x * axes[0].z + y * axes[1].z + z * axes[2].z,
+		};
+		colors[batchCount] = palette[voxel[3]];
+		batchCount += 1;
+		if (batchCount == VOX_IMPORT_BATCH_SIZE) {
+			addVoxelsToGroup(voxelArray, colors, positions, scale, batchCount, groupIndex);
+			batchCount = 0;
+		}
+	}
+	if (batchCount > 0) {
+		addVoxelsToGroup(voxelArray, colors, positions, scale, batchCount, groupIndex);
+	}
+	//in whatever order the file had them. sorted, they save to much smaller chunks
+	sortVoxelsInMortonOrder(voxelArray, VoxelSpan{ voxelsBegin, voxelArray->voxelsCount });
+}
+
+bool32 importVoxFile(const char* filepath, VoxelArray* voxelArray, u32 voxelSize) {
+	MappedFile file = {};
+	if (!mapFile(filepath, &file)) {
+		printf("couldn't open %s\n", filepath);
+		return 0;
+	}
+	VoxScene scene = {};
+	bool32 isImported = readVoxScene(file.data, file.size, &scene);
+	if (!isImported) {
+		printf("%s isn't a valid .vox file\n", filepath);
+	}
+
+	if (isImported) {
+		VoxTransform identity;
+		setVoxTransformIdentity(&identity);
+		if (scene.nodesCount > 0 && scene.nodes[0].type != VOX_NODE_NONE) {
+			if (!collectVoxInstances(&scene, 0, &identity, 0)) {
+				printf("%s's scene graph places more than %d models or is too large to walk\n", filepath, VOX_MAX_INSTANCES);
+				isImported = 0;
+			}
+		} else {
+			//files from before the scene graph. every model is at the origin
+			scene.instances = (VoxInstance*) malloc(MAX(scene.modelsCount, 1) * sizeof(VoxInstance));
+			for (i32 i = 0; i < scene.modelsCount; i++) {
+				scene.instances[i] = VoxInstance{ i, identity };
+			}
+			scene.instancesCount = scene.modelsCount;
+		}
+	}
+
+	if (isImported) {
+
+		u64 voxelsCount = 0;
+		i32 groupsCount = 0;
+		for (i32 i = 0; i < scene.instancesCount; i++) {
+			i32 modelVoxelsCount = scene.models[scene.instances[i].modelId].voxelsCount;
+			voxelsCount += modelVoxelsCount;
+			groupsCount += modelVoxelsCount > 0;
+		}
+		if (voxelArray->voxelsCount + voxelsCount > (u64)voxelArray->voxelsCapacity || voxelArray->groupsCount + groupsCount > voxelArray->groupsCapacity) {
+			printf("%s has %llu voxels in %d groups, which don't fit in the voxel array\n", filepath, (unsigned long long)voxelsCount, groupsCount);
+			isImported = 0;
+		}
+	}
+
+	if (isImported) {
+		RGBAColorF32 palette[256];
+		for (i32 i = 0; i < 256; i++) {
+			palette[i] = unpackVoxColor(scene.palette[i]);
+		}
+		for (i32 i = 0; i < scene.instancesCount; i++) {
+			VoxModel* model = &scene.models[scene.instances[i].modelId];
+			if (model->voxelsCount > 0) {
+				addVoxInstance(voxelArray, model, &scene.instances[i].transform, palette, (i32)voxelSize);
+			}
+		}
+	}
+
+	free(scene.models);
+	free(scene.nodes);
+	free(scene.instances);
+	unmapFile(&file);
+	return isImported;
+}
+
+struct VoxWriter {
+	FILE* file;
+	u8* buffer;
+	u32 bufferedSize;
+	u64 writtenSize;
+	bool32 isValid;
+};
+
+static void flushVoxWriter(VoxWriter* writer) {
+	if (writer->bufferedSize > 0 && fwrite(writer->buffer, 1, writer->bufferedSize, writer->file) != writer->bufferedSize) {
+		writer->isValid = 0;
+	}
+	writer->bufferedSize = 0;
+}
+
+static void writeVoxBytes(VoxWriter* writer, const void* data, u32 size) {
+	_assert(size <= VOX_WRITE_BUFFER_SIZE);
+	if (writer->bufferedSize + size > VOX_WRITE_BUFFER_SIZE) {
+		flushVoxWriter(writer);
+	}
+	memcpy(writer->buffer + writer->bufferedSize, data, size);
+	writer->bufferedSize += size;
+	writer->writtenSize += size;
+}
+
+static void writeVoxI32(VoxWriter* writer, i32 value) {
+	writeVoxBytes(writer, &value, sizeof(value));
+}
+
+static void writeVoxChunkHeader(VoxWriter* writer, u32 id, u32 contentSize, u32 childrenSize) {
+	writeVoxI32(writer, (i32)id);
+	writeVoxI32(writer, (i32)contentSize);
+	writeVoxI32(writer, (i32)childrenSize);
+}
+
+static u32 calculateVoxStringSize(const char* text) {
+	return 4 + (u32)strlen(text);
+}
+
+static void writeVoxString(VoxWriter* writer, const char* text) {
+	u32 length = (u32)strlen(text);
+	writeVoxI32(writer, (i32)length);
+	writeVoxBytes(writer, text, length);
+}
+
+struct VoxPaletteBuilder {
+	//abgr. index 0 is never used by a voxel
+	u32 colors[256];
+	u32 colorsCount;
+	u32 tableColors[VOX_PALETTE_TABLE_SIZE];
+	u8 tableIndices[VOX_PALETTE_TABLE_SIZE];
+	bool32 isTableSlotUsed[VOX_PALETTE_TABLE_SIZE];
+};
+
+static u32 packVoxColor(RGBAColorF32 color) {
+	f32 channels[4] = { color.r, color.g, color.b, color.a };
+	u32 result = 0;
+	for (u32 i = 0; i < 4; i++) {
+		f32 channel = fminf(fmaxf(channels[i], 0.0f), 1.0f);
+		result |= (u32)(channel * 255.0f + 0.5f) << (i * 8);
+	}
+	return result;
+}
+
+static u8 findVoxPaletteIndex(VoxPaletteBuilder* builder, u32 color) {
+	u32 slot = (color * 2654435761u) >> 23;
+	while (builder->isTableSlotUsed[slot]) {
+		if (builder->tableColors[slot] == color) {
+			return builder->tableIndices[slot];
+		}
+		slot = (slot + 1) & (VOX_PALETTE_TABLE_SIZE - 1);
+	}
+	if (builder->colorsCount < 256) {
+		u8 index = (u8)builder->colorsCount;
+		builder->colors[index] = color;
+		builder->colorsCount += 1;
+		builder->isTableSlotUsed[slot] = 1;
+		builder->tableColors[slot] = color;
+		builder->tableIndices[slot] = index;
+		return index;
+	}
+	//the palette is full. the nearest color isn't added to the table, which has to keep free slots
+	u8 nearestIndex = 1;
+	u32 nearestDistance = 0xffffffff;
+	for (u32 i = 1; i < 256; i++) {
+		u32 distance = 0;
+		for (u32 shift = 0; shift < 32; shift += 8) {
+			i32 d = (i32)((color >> shift) & 0xff) - (i32)((builder->colors[i] >> shift) & 0xff);
+			distance += d * d;
+		}
+		if (distance < nearestDistance) {
+			nearestDistance = distance;
+			nearestIndex = (u8)i;
+		}
+	}
+	return nearestIndex;
+}
+
+static i32 divideRoundingDown(i32 a, i32 b) {
+	return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+static i32 divideRoundingUp(i32 a, i32 b) {
+	return -divideRoundingDown(-a, b);
+}
+
+//the cells whose centers are inside the voxel, in the group's .vox space. a voxel smaller than a cell gets the cell its center is in
+static void calculateVoxCellRange(Vector3i position, Vector3ui scale, i32 voxelSize, i32 cellsMin[3], i32 cellsMax[3]) {
+	i32 gamePosition[3] = { position.x, position.y, position.z };
+	i32 center[3];
+	convertGameToVox(gamePosition, center);
+	i32 extent[3] = { (i32)scale.x, (i32)scale.z, (i32)scale.y };
+	for (i32 a = 0; a < 3; a++) {
+		cellsMin[a] = divideRoundingUp(2 * center[a] - extent[a], 2 * voxelSize);
+		cellsMax[a] = divideRoundingUp(2 * center[a] + extent[a], 2 * voxelSize) - 1;
+		if (cellsMin[a] > cellsMax[a]) {
+			cellsMin[a] = cellsMax[a] = divideRoundingDown(2 * center[a] + voxelSize, 2 * voxelSize);
+		}
+	}
+}
+
+//returns 0 if the rotation isn't a multiple of 90 degrees around every axis
+static bool32 extractVoxRotation(math::Quaternion q, i32 rotation[3][3]) {
+	math::Matrix4 m = math::createRotationMatrix(q);
+	for (i32 column = 0; column < 3; column++) {
+		i32 axis[3] = {};
+		axis[column] = 1;
+		i32 gameAxis[3];
+		convertVoxToGame(axis, gameAxis);
+		f32 rotated[3];
+		for (i32 row = 0; row < 3; row++) {
+			rotated[row] = m.a.m[row] * gameAxis[0] + m.a.m[row + 4] * gameAxis[1] + m.a.m[row + 8] * gameAxis[2];
+		}
+		i32 rounded[3] = { (i32)roundf(rotated[0]), (i32)roundf(rotated[1]), (i32)roundf(rotated[2]) };
+		for (i32 row = 0; row < 3; row++) {
+			if (fabsf(rotated[row] - (f32)rounded[row]) > 1.0f / 1024.0f) {
+				return 0;
+			}
+		}
+		i32 voxAxis[3];
+		convertGameToVox(rounded, voxAxis);
+		for (i32 row = 0; row < 3; row++) {
+			rotation[row][column] = voxAxis[row];
+		}
+	}
+	return 1;
+}
+
+struct VoxExportedModel {
+	i32 translation[3];
+	u32 rotation;
+};
+
+//fills the model's cells with the palette indices of the group's voxels, 0 where there's none. voxels that overlap, or aren't
+//aligned to the cells, cover some cells more than once, and the last one wins. returns the occupied cells count
+static u32 rasterizeVoxModel(VoxelArray* voxelArray, i32 groupIndex, i32 voxelSize, VoxPaletteBuilder* palette, i32 cellsMin[3], i32 size[3], u8* cells) {
+	memset(cells, 0, (u64)size[0] * size[1] * size[2]);
+	VoxelGroup* group = &voxelArray->groups[groupIndex];
+	for (i32 i = group->voxelsBegin; i < group->voxelsEnd; i++) {
+		if (voxelArray->voxelsGroupIndex[i] != groupIndex || voxelArray->voxelsScale[i].x == 0) {
+			continue;
+		}
+		u8 colorIndex = findVoxPaletteIndex(palette, packVoxColor(voxelArray->colors[i]));
+		i32 voxelCellsMin[3], voxelCellsMax[3];
+		calculateVoxCellRange(voxelArray->voxelsPosition[i], voxelArray->voxelsScale[i], voxelSize, voxelCellsMin, voxelCellsMax);
+		for (i32 z = voxelCellsMin[2]; z <= voxelCellsMax[2]; z++) {
+			for (i32 y = voxelCellsMin[1]; y <= voxelCellsMax[1]; y++) {
+				for (i32 x = voxelCellsMin[0]; x <= voxelCellsMax[0]; x++) {
+					cells[((z - cellsMin[2]) * size[1] + y - cellsMin[1]) * size[0] + x - cellsMin[0]] = colorIndex;
+				}
+			}
+		}
+	}
+	u32 cellsCount = 0;
+	for (u64 i = 0; i < (u64)size[0] * size[1] * size[2]; i++) {
+		cellsCount += cells[i] != 0;
+	}
+	return cellsCount;
+}
+
+static void writeVoxModel(VoxWriter* writer, u8* cells, i32 size[3], u32 cellsCount) {
+	writeVoxChunkHeader(writer, VOX_CHUNK_SIZE, 12, 0);
+	for (i32 a = 0; a < 3; a++) {
+		writeVoxI32(writer, size[a]);
+	}
+	writeVoxChunkHeader(writer, VOX_CHUNK_XYZI, 4 + cellsCount * 4, 0);
+	writeVoxI32(writer, (i32)cellsCount);
+	for (i32 z = 0; z < size[2]; z++) {
+		for (i32 y = 0; y < size[1]; y++) {
+			for (i32 x = 0; x < size[0]; x++) {
+				u8 colorIndex = cells[(z * size[1] + y) * size[0] + x];
+				if (colorIndex != 0) {
+					u8 cell[4] = { (u8)x, (u8)y, (u8)z, colorIndex };
+					writeVoxBytes(writer, cell, sizeof(cell));
+				}
+			}
+		}
+	}
+}
+
+static void writeVoxTransformNode(VoxWriter* writer, i32 nodeId, i32 childNodeId, i32 layerId, const char* translation, const char* rotation) {
+	u32 frameSize = 4;
+	if (translation != nil) {
+		frameSize += calculateVoxStringSize("_t") + calculateVoxStringSize(translation);
+	}
+	if (rotation != nil) {
+		frameSize += calculateVoxStringSize("_r") + calculateVoxStringSize(rotation);
+	}
+	writeVoxChunkHeader(writer, VOX_CHUNK_TRANSFORM, 4 + 4 + 4 + 4 + 4 + 4 + frameSize, 0);
+	writeVoxI32(writer, nodeId);
+	writeVoxI32(writer, 0);
+	writeVoxI32(writer, childNodeId);
+	writeVoxI32(writer, -1);
+	writeVoxI32(writer, layerId);
+	writeVoxI32(writer, 1);
+	writeVoxI32(writer, (translation != nil) + (rotation != nil));
+	if (translation != nil) {
+		writeVoxString(writer, "_t");
+		writeVoxString(writer, translation);
+	}
+	if (rotation != nil) {
+		writeVoxString(writer, "_r");
+		writeVoxString(writer, rotation);
+	}
+}
+
+static void writeVoxScene(VoxWriter* writer, VoxExportedModel* models, i32 modelsCount) {
+	//a root transform, a group with every model, then a transform and a shape per model
+	writeVoxTransformNode(writer, 0, 1, -1, nil, nil);
+	writeVoxChunkHeader(writer, VOX_CHUNK_GROUP, 4 + 4 + 4 + modelsCount * 4, 0);
+	writeVoxI32(writer, 1);
+	writeVoxI32(writer, 0);
+	writeVoxI32(writer, modelsCount);
+	for (i32 i = 0; i < modelsCount; i++) {
+		writeVoxI32(writer, 2 + i * 2);
+	}
+	for (i32 i = 0; i < modelsCount; i++) {
+		char translation[64];
+		snprintf(translation, sizeof(translation), "%d %d %d", models[i].translation[0], models[i].translation[1], models[i].translation[2]);
+		char rotation[16];
+		snprintf(rotation, sizeof(rotation), "%u", models[i].rotation);
+		//4 is the bits of the identity
+		writeVoxTransformNode(writer, 2 + i * 2, 3 + i * 2, 0, translation, models[i].rotation != 4 ? rotation : nil);
+
+		writeVoxChunkHeader(writer, VOX_CHUNK_SHAPE, 4 + 4 + 4 + 4 + 4, 0);
+		writeVoxI32(writer, 3 + i * 2);
+		writeVoxI32(writer, 0);
+		writeVoxI32(writer, 1);
+		writeVoxI32(writer, i);
+		writeVoxI32(writer, 0);
+	}
+	writeVoxChunkHeader(writer, VOX_CHUNK_LAYER, 4 + 4 + 4, 0);
+	writeVoxI32(writer, 0);
+	writeVoxI32(writer, 0);
+	writeVoxI32(writer, -1);
+}
+
+bool32 exportVoxFile(const char* filepath, VoxelArray* voxelArray, u32 voxelSize) {
+	FILE* file = fopen(filepath, "wb");
+	if (file == nil) {
+		printf("couldn't create %s\n", filepath);
+		return 0;
+	}
+	VoxWriter writer = {};
+	writer.file = file;
+	writer.buffer = (u8*) malloc(VOX_WRITE_BUFFER_SIZE);
+	writer.isValid = 1;
+	VoxPaletteBuilder* palette = (VoxPaletteBuilder*) calloc(1, sizeof(VoxPaletteBuilder));
+	palette->colorsCount = 1;
+	VoxExportedModel* models = (VoxExportedModel*) malloc(MAX(voxelArray->groupsCount, 1) * sizeof(VoxExportedModel));
+	i32 modelsCount = 0;
+	//the palette index of every cell of the model being written, for the largest model there can be
+	u8* cells = (u8*) malloc((u64)VOX_MAX_MODEL_SIZE * VOX_MAX_MODEL_SIZE * VOX_MAX_MODEL_SIZE);
+
+	writeVoxI32(&writer, (i32)VOX_MAGIC);
+	writeVoxI32(&writer, VOX_FILE_VERSION);
+	//the size of the main chunk's children is written once they are
+	writeVoxChunkHeader(&writer, VOX_CHUNK_MAIN, 0, 0);
+	u64 childrenOffset = writer.writtenSize;
+
+	for (i32 g = 0; g < voxelArray->groupsCount; g++) {
+		VoxelGroup* group = &voxelArray->groups[g];
+		if (group->voxelsCount == 0) {
+			continue;
+		}
+		i32 rotation[3][3];
+		if (!extractVoxRotation(group->rotation, rotation)) {
+			printf("group %d isn't rotated by a multiple of 90 degrees. it's exported without its rotation\n", g);
+			memset(rotation, 0, sizeof(rotation));
+			for (i32 i = 0; i < 3; i++) {
+				rotation[i][i] = 1;
+			}
+		}
+
+		i32 cellsMin[3] = { INT32_MAX, INT32_MAX, INT32_MAX };
+		i32 cellsMax[3] = { INT32_MIN, INT32_MIN, INT32_MIN };
+		bool32 hasVoxels = 0;
+		for (i32 i = group->voxelsBegin; i < group->voxelsEnd; i++) {
+			if (voxelArray->voxelsGroupIndex[i] != g || voxelArray->voxelsScale[i].x == 0) {
+				continue;
+			}
+			i32 voxelCellsMin[3], voxelCellsMax[3];
+			calculateVoxCellRange(voxelArray->voxelsPosition[i], voxelArray->voxelsScale[i], (i32)voxelSize, voxelCellsMin, voxelCellsMax);
+			for (i32 a = 0; a < 3; a++) {
+				cellsMin[a] = MIN(cellsMin[a], voxelCellsMin[a]);
+				cellsMax[a] = MAX(cellsMax[a], voxelCellsMax[a]);
+			}
+			hasVoxels = 1;
+		}
+		if (!hasVoxels) {
+			continue;
+		}
+		i32 size[3];
+		bool32 isFitting = 1;
+		for (i32 a = 0; a < 3; a++) {
+			size[a] = cellsMax[a] - cellsMin[a] + 1;
+			isFitting = isFitting && size[a] <= VOX_MAX_MODEL_SIZE;
+		}
+		if (!isFitting) {
+			printf("group %d is %d x %d x %d cells, more than a .vox model can hold. it's left out\n", g, size[0], size[1], size[2]);
+			continue;
+		}
+		u32 cellsCount = rasterizeVoxModel(voxelArray, g, (i32)voxelSize, palette, cellsMin, size, cells);
+		writeVoxModel(&writer, cells, size, cellsCount);
+
+		//the importer centers the model on size / 2, so the translation moves from the group's origin to there
+		VoxExportedModel* model = &models[modelsCount];
+		i32 center[3] = { cellsMin[0] + size[0] / 2, cellsMin[1] + size[1] / 2, cellsMin[2] + size[2] / 2 };
+		rotateVoxVector(rotation, center, model->translation);
+		i32 groupPosition[3] = {
+			(i32)roundf(group->position.x / voxelSize),
+			(i32)roundf(group->position.y / voxelSize),
+			(i32)roundf(group->position.z / voxelSize),
+		};
+		i32 voxGroupPosition[3];
+		convertGameToVox(groupPosition, voxGroupPosition);
+		for (i32 a = 0; a < 3; a++) {
+			model->translation[a] += voxGroupPosition[a];
+		}
+		model->rotation = encodeVoxRotation(rotation);
+		modelsCount += 1;
+	}
+
+	writeVoxScene(&writer, models, modelsCount);
+	writeVoxChunkHeader(&writer, VOX_CHUNK_RGBA, 256 * 4, 0);
+	writeVoxBytes(&writer, &palette->colors[1], 255 * 4);
+	writeVoxI32(&writer, 0);
+	flushVoxWriter(&writer);
+
+	i32 childrenSize = (i32)(writer.writtenSize - childrenOffset);
+	bool32 isWritten = writer.isValid && seekFile(file, childrenOffset - 4) && fwrite(&childrenSize, sizeof(childrenSize), 1, file) == 1;
+	isWritten = fclose(file) == 0 && isWritten;
+	if (!isWritten) {
+		printf("couldn't write %s\n", filepath);
+	}
+	free(cells);
+	free(models);
+	free(palette);
+	free(writer.buffer);
+	return isWritten;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#ifndef VOXELS_GAME_VOX_H
+#define VOXELS_GAME_VOX_H
+
+#include "common.h"
+#include "voxel.h"
+
+/*
+	reads and writes MagicaVoxel .vox files.
+	every shape in the file's scene graph becomes a voxel group, placed by the transforms above it. files without a scene graph
+	get one group per model, at the origin. a .vox voxel becomes a cube that's voxelSize voxel units wide, centered on
+	the model's center. .vox is z up and the game is y up, so .vox (x, y, z) is (x, z, -y) in the game
+*/
+
+const u32 VOX_DEFAULT_VOXEL_SIZE = 2;
+//a model can't be larger than this along any axis
+const i32 VOX_MAX_MODEL_SIZE = 256;
+
+//appends the file's groups and voxels to the voxel array. returns 0 without adding anything if the file is invalid or doesn't fit
+bool32 importVoxFile(const char* filepath, VoxelArray* voxelArray, u32 voxelSize);
+//writes every group that has loaded voxels as a model, cut into cells of voxelSize. groups that span more than VOX_MAX_MODEL_SIZE cells
+//along an axis are left out, and rotations that aren't multiples of 90 degrees are dropped. past 255 colors, voxels get the nearest color
+//of the palette. a cell covered by several voxels gets the color of the last one. returns 0 if the file couldn't be written
+bool32 exportVoxFile(const char* filepath, VoxelArray* voxelArray, u32 voxelSize);
+
+#endif
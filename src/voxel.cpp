@@ -1,5 +1,11 @@
 #include "voxel.h"
 #include "memory.h"
+#include "collision.h"
+#include "platform.h"
+#include "radix_sort.h"
+
+#include <stdlib.h>
+#include <string.h>
 
 void initVoxelArray(VoxelArray* voxelArray, MemoryAllocator* memoryAllocator, i32 voxelCapacity, i32 groupsCapacity) {
 	voxelArray->voxelsCount = 0;
@@ -11,11 +17,32 @@ void initVoxelArray(VoxelArray* voxelArray, MemoryAllocator* memoryAllocator, i3
 
 	voxelArray->groupsCount = 0;
 	voxelArray->groupsCapacity = groupsCapacity;
-	voxelArray->groups = (VoxelGroup*) allocateMemory(memoryAllocator, voxelCapacity * sizeof(VoxelGroup));
+	voxelArray->groups = (VoxelGroup*) allocateMemory(memoryAllocator, groupsCapacity * sizeof(VoxelGroup));
+
+	voxelArray->dirtyGroupsCount = 0;
+	voxelArray->dirtyGroups = (i32*) allocateMemory(memoryAllocator, groupsCapacity * sizeof(i32));
+	voxelArray->dirtySpansCount = 0;
+	voxelArray->dirtySpans = (VoxelSpan*) allocateMemory(memoryAllocator, MAX_DIRTY_VOXEL_SPANS * sizeof(VoxelSpan));
+
+	voxelArray->chunksCapacity = (voxelCapacity + VOXELS_PER_CHUNK - 1) / VOXELS_PER_CHUNK;
+	voxelArray->isChunkModified = (u8*) allocateMemory(memoryAllocator, voxelArray->chunksCapacity);
+	memset(voxelArray->isChunkModified, 0, voxelArray->chunksCapacity);
+	voxelArray->snapshot = nil;
+}
+
+static void addVoxelToGroupSpan(VoxelGroup* group, i32 voxelIndex) {
+	if (group->voxelsBegin == group->voxelsEnd) {
+		group->voxelsBegin = voxelIndex;
+		group->voxelsEnd = voxelIndex + 1;
+	} else {
+		group->voxelsBegin = MIN(group->voxelsBegin, voxelIndex);
+		group->voxelsEnd = MAX(group->voxelsEnd, voxelIndex + 1);
+	}
 }
 
 i32 addStandaloneVoxel(VoxelArray* voxelArray, RGBAColorF32 color, Vector3i position, Vector3ui scale) {
 	_assert(voxelArray->voxelsCount < voxelArray->voxelsCapacity);
+	_assert(voxelArray->groupsCount < voxelArray->groupsCapacity);
 	voxelArray->colors[voxelArray->voxelsCount] = color;
 	voxelArray->voxelsPosition[voxelArray->voxelsCount] = Vector3i{};
 	voxelArray->voxelsScale[voxelArray->voxelsCount] = scale;
@@ -27,9 +54,14 @@ i32 addStandaloneVoxel(VoxelArray* voxelArray, RGBAColorF32 color, Vector3i posi
 		math::Vector3{1.0f, 0.0f, 0.0f},
 	};
 	group->position = math::Vector3{ (f32)position.x, (f32)position.y, (f32)position.z };
-	group->voxelsCount += 1;
+	group->voxelsCount = 1;
+	group->voxelsBegin = voxelArray->voxelsCount;
+	group->voxelsEnd = voxelArray->voxelsCount + 1;
+	group->isDirty = 0;
+	voxelArray->areGroupsModified = 1;
 
 	voxelArray->voxelsGroupIndex[voxelArray->voxelsCount] = voxelArray->groupsCount;
+	markVoxelDirty(voxelArray, voxelArray->voxelsCount);
 	voxelArray->groupsCount += 1;
 	voxelArray->voxelsCount += 1;
 	return voxelArray->voxelsCount-1;
@@ -43,12 +75,38 @@ i32 addVoxelToGroup(VoxelArray* voxelArray, RGBAColorF32 color, Vector3i positio
 	voxelArray->voxelsGroupIndex[voxelArray->voxelsCount] = groupIndex;
 
 	voxelArray->groups[groupIndex].voxelsCount += 1;
+	addVoxelToGroupSpan(&voxelArray->groups[groupIndex], voxelArray->voxelsCount);
+	markVoxelDirty(voxelArray, voxelArray->voxelsCount);
 
 	voxelArray->voxelsCount += 1;
 
 	return voxelArray->voxelsCount-1;
 }
 
+i32 appendVoxelsToGroup(VoxelArray* voxelArray, i32 count, i32 groupIndex) {
+	_assert(count > 0 && voxelArray->voxelsCount + count <= voxelArray->voxelsCapacity);
+	i32 begin = voxelArray->voxelsCount;
+	VoxelGroup* group = &voxelArray->groups[groupIndex];
+	group->voxelsCount += count;
+	addVoxelToGroupSpan(group, begin);
+	addVoxelToGroupSpan(group, begin + count - 1);
+	markVoxelSpanDirty(voxelArray, VoxelSpan{ begin, begin + count });
+
+	voxelArray->voxelsCount += count;
+	return begin;
+}
+
+i32 addVoxelsToGroup(VoxelArray* voxelArray, const RGBAColorF32* colors, const Vector3i* positions, Vector3ui scale, i32 count, i32 groupIndex) {
+	i32 begin = appendVoxelsToGroup(voxelArray, count, groupIndex);
+	memcpy(&voxelArray->colors[begin], colors, count * sizeof(RGBAColorF32));
+	memcpy(&voxelArray->voxelsPosition[begin], positions, count * sizeof(Vector3i));
+	for (i32 i = begin; i < begin + count; i++) {
+		voxelArray->voxelsScale[i] = scale;
+		voxelArray->voxelsGroupIndex[i] = groupIndex;
+	}
+	return begin;
+}
+
 i32 addEmptyVoxelGroup(VoxelArray* voxelArray, math::Vector3 position) {
 	_assert(voxelArray->groupsCount < voxelArray->groupsCapacity);
 	VoxelGroup* group = &voxelArray->groups[voxelArray->groupsCount];
@@ -58,12 +116,314 @@ i32 addEmptyVoxelGroup(VoxelArray* voxelArray, math::Vector3 position) {
 	};
 	group->position = position;
 	group->voxelsCount = 0;
+	group->voxelsBegin = 0;
+	group->voxelsEnd = 0;
+	group->isDirty = 0;
+	voxelArray->areGroupsModified = 1;
 
 	voxelArray->groupsCount += 1;
 
 	return voxelArray->groupsCount-1;
 }
 
+void markVoxelGroupDirty(VoxelArray* voxelArray, i32 groupIndex) {
+	VoxelGroup* group = &voxelArray->groups[groupIndex];
+	voxelArray->areGroupsModified = 1;
+	if (!group->isDirty) {
+		group->isDirty = 1;
+		voxelArray->dirtyGroups[voxelArray->dirtyGroupsCount] = groupIndex;
+		voxelArray->dirtyGroupsCount += 1;
+	}
+}
+
+void markVoxelDirty(VoxelArray* voxelArray, i32 voxelIndex) {
+	markVoxelSpanDirty(voxelArray, VoxelSpan{ voxelIndex, voxelIndex + 1 });
+}
+
+void markVoxelSpanDirty(VoxelArray* voxelArray, VoxelSpan span) {
+	if (span.begin >= span.end) {
+		return;
+	}
+	for (i32 c = span.begin / VOXELS_PER_CHUNK; c <= (span.end - 1) / VOXELS_PER_CHUNK; c++) {
+		voxelArray->isChunkModified[c] = 1;
+	}
+	//voxels are usually added in order, so most new spans extend the last one
+	if (voxelArray->dirtySpansCount > 0) {
+		VoxelSpan* last = &voxelArray->dirtySpans[voxelArray->dirtySpansCount - 1];
+		if (span.begin <= last->end && span.end >= last->begin) {
+			last->begin = MIN(last->begin, span.begin);
+			last->end = MAX(last->end, span.end);
+			return;
+		}
+	}
+	if (voxelArray->dirtySpansCount < MAX_DIRTY_VOXEL_SPANS) {
+		voxelArray->dirtySpans[voxelArray->dirtySpansCount] = span;
+		voxelArray->dirtySpansCount += 1;
+		return;
+	}
+	//out of spans. one span covering all of them uploads more than needed, but never misses a voxel
+	VoxelSpan all = span;
+	for (i32 i = 0; i < voxelArray->dirtySpansCount; i++) {
+		all.begin = MIN(all.begin, voxelArray->dirtySpans[i].begin);
+		all.end = MAX(all.end, voxelArray->dirtySpans[i].end);
+	}
+	voxelArray->dirtySpans[0] = all;
+	voxelArray->dirtySpansCount = 1;
+}
+
+static void copyVoxelChunkForSnapshot(VoxelSnapshot* snapshot, VoxelArray* voxelArray, i32 chunkIndex) {
+	i32 begin = chunkIndex * VOXELS_PER_CHUNK;
+	u64 count = (u64)MIN(VOXELS_PER_CHUNK, snapshot->voxelsCount - begin);
+	u8* copy = (u8*) malloc(count * (sizeof(RGBAColorF32) + sizeof(Vector3i) + sizeof(Vector3ui) + sizeof(i32)));
+	_assert(copy != nil);
+	u8* at = copy;
+	memcpy(at, &voxelArray->colors[begin], count * sizeof(RGBAColorF32));
+	at += count * sizeof(RGBAColorF32);
+	memcpy(at, &voxelArray->voxelsPosition[begin], count * sizeof(Vector3i));
+	at += count * sizeof(Vector3i);
+	memcpy(at, &voxelArray->voxelsScale[begin], count * sizeof(Vector3ui));
+	at += count * sizeof(Vector3ui);
+	memcpy(at, &voxelArray->voxelsGroupIndex[begin], count * sizeof(i32));
+	snapshot->chunksCopy[chunkIndex] = copy;
+	snapshot->copiedChunksCount += 1;
+}
+
+void prepareVoxelSpanWrite(VoxelArray* voxelArray, VoxelSpan span) {
+	VoxelSnapshot* snapshot = voxelArray->snapshot;
+	if (snapshot == nil) {
+		return;
+	}
+	span.end = MIN(span.end, snapshot->voxelsCount);
+	if (span.begin >= span.end) {
+		return;
+	}
+	for (i32 c = span.begin / VOXELS_PER_CHUNK; c <= (span.end - 1) / VOXELS_PER_CHUNK; c++) {
+		u32 state = atomicCompareExchangeU32(&snapshot->chunksState[c], VOXEL_CHUNK_SHARED, VOXEL_CHUNK_COPYING);
+		if (state == VOXEL_CHUNK_SHARED) {
+			copyVoxelChunkForSnapshot(snapshot, voxelArray, c);
+			atomicStoreU32(&snapshot->chunksState[c], VOXEL_CHUNK_COPIED);
+		}
+		//the reader holds a chunk for as long as it takes to encode it, so this is short
+		while (state == VOXEL_CHUNK_READING) {
+			sleepMilliseconds(0);
+			state = atomicLoadU32(&snapshot->chunksState[c]);
+		}
+	}
+}
+
+static int compareVoxelSpans(const void* a, const void* b) {
+	return ((const VoxelSpan*)a)->begin - ((const VoxelSpan*)b)->begin;
+}
+
+i32 collectDirtyVoxelSpans(VoxelArray* voxelArray, VoxelSpan* spans, i32 spansCapacity) {
+	i32 spansCount = 0;
+	VoxelSpan all = { voxelArray->voxelsCount, 0 };
+	for (i32 i = 0; i < voxelArray->dirtyGroupsCount + voxelArray->dirtySpansCount; i++) {
+		VoxelSpan span;
+		if (i < voxelArray->dirtyGroupsCount) {
+			VoxelGroup* group = &voxelArray->groups[voxelArray->dirtyGroups[i]];
+			group->isDirty = 0;
+			span = VoxelSpan{ group->voxelsBegin, group->voxelsEnd };
+		} else {
+			span = voxelArray->dirtySpans[i - voxelArray->dirtyGroupsCount];
+		}
+		span.end = MIN(span.end, voxelArray->voxelsCount);
+		if (span.begin >= span.end) {
+			continue;
+		}
+		all.begin = MIN(all.begin, span.begin);
+		all.end = MAX(all.end, span.end);
+		if (spansCount < spansCapacity) {
+			spans[spansCount] = span;
+		}
+		spansCount += 1;
+	}
+	voxelArray->dirtyGroupsCount = 0;
+	voxelArray->dirtySpansCount = 0;
+
+	if (spansCount == 0) {
+		return 0;
+	}
+	if (spansCount > spansCapacity) {
+		spans[0] = all;
+		return 1;
+	}
+
+	//spans with small gaps between them are merged, since one larger copy is cheaper than two small ones
+	const i32 maxMergeGap = 16;
+	qsort(spans, spansCount, sizeof(VoxelSpan), compareVoxelSpans);
+	i32 mergedCount = 1;
+	for (i32 i = 1; i < spansCount; i++) {
+		VoxelSpan* last = &spans[mergedCount - 1];
+		if (spans[i].begin <= last->end + maxMergeGap) {
+			last->end = MAX(last->end, spans[i].end);
+		} else {
+			spans[mergedCount] = spans[i];
+			mergedCount += 1;
+		}
+	}
+	return mergedCount;
+}
+
+static u64 spreadMortonBits(u32 value) {
+	u64 x = value & 0x1fffff;
+	x = (x | x << 32) & 0x1f00000000ffffull;
+	x = (x | x << 16) & 0x1f0000ff0000ffull;
+	x = (x | x << 8) & 0x100f00f00f00f00full;
+	x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+	x = (x | x << 2) & 0x1249249249249249ull;
+	return x;
+}
+
+//no branches or tables, so loops over many codes can be vectorized
+static u32 compactMortonBits(u64 x) {
+	x &= 0x1249249249249249ull;
+	x = (x ^ (x >> 2)) & 0x10c30c30c30c30c3ull;
+	x = (x ^ (x >> 4)) & 0x100f00f00f00f00full;
+	x = (x ^ (x >> 8)) & 0x1f0000ff0000ffull;
+	x = (x ^ (x >> 16)) & 0x1f00000000ffffull;
+	x = (x ^ (x >> 32)) & 0x1fffffull;
+	return (u32)x;
+}
+
+static u32 biasMortonCoordinate(i32 value) {
+	i32 clamped = MIN(MAX(value, -VOXEL_MORTON_BIAS), VOXEL_MORTON_BIAS - 1);
+	return (u32)(clamped + VOXEL_MORTON_BIAS);
+}
+
+u64 calculateVoxelMortonCode(Vector3i position) {
+	return spreadMortonBits(biasMortonCoordinate(position.x)) | (spreadMortonBits(biasMortonCoordinate(position.y)) << 1) | (spreadMortonBits(biasMortonCoordinate(position.z)) << 2);
+}
+
+Vector3i decodeVoxelMortonCode(u64 code) {
+	return Vector3i{
+		(i32)compactMortonBits(code) - VOXEL_MORTON_BIAS,
+		(i32)compactMortonBits(code >> 1) - VOXEL_MORTON_BIAS,
+		(i32)compactMortonBits(code >> 2) - VOXEL_MORTON_BIAS,
+	};
+}
+
+bool32 isVoxelPositionMortonCodable(Vector3i position) {
+	return
+		position.x >= -VOXEL_MORTON_BIAS && position.x < VOXEL_MORTON_BIAS &&
+		position.y >= -VOXEL_MORTON_BIAS && position.y < VOXEL_MORTON_BIAS &&
+		position.z >= -VOXEL_MORTON_BIAS && position.z < VOXEL_MORTON_BIAS;
+}
+
+void sortVoxelsInMortonOrder(VoxelArray* voxelArray, VoxelSpan span) {
+	i32 count = span.end - span.begin;
+	if (count < 2) {
+		return;
+	}
+	prepareVoxelSpanWrite(voxelArray, span);
+	MemoryAllocator scratch = {};
+	//the keys and indices, the attributes being gathered, and the sort's own arrays
+	initMemoryAllocator(&scratch, (u64)count * (sizeof(u64) + sizeof(u32) + sizeof(RGBAColorF32)) + 48 + calculateRadixSortScratchSize(count, sizeof(u64), 1));
+	u64* keys = (u64*) allocateMemory(&scratch, count * sizeof(u64));
+	u32* voxelIndices = (u32*) allocateMemory(&scratch, count * sizeof(u32));
+	for (i32 i = 0; i < count; i++) {
+		keys[i] = calculateVoxelMortonCode(voxelArray->voxelsPosition[span.begin + i]);
+		voxelIndices[i] = span.begin + i;
+	}
+	radixSort(keys, voxelIndices, count, &scratch);
+
+	//gathers every attribute in the new order, one at a time through the same scratch array
+	void* attributes = allocateMemory(&scratch, count * sizeof(RGBAColorF32));
+	RGBAColorF32* colors = (RGBAColorF32*)attributes;
+	for (i32 i = 0; i < count; i++) {
+		colors[i] = voxelArray->colors[voxelIndices[i]];
+	}
+	memcpy(&voxelArray->colors[span.begin], colors, count * sizeof(RGBAColorF32));
+	Vector3i* positions = (Vector3i*)attributes;
+	for (i32 i = 0; i < count; i++) {
+		positions[i] = voxelArray->voxelsPosition[voxelIndices[i]];
+	}
+	memcpy(&voxelArray->voxelsPosition[span.begin], positions, count * sizeof(Vector3i));
+	Vector3ui* scales = (Vector3ui*)attributes;
+	for (i32 i = 0; i < count; i++) {
+		scales[i] = voxelArray->voxelsScale[voxelIndices[i]];
+	}
+	memcpy(&voxelArray->voxelsScale[span.begin], scales, count * sizeof(Vector3ui));
+	i32* groupIndices = (i32*)attributes;
+	for (i32 i = 0; i < count; i++) {
+		groupIndices[i] = voxelArray->voxelsGroupIndex[voxelIndices[i]];
+	}
+	memcpy(&voxelArray->voxelsGroupIndex[span.begin], groupIndices, count * sizeof(i32));
+	free(scratch.memory);
+	markVoxelSpanDirty(voxelArray, span);
+}
+
+void initVoxelSnapshot(VoxelSnapshot* snapshot, MemoryAllocator* memoryAllocator, VoxelArray* voxelArray) {
+	*snapshot = {};
+	snapshot->groups = (VoxelGroup*) allocateMemory(memoryAllocator, voxelArray->groupsCapacity * sizeof(VoxelGroup));
+	snapshot->chunksState = (volatile u32*) allocateMemory(memoryAllocator, voxelArray->chunksCapacity * sizeof(u32));
+	memset((void*)snapshot->chunksState, 0, voxelArray->chunksCapacity * sizeof(u32));
+	snapshot->chunksCopy = (u8**) allocateMemory(memoryAllocator, voxelArray->chunksCapacity * sizeof(u8*));
+	memset(snapshot->chunksCopy, 0, voxelArray->chunksCapacity * sizeof(u8*));
+}
+
+void beginVoxelSnapshot(VoxelSnapshot* snapshot, VoxelArray* voxelArray, const u8* isChunkShared) {
+	_assert(voxelArray->snapshot == nil);
+	snapshot->voxelsCount = voxelArray->voxelsCount;
+	snapshot->groupsCount = voxelArray->groupsCount;
+	memcpy(snapshot->groups, voxelArray->groups, voxelArray->groupsCount * sizeof(VoxelGroup));
+	snapshot->copiedChunksCount = 0;
+	i32 chunksCount = (voxelArray->voxelsCount + VOXELS_PER_CHUNK - 1) / VOXELS_PER_CHUNK;
+	for (i32 i = 0; i < chunksCount; i++) {
+		snapshot->chunksState[i] = isChunkShared[i] ? VOXEL_CHUNK_SHARED : VOXEL_CHUNK_NOT_SHARED;
+	}
+	voxelArray->snapshot = snapshot;
+}
+
+void acquireVoxelSnapshotChunk(VoxelSnapshot* snapshot, VoxelArray* voxelArray, i32 chunkIndex, VoxelArray* voxels) {
+	i32 begin = chunkIndex * VOXELS_PER_CHUNK;
+	i32 count = MIN(VOXELS_PER_CHUNK, snapshot->voxelsCount - begin);
+	voxels->voxelsCapacity = count;
+	voxels->voxelsCount = count;
+	voxels->groupsCapacity = snapshot->groupsCount;
+	voxels->groupsCount = snapshot->groupsCount;
+	voxels->groups = snapshot->groups;
+	for (;;) {
+		u32 state = atomicCompareExchangeU32(&snapshot->chunksState[chunkIndex], VOXEL_CHUNK_SHARED, VOXEL_CHUNK_READING);
+		if (state == VOXEL_CHUNK_SHARED) {
+			voxels->colors = &voxelArray->colors[begin];
+			voxels->voxelsPosition = &voxelArray->voxelsPosition[begin];
+			voxels->voxelsScale = &voxelArray->voxelsScale[begin];
+			voxels->voxelsGroupIndex = &voxelArray->voxelsGroupIndex[begin];
+			return;
+		}
+		if (state == VOXEL_CHUNK_COPIED) {
+			u8* at = snapshot->chunksCopy[chunkIndex];
+			voxels->colors = (RGBAColorF32*)at;
+			at += count * sizeof(RGBAColorF32);
+			voxels->voxelsPosition = (Vector3i*)at;
+			at += count * sizeof(Vector3i);
+			voxels->voxelsScale = (Vector3ui*)at;
+			at += count * sizeof(Vector3ui);
+			voxels->voxelsGroupIndex = (i32*)at;
+			return;
+		}
+		_assert(state == VOXEL_CHUNK_COPYING);
+		sleepMilliseconds(0);
+	}
+}
+
+void releaseVoxelSnapshotChunk(VoxelSnapshot* snapshot, i32 chunkIndex) {
+	//a copied chunk stays copied, since nothing else reads it
+	atomicCompareExchangeU32(&snapshot->chunksState[chunkIndex], VOXEL_CHUNK_READING, VOXEL_CHUNK_READ);
+}
+
+void endVoxelSnapshot(VoxelSnapshot* snapshot, VoxelArray* voxelArray) {
+	_assert(voxelArray->snapshot == snapshot);
+	i32 chunksCount = (snapshot->voxelsCount + VOXELS_PER_CHUNK - 1) / VOXELS_PER_CHUNK;
+	for (i32 i = 0; i < chunksCount; i++) {
+		free(snapshot->chunksCopy[i]);
+		snapshot->chunksCopy[i] = nil;
+		snapshot->chunksState[i] = VOXEL_CHUNK_NOT_SHARED;
+	}
+	voxelArray->snapshot = nil;
+}
+
 math::Vector3 convertVoxelUnitsToWorldUnits(Vector3i v) {
 	return math::Vector3{ (f32)v.x, (f32)v.y, (f32) v.z }.scale(voxelUnitsToWorldUnits);
 }
@@ -71,3 +431,53 @@ math::Vector3 convertVoxelUnitsToWorldUnits(Vector3i v) {
 math::Vector3 convertVoxelUnitsToWorldUnits(Vector3ui v) {
 	return math::Vector3{ (f32)v.x, (f32)v.y, (f32) v.z }.scale(voxelUnitsToWorldUnits);
 }
+
+i32 pickVoxel(VoxelArray* voxelArray, math::Vector3 rayOrigin, math::Vector3 rayDirection, f32 tmax, f32* hitDistance, math::Vector3* hitPoint) {
+	return pickVoxelInSpan(voxelArray, VoxelSpan{ 0, voxelArray->voxelsCount }, rayOrigin, rayDirection, tmax, hitDistance, hitPoint);
+}
+
+i32 pickVoxelInSpan(
+	VoxelArray* voxelArray, VoxelSpan span, math::Vector3 rayOrigin, math::Vector3 rayDirection, f32 tmax, f32* hitDistance, math::Vector3* hitPoint
+) {
+	i32 hitVoxelIndex = -1;
+	*hitDistance = tmax;
+	for (i32 i = span.begin; i < span.end; i++) {
+		//the voxels of world chunks that aren't loaded yet have no size
+		if (voxelArray->voxelsScale[i].x == 0) {
+			continue;
+		}
+		OBB o = {};
+		o.center = convertVoxelUnitsToWorldUnits(voxelArray->voxelsPosition[i]);
+		o.halfExtents = convertVoxelUnitsToWorldUnits(voxelArray->voxelsScale[i]).scale(0.5f);
+		o.orientation = math::createQuaternionRotation( 0.0f, {1.0f, 0.0f, 0.0f} );
+
+		i32 voxelGroupIndex = voxelArray->voxelsGroupIndex[i];
+		if (voxelGroupIndex >= 0) {
+			o.center = math::rotateVector(o.center, voxelArray->groups[voxelGroupIndex].rotation).add(voxelArray->groups[voxelGroupIndex].position.scale(voxelUnitsToWorldUnits));
+			o.orientation = voxelArray->groups[voxelGroupIndex].rotation;
+		}
+		f32 t;
+		math::Vector3 q;
+		if (isRayIntersectingOBB(rayOrigin, rayDirection, o, tmax, &t, &q) && t < *hitDistance) {
+			*hitDistance = t;
+			*hitPoint = q;
+			hitVoxelIndex = i;
+		}
+	}
+	return hitVoxelIndex;
+}
+
+math::Matrix4 calculateVoxelModelMatrix(VoxelArray* voxelArray, i32 voxelIndex) {
+	math::Vector3 worldPosition = convertVoxelUnitsToWorldUnits(voxelArray->voxelsPosition[voxelIndex]);
+	math::Matrix4 rotationMatrix = math::initIdentityMatrix();
+	if (voxelArray->voxelsGroupIndex[voxelIndex] >= 0) {
+		//if part of a group, the voxel's world position is now relative to the group's world position.
+		VoxelGroup* group = &voxelArray->groups[voxelArray->voxelsGroupIndex[voxelIndex]];
+		worldPosition = math::rotateVector(worldPosition, group->rotation);
+		worldPosition = worldPosition.add(group->position.scale(voxelUnitsToWorldUnits));
+		rotationMatrix = math::createRotationMatrix(group->rotation);
+	}
+	math::Matrix4 model = math::translateMatrix(math::initIdentityMatrix(), worldPosition);
+	model = model.multiply(rotationMatrix);
+	return math::scaleMatrix(model, convertVoxelUnitsToWorldUnits(voxelArray->voxelsScale[voxelIndex]));
+}
@@ -23,6 +23,49 @@ struct VoxelGroup {
 	math::Vector3 position;
 	math::Quaternion rotation;
 	i32 voxelsCount;
+	//range of voxel indices that contains every voxel of the group. it may contain voxels of other groups too
+	i32 voxelsBegin;
+	i32 voxelsEnd;
+	bool32 isDirty;
+};
+
+//voxel indices [begin, end)
+struct VoxelSpan {
+	i32 begin;
+	i32 end;
+};
+
+const i32 MAX_DIRTY_VOXEL_SPANS = 1024;
+//morton codes interleave 21 bits of each coordinate, which are offset so that negative coordinates keep their order
+const i32 VOXEL_MORTON_AXIS_BITS = 21;
+const i32 VOXEL_MORTON_BIAS = 1 << (VOXEL_MORTON_AXIS_BITS - 1);
+//voxels are saved and loaded in chunks of consecutive voxel indices
+const i32 VOXELS_PER_CHUNK = 4096;
+
+typedef u32 VoxelChunkShareState;
+const VoxelChunkShareState VOXEL_CHUNK_NOT_SHARED = 0;
+const VoxelChunkShareState VOXEL_CHUNK_SHARED = 1;
+//the voxel array is copying the chunk before it writes to it
+const VoxelChunkShareState VOXEL_CHUNK_COPYING = 2;
+const VoxelChunkShareState VOXEL_CHUNK_COPIED = 3;
+//the snapshot's reader is reading the chunk from the voxel array, which has to wait for it before writing to it
+const VoxelChunkShareState VOXEL_CHUNK_READING = 4;
+const VoxelChunkShareState VOXEL_CHUNK_READ = 5;
+
+/*
+	the voxels of a voxel array as they were at one point, for reading on another thread while the voxel array keeps changing.
+	the chunks it shares stay in the voxel array until something is about to write to one of them, which copies it for the snapshot first.
+	the groups are small, so they are copied when the snapshot is taken.
+	voxels added after it was taken aren't in it, so adding voxels never copies anything
+*/
+struct VoxelSnapshot {
+	i32 voxelsCount;
+	i32 groupsCount;
+	VoxelGroup* groups;
+	volatile u32* chunksState;
+	//a copied chunk's colors, positions, scales and group indices, one after the other. allocated when the chunk is copied
+	u8** chunksCopy;
+	i32 copiedChunksCount;
 };
 
 struct VoxelArray {
@@ -39,6 +82,21 @@ struct VoxelArray {
 	i32 groupsCount;
 
 	VoxelGroup* groups;
+
+	//voxels whose instance data has to be rebuilt and uploaded. a voxel's instance index is its voxel index
+	i32 dirtyGroupsCount;
+	i32* dirtyGroups;
+	i32 dirtySpansCount;
+	VoxelSpan* dirtySpans;
+
+	//chunks whose voxels differ from the saved world. they are written on the next save
+	i32 chunksCapacity;
+	u8* isChunkModified;
+	//whether a group was added or moved since the saved world. the group table is written by every save either way
+	bool32 areGroupsModified;
+
+	//set while a snapshot shares chunks with the voxel array
+	VoxelSnapshot* snapshot;
 };
 
 void initVoxelArray(VoxelArray* voxelArray, MemoryAllocator* memoryAllocator, i32 voxelCapacity, i32 groupsCapacity);
@@ -46,10 +104,53 @@ void initVoxelArray(VoxelArray* voxelArray, MemoryAllocator* memoryAllocator, i3
 i32 addStandaloneVoxel(VoxelArray* voxelArray, RGBAColorF32 color, Vector3i position, Vector3ui scale);
 //returns voxel index
 i32 addVoxelToGroup(VoxelArray* voxelArray, RGBAColorF32 color, Vector3i position, Vector3ui scale, i32 groupIndex);
+//appends count voxels of the same scale to the group in one go. returns the voxel index of the first one
+i32 addVoxelsToGroup(VoxelArray* voxelArray, const RGBAColorF32* colors, const Vector3i* positions, Vector3ui scale, i32 count, i32 groupIndex);
+//adds count voxels to the group without writing them, for filling them in place. the caller writes their colors, positions, scales and
+//group indices before anything reads them. returns the voxel index of the first one
+i32 appendVoxelsToGroup(VoxelArray* voxelArray, i32 count, i32 groupIndex);
 //returns voxel group index
 i32 addEmptyVoxelGroup(VoxelArray* voxelArray, math::Vector3 position);
 
+//call after changing the position or rotation of a group
+void markVoxelGroupDirty(VoxelArray* voxelArray, i32 groupIndex);
+void markVoxelDirty(VoxelArray* voxelArray, i32 voxelIndex);
+//also marks the span's chunks as modified
+void markVoxelSpanDirty(VoxelArray* voxelArray, VoxelSpan span);
+//call before writing to voxels that already exist. chunks of the span that a snapshot still shares are copied for it first,
+//which may wait for its reader to finish reading one of them
+void prepareVoxelSpanWrite(VoxelArray* voxelArray, VoxelSpan span);
+//writes the dirty voxels as sorted, non overlapping spans and clears the dirty state. returns the amount of spans written
+i32 collectDirtyVoxelSpans(VoxelArray* voxelArray, VoxelSpan* spans, i32 spansCapacity);
+
+//reorders the voxels of the span along a z-order curve of their positions, which keeps voxels that are near each other
+//near in the array. voxel indices change, so it's only for voxels nothing refers to yet, like the ones that were just added.
+//the span must not hold voxels of groups that also have voxels outside of it
+void sortVoxelsInMortonOrder(VoxelArray* voxelArray, VoxelSpan span);
+//coordinates outside of [-VOXEL_MORTON_BIAS, VOXEL_MORTON_BIAS) are clamped
+u64 calculateVoxelMortonCode(Vector3i position);
+Vector3i decodeVoxelMortonCode(u64 code);
+bool32 isVoxelPositionMortonCodable(Vector3i position);
+
+void initVoxelSnapshot(VoxelSnapshot* snapshot, MemoryAllocator* memoryAllocator, VoxelArray* voxelArray);
+//takes the snapshot and shares the chunks that are set in isChunkShared with it. the voxel array can't have another snapshot at the same time
+void beginVoxelSnapshot(VoxelSnapshot* snapshot, VoxelArray* voxelArray, const u8* isChunkShared);
+//for the snapshot's reader, on any thread. points voxels at the shared chunk's voxels, from index 0, as they were when the snapshot was taken.
+//they stay valid until releaseVoxelSnapshotChunk. voxels only gets its attribute pointers and counts set, and the snapshot's groups
+void acquireVoxelSnapshotChunk(VoxelSnapshot* snapshot, VoxelArray* voxelArray, i32 chunkIndex, VoxelArray* voxels);
+void releaseVoxelSnapshotChunk(VoxelSnapshot* snapshot, i32 chunkIndex);
+//stops sharing chunks and frees the copies. the reader has to be done with the snapshot
+void endVoxelSnapshot(VoxelSnapshot* snapshot, VoxelArray* voxelArray);
+
 math::Vector3 convertVoxelUnitsToWorldUnits(Vector3i v);
 math::Vector3 convertVoxelUnitsToWorldUnits(Vector3ui v);
 
+//returns the index of the closest voxel hit by the ray, or -1 if none was hit before tmax. hitDistance is left at tmax when nothing was hit
+i32 pickVoxel(VoxelArray* voxelArray, math::Vector3 rayOrigin, math::Vector3 rayDirection, f32 tmax, f32* hitDistance, math::Vector3* hitPoint);
+i32 pickVoxelInSpan(
+	VoxelArray* voxelArray, VoxelSpan span, math::Vector3 rayOrigin, math::Vector3 rayDirection, f32 tmax, f32* hitDistance, math::Vector3* hitPoint
+);
+//the world transform of the voxel's unit cube, including the rotation and position of its group
+math::Matrix4 calculateVoxelModelMatrix(VoxelArray* voxelArray, i32 voxelIndex);
+
 #endif
@@ -0,0 +1,952 @@
+#include "voxel_light.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+
+const i32 MAX_VOXEL_LIGHT_JOBS = 16;
+//fewer nodes than this per job aren't worth splitting
+const i32 MIN_VOXEL_LIGHT_JOB_NODES = 256;
+const u32 VOXEL_LIGHT_NO_CELLS = 0xffffffff;
+//must be a power of two
+const u32 VOXEL_LIGHT_RING_CAPACITY = 8192;
+//the nodes a job gathers before it takes room for them in the light's queue
+const i32 VOXEL_LIGHT_OUTBOX_CAPACITY = 256;
+const i32 NO_VOXEL_GROUP_TRANSFORM = -2;
+//a cell that's closed queues 12 removals, and one that's opened 12 fills, and its source and the sky
+const i32 VOXEL_LIGHT_NODES_PER_CHANGED_CELL = 14;
+
+//the node is for the sky light instead of the block light
+const u8 VOXEL_LIGHT_NODE_SKY = 1;
+//the node came from the cell above, which sky light at 15 goes through without dropping
+const u8 VOXEL_LIGHT_NODE_DOWN = 2;
+//fills only. spreads the light the cell has, instead of offering it a level
+const u8 VOXEL_LIGHT_NODE_SEED = 4;
+//fills only. the cell's own source, or the sky above the volume, which is looked up when the cell is filled, so it's never out of date
+const u8 VOXEL_LIGHT_NODE_ANCHORED = 8;
+
+//+x, -x, +y, -y, +z, -z
+static const i32 VOXEL_LIGHT_DIRECTIONS[6][3] = {
+	{ 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+};
+const i32 VOXEL_LIGHT_DOWN = 3;
+
+struct VoxelLightOutbox {
+	i32 count;
+	VoxelLightNode nodes[VOXEL_LIGHT_OUTBOX_CAPACITY];
+};
+
+struct VoxelLightJob {
+	VoxelLight* light;
+	bool32 isRemoving;
+	//chunk indices [begin, end)
+	i32 chunksBegin;
+	i32 chunksEnd;
+	i32 processedNodesCount;
+	Vector3i changedCellsMin;
+	Vector3i changedCellsMax;
+
+	//the chunk being spread through
+	u32 base;
+	Vector3i chunkCellsMin;
+	VoxelLightOutbox removals;
+	VoxelLightOutbox fills;
+	//the chunk's cells waiting to spread their light, as their index in the chunk, the sky bit above it and, for removals, the level
+	//they had above that
+	u32 ringHead;
+	u32 ringTail;
+	u32 ring[VOXEL_LIGHT_RING_CAPACITY];
+};
+
+u32 getVoxelBlockLight(u8 light) {
+	return light & VOXEL_BLOCK_LIGHT_MASK;
+}
+
+u32 getVoxelSkyLight(u8 light) {
+	return light >> VOXEL_SKY_LIGHT_SHIFT;
+}
+
+static u32 getCellLight(u8 levels, u32 isSky) {
+	return isSky ? getVoxelSkyLight(levels) : getVoxelBlockLight(levels);
+}
+
+static u8 setCellLight(u8 levels, u32 isSky, u32 level) {
+	return isSky ? (u8)((levels & VOXEL_BLOCK_LIGHT_MASK) | (level << VOXEL_SKY_LIGHT_SHIFT)) : (u8)((levels & ~VOXEL_BLOCK_LIGHT_MASK) | level);
+}
+
+static i32 floorDivide(i32 a, i32 b) {
+	i32 q = a / b;
+	return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+static Vector3i calculateLightCellsDims(VoxelLight* light) {
+	return Vector3i{ light->chunksDims.x * VOXEL_LIGHT_CHUNK_SIZE, light->chunksDims.y * VOXEL_LIGHT_CHUNK_SIZE, light->chunksDims.z * VOXEL_LIGHT_CHUNK_SIZE };
+}
+
+static bool32 isLightCellInside(VoxelLight* light, Vector3i p) {
+	Vector3i dims = calculateLightCellsDims(light);
+	return p.x >= 0 && p.y >= 0 && p.z >= 0 && p.x < dims.x && p.y < dims.y && p.z < dims.z;
+}
+
+static u32 calculateLightCell(VoxelLight* light, Vector3i p) {
+	i32 s = VOXEL_LIGHT_CHUNK_SIZE;
+	i32 chunk = ((p.z / s) * light->chunksDims.y + p.y / s) * light->chunksDims.x + p.x / s;
+	return (u32)chunk * VOXEL_LIGHT_CHUNK_CELLS + (u32)(((p.z % s) * s + p.y % s) * s + p.x % s);
+}
+
+static Vector3i calculateLightCellPosition(VoxelLight* light, u32 cell) {
+	i32 s = VOXEL_LIGHT_CHUNK_SIZE;
+	i32 chunk = (i32)(cell / VOXEL_LIGHT_CHUNK_CELLS);
+	i32 local = (i32)(cell % VOXEL_LIGHT_CHUNK_CELLS);
+	return Vector3i{
+		(chunk % light->chunksDims.x) * s + local % s,
+		((chunk / light->chunksDims.x) % light->chunksDims.y) * s + (local / s) % s,
+		(chunk / (light->chunksDims.x * light->chunksDims.y)) * s + local / (s * s),
+	};
+}
+
+static Vector3i addLightDirection(Vector3i p, i32 d) {
+	return Vector3i{ p.x + VOXEL_LIGHT_DIRECTIONS[d][0], p.y + VOXEL_LIGHT_DIRECTIONS[d][1], p.z + VOXEL_LIGHT_DIRECTIONS[d][2] };
+}
+
+static void addCellToBounds(Vector3i p, Vector3i* min, Vector3i* max) {
+	min->x = MIN(min->x, p.x);
+	min->y = MIN(min->y, p.y);
+	min->z = MIN(min->z, p.z);
+	max->x = MAX(max->x, p.x);
+	max->y = MAX(max->y, p.y);
+	max->z = MAX(max->z, p.z);
+}
+
+static void clearCellBounds(Vector3i* min, Vector3i* max) {
+	*min = Vector3i{ INT32_MAX, INT32_MAX, INT32_MAX };
+	*max = Vector3i{ INT32_MIN, INT32_MIN, INT32_MIN };
+}
+
+static bool32 isLightPositionInVolume(VoxelLight* light, Vector3i position, Vector3i* cell) {
+	cell->x = floorDivide(position.x - light->origin.x, light->cellSize);
+	cell->y = floorDivide(position.y - light->origin.y, light->cellSize);
+	cell->z = floorDivide(position.z - light->origin.z, light->cellSize);
+	return isLightCellInside(light, *cell);
+}
+
+//nodes queued on the main thread, between rounds
+static void queueLightNode(VoxelLight* light, bool32 isRemoval, u32 cell, u32 level, u8 flags) {
+	volatile u64* count = isRemoval ? &light->removalNodesCount : &light->fillNodesCount;
+	if (*count >= (u64)light->nodesCapacity) {
+		light->isRelightNeeded = 1;
+		return;
+	}
+	VoxelLightNode* nodes = isRemoval ? light->removalNodes : light->fillNodes;
+	nodes[*count] = VoxelLightNode{ cell, (u8)level, flags };
+	*count += 1;
+}
+
+static void queueLightNeighbors(VoxelLight* light, Vector3i p, bool32 isRemoval, u32 level, u8 flags) {
+	for (i32 d = 0; d < 6; d++) {
+		Vector3i n = addLightDirection(p, d);
+		if (isLightCellInside(light, n)) {
+			queueLightNode(light, isRemoval, calculateLightCell(light, n), level, flags | (d == VOXEL_LIGHT_DOWN ? VOXEL_LIGHT_NODE_DOWN : 0));
+		}
+	}
+}
+
+//the cell's light is taken out, along with the light that came through it
+static void darkenLightCell(VoxelLight* light, u32 cell, Vector3i p, u32 isSky) {
+	u32 level = getCellLight(light->levels[cell], isSky);
+	if (level == 0) {
+		return;
+	}
+	light->levels[cell] = setCellLight(light->levels[cell], isSky, 0);
+	addCellToBounds(p, &light->changedCellsMin, &light->changedCellsMax);
+	queueLightNeighbors(light, p, 1, level, isSky ? VOXEL_LIGHT_NODE_SKY : 0);
+}
+
+//a cell that stops being blocked is filled from the cells around it, its source, and the sky when it's at the top of the volume
+static void openLightCell(VoxelLight* light, u32 cell, Vector3i p) {
+	queueLightNeighbors(light, p, 0, 0, VOXEL_LIGHT_NODE_SEED);
+	queueLightNeighbors(light, p, 0, 0, VOXEL_LIGHT_NODE_SEED | VOXEL_LIGHT_NODE_SKY);
+	if (light->sources[cell] > 0) {
+		queueLightNode(light, 0, cell, 0, VOXEL_LIGHT_NODE_ANCHORED);
+	}
+	if (p.y == calculateLightCellsDims(light).y - 1) {
+		queueLightNode(light, 0, cell, 0, VOXEL_LIGHT_NODE_ANCHORED | VOXEL_LIGHT_NODE_SKY);
+	}
+}
+
+static void closeLightCell(VoxelLight* light, u32 cell, Vector3i p) {
+	darkenLightCell(light, cell, p, 0);
+	darkenLightCell(light, cell, p, 1);
+}
+
+//the voxels' centers are in voxel units, so the rotation isn't scaled
+struct VoxelLightGroupTransform {
+	i32 groupIndex;
+	f32 rotation[3][3];
+	math::Vector3 translation;
+};
+
+static void loadVoxelLightGroupTransform(VoxelArray* voxelArray, i32 groupIndex, VoxelLightGroupTransform* transform) {
+	if (transform->groupIndex == groupIndex) {
+		return;
+	}
+	transform->groupIndex = groupIndex;
+	math::Matrix4 m = math::initIdentityMatrix();
+	transform->translation = math::Vector3{ 0.0f, 0.0f, 0.0f };
+	if (groupIndex >= 0) {
+		VoxelGroup* group = &voxelArray->groups[groupIndex];
+		m = math::createRotationMatrix(group->rotation);
+		transform->translation = group->position;
+	}
+	transform->rotation[0][0] = m.e.m00;
+	transform->rotation[0][1] = m.e.m01;
+	transform->rotation[0][2] = m.e.m02;
+	transform->rotation[1][0] = m.e.m10;
+	transform->rotation[1][1] = m.e.m11;
+	transform->rotation[1][2] = m.e.m12;
+	transform->rotation[2][0] = m.e.m20;
+	transform->rotation[2][1] = m.e.m21;
+	transform->rotation[2][2] = m.e.m22;
+}
+
+//the cells whose centers are inside the voxel's world bounds. the bounds are shrunk a little so voxels only touching a center don't block it
+static void calculateVoxelLightCells(
+	VoxelLight* light, VoxelArray* voxelArray, i32 voxelIndex, VoxelLightGroupTransform* transform, u32* cells, u16* cellsSize
+) {
+	*cells = VOXEL_LIGHT_NO_CELLS;
+	*cellsSize = 0;
+	Vector3ui scale = voxelArray->voxelsScale[voxelIndex];
+	if (scale.x == 0) {
+		return;
+	}
+	loadVoxelLightGroupTransform(voxelArray, voxelArray->voxelsGroupIndex[voxelIndex], transform);
+	Vector3i p = voxelArray->voxelsPosition[voxelIndex];
+	f32 (*r)[3] = transform->rotation;
+	Vector3i cellsDims = calculateLightCellsDims(light);
+	i32 dims[3] = { cellsDims.x, cellsDims.y, cellsDims.z };
+	i32 origin[3] = { light->origin.x, light->origin.y, light->origin.z };
+	i32 min[3];
+	i32 max[3];
+	for (i32 k = 0; k < 3; k++) {
+		f32 center = r[k][0] * (f32)p.x + r[k][1] * (f32)p.y + r[k][2] * (f32)p.z + transform->translation.v[k] - (f32)origin[k];
+		f32 extent = 0.5f * (fabsf(r[k][0]) * (f32)scale.x + fabsf(r[k][1]) * (f32)scale.y + fabsf(r[k][2]) * (f32)scale.z) - 0.001f;
+		f32 cellSize = (f32)light->cellSize;
+		i32 middle = (i32)floorf(center / cellSize);
+		min[k] = (i32)ceilf((center - extent) / cellSize - 0.5f);
+		max[k] = (i32)floorf((center + extent) / cellSize - 0.5f);
+		if (min[k] > max[k]) {
+			min[k] = middle;
+			max[k] = middle;
+		}
+		if (max[k] - min[k] + 1 > MAX_VOXEL_LIGHT_VOXEL_CELLS) {
+			min[k] = middle - MAX_VOXEL_LIGHT_VOXEL_CELLS / 2;
+			max[k] = middle + MAX_VOXEL_LIGHT_VOXEL_CELLS / 2 - 1;
+		}
+		min[k] = MAX(min[k], 0);
+		max[k] = MIN(max[k], dims[k] - 1);
+		if (min[k] > max[k]) {
+			return;
+		}
+	}
+	*cells = (u32)min[0] | ((u32)min[1] << 10) | ((u32)min[2] << 20);
+	*cellsSize = (u16)((max[0] - min[0]) | ((max[1] - min[1]) << 4) | ((max[2] - min[2]) << 8));
+}
+
+static void unpackVoxelLightCells(u32 cells, u16 cellsSize, Vector3i* min, Vector3i* max) {
+	*min = Vector3i{ (i32)(cells & 1023), (i32)((cells >> 10) & 1023), (i32)((cells >> 20) & 1023) };
+	*max = Vector3i{ min->x + (cellsSize & 15), min->y + ((cellsSize >> 4) & 15), min->z + ((cellsSize >> 8) & 15) };
+}
+
+//isOpeningCells is off for a relight, which fills every cell afterwards anyway
+static void blockVoxelLightCells(VoxelLight* light, u32 cells, u16 cellsSize, i32 delta, bool32 isOpeningCells) {
+	if (cells == VOXEL_LIGHT_NO_CELLS) {
+		return;
+	}
+	Vector3i min;
+	Vector3i max;
+	unpackVoxelLightCells(cells, cellsSize, &min, &max);
+	for (i32 z = min.z; z <= max.z; z++) {
+		for (i32 y = min.y; y <= max.y; y++) {
+			for (i32 x = min.x; x <= max.x; x++) {
+				Vector3i p = { x, y, z };
+				u32 cell = calculateLightCell(light, p);
+				u16 count = light->solidCounts[cell];
+				_assert(delta > 0 || count > 0);
+				light->solidCounts[cell] = (u16)(count + delta);
+				if (count == 0 || count + delta == 0) {
+					light->isChunkBlockingChanged[cell / VOXEL_LIGHT_CHUNK_CELLS] = 1;
+				}
+				if (!isOpeningCells) {
+					continue;
+				}
+				if (count == 0 && delta > 0) {
+					closeLightCell(light, cell, p);
+				} else if (count + delta == 0) {
+					openLightCell(light, cell, p);
+				}
+			}
+		}
+	}
+}
+
+static void markVoxelLightChunkStale(VoxelLight* light, i32 voxelIndex) {
+	light->isVoxelChunkStale[voxelIndex / VOXELS_PER_CHUNK] = 1;
+}
+
+static void reblockVoxel(VoxelLight* light, VoxelArray* voxelArray, i32 voxelIndex, VoxelLightGroupTransform* transform) {
+	u32 cells;
+	u16 cellsSize;
+	if (voxelIndex < voxelArray->voxelsCount) {
+		calculateVoxelLightCells(light, voxelArray, voxelIndex, transform, &cells, &cellsSize);
+	} else {
+		cells = VOXEL_LIGHT_NO_CELLS;
+		cellsSize = 0;
+	}
+	if (cells == light->voxelCells[voxelIndex] && cellsSize == light->voxelCellsSize[voxelIndex]) {
+		//a voxel added in the place of one that was dropped still has the dropped one's light
+		if (voxelIndex >= light->voxelsCount) {
+			markVoxelLightChunkStale(light, voxelIndex);
+		}
+		return;
+	}
+	//blocking the new cells first keeps the cells both cover from being opened and closed again
+	blockVoxelLightCells(light, cells, cellsSize, 1, 1);
+	blockVoxelLightCells(light, light->voxelCells[voxelIndex], light->voxelCellsSize[voxelIndex], -1, 1);
+	light->voxelCells[voxelIndex] = cells;
+	light->voxelCellsSize[voxelIndex] = cellsSize;
+	markVoxelLightChunkStale(light, voxelIndex);
+}
+
+static i64 countVoxelLightCells(u32 cells, u16 cellsSize) {
+	if (cells == VOXEL_LIGHT_NO_CELLS) {
+		return 0;
+	}
+	return (i64)((cellsSize & 15) + 1) * (((cellsSize >> 4) & 15) + 1) * (((cellsSize >> 8) & 15) + 1);
+}
+
+//the cells the voxel stops blocking, and the ones it starts blocking. none when it blocks the same ones, like when only its color changed
+static i64 countChangedVoxelLightCells(VoxelLight* light, VoxelArray* voxelArray, i32 voxelIndex, VoxelLightGroupTransform* transform) {
+	u32 cells = VOXEL_LIGHT_NO_CELLS;
+	u16 cellsSize = 0;
+	if (voxelIndex < voxelArray->voxelsCount) {
+		calculateVoxelLightCells(light, voxelArray, voxelIndex, transform, &cells, &cellsSize);
+	}
+	if (cells == light->voxelCells[voxelIndex] && cellsSize == light->voxelCellsSize[voxelIndex]) {
+		return 0;
+	}
+	return countVoxelLightCells(cells, cellsSize) + countVoxelLightCells(light->voxelCells[voxelIndex], light->voxelCellsSize[voxelIndex]);
+}
+
+//whether the voxels added, dropped and in the spans change more than maxCells cells. stops counting once they do
+static bool32 isVoxelLightChangeOver(VoxelLight* light, VoxelArray* voxelArray, const VoxelSpan* spans, i32 spansCount, i64 maxCells) {
+	VoxelLightGroupTransform transform;
+	transform.groupIndex = NO_VOXEL_GROUP_TRANSFORM;
+	i32 keptVoxelsCount = MIN(light->voxelsCount, voxelArray->voxelsCount);
+	i32 voxelsEnd = MAX(light->voxelsCount, voxelArray->voxelsCount);
+	i64 cellsCount = 0;
+	for (i32 i = keptVoxelsCount; i < voxelsEnd && cellsCount <= maxCells; i++) {
+		cellsCount += countChangedVoxelLightCells(light, voxelArray, i, &transform);
+	}
+	for (i32 s = 0; s < spansCount && cellsCount <= maxCells; s++) {
+		i32 end = MIN(spans[s].end, keptVoxelsCount);
+		for (i32 i = spans[s].begin; i < end && cellsCount <= maxCells; i++) {
+			cellsCount += countChangedVoxelLightCells(light, voxelArray, i, &transform);
+		}
+	}
+	return cellsCount > maxCells;
+}
+
+//every cell is filled again from scratch, from the sky and the sources
+static void relightVoxelLight(VoxelLight* light, VoxelArray* voxelArray) {
+	i32 cellsCount = light->chunksCount * VOXEL_LIGHT_CHUNK_CELLS;
+	memset(light->solidCounts, 0, cellsCount * sizeof(u16));
+	memset(light->isChunkBlockingChanged, 1, light->chunksCount);
+	VoxelLightGroupTransform transform;
+	transform.groupIndex = NO_VOXEL_GROUP_TRANSFORM;
+	for (i32 i = 0; i < voxelArray->voxelsCount; i++) {
+		calculateVoxelLightCells(light, voxelArray, i, &transform, &light->voxelCells[i], &light->voxelCellsSize[i]);
+		blockVoxelLightCells(light, light->voxelCells[i], light->voxelCellsSize[i], 1, 0);
+	}
+	for (i32 i = voxelArray->voxelsCount; i < light->voxelsCount; i++) {
+		light->voxelCells[i] = VOXEL_LIGHT_NO_CELLS;
+	}
+	light->voxelsCount = voxelArray->voxelsCount;
+
+	memset(light->levels, 0, cellsCount);
+	light->removalNodesCount = 0;
+	light->fillNodesCount = 0;
+	light->isRelightNeeded = 0;
+	light->isRelighting = 1;
+	Vector3i dims = calculateLightCellsDims(light);
+	for (i32 z = 0; z < dims.z; z++) {
+		for (i32 x = 0; x < dims.x; x++) {
+			queueLightNode(light, 0, calculateLightCell(light, Vector3i{ x, dims.y - 1, z }), 0, VOXEL_LIGHT_NODE_ANCHORED | VOXEL_LIGHT_NODE_SKY);
+		}
+	}
+	for (i32 cell = 0; cell < cellsCount; cell++) {
+		if (light->sources[cell] > 0) {
+			queueLightNode(light, 0, (u32)cell, 0, VOXEL_LIGHT_NODE_ANCHORED);
+		}
+	}
+	//what didn't fit is left dark, instead of relighting again every update
+	if (light->isRelightNeeded) {
+		printf("the light's queues can't hold the volume's sources\n");
+		light->isRelightNeeded = 0;
+	}
+	light->changedCellsMin = Vector3i{ 0, 0, 0 };
+	light->changedCellsMax = Vector3i{ dims.x - 1, dims.y - 1, dims.z - 1 };
+}
+
+//fills that offer a cell the light of the cell next to it may have come from light that's about to be removed. the cells around them
+//spread their light again instead, once the removals are done
+static void reseedStaleLightFills(VoxelLight* light) {
+	i32 count = (i32)light->fillNodesCount;
+	bool32 isStale = 0;
+	for (i32 i = 0; i < count && !isStale; i++) {
+		isStale = (light->fillNodes[i].flags & (VOXEL_LIGHT_NODE_SEED | VOXEL_LIGHT_NODE_ANCHORED)) == 0;
+	}
+	if (!isStale) {
+		return;
+	}
+	memcpy(light->roundNodes, light->fillNodes, count * sizeof(VoxelLightNode));
+	light->fillNodesCount = 0;
+	for (i32 i = 0; i < count; i++) {
+		VoxelLightNode node = light->roundNodes[i];
+		if (node.flags & (VOXEL_LIGHT_NODE_SEED | VOXEL_LIGHT_NODE_ANCHORED)) {
+			queueLightNode(light, 0, node.cell, node.level, node.flags);
+		} else {
+			Vector3i p = calculateLightCellPosition(light, node.cell);
+			queueLightNeighbors(light, p, 0, 0, VOXEL_LIGHT_NODE_SEED | (node.flags & VOXEL_LIGHT_NODE_SKY));
+		}
+	}
+}
+
+void initVoxelLight(
+	VoxelLight* light, MemoryAllocator* memoryAllocator, VoxelArray* voxelArray, Vector3i origin, i32 cellSize, Vector3i chunksDims, i32 nodesCapacity
+) {
+	_assert(cellSize > 0);
+	_assert(chunksDims.x * VOXEL_LIGHT_CHUNK_SIZE <= MAX_VOXEL_LIGHT_CELLS_PER_AXIS);
+	_assert(chunksDims.y * VOXEL_LIGHT_CHUNK_SIZE <= MAX_VOXEL_LIGHT_CELLS_PER_AXIS);
+	_assert(chunksDims.z * VOXEL_LIGHT_CHUNK_SIZE <= MAX_VOXEL_LIGHT_CELLS_PER_AXIS);
+	light->origin = origin;
+	light->cellSize = cellSize;
+	light->chunksDims = chunksDims;
+	light->chunksCount = chunksDims.x * chunksDims.y * chunksDims.z;
+	i32 cellsCount = light->chunksCount * VOXEL_LIGHT_CHUNK_CELLS;
+	light->levels = (u8*) allocateMemory(memoryAllocator, cellsCount);
+	light->solidCounts = (u16*) allocateMemory(memoryAllocator, cellsCount * sizeof(u16));
+	light->sources = (u8*) allocateMemory(memoryAllocator, cellsCount);
+	memset(light->levels, 0, cellsCount);
+	memset(light->solidCounts, 0, cellsCount * sizeof(u16));
+	memset(light->sources, 0, cellsCount);
+	light->isChunkBlockingChanged = (u8*) allocateMemory(memoryAllocator, light->chunksCount);
+	memset(light->isChunkBlockingChanged, 0, light->chunksCount);
+
+	light->voxelsCapacity = voxelArray->voxelsCapacity;
+	light->voxelLevels = (u8*) allocateMemory(memoryAllocator, light->voxelsCapacity);
+	light->voxelCells = (u32*) allocateMemory(memoryAllocator, light->voxelsCapacity * sizeof(u32));
+	light->voxelCellsSize = (u16*) allocateMemory(memoryAllocator, light->voxelsCapacity * sizeof(u16));
+	memset(light->voxelLevels, VOXEL_LIGHT_OPEN_SKY, light->voxelsCapacity);
+	memset(light->voxelCells, 0xff, light->voxelsCapacity * sizeof(u32));
+	light->voxelsCount = 0;
+
+	light->nodesCapacity = nodesCapacity;
+	light->removalNodes = (VoxelLightNode*) allocateMemory(memoryAllocator, nodesCapacity * sizeof(VoxelLightNode));
+	light->fillNodes = (VoxelLightNode*) allocateMemory(memoryAllocator, nodesCapacity * sizeof(VoxelLightNode));
+	light->roundNodes = (VoxelLightNode*) allocateMemory(memoryAllocator, nodesCapacity * sizeof(VoxelLightNode));
+	light->removalNodesCount = 0;
+	light->fillNodesCount = 0;
+	light->chunkNodesOffsets = (u32*) allocateMemory(memoryAllocator, (light->chunksCount + 1) * sizeof(u32));
+	light->jobs = (VoxelLightJob*) allocateMemory(memoryAllocator, MAX_VOXEL_LIGHT_JOBS * sizeof(VoxelLightJob));
+	//nothing is lit until the first update
+	light->isRelightNeeded = 1;
+	light->isRelighting = 0;
+	clearCellBounds(&light->changedCellsMin, &light->changedCellsMax);
+
+	light->voxelChunksCapacity = voxelArray->chunksCapacity;
+	light->voxelChunkCellsMin = (Vector3i*) allocateMemory(memoryAllocator, light->voxelChunksCapacity * sizeof(Vector3i));
+	light->voxelChunkCellsMax = (Vector3i*) allocateMemory(memoryAllocator, light->voxelChunksCapacity * sizeof(Vector3i));
+	light->isVoxelChunkStale = (u8*) allocateMemory(memoryAllocator, light->voxelChunksCapacity);
+	for (i32 c = 0; c < light->voxelChunksCapacity; c++) {
+		clearCellBounds(&light->voxelChunkCellsMin[c], &light->voxelChunkCellsMax[c]);
+	}
+	memset(light->isVoxelChunkStale, 0, light->voxelChunksCapacity);
+	light->changedChunksBegin = light->voxelChunksCapacity;
+	light->changedChunksEnd = 0;
+}
+
+bool32 setVoxelLightSource(VoxelLight* light, Vector3i position, u32 level) {
+	Vector3i p;
+	if (!isLightPositionInVolume(light, position, &p)) {
+		return 0;
+	}
+	level = MIN(level, MAX_VOXEL_LIGHT_LEVEL);
+	u32 cell = calculateLightCell(light, p);
+	u32 previousLevel = light->sources[cell];
+	light->sources[cell] = (u8)level;
+	//a dimmer source takes out the light of the brighter one, and what's around fills back in
+	if (level < previousLevel) {
+		darkenLightCell(light, cell, p, 0);
+	}
+	if (level > 0) {
+		queueLightNode(light, 0, cell, 0, VOXEL_LIGHT_NODE_ANCHORED);
+	}
+	return 1;
+}
+
+u8 getVoxelLightAt(VoxelLight* light, Vector3i position) {
+	Vector3i p;
+	if (!isLightPositionInVolume(light, position, &p)) {
+		return VOXEL_LIGHT_OPEN_SKY;
+	}
+	return light->levels[calculateLightCell(light, p)];
+}
+
+bool32 isVoxelLightPending(VoxelLight* light) {
+	return light->removalNodesCount > 0 || light->fillNodesCount > 0 || light->isRelightNeeded;
+}
+
+static void flushLightOutbox(VoxelLight* light, VoxelLightOutbox* outbox, bool32 isRemoval) {
+	if (outbox->count == 0) {
+		return;
+	}
+	volatile u64* count = isRemoval ? &light->removalNodesCount : &light->fillNodesCount;
+	u64 end = atomicAddU64(count, (u64)outbox->count);
+	u64 begin = end - (u64)outbox->count;
+	if (end > (u64)light->nodesCapacity) {
+		atomicStoreU32(&light->isRelightNeeded, 1);
+		end = MAX(begin, (u64)light->nodesCapacity);
+	}
+	VoxelLightNode* nodes = isRemoval ? light->removalNodes : light->fillNodes;
+	memcpy(&nodes[begin], outbox->nodes, (end - begin) * sizeof(VoxelLightNode));
+	outbox->count = 0;
+}
+
+static void postLightNode(VoxelLightJob* job, bool32 isRemoval, u32 cell, u32 level, u8 flags) {
+	VoxelLightOutbox* outbox = isRemoval ? &job->removals : &job->fills;
+	if (outbox->count == VOXEL_LIGHT_OUTBOX_CAPACITY) {
+		flushLightOutbox(job->light, outbox, isRemoval);
+	}
+	outbox->nodes[outbox->count] = VoxelLightNode{ cell, (u8)level, flags };
+	outbox->count += 1;
+}
+
+static Vector3i calculateLocalCellPosition(u32 local) {
+	i32 s = VOXEL_LIGHT_CHUNK_SIZE;
+	return Vector3i{ (i32)local % s, ((i32)local / s) % s, (i32)local / (s * s) };
+}
+
+static void markJobCellChanged(VoxelLightJob* job, u32 local) {
+	Vector3i l = calculateLocalCellPosition(local);
+	Vector3i p = { job->chunkCellsMin.x + l.x, job->chunkCellsMin.y + l.y, job->chunkCellsMin.z + l.z };
+	addCellToBounds(p, &job->changedCellsMin, &job->changedCellsMax);
+}
+
+//returns 0 if the neighbor is in another chunk, and writes its cell in the volume to cell, or -1 if it's outside of the volume
+static bool32 findLocalLightNeighbor(VoxelLightJob* job, Vector3i l, i32 d, u32* local, i64* cell) {
+	Vector3i n = addLightDirection(l, d);
+	i32 s = VOXEL_LIGHT_CHUNK_SIZE;
+	if (n.x >= 0 && n.y >= 0 && n.z >= 0 && n.x < s && n.y < s && n.z < s) {
+		*local = (u32)((n.z * s + n.y) * s + n.x);
+		return 1;
+	}
+	Vector3i p = { job->chunkCellsMin.x + n.x, job->chunkCellsMin.y + n.y, job->chunkCellsMin.z + n.z };
+	*cell = isLightCellInside(job->light, p) ? (i64)calculateLightCell(job->light, p) : -1;
+	return 0;
+}
+
+//cells the ring has no room for are spread by the next round. a fill is seeded again, and a removal passes its level on to its
+//neighbors, which is what it would've done
+static void pushLightRing(VoxelLightJob* job, u32 local, u32 isSky, u32 level) {
+	if (job->ringTail - job->ringHead < VOXEL_LIGHT_RING_CAPACITY) {
+		job->ring[job->ringTail & (VOXEL_LIGHT_RING_CAPACITY - 1)] = local | (isSky << 12) | (level << 13);
+		job->ringTail += 1;
+		return;
+	}
+	if (!job->isRemoving) {
+		postLightNode(job, 0, job->base + local, 0, VOXEL_LIGHT_NODE_SEED | (isSky ? VOXEL_LIGHT_NODE_SKY : 0));
+		return;
+	}
+	Vector3i l = calculateLocalCellPosition(local);
+	for (i32 d = 0; d < 6; d++) {
+		u32 neighborLocal;
+		i64 neighbor;
+		if (findLocalLightNeighbor(job, l, d, &neighborLocal, &neighbor)) {
+			neighbor = job->base + neighborLocal;
+		}
+		if (neighbor >= 0) {
+			postLightNode(job, 1, (u32)neighbor, level, (isSky ? VOXEL_LIGHT_NODE_SKY : 0) | (d == VOXEL_LIGHT_DOWN ? VOXEL_LIGHT_NODE_DOWN : 0));
+		}
+	}
+}
+
+static void fillLightCell(VoxelLightJob* job, u32 local, u32 isSky, u32 level) {
+	VoxelLight* light = job->light;
+	u32 cell = job->base + local;
+	if (light->solidCounts[cell] > 0 || getCellLight(light->levels[cell], isSky) >= level) {
+		return;
+	}
+	light->levels[cell] = setCellLight(light->levels[cell], isSky, level);
+	markJobCellChanged(job, local);
+	pushLightRing(job, local, isSky, 0);
+}
+
+//the light only drops going into the cells around, except for sky light at 15 going down
+static void spreadLightRing(VoxelLightJob* job) {
+	VoxelLight* light = job->light;
+	while (job->ringHead != job->ringTail) {
+		u32 entry = job->ring[job->ringHead & (VOXEL_LIGHT_RING_CAPACITY - 1)];
+		job->ringHead += 1;
+		job->processedNodesCount += 1;
+		u32 local = entry & (VOXEL_LIGHT_CHUNK_CELLS - 1);
+		u32 isSky = (entry >> 12) & 1;
+		u32 level = getCellLight(light->levels[job->base + local], isSky);
+		if (level == 0) {
+			continue;
+		}
+		Vector3i l = calculateLocalCellPosition(local);
+		for (i32 d = 0; d < 6; d++) {
+			u32 neighborLevel = isSky && d == VOXEL_LIGHT_DOWN && level == MAX_VOXEL_LIGHT_LEVEL ? level : level - 1;
+			if (neighborLevel == 0) {
+				continue;
+			}
+			u32 neighborLocal;
+			i64 neighbor;
+			if (findLocalLightNeighbor(job, l, d, &neighborLocal, &neighbor)) {
+				fillLightCell(job, neighborLocal, isSky, neighborLevel);
+			} else if (neighbor >= 0) {
+				postLightNode(job, 0, (u32)neighbor, neighborLevel, (isSky ? VOXEL_LIGHT_NODE_SKY : 0) | (d == VOXEL_LIGHT_DOWN ? VOXEL_LIGHT_NODE_DOWN : 0));
+			}
+		}
+	}
+}
+
+//a cell with less light than its removed neighbor had, or sky light at 15 right below it, got it from there, and is taken out too.
+//a cell with as much or more got it from somewhere else, and fills the removed cells back in once the removals are done
+static void removeLightCell(VoxelLightJob* job, u32 local, u32 isSky, u32 removedLevel, bool32 isDown) {
+	VoxelLight* light = job->light;
+	u32 cell = job->base + local;
+	u32 level = getCellLight(light->levels[cell], isSky);
+	if (level == 0) {
+		return;
+	}
+	if (level < removedLevel || (isSky && isDown && level == MAX_VOXEL_LIGHT_LEVEL && removedLevel == MAX_VOXEL_LIGHT_LEVEL)) {
+		light->levels[cell] = setCellLight(light->levels[cell], isSky, 0);
+		markJobCellChanged(job, local);
+		if (!isSky && light->sources[cell] > 0) {
+			postLightNode(job, 0, cell, 0, VOXEL_LIGHT_NODE_ANCHORED);
+		}
+		pushLightRing(job, local, isSky, level);
+	} else {
+		postLightNode(job, 0, cell, 0, VOXEL_LIGHT_NODE_SEED | (isSky ? VOXEL_LIGHT_NODE_SKY : 0));
+	}
+}
+
+static void spreadLightRemovalRing(VoxelLightJob* job) {
+	while (job->ringHead != job->ringTail) {
+		u32 entry = job->ring[job->ringHead & (VOXEL_LIGHT_RING_CAPACITY - 1)];
+		job->ringHead += 1;
+		job->processedNodesCount += 1;
+		u32 local = entry & (VOXEL_LIGHT_CHUNK_CELLS - 1);
+		u32 isSky = (entry >> 12) & 1;
+		u32 removedLevel = entry >> 13;
+		Vector3i l = calculateLocalCellPosition(local);
+		for (i32 d = 0; d < 6; d++) {
+			u32 neighborLocal;
+			i64 neighbor;
+			if (findLocalLightNeighbor(job, l, d, &neighborLocal, &neighbor)) {
+				removeLightCell(job, neighborLocal, isSky, removedLevel, d == VOXEL_LIGHT_DOWN);
+			} else if (neighbor >= 0) {
+				postLightNode(job, 1, (u32)neighbor, removedLevel, (isSky ? VOXEL_LIGHT_NODE_SKY : 0) | (d == VOXEL_LIGHT_DOWN ? VOXEL_LIGHT_NODE_DOWN : 0));
+			}
+		}
+	}
+}
+
+static void spreadLightInChunk(VoxelLightJob* job, const VoxelLightNode* nodes, i32 nodesCount) {
+	VoxelLight* light = job->light;
+	for (i32 i = 0; i < nodesCount; i++) {
+		VoxelLightNode node = nodes[i];
+		u32 local = node.cell - job->base;
+		u32 isSky = node.flags & VOXEL_LIGHT_NODE_SKY;
+		job->processedNodesCount += 1;
+		if (job->isRemoving) {
+			removeLightCell(job, local, isSky, node.level, (node.flags & VOXEL_LIGHT_NODE_DOWN) != 0);
+		} else if (node.flags & VOXEL_LIGHT_NODE_SEED) {
+			if (getCellLight(light->levels[node.cell], isSky) > 0) {
+				pushLightRing(job, local, isSky, 0);
+			}
+		} else if (node.flags & VOXEL_LIGHT_NODE_ANCHORED) {
+			fillLightCell(job, local, isSky, isSky ? MAX_VOXEL_LIGHT_LEVEL : light->sources[node.cell]);
+		} else {
+			fillLightCell(job, local, isSky, node.level);
+		}
+		//the queued cells are spread together, unless there are enough of them to fill the ring
+		if (job->ringTail - job->ringHead >= VOXEL_LIGHT_RING_CAPACITY / 2) {
+			job->isRemoving ? spreadLightRemovalRing(job) : spreadLightRing(job);
+		}
+	}
+	job->isRemoving ? spreadLightRemovalRing(job) : spreadLightRing(job);
+}
+
+static void spreadLightJobChunks(void* data) {
+	VoxelLightJob* job = (VoxelLightJob*)data;
+	VoxelLight* light = job->light;
+	for (i32 c = job->chunksBegin; c < job->chunksEnd; c++) {
+		u32 begin = light->chunkNodesOffsets[c];
+		u32 end = light->chunkNodesOffsets[c + 1];
+		if (begin == end) {
+			continue;
+		}
+		job->base = (u32)c * VOXEL_LIGHT_CHUNK_CELLS;
+		Vector3i p = calculateLightCellPosition(light, job->base);
+		job->chunkCellsMin = p;
+		job->ringHead = 0;
+		job->ringTail = 0;
+		spreadLightInChunk(job, &light->roundNodes[begin], (i32)(end - begin));
+	}
+	flushLightOutbox(light, &job->removals, 1);
+	flushLightOutbox(light, &job->fills, 0);
+}
+
+//runs rounds until nothing is queued, or the budget ran out
+static void spreadVoxelLight(VoxelLight* light, JobQueue* jobQueue, i32 maxNodes) {
+	i64 processedNodesCount = 0;
+	while (!light->isRelightNeeded && (maxNodes <= 0 || processedNodesCount < maxNodes)) {
+		bool32 isRemoving = light->removalNodesCount > 0;
+		i32 count = (i32)(isRemoving ? light->removalNodesCount : light->fillNodesCount);
+		if (count == 0) {
+			break;
+		}
+		VoxelLightNode* nodes = isRemoving ? light->removalNodes : light->fillNodes;
+
+		//counting sort by chunk. each chunk's offset ends up where the next one's starts, so they're moved up by one after
+		u32* offsets = light->chunkNodesOffsets;
+		memset(offsets, 0, (light->chunksCount + 1) * sizeof(u32));
+		for (i32 i = 0; i < count; i++) {
+			offsets[nodes[i].cell / VOXEL_LIGHT_CHUNK_CELLS + 1] += 1;
+		}
+		for (i32 c = 0; c < light->chunksCount; c++) {
+			offsets[c + 1] += offsets[c];
+		}
+		for (i32 i = 0; i < count; i++) {
+			light->roundNodes[offsets[nodes[i].cell / VOXEL_LIGHT_CHUNK_CELLS]++] = nodes[i];
+		}
+		for (i32 c = light->chunksCount; c > 0; c--) {
+			offsets[c] = offsets[c - 1];
+		}
+		offsets[0] = 0;
+		if (isRemoving) {
+			light->removalNodesCount = 0;
+		} else {
+			light->fillNodesCount = 0;
+		}
+
+		//split so every job has about the same amount of nodes
+		i32 jobsCount = MAX(1, MIN(MAX_VOXEL_LIGHT_JOBS, count / MIN_VOXEL_LIGHT_JOB_NODES));
+		i32 nodesPerJob = (count + jobsCount - 1) / jobsCount;
+		i32 chunksBegin = 0;
+		i32 addedJobsCount = 0;
+		for (i32 c = 0; c < light->chunksCount; c++) {
+			bool32 isLast = c + 1 == light->chunksCount;
+			if (!isLast && offsets[c + 1] - offsets[chunksBegin] < (u32)nodesPerJob) {
+				continue;
+			}
+			VoxelLightJob* job = &light->jobs[addedJobsCount];
+			job->light = light;
+			job->isRemoving = isRemoving;
+			job->chunksBegin = chunksBegin;
+			job->chunksEnd = c + 1;
+			job->processedNodesCount = 0;
+			job->removals.count = 0;
+			job->fills.count = 0;
+			clearCellBounds(&job->changedCellsMin, &job->changedCellsMax);
+			addedJobsCount += 1;
+			chunksBegin = c + 1;
+			if (addedJobsCount == MAX_VOXEL_LIGHT_JOBS) {
+				job->chunksEnd = light->chunksCount;
+				break;
+			}
+		}
+		for (i32 j = 0; j < addedJobsCount; j++) {
+			addJob(jobQueue, spreadLightJobChunks, &light->jobs[j]);
+		}
+		waitForAllJobs(jobQueue);
+
+		for (i32 j = 0; j < addedJobsCount; j++) {
+			VoxelLightJob* job = &light->jobs[j];
+			processedNodesCount += job->processedNodesCount;
+			if (job->changedCellsMin.x <= job->changedCellsMax.x) {
+				addCellToBounds(job->changedCellsMin, &light->changedCellsMin, &light->changedCellsMax);
+				addCellToBounds(job->changedCellsMax, &light->changedCellsMin, &light->changedCellsMax);
+			}
+		}
+		light->removalNodesCount = MIN(light->removalNodesCount, (u64)light->nodesCapacity);
+		light->fillNodesCount = MIN(light->fillNodesCount, (u64)light->nodesCapacity);
+	}
+}
+
+struct VoxelLightVoxelsJob {
+	VoxelLight* light;
+	i32 voxelsCount;
+	i32 chunksBegin;
+	i32 chunksEnd;
+};
+
+//the brightest of the voxel's cells and the cells around them. its own cells are blocked, so they have none
+static void recomputeVoxelLightChunks(void* data) {
+	VoxelLightVoxelsJob* job = (VoxelLightVoxelsJob*)data;
+	VoxelLight* light = job->light;
+	Vector3i dims = calculateLightCellsDims(light);
+	for (i32 c = job->chunksBegin; c < job->chunksEnd; c++) {
+		if (!light->isVoxelChunkStale[c]) {
+			continue;
+		}
+		Vector3i chunkMin;
+		Vector3i chunkMax;
+		clearCellBounds(&chunkMin, &chunkMax);
+		i32 end = MIN((c + 1) * VOXELS_PER_CHUNK, job->voxelsCount);
+		for (i32 i = c * VOXELS_PER_CHUNK; i < end; i++) {
+			if (light->voxelCells[i] == VOXEL_LIGHT_NO_CELLS) {
+				light->voxelLevels[i] = VOXEL_LIGHT_OPEN_SKY;
+				continue;
+			}
+			Vector3i min;
+			Vector3i max;
+			unpackVoxelLightCells(light->voxelCells[i], light->voxelCellsSize[i], &min, &max);
+			min = Vector3i{ MAX(min.x - 1, 0), MAX(min.y - 1, 0), MAX(min.z - 1, 0) };
+			max = Vector3i{ MIN(max.x + 1, dims.x - 1), MIN(max.y + 1, dims.y - 1), MIN(max.z + 1, dims.z - 1) };
+			u32 block = 0;
+			u32 sky = 0;
+			for (i32 z = min.z; z <= max.z; z++) {
+				for (i32 y = min.y; y <= max.y; y++) {
+					for (i32 x = min.x; x <= max.x; x++) {
+						u8 levels = light->levels[calculateLightCell(light, Vector3i{ x, y, z })];
+						block = MAX(block, getVoxelBlockLight(levels));
+						sky = MAX(sky, getVoxelSkyLight(levels));
+					}
+				}
+			}
+			light->voxelLevels[i] = (u8)(block | (sky << VOXEL_SKY_LIGHT_SHIFT));
+			addCellToBounds(min, &chunkMin, &chunkMax);
+			addCellToBounds(max, &chunkMin, &chunkMax);
+		}
+		light->voxelChunkCellsMin[c] = chunkMin;
+		light->voxelChunkCellsMax[c] = chunkMax;
+	}
+}
+
+static bool32 isCellBoundsOverlapping(Vector3i aMin, Vector3i aMax, Vector3i bMin, Vector3i bMax) {
+	return
+		aMin.x <= bMax.x && aMax.x >= bMin.x && aMin.y <= bMax.y && aMax.y >= bMin.y &&
+		aMin.z <= bMax.z && aMax.z >= bMin.z;
+}
+
+static void recomputeVoxelLightLevels(VoxelLight* light, VoxelArray* voxelArray, JobQueue* jobQueue) {
+	i32 chunksCount = (voxelArray->voxelsCount + VOXELS_PER_CHUNK - 1) / VOXELS_PER_CHUNK;
+	if (light->changedCellsMin.x <= light->changedCellsMax.x) {
+		for (i32 c = 0; c < chunksCount; c++) {
+			if (isCellBoundsOverlapping(light->voxelChunkCellsMin[c], light->voxelChunkCellsMax[c], light->changedCellsMin, light->changedCellsMax)) {
+				light->isVoxelChunkStale[c] = 1;
+			}
+		}
+		clearCellBounds(&light->changedCellsMin, &light->changedCellsMax);
+	}
+
+	i32 staleChunksCount = 0;
+	for (i32 c = 0; c < chunksCount; c++) {
+		staleChunksCount += light->isVoxelChunkStale[c];
+	}
+	if (staleChunksCount > 0) {
+		//split so every job has about the same amount of stale chunks
+		VoxelLightVoxelsJob jobs[MAX_VOXEL_LIGHT_JOBS];
+		i32 jobsCount = 0;
+		i32 staleChunksPerJob = staleChunksCount / MAX_VOXEL_LIGHT_JOBS + 1;
+		i32 jobStaleChunksCount = 0;
+		i32 chunksBegin = 0;
+		for (i32 c = 0; c < chunksCount; c++) {
+			jobStaleChunksCount += light->isVoxelChunkStale[c];
+			if (jobStaleChunksCount < staleChunksPerJob && c + 1 < chunksCount) {
+				continue;
+			}
+			VoxelLightVoxelsJob* job = &jobs[jobsCount];
+			job->light = light;
+			job->voxelsCount = voxelArray->voxelsCount;
+			job->chunksBegin = chunksBegin;
+			job->chunksEnd = c + 1;
+			jobsCount += 1;
+			chunksBegin = c + 1;
+			jobStaleChunksCount = 0;
+		}
+		for (i32 i = 0; i < jobsCount; i++) {
+			addJob(jobQueue, recomputeVoxelLightChunks, &jobs[i]);
+		}
+		waitForAllJobs(jobQueue);
+	}
+
+	//chunks past the voxels count only had voxels taken out, and are recomputed when voxels are added to them again
+	for (i32 c = 0; c < light->voxelChunksCapacity; c++) {
+		if (!light->isVoxelChunkStale[c]) {
+			continue;
+		}
+		light->isVoxelChunkStale[c] = 0;
+		if (c < chunksCount) {
+			light->changedChunksBegin = MIN(light->changedChunksBegin, c);
+			light->changedChunksEnd = MAX(light->changedChunksEnd, c + 1);
+		}
+	}
+}
+
+void updateVoxelLight(VoxelLight* light, VoxelArray* voxelArray, JobQueue* jobQueue, const VoxelSpan* spans, i32 spansCount, i32 maxNodes) {
+	_assert(light->voxelsCapacity == voxelArray->voxelsCapacity);
+	i32 keptVoxelsCount = MIN(light->voxelsCount, voxelArray->voxelsCount);
+	//moved groups and other edits go through the removals and fills, bounded by the cells they change. when that's more than the
+	//queues hold, or than an eighth of the volume, like when a world was loaded, filling every cell from scratch is cheaper
+	i64 maxChangedCells = MIN((i64)light->nodesCapacity / VOXEL_LIGHT_NODES_PER_CHANGED_CELL, (i64)light->chunksCount * VOXEL_LIGHT_CHUNK_CELLS / 8);
+	if (light->isRelightNeeded || isVoxelLightChangeOver(light, voxelArray, spans, spansCount, maxChangedCells)) {
+		i32 chunksCount = (MAX(light->voxelsCount, voxelArray->voxelsCount) + VOXELS_PER_CHUNK - 1) / VOXELS_PER_CHUNK;
+		memset(light->isVoxelChunkStale, 1, chunksCount);
+		relightVoxelLight(light, voxelArray);
+	} else {
+		VoxelLightGroupTransform transform;
+		transform.groupIndex = NO_VOXEL_GROUP_TRANSFORM;
+		for (i32 i = voxelArray->voxelsCount; i < light->voxelsCount; i++) {
+			reblockVoxel(light, voxelArray, i, &transform);
+		}
+		//voxels added since the last update are usually in the spans too, but aren't left out when they aren't
+		for (i32 i = light->voxelsCount; i < voxelArray->voxelsCount; i++) {
+			reblockVoxel(light, voxelArray, i, &transform);
+		}
+		for (i32 s = 0; s < spansCount; s++) {
+			i32 end = MIN(spans[s].end, keptVoxelsCount);
+			for (i32 i = spans[s].begin; i < end; i++) {
+				reblockVoxel(light, voxelArray, i, &transform);
+			}
+		}
+		light->voxelsCount = voxelArray->voxelsCount;
+	}
+
+	if (light->removalNodesCount > 0) {
+		reseedStaleLightFills(light);
+	}
+	spreadVoxelLight(light, jobQueue, maxNodes);
+	//the voxels keep the light they had until a relight is all spread, instead of going dark while it fills the cells back in
+	if (light->isRelighting && !isVoxelLightPending(light)) {
+		light->isRelighting = 0;
+	}
+	if (!light->isRelighting) {
+		recomputeVoxelLightLevels(light, voxelArray, jobQueue);
+	}
+}
+
+bool32 collectVoxelLightChanges(VoxelLight* light, VoxelSpan* span) {
+	if (light->changedChunksBegin >= light->changedChunksEnd) {
+		return 0;
+	}
+	span->begin = light->changedChunksBegin * VOXELS_PER_CHUNK;
+	span->end = light->changedChunksEnd * VOXELS_PER_CHUNK;
+	light->changedChunksBegin = light->voxelChunksCapacity;
+	light->changedChunksEnd = 0;
+	return 1;
+}
@@ -0,0 +1,123 @@
+#pragma once
+#ifndef VOXELS_GAME_VOXEL_LIGHT_H
+#define VOXELS_GAME_VOXEL_LIGHT_H
+
+#include "common.h"
+#include "memory.h"
+#include "voxel.h"
+#include "jobs.h"
+
+/*
+	block light and sky light, flood filled through a volume of cells laid over the world. voxels don't sit on a grid of their own,
+	so the cells are what the light moves through, and each voxel blocks the cells whose centers are inside its world bounds, or the
+	cell its center is in when it's smaller than a cell.
+	a cell's light is a byte, with the block light in the low nibble and the sky light in the high one. the cells are stored in chunks
+	of 16x16x16, one chunk after the other.
+	block light comes from sources placed in cells, and drops by one with every cell it moves. sky light comes in from the top of the
+	volume at 15, and stays 15 going straight down until something blocks it.
+	edits are flood filled from the cells they changed, with the removals spreading first and taking out the light that came from what
+	was removed, and the light around them filling back in after. each round, the queued cells are sorted by chunk, and the chunks are
+	spread over the job queue. a job only touches the cells of its own chunks, and queues whatever crosses into another chunk for the
+	next round.
+	an update stops after the round that goes over its budget of cells, and the next one picks up where it left off.
+	when the edits would change more cells than the queues hold, every cell is filled again from scratch instead.
+	a voxel's light is the brightest of the cells around it, recomputed for the chunks of voxels near the cells that changed. while
+	the cells are filled from scratch, the voxels keep the light they had, and are only recomputed once it's all spread
+*/
+
+const i32 VOXEL_LIGHT_CHUNK_SIZE = 16;
+const i32 VOXEL_LIGHT_CHUNK_CELLS = VOXEL_LIGHT_CHUNK_SIZE * VOXEL_LIGHT_CHUNK_SIZE * VOXEL_LIGHT_CHUNK_SIZE;
+const u32 MAX_VOXEL_LIGHT_LEVEL = 15;
+const u8 VOXEL_BLOCK_LIGHT_MASK = 0x0f;
+const u32 VOXEL_SKY_LIGHT_SHIFT = 4;
+//the light of voxels that are outside of the volume
+const u8 VOXEL_LIGHT_OPEN_SKY = 0xf0;
+//a voxel's light goes in the top byte of its occlusion on the gpu
+const u32 VOXEL_LIGHT_OCCLUSION_SHIFT = 56;
+//the volume is at most this many cells along each axis, and a voxel blocks at most this many cells along each axis around its center
+const i32 MAX_VOXEL_LIGHT_CELLS_PER_AXIS = 1024;
+const i32 MAX_VOXEL_LIGHT_VOXEL_CELLS = 16;
+
+//a cell queued for the next round. flags are the VOXEL_LIGHT_NODE_ bits in voxel_light.cpp
+struct VoxelLightNode {
+	u32 cell;
+	u8 level;
+	u8 flags;
+};
+
+struct VoxelLightJob;
+
+struct VoxelLight {
+	//in voxel units. the min corner of the volume's first cell
+	Vector3i origin;
+	i32 cellSize;
+	Vector3i chunksDims;
+	i32 chunksCount;
+
+	u8* levels;
+	//how many voxels block each cell
+	u16* solidCounts;
+	//the block light level of the source in each cell, 0 if there's none
+	u8* sources;
+	//the chunks with cells that started or stopped being blocked. updateVoxelShadow clears them once it rebuilt their occupancy
+	u8* isChunkBlockingChanged;
+
+	i32 voxelsCapacity;
+	//the brightest block and sky light around each voxel
+	u8* voxelLevels;
+	//the first cell each voxel blocks, its x, y and z 10 bits each, or VOXEL_LIGHT_NO_CELLS. the amount along each axis, less one,
+	//is 4 bits each of voxelCellsSize
+	u32* voxelCells;
+	u16* voxelCellsSize;
+	//the voxels count of the last update. voxels dropped since then stop blocking cells on the next one
+	i32 voxelsCount;
+
+	//the queued removals and fills. removals are all done before any fill starts
+	i32 nodesCapacity;
+	VoxelLightNode* removalNodes;
+	VoxelLightNode* fillNodes;
+	volatile u64 removalNodesCount;
+	volatile u64 fillNodesCount;
+	//the nodes of the round, sorted by chunk, and where each chunk's start
+	VoxelLightNode* roundNodes;
+	u32* chunkNodesOffsets;
+	VoxelLightJob* jobs;
+	//set when a queue was full, and before the first update. every cell is filled from scratch on the next update
+	volatile u32 isRelightNeeded;
+	//set from when the cells are filled from scratch until nothing is queued anymore. the voxels' light isn't recomputed until then
+	bool32 isRelighting;
+
+	//the cells whose light changed since the voxels' light was last recomputed. min > max when none did
+	Vector3i changedCellsMin;
+	Vector3i changedCellsMax;
+	//the cells around the voxels of each voxel chunk, when they were last recomputed
+	i32 voxelChunksCapacity;
+	Vector3i* voxelChunkCellsMin;
+	Vector3i* voxelChunkCellsMax;
+	u8* isVoxelChunkStale;
+	//the voxel chunks recomputed since the last collectVoxelLightChanges. [begin, end)
+	i32 changedChunksBegin;
+	i32 changedChunksEnd;
+};
+
+//chunksDims is the amount of chunks along each axis. nodesCapacity bounds how many cells each queue holds
+void initVoxelLight(
+	VoxelLight* light, MemoryAllocator* memoryAllocator, VoxelArray* voxelArray, Vector3i origin, i32 cellSize, Vector3i chunksDims, i32 nodesCapacity
+);
+//places a source of block light in the cell at position, in voxel units. a level of 0 takes the source out. returns 0 if the position
+//is outside of the volume. the light spreads on the next update
+bool32 setVoxelLightSource(VoxelLight* light, Vector3i position, u32 level);
+//call with the spans collectDirtyVoxelSpans wrote. spreads the light until nothing is queued, or it went over maxNodes cells.
+//maxNodes <= 0 has no budget
+void updateVoxelLight(VoxelLight* light, VoxelArray* voxelArray, JobQueue* jobQueue, const VoxelSpan* spans, i32 spansCount, i32 maxNodes);
+//whether some of the light is still waiting to be spread by the next update
+bool32 isVoxelLightPending(VoxelLight* light);
+//writes the voxels whose light was recomputed since the last call, and forgets them. returns 0 if none were
+bool32 collectVoxelLightChanges(VoxelLight* light, VoxelSpan* span);
+
+//the light of the cell at position, in voxel units. VOXEL_LIGHT_OPEN_SKY outside of the volume
+u8 getVoxelLightAt(VoxelLight* light, Vector3i position);
+u32 getVoxelBlockLight(u8 light);
+u32 getVoxelSkyLight(u8 light);
+
+#endif
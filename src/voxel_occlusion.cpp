@@ -0,0 +1,366 @@
+#include "voxel_occlusion.h"
+
+#include <string.h>
+
+const i32 MAX_VOXEL_OCCLUSION_JOBS = 64;
+
+//the signs of each face's corners, in the order the cube's vertices go around it. the face's own axis is the one every corner shares
+static const i32 VOXEL_FACE_CORNER_SIGNS[VOXEL_FACES_COUNT][4][3] = {
+	{ { -1, -1,  1 }, {  1, -1,  1 }, {  1,  1,  1 }, { -1,  1,  1 } },
+	{ { -1, -1, -1 }, { -1,  1, -1 }, {  1,  1, -1 }, {  1, -1, -1 } },
+	{ { -1,  1,  1 }, { -1,  1, -1 }, { -1, -1, -1 }, { -1, -1,  1 } },
+	{ {  1,  1,  1 }, {  1, -1,  1 }, {  1, -1, -1 }, {  1,  1, -1 } },
+	{ { -1, -1, -1 }, {  1, -1, -1 }, {  1, -1,  1 }, { -1, -1,  1 } },
+	{ { -1,  1, -1 }, { -1,  1,  1 }, {  1,  1,  1 }, {  1,  1, -1 } },
+};
+static const i32 VOXEL_FACE_AXES[VOXEL_FACES_COUNT] = { 2, 2, 0, 0, 1, 1 };
+
+static i32 calculateChunksCount(i32 voxelsCount) {
+	return (voxelsCount + VOXELS_PER_CHUNK - 1) / VOXELS_PER_CHUNK;
+}
+
+//a lattice cell's position is packed into 21 bits per axis, offset like morton codes' coordinates, and its tag is the group index
+//above the voxels' scale
+struct VoxelLatticeKey {
+	u64 position;
+	u32 tag;
+};
+
+//returns 0 for cells that can't be packed, which are never occluded and never occlude anything
+static bool32 makeVoxelLatticeKey(Vector3i position, u32 scale, i32 groupIndex, VoxelLatticeKey* key) {
+	if (
+		!isVoxelPositionMortonCodable(position) || scale == 0 || scale > MAX_OCCLUDED_VOXEL_SCALE || groupIndex < 0 ||
+		groupIndex >= (1 << 24)
+	) {
+		return 0;
+	}
+	key->position =
+		((u64)(position.x + VOXEL_MORTON_BIAS) << (2 * VOXEL_MORTON_AXIS_BITS)) | ((u64)(position.y + VOXEL_MORTON_BIAS) << VOXEL_MORTON_AXIS_BITS) |
+		(u64)(position.z + VOXEL_MORTON_BIAS);
+	key->tag = ((u32)groupIndex << 8) | scale;
+	return 1;
+}
+
+static Vector3i unpackVoxelLatticePosition(u64 position) {
+	u64 mask = (1ull << VOXEL_MORTON_AXIS_BITS) - 1;
+	return Vector3i{
+		(i32)((position >> (2 * VOXEL_MORTON_AXIS_BITS)) & mask) - VOXEL_MORTON_BIAS,
+		(i32)((position >> VOXEL_MORTON_AXIS_BITS) & mask) - VOXEL_MORTON_BIAS,
+		(i32)(position & mask) - VOXEL_MORTON_BIAS,
+	};
+}
+
+static u32 hashVoxelLatticeKey(VoxelLatticeKey key) {
+	u64 h = key.position + (u64)key.tag * 0x9e3779b97f4a7c15ull;
+	h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ull;
+	h = (h ^ (h >> 27)) * 0x94d049bb133111ebull;
+	return (u32)(h ^ (h >> 31));
+}
+
+static bool32 isVoxelLatticeSlotKey(VoxelLatticeSlot* slot, VoxelLatticeKey key) {
+	return slot->position == key.position && slot->tag == key.tag;
+}
+
+//the slots holding the cell are in the run of full slots starting at its hash
+static bool32 isVoxelLatticeCellSolid(VoxelOcclusion* occlusion, Vector3i position, u32 scale, i32 groupIndex) {
+	VoxelLatticeKey key;
+	if (!makeVoxelLatticeKey(position, scale, groupIndex, &key)) {
+		return 0;
+	}
+	u32 mask = occlusion->tableMask;
+	for (u32 s = hashVoxelLatticeKey(key) & mask; occlusion->table[s].voxelIndex >= 0; s = (s + 1) & mask) {
+		if (isVoxelLatticeSlotKey(&occlusion->table[s], key)) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+static void insertLatticeVoxel(VoxelOcclusion* occlusion, VoxelLatticeKey key, i32 voxelIndex) {
+	u32 mask = occlusion->tableMask;
+	u32 s = hashVoxelLatticeKey(key) & mask;
+	for (; occlusion->table[s].voxelIndex >= 0; s = (s + 1) & mask);
+	occlusion->table[s].position = key.position;
+	occlusion->table[s].tag = key.tag;
+	occlusion->table[s].voxelIndex = voxelIndex;
+	occlusion->voxelSlots[voxelIndex] = (i32)s;
+}
+
+//the voxels after the removed one are moved back into the hole when that's still on their way from their hash, so lookups never
+//need to skip over removed slots
+static void removeLatticeVoxel(VoxelOcclusion* occlusion, i32 voxelIndex) {
+	u32 mask = occlusion->tableMask;
+	u32 hole = (u32)occlusion->voxelSlots[voxelIndex];
+	for (u32 s = (hole + 1) & mask; occlusion->table[s].voxelIndex >= 0; s = (s + 1) & mask) {
+		VoxelLatticeSlot* slot = &occlusion->table[s];
+		u32 home = hashVoxelLatticeKey(VoxelLatticeKey{ slot->position, slot->tag }) & mask;
+		if (((s - home) & mask) >= ((s - hole) & mask)) {
+			occlusion->table[hole] = *slot;
+			occlusion->voxelSlots[slot->voxelIndex] = (i32)hole;
+			hole = s;
+		}
+	}
+	occlusion->table[hole].voxelIndex = -1;
+	occlusion->voxelSlots[voxelIndex] = -1;
+}
+
+static void markVoxelOcclusionChunkStale(VoxelOcclusion* occlusion, i32 voxelIndex) {
+	occlusion->isChunkStale[voxelIndex / VOXELS_PER_CHUNK] = 1;
+}
+
+//the voxels around a cell are the ones whose occlusion it takes part in
+static void markLatticeNeighborsStale(VoxelOcclusion* occlusion, VoxelLatticeKey key) {
+	Vector3i p = unpackVoxelLatticePosition(key.position);
+	u32 scale = key.tag & MAX_OCCLUDED_VOXEL_SCALE;
+	i32 groupIndex = (i32)(key.tag >> 8);
+	i32 step = (i32)scale;
+	u32 mask = occlusion->tableMask;
+	for (i32 dx = -1; dx <= 1; dx++) {
+		for (i32 dy = -1; dy <= 1; dy++) {
+			for (i32 dz = -1; dz <= 1; dz++) {
+				VoxelLatticeKey n;
+				if ((dx == 0 && dy == 0 && dz == 0) || !makeVoxelLatticeKey(Vector3i{ p.x + dx * step, p.y + dy * step, p.z + dz * step }, scale, groupIndex, &n)) {
+					continue;
+				}
+				//every voxel in the cell is marked, not only the first one found
+				for (u32 s = hashVoxelLatticeKey(n) & mask; occlusion->table[s].voxelIndex >= 0; s = (s + 1) & mask) {
+					if (isVoxelLatticeSlotKey(&occlusion->table[s], n)) {
+						markVoxelOcclusionChunkStale(occlusion, occlusion->table[s].voxelIndex);
+					}
+				}
+			}
+		}
+	}
+}
+
+//the neighbors don't need to be marked when every chunk is stale anyway
+static void unhashVoxel(VoxelOcclusion* occlusion, i32 voxelIndex, bool32 isMarkingNeighbors) {
+	i32 s = occlusion->voxelSlots[voxelIndex];
+	if (s < 0) {
+		return;
+	}
+	VoxelLatticeKey key = { occlusion->table[s].position, occlusion->table[s].tag };
+	removeLatticeVoxel(occlusion, voxelIndex);
+	if (isMarkingNeighbors) {
+		markLatticeNeighborsStale(occlusion, key);
+	}
+}
+
+static void rehashVoxel(VoxelOcclusion* occlusion, VoxelArray* voxelArray, i32 voxelIndex, bool32 isMarkingNeighbors) {
+	Vector3ui scale = voxelArray->voxelsScale[voxelIndex];
+	VoxelLatticeKey key;
+	//only cubes sit on a lattice of their own size
+	bool32 isHashable =
+		scale.x == scale.y && scale.x == scale.z &&
+		makeVoxelLatticeKey(voxelArray->voxelsPosition[voxelIndex], scale.x, voxelArray->voxelsGroupIndex[voxelIndex], &key);
+	i32 s = occlusion->voxelSlots[voxelIndex];
+	if (s < 0 && !isHashable) {
+		return;
+	}
+	if (s >= 0 && isHashable && isVoxelLatticeSlotKey(&occlusion->table[s], key)) {
+		return;
+	}
+	unhashVoxel(occlusion, voxelIndex, isMarkingNeighbors);
+	markVoxelOcclusionChunkStale(occlusion, voxelIndex);
+	if (isHashable) {
+		insertLatticeVoxel(occlusion, key, voxelIndex);
+		if (isMarkingNeighbors) {
+			markLatticeNeighborsStale(occlusion, key);
+		}
+	}
+}
+
+void initVoxelOcclusion(VoxelOcclusion* occlusion, MemoryAllocator* memoryAllocator, VoxelArray* voxelArray) {
+	occlusion->voxelsCapacity = voxelArray->voxelsCapacity;
+	occlusion->occlusions = (u64*) allocateMemory(memoryAllocator, occlusion->voxelsCapacity * sizeof(u64));
+	occlusion->voxelSlots = (i32*) allocateMemory(memoryAllocator, occlusion->voxelsCapacity * sizeof(i32));
+	memset(occlusion->voxelSlots, 0xff, occlusion->voxelsCapacity * sizeof(i32));
+
+	//at most half full, so probes stay short
+	u32 tableCapacity = 16;
+	while (tableCapacity < 2 * (u32)occlusion->voxelsCapacity) {
+		tableCapacity *= 2;
+	}
+	occlusion->tableMask = tableCapacity - 1;
+	occlusion->table = (VoxelLatticeSlot*) allocateMemory(memoryAllocator, tableCapacity * sizeof(VoxelLatticeSlot));
+	for (u32 i = 0; i < tableCapacity; i++) {
+		occlusion->table[i].voxelIndex = -1;
+	}
+
+	occlusion->chunksCapacity = voxelArray->chunksCapacity;
+	occlusion->isChunkStale = (u8*) allocateMemory(memoryAllocator, occlusion->chunksCapacity);
+	memset(occlusion->isChunkStale, 0, occlusion->chunksCapacity);
+	occlusion->voxelsCount = 0;
+	occlusion->changedChunksBegin = occlusion->chunksCapacity;
+	occlusion->changedChunksEnd = 0;
+}
+
+u32 calculateVoxelCornerOcclusion(bool32 isSide1Solid, bool32 isSide2Solid, bool32 isCornerSolid) {
+	if (isSide1Solid && isSide2Solid) {
+		return 0;
+	}
+	return 3 - (isSide1Solid != 0) - (isSide2Solid != 0) - (isCornerSolid != 0);
+}
+
+u32 getVoxelCornerOcclusion(u64 occlusion, VoxelFace face, u32 corner) {
+	return (u32)(occlusion >> (2 * (4 * face + corner))) & 3;
+}
+
+bool32 isVoxelFaceFlipped(u64 occlusion, VoxelFace face) {
+	return (occlusion >> (VOXEL_OCCLUSION_FLIP_SHIFT + face)) & 1;
+}
+
+static u64 calculateVoxelOcclusion(VoxelOcclusion* occlusion, i32 voxelIndex) {
+	i32 s = occlusion->voxelSlots[voxelIndex];
+	if (s < 0) {
+		return VOXEL_UNOCCLUDED;
+	}
+	Vector3i p = unpackVoxelLatticePosition(occlusion->table[s].position);
+	u32 scale = occlusion->table[s].tag & MAX_OCCLUDED_VOXEL_SCALE;
+	i32 groupIndex = (i32)(occlusion->table[s].tag >> 8);
+	i32 step = (i32)scale;
+	//the 3x3x3 cells around the voxel, indexed by (x + 1) * 9 + (y + 1) * 3 + z + 1
+	bool32 isSolid[27];
+	for (i32 dx = -1; dx <= 1; dx++) {
+		for (i32 dy = -1; dy <= 1; dy++) {
+			for (i32 dz = -1; dz <= 1; dz++) {
+				Vector3i n = { p.x + dx * step, p.y + dy * step, p.z + dz * step };
+				isSolid[(dx + 1) * 9 + (dy + 1) * 3 + dz + 1] = (dx != 0 || dy != 0 || dz != 0) && isVoxelLatticeCellSolid(occlusion, n, scale, groupIndex);
+			}
+		}
+	}
+
+	u64 result = 0;
+	for (u32 f = 0; f < VOXEL_FACES_COUNT; f++) {
+		i32 axis = VOXEL_FACE_AXES[f];
+		i32 a = (axis + 1) % 3;
+		i32 b = (axis + 2) % 3;
+		u32 ao[4];
+		for (u32 c = 0; c < 4; c++) {
+			const i32* signs = VOXEL_FACE_CORNER_SIGNS[f][c];
+			i32 side1[3] = {};
+			i32 side2[3] = {};
+			i32 corner[3] = {};
+			side1[axis] = side2[axis] = corner[axis] = signs[axis];
+			side1[a] = corner[a] = signs[a];
+			side2[b] = corner[b] = signs[b];
+			ao[c] = calculateVoxelCornerOcclusion(
+				isSolid[(side1[0] + 1) * 9 + (side1[1] + 1) * 3 + side1[2] + 1],
+				isSolid[(side2[0] + 1) * 9 + (side2[1] + 1) * 3 + side2[2] + 1],
+				isSolid[(corner[0] + 1) * 9 + (corner[1] + 1) * 3 + corner[2] + 1]
+			);
+			result |= (u64)ao[c] << (2 * (4 * f + c));
+		}
+		//the quad is split between corners 0 and 2 unless 1 and 3 are further apart from each other in darkness
+		if (ao[0] + ao[2] < ao[1] + ao[3]) {
+			result |= 1ull << (VOXEL_OCCLUSION_FLIP_SHIFT + f);
+		}
+	}
+	return result;
+}
+
+struct VoxelOcclusionJob {
+	VoxelOcclusion* occlusion;
+	i32 voxelsCount;
+	i32 chunksBegin;
+	i32 chunksEnd;
+};
+
+static void recomputeVoxelOcclusionChunks(void* data) {
+	VoxelOcclusionJob* job = (VoxelOcclusionJob*)data;
+	VoxelOcclusion* occlusion = job->occlusion;
+	for (i32 c = job->chunksBegin; c < job->chunksEnd; c++) {
+		if (!occlusion->isChunkStale[c]) {
+			continue;
+		}
+		i32 end = MIN((c + 1) * VOXELS_PER_CHUNK, job->voxelsCount);
+		for (i32 i = c * VOXELS_PER_CHUNK; i < end; i++) {
+			occlusion->occlusions[i] = calculateVoxelOcclusion(occlusion, i);
+		}
+	}
+}
+
+void updateVoxelOcclusion(VoxelOcclusion* occlusion, VoxelArray* voxelArray, JobQueue* jobQueue, const VoxelSpan* spans, i32 spansCount) {
+	_assert(occlusion->voxelsCapacity == voxelArray->voxelsCapacity);
+	i32 keptVoxelsCount = MIN(occlusion->voxelsCount, voxelArray->voxelsCount);
+	i32 changedVoxelsCount = MAX(occlusion->voxelsCount, voxelArray->voxelsCount) - keptVoxelsCount;
+	for (i32 s = 0; s < spansCount; s++) {
+		changedVoxelsCount += MAX(0, MIN(spans[s].end, keptVoxelsCount) - spans[s].begin);
+	}
+	//looking up the neighbors of every changed voxel costs about as much as recomputing them, so when a lot of them changed,
+	//like when a world was loaded, every chunk is recomputed instead
+	bool32 isMarkingNeighbors = changedVoxelsCount < MAX(occlusion->voxelsCount, voxelArray->voxelsCount) / 8;
+	if (!isMarkingNeighbors) {
+		memset(occlusion->isChunkStale, 1, calculateChunksCount(MAX(occlusion->voxelsCount, voxelArray->voxelsCount)));
+	}
+
+	for (i32 i = voxelArray->voxelsCount; i < occlusion->voxelsCount; i++) {
+		unhashVoxel(occlusion, i, isMarkingNeighbors);
+	}
+	//voxels added since the last update are usually in the spans too, but aren't left out when they aren't
+	for (i32 i = occlusion->voxelsCount; i < voxelArray->voxelsCount; i++) {
+		rehashVoxel(occlusion, voxelArray, i, isMarkingNeighbors);
+	}
+	for (i32 s = 0; s < spansCount; s++) {
+		i32 end = MIN(spans[s].end, keptVoxelsCount);
+		for (i32 i = spans[s].begin; i < end; i++) {
+			rehashVoxel(occlusion, voxelArray, i, isMarkingNeighbors);
+		}
+	}
+	occlusion->voxelsCount = voxelArray->voxelsCount;
+
+	i32 chunksCount = calculateChunksCount(voxelArray->voxelsCount);
+	i32 staleChunksCount = 0;
+	for (i32 c = 0; c < chunksCount; c++) {
+		staleChunksCount += occlusion->isChunkStale[c];
+	}
+	if (staleChunksCount > 0) {
+		//split so every job has about the same amount of stale chunks
+		VoxelOcclusionJob jobs[MAX_VOXEL_OCCLUSION_JOBS];
+		i32 jobsCount = 0;
+		i32 staleChunksPerJob = staleChunksCount / MAX_VOXEL_OCCLUSION_JOBS + 1;
+		i32 jobStaleChunksCount = 0;
+		i32 chunksBegin = 0;
+		for (i32 c = 0; c < chunksCount; c++) {
+			jobStaleChunksCount += occlusion->isChunkStale[c];
+			if (jobStaleChunksCount < staleChunksPerJob && c + 1 < chunksCount) {
+				continue;
+			}
+			VoxelOcclusionJob* job = &jobs[jobsCount];
+			job->occlusion = occlusion;
+			job->voxelsCount = voxelArray->voxelsCount;
+			job->chunksBegin = chunksBegin;
+			job->chunksEnd = c + 1;
+			jobsCount += 1;
+			chunksBegin = c + 1;
+			jobStaleChunksCount = 0;
+		}
+		for (i32 i = 0; i < jobsCount; i++) {
+			addJob(jobQueue, recomputeVoxelOcclusionChunks, &jobs[i]);
+		}
+		waitForAllJobs(jobQueue);
+	}
+
+	//chunks past the voxels count only had voxels taken out, and are recomputed when voxels are added to them again
+	for (i32 c = 0; c < occlusion->chunksCapacity; c++) {
+		if (!occlusion->isChunkStale[c]) {
+			continue;
+		}
+		occlusion->isChunkStale[c] = 0;
+		if (c < chunksCount) {
+			occlusion->changedChunksBegin = MIN(occlusion->changedChunksBegin, c);
+			occlusion->changedChunksEnd = MAX(occlusion->changedChunksEnd, c + 1);
+		}
+	}
+}
+
+bool32 collectVoxelOcclusionChanges(VoxelOcclusion* occlusion, VoxelSpan* span) {
+	if (occlusion->changedChunksBegin >= occlusion->changedChunksEnd) {
+		return 0;
+	}
+	span->begin = occlusion->changedChunksBegin * VOXELS_PER_CHUNK;
+	span->end = occlusion->changedChunksEnd * VOXELS_PER_CHUNK;
+	occlusion->changedChunksBegin = occlusion->chunksCapacity;
+	occlusion->changedChunksEnd = 0;
+	return 1;
+}
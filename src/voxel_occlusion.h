@@ -0,0 +1,75 @@
+#pragma once
+#ifndef VOXELS_GAME_VOXEL_OCCLUSION_H
+#define VOXELS_GAME_VOXEL_OCCLUSION_H
+
+#include "common.h"
+#include "memory.h"
+#include "voxel.h"
+#include "jobs.h"
+
+/*
+	ambient occlusion baked into the corners of every face of every voxel. a corner is darkened by the voxels on the two sides of it
+	and the one diagonal to it, in the layer in front of its face, and is fully dark when both sides are there.
+	voxels only occlude the voxels of their own group that have the same size and sit on the same lattice, which are found through
+	a hash of the voxels' positions. voxels that aren't cubes, or have no size, are never occluded.
+	a voxel's occlusion is 2 bits per corner of each face, in the order the cube's vertices are in, and a bit per face that flips the
+	diagonal its quad is split along to the one between the corners that are closer in darkness, which keeps the shading from
+	leaning to one side.
+	chunks go stale when their voxels or the voxels next to them change, and only those are recomputed, on the job queue
+*/
+
+typedef u32 VoxelFace;
+//in the order of the cube's vertices. front is +z
+const VoxelFace VOXEL_FACE_FRONT = 0;
+const VoxelFace VOXEL_FACE_BACK = 1;
+const VoxelFace VOXEL_FACE_LEFT = 2;
+const VoxelFace VOXEL_FACE_RIGHT = 3;
+const VoxelFace VOXEL_FACE_BOTTOM = 4;
+const VoxelFace VOXEL_FACE_TOP = 5;
+const u32 VOXEL_FACES_COUNT = 6;
+
+//every corner open and no face flipped
+const u64 VOXEL_UNOCCLUDED = 0x0000ffffffffffffull;
+const u32 VOXEL_OCCLUSION_FLIP_SHIFT = 48;
+//bigger voxels, and voxels whose positions can't be morton coded, are never occluded
+const u32 MAX_OCCLUDED_VOXEL_SCALE = 255;
+
+//a voxel's lattice cell, kept in the table so lookups don't have to read the voxels. empty slots have a voxel index of -1
+struct VoxelLatticeSlot {
+	u64 position;
+	u32 tag;
+	i32 voxelIndex;
+};
+
+struct VoxelOcclusion {
+	i32 voxelsCapacity;
+	u64* occlusions;
+
+	//open addressing of the voxels' cells. a cell may be in it more than once when voxels overlap
+	u32 tableMask;
+	VoxelLatticeSlot* table;
+	//the slot of each voxel, so it can still be found after it changed. -1 for voxels that aren't in the table
+	i32* voxelSlots;
+
+	i32 chunksCapacity;
+	u8* isChunkStale;
+	//the voxels count of the last update. voxels dropped since then are taken out of the table by the next one
+	i32 voxelsCount;
+	//the chunks recomputed since the last collectVoxelOcclusionChanges. [begin, end)
+	i32 changedChunksBegin;
+	i32 changedChunksEnd;
+};
+
+void initVoxelOcclusion(VoxelOcclusion* occlusion, MemoryAllocator* memoryAllocator, VoxelArray* voxelArray);
+//call with the spans collectDirtyVoxelSpans wrote. rehashes their voxels, and recomputes the chunks they and their neighbors are in
+void updateVoxelOcclusion(VoxelOcclusion* occlusion, VoxelArray* voxelArray, JobQueue* jobQueue, const VoxelSpan* spans, i32 spansCount);
+//writes the voxels of the chunks recomputed since the last call, and forgets them. returns 0 if none were
+bool32 collectVoxelOcclusionChanges(VoxelOcclusion* occlusion, VoxelSpan* span);
+
+//3 is open, 0 is fully occluded
+u32 calculateVoxelCornerOcclusion(bool32 isSide1Solid, bool32 isSide2Solid, bool32 isCornerSolid);
+//corners are in the order the cube's vertices go around the face
+u32 getVoxelCornerOcclusion(u64 occlusion, VoxelFace face, u32 corner);
+bool32 isVoxelFaceFlipped(u64 occlusion, VoxelFace face);
+
+#endif
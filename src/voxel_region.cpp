@@ -0,0 +1,433 @@
+#include "voxel_region.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+//fills are split into about this many jobs, and masks into one job per chunk
+const i32 MAX_REGION_FILL_JOBS = 64;
+const i32 VOXEL_MASK_WORDS_PER_CHUNK = VOXELS_PER_CHUNK / 64;
+
+//scaled so the region spans [-1, 1)
+static f64 normalizeRegionCoordinate(i32 min, i32 max, i32 coordinate) {
+	return (f64)(2 * (i64)coordinate - min - max) / (f64)(max - min);
+}
+
+bool32 isInsideVoxelRegion(VoxelRegion region, Vector3i position) {
+	if (
+		position.x < region.min.x || position.x >= region.max.x || position.y < region.min.y || position.y >= region.max.y ||
+		position.z < region.min.z || position.z >= region.max.z
+	) {
+		return 0;
+	}
+	if (region.shape == VOXEL_REGION_BOX) {
+		return 1;
+	}
+	f64 x = normalizeRegionCoordinate(region.min.x, region.max.x, position.x);
+	f64 z = normalizeRegionCoordinate(region.min.z, region.max.z, position.z);
+	if (region.shape == VOXEL_REGION_CYLINDER) {
+		return x * x + z * z < 1.0;
+	}
+	f64 y = normalizeRegionCoordinate(region.min.y, region.max.y, position.y);
+	return x * x + y * y + z * z < 1.0;
+}
+
+//the cells along x of a row, whose centers are gridMin.x + cellSize * i + cellSize / 2
+struct VoxelRegionCells {
+	Vector3i gridMin;
+	i32 cellSize;
+	i32 cellsCount;
+	i32 y;
+	i32 z;
+};
+
+static bool32 isRegionCellInside(VoxelRegion region, VoxelRegionCells* cells, i32 i) {
+	return isInsideVoxelRegion(region, Vector3i{ cells->gridMin.x + cells->cellSize * i + cells->cellSize / 2, cells->y, cells->z });
+}
+
+//the region is convex, so the cells of a row that are inside it are one run [begin, end)
+static void findRegionRowCells(VoxelRegion region, VoxelRegionCells* cells, i32* begin, i32* end) {
+	*begin = 0;
+	*end = 0;
+	if (cells->y < region.min.y || cells->y >= region.max.y || cells->z < region.min.z || cells->z >= region.max.z || region.min.x >= region.max.x) {
+		return;
+	}
+	//the half width of the row, worked out from the shape, is only a guess because of rounding. the ends are moved to the exact cells after
+	f64 t = 1.0;
+	f64 y = normalizeRegionCoordinate(region.min.y, region.max.y, cells->y);
+	f64 z = normalizeRegionCoordinate(region.min.z, region.max.z, cells->z);
+	if (region.shape == VOXEL_REGION_SPHERE) {
+		t = 1.0 - y * y - z * z;
+	} else if (region.shape == VOXEL_REGION_CYLINDER) {
+		t = 1.0 - z * z;
+	}
+	if (t <= 0.0) {
+		return;
+	}
+	f64 halfWidth = sqrt(t) * 0.5 * (f64)(region.max.x - region.min.x);
+	f64 center = 0.5 * ((f64)region.min.x + (f64)region.max.x);
+	f64 firstCenter = (f64)(cells->gridMin.x + cells->cellSize / 2);
+	f64 first = ceil((center - halfWidth - firstCenter) / (f64)cells->cellSize);
+	f64 last = floor((center + halfWidth - firstCenter) / (f64)cells->cellSize);
+	i32 b = (i32)fmin(fmax(first, 0.0), (f64)cells->cellsCount);
+	i32 e = (i32)fmin(fmax(last + 1.0, (f64)b), (f64)cells->cellsCount);
+	while (b < e && !isRegionCellInside(region, cells, b)) {
+		b += 1;
+	}
+	while (e > b && !isRegionCellInside(region, cells, e - 1)) {
+		e -= 1;
+	}
+	while (b > 0 && isRegionCellInside(region, cells, b - 1)) {
+		b -= 1;
+	}
+	while (e < cells->cellsCount && isRegionCellInside(region, cells, e)) {
+		e += 1;
+	}
+	*begin = b;
+	*end = e;
+}
+
+//a hollow row has a run on each side of the inner region
+struct VoxelRegionRow {
+	i32 cellsBegin[2];
+	i32 cellsEnd[2];
+	i64 voxelIndex;
+};
+
+struct VoxelRegionFillJob {
+	VoxelArray* voxelArray;
+	VoxelRegionRow* rows;
+	i32 rowsBegin;
+	i32 rowsEnd;
+	//rows go along y, then z
+	i32 rowsPerLayer;
+	Vector3i gridMin;
+	i32 cellSize;
+	RGBAColorF32 color;
+	i32 groupIndex;
+};
+
+static void fillVoxelRegionRows(void* data) {
+	VoxelRegionFillJob* job = (VoxelRegionFillJob*)data;
+	VoxelArray* voxelArray = job->voxelArray;
+	i32 s = job->cellSize;
+	Vector3ui scale = { (u32)s, (u32)s, (u32)s };
+	for (i32 r = job->rowsBegin; r < job->rowsEnd; r++) {
+		VoxelRegionRow* row = &job->rows[r];
+		i32 y = job->gridMin.y + s * (r % job->rowsPerLayer) + s / 2;
+		i32 z = job->gridMin.z + s * (r / job->rowsPerLayer) + s / 2;
+		i32 x = job->gridMin.x + s / 2;
+		i32 at = (i32)row->voxelIndex;
+		for (i32 run = 0; run < 2; run++) {
+			i32 count = row->cellsEnd[run] - row->cellsBegin[run];
+			if (count <= 0) {
+				continue;
+			}
+			RGBAColorF32* colors = &voxelArray->colors[at];
+			Vector3i* positions = &voxelArray->voxelsPosition[at];
+			Vector3ui* scales = &voxelArray->voxelsScale[at];
+			i32* groupIndices = &voxelArray->voxelsGroupIndex[at];
+			i32 runX = x + s * row->cellsBegin[run];
+			//one array at a time, so each loop is a plain strided store
+			for (i32 i = 0; i < count; i++) {
+				colors[i] = job->color;
+			}
+			for (i32 i = 0; i < count; i++) {
+				positions[i] = Vector3i{ runX + s * i, y, z };
+			}
+			for (i32 i = 0; i < count; i++) {
+				scales[i] = scale;
+			}
+			for (i32 i = 0; i < count; i++) {
+				groupIndices[i] = job->groupIndex;
+			}
+			at += count;
+		}
+	}
+}
+
+i32 fillVoxelRegion(
+	VoxelArray* voxelArray, JobQueue* jobQueue, EditJournal* journal, VoxelRegion region, i32 cellSize, i32 hollowThickness, RGBAColorF32 color, i32 groupIndex
+) {
+	_assert(cellSize > 0 && groupIndex >= 0 && groupIndex < voxelArray->groupsCount);
+	i32 cellsCountX = MAX(0, (region.max.x - region.min.x) / cellSize);
+	i32 cellsCountY = MAX(0, (region.max.y - region.min.y) / cellSize);
+	i32 cellsCountZ = MAX(0, (region.max.z - region.min.z) / cellSize);
+	i64 rowsCount = (i64)cellsCountY * cellsCountZ;
+	if (cellsCountX == 0 || rowsCount == 0) {
+		return -1;
+	}
+	VoxelRegion inner = region;
+	bool32 isHollow = hollowThickness > 0;
+	if (isHollow) {
+		i32 depth = hollowThickness * cellSize;
+		inner.min = Vector3i{ region.min.x + depth, region.min.y + depth, region.min.z + depth };
+		inner.max = Vector3i{ region.max.x - depth, region.max.y - depth, region.max.z - depth };
+	}
+
+	//runs are found for every row before anything is written, so each one knows where its voxels go
+	VoxelRegionRow* rows = (VoxelRegionRow*) malloc(rowsCount * sizeof(VoxelRegionRow));
+	_assert(rows != nil);
+	VoxelRegionCells cells = {};
+	cells.gridMin = region.min;
+	cells.cellSize = cellSize;
+	cells.cellsCount = cellsCountX;
+	i64 voxelsCount = 0;
+	for (i64 r = 0; r < rowsCount; r++) {
+		VoxelRegionRow* row = &rows[r];
+		cells.y = region.min.y + cellSize * (i32)(r % cellsCountY) + cellSize / 2;
+		cells.z = region.min.z + cellSize * (i32)(r / cellsCountY) + cellSize / 2;
+		i32 begin, end;
+		findRegionRowCells(region, &cells, &begin, &end);
+		row->cellsBegin[0] = begin;
+		row->cellsEnd[0] = end;
+		row->cellsBegin[1] = end;
+		row->cellsEnd[1] = end;
+		if (isHollow && begin < end) {
+			i32 innerBegin, innerEnd;
+			findRegionRowCells(inner, &cells, &innerBegin, &innerEnd);
+			if (innerBegin < innerEnd) {
+				row->cellsEnd[0] = MAX(begin, MIN(innerBegin, end));
+				row->cellsBegin[1] = MAX(begin, MIN(innerEnd, end));
+			}
+		}
+		row->voxelIndex = voxelsCount;
+		voxelsCount += (row->cellsEnd[0] - row->cellsBegin[0]) + (row->cellsEnd[1] - row->cellsBegin[1]);
+	}
+	if (voxelsCount == 0 || voxelsCount > (i64)(voxelArray->voxelsCapacity - voxelArray->voxelsCount)) {
+		free(rows);
+		return -1;
+	}
+
+	if (journal != nil) {
+		recordVoxelGroupEdit(journal, voxelArray, groupIndex);
+	}
+	i32 begin = appendVoxelsToGroup(voxelArray, (i32)voxelsCount, groupIndex);
+	//rows are split between the jobs by their amount of voxels, since the rows of a sphere differ a lot
+	VoxelRegionFillJob jobs[MAX_REGION_FILL_JOBS];
+	i32 jobsCount = 0;
+	i64 voxelsPerJob = MAX(voxelsCount / MAX_REGION_FILL_JOBS + 1, (i64)VOXELS_PER_CHUNK);
+	i64 jobVoxelsBegin = 0;
+	i32 rowsBegin = 0;
+	for (i64 r = 0; r < rowsCount; r++) {
+		i64 rowVoxelsEnd = r + 1 < rowsCount ? rows[r + 1].voxelIndex : voxelsCount;
+		rows[r].voxelIndex += begin;
+		if (r + 1 < rowsCount && (rowVoxelsEnd - jobVoxelsBegin < voxelsPerJob || jobsCount == MAX_REGION_FILL_JOBS - 1)) {
+			continue;
+		}
+		VoxelRegionFillJob* job = &jobs[jobsCount];
+		job->voxelArray = voxelArray;
+		job->rows = rows;
+		job->rowsBegin = rowsBegin;
+		job->rowsEnd = (i32)r + 1;
+		job->rowsPerLayer = cellsCountY;
+		job->gridMin = region.min;
+		job->cellSize = cellSize;
+		job->color = color;
+		job->groupIndex = groupIndex;
+		jobsCount += 1;
+		rowsBegin = (i32)r + 1;
+		jobVoxelsBegin = rowVoxelsEnd;
+	}
+	for (i32 i = 0; i < jobsCount; i++) {
+		addJob(jobQueue, fillVoxelRegionRows, &jobs[i]);
+	}
+	waitForAllJobs(jobQueue);
+	free(rows);
+	return begin;
+}
+
+//one chunk's part of the group's voxels, and the bitmask of the ones that matched
+struct VoxelRegionChunkJob {
+	VoxelArray* voxelArray;
+	VoxelRegion region;
+	i32 groupIndex;
+	bool32 isColorMatched;
+	RGBAColorF32 color;
+	VoxelSpan span;
+	//bit i of word w is voxel chunkBegin + 64 * w + i
+	i32 chunkBegin;
+	u64 mask[VOXEL_MASK_WORDS_PER_CHUNK];
+	i32 matchedCount;
+
+	//where the matched voxels go
+	RGBAColorF32 newColor;
+	VoxelClipboard* clipboard;
+	i32 clipboardIndex;
+};
+
+static bool32 areColorsEqual(RGBAColorF32 a, RGBAColorF32 b) {
+	return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+static void maskVoxelRegionChunk(void* data) {
+	VoxelRegionChunkJob* job = (VoxelRegionChunkJob*)data;
+	VoxelArray* voxelArray = job->voxelArray;
+	memset(job->mask, 0, sizeof(job->mask));
+	i32 matchedCount = 0;
+	for (i32 i = job->span.begin; i < job->span.end; i++) {
+		//voxels of chunks that aren't loaded have no size, and their colors and positions may be gone
+		u64 isMatched =
+			voxelArray->voxelsScale[i].x != 0 && voxelArray->voxelsGroupIndex[i] == job->groupIndex &&
+			isInsideVoxelRegion(job->region, voxelArray->voxelsPosition[i]) && (!job->isColorMatched || areColorsEqual(voxelArray->colors[i], job->color));
+		job->mask[(i - job->chunkBegin) / 64] |= isMatched << ((i - job->chunkBegin) % 64);
+		matchedCount += (i32)isMatched;
+	}
+	job->matchedCount = matchedCount;
+}
+
+static void recolorVoxelRegionChunk(void* data) {
+	VoxelRegionChunkJob* job = (VoxelRegionChunkJob*)data;
+	RGBAColorF32* colors = &job->voxelArray->colors[job->chunkBegin];
+	for (i32 w = 0; w < VOXEL_MASK_WORDS_PER_CHUNK; w++) {
+		u64 word = job->mask[w];
+		if (word == 0) {
+			continue;
+		}
+		for (i32 i = 0; i < 64; i++) {
+			if ((word >> i) & 1) {
+				colors[64 * w + i] = job->newColor;
+			}
+		}
+	}
+}
+
+static void copyVoxelRegionChunk(void* data) {
+	VoxelRegionChunkJob* job = (VoxelRegionChunkJob*)data;
+	VoxelArray* voxelArray = job->voxelArray;
+	VoxelClipboard* clipboard = job->clipboard;
+	i32 at = job->clipboardIndex;
+	for (i32 w = 0; w < VOXEL_MASK_WORDS_PER_CHUNK; w++) {
+		u64 word = job->mask[w];
+		for (i32 i = 0; word != 0 && i < 64; i++) {
+			if ((word >> i) & 1) {
+				i32 v = job->chunkBegin + 64 * w + i;
+				Vector3i position = voxelArray->voxelsPosition[v];
+				clipboard->colors[at] = voxelArray->colors[v];
+				clipboard->voxelsPosition[at] = Vector3i{ position.x - job->region.min.x, position.y - job->region.min.y, position.z - job->region.min.z };
+				clipboard->voxelsScale[at] = voxelArray->voxelsScale[v];
+				at += 1;
+			}
+		}
+	}
+}
+
+//masks the group's voxels in the region, one job per chunk the group has voxels in. the caller frees the jobs
+static VoxelRegionChunkJob* maskVoxelRegion(
+	VoxelArray* voxelArray, JobQueue* jobQueue, VoxelRegion region, i32 groupIndex, const RGBAColorF32* color, i32* jobsCount
+) {
+	_assert(groupIndex >= 0 && groupIndex < voxelArray->groupsCount);
+	VoxelGroup* group = &voxelArray->groups[groupIndex];
+	*jobsCount = 0;
+	if (group->voxelsBegin >= group->voxelsEnd) {
+		return nil;
+	}
+	i32 firstChunk = group->voxelsBegin / VOXELS_PER_CHUNK;
+	i32 chunksCount = (group->voxelsEnd - 1) / VOXELS_PER_CHUNK + 1 - firstChunk;
+	VoxelRegionChunkJob* jobs = (VoxelRegionChunkJob*) malloc(chunksCount * sizeof(VoxelRegionChunkJob));
+	_assert(jobs != nil);
+	for (i32 c = 0; c < chunksCount; c++) {
+		VoxelRegionChunkJob* job = &jobs[c];
+		job->voxelArray = voxelArray;
+		job->region = region;
+		job->groupIndex = groupIndex;
+		job->isColorMatched = color != nil;
+		job->color = color != nil ? *color : RGBAColorF32{};
+		job->chunkBegin = (firstChunk + c) * VOXELS_PER_CHUNK;
+		job->span = VoxelSpan{ MAX(group->voxelsBegin, job->chunkBegin), MIN(group->voxelsEnd, job->chunkBegin + VOXELS_PER_CHUNK) };
+		addJob(jobQueue, maskVoxelRegionChunk, job);
+	}
+	waitForAllJobs(jobQueue);
+	*jobsCount = chunksCount;
+	return jobs;
+}
+
+i32 replaceVoxelRegionColor(VoxelArray* voxelArray, JobQueue* jobQueue, EditJournal* journal, VoxelRegion region, i32 groupIndex, RGBAColorF32 from, RGBAColorF32 to) {
+	i32 jobsCount;
+	VoxelRegionChunkJob* jobs = maskVoxelRegion(voxelArray, jobQueue, region, groupIndex, &from, &jobsCount);
+	i32 matchedCount = 0;
+	//consecutive chunks with matches are recorded and copied for a running save as one span, before any of them is written
+	for (i32 c = 0; c < jobsCount;) {
+		if (jobs[c].matchedCount == 0) {
+			c += 1;
+			continue;
+		}
+		VoxelSpan span = jobs[c].span;
+		while (c < jobsCount && jobs[c].matchedCount > 0) {
+			span.end = jobs[c].span.end;
+			matchedCount += jobs[c].matchedCount;
+			c += 1;
+		}
+		if (journal != nil) {
+			recordVoxelSpanEdit(journal, voxelArray, span);
+		}
+		prepareVoxelSpanWrite(voxelArray, span);
+		markVoxelSpanDirty(voxelArray, span);
+	}
+	for (i32 c = 0; c < jobsCount; c++) {
+		if (jobs[c].matchedCount > 0) {
+			jobs[c].newColor = to;
+			addJob(jobQueue, recolorVoxelRegionChunk, &jobs[c]);
+		}
+	}
+	waitForAllJobs(jobQueue);
+	free(jobs);
+	return matchedCount;
+}
+
+void initVoxelClipboard(VoxelClipboard* clipboard, MemoryAllocator* memoryAllocator, i32 voxelsCapacity) {
+	clipboard->voxelsCapacity = voxelsCapacity;
+	clipboard->voxelsCount = 0;
+	clipboard->colors = (RGBAColorF32*) allocateMemory(memoryAllocator, voxelsCapacity * sizeof(RGBAColorF32));
+	clipboard->voxelsPosition = (Vector3i*) allocateMemory(memoryAllocator, voxelsCapacity * sizeof(Vector3i));
+	clipboard->voxelsScale = (Vector3ui*) allocateMemory(memoryAllocator, voxelsCapacity * sizeof(Vector3ui));
+}
+
+bool32 copyVoxelRegion(VoxelArray* voxelArray, JobQueue* jobQueue, VoxelRegion region, i32 groupIndex, VoxelClipboard* clipboard) {
+	i32 jobsCount;
+	VoxelRegionChunkJob* jobs = maskVoxelRegion(voxelArray, jobQueue, region, groupIndex, nil, &jobsCount);
+	i64 voxelsCount = 0;
+	for (i32 c = 0; c < jobsCount; c++) {
+		jobs[c].clipboard = clipboard;
+		jobs[c].clipboardIndex = (i32)MIN(voxelsCount, (i64)clipboard->voxelsCapacity);
+		voxelsCount += jobs[c].matchedCount;
+	}
+	clipboard->voxelsCount = 0;
+	if (voxelsCount > clipboard->voxelsCapacity) {
+		free(jobs);
+		return 0;
+	}
+	for (i32 c = 0; c < jobsCount; c++) {
+		if (jobs[c].matchedCount > 0) {
+			addJob(jobQueue, copyVoxelRegionChunk, &jobs[c]);
+		}
+	}
+	waitForAllJobs(jobQueue);
+	clipboard->voxelsCount = (i32)voxelsCount;
+	free(jobs);
+	return 1;
+}
+
+i32 pasteVoxelClipboard(VoxelArray* voxelArray, EditJournal* journal, VoxelClipboard* clipboard, Vector3i position, i32 groupIndex) {
+	_assert(groupIndex >= 0 && groupIndex < voxelArray->groupsCount);
+	i32 count = clipboard->voxelsCount;
+	if (count == 0 || count > voxelArray->voxelsCapacity - voxelArray->voxelsCount) {
+		return -1;
+	}
+	if (journal != nil) {
+		recordVoxelGroupEdit(journal, voxelArray, groupIndex);
+	}
+	i32 begin = appendVoxelsToGroup(voxelArray, count, groupIndex);
+	memcpy(&voxelArray->colors[begin], clipboard->colors, count * sizeof(RGBAColorF32));
+	memcpy(&voxelArray->voxelsScale[begin], clipboard->voxelsScale, count * sizeof(Vector3ui));
+	Vector3i* positions = &voxelArray->voxelsPosition[begin];
+	i32* groupIndices = &voxelArray->voxelsGroupIndex[begin];
+	for (i32 i = 0; i < count; i++) {
+		Vector3i p = clipboard->voxelsPosition[i];
+		positions[i] = Vector3i{ p.x + position.x, p.y + position.y, p.z + position.z };
+	}
+	for (i32 i = 0; i < count; i++) {
+		groupIndices[i] = groupIndex;
+	}
+	return begin;
+}
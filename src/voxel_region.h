@@ -0,0 +1,60 @@
+#pragma once
+#ifndef VOXELS_GAME_VOXEL_REGION_H
+#define VOXELS_GAME_VOXEL_REGION_H
+
+#include "common.h"
+#include "memory.h"
+#include "voxel.h"
+#include "jobs.h"
+#include "edit_journal.h"
+
+/*
+	edits of every voxel in a region of a group at once, split per chunk of voxels and run on the job queue.
+	a voxel is in a region if its center is. the voxels of a chunk are tested into a bitmask first, so chunks without a match are never
+	written, and the chunks that are get marked dirty, recorded in the journal and copied for a running save once per edit.
+	fills are worked out as runs of cells along x for every row of the region, and written in place at the end of the voxel array.
+	voxels without a size, like the ones of a world's chunks that aren't loaded, are never in a region. load them first to edit them
+*/
+
+typedef u32 VoxelRegionShape;
+const VoxelRegionShape VOXEL_REGION_BOX = 0;
+//the sphere and the cylinder are inscribed in the region's box, so they are stretched when the box isn't a cube
+const VoxelRegionShape VOXEL_REGION_SPHERE = 1;
+//stands along y
+const VoxelRegionShape VOXEL_REGION_CYLINDER = 2;
+
+//in voxel units of the group's space. max is exclusive
+struct VoxelRegion {
+	VoxelRegionShape shape;
+	Vector3i min;
+	Vector3i max;
+};
+
+//voxels copied out of a region, with their positions relative to its min
+struct VoxelClipboard {
+	i32 voxelsCapacity;
+	i32 voxelsCount;
+	RGBAColorF32* colors;
+	Vector3i* voxelsPosition;
+	Vector3ui* voxelsScale;
+};
+
+bool32 isInsideVoxelRegion(VoxelRegion region, Vector3i position);
+
+//fills the region with cubes of cellSize voxel units, on a grid that starts at its min. with a hollowThickness above 0, only the cells
+//that are less than that many cells deep inside the region are filled.
+//the journal may be nil. returns the index of the first voxel added, or -1 if the region has no cells or they don't fit
+i32 fillVoxelRegion(
+	VoxelArray* voxelArray, JobQueue* jobQueue, EditJournal* journal, VoxelRegion region, i32 cellSize, i32 hollowThickness, RGBAColorF32 color, i32 groupIndex
+);
+//gives the group's voxels in the region that have the color from the color to. returns the amount of them
+i32 replaceVoxelRegionColor(VoxelArray* voxelArray, JobQueue* jobQueue, EditJournal* journal, VoxelRegion region, i32 groupIndex, RGBAColorF32 from, RGBAColorF32 to);
+
+void initVoxelClipboard(VoxelClipboard* clipboard, MemoryAllocator* memoryAllocator, i32 voxelsCapacity);
+//replaces the clipboard's voxels with the group's voxels in the region. returns 0 if they don't fit, which leaves it empty
+bool32 copyVoxelRegion(VoxelArray* voxelArray, JobQueue* jobQueue, VoxelRegion region, i32 groupIndex, VoxelClipboard* clipboard);
+//adds the clipboard's voxels to the group, with the min of the region they were copied from at position.
+//the journal may be nil. returns the index of the first voxel added, or -1 if the clipboard is empty or its voxels don't fit
+i32 pasteVoxelClipboard(VoxelArray* voxelArray, EditJournal* journal, VoxelClipboard* clipboard, Vector3i position, i32 groupIndex);
+
+#endif
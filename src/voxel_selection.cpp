@@ -0,0 +1,739 @@
+#include "voxel_selection.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <float.h>
+#include <stdint.h>
+
+//stale chunks are refreshed by at most this many jobs, and queries run one job per chunk they reach
+const i32 MAX_SPATIAL_INDEX_JOBS = 64;
+const i32 NO_VOXEL_GROUP_TRANSFORM = -2;
+
+typedef u32 VoxelSelectionQueryShape;
+const VoxelSelectionQueryShape VOXEL_SELECTION_QUERY_BOX = 0;
+const VoxelSelectionQueryShape VOXEL_SELECTION_QUERY_FRUSTUM = 1;
+const VoxelSelectionQueryShape VOXEL_SELECTION_QUERY_LASSO = 2;
+//every voxel of the marked groups
+const VoxelSelectionQueryShape VOXEL_SELECTION_QUERY_GROUPS = 3;
+
+//adds up the bits of each pair, then each nibble, then each byte, and sums the bytes with one multiply
+static i32 countSetBits(u64 x) {
+	x = x - ((x >> 1) & 0x5555555555555555ull);
+	x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+	x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+	return (i32)((x * 0x0101010101010101ull) >> 56);
+}
+
+static i32 calculateChunksCount(i32 voxelsCount) {
+	return (voxelsCount + VOXELS_PER_CHUNK - 1) / VOXELS_PER_CHUNK;
+}
+
+//the transform of the last group a voxel was in, since consecutive voxels are nearly always in the same group.
+//the rotation is scaled to take voxel units, so a voxel's center is one multiply and add away
+struct VoxelGroupTransform {
+	i32 groupIndex;
+	f32 rotation[3][3];
+	math::Vector3 translation;
+};
+
+static void loadVoxelGroupTransform(VoxelArray* voxelArray, i32 groupIndex, VoxelGroupTransform* transform) {
+	if (transform->groupIndex == groupIndex) {
+		return;
+	}
+	transform->groupIndex = groupIndex;
+	math::Matrix4 m = math::initIdentityMatrix();
+	transform->translation = math::Vector3{ 0.0f, 0.0f, 0.0f };
+	if (groupIndex >= 0) {
+		VoxelGroup* group = &voxelArray->groups[groupIndex];
+		m = math::createRotationMatrix(group->rotation);
+		transform->translation = group->position.scale(voxelUnitsToWorldUnits);
+	}
+	f32 u = voxelUnitsToWorldUnits;
+	transform->rotation[0][0] = u * m.e.m00;
+	transform->rotation[0][1] = u * m.e.m01;
+	transform->rotation[0][2] = u * m.e.m02;
+	transform->rotation[1][0] = u * m.e.m10;
+	transform->rotation[1][1] = u * m.e.m11;
+	transform->rotation[1][2] = u * m.e.m12;
+	transform->rotation[2][0] = u * m.e.m20;
+	transform->rotation[2][1] = u * m.e.m21;
+	transform->rotation[2][2] = u * m.e.m22;
+}
+
+//p is in voxel units of the group's space
+static math::Vector3 transformVoxelPoint(VoxelGroupTransform* transform, f32 x, f32 y, f32 z) {
+	math::Vector3 t = transform->translation;
+	f32 (*r)[3] = transform->rotation;
+	return math::Vector3{
+		r[0][0] * x + r[0][1] * y + r[0][2] * z + t.x,
+		r[1][0] * x + r[1][1] * y + r[1][2] * z + t.y,
+		r[2][0] * x + r[2][1] * y + r[2][2] * z + t.z,
+	};
+}
+
+static math::Vector3 calculateVoxelWorldCenter(VoxelArray* voxelArray, i32 voxelIndex, VoxelGroupTransform* transform) {
+	loadVoxelGroupTransform(voxelArray, voxelArray->voxelsGroupIndex[voxelIndex], transform);
+	Vector3i p = voxelArray->voxelsPosition[voxelIndex];
+	return transformVoxelPoint(transform, (f32)p.x, (f32)p.y, (f32)p.z);
+}
+
+static bool32 isAABBEmpty(AABB a) {
+	return a.min.x > a.max.x;
+}
+
+static bool32 isAABBOverlappingAABB(AABB a, AABB b) {
+	return
+		a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y && a.max.y >= b.min.y &&
+		a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+static bool32 isAABBInsideAABB(AABB inner, AABB outer) {
+	return
+		inner.min.x >= outer.min.x && inner.max.x <= outer.max.x && inner.min.y >= outer.min.y && inner.max.y <= outer.max.y &&
+		inner.min.z >= outer.min.z && inner.max.z <= outer.max.z;
+}
+
+static void markSpatialIndexChunksStale(VoxelSpatialIndex* index, VoxelSpan span) {
+	span.end = MIN(span.end, index->chunksCapacity * VOXELS_PER_CHUNK);
+	if (span.begin >= span.end) {
+		return;
+	}
+	for (i32 c = span.begin / VOXELS_PER_CHUNK; c <= (span.end - 1) / VOXELS_PER_CHUNK; c++) {
+		index->isChunkStale[c] = 1;
+	}
+}
+
+void initVoxelSpatialIndex(VoxelSpatialIndex* index, MemoryAllocator* memoryAllocator, VoxelArray* voxelArray) {
+	index->chunksCapacity = voxelArray->chunksCapacity;
+	index->chunkBounds = (AABB*) allocateMemory(memoryAllocator, index->chunksCapacity * sizeof(AABB));
+	index->isChunkStale = (u8*) allocateMemory(memoryAllocator, index->chunksCapacity);
+	memset(index->isChunkStale, 1, index->chunksCapacity);
+	index->voxelsCount = 0;
+}
+
+void markVoxelSpatialIndexStale(VoxelSpatialIndex* index, const VoxelSpan* spans, i32 spansCount) {
+	for (i32 i = 0; i < spansCount; i++) {
+		markSpatialIndexChunksStale(index, spans[i]);
+	}
+}
+
+struct VoxelSpatialIndexJob {
+	VoxelSpatialIndex* index;
+	VoxelArray* voxelArray;
+	i32 chunksBegin;
+	i32 chunksEnd;
+};
+
+//adds the world bounds of a box in voxel units of the group's space, given in half voxel units so it stays in integers
+static void addVoxelGroupBoxToBounds(VoxelGroupTransform* transform, i64 min[3], i64 max[3], AABB* bounds) {
+	math::Vector3 center = transformVoxelPoint(transform, 0.25f * (f32)(min[0] + max[0]), 0.25f * (f32)(min[1] + max[1]), 0.25f * (f32)(min[2] + max[2]));
+	f32 h[3] = { 0.25f * (f32)(max[0] - min[0]), 0.25f * (f32)(max[1] - min[1]), 0.25f * (f32)(max[2] - min[2]) };
+	f32 (*r)[3] = transform->rotation;
+	for (i32 k = 0; k < 3; k++) {
+		f32 extent = fabsf(r[k][0]) * h[0] + fabsf(r[k][1]) * h[1] + fabsf(r[k][2]) * h[2];
+		bounds->min.v[k] = fminf(bounds->min.v[k], center.v[k] - extent);
+		bounds->max.v[k] = fmaxf(bounds->max.v[k], center.v[k] + extent);
+	}
+}
+
+//the bounds of each run of voxels of one group are found in the group's space first, and transformed once.
+//for a rotated group that's a bit bigger than the voxels, which is fine for culling
+static void refreshVoxelSpatialIndexChunks(void* data) {
+	VoxelSpatialIndexJob* job = (VoxelSpatialIndexJob*)data;
+	VoxelSpatialIndex* index = job->index;
+	VoxelArray* voxelArray = job->voxelArray;
+	VoxelGroupTransform transform;
+	transform.groupIndex = NO_VOXEL_GROUP_TRANSFORM;
+	for (i32 c = job->chunksBegin; c < job->chunksEnd; c++) {
+		if (!index->isChunkStale[c]) {
+			continue;
+		}
+		AABB bounds = {};
+		bounds.min = math::Vector3{ FLT_MAX, FLT_MAX, FLT_MAX };
+		bounds.max = math::Vector3{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		i32 end = MIN((c + 1) * VOXELS_PER_CHUNK, voxelArray->voxelsCount);
+		for (i32 i = c * VOXELS_PER_CHUNK; i < end;) {
+			i32 groupIndex = voxelArray->voxelsGroupIndex[i];
+			i64 min[3] = { INT64_MAX, INT64_MAX, INT64_MAX };
+			i64 max[3] = { INT64_MIN, INT64_MIN, INT64_MIN };
+			for (; i < end && voxelArray->voxelsGroupIndex[i] == groupIndex; i++) {
+				//the voxels of world chunks that aren't loaded yet have no size
+				Vector3ui scale = voxelArray->voxelsScale[i];
+				if (scale.x == 0) {
+					continue;
+				}
+				Vector3i p = voxelArray->voxelsPosition[i];
+				min[0] = MIN(min[0], 2 * (i64)p.x - scale.x);
+				min[1] = MIN(min[1], 2 * (i64)p.y - scale.y);
+				min[2] = MIN(min[2], 2 * (i64)p.z - scale.z);
+				max[0] = MAX(max[0], 2 * (i64)p.x + scale.x);
+				max[1] = MAX(max[1], 2 * (i64)p.y + scale.y);
+				max[2] = MAX(max[2], 2 * (i64)p.z + scale.z);
+			}
+			if (min[0] <= max[0]) {
+				loadVoxelGroupTransform(voxelArray, groupIndex, &transform);
+				addVoxelGroupBoxToBounds(&transform, min, max, &bounds);
+			}
+		}
+		index->chunkBounds[c] = bounds;
+		index->isChunkStale[c] = 0;
+	}
+}
+
+void refreshVoxelSpatialIndex(VoxelSpatialIndex* index, VoxelArray* voxelArray, JobQueue* jobQueue) {
+	_assert(index->chunksCapacity == voxelArray->chunksCapacity);
+	//the dirty state is the renderer's, so it's only looked at here, not cleared
+	markSpatialIndexChunksStale(index, VoxelSpan{ MIN(index->voxelsCount, voxelArray->voxelsCount), MAX(index->voxelsCount, voxelArray->voxelsCount) });
+	index->voxelsCount = voxelArray->voxelsCount;
+	markVoxelSpatialIndexStale(index, voxelArray->dirtySpans, voxelArray->dirtySpansCount);
+	for (i32 i = 0; i < voxelArray->dirtyGroupsCount; i++) {
+		VoxelGroup* group = &voxelArray->groups[voxelArray->dirtyGroups[i]];
+		markSpatialIndexChunksStale(index, VoxelSpan{ group->voxelsBegin, group->voxelsEnd });
+	}
+
+	i32 chunksCount = calculateChunksCount(voxelArray->voxelsCount);
+	i32 staleChunksCount = 0;
+	for (i32 c = 0; c < chunksCount; c++) {
+		staleChunksCount += index->isChunkStale[c];
+	}
+	if (staleChunksCount == 0) {
+		return;
+	}
+	//split so every job has about the same amount of stale chunks
+	VoxelSpatialIndexJob jobs[MAX_SPATIAL_INDEX_JOBS];
+	i32 jobsCount = 0;
+	i32 staleChunksPerJob = staleChunksCount / MAX_SPATIAL_INDEX_JOBS + 1;
+	i32 jobStaleChunksCount = 0;
+	i32 chunksBegin = 0;
+	for (i32 c = 0; c < chunksCount; c++) {
+		jobStaleChunksCount += index->isChunkStale[c];
+		if (jobStaleChunksCount < staleChunksPerJob && c + 1 < chunksCount) {
+			continue;
+		}
+		VoxelSpatialIndexJob* job = &jobs[jobsCount];
+		job->index = index;
+		job->voxelArray = voxelArray;
+		job->chunksBegin = chunksBegin;
+		job->chunksEnd = c + 1;
+		jobsCount += 1;
+		chunksBegin = c + 1;
+		jobStaleChunksCount = 0;
+	}
+	for (i32 i = 0; i < jobsCount; i++) {
+		addJob(jobQueue, refreshVoxelSpatialIndexChunks, &jobs[i]);
+	}
+	waitForAllJobs(jobQueue);
+}
+
+i32 pickVoxelInIndex(
+	VoxelSpatialIndex* index, VoxelArray* voxelArray, JobQueue* jobQueue, math::Vector3 rayOrigin, math::Vector3 rayDirection, f32 tmax, f32* hitDistance, math::Vector3* hitPoint
+) {
+	refreshVoxelSpatialIndex(index, voxelArray, jobQueue);
+	i32 hitVoxelIndex = -1;
+	*hitDistance = tmax;
+	i32 chunksCount = calculateChunksCount(voxelArray->voxelsCount);
+	//chunks are tested in order and only replace a hit that is strictly further, so this hits the same voxel as pickVoxel
+	for (i32 c = 0; c < chunksCount; c++) {
+		AABB bounds = index->chunkBounds[c];
+		f32 t;
+		math::Vector3 q;
+		if (isAABBEmpty(bounds) || !isRayIntersectingAABB(rayOrigin, rayDirection, bounds, *hitDistance, &t, &q)) {
+			continue;
+		}
+		VoxelSpan span = { c * VOXELS_PER_CHUNK, MIN((c + 1) * VOXELS_PER_CHUNK, voxelArray->voxelsCount) };
+		f32 chunkHitDistance;
+		math::Vector3 chunkHitPoint;
+		i32 hit = pickVoxelInSpan(voxelArray, span, rayOrigin, rayDirection, *hitDistance, &chunkHitDistance, &chunkHitPoint);
+		if (hit >= 0) {
+			hitVoxelIndex = hit;
+			*hitDistance = chunkHitDistance;
+			*hitPoint = chunkHitPoint;
+		}
+	}
+	return hitVoxelIndex;
+}
+
+static void markVoxelSelectionChunkChanged(VoxelSelection* selection, i32 chunkIndex) {
+	selection->changedChunksBegin = MIN(selection->changedChunksBegin, chunkIndex);
+	selection->changedChunksEnd = MAX(selection->changedChunksEnd, chunkIndex + 1);
+}
+
+static void clearVoxelSelectionChunk(VoxelSelection* selection, i32 chunkIndex) {
+	if (selection->chunkSelectedCounts[chunkIndex] == 0) {
+		return;
+	}
+	memset(&selection->bits[chunkIndex * VOXEL_SELECTION_WORDS_PER_CHUNK], 0, VOXEL_SELECTION_WORDS_PER_CHUNK * sizeof(u64));
+	selection->selectedCount -= selection->chunkSelectedCounts[chunkIndex];
+	selection->chunkSelectedCounts[chunkIndex] = 0;
+	markVoxelSelectionChunkChanged(selection, chunkIndex);
+}
+
+void initVoxelSelection(VoxelSelection* selection, MemoryAllocator* memoryAllocator, VoxelArray* voxelArray) {
+	selection->chunksCapacity = voxelArray->chunksCapacity;
+	selection->bits = (u64*) allocateMemory(memoryAllocator, selection->chunksCapacity * VOXEL_SELECTION_WORDS_PER_CHUNK * sizeof(u64));
+	memset(selection->bits, 0, selection->chunksCapacity * VOXEL_SELECTION_WORDS_PER_CHUNK * sizeof(u64));
+	selection->chunkSelectedCounts = (i32*) allocateMemory(memoryAllocator, selection->chunksCapacity * sizeof(i32));
+	memset(selection->chunkSelectedCounts, 0, selection->chunksCapacity * sizeof(i32));
+	selection->selectedCount = 0;
+	selection->changedChunksBegin = selection->chunksCapacity;
+	selection->changedChunksEnd = 0;
+}
+
+void clearVoxelSelection(VoxelSelection* selection) {
+	for (i32 c = 0; c < selection->chunksCapacity; c++) {
+		clearVoxelSelectionChunk(selection, c);
+	}
+	selection->selectedCount = 0;
+}
+
+bool32 isVoxelSelected(VoxelSelection* selection, i32 voxelIndex) {
+	return (selection->bits[voxelIndex / 64] >> (voxelIndex % 64)) & 1;
+}
+
+void setVoxelSelected(VoxelSelection* selection, i32 voxelIndex, bool32 isSelected) {
+	if (isVoxelSelected(selection, voxelIndex) == (isSelected != 0)) {
+		return;
+	}
+	i32 chunkIndex = voxelIndex / VOXELS_PER_CHUNK;
+	i32 change = isSelected ? 1 : -1;
+	selection->bits[voxelIndex / 64] ^= (u64)1 << (voxelIndex % 64);
+	selection->chunkSelectedCounts[chunkIndex] += change;
+	selection->selectedCount += change;
+	markVoxelSelectionChunkChanged(selection, chunkIndex);
+}
+
+void trimVoxelSelection(VoxelSelection* selection, i32 voxelsCount) {
+	for (i32 c = voxelsCount / VOXELS_PER_CHUNK; c < selection->chunksCapacity; c++) {
+		if (selection->chunkSelectedCounts[c] == 0) {
+			continue;
+		}
+		u64* words = &selection->bits[c * VOXEL_SELECTION_WORDS_PER_CHUNK];
+		i32 count = 0;
+		for (i32 w = 0; w < VOXEL_SELECTION_WORDS_PER_CHUNK; w++) {
+			i32 wordBegin = c * VOXELS_PER_CHUNK + 64 * w;
+			if (wordBegin >= voxelsCount) {
+				words[w] = 0;
+			} else if (voxelsCount - wordBegin < 64) {
+				words[w] &= ((u64)1 << (voxelsCount - wordBegin)) - 1;
+			}
+			count += countSetBits(words[w]);
+		}
+		selection->selectedCount += count - selection->chunkSelectedCounts[c];
+		selection->chunkSelectedCounts[c] = count;
+		markVoxelSelectionChunkChanged(selection, c);
+	}
+}
+
+bool32 collectVoxelSelectionChanges(VoxelSelection* selection, VoxelSpan* span) {
+	if (selection->changedChunksBegin >= selection->changedChunksEnd) {
+		return 0;
+	}
+	span->begin = selection->changedChunksBegin * VOXELS_PER_CHUNK;
+	span->end = selection->changedChunksEnd * VOXELS_PER_CHUNK;
+	selection->changedChunksBegin = selection->chunksCapacity;
+	selection->changedChunksEnd = 0;
+	return 1;
+}
+
+struct VoxelSelectionQuery {
+	VoxelSelection* selection;
+	VoxelArray* voxelArray;
+	VoxelSelectionQueryShape shape;
+	VoxelSelectionMode mode;
+	AABB box;
+	//also the culling frustum of a lasso, from the bounding rectangle of its points
+	Frustum frustum;
+	//the rows of the view projection that give clip space x, y and w
+	math::Vector4 clipX;
+	math::Vector4 clipY;
+	math::Vector4 clipW;
+	const math::Vector2* points;
+	i32 pointsCount;
+	const u8* isGroupMarked;
+};
+
+struct VoxelSelectionChunkJob {
+	VoxelSelectionQuery* query;
+	i32 chunkIndex;
+	//every loaded voxel of the chunk matches, so none of them are tested
+	bool32 isChunkInside;
+};
+
+//even-odd rule, so a lasso that crosses itself leaves the overlap out
+static bool32 isPointInPolygon(const math::Vector2* points, i32 pointsCount, f32 x, f32 y) {
+	bool32 isInside = 0;
+	for (i32 i = 0, j = pointsCount - 1; i < pointsCount; j = i, i++) {
+		math::Vector2 a = points[i];
+		math::Vector2 b = points[j];
+		if ((a.y > y) != (b.y > y) && x < (b.x - a.x) * (y - a.y) / (b.y - a.y) + a.x) {
+			isInside = !isInside;
+		}
+	}
+	return isInside;
+}
+
+static bool32 isPointInFrustum(Frustum* frustum, math::Vector3 p) {
+	for (i32 i = 0; i < 6; i++) {
+		math::Vector4 plane = frustum->planes[i];
+		if (plane.x * p.x + plane.y * p.y + plane.z * p.z + plane.w < 0.0f) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static bool32 isVoxelInQuery(VoxelSelectionQuery* query, i32 voxelIndex, VoxelGroupTransform* transform) {
+	VoxelArray* voxelArray = query->voxelArray;
+	if (query->shape == VOXEL_SELECTION_QUERY_GROUPS) {
+		i32 groupIndex = voxelArray->voxelsGroupIndex[voxelIndex];
+		return groupIndex >= 0 && query->isGroupMarked[groupIndex];
+	}
+	math::Vector3 c = calculateVoxelWorldCenter(voxelArray, voxelIndex, transform);
+	if (query->shape == VOXEL_SELECTION_QUERY_BOX) {
+		AABB box = query->box;
+		return
+			c.x >= box.min.x && c.x <= box.max.x && c.y >= box.min.y && c.y <= box.max.y &&
+			c.z >= box.min.z && c.z <= box.max.z;
+	}
+	if (!isPointInFrustum(&query->frustum, c)) {
+		return 0;
+	}
+	if (query->shape == VOXEL_SELECTION_QUERY_FRUSTUM) {
+		return 1;
+	}
+	//in front of the near plane, so w is above 0
+	math::Vector4 x = query->clipX;
+	math::Vector4 y = query->clipY;
+	math::Vector4 w = query->clipW;
+	f32 clipW = w.x * c.x + w.y * c.y + w.z * c.z + w.w;
+	f32 ndcX = (x.x * c.x + x.y * c.y + x.z * c.z + x.w) / clipW;
+	f32 ndcY = (y.x * c.x + y.y * c.y + y.z * c.z + y.w) / clipW;
+	return isPointInPolygon(query->points, query->pointsCount, ndcX, ndcY);
+}
+
+static void selectVoxelSelectionChunk(void* data) {
+	VoxelSelectionChunkJob* job = (VoxelSelectionChunkJob*)data;
+	VoxelSelectionQuery* query = job->query;
+	VoxelArray* voxelArray = query->voxelArray;
+	VoxelSelection* selection = query->selection;
+	i32 chunkBegin = job->chunkIndex * VOXELS_PER_CHUNK;
+	i32 chunkEnd = MIN(chunkBegin + VOXELS_PER_CHUNK, voxelArray->voxelsCount);
+	VoxelGroupTransform transform;
+	transform.groupIndex = NO_VOXEL_GROUP_TRANSFORM;
+	u64 matched[VOXEL_SELECTION_WORDS_PER_CHUNK] = {};
+	for (i32 i = chunkBegin; i < chunkEnd; i++) {
+		if (voxelArray->voxelsScale[i].x == 0) {
+			continue;
+		}
+		u64 isMatched = job->isChunkInside || isVoxelInQuery(query, i, &transform);
+		matched[(i - chunkBegin) / 64] |= isMatched << ((i - chunkBegin) % 64);
+	}
+	//only this job writes the chunk's words
+	u64* words = &selection->bits[job->chunkIndex * VOXEL_SELECTION_WORDS_PER_CHUNK];
+	i32 count = 0;
+	for (i32 w = 0; w < VOXEL_SELECTION_WORDS_PER_CHUNK; w++) {
+		if (query->mode == VOXEL_SELECTION_REPLACE) {
+			words[w] = matched[w];
+		} else if (query->mode == VOXEL_SELECTION_ADD) {
+			words[w] |= matched[w];
+		} else {
+			words[w] &= ~matched[w];
+		}
+		count += countSetBits(words[w]);
+	}
+	selection->chunkSelectedCounts[job->chunkIndex] = count;
+}
+
+//runs the query on every chunk whose bounds it reaches. isChunkReached may be nil, which reaches every chunk
+static i32 runVoxelSelectionQuery(VoxelSelectionQuery* query, VoxelSpatialIndex* index, JobQueue* jobQueue, const u8* isChunkReached) {
+	VoxelSelection* selection = query->selection;
+	VoxelArray* voxelArray = query->voxelArray;
+	_assert(selection->chunksCapacity == voxelArray->chunksCapacity);
+	if (index != nil) {
+		refreshVoxelSpatialIndex(index, voxelArray, jobQueue);
+	}
+	i32 chunksCount = calculateChunksCount(voxelArray->voxelsCount);
+	VoxelSelectionChunkJob* jobs = (VoxelSelectionChunkJob*) malloc(MAX(chunksCount, 1) * sizeof(VoxelSelectionChunkJob));
+	_assert(jobs != nil);
+	i32 jobsCount = 0;
+	for (i32 c = 0; c < selection->chunksCapacity; c++) {
+		bool32 isReached = c < chunksCount;
+		bool32 isChunkInside = 0;
+		if (isReached && isChunkReached != nil) {
+			isReached = isChunkReached[c];
+		}
+		if (isReached && index != nil) {
+			AABB bounds = index->chunkBounds[c];
+			if (isAABBEmpty(bounds)) {
+				isReached = 0;
+			} else if (query->shape == VOXEL_SELECTION_QUERY_BOX) {
+				isReached = isAABBOverlappingAABB(bounds, query->box);
+				isChunkInside = isAABBInsideAABB(bounds, query->box);
+			} else {
+				isReached = isAABBIntersectingFrustum(&query->frustum, bounds);
+				isChunkInside = query->shape == VOXEL_SELECTION_QUERY_FRUSTUM && isAABBInsideFrustum(&query->frustum, bounds);
+			}
+		}
+		if (!isReached) {
+			if (query->mode == VOXEL_SELECTION_REPLACE) {
+				clearVoxelSelectionChunk(selection, c);
+			}
+			continue;
+		}
+		VoxelSelectionChunkJob* job = &jobs[jobsCount];
+		job->query = query;
+		job->chunkIndex = c;
+		job->isChunkInside = isChunkInside;
+		jobsCount += 1;
+	}
+	for (i32 i = 0; i < jobsCount; i++) {
+		addJob(jobQueue, selectVoxelSelectionChunk, &jobs[i]);
+	}
+	waitForAllJobs(jobQueue);
+	for (i32 i = 0; i < jobsCount; i++) {
+		markVoxelSelectionChunkChanged(selection, jobs[i].chunkIndex);
+	}
+	free(jobs);
+	selection->selectedCount = 0;
+	for (i32 c = 0; c < selection->chunksCapacity; c++) {
+		selection->selectedCount += selection->chunkSelectedCounts[c];
+	}
+	return selection->selectedCount;
+}
+
+static void initVoxelSelectionQuery(VoxelSelectionQuery* query, VoxelSelection* selection, VoxelArray* voxelArray, VoxelSelectionQueryShape shape, VoxelSelectionMode mode) {
+	*query = {};
+	query->selection = selection;
+	query->voxelArray = voxelArray;
+	query->shape = shape;
+	query->mode = mode;
+}
+
+i32 selectVoxelsInBox(VoxelSelection* selection, VoxelSpatialIndex* index, VoxelArray* voxelArray, JobQueue* jobQueue, AABB box, VoxelSelectionMode mode) {
+	VoxelSelectionQuery query;
+	initVoxelSelectionQuery(&query, selection, voxelArray, VOXEL_SELECTION_QUERY_BOX, mode);
+	query.box = box;
+	return runVoxelSelectionQuery(&query, index, jobQueue, nil);
+}
+
+i32 selectVoxelsInFrustum(VoxelSelection* selection, VoxelSpatialIndex* index, VoxelArray* voxelArray, JobQueue* jobQueue, Frustum* frustum, VoxelSelectionMode mode) {
+	VoxelSelectionQuery query;
+	initVoxelSelectionQuery(&query, selection, voxelArray, VOXEL_SELECTION_QUERY_FRUSTUM, mode);
+	query.frustum = *frustum;
+	return runVoxelSelectionQuery(&query, index, jobQueue, nil);
+}
+
+i32 selectVoxelsInLasso(
+	VoxelSelection* selection, VoxelSpatialIndex* index, VoxelArray* voxelArray, JobQueue* jobQueue, math::Matrix4 viewProjection,
+	const math::Vector2* points, i32 pointsCount, VoxelSelectionMode mode
+) {
+	_assert(pointsCount <= MAX_LASSO_POINTS);
+	if (pointsCount < 3) {
+		if (mode == VOXEL_SELECTION_REPLACE) {
+			clearVoxelSelection(selection);
+		}
+		return selection->selectedCount;
+	}
+	math::Vector2 min = points[0];
+	math::Vector2 max = points[0];
+	for (i32 i = 1; i < pointsCount; i++) {
+		min.x = fminf(min.x, points[i].x);
+		min.y = fminf(min.y, points[i].y);
+		max.x = fmaxf(max.x, points[i].x);
+		max.y = fmaxf(max.y, points[i].y);
+	}
+	VoxelSelectionQuery query;
+	initVoxelSelectionQuery(&query, selection, voxelArray, VOXEL_SELECTION_QUERY_LASSO, mode);
+	query.frustum = extractScreenRectFrustum(viewProjection, min.x, min.y, max.x, max.y);
+	math::Matrix4 m = viewProjection;
+	query.clipX = math::Vector4{ m.e.m00, m.e.m01, m.e.m02, m.e.m03 };
+	query.clipY = math::Vector4{ m.e.m10, m.e.m11, m.e.m12, m.e.m13 };
+	query.clipW = math::Vector4{ m.e.m30, m.e.m31, m.e.m32, m.e.m33 };
+	query.points = points;
+	query.pointsCount = pointsCount;
+	return runVoxelSelectionQuery(&query, index, jobQueue, nil);
+}
+
+//the caller frees it
+static u8* markSelectedVoxelGroups(VoxelSelection* selection, VoxelArray* voxelArray) {
+	u8* isGroupMarked = (u8*) malloc(MAX(voxelArray->groupsCount, 1));
+	_assert(isGroupMarked != nil);
+	memset(isGroupMarked, 0, voxelArray->groupsCount);
+	i32 chunksCount = MIN(calculateChunksCount(voxelArray->voxelsCount), selection->chunksCapacity);
+	for (i32 c = 0; c < chunksCount; c++) {
+		if (selection->chunkSelectedCounts[c] == 0) {
+			continue;
+		}
+		for (i32 w = 0; w < VOXEL_SELECTION_WORDS_PER_CHUNK; w++) {
+			u64 word = selection->bits[c * VOXEL_SELECTION_WORDS_PER_CHUNK + w];
+			for (i32 i = 0; word != 0 && i < 64; i++) {
+				i32 v = c * VOXELS_PER_CHUNK + 64 * w + i;
+				if (((word >> i) & 1) && v < voxelArray->voxelsCount && voxelArray->voxelsGroupIndex[v] >= 0) {
+					isGroupMarked[voxelArray->voxelsGroupIndex[v]] = 1;
+				}
+			}
+		}
+	}
+	return isGroupMarked;
+}
+
+i32 selectVoxelGroupsOfSelection(VoxelSelection* selection, VoxelArray* voxelArray, JobQueue* jobQueue) {
+	u8* isGroupMarked = markSelectedVoxelGroups(selection, voxelArray);
+	//only the chunks the marked groups span are visited
+	u8* isChunkReached = (u8*) malloc(selection->chunksCapacity);
+	_assert(isChunkReached != nil);
+	memset(isChunkReached, 0, selection->chunksCapacity);
+	for (i32 g = 0; g < voxelArray->groupsCount; g++) {
+		VoxelGroup* group = &voxelArray->groups[g];
+		if (!isGroupMarked[g] || group->voxelsBegin >= group->voxelsEnd) {
+			continue;
+		}
+		for (i32 c = group->voxelsBegin / VOXELS_PER_CHUNK; c <= (group->voxelsEnd - 1) / VOXELS_PER_CHUNK; c++) {
+			isChunkReached[c] = 1;
+		}
+	}
+	VoxelSelectionQuery query;
+	initVoxelSelectionQuery(&query, selection, voxelArray, VOXEL_SELECTION_QUERY_GROUPS, VOXEL_SELECTION_ADD);
+	query.isGroupMarked = isGroupMarked;
+	i32 selectedCount = runVoxelSelectionQuery(&query, nil, jobQueue, isChunkReached);
+	free(isChunkReached);
+	free(isGroupMarked);
+	return selectedCount;
+}
+
+struct VoxelSelectionWriteJob {
+	VoxelSelection* selection;
+	VoxelArray* voxelArray;
+	i32 chunkIndex;
+	RGBAColorF32 color;
+	Vector3i offset;
+};
+
+static void recolorVoxelSelectionChunk(void* data) {
+	VoxelSelectionWriteJob* job = (VoxelSelectionWriteJob*)data;
+	u64* words = &job->selection->bits[job->chunkIndex * VOXEL_SELECTION_WORDS_PER_CHUNK];
+	i32 chunkBegin = job->chunkIndex * VOXELS_PER_CHUNK;
+	RGBAColorF32* colors = &job->voxelArray->colors[chunkBegin];
+	for (i32 w = 0; w < VOXEL_SELECTION_WORDS_PER_CHUNK; w++) {
+		u64 word = words[w];
+		for (i32 i = 0; word != 0 && i < 64; i++) {
+			if ((word >> i) & 1) {
+				colors[64 * w + i] = job->color;
+			}
+		}
+	}
+}
+
+static void translateVoxelSelectionChunk(void* data) {
+	VoxelSelectionWriteJob* job = (VoxelSelectionWriteJob*)data;
+	u64* words = &job->selection->bits[job->chunkIndex * VOXEL_SELECTION_WORDS_PER_CHUNK];
+	i32 chunkBegin = job->chunkIndex * VOXELS_PER_CHUNK;
+	Vector3i* positions = &job->voxelArray->voxelsPosition[chunkBegin];
+	Vector3i offset = job->offset;
+	for (i32 w = 0; w < VOXEL_SELECTION_WORDS_PER_CHUNK; w++) {
+		u64 word = words[w];
+		for (i32 i = 0; word != 0 && i < 64; i++) {
+			if ((word >> i) & 1) {
+				Vector3i* p = &positions[64 * w + i];
+				*p = Vector3i{ p->x + offset.x, p->y + offset.y, p->z + offset.z };
+			}
+		}
+	}
+}
+
+//voxels of world chunks that were unloaded since they were selected have no size anymore, and their colors and positions may be gone
+static void deselectUnsizedVoxels(VoxelSelection* selection, VoxelArray* voxelArray, i32 chunkIndex) {
+	u64* words = &selection->bits[chunkIndex * VOXEL_SELECTION_WORDS_PER_CHUNK];
+	Vector3ui* scales = &voxelArray->voxelsScale[chunkIndex * VOXELS_PER_CHUNK];
+	i32 count = 0;
+	for (i32 w = 0; w < VOXEL_SELECTION_WORDS_PER_CHUNK; w++) {
+		u64 word = words[w];
+		for (i32 i = 0; word != 0 && i < 64; i++) {
+			if (((word >> i) & 1) && scales[64 * w + i].x == 0) {
+				words[w] &= ~((u64)1 << i);
+			}
+		}
+		count += countSetBits(words[w]);
+	}
+	if (count != selection->chunkSelectedCounts[chunkIndex]) {
+		selection->selectedCount += count - selection->chunkSelectedCounts[chunkIndex];
+		selection->chunkSelectedCounts[chunkIndex] = count;
+		markVoxelSelectionChunkChanged(selection, chunkIndex);
+	}
+}
+
+//consecutive chunks with selected voxels are recorded, copied for a running save and marked dirty as one span, before any of them is written.
+//returns one job per chunk with selected voxels, which the caller frees
+static VoxelSelectionWriteJob* prepareVoxelSelectionWrite(VoxelSelection* selection, VoxelArray* voxelArray, EditJournal* journal, i32* jobsCount) {
+	trimVoxelSelection(selection, voxelArray->voxelsCount);
+	i32 chunksCount = calculateChunksCount(voxelArray->voxelsCount);
+	for (i32 c = 0; c < chunksCount; c++) {
+		if (selection->chunkSelectedCounts[c] > 0) {
+			deselectUnsizedVoxels(selection, voxelArray, c);
+		}
+	}
+	VoxelSelectionWriteJob* jobs = (VoxelSelectionWriteJob*) malloc(MAX(chunksCount, 1) * sizeof(VoxelSelectionWriteJob));
+	_assert(jobs != nil);
+	*jobsCount = 0;
+	for (i32 c = 0; c < chunksCount;) {
+		if (selection->chunkSelectedCounts[c] == 0) {
+			c += 1;
+			continue;
+		}
+		VoxelSpan span = { c * VOXELS_PER_CHUNK, 0 };
+		while (c < chunksCount && selection->chunkSelectedCounts[c] > 0) {
+			VoxelSelectionWriteJob* job = &jobs[*jobsCount];
+			*job = {};
+			job->selection = selection;
+			job->voxelArray = voxelArray;
+			job->chunkIndex = c;
+			*jobsCount += 1;
+			c += 1;
+		}
+		span.end = MIN(c * VOXELS_PER_CHUNK, voxelArray->voxelsCount);
+		if (journal != nil) {
+			recordVoxelSpanEdit(journal, voxelArray, span);
+		}
+		prepareVoxelSpanWrite(voxelArray, span);
+		markVoxelSpanDirty(voxelArray, span);
+	}
+	return jobs;
+}
+
+void recolorVoxelSelection(VoxelSelection* selection, VoxelArray* voxelArray, JobQueue* jobQueue, EditJournal* journal, RGBAColorF32 color) {
+	i32 jobsCount;
+	VoxelSelectionWriteJob* jobs = prepareVoxelSelectionWrite(selection, voxelArray, journal, &jobsCount);
+	for (i32 i = 0; i < jobsCount; i++) {
+		jobs[i].color = color;
+		addJob(jobQueue, recolorVoxelSelectionChunk, &jobs[i]);
+	}
+	waitForAllJobs(jobQueue);
+	free(jobs);
+}
+
+void translateVoxelSelection(VoxelSelection* selection, VoxelArray* voxelArray, JobQueue* jobQueue, EditJournal* journal, Vector3i offset) {
+	i32 jobsCount;
+	VoxelSelectionWriteJob* jobs = prepareVoxelSelectionWrite(selection, voxelArray, journal, &jobsCount);
+	for (i32 i = 0; i < jobsCount; i++) {
+		jobs[i].offset = offset;
+		addJob(jobQueue, translateVoxelSelectionChunk, &jobs[i]);
+	}
+	waitForAllJobs(jobQueue);
+	free(jobs);
+}
+
+void moveVoxelSelectionGroups(VoxelSelection* selection, VoxelArray* voxelArray, EditJournal* journal, math::Vector3 offset) {
+	u8* isGroupMarked = markSelectedVoxelGroups(selection, voxelArray);
+	for (i32 g = 0; g < voxelArray->groupsCount; g++) {
+		if (!isGroupMarked[g]) {
+			continue;
+		}
+		if (journal != nil) {
+			recordVoxelGroupEdit(journal, voxelArray, g);
+		}
+		voxelArray->groups[g].position = voxelArray->groups[g].position.add(offset);
+		markVoxelGroupDirty(voxelArray, g);
+	}
+	free(isGroupMarked);
+}
@@ -0,0 +1,86 @@
+#pragma once
+#ifndef VOXELS_GAME_VOXEL_SELECTION_H
+#define VOXELS_GAME_VOXEL_SELECTION_H
+
+#include "common.h"
+#include "math.h"
+#include "memory.h"
+#include "collision.h"
+#include "voxel.h"
+#include "jobs.h"
+#include "edit_journal.h"
+
+/*
+	the spatial index keeps the world space bounds of every chunk of voxels, so queries only test the voxels of the chunks they reach.
+	bounds go stale when their voxels or groups change, and are recomputed on the job queue by the next query.
+	a selection is a bit per voxel, kept as one bitset per chunk with a count of its selected voxels, so chunks without any are skipped.
+	queries test a voxel's center, and never select the voxels of world chunks that aren't loaded. voxels whose chunk is unloaded after
+	they were selected are deselected by the next batch edit, before it writes anything
+*/
+
+struct VoxelSpatialIndex {
+	i32 chunksCapacity;
+	//in world units, with the voxels' groups' transforms. empty chunks have min above max
+	AABB* chunkBounds;
+	u8* isChunkStale;
+	//the voxels count of the last refresh. chunks of voxels added or dropped since then are stale too
+	i32 voxelsCount;
+};
+
+typedef u32 VoxelSelectionMode;
+const VoxelSelectionMode VOXEL_SELECTION_REPLACE = 0;
+const VoxelSelectionMode VOXEL_SELECTION_ADD = 1;
+const VoxelSelectionMode VOXEL_SELECTION_REMOVE = 2;
+
+const i32 VOXEL_SELECTION_WORDS_PER_CHUNK = VOXELS_PER_CHUNK / 64;
+const i32 MAX_LASSO_POINTS = 512;
+
+struct VoxelSelection {
+	i32 chunksCapacity;
+	//bit i of word w of a chunk's words is voxel chunkIndex * VOXELS_PER_CHUNK + 64 * w + i
+	u64* bits;
+	i32* chunkSelectedCounts;
+	i32 selectedCount;
+	//the chunks whose bits may have changed since the last collectVoxelSelectionChanges, for redrawing the selection. [begin, end)
+	i32 changedChunksBegin;
+	i32 changedChunksEnd;
+};
+
+void initVoxelSpatialIndex(VoxelSpatialIndex* index, MemoryAllocator* memoryAllocator, VoxelArray* voxelArray);
+//call with the spans collectDirtyVoxelSpans wrote. voxels that are still dirty in the voxel array are found by the next query on its own
+void markVoxelSpatialIndexStale(VoxelSpatialIndex* index, const VoxelSpan* spans, i32 spansCount);
+void refreshVoxelSpatialIndex(VoxelSpatialIndex* index, VoxelArray* voxelArray, JobQueue* jobQueue);
+//the same as pickVoxel, only testing the voxels of the chunks the ray reaches
+i32 pickVoxelInIndex(
+	VoxelSpatialIndex* index, VoxelArray* voxelArray, JobQueue* jobQueue, math::Vector3 rayOrigin, math::Vector3 rayDirection, f32 tmax, f32* hitDistance, math::Vector3* hitPoint
+);
+
+void initVoxelSelection(VoxelSelection* selection, MemoryAllocator* memoryAllocator, VoxelArray* voxelArray);
+void clearVoxelSelection(VoxelSelection* selection);
+bool32 isVoxelSelected(VoxelSelection* selection, i32 voxelIndex);
+void setVoxelSelected(VoxelSelection* selection, i32 voxelIndex, bool32 isSelected);
+//drops the bits of voxels at or past voxelsCount, after an undo removed them
+void trimVoxelSelection(VoxelSelection* selection, i32 voxelsCount);
+//writes the voxels of the chunks whose bits changed since the last call, and forgets them. returns 0 if none did
+bool32 collectVoxelSelectionChanges(VoxelSelection* selection, VoxelSpan* span);
+
+//the queries return the amount of voxels selected afterwards
+//voxels whose center is in the box, in world units
+i32 selectVoxelsInBox(VoxelSelection* selection, VoxelSpatialIndex* index, VoxelArray* voxelArray, JobQueue* jobQueue, AABB box, VoxelSelectionMode mode);
+i32 selectVoxelsInFrustum(VoxelSelection* selection, VoxelSpatialIndex* index, VoxelArray* voxelArray, JobQueue* jobQueue, Frustum* frustum, VoxelSelectionMode mode);
+//voxels whose center projects inside the polygon, in normalized device coordinates, and are in front of the camera
+i32 selectVoxelsInLasso(
+	VoxelSelection* selection, VoxelSpatialIndex* index, VoxelArray* voxelArray, JobQueue* jobQueue, math::Matrix4 viewProjection,
+	const math::Vector2* points, i32 pointsCount, VoxelSelectionMode mode
+);
+//selects every voxel of the groups that have a selected voxel
+i32 selectVoxelGroupsOfSelection(VoxelSelection* selection, VoxelArray* voxelArray, JobQueue* jobQueue);
+
+//the journal may be nil for all of them
+void recolorVoxelSelection(VoxelSelection* selection, VoxelArray* voxelArray, JobQueue* jobQueue, EditJournal* journal, RGBAColorF32 color);
+//moves the selected voxels within their groups, in voxel units of each group's space
+void translateVoxelSelection(VoxelSelection* selection, VoxelArray* voxelArray, JobQueue* jobQueue, EditJournal* journal, Vector3i offset);
+//moves the groups that have a selected voxel, in voxel units
+void moveVoxelSelectionGroups(VoxelSelection* selection, VoxelArray* voxelArray, EditJournal* journal, math::Vector3 offset);
+
+#endif
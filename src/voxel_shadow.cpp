@@ -0,0 +1,186 @@
+#include "voxel_shadow.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+const i32 MAX_VOXEL_SHADOW_JOBS = 16;
+//fewer chunks than this per job aren't worth splitting
+const i32 MIN_VOXEL_SHADOW_JOB_CHUNKS = 4;
+//how far inside of the surface the march starts, in cells. just enough to be in the voxel's layer of cells when the face is on its edge
+const f32 VOXEL_SHADOW_SURFACE_OFFSET = 0.05f;
+
+struct VoxelShadowJob {
+	VoxelShadow* shadow;
+	const u16* solidCounts;
+	//indices into the shadow's stale chunks. [begin, end)
+	i32 begin;
+	i32 end;
+};
+
+static void rebuildVoxelShadowChunks(void* data) {
+	VoxelShadowJob* job = (VoxelShadowJob*)data;
+	VoxelShadow* shadow = job->shadow;
+	for (i32 i = job->begin; i < job->end; i++) {
+		i32 chunk = shadow->staleChunks[i];
+		const u16* counts = &job->solidCounts[chunk * VOXEL_LIGHT_CHUNK_CELLS];
+		u32* words = &shadow->occupancy[chunk * VOXEL_SHADOW_CHUNK_WORDS];
+		for (i32 w = 0; w < VOXEL_SHADOW_CHUNK_WORDS; w++) {
+			u32 word = 0;
+			for (u32 b = 0; b < 32; b++) {
+				word |= (u32)(counts[b] > 0) << b;
+			}
+			words[w] = word;
+			counts += 32;
+		}
+	}
+}
+
+void initVoxelShadow(VoxelShadow* shadow, MemoryAllocator* memoryAllocator, VoxelLight* light) {
+	shadow->origin = light->origin;
+	shadow->cellSize = light->cellSize;
+	shadow->chunksDims = light->chunksDims;
+	shadow->chunksCount = light->chunksCount;
+	shadow->occupancy = (u32*) allocateMemory(memoryAllocator, shadow->chunksCount * VOXEL_SHADOW_CHUNK_WORDS * sizeof(u32));
+	memset(shadow->occupancy, 0, shadow->chunksCount * VOXEL_SHADOW_CHUNK_WORDS * sizeof(u32));
+	shadow->staleChunks = (i32*) allocateMemory(memoryAllocator, shadow->chunksCount * sizeof(i32));
+	shadow->jobs = (VoxelShadowJob*) allocateMemory(memoryAllocator, MAX_VOXEL_SHADOW_JOBS * sizeof(VoxelShadowJob));
+	shadow->changedChunksBegin = shadow->chunksCount;
+	shadow->changedChunksEnd = 0;
+	memset(light->isChunkBlockingChanged, 1, light->chunksCount);
+}
+
+void updateVoxelShadow(VoxelShadow* shadow, VoxelLight* light, JobQueue* jobQueue) {
+	_assert(shadow->chunksCount == light->chunksCount);
+	i32 staleChunksCount = 0;
+	for (i32 c = 0; c < shadow->chunksCount; c++) {
+		if (light->isChunkBlockingChanged[c]) {
+			light->isChunkBlockingChanged[c] = 0;
+			shadow->staleChunks[staleChunksCount++] = c;
+		}
+	}
+	if (staleChunksCount == 0) {
+		return;
+	}
+	shadow->changedChunksBegin = MIN(shadow->changedChunksBegin, shadow->staleChunks[0]);
+	shadow->changedChunksEnd = MAX(shadow->changedChunksEnd, shadow->staleChunks[staleChunksCount - 1] + 1);
+
+	i32 jobsCount = MAX(1, MIN(MAX_VOXEL_SHADOW_JOBS, MIN((i32)jobQueue->threadsCount + 1, staleChunksCount / MIN_VOXEL_SHADOW_JOB_CHUNKS)));
+	i32 chunksPerJob = (staleChunksCount + jobsCount - 1) / jobsCount;
+	for (i32 j = 0; j < jobsCount; j++) {
+		VoxelShadowJob* job = &shadow->jobs[j];
+		job->shadow = shadow;
+		job->solidCounts = light->solidCounts;
+		job->begin = MIN(j * chunksPerJob, staleChunksCount);
+		job->end = MIN(job->begin + chunksPerJob, staleChunksCount);
+	}
+	if (jobsCount == 1) {
+		rebuildVoxelShadowChunks(&shadow->jobs[0]);
+		return;
+	}
+	for (i32 j = 0; j < jobsCount; j++) {
+		addJob(jobQueue, rebuildVoxelShadowChunks, &shadow->jobs[j]);
+	}
+	waitForAllJobs(jobQueue);
+}
+
+bool32 collectVoxelShadowChanges(VoxelShadow* shadow, i32* chunksBegin, i32* chunksEnd) {
+	if (shadow->changedChunksBegin >= shadow->changedChunksEnd) {
+		return 0;
+	}
+	*chunksBegin = shadow->changedChunksBegin;
+	*chunksEnd = shadow->changedChunksEnd;
+	shadow->changedChunksBegin = shadow->chunksCount;
+	shadow->changedChunksEnd = 0;
+	return 1;
+}
+
+bool32 isVoxelShadowCellBlocked(VoxelShadow* shadow, i32 x, i32 y, i32 z) {
+	i32 s = VOXEL_LIGHT_CHUNK_SIZE;
+	if (x < 0 || y < 0 || z < 0 || x >= shadow->chunksDims.x * s || y >= shadow->chunksDims.y * s || z >= shadow->chunksDims.z * s) {
+		return 0;
+	}
+	u32 chunk = (u32)(((z / s) * shadow->chunksDims.y + y / s) * shadow->chunksDims.x + x / s);
+	u32 cell = chunk * VOXEL_LIGHT_CHUNK_CELLS + (u32)(((z % s) * s + y % s) * s + x % s);
+	return (shadow->occupancy[cell >> 5] >> (cell & 31)) & 1;
+}
+
+//a 3d dda, stepping into whichever cell the ray crosses into first. the cell the ray starts in isn't tested, since it's usually the
+//one the surface it starts from is in
+bool32 traceVoxelShadowRay(VoxelShadow* shadow, math::Vector3 start, math::Vector3 direction, math::Vector3 normal, i32 maxSteps) {
+	f32 dims[3] = {
+		(f32)(shadow->chunksDims.x * VOXEL_LIGHT_CHUNK_SIZE), (f32)(shadow->chunksDims.y * VOXEL_LIGHT_CHUNK_SIZE), (f32)(shadow->chunksDims.z * VOXEL_LIGHT_CHUNK_SIZE)
+	};
+	f32 tEnter = 0.0f;
+	f32 tExit = INFINITY;
+	for (i32 k = 0; k < 3; k++) {
+		if (direction.v[k] == 0.0f) {
+			if (start.v[k] < 0.0f || start.v[k] >= dims[k]) {
+				return 0;
+			}
+			continue;
+		}
+		f32 t0 = -start.v[k] / direction.v[k];
+		f32 t1 = (dims[k] - start.v[k]) / direction.v[k];
+		tEnter = MAX(tEnter, MIN(t0, t1));
+		tExit = MIN(tExit, MAX(t0, t1));
+	}
+	if (tEnter >= tExit) {
+		return 0;
+	}
+	i32 layerAxis = fabsf(normal.x) >= fabsf(normal.y) ? (fabsf(normal.x) >= fabsf(normal.z) ? 0 : 2) : (fabsf(normal.y) >= fabsf(normal.z) ? 1 : 2);
+
+	i32 cell[3];
+	i32 step[3];
+	f32 tMax[3];
+	f32 tDelta[3];
+	for (i32 k = 0; k < 3; k++) {
+		f32 p = start.v[k] + direction.v[k] * tEnter;
+		cell[k] = MIN(MAX((i32)floorf(p), 0), (i32)dims[k] - 1);
+		if (direction.v[k] > 0.0f) {
+			step[k] = 1;
+			tMax[k] = tEnter + ((f32)(cell[k] + 1) - p) / direction.v[k];
+			tDelta[k] = 1.0f / direction.v[k];
+		} else if (direction.v[k] < 0.0f) {
+			step[k] = -1;
+			tMax[k] = tEnter + ((f32)cell[k] - p) / direction.v[k];
+			tDelta[k] = -1.0f / direction.v[k];
+		} else {
+			step[k] = 0;
+			tMax[k] = INFINITY;
+			tDelta[k] = INFINITY;
+		}
+	}
+	//a voxel smaller than a cell blocks the cell it's in, and the ones next to it in that layer often do too. none of them are
+	//above its surface, so they aren't tested. cells further along the layer are, since a short wall there does shadow the surface
+	bool32 isStartSkipped = tEnter <= 0.0f;
+	i32 startCell[3] = { cell[0], cell[1], cell[2] };
+	for (i32 i = 0; i < maxSteps; i++) {
+		bool32 isSkipped =
+			isStartSkipped && cell[layerAxis] == startCell[layerAxis] &&
+			abs(cell[0] - startCell[0]) <= 1 && abs(cell[1] - startCell[1]) <= 1 && abs(cell[2] - startCell[2]) <= 1;
+		if (!isSkipped && isVoxelShadowCellBlocked(shadow, cell[0], cell[1], cell[2])) {
+			return 1;
+		}
+		i32 k = tMax[0] < tMax[1] ? (tMax[0] < tMax[2] ? 0 : 2) : (tMax[1] < tMax[2] ? 1 : 2);
+		cell[k] += step[k];
+		tMax[k] += tDelta[k];
+		if (cell[k] < 0 || cell[k] >= (i32)dims[k]) {
+			return 0;
+		}
+	}
+	return 0;
+}
+
+bool32 isVoxelShadowed(VoxelShadow* shadow, math::Vector3 position, math::Vector3 normal, math::Vector3 sunDirection) {
+	if (normal.dot(sunDirection) <= 0.0f) {
+		return 1;
+	}
+	f32 cellSize = (f32)shadow->cellSize;
+	math::Vector3 start = {
+		((position.x - (f32)shadow->origin.x) / cellSize) - normal.x * VOXEL_SHADOW_SURFACE_OFFSET,
+		((position.y - (f32)shadow->origin.y) / cellSize) - normal.y * VOXEL_SHADOW_SURFACE_OFFSET,
+		((position.z - (f32)shadow->origin.z) / cellSize) - normal.z * VOXEL_SHADOW_SURFACE_OFFSET,
+	};
+	return traceVoxelShadowRay(shadow, start, sunDirection, normal, MAX_VOXEL_SHADOW_STEPS);
+}
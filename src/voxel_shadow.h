@@ -0,0 +1,65 @@
+#pragma once
+#ifndef VOXELS_GAME_VOXEL_SHADOW_H
+#define VOXELS_GAME_VOXEL_SHADOW_H
+
+#include "common.h"
+#include "memory.h"
+#include "math.h"
+#include "voxel_light.h"
+#include "jobs.h"
+
+/*
+	sun shadows, marched through a bit per cell of the light volume that's set when a voxel blocks the cell. the bits are laid out like
+	the light's cells, a chunk of 16x16x16 after the other, so a chunk is 128 words, and the bit of a cell is its index in the light's
+	cells.
+	only the chunks whose cells started or stopped being blocked are rebuilt, on the job queue, and the range of rebuilt chunks is handed
+	back so only those are uploaded.
+	the voxel shader marches the same bits, from each fragment toward the sun, one cell at a time, and the fragment is in shadow if a
+	blocked cell is in the way before the ray leaves the volume. the fragment's cell and the ones next to it in its layer, along the axis
+	it faces the most, are skipped, since the voxel and its neighbours block them even when they're smaller than a cell. the rest of the
+	layer is tested, so a surface half way up a cell can be shadowed by its own floor under a low sun. traceVoxelShadowRay is the
+	same march on the cpu, to test the bits with, and to compare the shader's result against
+*/
+
+const i32 VOXEL_SHADOW_CHUNK_WORDS = VOXEL_LIGHT_CHUNK_CELLS / 32;
+//how many cells a shadow ray goes through before it gives up. the voxel shader is given it in its push constants
+const i32 MAX_VOXEL_SHADOW_STEPS = 256;
+
+struct VoxelShadowJob;
+
+struct VoxelShadow {
+	//the light volume's, in voxel units
+	Vector3i origin;
+	i32 cellSize;
+	Vector3i chunksDims;
+	i32 chunksCount;
+	u32* occupancy;
+
+	//the chunks being rebuilt
+	i32* staleChunks;
+	VoxelShadowJob* jobs;
+	//the chunks rebuilt since the last collectVoxelShadowChanges. [begin, end)
+	i32 changedChunksBegin;
+	i32 changedChunksEnd;
+};
+
+//the shadow covers the light's volume. every chunk is built on the first update
+void initVoxelShadow(VoxelShadow* shadow, MemoryAllocator* memoryAllocator, VoxelLight* light);
+//call after updateVoxelLight. rebuilds the chunks the light's blocked cells changed in
+void updateVoxelShadow(VoxelShadow* shadow, VoxelLight* light, JobQueue* jobQueue);
+//writes the chunks rebuilt since the last call, and forgets them. returns 0 if none were. chunk c is the words
+//[c * VOXEL_SHADOW_CHUNK_WORDS, (c + 1) * VOXEL_SHADOW_CHUNK_WORDS) of the occupancy
+bool32 collectVoxelShadowChanges(VoxelShadow* shadow, i32* chunksBegin, i32* chunksEnd);
+
+//whether the cell at x, y, z of the volume is blocked. cells outside of the volume never are
+bool32 isVoxelShadowCellBlocked(VoxelShadow* shadow, i32 x, i32 y, i32 z);
+//marches from start toward direction, both in cells, with the volume's min corner at 0. returns whether it went through a blocked cell
+//before it left the volume or went through maxSteps cells. start's cell and the ones next to it in its layer along the axis normal is
+//the most along are skipped. a start outside of the volume is moved to where the ray enters it, and skips none
+bool32 traceVoxelShadowRay(VoxelShadow* shadow, math::Vector3 start, math::Vector3 direction, math::Vector3 normal, i32 maxSteps);
+//whether the point on a voxel's surface, in voxel units, is in the shadow of the sun, which is toward sunDirection. the march starts
+//a little inside of the surface, and skips the voxel's cell and the ones next to it in its layer, so a voxel doesn't shadow itself. faces turned away from the sun
+//are always in shadow
+bool32 isVoxelShadowed(VoxelShadow* shadow, math::Vector3 position, math::Vector3 normal, math::Vector3 sunDirection);
+
+#endif
@@ -0,0 +1,416 @@
+#include "voxel_tracer.h"
+
+#include "platform.h"
+
+#include <float.h>
+#include <math.h>
+
+//in world units. further than anything in the world
+const f32 VOXEL_TRACER_MAX_DISTANCE = 100000.0f;
+//how far off a voxel's face the rays that leave it start, in world units, so they don't hit it again
+const f32 VOXEL_TRACER_SURFACE_OFFSET = 0.001f;
+//no group has this index, not even -1 for standalone voxels
+const i32 NO_VOXEL_TRACER_GROUP = -2;
+
+struct VoxelTracerContext {
+	VoxelTracer* tracer;
+	VoxelTracerConfig* config;
+	math::Matrix4 inverseView;
+	math::Matrix4 inverseProjection;
+	math::Vector3 cameraPosition;
+	u8* pixels;
+	u32 tilesX;
+	u32 tilesCount;
+	//the tiles taken by the jobs so far
+	volatile u32 takenTilesCount;
+};
+
+struct VoxelTracerJob {
+	VoxelTracerContext* context;
+	u64 raysCount;
+};
+
+//a ray in the space of the group of the voxels it's being tested against, in world units, so each voxel is an axis aligned box
+struct VoxelTracerGroupRay {
+	i32 groupIndex;
+	math::Quaternion rotation;
+	math::Vector3 origin;
+	math::Vector3 direction;
+	math::Vector3 inverseDirection;
+};
+
+static void loadVoxelTracerGroupRay(VoxelArray* voxelArray, i32 groupIndex, math::Vector3 origin, math::Vector3 direction, VoxelTracerGroupRay* ray) {
+	if (ray->groupIndex == groupIndex) {
+		return;
+	}
+	ray->groupIndex = groupIndex;
+	ray->rotation = math::Quaternion{ 1.0f, { 0.0f, 0.0f, 0.0f } };
+	ray->origin = origin;
+	ray->direction = direction;
+	if (groupIndex >= 0) {
+		VoxelGroup* group = &voxelArray->groups[groupIndex];
+		ray->rotation = group->rotation;
+		math::Quaternion inverse = { group->rotation.real, group->rotation.vector.scale(-1.0f) };
+		ray->origin = math::rotateVector(origin.sub(group->position.scale(voxelUnitsToWorldUnits)), inverse);
+		ray->direction = math::rotateVector(direction, inverse);
+	}
+	for (i32 k = 0; k < 3; k++) {
+		ray->inverseDirection.v[k] = ray->direction.v[k] != 0.0f ? 1.0f / ray->direction.v[k] : 0.0f;
+	}
+}
+
+//isRayIntersectingAABB treats directions within a tolerance of an axis as parallel to it, which misses far away bounds that a nearly
+//parallel ray still reaches. this one is exact
+static bool32 isVoxelTracerRayHittingBounds(math::Vector3 origin, math::Vector3 direction, math::Vector3 inverseDirection, AABB bounds, f32 tmax) {
+	if (bounds.min.x > bounds.max.x) {
+		return 0;
+	}
+	f32 tmin = 0.0f;
+	for (i32 k = 0; k < 3; k++) {
+		if (direction.v[k] == 0.0f) {
+			if (origin.v[k] < bounds.min.v[k] || origin.v[k] > bounds.max.v[k]) {
+				return 0;
+			}
+			continue;
+		}
+		f32 t1 = (bounds.min.v[k] - origin.v[k]) * inverseDirection.v[k];
+		f32 t2 = (bounds.max.v[k] - origin.v[k]) * inverseDirection.v[k];
+		tmin = fmaxf(tmin, fminf(t1, t2));
+		tmax = fminf(tmax, fmaxf(t1, t2));
+		if (tmin > tmax) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+//a slab test in the group's space. entryAxis is the axis of the face the ray entered through, or -1 if it starts inside the voxel
+static bool32 isVoxelTracerRayHittingVoxel(VoxelArray* voxelArray, i32 voxelIndex, VoxelTracerGroupRay* ray, f32 tmax, f32* tmin, i32* entryAxis) {
+	math::Vector3 center = convertVoxelUnitsToWorldUnits(voxelArray->voxelsPosition[voxelIndex]);
+	math::Vector3 halfExtents = convertVoxelUnitsToWorldUnits(voxelArray->voxelsScale[voxelIndex]).scale(0.5f);
+	f32 t0 = 0.0f;
+	*entryAxis = -1;
+	for (i32 k = 0; k < 3; k++) {
+		f32 min = center.v[k] - halfExtents.v[k];
+		f32 max = center.v[k] + halfExtents.v[k];
+		if (ray->direction.v[k] == 0.0f) {
+			if (ray->origin.v[k] < min || ray->origin.v[k] > max) {
+				return 0;
+			}
+			continue;
+		}
+		f32 t1 = (min - ray->origin.v[k]) * ray->inverseDirection.v[k];
+		f32 t2 = (max - ray->origin.v[k]) * ray->inverseDirection.v[k];
+		if (t1 > t2) {
+			f32 t3 = t1;
+			t1 = t2;
+			t2 = t3;
+		}
+		if (t1 > t0) {
+			t0 = t1;
+			*entryAxis = k;
+		}
+		tmax = fminf(tmax, t2);
+		if (t0 > tmax) {
+			return 0;
+		}
+	}
+	*tmin = t0;
+	return 1;
+}
+
+struct VoxelTracerLeavesJob {
+	VoxelTracer* tracer;
+	i32 leavesBegin;
+	i32 leavesEnd;
+};
+
+static void buildVoxelTracerLeaves(void* data) {
+	VoxelTracerLeavesJob* job = (VoxelTracerLeavesJob*)data;
+	VoxelArray* voxelArray = job->tracer->voxelArray;
+	//consecutive voxels are nearly always in the same group, so its rotation is only made again when the group changes
+	i32 groupIndex = NO_VOXEL_TRACER_GROUP;
+	math::Matrix4 rotation = math::initIdentityMatrix();
+	math::Vector3 translation = { 0.0f, 0.0f, 0.0f };
+	for (i32 l = job->leavesBegin; l < job->leavesEnd; l++) {
+		AABB bounds = {};
+		bounds.min = math::Vector3{ FLT_MAX, FLT_MAX, FLT_MAX };
+		bounds.max = math::Vector3{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		i32 end = MIN((l + 1) * VOXEL_TRACER_LEAF_SIZE, voxelArray->voxelsCount);
+		for (i32 i = l * VOXEL_TRACER_LEAF_SIZE; i < end; i++) {
+			//the voxels of world chunks that aren't loaded yet have no size
+			if (voxelArray->voxelsScale[i].x == 0) {
+				continue;
+			}
+			if (voxelArray->voxelsGroupIndex[i] != groupIndex) {
+				groupIndex = voxelArray->voxelsGroupIndex[i];
+				rotation = math::initIdentityMatrix();
+				translation = math::Vector3{ 0.0f, 0.0f, 0.0f };
+				if (groupIndex >= 0) {
+					rotation = math::createRotationMatrix(voxelArray->groups[groupIndex].rotation);
+					translation = voxelArray->groups[groupIndex].position.scale(voxelUnitsToWorldUnits);
+				}
+			}
+			math::Vector3 p = convertVoxelUnitsToWorldUnits(voxelArray->voxelsPosition[i]);
+			math::Vector3 h = convertVoxelUnitsToWorldUnits(voxelArray->voxelsScale[i]).scale(0.5f);
+			f32 r[3][3] = {
+				{ rotation.e.m00, rotation.e.m01, rotation.e.m02 },
+				{ rotation.e.m10, rotation.e.m11, rotation.e.m12 },
+				{ rotation.e.m20, rotation.e.m21, rotation.e.m22 },
+			};
+			for (i32 k = 0; k < 3; k++) {
+				f32 center = r[k][0] * p.x + r[k][1] * p.y + r[k][2] * p.z + translation.v[k];
+				f32 extent = fabsf(r[k][0]) * h.x + fabsf(r[k][1]) * h.y + fabsf(r[k][2]) * h.z;
+				bounds.min.v[k] = fminf(bounds.min.v[k], center - extent);
+				bounds.max.v[k] = fmaxf(bounds.max.v[k], center + extent);
+			}
+		}
+		job->tracer->leafBounds[l] = bounds;
+	}
+}
+
+void initVoxelTracer(VoxelTracer* tracer, MemoryAllocator* memoryAllocator, VoxelArray* voxelArray, VoxelSpatialIndex* index) {
+	tracer->voxelArray = voxelArray;
+	tracer->index = index;
+	tracer->leavesCapacity = voxelArray->chunksCapacity * VOXEL_TRACER_LEAVES_PER_CHUNK;
+	tracer->leafBounds = (AABB*) allocateMemory(memoryAllocator, tracer->leavesCapacity * sizeof(AABB));
+}
+
+void prepareVoxelTracer(VoxelTracer* tracer, JobQueue* jobQueue) {
+	refreshVoxelSpatialIndex(tracer->index, tracer->voxelArray, jobQueue);
+	i32 leavesCount = (tracer->voxelArray->voxelsCount + VOXEL_TRACER_LEAF_SIZE - 1) / VOXEL_TRACER_LEAF_SIZE;
+	_assert(leavesCount <= tracer->leavesCapacity);
+	VoxelTracerLeavesJob jobs[MAX_VOXEL_TRACER_JOBS];
+	//a chunk's worth of leaves at least per job
+	i32 jobsCount = MAX(1, MIN((i32)MIN(jobQueue->threadsCount + 1, MAX_VOXEL_TRACER_JOBS), leavesCount / VOXEL_TRACER_LEAVES_PER_CHUNK));
+	i32 leavesPerJob = (leavesCount + jobsCount - 1) / jobsCount;
+	for (i32 j = 0; j < jobsCount; j++) {
+		jobs[j].tracer = tracer;
+		jobs[j].leavesBegin = MIN(j * leavesPerJob, leavesCount);
+		jobs[j].leavesEnd = MIN(jobs[j].leavesBegin + leavesPerJob, leavesCount);
+	}
+	if (jobsCount == 1) {
+		buildVoxelTracerLeaves(&jobs[0]);
+		return;
+	}
+	for (i32 j = 0; j < jobsCount; j++) {
+		addJob(jobQueue, buildVoxelTracerLeaves, &jobs[j]);
+	}
+	waitForAllJobs(jobQueue);
+}
+
+//voxels are tested in order and only replace a hit that is strictly further, so ties go to the first voxel like in pickVoxel
+i32 traceVoxelRay(VoxelTracer* tracer, math::Vector3 origin, math::Vector3 direction, f32 tmax, f32* hitDistance, math::Vector3* normal) {
+	VoxelArray* voxelArray = tracer->voxelArray;
+	i32 hitVoxelIndex = -1;
+	*hitDistance = tmax;
+	VoxelTracerGroupRay groupRay = {};
+	groupRay.groupIndex = NO_VOXEL_TRACER_GROUP;
+	VoxelTracerGroupRay hitGroupRay = {};
+	i32 hitEntryAxis = -1;
+	math::Vector3 inverseDirection;
+	for (i32 k = 0; k < 3; k++) {
+		inverseDirection.v[k] = direction.v[k] != 0.0f ? 1.0f / direction.v[k] : 0.0f;
+	}
+	i32 chunksCount = (voxelArray->voxelsCount + VOXELS_PER_CHUNK - 1) / VOXELS_PER_CHUNK;
+	for (i32 c = 0; c < chunksCount; c++) {
+		if (!isVoxelTracerRayHittingBounds(origin, direction, inverseDirection, tracer->index->chunkBounds[c], *hitDistance)) {
+			continue;
+		}
+		i32 leavesEnd = MIN((c + 1) * VOXEL_TRACER_LEAVES_PER_CHUNK, (voxelArray->voxelsCount + VOXEL_TRACER_LEAF_SIZE - 1) / VOXEL_TRACER_LEAF_SIZE);
+		for (i32 l = c * VOXEL_TRACER_LEAVES_PER_CHUNK; l < leavesEnd; l++) {
+			if (!isVoxelTracerRayHittingBounds(origin, direction, inverseDirection, tracer->leafBounds[l], *hitDistance)) {
+				continue;
+			}
+			i32 end = MIN((l + 1) * VOXEL_TRACER_LEAF_SIZE, voxelArray->voxelsCount);
+			for (i32 i = l * VOXEL_TRACER_LEAF_SIZE; i < end; i++) {
+				//the voxels of world chunks that aren't loaded yet have no size
+				if (voxelArray->voxelsScale[i].x == 0) {
+					continue;
+				}
+				loadVoxelTracerGroupRay(voxelArray, voxelArray->voxelsGroupIndex[i], origin, direction, &groupRay);
+				f32 t;
+				i32 entryAxis;
+				if (isVoxelTracerRayHittingVoxel(voxelArray, i, &groupRay, *hitDistance, &t, &entryAxis) && t < *hitDistance) {
+					hitVoxelIndex = i;
+					*hitDistance = t;
+					hitEntryAxis = entryAxis;
+					hitGroupRay = groupRay;
+				}
+			}
+		}
+	}
+	if (hitVoxelIndex >= 0) {
+		//a ray that starts inside a voxel gets the normal facing back along it
+		math::Vector3 n = hitGroupRay.direction.scale(-1.0f);
+		if (hitEntryAxis >= 0) {
+			n = math::Vector3{ 0.0f, 0.0f, 0.0f };
+			n.v[hitEntryAxis] = hitGroupRay.direction.v[hitEntryAxis] < 0.0f ? 1.0f : -1.0f;
+		}
+		*normal = math::rotateVector(n, hitGroupRay.rotation).normalize();
+	}
+	return hitVoxelIndex;
+}
+
+//pcg's output hash, to turn the pixel into the start of its own sequence
+static u32 hashVoxelTracerSeed(u32 value) {
+	u32 state = value * 747796405u + 2891336453u;
+	u32 word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+	return (word >> 22u) ^ word;
+}
+
+//xorshift. [0, 1)
+static f32 nextVoxelTracerRandom(u32* state) {
+	u32 x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return (f32)(x >> 8) * (1.0f / 16777216.0f);
+}
+
+//cosine weighted, so a diffuse bounce's throughput is just the albedo
+static math::Vector3 sampleVoxelTracerHemisphere(math::Vector3 normal, u32* random) {
+	f32 u1 = nextVoxelTracerRandom(random);
+	f32 u2 = nextVoxelTracerRandom(random);
+	f32 r = sqrtf(u1);
+	f32 phi = TAU32 * u2;
+	math::Vector3 axis = fabsf(normal.x) > 0.9f ? math::Vector3{ 0.0f, 1.0f, 0.0f } : math::Vector3{ 1.0f, 0.0f, 0.0f };
+	math::Vector3 tangent = axis.cross(normal).normalize();
+	math::Vector3 bitangent = normal.cross(tangent);
+	return tangent.scale(r * cosf(phi)).add(bitangent.scale(r * sinf(phi))).add(normal.scale(sqrtf(fmaxf(0.0f, 1.0f - u1))));
+}
+
+static u8 convertLinearToSRGB(f32 c) {
+	c = fminf(fmaxf(c, 0.0f), 1.0f);
+	c = c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+	return (u8)(c * 255.0f + 0.5f);
+}
+
+static math::Vector3 traceVoxelPath(VoxelTracerContext* context, math::Vector3 origin, math::Vector3 direction, u32* random, u64* raysCount) {
+	VoxelTracerConfig* config = context->config;
+	math::Vector3 sun = config->sunDirection;
+	math::Vector3 radiance = { 0.0f, 0.0f, 0.0f };
+	math::Vector3 throughput = { 1.0f, 1.0f, 1.0f };
+	for (u32 bounce = 0; ; bounce++) {
+		f32 t;
+		math::Vector3 normal;
+		i32 hit = traceVoxelRay(context->tracer, origin, direction, VOXEL_TRACER_MAX_DISTANCE, &t, &normal);
+		*raysCount += 1;
+		if (hit < 0) {
+			radiance = radiance.add(math::Vector3{ throughput.x * config->skyColor.x, throughput.y * config->skyColor.y, throughput.z * config->skyColor.z });
+			break;
+		}
+		RGBAColorF32 color = context->tracer->voxelArray->colors[hit];
+		math::Vector3 albedo = { color.r, color.g, color.b };
+		math::Vector3 point = origin.add(direction.scale(t));
+		math::Vector3 surface = point.add(normal.scale(VOXEL_TRACER_SURFACE_OFFSET));
+
+		f32 cosSun = normal.dot(sun);
+		if (cosSun > 0.0f) {
+			bool32 isLit;
+			if (config->shadow != nil) {
+				isLit = !isVoxelShadowed(config->shadow, point.scale(1.0f / voxelUnitsToWorldUnits), normal, sun);
+			} else {
+				f32 sunDistance;
+				math::Vector3 sunNormal;
+				isLit = traceVoxelRay(context->tracer, surface, sun, VOXEL_TRACER_MAX_DISTANCE, &sunDistance, &sunNormal) < 0;
+				*raysCount += 1;
+			}
+			if (isLit) {
+				radiance = radiance.add(math::Vector3{
+					throughput.x * albedo.x * config->sunColor.x * cosSun,
+					throughput.y * albedo.y * config->sunColor.y * cosSun,
+					throughput.z * albedo.z * config->sunColor.z * cosSun,
+				});
+			}
+		}
+		if (bounce == config->maxBounces) {
+			break;
+		}
+		throughput = math::Vector3{ throughput.x * albedo.x, throughput.y * albedo.y, throughput.z * albedo.z };
+		origin = surface;
+		direction = sampleVoxelTracerHemisphere(normal, random);
+	}
+	return radiance;
+}
+
+static void traceVoxelTiles(void* data) {
+	VoxelTracerJob* job = (VoxelTracerJob*)data;
+	VoxelTracerContext* context = job->context;
+	VoxelTracerConfig* config = context->config;
+	while (true) {
+		u32 tile = atomicIncrementU32(&context->takenTilesCount) - 1;
+		if (tile >= context->tilesCount) {
+			return;
+		}
+		u32 beginX = (tile % context->tilesX) * VOXEL_TRACER_TILE_SIZE;
+		u32 beginY = (tile / context->tilesX) * VOXEL_TRACER_TILE_SIZE;
+		u32 endX = MIN(beginX + VOXEL_TRACER_TILE_SIZE, config->width);
+		u32 endY = MIN(beginY + VOXEL_TRACER_TILE_SIZE, config->height);
+		for (u32 y = beginY; y < endY; y++) {
+			for (u32 x = beginX; x < endX; x++) {
+				u32 pixel = y * config->width + x;
+				u32 random = hashVoxelTracerSeed(config->seed ^ hashVoxelTracerSeed(pixel)) | 1;
+				math::Vector3 sum = { 0.0f, 0.0f, 0.0f };
+				for (u32 s = 0; s < config->samplesPerPixel; s++) {
+					//one sample goes through the pixel's center, more are spread over the pixel. clip space y is up, like the cursor's in
+					//calculateRayFromScreenToWorld, and the rows are written from the top
+					f32 offsetX = config->samplesPerPixel == 1 ? 0.5f : nextVoxelTracerRandom(&random);
+					f32 offsetY = config->samplesPerPixel == 1 ? 0.5f : nextVoxelTracerRandom(&random);
+					math::Vector4 clip = { 2.0f * ((f32)x + offsetX) / (f32)config->width - 1.0f, 1.0f - 2.0f * ((f32)y + offsetY) / (f32)config->height, -1.0f, 1.0f };
+					math::Vector4 view = math::multiplyMatrixVector(context->inverseProjection, clip);
+					view = math::Vector4{ view.x, view.y, -1.0f, 0.0f };
+					math::Vector4 world = math::multiplyMatrixVector(context->inverseView, view);
+					math::Vector3 direction = math::Vector3{ world.x, world.y, world.z }.normalize();
+					sum = sum.add(traceVoxelPath(context, context->cameraPosition, direction, &random, &job->raysCount));
+				}
+				sum = sum.scale(1.0f / (f32)config->samplesPerPixel);
+				u8* out = &context->pixels[4 * pixel];
+				out[0] = convertLinearToSRGB(sum.x);
+				out[1] = convertLinearToSRGB(sum.y);
+				out[2] = convertLinearToSRGB(sum.z);
+				out[3] = 255;
+			}
+		}
+	}
+}
+
+void traceVoxelImage(
+	VoxelTracer* tracer, JobQueue* jobQueue, math::Matrix4 view, math::Matrix4 projection, VoxelTracerConfig* config, u8* pixels, VoxelTracerStats* stats
+) {
+	_assert(config->samplesPerPixel > 0);
+	f64 prepareStartSeconds = getWallClockSeconds();
+	prepareVoxelTracer(tracer, jobQueue);
+	f64 startSeconds = getWallClockSeconds();
+	stats->prepareSeconds = startSeconds - prepareStartSeconds;
+
+	VoxelTracerContext context = {};
+	context.tracer = tracer;
+	context.config = config;
+	context.inverseView = math::inverseMatrix(view);
+	context.inverseProjection = math::inverseMatrix(projection);
+	math::Vector4 cameraPosition = math::multiplyMatrixVector(context.inverseView, math::Vector4{ 0.0f, 0.0f, 0.0f, 1.0f });
+	context.cameraPosition = math::Vector3{ cameraPosition.x, cameraPosition.y, cameraPosition.z };
+	context.pixels = pixels;
+	context.tilesX = (config->width + VOXEL_TRACER_TILE_SIZE - 1) / VOXEL_TRACER_TILE_SIZE;
+	context.tilesCount = context.tilesX * ((config->height + VOXEL_TRACER_TILE_SIZE - 1) / VOXEL_TRACER_TILE_SIZE);
+	context.takenTilesCount = 0;
+
+	//the tiles aren't handed out ahead of time. each job takes the next one when it's done with its last, so slow tiles don't hold a job back
+	VoxelTracerJob jobs[MAX_VOXEL_TRACER_JOBS];
+	u32 jobsCount = MIN(MIN(jobQueue->threadsCount + 1, MAX_VOXEL_TRACER_JOBS), MAX(context.tilesCount, 1u));
+	for (u32 j = 0; j < jobsCount; j++) {
+		jobs[j].context = &context;
+		jobs[j].raysCount = 0;
+		addJob(jobQueue, traceVoxelTiles, &jobs[j]);
+	}
+	waitForAllJobs(jobQueue);
+
+	stats->raysCount = 0;
+	for (u32 j = 0; j < jobsCount; j++) {
+		stats->raysCount += jobs[j].raysCount;
+	}
+	stats->seconds = getWallClockSeconds() - startSeconds;
+	stats->raysPerSecond = stats->seconds > 0.0 ? (f64)stats->raysCount / stats->seconds : 0.0;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#ifndef VOXELS_GAME_VOXEL_TRACER_H
+#define VOXELS_GAME_VOXEL_TRACER_H
+
+#include "common.h"
+#include "math.h"
+#include "voxel.h"
+#include "voxel_selection.h"
+#include "voxel_shadow.h"
+#include "memory.h"
+#include "jobs.h"
+
+/*
+	a path tracer that renders the voxels on the cpu, for checking what the gpu draws and for golden images on machines without one.
+	rays go through the spatial index's chunk bounds, then through the bounds of each run of VOXEL_TRACER_LEAF_SIZE voxels of the chunks
+	they reach, and are only tested against the voxels of the runs they reach. the runs' bounds are the tracer's own, rebuilt on the job
+	queue before each image, since a chunk's bounds alone leave thousands of voxels to test.
+	every voxel is a diffuse box of its color, lit by the sun and a sky of one color. each sample follows a path from the camera, adding
+	the sun's light at each voxel it bounces off of, and the sky's when it leaves, for up to maxBounces bounces.
+	the image is split into tiles that the job queue's threads take one at a time. each pixel's random numbers only depend on the seed
+	and the pixel, so an image comes out the same for any amount of threads.
+	the camera is the view and projection the renderer is given, and a pixel's ray goes through its center like calculateRayFromScreenToWorld
+*/
+
+const u32 VOXEL_TRACER_TILE_SIZE = 16;
+const u32 MAX_VOXEL_TRACER_JOBS = 64;
+const i32 VOXEL_TRACER_LEAF_SIZE = 32;
+const i32 VOXEL_TRACER_LEAVES_PER_CHUNK = VOXELS_PER_CHUNK / VOXEL_TRACER_LEAF_SIZE;
+
+struct VoxelTracer {
+	VoxelArray* voxelArray;
+	VoxelSpatialIndex* index;
+	i32 leavesCapacity;
+	//in world units. leaf l is the voxels [l * VOXEL_TRACER_LEAF_SIZE, (l + 1) * VOXEL_TRACER_LEAF_SIZE). empty leaves have min above max
+	AABB* leafBounds;
+};
+
+struct VoxelTracerConfig {
+	u32 width;
+	u32 height;
+	u32 samplesPerPixel;
+	//0 only lights the voxels the camera sees directly
+	u32 maxBounces;
+	u32 seed;
+	//toward the sun
+	math::Vector3 sunDirection;
+	//linear
+	math::Vector3 sunColor;
+	math::Vector3 skyColor;
+	//when it isn't nil, the sun is blocked where the shadow volume's march says it is, like in voxel_shader.frag, instead of by the voxels
+	VoxelShadow* shadow;
+};
+
+struct VoxelTracerStats {
+	//camera, bounce and sun rays
+	u64 raysCount;
+	//tracing the tiles. prepareSeconds is the prepareVoxelTracer call before it, which raysPerSecond leaves out
+	f64 seconds;
+	f64 prepareSeconds;
+	f64 raysPerSecond;
+};
+
+//the index is shared with whatever else uses it, like picking
+void initVoxelTracer(VoxelTracer* tracer, MemoryAllocator* memoryAllocator, VoxelArray* voxelArray, VoxelSpatialIndex* index);
+//refreshes the spatial index and rebuilds the leaves' bounds. call after the voxels change, before traceVoxelRay. traceVoxelImage calls it
+void prepareVoxelTracer(VoxelTracer* tracer, JobQueue* jobQueue);
+//writes width * height srgb rgba8 pixels, top row first
+void traceVoxelImage(
+	VoxelTracer* tracer, JobQueue* jobQueue, math::Matrix4 view, math::Matrix4 projection, VoxelTracerConfig* config, u8* pixels, VoxelTracerStats* stats
+);
+//the closest voxel the ray hits before tmax, or -1. normal is the world space normal of the face that was hit.
+//safe to call from any thread while nothing changes the voxels or the tracer
+i32 traceVoxelRay(VoxelTracer* tracer, math::Vector3 origin, math::Vector3 direction, f32 tmax, f32* hitDistance, math::Vector3* normal);
+
+#endif
@@ -0,0 +1,95 @@
+#include "voxel_translucency.h"
+#include "radix_sort.h"
+
+#include <string.h>
+
+void initTranslucentVoxels(TranslucentVoxels* translucentVoxels, MemoryAllocator* memoryAllocator, i32 voxelsCapacity, i32 capacity) {
+	translucentVoxels->capacity = capacity;
+	translucentVoxels->count = 0;
+	translucentVoxels->voxelIndices = (i32*) allocateMemory(memoryAllocator, capacity * sizeof(i32));
+	translucentVoxels->instances = (TranslucentVoxelInstance*) allocateMemory(memoryAllocator, capacity * sizeof(TranslucentVoxelInstance));
+	translucentVoxels->centers = (math::Vector3*) allocateMemory(memoryAllocator, capacity * sizeof(math::Vector3));
+	translucentVoxels->voxelsCapacity = voxelsCapacity;
+	translucentVoxels->voxelSlots = (i32*) allocateMemory(memoryAllocator, voxelsCapacity * sizeof(i32));
+	memset(translucentVoxels->voxelSlots, 0xff, voxelsCapacity * sizeof(i32));
+	translucentVoxels->sortKeys = (u32*) allocateMemory(memoryAllocator, capacity * sizeof(u32));
+	translucentVoxels->sortedSlots = (u32*) allocateMemory(memoryAllocator, capacity * sizeof(u32));
+	MemoryAllocator* sortScratch = &translucentVoxels->sortScratch;
+	sortScratch->byteCapacity = calculateRadixSortScratchSize(capacity, sizeof(u32), 1);
+	sortScratch->byteOffset = 0;
+	sortScratch->memory = (u8*) allocateMemory(memoryAllocator, sortScratch->byteCapacity);
+}
+
+bool32 isVoxelColorTranslucent(RGBAColorF32 color) {
+	return color.a < 1.0f;
+}
+
+//the last voxel of the set takes the slot's place
+static void removeTranslucentVoxelSlot(TranslucentVoxels* translucentVoxels, i32 slot) {
+	i32 last = translucentVoxels->count - 1;
+	translucentVoxels->voxelSlots[translucentVoxels->voxelIndices[slot]] = -1;
+	if (slot != last) {
+		translucentVoxels->voxelIndices[slot] = translucentVoxels->voxelIndices[last];
+		translucentVoxels->instances[slot] = translucentVoxels->instances[last];
+		translucentVoxels->centers[slot] = translucentVoxels->centers[last];
+		translucentVoxels->voxelSlots[translucentVoxels->voxelIndices[slot]] = slot;
+	}
+	translucentVoxels->count = last;
+}
+
+bool32 updateTranslucentVoxel(TranslucentVoxels* translucentVoxels, i32 voxelIndex, math::Matrix4 model, RGBAColorF32 color) {
+	_assert(voxelIndex >= 0 && voxelIndex < translucentVoxels->voxelsCapacity);
+	i32 slot = translucentVoxels->voxelSlots[voxelIndex];
+	if (!isVoxelColorTranslucent(color)) {
+		removeTranslucentVoxel(translucentVoxels, voxelIndex);
+		return 0;
+	}
+	if (slot < 0) {
+		if (translucentVoxels->count >= translucentVoxels->capacity) {
+			return 0;
+		}
+		slot = translucentVoxels->count;
+		translucentVoxels->count += 1;
+		translucentVoxels->voxelIndices[slot] = voxelIndex;
+		translucentVoxels->voxelSlots[voxelIndex] = slot;
+	}
+	translucentVoxels->instances[slot].model = model;
+	translucentVoxels->instances[slot].color = color;
+	translucentVoxels->centers[slot] = math::Vector3{ model.e.m03, model.e.m13, model.e.m23 };
+	return 1;
+}
+
+void removeTranslucentVoxel(TranslucentVoxels* translucentVoxels, i32 voxelIndex) {
+	i32 slot = translucentVoxels->voxelSlots[voxelIndex];
+	if (slot >= 0) {
+		removeTranslucentVoxelSlot(translucentVoxels, slot);
+	}
+}
+
+void trimTranslucentVoxels(TranslucentVoxels* translucentVoxels, i32 voxelsCount) {
+	for (i32 slot = translucentVoxels->count - 1; slot >= 0; slot--) {
+		if (translucentVoxels->voxelIndices[slot] >= voxelsCount) {
+			removeTranslucentVoxelSlot(translucentVoxels, slot);
+		}
+	}
+}
+
+i32 sortTranslucentVoxels(TranslucentVoxels* translucentVoxels, math::Matrix4 view, math::Matrix4* models, RGBAColorF32* colors) {
+	i32 count = translucentVoxels->count;
+	u32* keys = translucentVoxels->sortKeys;
+	u32* slots = translucentVoxels->sortedSlots;
+	//the camera looks down -z in view space, so the farthest voxels have the lowest z and sort first
+	for (i32 slot = 0; slot < count; slot++) {
+		math::Vector3 center = translucentVoxels->centers[slot];
+		keys[slot] = calculateRadixSortKey(view.e.m20 * center.x + view.e.m21 * center.y + view.e.m22 * center.z + view.e.m23);
+		slots[slot] = slot;
+	}
+	radixSort(keys, slots, count, &translucentVoxels->sortScratch);
+
+	for (i32 i = 0; i < count; i++) {
+		TranslucentVoxelInstance* instance = &translucentVoxels->instances[slots[i]];
+		models[i] = instance->model;
+		colors[i] = instance->color;
+	}
+	return count;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#ifndef VOXELS_GAME_VOXEL_TRANSLUCENCY_H
+#define VOXELS_GAME_VOXEL_TRANSLUCENCY_H
+
+#include "common.h"
+#include "math.h"
+#include "memory.h"
+
+/*
+	voxels with an alpha below 1 can't be drawn with the opaque voxels, whose order is whatever their voxel indices are.
+	they are kept in a set, with the transform and color of their instance, as their instances are rebuilt. every frame they are
+	radix sorted back to front by their depth in view space and drawn after the opaque voxels, in that order.
+	voxels that don't fit in the set are drawn with the opaque voxels
+*/
+
+//kept together, since the sorted voxels' instances are gathered from all over the set
+struct TranslucentVoxelInstance {
+	math::Matrix4 model;
+	RGBAColorF32 color;
+};
+
+struct TranslucentVoxels {
+	i32 capacity;
+	i32 count;
+	i32* voxelIndices;
+	TranslucentVoxelInstance* instances;
+	//a voxel's slot in the set, or -1 if it isn't in it
+	i32 voxelsCapacity;
+	i32* voxelSlots;
+	//the translation of each model, packed together so making the sort keys doesn't read the whole models
+	math::Vector3* centers;
+	//the depth keys of the slots, and the slots in the order they sort to
+	u32* sortKeys;
+	u32* sortedSlots;
+	//carved out of the allocator the set was made with, for the radix sort
+	MemoryAllocator sortScratch;
+};
+
+void initTranslucentVoxels(TranslucentVoxels* translucentVoxels, MemoryAllocator* memoryAllocator, i32 voxelsCapacity, i32 capacity);
+bool32 isVoxelColorTranslucent(RGBAColorF32 color);
+//call whenever a voxel's instance is rebuilt. adds, updates or removes it by its color.
+//returns 1 if the voxel is drawn from the set, in which case its opaque instance has to be collapsed
+bool32 updateTranslucentVoxel(TranslucentVoxels* translucentVoxels, i32 voxelIndex, math::Matrix4 model, RGBAColorF32 color);
+void removeTranslucentVoxel(TranslucentVoxels* translucentVoxels, i32 voxelIndex);
+//drops the voxels at or past voxelsCount, after an undo removed them
+void trimTranslucentVoxels(TranslucentVoxels* translucentVoxels, i32 voxelsCount);
+//writes the instances of the set's voxels, farthest from the camera first. returns the amount written
+i32 sortTranslucentVoxels(TranslucentVoxels* translucentVoxels, math::Matrix4 view, math::Matrix4* models, RGBAColorF32* colors);
+
+#endif
@@ -0,0 +1,913 @@
+#include "world_file.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+//the largest a voxel gets: a run of one group index, a position coded both ways while the encoder picks the smaller one,
+//a run of one scale, and a run of one color that's new to the palette
+const u64 WORLD_CHUNK_MAX_VOXEL_SIZE = (5 + 5) + (10 + 5 + 3 * 5) + (5 + 3 * 5) + (5 + 1 + sizeof(RGBAColorF32));
+//the flags byte
+const u64 WORLD_CHUNK_HEADER_SIZE = 1;
+//the file is rewritten once the dead bytes of a save would be more than this fraction of it
+const f64 WORLD_FILE_MAX_DEAD_FRACTION = 0.5;
+//colors are looked up in an open addressing table while encoding. twice the most colors a chunk can have
+const u32 WORLD_CHUNK_PALETTE_TABLE_SIZE = 2 * VOXELS_PER_CHUNK;
+
+typedef u8 WorldChunkFlags;
+//positions are runs of consecutive morton codes instead of coordinate deltas
+const WorldChunkFlags WORLD_CHUNK_MORTON_POSITIONS = 1;
+
+static u8* writeVarint(u8* data, u32 value) {
+	while (value >= 0x80) {
+		*data++ = (u8)(value | 0x80);
+		value >>= 7;
+	}
+	*data++ = (u8)value;
+	return data;
+}
+
+static u8* writeVarint64(u8* data, u64 value) {
+	while (value >= 0x80) {
+		*data++ = (u8)(value | 0x80);
+		value >>= 7;
+	}
+	*data++ = (u8)value;
+	return data;
+}
+
+static u32 encodeZigzag(i32 value) {
+	return ((u32)value << 1) ^ (u32)(value >> 31);
+}
+
+static i32 decodeZigzag(u32 value) {
+	return (i32)(value >> 1) ^ -(i32)(value & 1);
+}
+
+static u64 encodeZigzag64(i64 value) {
+	return ((u64)value << 1) ^ (u64)(value >> 63);
+}
+
+static i64 decodeZigzag64(u64 value) {
+	return (i64)(value >> 1) ^ -(i64)(value & 1);
+}
+
+struct WorldChunkReader {
+	const u8* at;
+	const u8* end;
+	bool32 isValid;
+};
+
+static u32 readVarint(WorldChunkReader* reader) {
+	u32 value = 0;
+	for (u32 shift = 0; shift < 35; shift += 7) {
+		if (reader->at >= reader->end) {
+			reader->isValid = 0;
+			return 0;
+		}
+		u8 byte = *reader->at++;
+		value |= (u32)(byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0) {
+			return value;
+		}
+	}
+	reader->isValid = 0;
+	return 0;
+}
+
+static u64 readVarint64(WorldChunkReader* reader) {
+	u64 value = 0;
+	for (u32 shift = 0; shift < 70; shift += 7) {
+		if (reader->at >= reader->end) {
+			reader->isValid = 0;
+			return 0;
+		}
+		u8 byte = *reader->at++;
+		value |= (u64)(byte & 0x7f) << shift;
+		if ((byte & 0x80) == 0) {
+			return value;
+		}
+	}
+	reader->isValid = 0;
+	return 0;
+}
+
+u64 calculateWorldChunkMaxEncodedSize(i32 voxelsCount) {
+	return WORLD_CHUNK_HEADER_SIZE + (u64)voxelsCount * WORLD_CHUNK_MAX_VOXEL_SIZE;
+}
+
+//voxels that were sorted in morton order mostly continue the code of the voxel before them, so a solid block is one run
+static u8* writeMortonPositions(VoxelArray* voxelArray, VoxelSpan span, u8* at) {
+	u64 nextCode = 0;
+	for (i32 i = span.begin; i < span.end;) {
+		u64 code = calculateVoxelMortonCode(voxelArray->voxelsPosition[i]);
+		i32 runEnd = i + 1;
+		while (runEnd < span.end && calculateVoxelMortonCode(voxelArray->voxelsPosition[runEnd]) == code + (u64)(runEnd - i)) {
+			runEnd += 1;
+		}
+		at = writeVarint64(at, encodeZigzag64((i64)(code - nextCode)));
+		at = writeVarint(at, (u32)(runEnd - i));
+		nextCode = code + (u64)(runEnd - i);
+		i = runEnd;
+	}
+	return at;
+}
+
+static u8* writeDeltaPositions(VoxelArray* voxelArray, VoxelSpan span, u8* at) {
+	Vector3i lastPosition = {};
+	for (i32 i = span.begin; i < span.end; i++) {
+		Vector3i position = voxelArray->voxelsPosition[i];
+		at = writeVarint(at, encodeZigzag(position.x - lastPosition.x));
+		at = writeVarint(at, encodeZigzag(position.y - lastPosition.y));
+		at = writeVarint(at, encodeZigzag(position.z - lastPosition.z));
+		lastPosition = position;
+	}
+	return at;
+}
+
+static u32 hashColor(RGBAColorF32 color) {
+	u32 words[4];
+	memcpy(words, &color, sizeof(words));
+	u32 hash = 2166136261u;
+	for (u32 i = 0; i < 4; i++) {
+		hash = (hash ^ words[i]) * 16777619u;
+	}
+	return hash;
+}
+
+u64 encodeWorldChunk(VoxelArray* voxelArray, VoxelSpan span, u8* data) {
+	_assert(span.end - span.begin <= VOXELS_PER_CHUNK);
+	u8* at = data;
+	WorldChunkFlags* flags = at;
+	*flags = 0;
+	at += WORLD_CHUNK_HEADER_SIZE;
+
+	i32 lastGroupIndex = 0;
+	for (i32 i = span.begin; i < span.end;) {
+		i32 groupIndex = voxelArray->voxelsGroupIndex[i];
+		i32 runEnd = i + 1;
+		while (runEnd < span.end && voxelArray->voxelsGroupIndex[runEnd] == groupIndex) {
+			runEnd += 1;
+		}
+		at = writeVarint(at, encodeZigzag(groupIndex - lastGroupIndex));
+		at = writeVarint(at, (u32)(runEnd - i));
+		lastGroupIndex = groupIndex;
+		i = runEnd;
+	}
+
+	//both position streams are written, and the smaller one is kept
+	bool32 isMortonCodable = 1;
+	for (i32 i = span.begin; i < span.end && isMortonCodable; i++) {
+		isMortonCodable = isVoxelPositionMortonCodable(voxelArray->voxelsPosition[i]);
+	}
+	u8* mortonEnd = isMortonCodable ? writeMortonPositions(voxelArray, span, at) : at;
+	u8* deltaEnd = writeDeltaPositions(voxelArray, span, mortonEnd);
+	if (isMortonCodable && mortonEnd - at <= deltaEnd - mortonEnd) {
+		*flags |= WORLD_CHUNK_MORTON_POSITIONS;
+		at = mortonEnd;
+	} else {
+		memmove(at, mortonEnd, deltaEnd - mortonEnd);
+		at += deltaEnd - mortonEnd;
+	}
+
+	for (i32 i = span.begin; i < span.end;) {
+		Vector3ui scale = voxelArray->voxelsScale[i];
+		i32 runEnd = i + 1;
+		while (runEnd < span.end && memcmp(&voxelArray->voxelsScale[runEnd], &scale, sizeof(Vector3ui)) == 0) {
+			runEnd += 1;
+		}
+		at = writeVarint(at, (u32)(runEnd - i));
+		at = writeVarint(at, scale.x);
+		at = writeVarint(at, scale.y);
+		at = writeVarint(at, scale.z);
+		i = runEnd;
+	}
+
+	//runs of palette indices. a color that isn't in the palette yet is written after index 0 and added to it.
+	//the palette holds the first voxel of every color, relative to the span
+	u16 palette[VOXELS_PER_CHUNK];
+	u16 paletteTable[WORLD_CHUNK_PALETTE_TABLE_SIZE];
+	memset(paletteTable, 0xff, sizeof(paletteTable));
+	u32 paletteCount = 0;
+	for (i32 i = span.begin; i < span.end;) {
+		RGBAColorF32* color = &voxelArray->colors[i];
+		i32 runEnd = i + 1;
+		while (runEnd < span.end && memcmp(&voxelArray->colors[runEnd], color, sizeof(RGBAColorF32)) == 0) {
+			runEnd += 1;
+		}
+		u32 slot = hashColor(*color) & (WORLD_CHUNK_PALETTE_TABLE_SIZE - 1);
+		while (paletteTable[slot] != 0xffff && memcmp(&voxelArray->colors[span.begin + palette[paletteTable[slot]]], color, sizeof(RGBAColorF32)) != 0) {
+			slot = (slot + 1) & (WORLD_CHUNK_PALETTE_TABLE_SIZE - 1);
+		}
+		if (paletteTable[slot] == 0xffff) {
+			paletteTable[slot] = (u16)paletteCount;
+			palette[paletteCount] = (u16)(i - span.begin);
+			paletteCount += 1;
+			at = writeVarint(at, 0);
+			memcpy(at, color, sizeof(RGBAColorF32));
+			at += sizeof(RGBAColorF32);
+		} else {
+			at = writeVarint(at, (u32)paletteTable[slot] + 1);
+		}
+		at = writeVarint(at, (u32)(runEnd - i));
+		i = runEnd;
+	}
+	return (u64)(at - data);
+}
+
+bool32 decodeWorldChunk(const u8* data, u64 size, VoxelArray* voxelArray, VoxelSpan span) {
+	if (size < WORLD_CHUNK_HEADER_SIZE || span.end - span.begin > VOXELS_PER_CHUNK) {
+		return 0;
+	}
+	WorldChunkFlags flags = data[0];
+	WorldChunkReader reader = { data + WORLD_CHUNK_HEADER_SIZE, data + size, 1 };
+	//every stream is runs, which are filled in by loops without branches that the compiler can vectorize
+	i32 groupIndex = 0;
+	for (i32 i = span.begin; i < span.end;) {
+		groupIndex += decodeZigzag(readVarint(&reader));
+		u32 runLength = readVarint(&reader);
+		if (!reader.isValid || groupIndex < -1 || groupIndex >= voxelArray->groupsCount || runLength == 0 || runLength > (u32)(span.end - i)) {
+			return 0;
+		}
+		for (u32 r = 0; r < runLength; r++) {
+			voxelArray->voxelsGroupIndex[i + r] = groupIndex;
+		}
+		i += runLength;
+	}
+
+	if (flags & WORLD_CHUNK_MORTON_POSITIONS) {
+		u64 nextCode = 0;
+		for (i32 i = span.begin; i < span.end;) {
+			u64 code = nextCode + (u64)decodeZigzag64(readVarint64(&reader));
+			u32 runLength = readVarint(&reader);
+			if (!reader.isValid || runLength == 0 || runLength > (u32)(span.end - i)) {
+				return 0;
+			}
+			Vector3i* positions = &voxelArray->voxelsPosition[i];
+			for (u32 r = 0; r < runLength; r++) {
+				positions[r] = decodeVoxelMortonCode(code + r);
+			}
+			nextCode = code + runLength;
+			i += runLength;
+		}
+	} else {
+		Vector3i position = {};
+		for (i32 i = span.begin; i < span.end; i++) {
+			position.x += decodeZigzag(readVarint(&reader));
+			position.y += decodeZigzag(readVarint(&reader));
+			position.z += decodeZigzag(readVarint(&reader));
+			voxelArray->voxelsPosition[i] = position;
+		}
+	}
+
+	for (i32 i = span.begin; i < span.end && reader.isValid;) {
+		u32 runLength = readVarint(&reader);
+		Vector3ui scale;
+		scale.x = readVarint(&reader);
+		scale.y = readVarint(&reader);
+		scale.z = readVarint(&reader);
+		if (runLength == 0 || runLength > (u32)(span.end - i)) {
+			return 0;
+		}
+		for (u32 r = 0; r < runLength; r++) {
+			voxelArray->voxelsScale[i + r] = scale;
+		}
+		i += runLength;
+	}
+
+	u16 palette[VOXELS_PER_CHUNK];
+	u32 paletteCount = 0;
+	for (i32 i = span.begin; i < span.end && reader.isValid;) {
+		u32 paletteIndex = readVarint(&reader);
+		RGBAColorF32 color;
+		if (paletteIndex == 0) {
+			if (reader.end - reader.at < (i64)sizeof(RGBAColorF32)) {
+				return 0;
+			}
+			memcpy(&color, reader.at, sizeof(RGBAColorF32));
+			reader.at += sizeof(RGBAColorF32);
+			palette[paletteCount] = (u16)(i - span.begin);
+			paletteCount += 1;
+		} else if (paletteIndex <= paletteCount) {
+			color = voxelArray->colors[span.begin + palette[paletteIndex - 1]];
+		} else {
+			return 0;
+		}
+		u32 runLength = readVarint(&reader);
+		if (runLength == 0 || runLength > (u32)(span.end - i)) {
+			return 0;
+		}
+		for (u32 r = 0; r < runLength; r++) {
+			voxelArray->colors[i + r] = color;
+		}
+		i += runLength;
+	}
+	return reader.isValid && reader.at == reader.end;
+}
+
+//the payloads of version 1 files, which had no flags or palette and coded every position as deltas
+static bool32 decodeWorldChunkVersion1(const u8* data, u64 size, VoxelArray* voxelArray, VoxelSpan span) {
+	WorldChunkReader reader = { data, data + size, 1 };
+	i32 groupIndex = 0;
+	for (i32 i = span.begin; i < span.end; i++) {
+		groupIndex += decodeZigzag(readVarint(&reader));
+		voxelArray->voxelsGroupIndex[i] = groupIndex;
+		if (groupIndex < -1 || groupIndex >= voxelArray->groupsCount) {
+			return 0;
+		}
+	}
+	Vector3i position = {};
+	for (i32 i = span.begin; i < span.end; i++) {
+		position.x += decodeZigzag(readVarint(&reader));
+		position.y += decodeZigzag(readVarint(&reader));
+		position.z += decodeZigzag(readVarint(&reader));
+		voxelArray->voxelsPosition[i] = position;
+	}
+	for (i32 i = span.begin; i < span.end && reader.isValid;) {
+		u32 runLength = readVarint(&reader);
+		Vector3ui scale;
+		scale.x = readVarint(&reader);
+		scale.y = readVarint(&reader);
+		scale.z = readVarint(&reader);
+		if (runLength == 0 || runLength > (u32)(span.end - i)) {
+			return 0;
+		}
+		for (u32 r = 0; r < runLength; r++) {
+			voxelArray->voxelsScale[i + r] = scale;
+		}
+		i += runLength;
+	}
+	for (i32 i = span.begin; i < span.end && reader.isValid;) {
+		u32 runLength = readVarint(&reader);
+		if (runLength == 0 || runLength > (u32)(span.end - i) || reader.end - reader.at < (i64)sizeof(RGBAColorF32)) {
+			return 0;
+		}
+		RGBAColorF32 color;
+		memcpy(&color, reader.at, sizeof(RGBAColorF32));
+		reader.at += sizeof(RGBAColorF32);
+		for (u32 r = 0; r < runLength; r++) {
+			voxelArray->colors[i + r] = color;
+		}
+		i += runLength;
+	}
+	return reader.isValid && reader.at == reader.end;
+}
+
+void initWorld(World* world, MemoryAllocator* memoryAllocator, VoxelArray* voxelArray, const char* filepath) {
+	*world = {};
+	_assert(strlen(filepath) < WORLD_FILE_PATH_LENGTH);
+	strcpy(world->filepath, filepath);
+	world->voxelArray = voxelArray;
+	world->chunks = (WorldChunkEntry*) allocateMemory(memoryAllocator, voxelArray->chunksCapacity * sizeof(WorldChunkEntry));
+	memset(world->chunks, 0, voxelArray->chunksCapacity * sizeof(WorldChunkEntry));
+	world->savingChunks = (WorldChunkEntry*) allocateMemory(memoryAllocator, voxelArray->chunksCapacity * sizeof(WorldChunkEntry));
+	world->isChunkLoaded = (u8*) allocateMemory(memoryAllocator, voxelArray->chunksCapacity);
+	memset(world->isChunkLoaded, 1, voxelArray->chunksCapacity);
+	world->chunkBuffer = (u8*) allocateMemory(memoryAllocator, calculateWorldChunkMaxEncodedSize(VOXELS_PER_CHUNK));
+	initVoxelSnapshot(&world->snapshot, memoryAllocator, voxelArray);
+	world->isChunkSaving = (u8*) allocateMemory(memoryAllocator, voxelArray->chunksCapacity);
+	memset(world->isChunkSaving, 0, voxelArray->chunksCapacity);
+}
+
+static i32 calculateChunksCount(i32 voxelsCount) {
+	return (voxelsCount + VOXELS_PER_CHUNK - 1) / VOXELS_PER_CHUNK;
+}
+
+VoxelSpan getWorldChunkSpan(World* world, i32 chunkIndex) {
+	VoxelSpan span = { chunkIndex * VOXELS_PER_CHUNK, (chunkIndex + 1) * VOXELS_PER_CHUNK };
+	span.end = MIN(span.end, world->voxelArray->voxelsCount);
+	return span;
+}
+
+static bool32 isWorldFileValid(World* world, WorldFileHeader* header) {
+	u64 fileSize = world->file.size;
+	VoxelArray* voxelArray = world->voxelArray;
+	if (
+		header->magic != WORLD_FILE_MAGIC || header->version < WORLD_FILE_OLDEST_VERSION || header->version > WORLD_FILE_VERSION ||
+		header->voxelsPerChunk != (u32)VOXELS_PER_CHUNK
+	) {
+		printf("%s is not a version %u to %u world file\n", world->filepath, WORLD_FILE_OLDEST_VERSION, WORLD_FILE_VERSION);
+		return 0;
+	}
+	if (header->voxelsCount < 0 || header->voxelsCount > voxelArray->voxelsCapacity || header->groupsCount < 0 || header->groupsCount > voxelArray->groupsCapacity) {
+		printf("world %s has more voxels or groups than the voxel array can hold\n", world->filepath);
+		return 0;
+	}
+	u64 groupsSize = (u64)header->groupsCount * sizeof(WorldFileGroup);
+	u64 directorySize = (u64)header->chunksCount * sizeof(WorldChunkEntry);
+	if (
+		header->groupsOffset % WORLD_FILE_TABLE_ALIGNMENT != 0 || header->directoryOffset % WORLD_FILE_TABLE_ALIGNMENT != 0 ||
+		header->fileSize > fileSize || header->chunksCount != (u32)calculateChunksCount(header->voxelsCount) ||
+		header->groupsOffset > header->fileSize || groupsSize > header->fileSize - header->groupsOffset ||
+		header->directoryOffset > header->fileSize || directorySize > header->fileSize - header->directoryOffset
+	) {
+		printf("world %s is truncated\n", world->filepath);
+		return 0;
+	}
+	WorldChunkEntry* chunks = (WorldChunkEntry*)(world->file.data + header->directoryOffset);
+	for (u32 i = 0; i < header->chunksCount; i++) {
+		u32 voxelsCount = (u32)MIN(header->voxelsCount - (i32)i * VOXELS_PER_CHUNK, VOXELS_PER_CHUNK);
+		if (chunks[i].voxelsCount != voxelsCount || chunks[i].offset > header->fileSize || chunks[i].size > header->fileSize - chunks[i].offset) {
+			printf("chunk %u of world %s is invalid\n", i, world->filepath);
+			return 0;
+		}
+	}
+	WorldFileGroup* groups = (WorldFileGroup*)(world->file.data + header->groupsOffset);
+	for (i32 i = 0; i < header->groupsCount; i++) {
+		if (groups[i].voxelsBegin < 0 || groups[i].voxelsBegin > groups[i].voxelsEnd || groups[i].voxelsEnd > header->voxelsCount) {
+			printf("group %d of world %s is invalid\n", i, world->filepath);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+bool32 openWorld(World* world) {
+	VoxelArray* voxelArray = world->voxelArray;
+	_assert(voxelArray->voxelsCount == 0 && voxelArray->groupsCount == 0);
+	if (!mapFile(world->filepath, &world->file)) {
+		return 0;
+	}
+	WorldFileHeader* header = (WorldFileHeader*)world->file.data;
+	if (world->file.size < sizeof(WorldFileHeader) || !isWorldFileValid(world, header)) {
+		unmapFile(&world->file);
+		return 0;
+	}
+	world->header = *header;
+
+	WorldFileGroup* groups = (WorldFileGroup*)(world->file.data + header->groupsOffset);
+	for (i32 i = 0; i < header->groupsCount; i++) {
+		VoxelGroup* group = &voxelArray->groups[i];
+		group->position = groups[i].position;
+		group->rotation = groups[i].rotation;
+		group->voxelsCount = groups[i].voxelsCount;
+		group->voxelsBegin = groups[i].voxelsBegin;
+		group->voxelsEnd = groups[i].voxelsEnd;
+		group->isDirty = 0;
+	}
+	voxelArray->groupsCount = header->groupsCount;
+
+	//voxels without a size are skipped by picking and drawn as nothing until their chunk is loaded
+	voxelArray->voxelsCount = header->voxelsCount;
+	memset(voxelArray->voxelsScale, 0, (u64)header->voxelsCount * sizeof(Vector3ui));
+	memset(voxelArray->voxelsGroupIndex, 0xff, (u64)header->voxelsCount * sizeof(i32));
+	markVoxelSpanDirty(voxelArray, VoxelSpan{ 0, header->voxelsCount });
+
+	memcpy(world->chunks, world->file.data + header->directoryOffset, header->chunksCount * sizeof(WorldChunkEntry));
+	memset(world->isChunkLoaded, 0, header->chunksCount);
+	memset(voxelArray->isChunkModified, 0, header->chunksCount);
+	voxelArray->areGroupsModified = 0;
+	world->loadedChunksCount = 0;
+	world->loadedVoxelsCount = 0;
+
+	//an old file is loaded whole and marked as modified, so the next save rewrites it in the current format
+	if (header->version != WORLD_FILE_VERSION) {
+		printf("upgrading world %s from version %u to %u\n", world->filepath, header->version, WORLD_FILE_VERSION);
+		loadWorldChunks(world, (i32)header->chunksCount);
+		memset(voxelArray->isChunkModified, 1, header->chunksCount);
+		return 1;
+	}
+
+	//new voxels are added after the last one, so a partially filled last chunk has to be in memory before they are
+	i32 lastChunkIndex = (i32)header->chunksCount - 1;
+	if (lastChunkIndex >= 0 && world->chunks[lastChunkIndex].voxelsCount < (u32)VOXELS_PER_CHUNK && !loadWorldChunk(world, lastChunkIndex)) {
+		closeWorld(world);
+		return 0;
+	}
+	return 1;
+}
+
+void closeWorld(World* world) {
+	finishWorldSave(world);
+	if (world->hasSaveThread) {
+		//the thread doesn't touch the world again once it has acknowledged the stop
+		atomicStoreU32(&world->isSaveThreadStopping, 1);
+		signalSemaphore(world->saveSemaphore, 1);
+		while (!atomicLoadU32(&world->hasSaveThreadStopped)) {
+			sleepMilliseconds(0);
+		}
+		destroySemaphore(world->saveSemaphore);
+		world->hasSaveThread = 0;
+		world->isSaveThreadStopping = 0;
+		world->hasSaveThreadStopped = 0;
+	}
+	unmapFile(&world->file);
+	world->header = {};
+	memset(world->isChunkLoaded, 1, world->voxelArray->chunksCapacity);
+}
+
+static bool32 decodeWorldFileChunk(World* world, i32 chunkIndex, VoxelArray* voxelArray, VoxelSpan span) {
+	WorldChunkEntry* chunk = &world->chunks[chunkIndex];
+	if (world->file.data == nil) {
+		return 0;
+	}
+	if (world->header.version == 1) {
+		return decodeWorldChunkVersion1(world->file.data + chunk->offset, chunk->size, voxelArray, span);
+	}
+	return decodeWorldChunk(world->file.data + chunk->offset, chunk->size, voxelArray, span);
+}
+
+static void markWorldChunkLoaded(World* world, i32 chunkIndex) {
+	VoxelArray* voxelArray = world->voxelArray;
+	VoxelSpan span = getWorldChunkSpan(world, chunkIndex);
+	world->isChunkLoaded[chunkIndex] = 1;
+	world->loadedChunksCount += 1;
+	world->loadedVoxelsCount += span.end - span.begin;
+	//loading doesn't change the world, so the chunk isn't saved again unless it's edited
+	markVoxelSpanDirty(voxelArray, span);
+	voxelArray->isChunkModified[chunkIndex] = 0;
+}
+
+bool32 loadWorldChunk(World* world, i32 chunkIndex) {
+	if (world->isChunkLoaded[chunkIndex]) {
+		return 1;
+	}
+	VoxelArray* voxelArray = world->voxelArray;
+	VoxelSpan span = getWorldChunkSpan(world, chunkIndex);
+	bool32 isDecoded = decodeWorldFileChunk(world, chunkIndex, voxelArray, span);
+	if (!isDecoded) {
+		//a corrupt chunk counts as loaded with no voxels, so it isn't retried over and over
+		printf("chunk %d of world %s is corrupt\n", chunkIndex, world->filepath);
+		memset(&voxelArray->voxelsScale[span.begin], 0, (span.end - span.begin) * sizeof(Vector3ui));
+		memset(&voxelArray->voxelsGroupIndex[span.begin], 0xff, (span.end - span.begin) * sizeof(i32));
+	}
+	markWorldChunkLoaded(world, chunkIndex);
+	return isDecoded;
+}
+
+i32 loadWorldChunks(World* world, i32 maxChunksCount) {
+	i32 loadedCount = 0;
+	for (u32 i = 0; i < world->header.chunksCount && loadedCount < maxChunksCount; i++) {
+		if (!world->isChunkLoaded[i]) {
+			loadWorldChunk(world, (i32)i);
+			loadedCount += 1;
+		}
+	}
+	return loadedCount;
+}
+
+bool32 readWorldChunk(World* world, i32 chunkIndex, VoxelArray* voxels) {
+	VoxelSpan span = { 0, (i32)world->chunks[chunkIndex].voxelsCount };
+	_assert(span.end <= voxels->voxelsCapacity);
+	voxels->groupsCount = world->header.groupsCount;
+	voxels->voxelsCount = span.end;
+	return decodeWorldFileChunk(world, chunkIndex, voxels, span);
+}
+
+void setWorldChunkVoxels(World* world, i32 chunkIndex, VoxelArray* voxels, bool32 isDecoded) {
+	if (world->isChunkLoaded[chunkIndex]) {
+		return;
+	}
+	VoxelArray* voxelArray = world->voxelArray;
+	VoxelSpan span = getWorldChunkSpan(world, chunkIndex);
+	u64 count = (u64)(span.end - span.begin);
+	if (isDecoded) {
+		memcpy(&voxelArray->colors[span.begin], voxels->colors, count * sizeof(RGBAColorF32));
+		memcpy(&voxelArray->voxelsPosition[span.begin], voxels->voxelsPosition, count * sizeof(Vector3i));
+		memcpy(&voxelArray->voxelsScale[span.begin], voxels->voxelsScale, count * sizeof(Vector3ui));
+		memcpy(&voxelArray->voxelsGroupIndex[span.begin], voxels->voxelsGroupIndex, count * sizeof(i32));
+	} else {
+		printf("chunk %d of world %s is corrupt\n", chunkIndex, world->filepath);
+		memset(&voxelArray->voxelsScale[span.begin], 0, count * sizeof(Vector3ui));
+		memset(&voxelArray->voxelsGroupIndex[span.begin], 0xff, count * sizeof(i32));
+	}
+	markWorldChunkLoaded(world, chunkIndex);
+}
+
+bool32 canUnloadWorldChunk(World* world, i32 chunkIndex) {
+	VoxelSpan span = getWorldChunkSpan(world, chunkIndex);
+	//modified chunks have to be saved first, and the partially filled last chunk is where new voxels are added
+	return
+		world->isChunkLoaded[chunkIndex] && !world->voxelArray->isChunkModified[chunkIndex] && !world->isChunkSaving[chunkIndex] &&
+		(u32)chunkIndex < world->header.chunksCount && span.end - span.begin == VOXELS_PER_CHUNK;
+}
+
+bool32 unloadWorldChunk(World* world, i32 chunkIndex) {
+	if (!canUnloadWorldChunk(world, chunkIndex)) {
+		return 0;
+	}
+	VoxelArray* voxelArray = world->voxelArray;
+	VoxelSpan span = getWorldChunkSpan(world, chunkIndex);
+	u64 count = (u64)(span.end - span.begin);
+	//the group indices stay, so the voxels of the chunk still point at a valid group while they have no size. the scales have to
+	//read as 0 until the chunk is loaded again, which discarded pages don't promise, so they stay as well
+	discardMemoryPages(&voxelArray->colors[span.begin], count * sizeof(RGBAColorF32));
+	discardMemoryPages(&voxelArray->voxelsPosition[span.begin], count * sizeof(Vector3i));
+	memset(&voxelArray->voxelsScale[span.begin], 0, count * sizeof(Vector3ui));
+	markVoxelSpanDirty(voxelArray, span);
+	voxelArray->isChunkModified[chunkIndex] = 0;
+	world->isChunkLoaded[chunkIndex] = 0;
+	world->loadedChunksCount -= 1;
+	world->loadedVoxelsCount -= count;
+	return 1;
+}
+
+static void calculateWorldChunkBounds(VoxelArray* voxelArray, VoxelSpan span, Vector3i* boundsMin, Vector3i* boundsMax) {
+	math::Vector3 lower = { INFINITY, INFINITY, INFINITY };
+	math::Vector3 upper = { -INFINITY, -INFINITY, -INFINITY };
+	for (i32 i = span.begin; i < span.end; i++) {
+		Vector3i p = voxelArray->voxelsPosition[i];
+		math::Vector3 center = { (f32)p.x, (f32)p.y, (f32)p.z };
+		i32 groupIndex = voxelArray->voxelsGroupIndex[i];
+		if (groupIndex >= 0) {
+			center = math::rotateVector(center, voxelArray->groups[groupIndex].rotation).add(voxelArray->groups[groupIndex].position);
+		}
+		//the scale is the voxel's full extent, so it covers the half diagonal of any rotation of it
+		Vector3ui s = voxelArray->voxelsScale[i];
+		f32 extent = (f32)MAX(MAX(s.x, s.y), s.z);
+		for (i32 k = 0; k < 3; k++) {
+			lower.v[k] = fminf(lower.v[k], center.v[k] - extent);
+			upper.v[k] = fmaxf(upper.v[k], center.v[k] + extent);
+		}
+	}
+	*boundsMin = Vector3i{ (i32)floorf(lower.x), (i32)floorf(lower.y), (i32)floorf(lower.z) };
+	*boundsMax = Vector3i{ (i32)ceilf(upper.x), (i32)ceilf(upper.y), (i32)ceilf(upper.z) };
+}
+
+//appends the chunk's payload at *offset, either encoded from the snapshot or copied from the mapped file. returns 0 on a write error
+static bool32 writeWorldChunk(World* world, FILE* file, i32 chunkIndex, bool32 isEncoding, u64* offset) {
+	WorldChunkEntry* chunk = &world->savingChunks[chunkIndex];
+	*chunk = world->chunks[chunkIndex];
+	const u8* payload = nil;
+	if (isEncoding) {
+		VoxelArray voxels = {};
+		acquireVoxelSnapshotChunk(&world->snapshot, world->voxelArray, chunkIndex, &voxels);
+		VoxelSpan span = { 0, voxels.voxelsCount };
+		chunk->size = (u32)encodeWorldChunk(&voxels, span, world->chunkBuffer);
+		chunk->voxelsCount = (u32)voxels.voxelsCount;
+		calculateWorldChunkBounds(&voxels, span, &chunk->boundsMin, &chunk->boundsMax);
+		releaseVoxelSnapshotChunk(&world->snapshot, chunkIndex);
+		payload = world->chunkBuffer;
+	} else if (world->file.data != nil) {
+		payload = world->file.data + chunk->offset;
+	} else {
+		printf("chunk %d of world %s isn't loaded and its file isn't mapped\n", chunkIndex, world->filepath);
+		return 0;
+	}
+	chunk->offset = *offset;
+	*offset += chunk->size;
+	return fwrite(payload, 1, chunk->size, file) == chunk->size;
+}
+
+//writes the snapshot's group table and the directory at *offset and fills in the rest of the header
+static bool32 writeWorldTables(World* world, FILE* file, i32 chunksCount, u64* offset, WorldFileHeader* header) {
+	VoxelSnapshot* snapshot = &world->snapshot;
+	const u8 padding[WORLD_FILE_TABLE_ALIGNMENT] = {};
+	u64 paddingSize = (WORLD_FILE_TABLE_ALIGNMENT - *offset % WORLD_FILE_TABLE_ALIGNMENT) % WORLD_FILE_TABLE_ALIGNMENT;
+	if (paddingSize > 0 && fwrite(padding, 1, paddingSize, file) != paddingSize) {
+		return 0;
+	}
+	*offset += paddingSize;
+	header->groupsOffset = *offset;
+	header->groupsCount = snapshot->groupsCount;
+	for (i32 i = 0; i < snapshot->groupsCount; i++) {
+		VoxelGroup* group = &snapshot->groups[i];
+		WorldFileGroup fileGroup = {};
+		fileGroup.position = group->position;
+		fileGroup.rotation = group->rotation;
+		fileGroup.voxelsCount = group->voxelsCount;
+		fileGroup.voxelsBegin = group->voxelsBegin;
+		fileGroup.voxelsEnd = group->voxelsEnd;
+		if (fwrite(&fileGroup, sizeof(fileGroup), 1, file) != 1) {
+			return 0;
+		}
+	}
+	*offset += (u64)snapshot->groupsCount * sizeof(WorldFileGroup);
+	header->directoryOffset = *offset;
+	header->chunksCount = (u32)chunksCount;
+	*offset += (u64)chunksCount * sizeof(WorldChunkEntry);
+	header->voxelsCount = snapshot->voxelsCount;
+	header->fileSize = *offset;
+	return chunksCount == 0 || fwrite(world->savingChunks, sizeof(WorldChunkEntry), chunksCount, file) == (u64)chunksCount;
+}
+
+static bool32 isWorldChunkEncoded(World* world, i32 chunkIndex) {
+	if (!world->isChunkLoaded[chunkIndex]) {
+		return 0;
+	}
+	return world->voxelArray->isChunkModified[chunkIndex] || (u32)chunkIndex >= world->header.chunksCount || world->file.data == nil;
+}
+
+static void getWorldTemporaryPath(World* world, char* path, u64 pathSize) {
+	snprintf(path, pathSize, "%s.tmp", world->filepath);
+}
+
+//writes every chunk and the tables into a new file, which replaces the old one when the save is finished.
+//chunks that aren't being encoded are copied from the old file without decoding them
+static bool32 compactWorldFile(World* world, i32 chunksCount, WorldFileHeader* header) {
+	char temporaryPath[WORLD_FILE_PATH_LENGTH + 4];
+	getWorldTemporaryPath(world, temporaryPath, sizeof(temporaryPath));
+	FILE* file = fopen(temporaryPath, "wb");
+	if (file == nil) {
+		printf("failed to open %s for writing\n", temporaryPath);
+		return 0;
+	}
+	u64 offset = sizeof(WorldFileHeader);
+	bool32 isWritten = seekFile(file, offset);
+	for (i32 i = 0; i < chunksCount && isWritten; i++) {
+		isWritten = writeWorldChunk(world, file, i, world->isChunkSaving[i], &offset);
+	}
+	isWritten = isWritten && writeWorldTables(world, file, chunksCount, &offset, header);
+	header->deadBytes = 0;
+	isWritten = isWritten && seekFile(file, 0) && fwrite(header, sizeof(WorldFileHeader), 1, file) == 1 && flushFileToDisk(file);
+	isWritten = fclose(file) == 0 && isWritten;
+	if (!isWritten) {
+		printf("failed to write world %s\n", temporaryPath);
+		remove(temporaryPath);
+	}
+	return isWritten;
+}
+
+//appends the encoded chunks and new tables after the last save, then points the header at them.
+//the mapping stays, since nothing it covers is overwritten except the header, which the world keeps its own copy of
+static bool32 appendWorldFile(World* world, i32 chunksCount, WorldFileHeader* header) {
+	for (i32 i = 0; i < chunksCount; i++) {
+		world->savingChunks[i] = world->chunks[i];
+	}
+	FILE* file = fopen(world->filepath, "r+b");
+	if (file == nil) {
+		printf("failed to open %s for writing\n", world->filepath);
+		return 0;
+	}
+	u64 offset = world->header.fileSize;
+	bool32 isWritten = seekFile(file, offset);
+	for (i32 i = 0; i < chunksCount && isWritten; i++) {
+		if (world->isChunkSaving[i]) {
+			isWritten = writeWorldChunk(world, file, i, 1, &offset);
+		}
+	}
+	isWritten = isWritten && writeWorldTables(world, file, chunksCount, &offset, header);
+	//the new data has to be on the disk before the header refers to it
+	isWritten = isWritten && flushFileToDisk(file);
+	isWritten = isWritten && seekFile(file, 0) && fwrite(header, sizeof(WorldFileHeader), 1, file) == 1 && flushFileToDisk(file);
+	isWritten = fclose(file) == 0 && isWritten;
+	if (!isWritten) {
+		printf("failed to write world %s\n", world->filepath);
+	}
+	return isWritten;
+}
+
+static void writeWorldSave(World* world) {
+	if (world->isSaveCompacting) {
+		world->wasSaveWritten = compactWorldFile(world, world->savingChunksCount, &world->savingHeader);
+	} else {
+		world->wasSaveWritten = appendWorldFile(world, world->savingChunksCount, &world->savingHeader);
+	}
+	atomicStoreU32(&world->isSaveWritten, 1);
+}
+
+static void runWorldSaveThread(void* data) {
+	World* world = (World*)data;
+	for (;;) {
+		waitForSemaphore(world->saveSemaphore);
+		if (atomicLoadU32(&world->isSaveThreadStopping)) {
+			atomicStoreU32(&world->hasSaveThreadStopped, 1);
+			return;
+		}
+		writeWorldSave(world);
+	}
+}
+
+bool32 beginWorldSave(World* world) {
+	if (world->isSaving) {
+		return 0;
+	}
+	f64 startSeconds = getWallClockSeconds();
+	VoxelArray* voxelArray = world->voxelArray;
+	i32 chunksCount = calculateChunksCount(voxelArray->voxelsCount);
+
+	WorldFileHeader* header = &world->savingHeader;
+	*header = {};
+	header->magic = WORLD_FILE_MAGIC;
+	header->version = WORLD_FILE_VERSION;
+	header->voxelsPerChunk = VOXELS_PER_CHUNK;
+	//the bytes that stop being referenced by this save: the rewritten chunks and the old tables
+	header->deadBytes = world->header.deadBytes;
+	if (world->file.data != nil) {
+		header->deadBytes += world->header.fileSize - world->header.groupsOffset;
+		for (u32 i = 0; i < world->header.chunksCount; i++) {
+			if (world->isChunkLoaded[i] && voxelArray->isChunkModified[i]) {
+				header->deadBytes += world->chunks[i].size;
+			}
+		}
+	}
+	world->isSaveCompacting =
+		world->file.data == nil || world->header.version != WORLD_FILE_VERSION ||
+		(f64)header->deadBytes > WORLD_FILE_MAX_DEAD_FRACTION * (f64)world->header.fileSize;
+
+	//the chunks being saved count as unmodified from here on. edits made during the save mark them modified again
+	for (i32 i = 0; i < chunksCount; i++) {
+		world->isChunkSaving[i] = (u8)isWorldChunkEncoded(world, i);
+		if (world->isChunkSaving[i]) {
+			voxelArray->isChunkModified[i] = 0;
+		}
+	}
+	beginVoxelSnapshot(&world->snapshot, voxelArray, world->isChunkSaving);
+	voxelArray->areGroupsModified = 0;
+	world->savingChunksCount = chunksCount;
+	world->isSaveWritten = 0;
+	world->wasSaveWritten = 0;
+	world->isSaving = 1;
+	world->saveStartSeconds = startSeconds;
+
+	if (!world->hasSaveThread) {
+		world->saveSemaphore = createSemaphore(0);
+		world->hasSaveThread = createThread(runWorldSaveThread, world);
+		if (!world->hasSaveThread) {
+			printf("unable to create the save thread of world %s. it's saved on the main thread\n", world->filepath);
+		}
+	}
+	if (world->hasSaveThread) {
+		signalSemaphore(world->saveSemaphore, 1);
+	} else {
+		writeWorldSave(world);
+	}
+	world->saveBlockingSeconds = getWallClockSeconds() - startSeconds;
+	return 1;
+}
+
+bool32 isWorldModified(World* world) {
+	VoxelArray* voxelArray = world->voxelArray;
+	if (
+		world->file.data == nil || voxelArray->areGroupsModified ||
+		voxelArray->voxelsCount != world->header.voxelsCount || voxelArray->groupsCount != world->header.groupsCount
+	) {
+		return 1;
+	}
+	i32 chunksCount = calculateChunksCount(voxelArray->voxelsCount);
+	for (i32 i = 0; i < chunksCount; i++) {
+		if (voxelArray->isChunkModified[i]) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+bool32 isWorldSaveWritten(World* world) {
+	return world->isSaving && atomicLoadU32(&world->isSaveWritten);
+}
+
+bool32 finishWorldSave(World* world) {
+	if (!world->isSaving) {
+		return 0;
+	}
+	f64 waitSeconds = getWallClockSeconds();
+	while (!atomicLoadU32(&world->isSaveWritten)) {
+		sleepMilliseconds(0);
+	}
+	VoxelArray* voxelArray = world->voxelArray;
+	i32 chunksCount = world->savingChunksCount;
+	bool32 isSaved = world->wasSaveWritten;
+	//the mapping is replaced either way, so it covers what the save appended
+	unmapFile(&world->file);
+	if (isSaved && world->isSaveCompacting) {
+		char temporaryPath[WORLD_FILE_PATH_LENGTH + 4];
+		getWorldTemporaryPath(world, temporaryPath, sizeof(temporaryPath));
+		if (!replaceFile(temporaryPath, world->filepath)) {
+			printf("failed to replace world %s with %s\n", world->filepath, temporaryPath);
+			remove(temporaryPath);
+			isSaved = 0;
+		}
+	}
+	endVoxelSnapshot(&world->snapshot, voxelArray);
+
+	if (isSaved) {
+		world->header = world->savingHeader;
+		memcpy(world->chunks, world->savingChunks, chunksCount * sizeof(WorldChunkEntry));
+		//the chunks that were only in memory are in the file now
+		world->loadedChunksCount = 0;
+		world->loadedVoxelsCount = 0;
+		for (i32 i = 0; i < chunksCount; i++) {
+			if (world->isChunkLoaded[i]) {
+				world->loadedChunksCount += 1;
+				world->loadedVoxelsCount += world->chunks[i].voxelsCount;
+			}
+		}
+		world->lastSaveBytes = world->header.fileSize;
+		world->wasLastSaveCompacted = world->isSaveCompacting;
+	} else {
+		//they are written again by the next save
+		for (i32 i = 0; i < chunksCount; i++) {
+			if (world->isChunkSaving[i]) {
+				voxelArray->isChunkModified[i] = 1;
+			}
+		}
+		voxelArray->areGroupsModified = 1;
+	}
+	memset(world->isChunkSaving, 0, chunksCount);
+	if (!mapFile(world->filepath, &world->file) && world->header.fileSize > 0) {
+		printf("unable to map world %s after saving. chunks that aren't loaded can't be loaded anymore\n", world->filepath);
+	}
+	world->isSaving = 0;
+	f64 endSeconds = getWallClockSeconds();
+	world->lastSaveSeconds = endSeconds - world->saveStartSeconds;
+	//waiting for the save thread counts too, since the caller was blocked by it
+	world->lastSaveBlockingSeconds = world->saveBlockingSeconds + (endSeconds - waitSeconds);
+	return isSaved;
+}
+
+bool32 saveWorld(World* world) {
+	finishWorldSave(world);
+	beginWorldSave(world);
+	return finishWorldSave(world);
+}
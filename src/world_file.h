@@ -0,0 +1,152 @@
+#pragma once
+#ifndef VOXELS_GAME_WORLD_FILE_H
+#define VOXELS_GAME_WORLD_FILE_H
+
+#include "common.h"
+#include "memory.h"
+#include "platform.h"
+#include "voxel.h"
+
+/*
+	a world is saved into one file, which stays mapped read only while the game runs.
+	layout: WorldFileHeader, then chunk payloads, group tables and chunk directories in the order they were written.
+	a save appends the modified chunks, a new group table and a new directory, then rewrites the header last,
+	so a save that's cut short leaves the previous header pointing at intact data.
+	bytes that the current directory doesn't refer to anymore are counted in deadBytes, and the file is rewritten
+	without them once they make up most of it.
+	saves run on a thread of their own. the main thread only takes a snapshot of the voxel array when one starts, and maps the file
+	again when it's done.
+	all offsets are from the start of the file
+*/
+
+const u32 WORLD_FILE_MAGIC = 'V' | ('X' << 8) | ('W' << 16) | ('D' << 24);
+//version 2 added palettes and morton coded positions to the chunk payloads. version 1 files are read and rewritten on the next save
+const u32 WORLD_FILE_VERSION = 2;
+const u32 WORLD_FILE_OLDEST_VERSION = 1;
+const u32 WORLD_FILE_PATH_LENGTH = 260;
+const char* const WORLD_FILE_PATH = "./world.vxworld";
+//the group table and the directory are read in place from the mapping
+const u64 WORLD_FILE_TABLE_ALIGNMENT = 8;
+
+struct WorldFileHeader {
+	u32 magic;
+	u32 version;
+	u32 voxelsPerChunk;
+	u32 chunksCount;
+	i32 voxelsCount;
+	i32 groupsCount;
+	u64 groupsOffset;
+	u64 directoryOffset;
+	//the file can be longer than this after a save that failed. the bytes past it are overwritten by the next one
+	u64 fileSize;
+	u64 deadBytes;
+};
+
+struct WorldFileGroup {
+	math::Vector3 position;
+	math::Quaternion rotation;
+	i32 voxelsCount;
+	i32 voxelsBegin;
+	i32 voxelsEnd;
+};
+
+struct WorldChunkEntry {
+	u64 offset;
+	u32 size;
+	u32 voxelsCount;
+	//bounds of the chunk's voxels in voxel units, with their groups' transforms at the time of the save
+	Vector3i boundsMin;
+	Vector3i boundsMax;
+};
+
+struct World {
+	char filepath[WORLD_FILE_PATH_LENGTH];
+	VoxelArray* voxelArray;
+
+	MappedFile file;
+	//the header of the last save. zeroed if the world has never been saved
+	WorldFileHeader header;
+
+	//one entry and one flag for every chunk the voxel array can hold. chunks that aren't in the file count as loaded
+	WorldChunkEntry* chunks;
+	//the directory that's being written. it replaces chunks once the save succeeded
+	WorldChunkEntry* savingChunks;
+	u8* isChunkLoaded;
+	//only chunks that are in the file are counted
+	i32 loadedChunksCount;
+	u64 loadedVoxelsCount;
+
+	u8* chunkBuffer;
+
+	//the save that's running. the chunks it encodes are shared with the snapshot and can't be unloaded until it's finished
+	bool32 isSaving;
+	VoxelSnapshot snapshot;
+	u8* isChunkSaving;
+	WorldFileHeader savingHeader;
+	i32 savingChunksCount;
+	bool32 isSaveCompacting;
+	volatile u32 isSaveWritten;
+	bool32 wasSaveWritten;
+	bool32 hasSaveThread;
+	//set by closeWorld, which waits for the save thread to set hasSaveThreadStopped and return
+	volatile u32 isSaveThreadStopping;
+	volatile u32 hasSaveThreadStopped;
+	PlatformSemaphore saveSemaphore;
+	f64 saveStartSeconds;
+	f64 saveBlockingSeconds;
+
+	//from the start of the save to its end, and the part of it spent on the calling thread
+	f64 lastSaveSeconds;
+	f64 lastSaveBlockingSeconds;
+	u64 lastSaveBytes;
+	bool32 wasLastSaveCompacted;
+};
+
+void initWorld(World* world, MemoryAllocator* memoryAllocator, VoxelArray* voxelArray, const char* filepath);
+//maps the world file and reads its group table into the empty voxel array. voxels stay in the file until their chunk is loaded,
+//and have no size until then. returns 0 if the file is missing or invalid
+bool32 openWorld(World* world);
+//finishes the save that's running and stops the save thread
+void closeWorld(World* world);
+
+//decodes the chunk into the voxel array if it isn't loaded yet, and marks its voxels dirty. returns 0 if its payload is corrupt
+bool32 loadWorldChunk(World* world, i32 chunkIndex);
+//loads up to maxChunksCount of the chunks that aren't loaded yet, in file order. returns the amount loaded
+i32 loadWorldChunks(World* world, i32 maxChunksCount);
+//chunks that can't be unloaded are the ones modified since the last save, the ones that aren't in the file yet, the partially filled last one,
+//and the ones a running save is encoding
+bool32 canUnloadWorldChunk(World* world, i32 chunkIndex);
+//gives the chunk's voxels back to the file and releases their memory. returns 0 if the chunk can't be unloaded
+bool32 unloadWorldChunk(World* world, i32 chunkIndex);
+VoxelSpan getWorldChunkSpan(World* world, i32 chunkIndex);
+
+//for loading on other threads. decodes the chunk into voxels, starting at index 0, without touching the world.
+//any thread may call it, except while finishWorldSave or closeWorld run. returns 0 if the payload is corrupt
+bool32 readWorldChunk(World* world, i32 chunkIndex, VoxelArray* voxels);
+//copies the voxels read by readWorldChunk into the voxel array and marks the chunk as loaded. a chunk that failed to read is loaded without voxels
+void setWorldChunkVoxels(World* world, i32 chunkIndex, VoxelArray* voxels, bool32 isDecoded);
+
+//writes the loaded chunks that were modified since the last save, and the group table. returns 0 on failure, keeping the previous save.
+//a save that's running is finished first
+bool32 saveWorld(World* world);
+//starts a save on the world's save thread and returns without waiting for it. the voxel array can keep changing while it runs, as long
+//as voxels that already exist go through prepareVoxelSpanWrite before they are written. returns 0 if a save is already running
+bool32 beginWorldSave(World* world);
+//whether a save would write anything the file doesn't already have: modified chunks, new or removed voxels, or changed groups
+bool32 isWorldModified(World* world);
+//whether finishWorldSave would return without waiting
+bool32 isWorldSaveWritten(World* world);
+//waits for the save thread, then maps the file it wrote. chunks may not be read from the world meanwhile.
+//returns 0 if the save failed, in which case its chunks stay modified, or if no save was running
+bool32 finishWorldSave(World* world);
+
+//chunk payloads store every voxel attribute in its own stream of runs: group indices, scales, and indices into a palette of the
+//chunk's colors. positions are runs of consecutive morton codes, which is what voxels sorted by sortVoxelsInMortonOrder turn into,
+//or delta coded varints when those are smaller
+u64 calculateWorldChunkMaxEncodedSize(i32 voxelsCount);
+//returns the size written to data
+u64 encodeWorldChunk(VoxelArray* voxelArray, VoxelSpan span, u8* data);
+//returns 0 if the payload doesn't hold exactly the voxels of the span
+bool32 decodeWorldChunk(const u8* data, u64 size, VoxelArray* voxelArray, VoxelSpan span);
+
+#endif
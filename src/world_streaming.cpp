@@ -0,0 +1,169 @@
+#include "world_streaming.h"
+#include "collision.h"
+
+#include <string.h>
+#include <math.h>
+
+static void loadWorldChunkJob(void* data) {
+	WorldChunkLoad* load = (WorldChunkLoad*)data;
+	load->isDecoded = readWorldChunk(load->world, load->chunkIndex, &load->voxels);
+	atomicStoreU32(&load->isDone, 1);
+}
+
+void initWorldStreamer(WorldStreamer* streamer, MemoryAllocator* memoryAllocator, World* world, JobQueue* jobQueue, u64 residentBytesBudget, f32 loadRadius) {
+	*streamer = {};
+	streamer->world = world;
+	streamer->jobQueue = jobQueue;
+	streamer->residentBytesBudget = residentBytesBudget;
+	streamer->loadRadius = loadRadius;
+	i32 chunksCapacity = world->voxelArray->chunksCapacity;
+	streamer->chunksLastWantedFrame = (u64*) allocateMemory(memoryAllocator, chunksCapacity * sizeof(u64));
+	memset(streamer->chunksLastWantedFrame, 0, chunksCapacity * sizeof(u64));
+	streamer->isChunkLoading = (u8*) allocateMemory(memoryAllocator, chunksCapacity);
+	memset(streamer->isChunkLoading, 0, chunksCapacity);
+	for (u32 i = 0; i < MAX_WORLD_CHUNK_LOADS_IN_FLIGHT; i++) {
+		WorldChunkLoad* load = &streamer->loads[i];
+		load->world = world;
+		initVoxelArray(&load->voxels, memoryAllocator, VOXELS_PER_CHUNK, 1);
+	}
+}
+
+u64 getWorldResidentBytes(WorldStreamer* streamer) {
+	return streamer->world->loadedVoxelsCount * WORLD_VOXEL_RESIDENT_SIZE;
+}
+
+u64 getWorldPinnedBytes(WorldStreamer* streamer) {
+	return (u64)streamer->world->voxelArray->voxelsCount * WORLD_VOXEL_PINNED_SIZE;
+}
+
+static void finishWorldChunkLoad(WorldStreamer* streamer, WorldChunkLoad* load) {
+	setWorldChunkVoxels(streamer->world, load->chunkIndex, &load->voxels, load->isDecoded);
+	streamer->isChunkLoading[load->chunkIndex] = 0;
+	streamer->loadedChunksCount += 1;
+	load->isInFlight = 0;
+}
+
+void finishWorldStreaming(WorldStreamer* streamer) {
+	waitForAllJobs(streamer->jobQueue);
+	for (u32 i = 0; i < MAX_WORLD_CHUNK_LOADS_IN_FLIGHT; i++) {
+		if (streamer->loads[i].isInFlight) {
+			finishWorldChunkLoad(streamer, &streamer->loads[i]);
+		}
+	}
+}
+
+//unloads the chunk that was wanted the longest ago, if any chunk that isn't wanted this frame can be unloaded
+static bool32 unloadLeastRecentlyWantedChunk(WorldStreamer* streamer) {
+	World* world = streamer->world;
+	i32 leastRecentChunk = -1;
+	for (u32 i = 0; i < world->header.chunksCount; i++) {
+		if (
+			streamer->chunksLastWantedFrame[i] < streamer->frameNumber && !streamer->isChunkLoading[i] && canUnloadWorldChunk(world, (i32)i) &&
+			(leastRecentChunk < 0 || streamer->chunksLastWantedFrame[i] < streamer->chunksLastWantedFrame[leastRecentChunk])
+		) {
+			leastRecentChunk = (i32)i;
+		}
+	}
+	if (leastRecentChunk < 0) {
+		return 0;
+	}
+	unloadWorldChunk(world, leastRecentChunk);
+	streamer->unloadedChunksCount += 1;
+	return 1;
+}
+
+static f32 calculateDistanceToAABB(math::Vector3 p, AABB b) {
+	math::Vector3 d = {
+		fmaxf(fmaxf(b.min.x - p.x, 0.0f), p.x - b.max.x),
+		fmaxf(fmaxf(b.min.y - p.y, 0.0f), p.y - b.max.y),
+		fmaxf(fmaxf(b.min.z - p.z, 0.0f), p.z - b.max.z),
+	};
+	return d.length();
+}
+
+void updateWorldStreaming(WorldStreamer* streamer, math::Vector3 cameraPosition, math::Matrix4 viewProjection) {
+	World* world = streamer->world;
+	streamer->frameNumber += 1;
+
+	u32 freeLoadsCount = 0;
+	u64 loadingBytes = 0;
+	for (u32 i = 0; i < MAX_WORLD_CHUNK_LOADS_IN_FLIGHT; i++) {
+		WorldChunkLoad* load = &streamer->loads[i];
+		if (load->isInFlight && atomicLoadU32(&load->isDone)) {
+			finishWorldChunkLoad(streamer, load);
+		}
+		if (load->isInFlight) {
+			loadingBytes += world->chunks[load->chunkIndex].voxelsCount * WORLD_VOXEL_RESIDENT_SIZE;
+		} else {
+			freeLoadsCount += 1;
+		}
+	}
+	if (world->file.data == nil) {
+		return;
+	}
+
+	//the best chunks to load this frame, ordered best first. chunks in the frustum sort before every chunk outside of it
+	i32 candidates[MAX_WORLD_CHUNK_LOADS_IN_FLIGHT];
+	f32 candidateKeys[MAX_WORLD_CHUNK_LOADS_IN_FLIGHT];
+	u32 candidatesCount = 0;
+	Frustum frustum = extractFrustum(viewProjection);
+	for (u32 i = 0; i < world->header.chunksCount; i++) {
+		WorldChunkEntry* chunk = &world->chunks[i];
+		AABB bounds = {
+			math::Vector3{ (f32)chunk->boundsMin.x, (f32)chunk->boundsMin.y, (f32)chunk->boundsMin.z }.scale(voxelUnitsToWorldUnits),
+			math::Vector3{ (f32)chunk->boundsMax.x, (f32)chunk->boundsMax.y, (f32)chunk->boundsMax.z }.scale(voxelUnitsToWorldUnits),
+		};
+		f32 distance = calculateDistanceToAABB(cameraPosition, bounds);
+		if (distance > streamer->loadRadius) {
+			continue;
+		}
+		streamer->chunksLastWantedFrame[i] = streamer->frameNumber;
+		if (world->isChunkLoaded[i] || streamer->isChunkLoading[i]) {
+			continue;
+		}
+		f32 key = isAABBIntersectingFrustum(&frustum, bounds) ? distance : distance + streamer->loadRadius;
+		if (candidatesCount == freeLoadsCount && (freeLoadsCount == 0 || key >= candidateKeys[candidatesCount - 1])) {
+			continue;
+		}
+		u32 at = candidatesCount < freeLoadsCount ? candidatesCount++ : candidatesCount - 1;
+		while (at > 0 && candidateKeys[at - 1] > key) {
+			candidates[at] = candidates[at - 1];
+			candidateKeys[at] = candidateKeys[at - 1];
+			at -= 1;
+		}
+		candidates[at] = (i32)i;
+		candidateKeys[at] = key;
+	}
+
+	//the budget may have been lowered, or the camera moved away from chunks that were loaded
+	while (getWorldResidentBytes(streamer) + loadingBytes > streamer->residentBytesBudget && unloadLeastRecentlyWantedChunk(streamer)) {}
+
+	streamer->blockedChunksCount = 0;
+	u32 nextLoad = 0;
+	for (u32 c = 0; c < candidatesCount; c++) {
+		u64 chunkBytes = world->chunks[candidates[c]].voxelsCount * WORLD_VOXEL_RESIDENT_SIZE;
+		bool32 isFitting = 1;
+		while (getWorldResidentBytes(streamer) + loadingBytes + chunkBytes > streamer->residentBytesBudget && isFitting) {
+			isFitting = unloadLeastRecentlyWantedChunk(streamer);
+		}
+		if (!isFitting) {
+			streamer->blockedChunksCount = candidatesCount - c;
+			break;
+		}
+		while (streamer->loads[nextLoad].isInFlight) {
+			nextLoad += 1;
+		}
+		WorldChunkLoad* load = &streamer->loads[nextLoad];
+		load->chunkIndex = candidates[c];
+		load->isDecoded = 0;
+		load->isDone = 0;
+		load->isInFlight = 1;
+		streamer->isChunkLoading[load->chunkIndex] = 1;
+		loadingBytes += chunkBytes;
+		addJob(streamer->jobQueue, loadWorldChunkJob, load);
+	}
+	//without worker threads, jobs only run while something waits for them
+	if (streamer->jobQueue->threadsCount == 0) {
+		finishWorldStreaming(streamer);
+	}
+}
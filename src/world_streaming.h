@@ -0,0 +1,65 @@
+#pragma once
+#ifndef VOXELS_GAME_WORLD_STREAMING_H
+#define VOXELS_GAME_WORLD_STREAMING_H
+
+#include "common.h"
+#include "math.h"
+#include "memory.h"
+#include "jobs.h"
+#include "world_file.h"
+
+/*
+	pages the chunks of a world in and out around the camera.
+	chunks whose saved bounds are within the load radius are decoded on the job queue's threads, nearest first,
+	with the ones in the view frustum ahead of the rest. when the loaded chunks would go over the memory budget,
+	the chunks that were wanted the longest ago are unloaded first. chunks that can't be unloaded (see unloadWorldChunk)
+	stay resident and count towards the budget.
+	the budget only covers what unloading gives back. every voxel's scale and group index stay in memory whether its chunk
+	is loaded or not, since an unloaded voxel is one with a scale of 0. that part is reported by getWorldPinnedBytes.
+*/
+
+const u32 MAX_WORLD_CHUNK_LOADS_IN_FLIGHT = 8;
+//the memory a voxel's color and position take in the voxel array. unloading its chunk gives it back
+const u64 WORLD_VOXEL_RESIDENT_SIZE = sizeof(RGBAColorF32) + sizeof(Vector3i);
+//the memory a voxel's scale and group index take, loaded or not
+const u64 WORLD_VOXEL_PINNED_SIZE = sizeof(Vector3ui) + sizeof(i32);
+
+struct WorldChunkLoad {
+	World* world;
+	i32 chunkIndex;
+	//chunk sized arrays the job decodes into. copied into the world's voxel array on the main thread
+	VoxelArray voxels;
+	bool32 isDecoded;
+	volatile u32 isDone;
+	bool32 isInFlight;
+};
+
+struct WorldStreamer {
+	World* world;
+	JobQueue* jobQueue;
+
+	u64 residentBytesBudget;
+	//in world units
+	f32 loadRadius;
+
+	//the last frame the chunk was within the load radius
+	u64* chunksLastWantedFrame;
+	u8* isChunkLoading;
+	u64 frameNumber;
+	WorldChunkLoad loads[MAX_WORLD_CHUNK_LOADS_IN_FLIGHT];
+
+	u64 loadedChunksCount;
+	u64 unloadedChunksCount;
+	//chunks that are wanted but can't be loaded until others are unloaded
+	u32 blockedChunksCount;
+};
+
+void initWorldStreamer(WorldStreamer* streamer, MemoryAllocator* memoryAllocator, World* world, JobQueue* jobQueue, u64 residentBytesBudget, f32 loadRadius);
+//call once per frame on the thread that owns the job queue. finishes the loads that are done and starts new ones
+void updateWorldStreaming(WorldStreamer* streamer, math::Vector3 cameraPosition, math::Matrix4 viewProjection);
+//waits for every load in flight and finishes it. call before saving the world, since saving remaps its file
+void finishWorldStreaming(WorldStreamer* streamer);
+u64 getWorldResidentBytes(WorldStreamer* streamer);
+u64 getWorldPinnedBytes(WorldStreamer* streamer);
+
+#endif
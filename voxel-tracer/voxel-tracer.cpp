@@ -0,0 +1,181 @@
+#include "../src/common.h"
+#include "../src/math.h"
+#include "../src/memory.h"
+#include "../src/platform.h"
+#include "../src/jobs.h"
+#include "../src/voxel.h"
+#include "../src/voxel_selection.h"
+#include "../src/voxel_tracer.h"
+#include "../src/world_file.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "../src/third_party/stb/stb_image_write.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+	usage: voxel-tracer [options] output.png [world.vxworld]
+
+	path traces the world's voxels on the cpu and writes the image as a png. without a world, a small scene of colored boxes is traced.
+	options:
+		--size WxH             640x360
+		--samples n            samples per pixel, 16
+		--bounces n            4
+		--threads n            worker threads besides the calling one. all logical processors but one by default
+		--camera x,y,z         world units
+		--target x,y,z         what the camera looks at
+		--fov degrees          vertical, 70 like the game
+		--sun yaw,pitch        degrees, like the lighting sliders
+		--seed n
+	prints the rays traced per second when it's done, so it doubles as a benchmark of the spatial index on big worlds.
+*/
+
+static bool32 parseVector3(const char* text, math::Vector3* v) {
+	return sscanf(text, "%f,%f,%f", &v->x, &v->y, &v->z) == 3;
+}
+
+static void addDemoScene(VoxelArray* voxelArray) {
+	RGBAColorF32 floorColors[2] = { { 0.6f, 0.6f, 0.6f, 1.0f }, { 0.45f, 0.45f, 0.45f, 1.0f } };
+	i32 floorGroup = addEmptyVoxelGroup(voxelArray, math::Vector3{});
+	VoxelSpan floorSpan = { voxelArray->voxelsCount, voxelArray->voxelsCount };
+	//a checkered floor of world unit voxels, with its top at y 0
+	for (i32 z = -24; z < 24; z++) {
+		for (i32 x = -24; x < 24; x++) {
+			addVoxelToGroup(voxelArray, floorColors[(x + z) & 1], Vector3i{ 4 * x + 2, -2, 4 * z + 2 }, Vector3ui{ 4, 4, 4 }, floorGroup);
+		}
+	}
+	//rows of the floor make long thin leaves that most rays reach. squares of it don't
+	floorSpan.end = voxelArray->voxelsCount;
+	sortVoxelsInMortonOrder(voxelArray, floorSpan);
+	RGBAColorF32 red = {};
+	red.r = 0.8f; red.g = 0.1f; red.b = 0.1f; red.a = 1.0f;
+	RGBAColorF32 green = {};
+	green.r = 0.1f; green.g = 0.7f; green.b = 0.2f; green.a = 1.0f;
+	RGBAColorF32 blue = {};
+	blue.r = 0.15f; blue.g = 0.25f; blue.b = 0.8f; blue.a = 1.0f;
+	RGBAColorF32 white = { 0.9f, 0.9f, 0.9f, 1.0f };
+	addStandaloneVoxel(voxelArray, red, Vector3i{ -24, 8, 0 }, Vector3ui{ 16, 16, 16 });
+	addStandaloneVoxel(voxelArray, white, Vector3i{ 0, 24, -16 }, Vector3ui{ 8, 48, 8 });
+	//a wall with a window in it
+	i32 wallGroup = addEmptyVoxelGroup(voxelArray, math::Vector3{ 0.0f, 0.0f, -40.0f });
+	for (i32 y = 0; y < 6; y++) {
+		for (i32 x = -6; x < 6; x++) {
+			if (y >= 2 && y < 4 && x >= -1 && x < 1) {
+				continue;
+			}
+			addVoxelToGroup(voxelArray, green, Vector3i{ 4 * x + 2, 4 * y + 2, 0 }, Vector3ui{ 4, 4, 4 }, wallGroup);
+		}
+	}
+	i32 tiltedGroup = addEmptyVoxelGroup(voxelArray, math::Vector3{ 28.0f, 8.0f, 4.0f });
+	addVoxelToGroup(voxelArray, blue, Vector3i{ 0, 0, 0 }, Vector3ui{ 12, 12, 12 }, tiltedGroup);
+	voxelArray->groups[tiltedGroup].rotation = math::createQuaternionRotation(PI32 / 4.0f, math::Vector3{ 0.0f, 1.0f, 0.0f });
+}
+
+int main(int argc, char** argv) {
+	VoxelTracerConfig config = {};
+	config.width = 640;
+	config.height = 360;
+	config.samplesPerPixel = 16;
+	config.maxBounces = 4;
+	config.seed = 1;
+	config.sunColor = math::Vector3{ 1.6f, 1.5f, 1.35f };
+	config.skyColor = math::Vector3{ 0.35f, 0.5f, 0.8f };
+	u32 threadsCount = MAX(getLogicalProcessorCount(), 2) - 1;
+	math::Vector3 cameraPosition = { 0.0f, 8.0f, 20.0f };
+	math::Vector3 cameraTarget = { 0.0f, 2.0f, 0.0f };
+	f32 fov = 70.0f;
+	f32 sunYaw = 30.0f;
+	f32 sunPitch = 55.0f;
+
+	i32 argumentIndex = 1;
+	while (argumentIndex + 1 < argc && strncmp(argv[argumentIndex], "--", 2) == 0) {
+		const char* option = argv[argumentIndex];
+		const char* value = argv[argumentIndex + 1];
+		bool32 isValid;
+		if (strcmp(option, "--size") == 0) {
+			isValid = sscanf(value, "%ux%u", &config.width, &config.height) == 2 && config.width > 0 && config.height > 0;
+		} else if (strcmp(option, "--samples") == 0) {
+			isValid = sscanf(value, "%u", &config.samplesPerPixel) == 1 && config.samplesPerPixel > 0;
+		} else if (strcmp(option, "--bounces") == 0) {
+			isValid = sscanf(value, "%u", &config.maxBounces) == 1;
+		} else if (strcmp(option, "--threads") == 0) {
+			isValid = sscanf(value, "%u", &threadsCount) == 1;
+		} else if (strcmp(option, "--camera") == 0) {
+			isValid = parseVector3(value, &cameraPosition);
+		} else if (strcmp(option, "--target") == 0) {
+			isValid = parseVector3(value, &cameraTarget);
+		} else if (strcmp(option, "--fov") == 0) {
+			isValid = sscanf(value, "%f", &fov) == 1 && fov > 0.0f && fov < 180.0f;
+		} else if (strcmp(option, "--sun") == 0) {
+			isValid = sscanf(value, "%f,%f", &sunYaw, &sunPitch) == 2;
+		} else if (strcmp(option, "--seed") == 0) {
+			isValid = sscanf(value, "%u", &config.seed) == 1;
+		} else {
+			printf("unknown option %s\n", option);
+			return 1;
+		}
+		if (!isValid) {
+			printf("invalid value %s for %s\n", value, option);
+			return 1;
+		}
+		argumentIndex += 2;
+	}
+	if (argumentIndex >= argc || argumentIndex + 2 < argc) {
+		printf(
+			"usage: voxel-tracer [--size WxH] [--samples n] [--bounces n] [--threads n] [--camera x,y,z] [--target x,y,z] [--fov degrees] "
+			"[--sun yaw,pitch] [--seed n] output.png [world.vxworld]\n"
+		);
+		return 1;
+	}
+	const char* outputFilepath = argv[argumentIndex];
+	const char* worldFilepath = argumentIndex + 1 < argc ? argv[argumentIndex + 1] : nil;
+	f32 yaw = math::radians(sunYaw);
+	f32 pitch = math::radians(sunPitch);
+	config.sunDirection = math::Vector3{ cosf(pitch) * cosf(yaw), sinf(pitch), cosf(pitch) * sinf(yaw) };
+
+	MemoryAllocator memoryAllocator = {};
+	initMemoryAllocator(&memoryAllocator, gigabyte(2));
+	JobQueue* jobQueue = (JobQueue*) allocateMemory(&memoryAllocator, sizeof(JobQueue));
+	initJobQueue(jobQueue, threadsCount);
+
+	const u32 maxVoxels = 2048 * 2048;
+	VoxelArray voxelArray = {};
+	initVoxelArray(&voxelArray, &memoryAllocator, maxVoxels, maxVoxels / 16);
+	if (worldFilepath != nil) {
+		World* world = (World*) allocateMemory(&memoryAllocator, sizeof(World));
+		initWorld(world, &memoryAllocator, &voxelArray, worldFilepath);
+		if (!openWorld(world)) {
+			printf("failed to open world %s\n", worldFilepath);
+			return 1;
+		}
+		while (loadWorldChunks(world, 100) > 0) {}
+		printf("loaded %d voxels in %u chunks from %s\n", voxelArray.voxelsCount, world->header.chunksCount, worldFilepath);
+	} else {
+		addDemoScene(&voxelArray);
+	}
+	VoxelSpatialIndex index = {};
+	initVoxelSpatialIndex(&index, &memoryAllocator, &voxelArray);
+	VoxelTracer tracer = {};
+	initVoxelTracer(&tracer, &memoryAllocator, &voxelArray, &index);
+
+	math::Matrix4 view = math::lookAt(cameraPosition, cameraTarget, math::Vector3{ 0.0f, 1.0f, 0.0f });
+	math::Matrix4 projection = math::createPerspective(math::radians(fov), (f32)config.width / (f32)config.height, 0.1f, 100.0f);
+	u8* pixels = (u8*) malloc(4ull * config.width * config.height);
+	VoxelTracerStats stats = {};
+	traceVoxelImage(&tracer, jobQueue, view, projection, &config, pixels, &stats);
+	printf(
+		"traced %ux%u at %u samples with %u threads: %llu rays in %.2f s after %.2f s of preparation, %.2f M rays/s\n",
+		config.width, config.height, config.samplesPerPixel, threadsCount + 1, (unsigned long long)stats.raysCount, stats.seconds,
+		stats.prepareSeconds, stats.raysPerSecond / 1e6
+	);
+
+	if (!stbi_write_png(outputFilepath, (int)config.width, (int)config.height, 4, pixels, 4 * (int)config.width)) {
+		printf("failed to write %s\n", outputFilepath);
+		return 1;
+	}
+	printf("wrote %s\n", outputFilepath);
+	free(pixels);
+	return 0;
+}
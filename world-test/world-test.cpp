@@ -0,0 +1,2361 @@
+#include "../src/world_file.h"
+#include "../src/world_streaming.h"
+#include "../src/vox.h"
+#include "../src/edit_journal.h"
+#include "../src/voxel_region.h"
+#include "../src/voxel_selection.h"
+#include "../src/voxel_translucency.h"
+#include "../src/radix_sort.h"
+#include "../src/voxel_occlusion.h"
+#include "../src/voxel_light.h"
+#include "../src/voxel_shadow.h"
+#include "../src/voxel_tracer.h"
+#include "../src/texture.h"
+#include "../src/asset_pack.h"
+#define STB_IMAGE_IMPLEMENTATION
+#include "../src/third_party/stb/stb_image.h"
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "../src/third_party/stb/stb_image_write.h"
+#include "stdio.h"
+#include "stdlib.h"
+#include "string.h"
+#include <math.h>
+
+static const char* testWorldPath = "world-test.vxworld";
+static const char* testVoxPath = "world-test.vox";
+static const char* testJournalPath = "world-test.vxjournal";
+
+static u32 randomState = 12345;
+static u32 nextRandom() {
+	randomState ^= randomState << 13;
+	randomState ^= randomState >> 17;
+	randomState ^= randomState << 5;
+	return randomState;
+}
+
+//groups of voxels in rows, like a built scene. colors and scales repeat so they form runs
+static void fillVoxelArray(VoxelArray* voxelArray, i32 voxelsCount) {
+	RGBAColorF32 palette[4] = { {1.0f, 1.0f, 1.0f, 1.0f}, {0.5f, 0.25f, 0.0f, 1.0f}, {0.0f, 1.0f, 1.0f, 0.2f}, {0.1f, 0.9f, 0.1f, 1.0f} };
+	i32 groupIndex = -1;
+	for (i32 i = 0; i < voxelsCount; i++) {
+		if (i % 1000 == 0) {
+			groupIndex = addEmptyVoxelGroup(voxelArray, math::Vector3{ (f32)(nextRandom() % 512), 0.0f, -(f32)(nextRandom() % 512) });
+			voxelArray->groups[groupIndex].rotation = math::createQuaternionRotation((f32)(nextRandom() % 628) / 100.0f, { 0.0f, 1.0f, 0.0f });
+		}
+		if (i % 777 == 5) {
+			addStandaloneVoxel(voxelArray, palette[0], Vector3i{ (i32)(nextRandom() % 100), 0, -(i32)(nextRandom() % 100) }, Vector3ui{ 8, 8, 8 });
+			continue;
+		}
+		i32 local = i % 1000;
+		Vector3i position = { (local % 10) * 2, (local / 100) * 2, ((local / 10) % 10) * 2 };
+		addVoxelToGroup(voxelArray, palette[(i / 64) % 4], position, Vector3ui{ 2, 2, 2 + (u32)(i / 300 % 2) }, groupIndex);
+	}
+}
+
+static bool32 areVoxelsEqual(VoxelArray* a, VoxelArray* b, i32 voxelIndex) {
+	return
+		memcmp(&a->colors[voxelIndex], &b->colors[voxelIndex], sizeof(RGBAColorF32)) == 0 &&
+		memcmp(&a->voxelsPosition[voxelIndex], &b->voxelsPosition[voxelIndex], sizeof(Vector3i)) == 0 &&
+		memcmp(&a->voxelsScale[voxelIndex], &b->voxelsScale[voxelIndex], sizeof(Vector3ui)) == 0 &&
+		a->voxelsGroupIndex[voxelIndex] == b->voxelsGroupIndex[voxelIndex];
+}
+
+//returns the index of the first voxel or group that differs, or -1
+static bool32 areVoxelSpansEqual(VoxelArray* a, VoxelArray* b, VoxelSpan span) {
+	for (i32 i = span.begin; i < span.end; i++) {
+		if (!areVoxelsEqual(a, b, i)) {
+			return 0;
+		}
+	}
+	return 1;
+}
+
+static i32 compareVoxelArrays(VoxelArray* a, VoxelArray* b) {
+	if (a->voxelsCount != b->voxelsCount || a->groupsCount != b->groupsCount) {
+		return 0;
+	}
+	for (i32 i = 0; i < a->voxelsCount; i++) {
+		if (!areVoxelsEqual(a, b, i)) {
+			return i;
+		}
+	}
+	for (i32 i = 0; i < a->groupsCount; i++) {
+		VoxelGroup* ga = &a->groups[i];
+		VoxelGroup* gb = &b->groups[i];
+		if (
+			memcmp(&ga->position, &gb->position, sizeof(math::Vector3)) != 0 || memcmp(&ga->rotation, &gb->rotation, sizeof(math::Quaternion)) != 0 ||
+			ga->voxelsCount != gb->voxelsCount || ga->voxelsBegin != gb->voxelsBegin || ga->voxelsEnd != gb->voxelsEnd
+		) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+static void copyVoxelArray(VoxelArray* to, VoxelArray* from) {
+	_assert(to->voxelsCapacity >= from->voxelsCount && to->groupsCapacity >= from->groupsCount);
+	to->voxelsCount = from->voxelsCount;
+	to->groupsCount = from->groupsCount;
+	memcpy(to->colors, from->colors, from->voxelsCount * sizeof(RGBAColorF32));
+	memcpy(to->voxelsPosition, from->voxelsPosition, from->voxelsCount * sizeof(Vector3i));
+	memcpy(to->voxelsScale, from->voxelsScale, from->voxelsCount * sizeof(Vector3ui));
+	memcpy(to->voxelsGroupIndex, from->voxelsGroupIndex, from->voxelsCount * sizeof(i32));
+	memcpy(to->groups, from->groups, from->groupsCount * sizeof(VoxelGroup));
+}
+
+static u64 getFileSize(const char* filepath) {
+	MappedFile file;
+	if (!mapFile(filepath, &file)) {
+		return 0;
+	}
+	u64 size = file.size;
+	unmapFile(&file);
+	return size;
+}
+
+//.vox files are built by hand, so the importer isn't only tested against the exporter
+struct VoxFixture {
+	u8 data[4096];
+	u32 size;
+};
+
+static void appendFixtureBytes(VoxFixture* fixture, const void* data, u32 size) {
+	memcpy(&fixture->data[fixture->size], data, size);
+	fixture->size += size;
+}
+
+static void appendFixtureI32(VoxFixture* fixture, i32 value) {
+	appendFixtureBytes(fixture, &value, sizeof(value));
+}
+
+static void appendFixtureString(VoxFixture* fixture, const char* text) {
+	appendFixtureI32(fixture, (i32)strlen(text));
+	appendFixtureBytes(fixture, text, (u32)strlen(text));
+}
+
+//returns where the chunk's content starts
+static u32 beginFixtureChunk(VoxFixture* fixture, const char* id) {
+	appendFixtureBytes(fixture, id, 4);
+	appendFixtureI32(fixture, 0);
+	appendFixtureI32(fixture, 0);
+	return fixture->size;
+}
+
+static void endFixtureChunk(VoxFixture* fixture, u32 contentOffset) {
+	i32 size = (i32)(fixture->size - contentOffset);
+	memcpy(&fixture->data[contentOffset - 8], &size, sizeof(size));
+}
+
+static void beginFixtureFile(VoxFixture* fixture) {
+	fixture->size = 0;
+	appendFixtureBytes(fixture, "VOX ", 4);
+	appendFixtureI32(fixture, 150);
+	beginFixtureChunk(fixture, "MAIN");
+}
+
+static bool32 endFixtureFile(VoxFixture* fixture, const char* filepath, u32 truncatedBytes) {
+	i32 childrenSize = (i32)(fixture->size - 20);
+	memcpy(&fixture->data[16], &childrenSize, sizeof(childrenSize));
+	FILE* file = fopen(filepath, "wb");
+	if (file == nil) {
+		return 0;
+	}
+	bool32 isWritten = fwrite(fixture->data, 1, fixture->size - truncatedBytes, file) == fixture->size - truncatedBytes;
+	return fclose(file) == 0 && isWritten;
+}
+
+static void appendFixtureModel(VoxFixture* fixture, i32 x, i32 y, i32 z, const u8* voxels, i32 voxelsCount) {
+	u32 content = beginFixtureChunk(fixture, "SIZE");
+	appendFixtureI32(fixture, x);
+	appendFixtureI32(fixture, y);
+	appendFixtureI32(fixture, z);
+	endFixtureChunk(fixture, content);
+	content = beginFixtureChunk(fixture, "XYZI");
+	appendFixtureI32(fixture, voxelsCount);
+	appendFixtureBytes(fixture, voxels, voxelsCount * 4);
+	endFixtureChunk(fixture, content);
+}
+
+static void appendFixtureTransform(VoxFixture* fixture, i32 nodeId, i32 childNodeId, const char* translation, const char* rotation, bool32 isHidden) {
+	u32 content = beginFixtureChunk(fixture, "nTRN");
+	appendFixtureI32(fixture, nodeId);
+	appendFixtureI32(fixture, isHidden ? 1 : 0);
+	if (isHidden) {
+		appendFixtureString(fixture, "_hidden");
+		appendFixtureString(fixture, "1");
+	}
+	appendFixtureI32(fixture, childNodeId);
+	appendFixtureI32(fixture, -1);
+	appendFixtureI32(fixture, 0);
+	appendFixtureI32(fixture, 1);
+	appendFixtureI32(fixture, (translation != nil) + (rotation != nil));
+	if (translation != nil) {
+		appendFixtureString(fixture, "_t");
+		appendFixtureString(fixture, translation);
+	}
+	if (rotation != nil) {
+		appendFixtureString(fixture, "_r");
+		appendFixtureString(fixture, rotation);
+	}
+	endFixtureChunk(fixture, content);
+}
+
+static void appendFixtureShape(VoxFixture* fixture, i32 nodeId, i32 modelId) {
+	u32 content = beginFixtureChunk(fixture, "nSHP");
+	appendFixtureI32(fixture, nodeId);
+	appendFixtureI32(fixture, 0);
+	appendFixtureI32(fixture, 1);
+	appendFixtureI32(fixture, modelId);
+	appendFixtureI32(fixture, 0);
+	endFixtureChunk(fixture, content);
+}
+
+//in voxel units, with the transform of the voxel's group
+static math::Vector3 calculateVoxelGroupedPosition(VoxelArray* voxelArray, i32 voxelIndex, math::Vector3 offset) {
+	Vector3i p = voxelArray->voxelsPosition[voxelIndex];
+	VoxelGroup* group = &voxelArray->groups[voxelArray->voxelsGroupIndex[voxelIndex]];
+	math::Vector3 local = math::Vector3{ (f32)p.x, (f32)p.y, (f32)p.z }.add(offset);
+	return math::rotateVector(local, group->rotation).add(group->position);
+}
+
+static bool32 areVectorsNear(math::Vector3 a, math::Vector3 b) {
+	return fabsf(a.x - b.x) < 0.01f && fabsf(a.y - b.y) < 0.01f && fabsf(a.z - b.z) < 0.01f;
+}
+
+static u32 packTestColor(RGBAColorF32 color) {
+	return (u32)(color.r * 255.0f + 0.5f) | ((u32)(color.g * 255.0f + 0.5f) << 8) | ((u32)(color.b * 255.0f + 0.5f) << 16) | ((u32)(color.a * 255.0f + 0.5f) << 24);
+}
+
+//a cube of voxelSize in the world, for comparing voxel arrays cut into different voxels
+struct TestVoxCell {
+	i32 position[3];
+	u32 color;
+};
+
+static int compareTestVoxCells(const void* a, const void* b) {
+	const TestVoxCell* x = (const TestVoxCell*)a;
+	const TestVoxCell* y = (const TestVoxCell*)b;
+	for (i32 i = 0; i < 3; i++) {
+		if (x->position[i] != y->position[i]) {
+			return x->position[i] < y->position[i] ? -1 : 1;
+		}
+	}
+	return x->color < y->color ? -1 : x->color > y->color;
+}
+
+//every voxel has to line up with the cells of 2, so its size is a multiple of 2 and its sides are on odd positions
+static i32 collectTestVoxCells(VoxelArray* voxelArray, TestVoxCell* cells) {
+	i32 cellsCount = 0;
+	for (i32 i = 0; i < voxelArray->voxelsCount; i++) {
+		Vector3i p = voxelArray->voxelsPosition[i];
+		i32 half[3] = { (i32)voxelArray->voxelsScale[i].x / 2, (i32)voxelArray->voxelsScale[i].y / 2, (i32)voxelArray->voxelsScale[i].z / 2 };
+		//the cells of 2, which are centered on even positions
+		for (i32 z = 1 - half[2]; z < half[2]; z++) {
+			for (i32 y = 1 - half[1]; y < half[1]; y++) {
+				for (i32 x = 1 - half[0]; x < half[0]; x++) {
+					if (((p.x + x) | (p.y + y) | (p.z + z)) & 1) {
+						continue;
+					}
+					math::Vector3 offset = { (f32)x, (f32)y, (f32)z };
+					math::Vector3 position = calculateVoxelGroupedPosition(voxelArray, i, offset);
+					TestVoxCell* cell = &cells[cellsCount++];
+					cell->position[0] = (i32)roundf(position.x);
+					cell->position[1] = (i32)roundf(position.y);
+					cell->position[2] = (i32)roundf(position.z);
+					cell->color = packTestColor(voxelArray->colors[i]);
+				}
+			}
+		}
+	}
+	qsort(cells, cellsCount, sizeof(TestVoxCell), compareTestVoxCells);
+	return cellsCount;
+}
+
+static math::Vector3 calculateTestVoxelWorldCenter(VoxelArray* voxelArray, i32 voxelIndex) {
+	math::Matrix4 model = calculateVoxelModelMatrix(voxelArray, voxelIndex);
+	return math::Vector3{ model.e.m03, model.e.m13, model.e.m23 };
+}
+
+static bool32 isTestPointInBox(AABB box, math::Vector3 p) {
+	return p.x >= box.min.x && p.x <= box.max.x && p.y >= box.min.y && p.y <= box.max.y && p.z >= box.min.z && p.z <= box.max.z;
+}
+
+//returns the first voxel whose selection differs from want, or -1
+static i32 compareTestSelection(VoxelSelection* selection, VoxelArray* voxelArray, const u8* want) {
+	i32 wantCount = 0;
+	for (i32 i = 0; i < voxelArray->voxelsCount; i++) {
+		if (isVoxelSelected(selection, i) != (bool32)want[i]) {
+			return i;
+		}
+		wantCount += want[i];
+	}
+	return selection->selectedCount == wantCount ? -1 : voxelArray->voxelsCount;
+}
+
+struct TestSortPair {
+	u64 key;
+	u32 value;
+};
+
+//by key, then by value, which is the order a stable sort leaves pairs in when the values start out in increasing order
+static int compareTestSortPairs(const void* a, const void* b) {
+	const TestSortPair* x = (const TestSortPair*)a;
+	const TestSortPair* y = (const TestSortPair*)b;
+	if (x->key != y->key) {
+		return x->key < y->key ? -1 : 1;
+	}
+	return x->value < y->value ? -1 : (x->value > y->value ? 1 : 0);
+}
+
+//collects the dirty voxels and updates their occlusion, and fails when the chunks it recomputed don't cover [begin, end)
+static bool32 updateTestVoxelOcclusion(VoxelOcclusion* occlusion, VoxelArray* voxelArray, JobQueue* jobQueue, i32 begin, i32 end) {
+	VoxelSpan spans[MAX_DIRTY_VOXEL_SPANS];
+	i32 spansCount = collectDirtyVoxelSpans(voxelArray, spans, MAX_DIRTY_VOXEL_SPANS);
+	updateVoxelOcclusion(occlusion, voxelArray, jobQueue, spans, spansCount);
+	VoxelSpan changed = {};
+	if (!collectVoxelOcclusionChanges(occlusion, &changed) || changed.begin > begin || changed.end < end) {
+		printf("voxels [%d, %d) were recomputed, which doesn't cover [%d, %d)\n", changed.begin, changed.end, begin, end);
+		return 0;
+	}
+	return 1;
+}
+
+static bool32 checkTestFaceOcclusion(u64 occlusion, VoxelFace face, u32 corner0, u32 corner1, u32 corner2, u32 corner3, bool32 isFlipped) {
+	u32 want[4] = { corner0, corner1, corner2, corner3 };
+	for (u32 c = 0; c < 4; c++) {
+		if (getVoxelCornerOcclusion(occlusion, face, c) != want[c]) {
+			printf("corner %u of face %u has an occlusion of %u, not %u\n", c, face, getVoxelCornerOcclusion(occlusion, face, c), want[c]);
+			return 0;
+		}
+	}
+	if (isVoxelFaceFlipped(occlusion, face) != isFlipped) {
+		printf("face %u was %s\n", face, isFlipped ? "not flipped" : "flipped");
+		return 0;
+	}
+	return 1;
+}
+
+//the light of the cell at x, y, z of a test volume of 4 voxel units a cell, whose origin is at 0
+static u8 getTestCellLight(VoxelLight* light, i32 x, i32 y, i32 z) {
+	return getVoxelLightAt(light, Vector3i{ 4 * x + 2, 4 * y + 2, 4 * z + 2 });
+}
+
+static bool32 checkTestCellLight(VoxelLight* light, i32 x, i32 y, i32 z, u32 block, u32 sky) {
+	u8 levels = getTestCellLight(light, x, y, z);
+	if (getVoxelBlockLight(levels) != block || getVoxelSkyLight(levels) != sky) {
+		printf("cell %d %d %d has a block light of %u and a sky light of %u, not %u and %u\n", x, y, z, getVoxelBlockLight(levels), getVoxelSkyLight(levels), block, sky);
+		return 0;
+	}
+	return 1;
+}
+
+static void updateTestVoxelLight(VoxelLight* light, VoxelArray* voxelArray, JobQueue* jobQueue, i32 maxNodes) {
+	VoxelSpan spans[MAX_DIRTY_VOXEL_SPANS];
+	i32 spansCount = collectDirtyVoxelSpans(voxelArray, spans, MAX_DIRTY_VOXEL_SPANS);
+	updateVoxelLight(light, voxelArray, jobQueue, spans, spansCount, maxNodes);
+}
+
+//a layer of voxels the size of a cell, one in each cell of the layer y that's inside [0, 32) along x and z, and [begin, end) along the other
+static void addTestLightLayer(VoxelArray* voxelArray, i32 groupIndex, bool32 isHorizontal, i32 layer, i32 begin, i32 end) {
+	RGBAColorF32 white = { 1.0f, 1.0f, 1.0f, 1.0f };
+	for (i32 a = 0; a < 32; a++) {
+		for (i32 b = begin; b < end; b++) {
+			Vector3i p = isHorizontal ? Vector3i{ 4 * a + 2, 4 * layer + 2, 4 * b + 2 } : Vector3i{ 4 * layer + 2, 4 * b + 2, 4 * a + 2 };
+			addVoxelToGroup(voxelArray, white, p, Vector3ui{ 4, 4, 4 }, groupIndex);
+		}
+	}
+}
+
+//size keeps counting past capacity, so a png that didn't fit is noticed
+struct TestPNG {
+	u8* data;
+	u64 size;
+	u64 capacity;
+};
+
+static void writeTestPNG(void* context, void* data, int size) {
+	TestPNG* png = (TestPNG*)context;
+	if (png->size + size <= png->capacity) {
+		memcpy(&png->data[png->size], data, size);
+	}
+	png->size += size;
+}
+
+int main() {
+	const i32 voxelsCount = 10 * VOXELS_PER_CHUNK + 123;
+	MemoryAllocator memoryAllocator = {};
+	initMemoryAllocator(&memoryAllocator, 512ull * 1024 * 1024);
+
+	VoxelArray source = {};
+	initVoxelArray(&source, &memoryAllocator, 12 * VOXELS_PER_CHUNK, 12 * VOXELS_PER_CHUNK);
+	fillVoxelArray(&source, voxelsCount);
+
+	{
+		u8* data = (u8*) malloc(calculateWorldChunkMaxEncodedSize(VOXELS_PER_CHUNK));
+		VoxelArray decoded = {};
+		initVoxelArray(&decoded, &memoryAllocator, source.voxelsCapacity, 1);
+		decoded.groupsCount = source.groupsCount;
+		VoxelSpan span = { VOXELS_PER_CHUNK, 2 * VOXELS_PER_CHUNK };
+		u64 size = encodeWorldChunk(&source, span, data);
+		if (size > calculateWorldChunkMaxEncodedSize(VOXELS_PER_CHUNK) || size > VOXELS_PER_CHUNK * 16) {
+			printf("a chunk of repeating voxels took %llu bytes\n", (unsigned long long)size);
+			return 1;
+		}
+		if (!decodeWorldChunk(data, size, &decoded, span)) {
+			printf("a chunk failed to decode\n");
+			return 1;
+		}
+		for (i32 i = span.begin; i < span.end; i++) {
+			if (!areVoxelsEqual(&source, &decoded, i)) {
+				printf("voxel %d changed in a chunk round trip\n", i);
+				return 1;
+			}
+		}
+		if (decodeWorldChunk(data, size - 1, &decoded, span) || decodeWorldChunk(data, size, &decoded, VoxelSpan{ span.begin, span.end - 1 })) {
+			printf("a truncated payload, or one with too many voxels, decoded\n");
+			return 1;
+		}
+		//any corrupted byte either fails to decode or decodes to valid voxels, never reads past the payload
+		for (u32 i = 0; i < 1000; i++) {
+			u64 byteIndex = nextRandom() % size;
+			u8 original = data[byteIndex];
+			data[byteIndex] ^= (u8)(1 + nextRandom() % 255);
+			decodeWorldChunk(data, size, &decoded, span);
+			data[byteIndex] = original;
+		}
+		free(data);
+	}
+
+	{
+		Vector3i positions[] = { { 0, 0, 0 }, { -1, 2, -3 }, { VOXEL_MORTON_BIAS - 1, -VOXEL_MORTON_BIAS, 12345 } };
+		for (i32 i = 0; i < 3; i++) {
+			Vector3i decoded = decodeVoxelMortonCode(calculateVoxelMortonCode(positions[i]));
+			if (memcmp(&decoded, &positions[i], sizeof(Vector3i)) != 0) {
+				printf("position %d changed in a morton code round trip\n", i);
+				return 1;
+			}
+		}
+
+		//a solid cube that's aligned to a power of 2, sorted in morton order, is a single run of codes
+		VoxelArray cube = {};
+		initVoxelArray(&cube, &memoryAllocator, VOXELS_PER_CHUNK, 1);
+		i32 groupIndex = addEmptyVoxelGroup(&cube, math::Vector3{});
+		for (i32 i = 0; i < VOXELS_PER_CHUNK; i++) {
+			addVoxelToGroup(&cube, RGBAColorF32{ 1.0f, 1.0f, 1.0f, 1.0f }, Vector3i{ 15 - i % 16, (i / 16) % 16, i / 256 }, Vector3ui{ 1, 1, 1 }, groupIndex);
+		}
+		sortVoxelsInMortonOrder(&cube, VoxelSpan{ 0, VOXELS_PER_CHUNK });
+		u64 sum[3] = {};
+		for (i32 i = 0; i < VOXELS_PER_CHUNK; i++) {
+			Vector3i p = cube.voxelsPosition[i];
+			sum[0] += p.x;
+			sum[1] += p.y;
+			sum[2] += p.z;
+			if (i > 0 && calculateVoxelMortonCode(p) != calculateVoxelMortonCode(cube.voxelsPosition[i - 1]) + 1) {
+				printf("voxel %d isn't in morton order after sorting\n", i);
+				return 1;
+			}
+		}
+		if (sum[0] != 15 * VOXELS_PER_CHUNK / 2 || sum[1] != sum[0] || sum[2] != sum[0]) {
+			printf("sorting lost or duplicated voxels\n");
+			return 1;
+		}
+		u8* data = (u8*) malloc(calculateWorldChunkMaxEncodedSize(VOXELS_PER_CHUNK));
+		u64 size = encodeWorldChunk(&cube, VoxelSpan{ 0, VOXELS_PER_CHUNK }, data);
+		VoxelArray decoded = {};
+		initVoxelArray(&decoded, &memoryAllocator, VOXELS_PER_CHUNK, 1);
+		decoded.groupsCount = 1;
+		if (size > 64 || !decodeWorldChunk(data, size, &decoded, VoxelSpan{ 0, VOXELS_PER_CHUNK }) || !areVoxelSpansEqual(&cube, &decoded, VoxelSpan{ 0, VOXELS_PER_CHUNK })) {
+			printf("a sorted cube took %llu bytes, or changed in a round trip\n", (unsigned long long)size);
+			return 1;
+		}
+
+		//positions too far out for morton codes fall back to deltas
+		cube.voxelsPosition[7].x = 1 << 30;
+		size = encodeWorldChunk(&cube, VoxelSpan{ 0, VOXELS_PER_CHUNK }, data);
+		if (!decodeWorldChunk(data, size, &decoded, VoxelSpan{ 0, VOXELS_PER_CHUNK }) || !areVoxelSpansEqual(&cube, &decoded, VoxelSpan{ 0, VOXELS_PER_CHUNK })) {
+			printf("a chunk with a position out of the morton range changed in a round trip\n");
+			return 1;
+		}
+		free(data);
+	}
+
+	remove(testWorldPath);
+	World* world = (World*) malloc(sizeof(World));
+	initWorld(world, &memoryAllocator, &source, testWorldPath);
+	if (!saveWorld(world) || !world->wasLastSaveCompacted) {
+		printf("the first save of a world failed or didn't write a whole file\n");
+		return 1;
+	}
+
+	VoxelArray loaded = {};
+	initVoxelArray(&loaded, &memoryAllocator, source.voxelsCapacity, source.groupsCapacity);
+	World* loadedWorld = (World*) malloc(sizeof(World));
+	initWorld(loadedWorld, &memoryAllocator, &loaded, testWorldPath);
+	{
+		if (!openWorld(loadedWorld)) {
+			printf("the saved world didn't open\n");
+			return 1;
+		}
+		//only the partially filled last chunk is loaded up front
+		if (loadedWorld->loadedChunksCount != 1 || !loadedWorld->isChunkLoaded[10] || loadedWorld->isChunkLoaded[0] || loaded.voxelsScale[0].x != 0) {
+			printf("opening a world loaded %d chunks\n", loadedWorld->loadedChunksCount);
+			return 1;
+		}
+		for (u32 i = 0; i < loadedWorld->header.chunksCount; i++) {
+			for (i32 v = i * VOXELS_PER_CHUNK; v < MIN((i32)(i + 1) * VOXELS_PER_CHUNK, voxelsCount); v++) {
+				Vector3i boundsMin = loadedWorld->chunks[i].boundsMin;
+				Vector3i boundsMax = loadedWorld->chunks[i].boundsMax;
+				math::Vector3 center = math::rotateVector(
+					math::Vector3{ (f32)source.voxelsPosition[v].x, (f32)source.voxelsPosition[v].y, (f32)source.voxelsPosition[v].z },
+					source.groups[source.voxelsGroupIndex[v]].rotation
+				).add(source.groups[source.voxelsGroupIndex[v]].position);
+				if (center.x < boundsMin.x || center.y < boundsMin.y || center.z < boundsMin.z || center.x > boundsMax.x || center.y > boundsMax.y || center.z > boundsMax.z) {
+					printf("voxel %d is outside the bounds of chunk %u\n", v, i);
+					return 1;
+				}
+			}
+		}
+		if (!loadWorldChunk(loadedWorld, 3) || !areVoxelsEqual(&source, &loaded, 3 * VOXELS_PER_CHUNK) || loaded.isChunkModified[3]) {
+			printf("chunk 3 didn't load on its own, or loading it marked it as modified\n");
+			return 1;
+		}
+		while (loadWorldChunks(loadedWorld, 4) > 0) {}
+		i32 mismatch = compareVoxelArrays(&source, &loaded);
+		if (mismatch >= 0 || loadedWorld->loadedChunksCount != 11) {
+			printf("the loaded world differs from the saved one at voxel or group %d\n", mismatch);
+			return 1;
+		}
+	}
+
+	{
+		//a small edit appends one chunk and the tables
+		if (isWorldModified(loadedWorld)) {
+			printf("a world that was only opened and loaded counts as modified\n");
+			return 1;
+		}
+		u64 sizeBefore = getFileSize(testWorldPath);
+		i32 edited = 5 * VOXELS_PER_CHUNK + 17;
+		loaded.colors[edited] = RGBAColorF32{ 0.25f, 0.5f, 0.75f, 1.0f };
+		markVoxelDirty(&loaded, edited);
+		loaded.groups[2].position.x += 8.0f;
+		markVoxelGroupDirty(&loaded, 2);
+		if (!saveWorld(loadedWorld) || loadedWorld->wasLastSaveCompacted) {
+			printf("saving a small edit failed or rewrote the whole file\n");
+			return 1;
+		}
+		if (isWorldModified(loadedWorld)) {
+			printf("a world counts as modified right after saving it\n");
+			return 1;
+		}
+		//moving a group alone is a change worth saving
+		loaded.groups[2].position.x -= 8.0f;
+		markVoxelGroupDirty(&loaded, 2);
+		bool32 isMovedGroupModified = isWorldModified(loadedWorld);
+		loaded.groups[2].position.x += 8.0f;
+		if (!isMovedGroupModified) {
+			printf("moving a group didn't modify the world\n");
+			return 1;
+		}
+		u64 appendedSize = getFileSize(testWorldPath) - sizeBefore;
+		u64 tablesSize = (u64)loaded.groupsCount * sizeof(WorldFileGroup) + (u64)loadedWorld->header.chunksCount * sizeof(WorldChunkEntry);
+		if (appendedSize > tablesSize + WORLD_FILE_TABLE_ALIGNMENT + loadedWorld->chunks[5].size || loaded.isChunkModified[5]) {
+			printf("saving a small edit appended %llu bytes\n", (unsigned long long)appendedSize);
+			return 1;
+		}
+		//new voxels go into the partially filled last chunk and a new one after it
+		for (i32 i = 0; i < VOXELS_PER_CHUNK; i++) {
+			addVoxelToGroup(&loaded, RGBAColorF32{ 1.0f, 0.0f, 0.0f, 1.0f }, Vector3i{ i, 0, 0 }, Vector3ui{ 1, 1, 1 }, 0);
+		}
+		if (!saveWorld(loadedWorld)) {
+			printf("saving added voxels failed\n");
+			return 1;
+		}
+
+		VoxelArray reloaded = {};
+		initVoxelArray(&reloaded, &memoryAllocator, source.voxelsCapacity, source.groupsCapacity);
+		World* reloadedWorld = (World*) malloc(sizeof(World));
+		initWorld(reloadedWorld, &memoryAllocator, &reloaded, testWorldPath);
+		if (!openWorld(reloadedWorld)) {
+			printf("the world didn't open after appending to it\n");
+			return 1;
+		}
+		while (loadWorldChunks(reloadedWorld, 100) > 0) {}
+		i32 mismatch = compareVoxelArrays(&loaded, &reloaded);
+		if (mismatch >= 0) {
+			printf("the appended world differs at voxel or group %d\n", mismatch);
+			return 1;
+		}
+		closeWorld(reloadedWorld);
+	}
+
+	{
+		//a snapshot keeps a chunk as it was, by copying it only when it's written before the reader got to it
+		VoxelSnapshot* snapshot = (VoxelSnapshot*) malloc(sizeof(VoxelSnapshot));
+		initVoxelSnapshot(snapshot, &memoryAllocator, &loaded);
+		u8* isChunkShared = (u8*) calloc(loaded.chunksCapacity, 1);
+		isChunkShared[0] = 1;
+		isChunkShared[1] = 1;
+		beginVoxelSnapshot(snapshot, &loaded, isChunkShared);
+		RGBAColorF32 before = loaded.colors[5];
+		prepareVoxelSpanWrite(&loaded, VoxelSpan{ 5, 6 });
+		loaded.colors[5].r = before.r + 1.0f;
+		prepareVoxelSpanWrite(&loaded, VoxelSpan{ 7, 8 });
+		VoxelArray voxels = {};
+		acquireVoxelSnapshotChunk(snapshot, &loaded, 0, &voxels);
+		if (voxels.colors == loaded.colors || voxels.colors[5].r != before.r || voxels.voxelsCount != VOXELS_PER_CHUNK || snapshot->copiedChunksCount != 1) {
+			printf("writing to a shared chunk didn't copy it for the snapshot\n");
+			return 1;
+		}
+		releaseVoxelSnapshotChunk(snapshot, 0);
+		acquireVoxelSnapshotChunk(snapshot, &loaded, 1, &voxels);
+		if (voxels.colors != &loaded.colors[VOXELS_PER_CHUNK]) {
+			printf("a chunk that wasn't written wasn't shared with the snapshot\n");
+			return 1;
+		}
+		releaseVoxelSnapshotChunk(snapshot, 1);
+		//once it was read, or if it isn't shared, writing doesn't copy it
+		prepareVoxelSpanWrite(&loaded, VoxelSpan{ VOXELS_PER_CHUNK, 3 * VOXELS_PER_CHUNK });
+		if (snapshot->copiedChunksCount != 1) {
+			printf("writing to a chunk the snapshot doesn't need copied it\n");
+			return 1;
+		}
+		endVoxelSnapshot(snapshot, &loaded);
+		loaded.colors[5] = before;
+		if (loaded.snapshot != nil || snapshot->chunksCopy[0] != nil) {
+			printf("ending the snapshot didn't free its copies\n");
+			return 1;
+		}
+		free(isChunkShared);
+		free(snapshot);
+	}
+
+	{
+		//a save started in the background writes the world as it was when it started, while it's edited
+		i32 edited = 2 * VOXELS_PER_CHUNK + 5;
+		markVoxelSpanDirty(&loaded, VoxelSpan{ 0, loaded.voxelsCount });
+		if (!beginWorldSave(loadedWorld) || beginWorldSave(loadedWorld) || canUnloadWorldChunk(loadedWorld, 0)) {
+			printf("a background save didn't start, started twice, or let its chunks be unloaded\n");
+			return 1;
+		}
+		RGBAColorF32 before = loaded.colors[edited];
+		prepareVoxelSpanWrite(&loaded, VoxelSpan{ edited, edited + 1 });
+		loaded.colors[edited] = RGBAColorF32{ 0.0f, 1.0f, 0.0f, 1.0f };
+		markVoxelDirty(&loaded, edited);
+		if (!finishWorldSave(loadedWorld) || !loaded.isChunkModified[2] || loaded.isChunkModified[1] || !canUnloadWorldChunk(loadedWorld, 0)) {
+			printf("the background save failed, or didn't keep the chunk edited during it modified\n");
+			return 1;
+		}
+
+		VoxelArray reloaded = {};
+		initVoxelArray(&reloaded, &memoryAllocator, source.voxelsCapacity, source.groupsCapacity);
+		World* reloadedWorld = (World*) malloc(sizeof(World));
+		initWorld(reloadedWorld, &memoryAllocator, &reloaded, testWorldPath);
+		if (!openWorld(reloadedWorld)) {
+			printf("the world didn't open after a background save\n");
+			return 1;
+		}
+		while (loadWorldChunks(reloadedWorld, 100) > 0) {}
+		RGBAColorF32 after = loaded.colors[edited];
+		loaded.colors[edited] = before;
+		i32 mismatch = compareVoxelArrays(&loaded, &reloaded);
+		loaded.colors[edited] = after;
+		if (mismatch >= 0) {
+			printf("the background save differs from the world when it started at voxel or group %d\n", mismatch);
+			return 1;
+		}
+		closeWorld(reloadedWorld);
+	}
+
+	{
+		//rewriting every chunk over and over eventually compacts the file
+		bool32 wasCompacted = 0;
+		for (i32 s = 0; s < 4 && !wasCompacted; s++) {
+			markVoxelSpanDirty(&loaded, VoxelSpan{ 0, loaded.voxelsCount });
+			if (!saveWorld(loadedWorld)) {
+				printf("save %d failed\n", s);
+				return 1;
+			}
+			wasCompacted = loadedWorld->wasLastSaveCompacted;
+		}
+		if (!wasCompacted || loadedWorld->header.deadBytes != 0 || getFileSize(testWorldPath) != loadedWorld->header.fileSize) {
+			printf("rewriting every chunk never compacted the file\n");
+			return 1;
+		}
+		VoxelArray reloaded = {};
+		initVoxelArray(&reloaded, &memoryAllocator, source.voxelsCapacity, source.groupsCapacity);
+		World* reloadedWorld = (World*) malloc(sizeof(World));
+		initWorld(reloadedWorld, &memoryAllocator, &reloaded, testWorldPath);
+		if (!openWorld(reloadedWorld)) {
+			printf("the compacted world didn't open\n");
+			return 1;
+		}
+		while (loadWorldChunks(reloadedWorld, 100) > 0) {}
+		i32 mismatch = compareVoxelArrays(&loaded, &reloaded);
+		if (mismatch >= 0) {
+			printf("the compacted world differs at voxel or group %d\n", mismatch);
+			return 1;
+		}
+		closeWorld(reloadedWorld);
+	}
+
+	{
+		//a save that never got to its header leaves the previous save readable
+		closeWorld(loadedWorld);
+		if (loadedWorld->hasSaveThread) {
+			printf("closing a world left its save thread running\n");
+			return 1;
+		}
+		FILE* file = fopen(testWorldPath, "ab");
+		const u8 garbage[100] = { 1, 2, 3 };
+		fwrite(garbage, 1, sizeof(garbage), file);
+		fclose(file);
+		VoxelArray reloaded = {};
+		initVoxelArray(&reloaded, &memoryAllocator, source.voxelsCapacity, source.groupsCapacity);
+		World* reloadedWorld = (World*) malloc(sizeof(World));
+		initWorld(reloadedWorld, &memoryAllocator, &reloaded, testWorldPath);
+		if (!openWorld(reloadedWorld)) {
+			printf("a world with bytes after its last save didn't open\n");
+			return 1;
+		}
+		closeWorld(reloadedWorld);
+
+		file = fopen(testWorldPath, "r+b");
+		WorldFileHeader header;
+		fread(&header, sizeof(header), 1, file);
+		header.directoryOffset = header.fileSize - 8;
+		fseek(file, 0, SEEK_SET);
+		fwrite(&header, sizeof(header), 1, file);
+		fclose(file);
+		initVoxelArray(&reloaded, &memoryAllocator, source.voxelsCapacity, source.groupsCapacity);
+		initWorld(reloadedWorld, &memoryAllocator, &reloaded, testWorldPath);
+		if (openWorld(reloadedWorld)) {
+			printf("a world with its directory past the end of the file opened\n");
+			return 1;
+		}
+	}
+	remove(testWorldPath);
+
+	{
+		//one group of voxels per chunk, every chunk 1000 voxel units further along x than the one before
+		const i32 chunksCount = 16;
+		VoxelArray spread = {};
+		initVoxelArray(&spread, &memoryAllocator, chunksCount * VOXELS_PER_CHUNK, chunksCount);
+		for (i32 c = 0; c < chunksCount; c++) {
+			i32 groupIndex = addEmptyVoxelGroup(&spread, math::Vector3{ (f32)(c * 1000), 0.0f, 0.0f });
+			for (i32 i = 0; i < VOXELS_PER_CHUNK; i++) {
+				addVoxelToGroup(&spread, RGBAColorF32{ (f32)c, 0.0f, 0.0f, 1.0f }, Vector3i{ i % 16, (i / 16) % 16, i / 256 }, Vector3ui{ 1, 1, 1 }, groupIndex);
+			}
+		}
+		World* spreadWorld = (World*) malloc(sizeof(World));
+		initWorld(spreadWorld, &memoryAllocator, &spread, testWorldPath);
+		if (!saveWorld(spreadWorld)) {
+			printf("saving the spread out world failed\n");
+			return 1;
+		}
+
+		VoxelArray streamed = {};
+		initVoxelArray(&streamed, &memoryAllocator, spread.voxelsCapacity, spread.groupsCapacity);
+		World* streamedWorld = (World*) malloc(sizeof(World));
+		initWorld(streamedWorld, &memoryAllocator, &streamed, testWorldPath);
+		if (!openWorld(streamedWorld) || streamedWorld->loadedChunksCount != 0) {
+			printf("the spread out world didn't open, or loaded chunks when it did\n");
+			return 1;
+		}
+		JobQueue* jobQueue = (JobQueue*) malloc(sizeof(JobQueue));
+		initJobQueue(jobQueue, 2);
+		WorldStreamer* streamer = (WorldStreamer*) malloc(sizeof(WorldStreamer));
+		//a radius that reaches the camera's chunk and its neighbours, and a budget for 4 chunks
+		const u64 budget = 4 * VOXELS_PER_CHUNK * WORLD_VOXEL_RESIDENT_SIZE;
+		initWorldStreamer(streamer, &memoryAllocator, streamedWorld, jobQueue, budget, 1000.0f * voxelUnitsToWorldUnits);
+
+		//the camera flies along the chunks and back
+		for (i32 step = 0; step < 2 * chunksCount; step++) {
+			i32 cameraChunk = step < chunksCount ? step : 2 * chunksCount - 1 - step;
+			math::Vector3 cameraPosition = math::Vector3{ (f32)(cameraChunk * 1000) + 8.0f, 8.0f, 8.0f }.scale(voxelUnitsToWorldUnits);
+			for (i32 frame = 0; frame < 3; frame++) {
+				updateWorldStreaming(streamer, cameraPosition, math::initIdentityMatrix());
+				finishWorldStreaming(streamer);
+				if (getWorldResidentBytes(streamer) > budget) {
+					printf("%llu bytes are resident with a budget of %llu\n", (unsigned long long)getWorldResidentBytes(streamer), (unsigned long long)budget);
+					return 1;
+				}
+			}
+			if (!streamedWorld->isChunkLoaded[cameraChunk]) {
+				printf("the chunk the camera is in, %d, isn't loaded\n", cameraChunk);
+				return 1;
+			}
+			VoxelSpan span = getWorldChunkSpan(streamedWorld, cameraChunk);
+			for (i32 i = span.begin; i < span.end; i++) {
+				if (!areVoxelsEqual(&spread, &streamed, i)) {
+					printf("voxel %d of chunk %d is wrong after streaming it in\n", i, cameraChunk);
+					return 1;
+				}
+			}
+			//a modified chunk stays loaded until it's saved
+			if (cameraChunk == 2) {
+				streamed.colors[span.begin] = RGBAColorF32{ 0.5f, 0.5f, 0.5f, 1.0f };
+				spread.colors[span.begin] = streamed.colors[span.begin];
+				markVoxelDirty(&streamed, span.begin);
+			}
+			if (step > 2 && !streamedWorld->isChunkLoaded[2]) {
+				printf("the modified chunk was unloaded\n");
+				return 1;
+			}
+		}
+		if (streamer->unloadedChunksCount == 0 || streamedWorld->loadedChunksCount > 4) {
+			printf("streaming never unloaded a chunk\n");
+			return 1;
+		}
+		//unloaded voxels keep their scale and group index, so those aren't part of the budget
+		if (getWorldPinnedBytes(streamer) != (u64)streamed.voxelsCount * WORLD_VOXEL_PINNED_SIZE) {
+			printf("%llu bytes are pinned for %d voxels\n", (unsigned long long)getWorldPinnedBytes(streamer), streamed.voxelsCount);
+			return 1;
+		}
+		closeWorld(streamedWorld);
+	}
+	remove(testWorldPath);
+
+	{
+		//two models, one placed twice, a hidden shape and a palette
+		VoxFixture* fixture = (VoxFixture*) malloc(sizeof(VoxFixture));
+		beginFixtureFile(fixture);
+		const u8 model0[] = { 0, 0, 0, 1, 2, 1, 0, 2 };
+		appendFixtureModel(fixture, 3, 2, 1, model0, 2);
+		const u8 model1[] = { 0, 0, 0, 3 };
+		appendFixtureModel(fixture, 2, 1, 2, model1, 1);
+		appendFixtureTransform(fixture, 0, 1, nil, nil, 0);
+		u32 content = beginFixtureChunk(fixture, "nGRP");
+		appendFixtureI32(fixture, 1);
+		appendFixtureI32(fixture, 0);
+		appendFixtureI32(fixture, 4);
+		for (i32 i = 0; i < 4; i++) {
+			appendFixtureI32(fixture, 2 + i * 2);
+		}
+		endFixtureChunk(fixture, content);
+		appendFixtureTransform(fixture, 2, 3, "10 0 0", nil, 0);
+		appendFixtureShape(fixture, 3, 0);
+		//a quarter turn around z
+		appendFixtureTransform(fixture, 4, 5, "0 5 -3", "17", 0);
+		appendFixtureShape(fixture, 5, 1);
+		//mirrored along x
+		appendFixtureTransform(fixture, 6, 7, nil, "20", 0);
+		appendFixtureShape(fixture, 7, 1);
+		appendFixtureTransform(fixture, 8, 9, "100 100 100", nil, 1);
+		appendFixtureShape(fixture, 9, 0);
+		content = beginFixtureChunk(fixture, "RGBA");
+		u32 palette[256] = { 0xff0000ff, 0xff00ff00, 0x80ff0000 };
+		appendFixtureBytes(fixture, palette, sizeof(palette));
+		endFixtureChunk(fixture, content);
+		if (!endFixtureFile(fixture, testVoxPath, 0)) {
+			printf("couldn't write the .vox fixture\n");
+			return 1;
+		}
+
+		VoxelArray imported = {};
+		initVoxelArray(&imported, &memoryAllocator, 16, 16);
+		if (!importVoxFile(testVoxPath, &imported, 2) || imported.groupsCount != 3 || imported.voxelsCount != 4) {
+			printf("the .vox fixture imported %d voxels in %d groups\n", imported.voxelsCount, imported.groupsCount);
+			return 1;
+		}
+		//.vox (x, y, z) is (x, z, -y) in the game, and models are centered on size / 2
+		math::Vector3 wantPositions[4] = { { 18.0f, 0.0f, 2.0f }, { 22.0f, 0.0f, 0.0f }, { 0.0f, -8.0f, -8.0f }, { 2.0f, -2.0f, 0.0f } };
+		u32 wantColors[4] = { 0xff0000ff, 0xff00ff00, 0x80ff0000, 0x80ff0000 };
+		for (i32 i = 0; i < 4; i++) {
+			math::Vector3 position = calculateVoxelGroupedPosition(&imported, i, math::Vector3{});
+			if (!areVectorsNear(position, wantPositions[i]) || packTestColor(imported.colors[i]) != wantColors[i] || imported.voxelsScale[i].x != 2) {
+				printf("imported voxel %d is at (%f, %f, %f) with color %08x\n", i, position.x, position.y, position.z, packTestColor(imported.colors[i]));
+				return 1;
+			}
+		}
+
+		//without a palette or a scene graph, the default palette is used and models are at the origin
+		beginFixtureFile(fixture);
+		const u8 model2[] = { 0, 0, 0, 1, 1, 0, 0, 216 };
+		appendFixtureModel(fixture, 2, 1, 1, model2, 2);
+		if (!endFixtureFile(fixture, testVoxPath, 0)) {
+			printf("couldn't write the .vox fixture\n");
+			return 1;
+		}
+		VoxelArray plain = {};
+		initVoxelArray(&plain, &memoryAllocator, 16, 16);
+		if (
+			!importVoxFile(testVoxPath, &plain, 2) || plain.groupsCount != 1 ||
+			packTestColor(plain.colors[0]) != 0xffffffff || packTestColor(plain.colors[1]) != 0xff0000ee ||
+			!areVectorsNear(calculateVoxelGroupedPosition(&plain, 0, math::Vector3{}), math::Vector3{ -2.0f, 0.0f, 0.0f })
+		) {
+			printf("a .vox file without a palette or a scene graph imported wrong\n");
+			return 1;
+		}
+
+		//files that are cut short or don't fit add nothing
+		if (!endFixtureFile(fixture, testVoxPath, 3) || importVoxFile(testVoxPath, &plain, 2) || plain.voxelsCount != 2) {
+			printf("a truncated .vox file imported\n");
+			return 1;
+		}
+		VoxelArray tiny = {};
+		initVoxelArray(&tiny, &memoryAllocator, 1, 1);
+		if (!endFixtureFile(fixture, testVoxPath, 0) || importVoxFile(testVoxPath, &tiny, 2) || tiny.voxelsCount != 0 || tiny.groupsCount != 0) {
+			printf("a .vox file that doesn't fit imported\n");
+			return 1;
+		}
+
+		//a group that lists its own parent is a cycle, which is skipped
+		beginFixtureFile(fixture);
+		appendFixtureModel(fixture, 2, 1, 1, model2, 2);
+		appendFixtureTransform(fixture, 0, 1, nil, nil, 0);
+		content = beginFixtureChunk(fixture, "nGRP");
+		appendFixtureI32(fixture, 1);
+		appendFixtureI32(fixture, 0);
+		appendFixtureI32(fixture, 2);
+		appendFixtureI32(fixture, 0);
+		appendFixtureI32(fixture, 2);
+		endFixtureChunk(fixture, content);
+		appendFixtureTransform(fixture, 2, 3, nil, nil, 0);
+		appendFixtureShape(fixture, 3, 0);
+		VoxelArray cyclic = {};
+		initVoxelArray(&cyclic, &memoryAllocator, 16, 16);
+		if (!endFixtureFile(fixture, testVoxPath, 0) || !importVoxFile(testVoxPath, &cyclic, 2) || cyclic.groupsCount != 1 || cyclic.voxelsCount != 2) {
+			printf("a .vox file with a cycle imported %d voxels in %d groups\n", cyclic.voxelsCount, cyclic.groupsCount);
+			return 1;
+		}
+
+		//40 groups that each list the next one twice place the model 2^40 times. importing gives up instead
+		beginFixtureFile(fixture);
+		appendFixtureModel(fixture, 2, 1, 1, model2, 2);
+		appendFixtureTransform(fixture, 0, 1, nil, nil, 0);
+		for (i32 i = 1; i <= 40; i++) {
+			content = beginFixtureChunk(fixture, "nGRP");
+			appendFixtureI32(fixture, i);
+			appendFixtureI32(fixture, 0);
+			appendFixtureI32(fixture, 2);
+			appendFixtureI32(fixture, i + 1);
+			appendFixtureI32(fixture, i + 1);
+			endFixtureChunk(fixture, content);
+		}
+		appendFixtureShape(fixture, 41, 0);
+		VoxelArray shared = {};
+		initVoxelArray(&shared, &memoryAllocator, 16, 16);
+		if (!endFixtureFile(fixture, testVoxPath, 0) || importVoxFile(testVoxPath, &shared, 2) || shared.voxelsCount != 0 || shared.groupsCount != 0) {
+			printf("a .vox file with 2^40 instances imported\n");
+			return 1;
+		}
+		free(fixture);
+	}
+
+	{
+		//exporting and importing again keeps every voxel in place, cut into voxels of 2
+		VoxelArray scene = {};
+		initVoxelArray(&scene, &memoryAllocator, 256, 16);
+		RGBAColorF32 colors[3] = { { 1.0f, 0.0f, 0.0f, 1.0f }, { 10.0f / 255.0f, 20.0f / 255.0f, 30.0f / 255.0f, 1.0f }, { 0.0f, 1.0f, 1.0f, 51.0f / 255.0f } };
+		i32 turned = addEmptyVoxelGroup(&scene, math::Vector3{ 10.0f, 4.0f, -6.0f });
+		scene.groups[turned].rotation = math::createQuaternionRotation(PI32 / 2.0f, math::Vector3{ 0.0f, 1.0f, 0.0f });
+		for (i32 i = 0; i < 100; i++) {
+			addVoxelToGroup(&scene, colors[i % 3], Vector3i{ (i % 5) * 2, (i / 25) * 2, ((i / 5) % 5) * 2 - 4 }, Vector3ui{ 2, 2, 2 }, turned);
+		}
+		i32 plain = addEmptyVoxelGroup(&scene, math::Vector3{ -20.0f, 0.0f, 0.0f });
+		addVoxelToGroup(&scene, colors[1], Vector3i{ 1, 1, -1 }, Vector3ui{ 4, 4, 4 }, plain);
+		addVoxelToGroup(&scene, colors[2], Vector3i{ 4, 0, 0 }, Vector3ui{ 2, 6, 2 }, plain);
+		addStandaloneVoxel(&scene, colors[0], Vector3i{ 12, 0, -30 }, Vector3ui{ 6, 6, 6 });
+		if (!exportVoxFile(testVoxPath, &scene, 2)) {
+			printf("exporting a .vox file failed\n");
+			return 1;
+		}
+		VoxelArray imported = {};
+		initVoxelArray(&imported, &memoryAllocator, 1024, 16);
+		if (!importVoxFile(testVoxPath, &imported, 2) || imported.groupsCount != 3) {
+			printf("the exported .vox file didn't import\n");
+			return 1;
+		}
+		TestVoxCell* want = (TestVoxCell*) malloc(1024 * sizeof(TestVoxCell));
+		TestVoxCell* got = (TestVoxCell*) malloc(1024 * sizeof(TestVoxCell));
+		i32 wantCount = collectTestVoxCells(&scene, want);
+		i32 gotCount = collectTestVoxCells(&imported, got);
+		if (wantCount != gotCount || memcmp(want, got, wantCount * sizeof(TestVoxCell)) != 0) {
+			printf("the exported .vox file imported %d voxels of 2, instead of the same %d\n", gotCount, wantCount);
+			return 1;
+		}
+		free(want);
+		free(got);
+
+		//a voxel inside of another one is written once per cell, with the color of the one added last
+		VoxelArray overlapping = {};
+		initVoxelArray(&overlapping, &memoryAllocator, 16, 4);
+		i32 overlappingGroup = addEmptyVoxelGroup(&overlapping, math::Vector3{ 0.0f, 0.0f, 0.0f });
+		addVoxelToGroup(&overlapping, colors[0], Vector3i{ 2, 2, 2 }, Vector3ui{ 4, 4, 4 }, overlappingGroup);
+		addVoxelToGroup(&overlapping, colors[1], Vector3i{ 3, 3, 3 }, Vector3ui{ 2, 2, 2 }, overlappingGroup);
+		VoxelArray reimported = {};
+		initVoxelArray(&reimported, &memoryAllocator, 16, 4);
+		if (!exportVoxFile(testVoxPath, &overlapping, 2) || !importVoxFile(testVoxPath, &reimported, 2)) {
+			printf("exporting and importing overlapping voxels failed\n");
+			return 1;
+		}
+		i32 lastColorsCount = 0;
+		for (i32 i = 0; i < reimported.voxelsCount; i++) {
+			lastColorsCount += packTestColor(reimported.colors[i]) == packTestColor(colors[1]);
+		}
+		if (reimported.voxelsCount != 8 || lastColorsCount != 1) {
+			printf("overlapping voxels were exported as %d cells, %d of them the last voxel's, instead of 8 and 1\n", reimported.voxelsCount, lastColorsCount);
+			return 1;
+		}
+	}
+	remove(testVoxPath);
+
+	{
+		//a small budget, so edits spill to the file
+		const i32 fillCount = 256 * VOXELS_PER_CHUNK;
+		EditJournal* journal = (EditJournal*) malloc(sizeof(EditJournal));
+		initEditJournal(journal, &memoryAllocator, 256 * 1024, testJournalPath);
+		VoxelArray edited = {};
+		initVoxelArray(&edited, &memoryAllocator, voxelsCount + fillCount, source.groupsCount + 1);
+		copyVoxelArray(&edited, &source);
+		VoxelArray before = {};
+		initVoxelArray(&before, &memoryAllocator, edited.voxelsCapacity, edited.groupsCapacity);
+		VoxelArray after = {};
+		initVoxelArray(&after, &memoryAllocator, edited.voxelsCapacity, edited.groupsCapacity);
+
+		//overlapping spans of one edit go back to their values from before it
+		copyVoxelArray(&before, &edited);
+		beginEdit(journal, &edited, 0);
+		VoxelSpan recolored[2] = { { 100, 3 * VOXELS_PER_CHUNK }, { 2 * VOXELS_PER_CHUNK, 5 * VOXELS_PER_CHUNK + 7 } };
+		for (i32 s = 0; s < 2; s++) {
+			recordVoxelSpanEdit(journal, &edited, recolored[s]);
+			for (i32 i = recolored[s].begin; i < recolored[s].end; i++) {
+				edited.colors[i] = RGBAColorF32{ (f32)s, 0.5f, 0.0f, 1.0f };
+			}
+			markVoxelSpanDirty(&edited, recolored[s]);
+		}
+		endEdit(journal, &edited);
+		copyVoxelArray(&after, &edited);
+		if (!undoEdit(journal, &edited, nil) || compareVoxelArrays(&edited, &before) >= 0 || undoEdit(journal, &edited, nil)) {
+			printf("undoing a recolor didn't give the voxels back their colors\n");
+			return 1;
+		}
+		if (!redoEdit(journal, &edited, nil) || compareVoxelArrays(&edited, &after) >= 0 || redoEdit(journal, &edited, nil)) {
+			printf("redoing a recolor didn't color the voxels again\n");
+			return 1;
+		}
+
+		//a fill that's bigger than the budget is undone by dropping the voxels it added
+		beginEdit(journal, &edited, 0);
+		i32 filled = addEmptyVoxelGroup(&edited, math::Vector3{ 0.0f, 100.0f, 0.0f });
+		for (i32 i = 0; i < fillCount; i++) {
+			addVoxelToGroup(&edited, RGBAColorF32{ 0.0f, 0.0f, (f32)(i / 5000 % 2), 1.0f }, Vector3i{ i % 128, i / 16384, (i / 128) % 128 }, Vector3ui{ 1, 1, 1 }, filled);
+		}
+		endEdit(journal, &edited);
+		copyVoxelArray(&before, &after);
+		copyVoxelArray(&after, &edited);
+		if (journal->spilledBytes == 0) {
+			printf("a fill bigger than the budget of the journal didn't spill\n");
+			return 1;
+		}
+		if (!undoEdit(journal, &edited, nil) || compareVoxelArrays(&edited, &before) >= 0) {
+			printf("undoing a fill didn't drop the voxels it added\n");
+			return 1;
+		}
+		if (!redoEdit(journal, &edited, nil) || compareVoxelArrays(&edited, &after) >= 0) {
+			printf("redoing a fill didn't add its voxels again\n");
+			return 1;
+		}
+		undoEdit(journal, &edited, nil);
+
+		//every frame of a drag is its own edit with the same key, and they are undone in one step
+		copyVoxelArray(&before, &edited);
+		u32 editsCount = journal->editsCount;
+		for (i32 frame = 0; frame < 30; frame++) {
+			beginEdit(journal, &edited, 7);
+			recordVoxelGroupEdit(journal, &edited, 3);
+			edited.groups[3].position.x += 0.5f;
+			markVoxelGroupDirty(&edited, 3);
+			endEdit(journal, &edited);
+		}
+		if (journal->editsCount != editsCount) {
+			printf("a drag wasn't kept as one edit in place of the fill that was undone\n");
+			return 1;
+		}
+		if (redoEdit(journal, &edited, nil)) {
+			printf("an undone edit was redone after a new edit\n");
+			return 1;
+		}
+		if (!undoEdit(journal, &edited, nil) || compareVoxelArrays(&edited, &before) >= 0) {
+			printf("undoing a drag didn't move the group back\n");
+			return 1;
+		}
+
+		//scattered recolors spill the oldest edits, which are read back from the file
+		redoEdit(journal, &edited, nil);
+		copyVoxelArray(&before, &edited);
+		for (i32 e = 0; e < 40; e++) {
+			beginEdit(journal, &edited, 0);
+			VoxelSpan span = { (i32)(nextRandom() % (u32)(voxelsCount - VOXELS_PER_CHUNK)), 0 };
+			span.end = span.begin + VOXELS_PER_CHUNK;
+			recordVoxelSpanEdit(journal, &edited, span);
+			for (i32 i = span.begin; i < span.end; i++) {
+				edited.colors[i] = RGBAColorF32{ (f32)(nextRandom() % 256) / 255.0f, (f32)e, 0.0f, 1.0f };
+			}
+			markVoxelSpanDirty(&edited, span);
+			endEdit(journal, &edited);
+		}
+		copyVoxelArray(&after, &edited);
+		if (journal->memoryUsed > journal->memoryBudget || !journal->entries[0].isSpilled) {
+			printf("recolors used %llu bytes of a %llu byte journal\n", (unsigned long long)journal->memoryUsed, (unsigned long long)journal->memoryBudget);
+			return 1;
+		}
+		for (i32 e = 0; e < 40; e++) {
+			if (!undoEdit(journal, &edited, nil)) {
+				printf("undoing recolor %d failed\n", 39 - e);
+				return 1;
+			}
+		}
+		if (compareVoxelArrays(&edited, &before) >= 0) {
+			printf("undoing spilled recolors didn't give the voxels back their colors\n");
+			return 1;
+		}
+		for (i32 e = 0; e < 40; e++) {
+			redoEdit(journal, &edited, nil);
+		}
+		if (compareVoxelArrays(&edited, &after) >= 0) {
+			printf("redoing spilled recolors didn't color the voxels again\n");
+			return 1;
+		}
+		destroyEditJournal(journal);
+		if (getFileSize(testJournalPath) != 0) {
+			printf("the spill file of the journal is still there\n");
+			return 1;
+		}
+		free(journal);
+	}
+
+	{
+		//region edits give the same voxels as testing every cell of the region one at a time
+		JobQueue* jobQueue = (JobQueue*) malloc(sizeof(JobQueue));
+		initJobQueue(jobQueue, 3);
+		VoxelArray edited = {};
+		initVoxelArray(&edited, &memoryAllocator, 64 * VOXELS_PER_CHUNK, 16);
+		const i32 cellSize = 2;
+		VoxelRegion regions[4] = {
+			{ VOXEL_REGION_BOX, { -32, 0, -32 }, { 32, 64, 32 } },
+			{ VOXEL_REGION_SPHERE, { -30, -10, 4 }, { 30, 40, 71 } },
+			{ VOXEL_REGION_CYLINDER, { 0, 0, 0 }, { 41, 20, 61 } },
+			{ VOXEL_REGION_SPHERE, { 0, 0, 0 }, { 40, 40, 40 } },
+		};
+		i32 hollowThicknesses[4] = { 0, 0, 0, 2 };
+		for (i32 r = 0; r < 4; r++) {
+			VoxelRegion region = regions[r];
+			i32 groupIndex = addEmptyVoxelGroup(&edited, math::Vector3{});
+			i32 begin = fillVoxelRegion(&edited, jobQueue, nil, region, cellSize, hollowThicknesses[r], RGBAColorF32{ 1.0f, 0.0f, 0.0f, 1.0f }, groupIndex);
+			VoxelRegion inner = region;
+			i32 depth = hollowThicknesses[r] * cellSize;
+			inner.min = Vector3i{ region.min.x + depth, region.min.y + depth, region.min.z + depth };
+			inner.max = Vector3i{ region.max.x - depth, region.max.y - depth, region.max.z - depth };
+			i32 wantCount = 0;
+			for (i32 k = 0; k < (region.max.z - region.min.z) / cellSize; k++) {
+				for (i32 j = 0; j < (region.max.y - region.min.y) / cellSize; j++) {
+					for (i32 i = 0; i < (region.max.x - region.min.x) / cellSize; i++) {
+						Vector3i p = { region.min.x + i * cellSize + cellSize / 2, region.min.y + j * cellSize + cellSize / 2, region.min.z + k * cellSize + cellSize / 2 };
+						if (isInsideVoxelRegion(region, p) && (depth == 0 || !isInsideVoxelRegion(inner, p))) {
+							wantCount += 1;
+						}
+					}
+				}
+			}
+			if (begin < 0 || edited.groups[groupIndex].voxelsCount != wantCount || edited.voxelsCount - begin != wantCount) {
+				printf("filling region %d added %d voxels instead of %d\n", r, edited.groups[groupIndex].voxelsCount, wantCount);
+				return 1;
+			}
+			for (i32 i = begin; i < edited.voxelsCount; i++) {
+				Vector3i p = edited.voxelsPosition[i];
+				if (!isInsideVoxelRegion(region, p) || (depth > 0 && isInsideVoxelRegion(inner, p)) || edited.voxelsGroupIndex[i] != groupIndex || edited.voxelsScale[i].x != (u32)cellSize) {
+					printf("filling region %d added voxel %d at (%d, %d, %d), which isn't in it\n", r, i, p.x, p.y, p.z);
+					return 1;
+				}
+			}
+		}
+
+		//a recolor only writes the chunks that have voxels in the region, and is undone like any other edit
+		EditJournal* journal = (EditJournal*) malloc(sizeof(EditJournal));
+		initEditJournal(journal, &memoryAllocator, 1024 * 1024, testJournalPath);
+		VoxelArray before = {};
+		initVoxelArray(&before, &memoryAllocator, edited.voxelsCapacity, edited.groupsCapacity);
+		copyVoxelArray(&before, &edited);
+		edited.dirtySpansCount = 0;
+		memset(edited.isChunkModified, 0, edited.chunksCapacity);
+		VoxelRegion corner = { VOXEL_REGION_SPHERE, { -32, 0, -32 }, { 0, 32, 0 } };
+		RGBAColorF32 red = { 1.0f, 0.0f, 0.0f, 1.0f };
+		RGBAColorF32 blue = { 0.0f, 1.0f, 0.0f, 1.0f };
+		beginEdit(journal, &edited, 0);
+		i32 recoloredCount = replaceVoxelRegionColor(&edited, jobQueue, journal, corner, 0, red, blue);
+		endEdit(journal, &edited);
+		i32 wantCount = 0;
+		for (i32 i = 0; i < edited.voxelsCount; i++) {
+			bool32 isRecolored = edited.voxelsGroupIndex[i] == 0 && isInsideVoxelRegion(corner, edited.voxelsPosition[i]);
+			wantCount += isRecolored;
+			if (packTestColor(edited.colors[i]) != packTestColor(isRecolored ? blue : red)) {
+				printf("voxel %d has the wrong color after recoloring a region\n", i);
+				return 1;
+			}
+			if (isRecolored && !edited.isChunkModified[i / VOXELS_PER_CHUNK]) {
+				printf("the chunk of recolored voxel %d isn't modified\n", i);
+				return 1;
+			}
+		}
+		if (recoloredCount != wantCount || wantCount == 0 || edited.isChunkModified[edited.groups[1].voxelsBegin / VOXELS_PER_CHUNK + 1]) {
+			printf("recoloring a region recolored %d voxels instead of %d, or modified chunks outside of it\n", recoloredCount, wantCount);
+			return 1;
+		}
+		if (replaceVoxelRegionColor(&edited, jobQueue, nil, corner, 0, red, blue) != 0) {
+			printf("recoloring a region again found voxels of the old color\n");
+			return 1;
+		}
+		if (!undoEdit(journal, &edited, nil) || compareVoxelArrays(&edited, &before) >= 0) {
+			printf("undoing a region recolor didn't give the voxels back their colors\n");
+			return 1;
+		}
+		destroyEditJournal(journal);
+		free(journal);
+
+		//copying a region of the sphere and pasting it somewhere else keeps the voxels' places relative to each other
+		VoxelClipboard clipboard = {};
+		initVoxelClipboard(&clipboard, &memoryAllocator, 16384);
+		VoxelRegion half = { VOXEL_REGION_BOX, { -30, -10, 4 }, { 0, 40, 71 } };
+		if (!copyVoxelRegion(&edited, jobQueue, half, 1, &clipboard) || clipboard.voxelsCount != edited.groups[1].voxelsCount / 2) {
+			printf("copying half of a sphere copied %d of its %d voxels\n", clipboard.voxelsCount, edited.groups[1].voxelsCount);
+			return 1;
+		}
+		i32 pastedGroup = addEmptyVoxelGroup(&edited, math::Vector3{ 100.0f, 0.0f, 0.0f });
+		i32 pasted = pasteVoxelClipboard(&edited, nil, &clipboard, Vector3i{ 5, 6, 7 }, pastedGroup);
+		i32 copied = 0;
+		for (i32 i = edited.groups[1].voxelsBegin; i < edited.groups[1].voxelsEnd && pasted >= 0; i++) {
+			if (edited.voxelsGroupIndex[i] != 1 || !isInsideVoxelRegion(half, edited.voxelsPosition[i])) {
+				continue;
+			}
+			Vector3i p = edited.voxelsPosition[i];
+			Vector3i q = edited.voxelsPosition[pasted + copied];
+			if (q.x != p.x - half.min.x + 5 || q.y != p.y - half.min.y + 6 || q.z != p.z - half.min.z + 7 || edited.voxelsGroupIndex[pasted + copied] != pastedGroup) {
+				printf("pasted voxel %d is at (%d, %d, %d) instead of where it was copied from\n", copied, q.x, q.y, q.z);
+				return 1;
+			}
+			copied += 1;
+		}
+		if (pasted < 0 || copied != clipboard.voxelsCount || edited.groups[pastedGroup].voxelsCount != copied) {
+			printf("pasting %d voxels added %d\n", clipboard.voxelsCount, copied);
+			return 1;
+		}
+		VoxelClipboard tiny = {};
+		initVoxelClipboard(&tiny, &memoryAllocator, 10);
+		if (copyVoxelRegion(&edited, jobQueue, half, 1, &tiny) || tiny.voxelsCount != 0) {
+			printf("a region that doesn't fit in the clipboard was copied\n");
+			return 1;
+		}
+
+		//a voxel without a size is one of a chunk that isn't loaded. it's neither copied nor recolored
+		i32 unloaded = pasted;
+		RGBAColorF32 unloadedColor = edited.colors[unloaded];
+		edited.voxelsScale[unloaded] = Vector3ui{};
+		VoxelRegion everything = { VOXEL_REGION_BOX, { -1000, -1000, -1000 }, { 1000, 1000, 1000 } };
+		i32 recoloredPastedCount = replaceVoxelRegionColor(&edited, jobQueue, nil, everything, pastedGroup, unloadedColor, blue);
+		if (
+			!copyVoxelRegion(&edited, jobQueue, everything, pastedGroup, &clipboard) || clipboard.voxelsCount != copied - 1 ||
+			recoloredPastedCount != copied - 1 || packTestColor(edited.colors[unloaded]) != packTestColor(unloadedColor)
+		) {
+			printf("a voxel without a size was copied or recolored\n");
+			return 1;
+		}
+	}
+
+	{
+		//selections match testing every voxel's center, while only visiting the chunks the spatial index says they reach
+		JobQueue* jobQueue = (JobQueue*) malloc(sizeof(JobQueue));
+		initJobQueue(jobQueue, 3);
+		VoxelArray edited = {};
+		initVoxelArray(&edited, &memoryAllocator, source.voxelsCapacity, source.groupsCapacity);
+		copyVoxelArray(&edited, &source);
+		//a voxel of a world chunk that isn't loaded is never selected
+		edited.voxelsScale[2 * VOXELS_PER_CHUNK + 7] = Vector3ui{ 0, 0, 0 };
+		VoxelSpatialIndex index = {};
+		initVoxelSpatialIndex(&index, &memoryAllocator, &edited);
+		VoxelSelection selection = {};
+		initVoxelSelection(&selection, &memoryAllocator, &edited);
+		u8* want = (u8*) malloc(edited.voxelsCapacity);
+
+		AABB boxes[2] = {
+			{ { 20.0f, -5.0f, -90.0f }, { 80.0f, 5.0f, -30.0f } },
+			{ { 60.0f, 0.5f, -120.0f }, { 130.0f, 3.0f, -50.0f } },
+		};
+		VoxelSelectionMode modes[3] = { VOXEL_SELECTION_REPLACE, VOXEL_SELECTION_ADD, VOXEL_SELECTION_REMOVE };
+		AABB modeBoxes[3] = { boxes[0], boxes[1], boxes[0] };
+		memset(want, 0, edited.voxelsCapacity);
+		for (i32 m = 0; m < 3; m++) {
+			i32 selectedCount = selectVoxelsInBox(&selection, &index, &edited, jobQueue, modeBoxes[m], modes[m]);
+			for (i32 i = 0; i < edited.voxelsCount; i++) {
+				if (edited.voxelsScale[i].x != 0 && isTestPointInBox(modeBoxes[m], calculateTestVoxelWorldCenter(&edited, i))) {
+					want[i] = modes[m] != VOXEL_SELECTION_REMOVE;
+				} else if (modes[m] == VOXEL_SELECTION_REPLACE) {
+					want[i] = 0;
+				}
+			}
+			i32 wrong = compareTestSelection(&selection, &edited, want);
+			if (wrong >= 0 || selectedCount != selection.selectedCount || selectedCount == 0) {
+				printf("selecting in box %d with mode %u got voxel %d wrong, with %d voxels selected\n", m, modes[m], wrong, selectedCount);
+				return 1;
+			}
+		}
+		if (isVoxelSelected(&selection, 2 * VOXELS_PER_CHUNK + 7)) {
+			printf("a voxel that isn't loaded was selected\n");
+			return 1;
+		}
+
+		math::Matrix4 view = math::lookAt(math::Vector3{ 64.0f, 40.0f, 30.0f }, math::Vector3{ 64.0f, 0.0f, -64.0f }, math::Vector3{ 0.0f, 1.0f, 0.0f });
+		math::Matrix4 viewProjection = math::createPerspective(math::radians(50.0f), 1.5f, 0.1f, 120.0f).multiply(view);
+		Frustum frustum = extractFrustum(viewProjection);
+		i32 selectedCount = selectVoxelsInFrustum(&selection, &index, &edited, jobQueue, &frustum, VOXEL_SELECTION_REPLACE);
+		i32 outsideCount = 0;
+		for (i32 i = 0; i < edited.voxelsCount; i++) {
+			math::Vector3 c = calculateTestVoxelWorldCenter(&edited, i);
+			want[i] = edited.voxelsScale[i].x != 0;
+			for (i32 p = 0; p < 6; p++) {
+				math::Vector4 plane = frustum.planes[p];
+				want[i] = want[i] && plane.x * c.x + plane.y * c.y + plane.z * c.z + plane.w >= 0.0f;
+			}
+			outsideCount += !want[i];
+		}
+		i32 wrong = compareTestSelection(&selection, &edited, want);
+		if (wrong >= 0 || selectedCount == 0 || outsideCount == 0) {
+			printf("selecting in a frustum got voxel %d wrong, with %d voxels selected and %d outside\n", wrong, selectedCount, outsideCount);
+			return 1;
+		}
+
+		//a concave lasso, so the voxels between its arms aren't selected
+		math::Vector2 lasso[5] = { { -0.6f, -0.5f }, { 0.5f, -0.6f }, { 0.0f, 0.0f }, { 0.6f, 0.5f }, { -0.5f, 0.4f } };
+		selectedCount = selectVoxelsInLasso(&selection, &index, &edited, jobQueue, viewProjection, lasso, 5, VOXEL_SELECTION_REPLACE);
+		i32 mismatchedCount = 0;
+		i32 wantCount = 0;
+		for (i32 i = 0; i < edited.voxelsCount; i++) {
+			math::Vector3 c = calculateTestVoxelWorldCenter(&edited, i);
+			math::Vector4 clip = math::multiplyMatrixVector(viewProjection, math::Vector4{ c.x, c.y, c.z, 1.0f });
+			bool32 isSelected = 0;
+			if (edited.voxelsScale[i].x != 0 && clip.w > 0.1f && clip.z >= -clip.w && clip.z <= clip.w) {
+				f32 x = clip.x / clip.w;
+				f32 y = clip.y / clip.w;
+				for (i32 k = 0, j = 4; k < 5; j = k, k++) {
+					if ((lasso[k].y > y) != (lasso[j].y > y) && x < (lasso[j].x - lasso[k].x) * (y - lasso[k].y) / (lasso[j].y - lasso[k].y) + lasso[k].x) {
+						isSelected = !isSelected;
+					}
+				}
+			}
+			wantCount += isSelected;
+			//centers right on the lasso's edges may round either way
+			mismatchedCount += isSelected != isVoxelSelected(&selection, i);
+		}
+		if (mismatchedCount > 4 || wantCount == 0 || selectedCount != selection.selectedCount) {
+			printf("selecting in a lasso got %d voxels wrong, with %d selected instead of %d\n", mismatchedCount, selectedCount, wantCount);
+			return 1;
+		}
+
+		//the index hits the same voxels as testing every voxel
+		for (i32 r = 0; r < 50; r++) {
+			math::Vector3 origin = { (f32)(nextRandom() % 128), 20.0f, -(f32)(nextRandom() % 128) };
+			math::Vector3 direction = math::Vector3{ (f32)(nextRandom() % 100) / 100.0f - 0.5f, -1.0f, (f32)(nextRandom() % 100) / 100.0f - 0.5f }.normalize();
+			f32 wantDistance, gotDistance;
+			math::Vector3 wantPoint, gotPoint;
+			i32 wantHit = pickVoxel(&edited, origin, direction, 100.0f, &wantDistance, &wantPoint);
+			i32 gotHit = pickVoxelInIndex(&index, &edited, jobQueue, origin, direction, 100.0f, &gotDistance, &gotPoint);
+			if (gotHit != wantHit || gotDistance != wantDistance) {
+				printf("picking with the index hit voxel %d instead of %d\n", gotHit, wantHit);
+				return 1;
+			}
+		}
+
+		//expanding to groups selects every loaded voxel of the groups that had a selected voxel
+		math::Vector3 center = calculateTestVoxelWorldCenter(&edited, 5000);
+		selectVoxelsInBox(&selection, &index, &edited, jobQueue, AABB{ center.sub(math::Vector3{ 1.0f, 1.0f, 1.0f }), center.add(math::Vector3{ 1.0f, 1.0f, 1.0f }) }, VOXEL_SELECTION_REPLACE);
+		i32 boxSelectedCount = selection.selectedCount;
+		u8* isGroupSelected = (u8*) malloc(edited.groupsCount);
+		memset(isGroupSelected, 0, edited.groupsCount);
+		for (i32 i = 0; i < edited.voxelsCount; i++) {
+			if (isVoxelSelected(&selection, i)) {
+				isGroupSelected[edited.voxelsGroupIndex[i]] = 1;
+			}
+		}
+		selectedCount = selectVoxelGroupsOfSelection(&selection, &edited, jobQueue);
+		for (i32 i = 0; i < edited.voxelsCount; i++) {
+			want[i] = edited.voxelsScale[i].x != 0 && isGroupSelected[edited.voxelsGroupIndex[i]];
+		}
+		wrong = compareTestSelection(&selection, &edited, want);
+		if (wrong >= 0 || boxSelectedCount == 0 || selectedCount <= boxSelectedCount) {
+			printf("expanding a selection to its groups got voxel %d wrong, with %d voxels selected\n", wrong, selectedCount);
+			return 1;
+		}
+
+		//batch edits only write the selected voxels, and are undone like any other edit
+		EditJournal* journal = (EditJournal*) malloc(sizeof(EditJournal));
+		initEditJournal(journal, &memoryAllocator, 1024 * 1024, testJournalPath);
+		VoxelArray before = {};
+		initVoxelArray(&before, &memoryAllocator, edited.voxelsCapacity, edited.groupsCapacity);
+		copyVoxelArray(&before, &edited);
+		selectVoxelsInBox(&selection, &index, &edited, jobQueue, boxes[0], VOXEL_SELECTION_REPLACE);
+		memset(edited.isChunkModified, 0, edited.chunksCapacity);
+		RGBAColorF32 purple = { 0.5f, 0.0f, 0.5f, 1.0f };
+		beginEdit(journal, &edited, 0);
+		recolorVoxelSelection(&selection, &edited, jobQueue, journal, purple);
+		translateVoxelSelection(&selection, &edited, jobQueue, journal, Vector3i{ 1, 2, 3 });
+		endEdit(journal, &edited);
+		for (i32 i = 0; i < edited.voxelsCount; i++) {
+			bool32 isSelected = isVoxelSelected(&selection, i);
+			Vector3i p = before.voxelsPosition[i];
+			Vector3i q = edited.voxelsPosition[i];
+			bool32 isMoved = q.x == p.x + 1 && q.y == p.y + 2 && q.z == p.z + 3;
+			bool32 isRecolored = packTestColor(edited.colors[i]) == packTestColor(purple);
+			if (isSelected ? !isMoved || !isRecolored : !areVoxelsEqual(&edited, &before, i)) {
+				printf("voxel %d was edited wrong by a batch edit of the selection\n", i);
+				return 1;
+			}
+			if (!isSelected && selection.chunkSelectedCounts[i / VOXELS_PER_CHUNK] == 0 && edited.isChunkModified[i / VOXELS_PER_CHUNK]) {
+				printf("a batch edit modified chunk %d, which has no selected voxels\n", i / VOXELS_PER_CHUNK);
+				return 1;
+			}
+		}
+		if (!undoEdit(journal, &edited, nil) || compareVoxelArrays(&edited, &before) >= 0) {
+			printf("undoing a batch edit of the selection didn't give the voxels back\n");
+			return 1;
+		}
+
+		//a selected voxel whose chunk was unloaded since has no size. batch edits deselect it instead of writing it
+		i32 unloaded = 0;
+		while (!isVoxelSelected(&selection, unloaded)) {
+			unloaded += 1;
+		}
+		Vector3ui unloadedScale = edited.voxelsScale[unloaded];
+		edited.voxelsScale[unloaded] = Vector3ui{};
+		i32 selectedBefore = selection.selectedCount;
+		recolorVoxelSelection(&selection, &edited, jobQueue, nil, purple);
+		bool32 isUnloadedWritten = packTestColor(edited.colors[unloaded]) == packTestColor(purple);
+		edited.voxelsScale[unloaded] = unloadedScale;
+		copyVoxelArray(&edited, &before);
+		if (isUnloadedWritten || isVoxelSelected(&selection, unloaded) || selection.selectedCount != selectedBefore - 1) {
+			printf("a batch edit wrote a selected voxel without a size, or kept it selected\n");
+			return 1;
+		}
+
+		//moving the selected groups makes their chunks' bounds stale, so the next query finds them where they went
+		VoxelSpan dirtySpans[64];
+		markVoxelSpatialIndexStale(&index, dirtySpans, collectDirtyVoxelSpans(&edited, dirtySpans, 64));
+		selectVoxelsInBox(&selection, &index, &edited, jobQueue, boxes[0], VOXEL_SELECTION_REPLACE);
+		selectVoxelGroupsOfSelection(&selection, &edited, jobQueue);
+		i32 movedCount = selection.selectedCount;
+		beginEdit(journal, &edited, 0);
+		moveVoxelSelectionGroups(&selection, &edited, journal, math::Vector3{ 0.0f, 4000.0f, 0.0f });
+		endEdit(journal, &edited);
+		selectedCount = selectVoxelsInBox(&selection, &index, &edited, jobQueue, AABB{ { -1000.0f, 900.0f, -1000.0f }, { 1000.0f, 1100.0f, 1000.0f } }, VOXEL_SELECTION_REPLACE);
+		if (selectedCount != movedCount) {
+			printf("selecting the moved groups found %d of their %d voxels\n", selectedCount, movedCount);
+			return 1;
+		}
+		undoEdit(journal, &edited, nil);
+		trimVoxelSelection(&selection, edited.voxelsCount);
+		if (selectVoxelsInBox(&selection, &index, &edited, jobQueue, AABB{ { -1000.0f, 900.0f, -1000.0f }, { 1000.0f, 1100.0f, 1000.0f } }, VOXEL_SELECTION_REPLACE) != 0) {
+			printf("voxels were still found where their groups were moved to after undoing the move\n");
+			return 1;
+		}
+		clearVoxelSelection(&selection);
+		VoxelSpan changed;
+		if (selection.selectedCount != 0 || !collectVoxelSelectionChanges(&selection, &changed) || collectVoxelSelectionChanges(&selection, &changed)) {
+			printf("clearing the selection left %d voxels selected, or its changes weren't collected once\n", selection.selectedCount);
+			return 1;
+		}
+		destroyEditJournal(journal);
+		free(journal);
+		free(isGroupSelected);
+		free(want);
+	}
+
+	{
+		//duplicate keys keep their order, the parallel sorts split the keys between 4 jobs, and the scratch space is given back
+		const i32 count = 300000;
+		JobQueue* jobQueue = (JobQueue*) malloc(sizeof(JobQueue));
+		initJobQueue(jobQueue, 3);
+		MemoryAllocator scratch = {};
+		initMemoryAllocator(&scratch, calculateRadixSortScratchSize(count, sizeof(u64), 1));
+		TestSortPair* want = (TestSortPair*) malloc(count * sizeof(TestSortPair));
+		u32* keys32 = (u32*) malloc(count * sizeof(u32));
+		u64* keys64 = (u64*) malloc(count * sizeof(u64));
+		u32* values = (u32*) malloc(count * sizeof(u32));
+		for (i32 sortIndex = 0; sortIndex < 4; sortIndex++) {
+			bool32 isParallel = sortIndex % 2;
+			bool32 is64 = sortIndex >= 2;
+			for (i32 i = 0; i < count; i++) {
+				//64 bit keys only differ in their low and high bytes, like morton codes of nearby voxels, so the middle digits are skipped
+				u64 key = is64 ? ((u64)(nextRandom() % 7) << 56) | (nextRandom() % 5000) : nextRandom() % 1000;
+				keys32[i] = (u32)key;
+				keys64[i] = key;
+				values[i] = i;
+				want[i].key = key;
+				want[i].value = i;
+			}
+			qsort(want, count, sizeof(TestSortPair), compareTestSortPairs);
+			if (is64) {
+				if (isParallel) {
+					parallelRadixSort(jobQueue, keys64, values, count, &scratch);
+				} else {
+					radixSort(keys64, values, count, &scratch);
+				}
+			} else {
+				if (isParallel) {
+					parallelRadixSort(jobQueue, keys32, values, count, &scratch);
+				} else {
+					radixSort(keys32, values, count, &scratch);
+				}
+			}
+			for (i32 i = 0; i < count; i++) {
+				u64 key = is64 ? keys64[i] : keys32[i];
+				if (key != want[i].key || values[i] != want[i].value) {
+					printf("sort %d put key %llu with value %u at %d, not key %llu with value %u\n", sortIndex, (unsigned long long)key, values[i], i, (unsigned long long)want[i].key, want[i].value);
+					return 1;
+				}
+			}
+			if (scratch.byteOffset != 0) {
+				printf("sort %d kept %llu bytes of its scratch space\n", sortIndex, (unsigned long long)scratch.byteOffset);
+				return 1;
+			}
+		}
+		//keys without values, and arrays too short to sort
+		for (i32 i = 0; i < count; i++) {
+			keys32[i] = count - i;
+		}
+		parallelRadixSort(jobQueue, keys32, nil, count, &scratch);
+		radixSort(keys32, nil, 0, &scratch);
+		radixSort(keys64, values, 1, &scratch);
+		for (i32 i = 0; i < count; i++) {
+			if (keys32[i] != (u32)(i + 1)) {
+				printf("sorting keys without values put %u at %d\n", keys32[i], i);
+				return 1;
+			}
+		}
+		f32 floats[] = { -INFINITY, -1.0e30f, -1.0f, -1.0e-30f, -0.0f, 0.0f, 1.0e-30f, 1.0f, 1.0e30f, INFINITY };
+		for (i32 i = 1; i < (i32)(sizeof(floats) / sizeof(floats[0])); i++) {
+			if (calculateRadixSortKey(floats[i - 1]) >= calculateRadixSortKey(floats[i])) {
+				printf("the sort keys of %g and %g are out of order\n", floats[i - 1], floats[i]);
+				return 1;
+			}
+		}
+		free(scratch.memory);
+		free(want);
+		free(keys32);
+		free(keys64);
+		free(values);
+	}
+
+	{
+		TranslucentVoxels translucentVoxels = {};
+		initTranslucentVoxels(&translucentVoxels, &memoryAllocator, 1000, 64);
+		RGBAColorF32 opaque = { 1.0f, 1.0f, 1.0f, 1.0f };
+		//the camera looks down -z from the origin, so voxels are farther the lower their z
+		math::Matrix4 view = math::lookAt(math::Vector3{}, math::Vector3{ 0.0f, 0.0f, -1.0f }, math::Vector3{ 0.0f, 1.0f, 0.0f });
+		for (i32 i = 0; i < 100; i++) {
+			//a voxel's red is its index, to find it in the sorted instances
+			RGBAColorF32 color = { (f32)i, 0.0f, 0.0f, 0.5f };
+			f32 z = (f32)(i32)(nextRandom() % 2001) - 1000.0f;
+			math::Matrix4 model = math::translateMatrix(math::initIdentityMatrix(), math::Vector3{ (f32)(i % 7), 3.0f, z });
+			bool32 isTranslucent = updateTranslucentVoxel(&translucentVoxels, 10 * i, model, color);
+			if (isTranslucent != (i < 64)) {
+				printf("translucent voxel %d was %s the full set\n", i, isTranslucent ? "added to" : "left out of");
+				return 1;
+			}
+		}
+		//opaque colors take voxels out of the set, which makes room for others
+		for (i32 i = 0; i < 64; i += 2) {
+			if (updateTranslucentVoxel(&translucentVoxels, 10 * i, math::initIdentityMatrix(), opaque)) {
+				printf("voxel %d stayed translucent with an opaque color\n", 10 * i);
+				return 1;
+			}
+		}
+		trimTranslucentVoxels(&translucentVoxels, 10 * 32);
+		if (translucentVoxels.count != 16) {
+			printf("the translucent set has %d voxels after removing some, not 16\n", translucentVoxels.count);
+			return 1;
+		}
+		math::Matrix4 models[64];
+		RGBAColorF32 colors[64];
+		i32 sortedCount = sortTranslucentVoxels(&translucentVoxels, view, models, colors);
+		u8 isSorted[32] = {};
+		for (i32 i = 0; i < sortedCount; i++) {
+			i32 voxel = (i32)colors[i].r;
+			if (voxel % 2 == 0 || voxel >= 32 || isSorted[voxel] || (i > 0 && models[i].e.m23 < models[i - 1].e.m23)) {
+				printf("translucent voxel %d was sorted wrong, at %d\n", 10 * voxel, i);
+				return 1;
+			}
+			isSorted[voxel] = 1;
+		}
+		if (sortedCount != 16) {
+			printf("%d translucent voxels were sorted, not 16\n", sortedCount);
+			return 1;
+		}
+		//voxels behind the camera and at the same depth still sort, with the ones behind it last
+		trimTranslucentVoxels(&translucentVoxels, 0);
+		for (i32 i = 0; i < 64; i++) {
+			f32 z = i < 32 ? -5.0f : (f32)i;
+			updateTranslucentVoxel(&translucentVoxels, i, math::translateMatrix(math::initIdentityMatrix(), math::Vector3{ 0.0f, 0.0f, z }), RGBAColorF32{ (f32)i, 0.0f, 0.0f, 0.5f });
+		}
+		sortedCount = sortTranslucentVoxels(&translucentVoxels, view, models, colors);
+		for (i32 i = 1; i < sortedCount; i++) {
+			if (models[i].e.m23 < models[i - 1].e.m23) {
+				printf("translucent voxels at z %f and %f were sorted the wrong way around\n", models[i - 1].e.m23, models[i].e.m23);
+				return 1;
+			}
+		}
+		if (sortedCount != 64 || models[0].e.m23 != -5.0f || models[63].e.m23 != 63.0f) {
+			printf("%d translucent voxels were sorted, from z %f to %f\n", sortedCount, models[0].e.m23, models[sortedCount - 1].e.m23);
+			return 1;
+		}
+	}
+
+	{
+		//corners are darkened by the voxels of their own group and size around them, in other chunks too, and only stale chunks are recomputed
+		if (
+			calculateVoxelCornerOcclusion(0, 0, 0) != 3 || calculateVoxelCornerOcclusion(0, 0, 1) != 2 || calculateVoxelCornerOcclusion(1, 0, 1) != 1 ||
+			calculateVoxelCornerOcclusion(1, 1, 0) != 0
+		) {
+			printf("the corner occlusion rule is wrong\n");
+			return 1;
+		}
+		JobQueue* jobQueue = (JobQueue*) malloc(sizeof(JobQueue));
+		initJobQueue(jobQueue, 2);
+		VoxelArray voxels = {};
+		initVoxelArray(&voxels, &memoryAllocator, 3 * VOXELS_PER_CHUNK, 16);
+		VoxelOcclusion occlusion = {};
+		initVoxelOcclusion(&occlusion, &memoryAllocator, &voxels);
+		RGBAColorF32 white = { 1.0f, 1.0f, 1.0f, 1.0f };
+		i32 groupIndex = addEmptyVoxelGroup(&voxels, math::Vector3{ 0.0f, 0.0f, 0.0f });
+		i32 otherGroupIndex = addEmptyVoxelGroup(&voxels, math::Vector3{ 0.0f, 0.0f, 0.0f });
+		i32 a = addVoxelToGroup(&voxels, white, Vector3i{ 0, 0, 0 }, Vector3ui{ 2, 2, 2 }, groupIndex);
+		//a whole chunk of voxels of another group all around a, which never darken it
+		for (i32 i = 0; i < VOXELS_PER_CHUNK; i++) {
+			addVoxelToGroup(&voxels, white, Vector3i{ 2 * (i % 16) - 16, 2 * ((i / 16) % 16) - 16, 2 * (i / 256) - 16 }, Vector3ui{ 2, 2, 2 }, otherGroupIndex);
+		}
+		i32 b = addVoxelToGroup(&voxels, white, Vector3i{ 2, 2, 0 }, Vector3ui{ 2, 2, 2 }, groupIndex);
+		if (
+			!updateTestVoxelOcclusion(&occlusion, &voxels, jobQueue, 0, b + 1) ||
+			!checkTestFaceOcclusion(occlusion.occlusions[a], VOXEL_FACE_TOP, 3, 3, 2, 2, 0) ||
+			!checkTestFaceOcclusion(occlusion.occlusions[a], VOXEL_FACE_RIGHT, 2, 3, 3, 2, 0) ||
+			!checkTestFaceOcclusion(occlusion.occlusions[b], VOXEL_FACE_BOTTOM, 2, 3, 3, 2, 0) ||
+			!checkTestFaceOcclusion(occlusion.occlusions[a], VOXEL_FACE_BOTTOM, 3, 3, 3, 3, 0)
+		) {
+			return 1;
+		}
+
+		//moving b only marks its own chunk dirty, and a's chunk goes stale through it. a lone darker corner flips the face
+		voxels.voxelsPosition[b] = Vector3i{ 2, 2, 2 };
+		markVoxelDirty(&voxels, b);
+		if (!updateTestVoxelOcclusion(&occlusion, &voxels, jobQueue, 0, b + 1) || !checkTestFaceOcclusion(occlusion.occlusions[a], VOXEL_FACE_TOP, 3, 3, 2, 3, 1)) {
+			return 1;
+		}
+
+		//both sides of a corner make it fully dark, and voxels of another size don't count
+		i32 d = addVoxelToGroup(&voxels, white, Vector3i{ 0, 2, 2 }, Vector3ui{ 2, 2, 2 }, groupIndex);
+		addVoxelToGroup(&voxels, white, Vector3i{ 2, 2, 0 }, Vector3ui{ 2, 2, 2 }, groupIndex);
+		addVoxelToGroup(&voxels, white, Vector3i{ 0, -2, 0 }, Vector3ui{ 4, 4, 4 }, groupIndex);
+		if (
+			!updateTestVoxelOcclusion(&occlusion, &voxels, jobQueue, 0, d) ||
+			!checkTestFaceOcclusion(occlusion.occlusions[a], VOXEL_FACE_TOP, 3, 2, 0, 2, 1) ||
+			!checkTestFaceOcclusion(occlusion.occlusions[a], VOXEL_FACE_BOTTOM, 3, 3, 3, 3, 0)
+		) {
+			return 1;
+		}
+
+		//voxels dropped by an undo stop darkening their neighbors
+		voxels.voxelsCount = d;
+		if (!updateTestVoxelOcclusion(&occlusion, &voxels, jobQueue, 0, 1) || !checkTestFaceOcclusion(occlusion.occlusions[a], VOXEL_FACE_TOP, 3, 3, 2, 3, 1)) {
+			return 1;
+		}
+		//and so do the voxels of world chunks that were unloaded
+		voxels.voxelsScale[b] = Vector3ui{ 0, 0, 0 };
+		markVoxelDirty(&voxels, b);
+		if (!updateTestVoxelOcclusion(&occlusion, &voxels, jobQueue, 0, 1) || occlusion.occlusions[a] != VOXEL_UNOCCLUDED || occlusion.occlusions[b] != VOXEL_UNOCCLUDED) {
+			printf("voxels are still occluded after their neighbors were taken away\n");
+			return 1;
+		}
+		updateVoxelOcclusion(&occlusion, &voxels, jobQueue, nil, 0);
+		VoxelSpan changed;
+		if (collectVoxelOcclusionChanges(&occlusion, &changed)) {
+			printf("voxels [%d, %d) were recomputed without anything changing\n", changed.begin, changed.end);
+			return 1;
+		}
+	}
+
+	{
+		//block light drops by one a cell, sky light comes down from the top, and both go around and through what blocks them
+		JobQueue* jobQueue = (JobQueue*) malloc(sizeof(JobQueue));
+		initJobQueue(jobQueue, 3);
+		VoxelArray voxels = {};
+		initVoxelArray(&voxels, &memoryAllocator, 3 * VOXELS_PER_CHUNK, 16);
+		VoxelLight* light = (VoxelLight*) malloc(sizeof(VoxelLight));
+		initVoxelLight(light, &memoryAllocator, &voxels, Vector3i{ 0, 0, 0 }, 4, Vector3i{ 2, 2, 2 }, 64 * 1024);
+		i32 groupIndex = addEmptyVoxelGroup(&voxels, math::Vector3{ 0.0f, 0.0f, 0.0f });
+		updateTestVoxelLight(light, &voxels, jobQueue, 0);
+		if (!checkTestCellLight(light, 5, 0, 5, 0, 15) || !checkTestCellLight(light, 31, 31, 31, 0, 15) || getVoxelLightAt(light, Vector3i{ -1, 0, 0 }) != VOXEL_LIGHT_OPEN_SKY) {
+			return 1;
+		}
+
+		//a roof shades everything under it, and a source lights the cells around it
+		addTestLightLayer(&voxels, groupIndex, 1, 20, 0, 32);
+		i32 roofEnd = voxels.voxelsCount;
+		setVoxelLightSource(light, Vector3i{ 42, 42, 42 }, 15);
+		i32 lit = addVoxelToGroup(&voxels, RGBAColorF32{ 1.0f, 1.0f, 1.0f, 1.0f }, Vector3i{ 38, 42, 42 }, Vector3ui{ 4, 4, 4 }, groupIndex);
+		updateTestVoxelLight(light, &voxels, jobQueue, 0);
+		if (
+			!checkTestCellLight(light, 0, 10, 0, 0, 0) || !checkTestCellLight(light, 5, 10, 5, 5, 0) || !checkTestCellLight(light, 5, 21, 5, 0, 15) || !checkTestCellLight(light, 10, 10, 10, 15, 0) ||
+			!checkTestCellLight(light, 13, 10, 10, 12, 0) || !checkTestCellLight(light, 10, 8, 11, 12, 0) || !checkTestCellLight(light, 9, 10, 10, 0, 0) ||
+			!checkTestCellLight(light, 8, 10, 10, 11, 0) || !checkTestCellLight(light, 10, 20, 10, 0, 0)
+		) {
+			return 1;
+		}
+		VoxelSpan changed = {};
+		if (!collectVoxelLightChanges(light, &changed) || changed.begin > lit || changed.end <= lit || light->voxelLevels[lit] != 15) {
+			printf("the voxel next to the source has a light of %x\n", light->voxelLevels[lit]);
+			return 1;
+		}
+
+		//a wall cuts the light off, and it comes back when the wall is undone
+		addTestLightLayer(&voxels, groupIndex, 0, 12, 0, 20);
+		updateTestVoxelLight(light, &voxels, jobQueue, 0);
+		if (!checkTestCellLight(light, 11, 10, 10, 14, 0) || !checkTestCellLight(light, 13, 10, 10, 0, 0) || !checkTestCellLight(light, 12, 10, 10, 0, 0)) {
+			return 1;
+		}
+		voxels.voxelsCount = lit + 1;
+		updateTestVoxelLight(light, &voxels, jobQueue, 0);
+		if (!checkTestCellLight(light, 13, 10, 10, 12, 0)) {
+			return 1;
+		}
+
+		//taking the source out darkens everything it lit, and taking the roof out lets the sky back in
+		setVoxelLightSource(light, Vector3i{ 42, 42, 42 }, 0);
+		updateTestVoxelLight(light, &voxels, jobQueue, 0);
+		if (!checkTestCellLight(light, 10, 10, 10, 0, 0) || !checkTestCellLight(light, 12, 10, 10, 0, 0)) {
+			return 1;
+		}
+		for (i32 i = 0; i < roofEnd; i++) {
+			voxels.voxelsScale[i] = Vector3ui{ 0, 0, 0 };
+		}
+		markVoxelSpanDirty(&voxels, VoxelSpan{ 0, roofEnd });
+		updateTestVoxelLight(light, &voxels, jobQueue, 0);
+		if (!checkTestCellLight(light, 5, 10, 5, 0, 15) || !checkTestCellLight(light, 10, 0, 10, 0, 15) || !checkTestCellLight(light, 9, 9, 10, 0, 14)) {
+			return 1;
+		}
+
+		//random edits spread a bit at a time, even while earlier ones are still spreading, end up lit the same as lighting their result from scratch
+		voxels.voxelsCount = 0;
+		addTestLightLayer(&voxels, groupIndex, 1, 24, 4, 28);
+		updateTestVoxelLight(light, &voxels, jobQueue, 0);
+		i32 spreadsCount = 0;
+		for (i32 edit = 0; edit < 40; edit++) {
+			u32 r = nextRandom();
+			if (r % 5 == 0) {
+				setVoxelLightSource(light, Vector3i{ (i32)(nextRandom() % 128), (i32)(nextRandom() % 96), (i32)(nextRandom() % 128) }, nextRandom() % 16);
+			} else if (r % 5 == 1 && voxels.voxelsCount > 0) {
+				voxels.voxelsCount -= MIN(voxels.voxelsCount, (i32)(nextRandom() % 8));
+			} else if (r % 5 == 2 && voxels.voxelsCount > 0) {
+				i32 v = (i32)(nextRandom() % voxels.voxelsCount);
+				voxels.voxelsPosition[v] = Vector3i{ (i32)(nextRandom() % 128), (i32)(nextRandom() % 128), (i32)(nextRandom() % 128) };
+				markVoxelDirty(&voxels, v);
+			} else {
+				for (i32 i = 0; i < 16 && voxels.voxelsCount < voxels.voxelsCapacity; i++) {
+					u32 scale = 2u << (nextRandom() % 3);
+					Vector3i p = { (i32)(nextRandom() % 128), (i32)(nextRandom() % 100), (i32)(nextRandom() % 128) };
+					addVoxelToGroup(&voxels, RGBAColorF32{ 1.0f, 1.0f, 1.0f, 1.0f }, p, Vector3ui{ scale, scale, scale }, groupIndex);
+				}
+			}
+			//the next edit comes in before the light of this one is done spreading
+			updateTestVoxelLight(light, &voxels, jobQueue, 100);
+			spreadsCount += 1;
+		}
+		while (isVoxelLightPending(light)) {
+			updateTestVoxelLight(light, &voxels, jobQueue, 100);
+			spreadsCount += 1;
+		}
+		VoxelLight* relit = (VoxelLight*) malloc(sizeof(VoxelLight));
+		initVoxelLight(relit, &memoryAllocator, &voxels, Vector3i{ 0, 0, 0 }, 4, Vector3i{ 2, 2, 2 }, 64 * 1024);
+		i32 cellsCount = light->chunksCount * VOXEL_LIGHT_CHUNK_CELLS;
+		memcpy(relit->sources, light->sources, cellsCount);
+		updateVoxelLight(relit, &voxels, jobQueue, nil, 0, 0);
+		i32 differentCellsCount = 0;
+		for (i32 c = 0; c < cellsCount; c++) {
+			differentCellsCount += light->levels[c] != relit->levels[c];
+		}
+		if (differentCellsCount > 0 || memcmp(light->voxelLevels, relit->voxelLevels, voxels.voxelsCount) != 0) {
+			printf("%d cells are lit differently than when they're lit from scratch\n", differentCellsCount);
+			return 1;
+		}
+		if (spreadsCount <= 40) {
+			printf("the budget never held the light back\n");
+			return 1;
+		}
+	}
+
+	{
+		//a moved group takes the light out and fills it back in around the cells it left and went into, instead of lighting every cell
+		//from scratch, and a relight keeps the voxels lit as before until it's all spread
+		JobQueue* jobQueue = (JobQueue*) malloc(sizeof(JobQueue));
+		initJobQueue(jobQueue, 3);
+		VoxelArray voxels = {};
+		initVoxelArray(&voxels, &memoryAllocator, 3 * VOXELS_PER_CHUNK, 16);
+		VoxelLight* light = (VoxelLight*) malloc(sizeof(VoxelLight));
+		initVoxelLight(light, &memoryAllocator, &voxels, Vector3i{ 0, 0, 0 }, 4, Vector3i{ 4, 4, 4 }, 256 * 1024);
+		i32 roofGroupIndex = addEmptyVoxelGroup(&voxels, math::Vector3{ 0.0f, 0.0f, 0.0f });
+		for (i32 y = 50; y < 54; y++) {
+			addTestLightLayer(&voxels, roofGroupIndex, 1, y, 0, 32);
+		}
+		i32 movedGroupIndex = addEmptyVoxelGroup(&voxels, math::Vector3{ 0.0f, 0.0f, 0.0f });
+		i32 movedBegin = voxels.voxelsCount;
+		for (i32 y = 10; y < 15; y++) {
+			addTestLightLayer(&voxels, movedGroupIndex, 1, y, 0, 32);
+		}
+		updateTestVoxelLight(light, &voxels, jobQueue, 0);
+		VoxelSpan changed = {};
+		collectVoxelLightChanges(light, &changed);
+
+		voxels.groups[movedGroupIndex].position = math::Vector3{ 4.0f, 0.0f, 0.0f };
+		markVoxelGroupDirty(&voxels, movedGroupIndex);
+		updateTestVoxelLight(light, &voxels, jobQueue, 0);
+		if (!collectVoxelLightChanges(light, &changed) || changed.begin < movedBegin / VOXELS_PER_CHUNK * VOXELS_PER_CHUNK) {
+			printf("moving a group recomputed the light of voxels [%d, %d), far from it\n", changed.begin, changed.end);
+			return 1;
+		}
+		VoxelLight* relit = (VoxelLight*) malloc(sizeof(VoxelLight));
+		initVoxelLight(relit, &memoryAllocator, &voxels, Vector3i{ 0, 0, 0 }, 4, Vector3i{ 4, 4, 4 }, 256 * 1024);
+		updateVoxelLight(relit, &voxels, jobQueue, nil, 0, 0);
+		i32 cellsCount = light->chunksCount * VOXEL_LIGHT_CHUNK_CELLS;
+		if (memcmp(light->levels, relit->levels, cellsCount) != 0 || memcmp(light->voxelLevels, relit->voxelLevels, voxels.voxelsCount) != 0) {
+			printf("the moved group is lit differently than when it's lit from scratch\n");
+			return 1;
+		}
+
+		u8* voxelLevels = (u8*) malloc(voxels.voxelsCount);
+		memcpy(voxelLevels, light->voxelLevels, voxels.voxelsCount);
+		light->isRelightNeeded = 1;
+		i32 spreadsCount = 0;
+		do {
+			updateTestVoxelLight(light, &voxels, jobQueue, 1000);
+			spreadsCount += 1;
+			if (memcmp(light->voxelLevels, voxelLevels, voxels.voxelsCount) != 0) {
+				printf("the voxels' light changed after %d updates of a relight of the same voxels\n", spreadsCount);
+				return 1;
+			}
+		} while (isVoxelLightPending(light));
+		if (spreadsCount < 2 || collectVoxelLightChanges(light, &changed) == 0) {
+			printf("the relight was spread in %d updates, and recomputed no voxels\n", spreadsCount);
+			return 1;
+		}
+		free(voxelLevels);
+	}
+
+	{
+		//the sun's shadows are marched through the cells the light is blocked in, and only the chunks those changed in are rebuilt
+		JobQueue* jobQueue = (JobQueue*) malloc(sizeof(JobQueue));
+		initJobQueue(jobQueue, 3);
+		VoxelArray voxels = {};
+		initVoxelArray(&voxels, &memoryAllocator, 2 * VOXELS_PER_CHUNK, 16);
+		VoxelLight* light = (VoxelLight*) malloc(sizeof(VoxelLight));
+		initVoxelLight(light, &memoryAllocator, &voxels, Vector3i{ 0, 0, 0 }, 4, Vector3i{ 2, 2, 2 }, 64 * 1024);
+		VoxelShadow* shadow = (VoxelShadow*) malloc(sizeof(VoxelShadow));
+		initVoxelShadow(shadow, &memoryAllocator, light);
+		i32 groupIndex = addEmptyVoxelGroup(&voxels, math::Vector3{ 0.0f, 0.0f, 0.0f });
+		addTestLightLayer(&voxels, groupIndex, 1, 20, 8, 24);
+		updateTestVoxelLight(light, &voxels, jobQueue, 0);
+		updateVoxelShadow(shadow, light, jobQueue);
+		i32 chunksBegin;
+		i32 chunksEnd;
+		if (!collectVoxelShadowChanges(shadow, &chunksBegin, &chunksEnd) || chunksBegin != 0 || chunksEnd != shadow->chunksCount) {
+			printf("the first update didn't build every chunk of the shadow\n");
+			return 1;
+		}
+
+		//a roof over z [8, 24) in cells, 20 cells up. the points are on the top faces of voxels 6 cells up
+		math::Vector3 up = { 0.0f, 1.0f, 0.0f };
+		math::Vector3 down = { 0.0f, -1.0f, 0.0f };
+		math::Vector3 slanted = math::Vector3{ 0.0f, 1.0f, 1.0f }.normalize();
+		if (
+			!isVoxelShadowed(shadow, math::Vector3{ 22.0f, 24.0f, 66.0f }, up, up) || isVoxelShadowed(shadow, math::Vector3{ 22.0f, 24.0f, 10.0f }, up, up) ||
+			!isVoxelShadowed(shadow, math::Vector3{ 22.0f, 24.0f, 10.0f }, up, slanted) || isVoxelShadowed(shadow, math::Vector3{ 22.0f, 24.0f, 10.0f }, up, math::Vector3{ 0.0f, 1.0f, -1.0f }) ||
+			!isVoxelShadowed(shadow, math::Vector3{ 22.0f, 24.0f, 10.0f }, down, up) || isVoxelShadowed(shadow, math::Vector3{ 22.0f, 84.0f, 66.0f }, up, up) ||
+			!traceVoxelShadowRay(shadow, math::Vector3{ 5.5f, -10.0f, 16.5f }, up, up, MAX_VOXEL_SHADOW_STEPS) ||
+			traceVoxelShadowRay(shadow, math::Vector3{ 5.5f, -10.0f, 30.5f }, up, up, MAX_VOXEL_SHADOW_STEPS) ||
+			traceVoxelShadowRay(shadow, math::Vector3{ 5.5f, 6.0f, 16.5f }, up, up, 10)
+		) {
+			printf("the roof's shadow isn't where it should be\n");
+			return 1;
+		}
+
+		//taking a corner of the roof out only rebuilds the chunk it's in
+		for (i32 a = 0; a < 16; a++) {
+			for (i32 b = 8; b < 16; b++) {
+				i32 v = a * 16 + b - 8;
+				voxels.voxelsScale[v] = Vector3ui{ 0, 0, 0 };
+				markVoxelDirty(&voxels, v);
+			}
+		}
+		updateTestVoxelLight(light, &voxels, jobQueue, 0);
+		updateVoxelShadow(shadow, light, jobQueue);
+		if (!collectVoxelShadowChanges(shadow, &chunksBegin, &chunksEnd) || chunksBegin != 2 || chunksEnd != 3) {
+			printf("chunks [%d, %d) of the shadow were rebuilt, not [2, 3)\n", chunksBegin, chunksEnd);
+			return 1;
+		}
+		if (isVoxelShadowed(shadow, math::Vector3{ 22.0f, 24.0f, 50.0f }, up, up) || !isVoxelShadowed(shadow, math::Vector3{ 22.0f, 24.0f, 66.0f }, up, up)) {
+			printf("the shadow didn't follow the roof\n");
+			return 1;
+		}
+		updateTestVoxelLight(light, &voxels, jobQueue, 0);
+		updateVoxelShadow(shadow, light, jobQueue);
+		if (collectVoxelShadowChanges(shadow, &chunksBegin, &chunksEnd)) {
+			printf("chunks [%d, %d) of the shadow were rebuilt without anything changing\n", chunksBegin, chunksEnd);
+			return 1;
+		}
+
+		//after random edits, the cells are blocked where the light is, and a ray straight up is shadowed when a cell above its own is blocked
+		for (i32 edit = 0; edit < 30; edit++) {
+			u32 r = nextRandom();
+			if (r % 3 == 0 && voxels.voxelsCount > 0) {
+				voxels.voxelsCount -= MIN(voxels.voxelsCount, (i32)(nextRandom() % 32));
+			} else if (r % 3 == 1 && voxels.voxelsCount > 0) {
+				i32 v = (i32)(nextRandom() % voxels.voxelsCount);
+				voxels.voxelsPosition[v] = Vector3i{ (i32)(nextRandom() % 128), (i32)(nextRandom() % 128), (i32)(nextRandom() % 128) };
+				markVoxelDirty(&voxels, v);
+			} else {
+				for (i32 i = 0; i < 64 && voxels.voxelsCount < voxels.voxelsCapacity; i++) {
+					u32 scale = 2u << (nextRandom() % 3);
+					Vector3i p = { (i32)(nextRandom() % 128), (i32)(nextRandom() % 128), (i32)(nextRandom() % 128) };
+					addVoxelToGroup(&voxels, RGBAColorF32{ 1.0f, 1.0f, 1.0f, 1.0f }, p, Vector3ui{ scale, scale, scale }, groupIndex);
+				}
+			}
+			updateTestVoxelLight(light, &voxels, jobQueue, 0);
+			updateVoxelShadow(shadow, light, jobQueue);
+		}
+		i32 wrongCellsCount = 0;
+		i32 wrongRaysCount = 0;
+		for (i32 z = 0; z < 32; z++) {
+			for (i32 y = 0; y < 32; y++) {
+				for (i32 x = 0; x < 32; x++) {
+					u32 cell = (u32)(((z / 16) * 2 + y / 16) * 2 + x / 16) * VOXEL_LIGHT_CHUNK_CELLS + (u32)(((z % 16) * 16 + y % 16) * 16 + x % 16);
+					wrongCellsCount += isVoxelShadowCellBlocked(shadow, x, y, z) != (light->solidCounts[cell] > 0);
+					bool32 isBlockedAbove = 0;
+					for (i32 above = y + 1; above < 32 && !isBlockedAbove; above++) {
+						isBlockedAbove = isVoxelShadowCellBlocked(shadow, x, above, z);
+					}
+					math::Vector3 start = { (f32)x + 0.5f, (f32)y + 0.5f, (f32)z + 0.5f };
+					wrongRaysCount += traceVoxelShadowRay(shadow, start, up, up, MAX_VOXEL_SHADOW_STEPS) != isBlockedAbove;
+				}
+			}
+		}
+		if (wrongCellsCount > 0 || wrongRaysCount > 0) {
+			printf("%d cells of the shadow don't match the light's, and %d rays were marched wrong\n", wrongCellsCount, wrongRaysCount);
+			return 1;
+		}
+	}
+
+	{
+		//voxels smaller than a cell, like the ones of .vox models, don't shadow themselves or the ones next to them, a cell blocked right
+		//above one still does, and so does a wall one cell tall further along the voxel's layer under a low sun
+		JobQueue* jobQueue = (JobQueue*) malloc(sizeof(JobQueue));
+		initJobQueue(jobQueue, 3);
+		VoxelArray voxels = {};
+		initVoxelArray(&voxels, &memoryAllocator, VOXELS_PER_CHUNK, 16);
+		VoxelLight* light = (VoxelLight*) malloc(sizeof(VoxelLight));
+		initVoxelLight(light, &memoryAllocator, &voxels, Vector3i{ 0, 0, 0 }, 4, Vector3i{ 2, 2, 2 }, 64 * 1024);
+		VoxelShadow* shadow = (VoxelShadow*) malloc(sizeof(VoxelShadow));
+		initVoxelShadow(shadow, &memoryAllocator, light);
+		i32 groupIndex = addEmptyVoxelGroup(&voxels, math::Vector3{ 0.0f, 0.0f, 0.0f });
+		//a floor of two voxels a cell, with a second one on top of it where x < 32, so its top faces are on the edge of the cells
+		for (i32 x = 1; x < 64; x += 2) {
+			for (i32 z = 1; z < 64; z += 2) {
+				addVoxelToGroup(&voxels, RGBAColorF32{ 1.0f, 1.0f, 1.0f, 1.0f }, Vector3i{ x, 1, z }, Vector3ui{ 2, 2, 2 }, groupIndex);
+				if (x < 32) {
+					addVoxelToGroup(&voxels, RGBAColorF32{ 1.0f, 1.0f, 1.0f, 1.0f }, Vector3i{ x, 3, z }, Vector3ui{ 2, 2, 2 }, groupIndex);
+				}
+			}
+		}
+		updateTestVoxelLight(light, &voxels, jobQueue, 0);
+		updateVoxelShadow(shadow, light, jobQueue);
+		math::Vector3 up = { 0.0f, 1.0f, 0.0f };
+		math::Vector3 lowSun = math::Vector3{ 1.0f, 0.25f, 0.3f }.normalize();
+		//the floor half way up its cells is only left behind by the rays that leave the layer within a cell
+		math::Vector3 midSun = math::Vector3{ 1.0f, 0.6f, 0.3f }.normalize();
+		i32 shadowedCount = 0;
+		for (i32 x = 1; x < 64; x += 2) {
+			for (i32 z = 1; z < 64; z += 2) {
+				math::Vector3 top = { (f32)x, x < 32 ? 4.0f : 2.0f, (f32)z };
+				shadowedCount += isVoxelShadowed(shadow, top, up, x < 32 ? lowSun : midSun);
+				shadowedCount += isVoxelShadowed(shadow, top, up, up);
+			}
+		}
+		if (shadowedCount > 0) {
+			printf("%d top faces of a floor smaller than a cell are shadowed by the floor\n", shadowedCount);
+			return 1;
+		}
+
+		addVoxelToGroup(&voxels, RGBAColorF32{ 1.0f, 1.0f, 1.0f, 1.0f }, Vector3i{ 41, 5, 41 }, Vector3ui{ 2, 2, 2 }, groupIndex);
+		addVoxelToGroup(&voxels, RGBAColorF32{ 1.0f, 1.0f, 1.0f, 1.0f }, Vector3i{ 9, 5, 9 }, Vector3ui{ 2, 2, 2 }, groupIndex);
+		updateTestVoxelLight(light, &voxels, jobQueue, 0);
+		updateVoxelShadow(shadow, light, jobQueue);
+		if (
+			!isVoxelShadowed(shadow, math::Vector3{ 41.0f, 2.0f, 41.0f }, up, up) || isVoxelShadowed(shadow, math::Vector3{ 45.0f, 2.0f, 41.0f }, up, up) ||
+			!isVoxelShadowed(shadow, math::Vector3{ 9.0f, 4.0f, 9.0f }, up, up) || isVoxelShadowed(shadow, math::Vector3{ 13.0f, 4.0f, 9.0f }, up, up)
+		) {
+			printf("a voxel in the cell right above the floor doesn't shadow it\n");
+			return 1;
+		}
+
+		//a voxel away from the floor with a wall a cell tall 3 cells along x, in the voxel's layer. the sun is low enough for the ray
+		//to still be in the layer when it gets to the wall
+		math::Vector3 grazingSun = math::Vector3{ 1.0f, 0.1f, 0.0f }.normalize();
+		math::Vector3 lonelyTop = { 5.0f, 2.0f, 90.0f };
+		addVoxelToGroup(&voxels, RGBAColorF32{ 1.0f, 1.0f, 1.0f, 1.0f }, Vector3i{ 5, 1, 90 }, Vector3ui{ 2, 2, 2 }, groupIndex);
+		updateTestVoxelLight(light, &voxels, jobQueue, 0);
+		updateVoxelShadow(shadow, light, jobQueue);
+		bool32 isShadowedWithoutWall = isVoxelShadowed(shadow, lonelyTop, up, grazingSun);
+		for (i32 y = 1; y < 4; y += 2) {
+			for (i32 z = 85; z < 96; z += 2) {
+				addVoxelToGroup(&voxels, RGBAColorF32{ 1.0f, 1.0f, 1.0f, 1.0f }, Vector3i{ 17, y, z }, Vector3ui{ 2, 2, 2 }, groupIndex);
+			}
+		}
+		updateTestVoxelLight(light, &voxels, jobQueue, 0);
+		updateVoxelShadow(shadow, light, jobQueue);
+		if (isShadowedWithoutWall || !isVoxelShadowed(shadow, lonelyTop, up, grazingSun)) {
+			printf("a voxel is %s\n", isShadowedWithoutWall ? "shadowed by itself under a low sun" : "not shadowed by a short wall along its layer");
+			return 1;
+		}
+	}
+
+	{
+		//mip levels are 2x2 box filters averaged in linear space, with odd edges clamped
+		if (calculateMipLevelsCount(4, 2) != 3 || calculateMipLevelsCount(3, 3) != 2 || calculateMipChainSize(4, 2, 3) != 4 * (8 + 2 + 1)) {
+			printf("mip chains of 4x2 and 3x3 images have the wrong amount of levels or size\n");
+			return 1;
+		}
+		u8 chain[4 * (8 + 2 + 1)] = {};
+		for (u32 i = 0; i < 8; i++) {
+			//black and white columns, with alpha going up along the row
+			u8 value = (i % 4) % 2 == 0 ? 0 : 255;
+			chain[4 * i + 0] = value;
+			chain[4 * i + 1] = value;
+			chain[4 * i + 2] = i < 4 ? 255 : 0;
+			chain[4 * i + 3] = (u8)(60 * (i % 4));
+		}
+		generateMipChain(chain, 4, 2, 3);
+		u8* level1 = &chain[4 * 8];
+		u8* level2 = &chain[4 * 10];
+		//half black and half white is 0.5 in linear, 188 in srgb, not 128
+		bool32 isLevel1Right =
+			level1[0] == 188 && level1[1] == 188 && level1[2] == 188 && level1[3] == 30 &&
+			level1[4] == 188 && level1[5] == 188 && level1[6] == 188 && level1[7] == 150;
+		bool32 isLevel2Right = level2[0] == 188 && level2[1] == 188 && level2[2] == 188 && level2[3] == 90;
+		u8 odd[4 * (9 + 1)] = {};
+		for (u32 i = 0; i < 9; i++) {
+			odd[4 * i + 0] = i == 0 ? 255 : 0;
+			odd[4 * i + 3] = 255;
+		}
+		generateMipChain(odd, 3, 3, 2);
+		//the 1x1 level only covers the top left 2x2, so one white texel of four
+		bool32 isOddRight = odd[36] == 137 && odd[37] == 0 && odd[38] == 0 && odd[39] == 255;
+		if (!isLevel1Right || !isLevel2Right || !isOddRight) {
+			printf(
+				"mip levels came out as %u %u %u %u, %u %u %u %u, %u %u %u %u and %u %u %u %u\n",
+				level1[0], level1[1], level1[2], level1[3], level1[4], level1[5], level1[6], level1[7],
+				level2[0], level2[1], level2[2], level2[3], odd[36], odd[37], odd[38], odd[39]
+			);
+			return 1;
+		}
+	}
+
+	{
+		//bc1 round trips. a solid block only loses the 565 quantization, and a 4 step gradient lands exactly on the palette
+		const u32 solidColors[4][3] = { { 0, 0, 0 }, { 255, 255, 255 }, { 200, 30, 90 }, { 17, 140, 231 } };
+		for (u32 colorIndex = 0; colorIndex < 4; colorIndex++) {
+			u8 pixels[4 * 16];
+			for (u32 i = 0; i < 16; i++) {
+				for (u32 c = 0; c < 3; c++) {
+					pixels[4 * i + c] = (u8)solidColors[colorIndex][c];
+				}
+				pixels[4 * i + 3] = 255;
+			}
+			u8 block[8];
+			compressBC1(pixels, 4, 4, block);
+			u8 decompressed[4 * 16];
+			decompressBC1(block, 4, 4, decompressed);
+			for (u32 i = 0; i < 16; i++) {
+				//5 bits for red and blue, 6 for green
+				i32 maxErrors[3] = { 4, 2, 4 };
+				for (u32 c = 0; c < 3; c++) {
+					if (abs((i32)decompressed[4 * i + c] - (i32)pixels[4 * i + c]) > maxErrors[c] || decompressed[4 * i + 3] != 255) {
+						printf(
+							"bc1 turned the solid color %u %u %u into %u %u %u %u\n", pixels[0], pixels[1], pixels[2],
+							decompressed[4 * i], decompressed[4 * i + 1], decompressed[4 * i + 2], decompressed[4 * i + 3]
+						);
+						return 1;
+					}
+				}
+			}
+		}
+
+		u8 gradient[4 * 16];
+		for (u32 i = 0; i < 16; i++) {
+			u8 value = (u8)(85 * (i % 4));
+			gradient[4 * i + 0] = value;
+			gradient[4 * i + 1] = value;
+			gradient[4 * i + 2] = value;
+			gradient[4 * i + 3] = 255;
+		}
+		u8 gradientBlock[8];
+		compressBC1(gradient, 4, 4, gradientBlock);
+		u8 decompressedGradient[4 * 16];
+		decompressBC1(gradientBlock, 4, 4, decompressedGradient);
+		for (u32 i = 0; i < 4 * 16; i++) {
+			if (abs((i32)decompressedGradient[i] - (i32)gradient[i]) > 4) {
+				printf("bc1 turned the gradient value %u into %u\n", gradient[i], decompressedGradient[i]);
+				return 1;
+			}
+		}
+
+		//a 5x3 image is two blocks. the partial one repeats the last column and row, and decompression only writes inside the image
+		const u32 edgeWidth = 5;
+		const u32 edgeHeight = 3;
+		u8 edge[4 * edgeWidth * edgeHeight];
+		for (u32 y = 0; y < edgeHeight; y++) {
+			for (u32 x = 0; x < edgeWidth; x++) {
+				u8* pixel = &edge[4 * (y * edgeWidth + x)];
+				pixel[0] = x < 4 ? 255 : 0;
+				pixel[1] = x < 4 ? 0 : 255;
+				pixel[2] = 0;
+				pixel[3] = 255;
+			}
+		}
+		if (calculateTextureLevelSize(TEXTURE_FORMAT_BC1_SRGB, edgeWidth, edgeHeight) != 16) {
+			printf("a 5x3 bc1 level should be 2 blocks, not %llu bytes\n", (unsigned long long)calculateTextureLevelSize(TEXTURE_FORMAT_BC1_SRGB, edgeWidth, edgeHeight));
+			return 1;
+		}
+		u8 edgeBlocks[16];
+		compressBC1(edge, edgeWidth, edgeHeight, edgeBlocks);
+		u8 decompressedEdge[4 * edgeWidth * edgeHeight];
+		decompressBC1(edgeBlocks, edgeWidth, edgeHeight, decompressedEdge);
+		for (u32 i = 0; i < 4 * edgeWidth * edgeHeight; i++) {
+			if (abs((i32)decompressedEdge[i] - (i32)edge[i]) > 4) {
+				printf("bc1 turned the value %u at %u of the 5x3 image into %u\n", edge[i], i, decompressedEdge[i]);
+				return 1;
+			}
+		}
+	}
+
+	{
+		//asset packs read back what was written, and notice when the file a texture came from changes
+		const char* packPath = "world-test.vxpack";
+		const char* sourcePath = "world-test-source.png";
+		FILE* source = fopen(sourcePath, "wb");
+		fwrite("source", 1, 6, source);
+		fclose(source);
+
+		AssetPackTexture textures[2] = {};
+		u8* texturesData[2];
+		strcpy(textures[0].name, "colors");
+		textures[0].format = TEXTURE_FORMAT_RGBA8_SRGB;
+		textures[0].width = 4;
+		textures[0].height = 2;
+		textures[0].mipLevelsCount = 3;
+		textures[0].dataSize = calculateTextureChainSize(textures[0].format, 4, 2, 3);
+		if (!getFileInfo(sourcePath, &textures[0].sourceSize, &textures[0].sourceModificationTime) || textures[0].sourceSize != 6) {
+			printf("failed to read the size of %s\n", sourcePath);
+			return 1;
+		}
+		strcpy(textures[1].name, "blocks");
+		textures[1].format = TEXTURE_FORMAT_BC1_SRGB;
+		textures[1].width = 8;
+		textures[1].height = 8;
+		textures[1].mipLevelsCount = 4;
+		textures[1].dataSize = calculateTextureChainSize(textures[1].format, 8, 8, 4);
+		for (u32 i = 0; i < 2; i++) {
+			texturesData[i] = (u8*)malloc(textures[i].dataSize);
+			for (u64 j = 0; j < textures[i].dataSize; j++) {
+				texturesData[i][j] = (u8)nextRandom();
+			}
+		}
+		if (!writeAssetPack(packPath, textures, texturesData, 2)) {
+			printf("failed to write %s\n", packPath);
+			return 1;
+		}
+
+		AssetPack pack;
+		if (!openAssetPack(packPath, &pack)) {
+			printf("failed to open the asset pack that was just written\n");
+			return 1;
+		}
+		if (pack.header->texturesCount != 2 || findAssetPackTexture(&pack, "missing") != nil) {
+			printf("the asset pack has %u textures instead of 2, or found one that was never written\n", pack.header->texturesCount);
+			return 1;
+		}
+		for (u32 i = 0; i < 2; i++) {
+			AssetPackTexture* texture = findAssetPackTexture(&pack, textures[i].name);
+			if (texture == nil || texture->format != textures[i].format || texture->width != textures[i].width ||
+				texture->height != textures[i].height || texture->mipLevelsCount != textures[i].mipLevelsCount ||
+				texture->dataOffset % ASSET_PACK_DATA_ALIGNMENT != 0 ||
+				memcmp(getAssetPackTextureData(&pack, texture), texturesData[i], textures[i].dataSize) != 0) {
+				printf("the asset pack read back %s differently than it was written\n", textures[i].name);
+				return 1;
+			}
+		}
+		AssetPackTexture* colors = findAssetPackTexture(&pack, "colors");
+		if (isAssetPackTextureStale(colors, sourcePath) || isAssetPackTextureStale(colors, "world-test-missing.png")) {
+			printf("the asset pack is stale before its source changed\n");
+			return 1;
+		}
+		source = fopen(sourcePath, "wb");
+		fwrite("changed source", 1, 14, source);
+		fclose(source);
+		if (!isAssetPackTextureStale(colors, sourcePath)) {
+			printf("the asset pack isn't stale after its source changed\n");
+			return 1;
+		}
+		closeAssetPack(&pack);
+
+		for (u32 i = 0; i < 2; i++) {
+			free(texturesData[i]);
+		}
+		remove(packPath);
+		remove(sourcePath);
+	}
+
+	{
+		//the cpu path tracer finds the same voxels picking does, and its images don't depend on the amount of threads
+		JobQueue* jobQueue = (JobQueue*) malloc(sizeof(JobQueue));
+		initJobQueue(jobQueue, 3);
+		JobQueue* serialJobQueue = (JobQueue*) malloc(sizeof(JobQueue));
+		initJobQueue(serialJobQueue, 0);
+		VoxelArray voxels = {};
+		initVoxelArray(&voxels, &memoryAllocator, 2 * VOXELS_PER_CHUNK, 16);
+		VoxelSpatialIndex index = {};
+		initVoxelSpatialIndex(&index, &memoryAllocator, &voxels);
+		VoxelTracer tracer = {};
+		initVoxelTracer(&tracer, &memoryAllocator, &voxels, &index);
+
+		//a slab 8 x 4 x 8 world units around the origin, seen from straight ahead
+		RGBAColorF32 purple = {};
+		purple.r = 0.5f; purple.g = 0.25f; purple.b = 1.0f; purple.a = 1.0f;
+		addStandaloneVoxel(&voxels, purple, Vector3i{ 0, 0, 0 }, Vector3ui{ 32, 16, 32 });
+		VoxelTracerConfig config = {};
+		config.width = 33;
+		config.height = 17;
+		config.samplesPerPixel = 1;
+		config.maxBounces = 0;
+		config.seed = 7;
+		config.sunDirection = math::Vector3{ 0.0f, 0.0f, 1.0f };
+		config.sunColor = math::Vector3{ 1.0f, 1.0f, 1.0f };
+		config.skyColor = math::Vector3{ 0.2f, 0.4f, 0.6f };
+		math::Matrix4 frontView = math::lookAt(math::Vector3{ 0.0f, 0.0f, 10.0f }, math::Vector3{ 0.0f, 0.0f, 0.0f }, math::Vector3{ 0.0f, 1.0f, 0.0f });
+		math::Matrix4 aboveView = math::lookAt(math::Vector3{ 0.0f, 10.0f, 10.0f }, math::Vector3{ 0.0f, 2.0f, 2.0f }, math::Vector3{ 0.0f, 1.0f, 0.0f });
+		math::Matrix4 projection = math::createPerspective(math::radians(70.0f), (f32)config.width / (f32)config.height, 0.1f, 100.0f);
+		u8* pixels = (u8*) malloc(4 * config.width * config.height);
+		u8* serialPixels = (u8*) malloc(4 * config.width * config.height);
+		VoxelTracerStats stats = {};
+		u8* center = &pixels[4 * (config.height / 2 * config.width + config.width / 2)];
+		traceVoxelImage(&tracer, jobQueue, frontView, projection, &config, pixels, &stats);
+		//the front face faces the sun, and the corners only see the sky. srgb of 0.5, 0.25, 1 and 0.2, 0.4, 0.6
+		bool32 isFrontLit = abs(center[0] - 188) <= 1 && abs(center[1] - 137) <= 1 && center[2] == 255 && center[3] == 255;
+		bool32 isCornerSky = abs(pixels[0] - 124) <= 1 && abs(pixels[1] - 170) <= 1 && abs(pixels[2] - 203) <= 1;
+		//a sun ray for the face, and none for the sky
+		bool32 isCounted = stats.raysCount > config.width * config.height && stats.raysCount < 2 * config.width * config.height;
+		config.sunDirection = math::Vector3{ 0.0f, 0.0f, -1.0f };
+		traceVoxelImage(&tracer, jobQueue, frontView, projection, &config, pixels, &stats);
+		bool32 isBackUnlit = center[0] == 0 && center[1] == 0 && center[2] == 0;
+		if (!isFrontLit || !isCornerSky || !isCounted || !isBackUnlit) {
+			printf(
+				"the slab traced to %u %u %u in the middle and %u %u %u in the corner, with %llu rays\n",
+				center[0], center[1], center[2], pixels[0], pixels[1], pixels[2], (unsigned long long)stats.raysCount
+			);
+			return 1;
+		}
+
+		//the top of the slab is lit from above until a voxel over it casts its shadow
+		config.sunDirection = math::Vector3{ 0.0f, 1.0f, 0.0f };
+		traceVoxelImage(&tracer, jobQueue, aboveView, projection, &config, pixels, &stats);
+		bool32 isTopLit = abs(center[0] - 188) <= 1 && abs(center[1] - 137) <= 1 && center[2] == 255;
+		addStandaloneVoxel(&voxels, purple, Vector3i{ 0, 24, 8 }, Vector3ui{ 8, 4, 8 });
+		traceVoxelImage(&tracer, jobQueue, aboveView, projection, &config, pixels, &stats);
+		bool32 isTopShadowed = center[0] == 0 && center[1] == 0 && center[2] == 0;
+		if (!isTopLit || !isTopShadowed) {
+			printf("the top of the slab wasn't lit, or the voxel above it didn't shadow it\n");
+			return 1;
+		}
+
+		//rays against a rotated group of random voxels hit the same voxels as picking, at the same distances
+		i32 groupIndex = addEmptyVoxelGroup(&voxels, math::Vector3{ 8.0f, 4.0f, -4.0f });
+		voxels.groups[groupIndex].rotation = math::createQuaternionRotation(0.7f, math::Vector3{ 1.0f, 2.0f, 0.5f }.normalize());
+		for (i32 i = 0; i < 3000; i++) {
+			RGBAColorF32 color = { (f32)(nextRandom() % 256) / 255.0f, (f32)(nextRandom() % 256) / 255.0f, (f32)(nextRandom() % 256) / 255.0f, 1.0f };
+			Vector3i p = { (i32)(nextRandom() % 128) - 64, (i32)(nextRandom() % 64) - 32, (i32)(nextRandom() % 128) - 64 };
+			addVoxelToGroup(&voxels, color, p, Vector3ui{ 1 + nextRandom() % 4, 1 + nextRandom() % 4, 1 + nextRandom() % 4 }, groupIndex);
+		}
+		prepareVoxelTracer(&tracer, jobQueue);
+		i32 wrongHitsCount = 0;
+		i32 wrongNormalsCount = 0;
+		i32 hitsCount = 0;
+		for (i32 i = 0; i < 2000; i++) {
+			math::Vector3 origin = { (f32)(nextRandom() % 4000) / 100.0f - 20.0f, (f32)(nextRandom() % 4000) / 100.0f - 20.0f, 30.0f };
+			math::Vector3 target = { (f32)(nextRandom() % 2000) / 100.0f - 10.0f, (f32)(nextRandom() % 1000) / 100.0f - 5.0f, (f32)(nextRandom() % 2000) / 100.0f - 10.0f };
+			math::Vector3 direction = target.sub(origin).normalize();
+			f32 wantDistance;
+			math::Vector3 wantPoint;
+			i32 want = pickVoxel(&voxels, origin, direction, 1000.0f, &wantDistance, &wantPoint);
+			f32 gotDistance;
+			math::Vector3 normal;
+			i32 got = traceVoxelRay(&tracer, origin, direction, 1000.0f, &gotDistance, &normal);
+			if ((got < 0) != (want < 0) || (got >= 0 && fabsf(gotDistance - wantDistance) > 1e-3f)) {
+				wrongHitsCount += 1;
+				continue;
+			}
+			if (got >= 0) {
+				hitsCount += 1;
+				//the normal faces the ray, and a step along it leaves the voxel
+				f32 leftDistance;
+				math::Vector3 leftPoint;
+				VoxelSpan span = { got, got + 1 };
+				math::Vector3 outside = origin.add(direction.scale(gotDistance)).add(normal.scale(0.01f));
+				if (normal.dot(direction) >= 0.0f || pickVoxelInSpan(&voxels, span, outside, normal, 1000.0f, &leftDistance, &leftPoint) >= 0) {
+					wrongNormalsCount += 1;
+				}
+			}
+		}
+		if (wrongHitsCount > 0 || wrongNormalsCount > 0 || hitsCount < 500) {
+			printf("%d traced rays hit other voxels than picking, %d of %d hits had wrong normals\n", wrongHitsCount, wrongNormalsCount, hitsCount);
+			return 1;
+		}
+
+		config.samplesPerPixel = 4;
+		config.maxBounces = 2;
+		config.sunDirection = math::Vector3{ 0.3f, 1.0f, 0.6f }.normalize();
+		math::Matrix4 sceneView = math::lookAt(math::Vector3{ 0.0f, 12.0f, 30.0f }, math::Vector3{ 4.0f, 2.0f, 0.0f }, math::Vector3{ 0.0f, 1.0f, 0.0f });
+		VoxelTracerStats serialStats = {};
+		traceVoxelImage(&tracer, jobQueue, sceneView, projection, &config, pixels, &stats);
+		traceVoxelImage(&tracer, serialJobQueue, sceneView, projection, &config, serialPixels, &serialStats);
+		if (memcmp(pixels, serialPixels, 4 * config.width * config.height) != 0 || stats.raysCount != serialStats.raysCount) {
+			printf("the image traced on 4 threads isn't the one traced on 1\n");
+			return 1;
+		}
+
+		TestPNG png = {};
+		png.capacity = 4 * config.width * config.height + 4096;
+		png.data = (u8*) malloc(png.capacity);
+		int isEncoded = stbi_write_png_to_func(writeTestPNG, &png, (int)config.width, (int)config.height, 4, pixels, 4 * (int)config.width);
+		int width, height, channels;
+		stbi_uc* decoded = isEncoded && png.size <= png.capacity ?
+			stbi_load_from_memory(png.data, (int)png.size, &width, &height, &channels, STBI_rgb_alpha) : nil;
+		if (
+			decoded == nil || width != (int)config.width || height != (int)config.height || channels != 4 ||
+			memcmp(decoded, pixels, 4 * config.width * config.height) != 0
+		) {
+			printf("the traced image didn't survive being encoded as a png: %s\n", decoded == nil ? stbi_failure_reason() : "pixels differ");
+			return 1;
+		}
+		stbi_image_free(decoded);
+		free(png.data);
+		free(serialPixels);
+		free(pixels);
+	}
+
+	printf("Successfully completed the tests!!!\n");
+	return 0;
+}